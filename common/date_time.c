@@ -59,3 +59,42 @@ uint8_t computeDayOfWeek(uint16_t y, uint8_t m, uint8_t d)
    //Return the day of the week
    return ((h + 5) % 7) + 1;
 }
+
+
+/**
+ * @brief Convert date to Unix timestamp
+ * @param[in] dateTime Date and time (UTC)
+ * @return Number of seconds elapsed since 1970-01-01 00:00:00 UTC
+ **/
+
+uint32_t dateTimeToUnixTime(const DateTime *dateTime)
+{
+   uint_t y;
+   uint_t m;
+   uint32_t t;
+
+   //Year and month of year
+   y = dateTime->year;
+   m = dateTime->month;
+
+   //January and February are counted as months 13 and 14 of the previous year
+   if(m <= 2)
+   {
+      m += 12;
+      y -= 1;
+   }
+
+   //Number of days elapsed since the beginning of the proleptic Gregorian calendar
+   t = (365 * y) + (y / 4) - (y / 100) + (y / 400);
+   t += (30 * m) + (3 * (m + 1) / 5) + dateTime->date;
+
+   //Unix time starts on January 1st, 1970
+   t -= 719561;
+
+   //Convert days to seconds and add the time of day
+   t *= 86400;
+   t += (3600 * dateTime->hours) + (60 * dateTime->minutes) + dateTime->seconds;
+
+   //Return Unix timestamp
+   return t;
+}
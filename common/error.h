@@ -103,6 +103,7 @@ typedef enum
    ERROR_UNSUPPORTED_CIPHER_ALGO,
    ERROR_UNSUPPORTED_KEY_EXCH_METHOD,
    ERROR_UNSUPPORTED_SIGNATURE_ALGO,
+   ERROR_UNSUPPORTED_ELLIPTIC_CURVE,
    ERROR_INVALID_SIGNATURE_ALGO,
    ERROR_CERTIFICATE_REQUIRED,
    ERROR_MESSAGE_TOO_LONG,
@@ -196,6 +197,9 @@ typedef enum
    ERROR_ILLEGAL_PARAMETER,
 
    ERROR_MORE_DATA_REQUIRED,
+   ERROR_WANT_READ,
+   ERROR_WANT_WRITE,
+   ERROR_WANT_KEY_OPERATION,
 
    ERROR_TLS_NOT_SUPPORTED,
 
@@ -32,6 +32,18 @@
 //Dependencies
 #include "crypto.h"
 
+//AES-NI instruction set support
+#ifndef AES_NI_SUPPORT
+   #define AES_NI_SUPPORT DISABLED
+#elif (AES_NI_SUPPORT != ENABLED && AES_NI_SUPPORT != DISABLED)
+   #error AES_NI_SUPPORT parameter is invalid
+#endif
+
+//The compiler must target a processor that implements AES-NI
+#if (AES_NI_SUPPORT == ENABLED && !defined(__AES__))
+   #error AES_NI_SUPPORT requires a target with AES-NI instructions
+#endif
+
 //AES block size
 #define AES_BLOCK_SIZE 16
 //Common interface for encryption algorithms
@@ -44,25 +56,12 @@
 
 typedef struct
 {
-   uint_t nr;
-   uint32_t w[60];
+   uint_t nr;       ///<Number of rounds
+   uint32_t w[60];  ///<Key schedule
+   uint32_t dk[60]; ///<Key schedule of the equivalent inverse cipher
 } AesContext;
 
 
-/**
- * @brief AES state array
- **/
-
-typedef struct
-{
-   union
-   {
-      uint32_t w[4];
-      uint8_t b[16];
-   };
-} AesState;
-
-
 //AES related constants
 extern const CipherAlgo aesCipherAlgo;
 
@@ -70,5 +69,7 @@ extern const CipherAlgo aesCipherAlgo;
 error_t aesInit(AesContext *context, const uint8_t *key, size_t keyLength);
 void aesEncryptBlock(AesContext *context, const uint8_t *input, uint8_t *output);
 void aesDecryptBlock(AesContext *context, const uint8_t *input, uint8_t *output);
+void aesEncryptBlocks(AesContext *context, const uint8_t *input, uint8_t *output, size_t n);
+void aesDecryptBlocks(AesContext *context, const uint8_t *input, uint8_t *output, size_t n);
 
 #endif
@@ -243,7 +243,9 @@ const CipherAlgo ariaCipherAlgo =
    NULL,
    NULL,
    (CipherAlgoEncryptBlock) ariaEncryptBlock,
-   (CipherAlgoDecryptBlock) ariaDecryptBlock
+   (CipherAlgoDecryptBlock) ariaDecryptBlock,
+   NULL,
+   NULL
 };
 
 
@@ -0,0 +1,508 @@
+/**
+ * @file chacha.c
+ * @brief ChaCha encryption algorithm
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneCrypto Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL CRYPTO_TRACE_LEVEL
+
+//Dependencies
+#include <string.h>
+#include "crypto.h"
+#include "chacha.h"
+
+#if (CHACHA_SSE2_SUPPORT == ENABLED)
+   #include <emmintrin.h>
+#elif (CHACHA_NEON_SUPPORT == ENABLED)
+   #include <arm_neon.h>
+#endif
+
+//Check crypto library configuration
+#if (CHACHA_SUPPORT == ENABLED)
+
+//ChaCha quarter-round function
+#define CHACHA_QUARTER_ROUND(a, b, c, d) \
+{ \
+   a += b; d ^= a; d = ROL32(d, 16); \
+   c += d; b ^= c; b = ROL32(b, 12); \
+   a += b; d ^= a; d = ROL32(d, 8); \
+   c += d; b ^= c; b = ROL32(b, 7); \
+}
+
+//Common interface for encryption algorithms
+const CipherAlgo chacha20CipherAlgo =
+{
+   "ChaCha20",
+   sizeof(ChachaContext),
+   CIPHER_ALGO_TYPE_STREAM,
+   0,
+   (CipherAlgoInit) chacha20Init,
+   (CipherAlgoEncryptStream) chachaCipher,
+   (CipherAlgoDecryptStream) chachaCipher,
+   NULL,
+   NULL,
+   NULL,
+   NULL
+};
+
+//Forward declaration of functions
+static void chachaProcessBlock(ChachaContext *context);
+
+#if (CHACHA_SSE2_SUPPORT == ENABLED || CHACHA_NEON_SUPPORT == ENABLED)
+static void chachaProcess4Blocks(ChachaContext *context,
+   const uint8_t *input, uint8_t *output);
+#endif
+
+
+/**
+ * @brief Initialize a ChaCha context using the supplied key and nonce
+ * @param[in] context Pointer to the ChaCha context to initialize
+ * @param[in] nr Number of rounds to be applied (8, 12 or 20)
+ * @param[in] key Pointer to the key
+ * @param[in] keyLength Length of the key, in bytes (16 or 32)
+ * @param[in] nonce Pointer to the nonce
+ * @param[in] nonceLength Length of the nonce, in bytes (8 or 12)
+ * @return Error code
+ **/
+
+error_t chachaInit(ChachaContext *context, uint_t nr, const uint8_t *key,
+   size_t keyLength, const uint8_t *nonce, size_t nonceLength)
+{
+   uint32_t *w;
+
+   //The number of rounds must be 8, 12 or 20
+   if(nr != 8 && nr != 12 && nr != 20)
+      return ERROR_INVALID_PARAMETER;
+
+   //Save the number of rounds to be applied
+   context->nr = nr;
+   //Point to the input block
+   w = context->state;
+
+   //Check the length of the key
+   if(keyLength == 16)
+   {
+      //The first four words are constants ("expand 16-byte k")
+      w[0] = 0x61707865;
+      w[1] = 0x3120646E;
+      w[2] = 0x79622D36;
+      w[3] = 0x6B206574;
+
+      //The 128-bit key is used twice
+      w[4] = LOAD32LE(key);
+      w[5] = LOAD32LE(key + 4);
+      w[6] = LOAD32LE(key + 8);
+      w[7] = LOAD32LE(key + 12);
+      w[8] = LOAD32LE(key);
+      w[9] = LOAD32LE(key + 4);
+      w[10] = LOAD32LE(key + 8);
+      w[11] = LOAD32LE(key + 12);
+   }
+   else if(keyLength == 32)
+   {
+      //The first four words are constants ("expand 32-byte k")
+      w[0] = 0x61707865;
+      w[1] = 0x3320646E;
+      w[2] = 0x79622D32;
+      w[3] = 0x6B206574;
+
+      //The next eight words are taken from the 256-bit key
+      w[4] = LOAD32LE(key);
+      w[5] = LOAD32LE(key + 4);
+      w[6] = LOAD32LE(key + 8);
+      w[7] = LOAD32LE(key + 12);
+      w[8] = LOAD32LE(key + 16);
+      w[9] = LOAD32LE(key + 20);
+      w[10] = LOAD32LE(key + 24);
+      w[11] = LOAD32LE(key + 28);
+   }
+   else
+   {
+      //Invalid key length
+      return ERROR_INVALID_KEY_LENGTH;
+   }
+
+   //Check the length of the nonce
+   if(nonceLength == 8)
+   {
+      //64-bit block counter followed by a 64-bit nonce
+      w[12] = 0;
+      w[13] = 0;
+      w[14] = LOAD32LE(nonce);
+      w[15] = LOAD32LE(nonce + 4);
+   }
+   else if(nonceLength == 12)
+   {
+      //32-bit block counter followed by a 96-bit nonce (RFC 7539)
+      w[12] = 0;
+      w[13] = LOAD32LE(nonce);
+      w[14] = LOAD32LE(nonce + 4);
+      w[15] = LOAD32LE(nonce + 8);
+   }
+   else
+   {
+      //Invalid nonce length
+      return ERROR_INVALID_PARAMETER;
+   }
+
+   //No key stream is available yet
+   context->pos = CHACHA_BLOCK_SIZE;
+
+   //ChaCha context successfully initialized
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Initialize a ChaCha20 context using the supplied key
+ *
+ * The nonce and the block counter are set to zero. Callers that need a
+ * nonce must use chachaInit() instead
+ *
+ * @param[in] context Pointer to the ChaCha context to initialize
+ * @param[in] key Pointer to the key
+ * @param[in] keyLength Length of the key
+ * @return Error code
+ **/
+
+error_t chacha20Init(ChachaContext *context, const uint8_t *key, size_t keyLength)
+{
+   static const uint8_t nonce[12] = {0};
+
+   //Initialize the context with an all-zero nonce
+   return chachaInit(context, 20, key, keyLength, nonce, sizeof(nonce));
+}
+
+
+/**
+ * @brief Encrypt/decrypt data with the ChaCha algorithm
+ * @param[in] context Pointer to the ChaCha context
+ * @param[in] input Pointer to the data to encrypt/decrypt (if NULL, the
+ *   raw key stream is written to the output buffer)
+ * @param[in] output Pointer to the resulting data
+ * @param[in] length Length of the input data
+ **/
+
+void chachaCipher(ChachaContext *context, const uint8_t *input,
+   uint8_t *output, size_t length)
+{
+   uint_t i;
+   uint_t n;
+
+   //Process input data
+   while(length > 0)
+   {
+#if (CHACHA_SSE2_SUPPORT == ENABLED || CHACHA_NEON_SUPPORT == ENABLED)
+      //Process four blocks in parallel whenever possible
+      if(input != NULL && context->pos >= CHACHA_BLOCK_SIZE &&
+         length >= (4 * CHACHA_BLOCK_SIZE))
+      {
+         //Encrypt/decrypt 256 bytes at a time
+         chachaProcess4Blocks(context, input, output);
+
+         //Advance data pointers
+         input += 4 * CHACHA_BLOCK_SIZE;
+         output += 4 * CHACHA_BLOCK_SIZE;
+         //Remaining bytes to process
+         length -= 4 * CHACHA_BLOCK_SIZE;
+         //Process the next chunk
+         continue;
+      }
+#endif
+      //Generate a new key stream block if necessary
+      if(context->pos >= CHACHA_BLOCK_SIZE)
+      {
+         chachaProcessBlock(context);
+         context->pos = 0;
+      }
+
+      //Number of key stream bytes that can be used at this time
+      n = min(length, CHACHA_BLOCK_SIZE - context->pos);
+
+      //Check whether the caller wants the raw key stream
+      if(input != NULL)
+      {
+         //Encrypt/decrypt data
+         for(i = 0; i < n; i++)
+            output[i] = input[i] ^ context->block[context->pos + i];
+
+         //Advance input pointer
+         input += n;
+      }
+      else
+      {
+         //Copy the key stream
+         for(i = 0; i < n; i++)
+            output[i] = context->block[context->pos + i];
+      }
+
+      //Update the number of key stream bytes used
+      context->pos += n;
+      //Advance output pointer
+      output += n;
+      //Remaining bytes to process
+      length -= n;
+   }
+}
+
+
+/**
+ * @brief Generate a block of key stream
+ * @param[in] context Pointer to the ChaCha context
+ **/
+
+static void chachaProcessBlock(ChachaContext *context)
+{
+   uint_t i;
+   uint32_t *w;
+   uint32_t x[16];
+
+   //Point to the input block
+   w = context->state;
+
+   //Copy the input block
+   for(i = 0; i < 16; i++)
+      x[i] = w[i];
+
+   //Each double round is made of a column round and a diagonal round
+   for(i = 0; i < context->nr; i += 2)
+   {
+      //Column round
+      CHACHA_QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+      CHACHA_QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+      CHACHA_QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+      CHACHA_QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+
+      //Diagonal round
+      CHACHA_QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+      CHACHA_QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+      CHACHA_QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+      CHACHA_QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+   }
+
+   //Add the original input words to the output words and serialize
+   //the result in little-endian order
+   for(i = 0; i < 16; i++)
+      STORE32LE(x[i] + w[i], context->block + i * 4);
+
+   //Increment block counter (a single message is limited to 2^32 blocks)
+   w[12]++;
+}
+
+#if (CHACHA_SSE2_SUPPORT == ENABLED)
+
+//Rotate each 32-bit lane to the left
+#define CHACHA_ROL_SSE2(v, n) _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - (n)))
+
+//Quarter-round function applied to four blocks at a time
+#define CHACHA_QUARTER_ROUND_SSE2(a, b, c, d) \
+{ \
+   a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = CHACHA_ROL_SSE2(d, 16); \
+   c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = CHACHA_ROL_SSE2(b, 12); \
+   a = _mm_add_epi32(a, b); d = _mm_xor_si128(d, a); d = CHACHA_ROL_SSE2(d, 8); \
+   c = _mm_add_epi32(c, d); b = _mm_xor_si128(b, c); b = CHACHA_ROL_SSE2(b, 7); \
+}
+
+
+/**
+ * @brief Encrypt/decrypt four consecutive blocks (SSE2)
+ *
+ * Lane j of each vector holds one state word of the j-th block, so that
+ * the four blocks are computed side by side without any shuffling
+ *
+ * @param[in] context Pointer to the ChaCha context
+ * @param[in] input Pointer to the data to encrypt/decrypt (256 bytes)
+ * @param[out] output Pointer to the resulting data (256 bytes)
+ **/
+
+static void chachaProcess4Blocks(ChachaContext *context,
+   const uint8_t *input, uint8_t *output)
+{
+   uint_t i;
+   uint32_t *w;
+   __m128i x[16];
+   __m128i s[16];
+   __m128i t0, t1, t2, t3;
+
+   //Point to the input block
+   w = context->state;
+
+   //Broadcast the input words. The block counter differs for each lane
+   for(i = 0; i < 16; i++)
+      s[i] = _mm_set1_epi32(w[i]);
+
+   s[12] = _mm_add_epi32(s[12], _mm_set_epi32(3, 2, 1, 0));
+
+   //Copy the input blocks
+   for(i = 0; i < 16; i++)
+      x[i] = s[i];
+
+   //Each double round is made of a column round and a diagonal round
+   for(i = 0; i < context->nr; i += 2)
+   {
+      //Column round
+      CHACHA_QUARTER_ROUND_SSE2(x[0], x[4], x[8], x[12]);
+      CHACHA_QUARTER_ROUND_SSE2(x[1], x[5], x[9], x[13]);
+      CHACHA_QUARTER_ROUND_SSE2(x[2], x[6], x[10], x[14]);
+      CHACHA_QUARTER_ROUND_SSE2(x[3], x[7], x[11], x[15]);
+
+      //Diagonal round
+      CHACHA_QUARTER_ROUND_SSE2(x[0], x[5], x[10], x[15]);
+      CHACHA_QUARTER_ROUND_SSE2(x[1], x[6], x[11], x[12]);
+      CHACHA_QUARTER_ROUND_SSE2(x[2], x[7], x[8], x[13]);
+      CHACHA_QUARTER_ROUND_SSE2(x[3], x[4], x[9], x[14]);
+   }
+
+   //Add the original input words
+   for(i = 0; i < 16; i++)
+      x[i] = _mm_add_epi32(x[i], s[i]);
+
+   //Transpose each group of four words so that every vector holds 16
+   //consecutive bytes of a single block
+   for(i = 0; i < 16; i += 4)
+   {
+      t0 = _mm_unpacklo_epi32(x[i], x[i + 1]);
+      t1 = _mm_unpacklo_epi32(x[i + 2], x[i + 3]);
+      t2 = _mm_unpackhi_epi32(x[i], x[i + 1]);
+      t3 = _mm_unpackhi_epi32(x[i + 2], x[i + 3]);
+
+      x[i] = _mm_unpacklo_epi64(t0, t1);
+      x[i + 1] = _mm_unpackhi_epi64(t0, t1);
+      x[i + 2] = _mm_unpacklo_epi64(t2, t3);
+      x[i + 3] = _mm_unpackhi_epi64(t2, t3);
+   }
+
+   //XOR the key stream with the input data
+   for(i = 0; i < 16; i++)
+   {
+      //Vector i carries bytes 16 * (i / 4) to 16 * (i / 4) + 15 of block i % 4
+      t0 = _mm_loadu_si128((const __m128i *) (input + (i % 4) * 64 + (i / 4) * 16));
+      t0 = _mm_xor_si128(t0, x[i]);
+      _mm_storeu_si128((__m128i *) (output + (i % 4) * 64 + (i / 4) * 16), t0);
+   }
+
+   //Increment block counter
+   w[12] += 4;
+}
+
+#elif (CHACHA_NEON_SUPPORT == ENABLED)
+
+//Rotate each 32-bit lane to the left
+#define CHACHA_ROL_NEON(v, n) vorrq_u32(vshlq_n_u32(v, n), vshrq_n_u32(v, 32 - (n)))
+
+//Quarter-round function applied to four blocks at a time
+#define CHACHA_QUARTER_ROUND_NEON(a, b, c, d) \
+{ \
+   a = vaddq_u32(a, b); d = veorq_u32(d, a); d = CHACHA_ROL_NEON(d, 16); \
+   c = vaddq_u32(c, d); b = veorq_u32(b, c); b = CHACHA_ROL_NEON(b, 12); \
+   a = vaddq_u32(a, b); d = veorq_u32(d, a); d = CHACHA_ROL_NEON(d, 8); \
+   c = vaddq_u32(c, d); b = veorq_u32(b, c); b = CHACHA_ROL_NEON(b, 7); \
+}
+
+
+/**
+ * @brief Encrypt/decrypt four consecutive blocks (NEON)
+ *
+ * Lane j of each vector holds one state word of the j-th block, so that
+ * the four blocks are computed side by side without any shuffling
+ *
+ * @param[in] context Pointer to the ChaCha context
+ * @param[in] input Pointer to the data to encrypt/decrypt (256 bytes)
+ * @param[out] output Pointer to the resulting data (256 bytes)
+ **/
+
+static void chachaProcess4Blocks(ChachaContext *context,
+   const uint8_t *input, uint8_t *output)
+{
+   uint_t i;
+   uint32_t *w;
+   uint32x4_t x[16];
+   uint32x4_t s[16];
+   uint32x4x2_t t0, t1;
+   uint8x16_t b;
+   static const uint32_t lanes[4] = {0, 1, 2, 3};
+
+   //Point to the input block
+   w = context->state;
+
+   //Broadcast the input words. The block counter differs for each lane
+   for(i = 0; i < 16; i++)
+      s[i] = vdupq_n_u32(w[i]);
+
+   s[12] = vaddq_u32(s[12], vld1q_u32(lanes));
+
+   //Copy the input blocks
+   for(i = 0; i < 16; i++)
+      x[i] = s[i];
+
+   //Each double round is made of a column round and a diagonal round
+   for(i = 0; i < context->nr; i += 2)
+   {
+      //Column round
+      CHACHA_QUARTER_ROUND_NEON(x[0], x[4], x[8], x[12]);
+      CHACHA_QUARTER_ROUND_NEON(x[1], x[5], x[9], x[13]);
+      CHACHA_QUARTER_ROUND_NEON(x[2], x[6], x[10], x[14]);
+      CHACHA_QUARTER_ROUND_NEON(x[3], x[7], x[11], x[15]);
+
+      //Diagonal round
+      CHACHA_QUARTER_ROUND_NEON(x[0], x[5], x[10], x[15]);
+      CHACHA_QUARTER_ROUND_NEON(x[1], x[6], x[11], x[12]);
+      CHACHA_QUARTER_ROUND_NEON(x[2], x[7], x[8], x[13]);
+      CHACHA_QUARTER_ROUND_NEON(x[3], x[4], x[9], x[14]);
+   }
+
+   //Add the original input words
+   for(i = 0; i < 16; i++)
+      x[i] = vaddq_u32(x[i], s[i]);
+
+   //Transpose each group of four words so that every vector holds 16
+   //consecutive bytes of a single block
+   for(i = 0; i < 16; i += 4)
+   {
+      t0 = vtrnq_u32(x[i], x[i + 1]);
+      t1 = vtrnq_u32(x[i + 2], x[i + 3]);
+
+      x[i] = vcombine_u32(vget_low_u32(t0.val[0]), vget_low_u32(t1.val[0]));
+      x[i + 1] = vcombine_u32(vget_low_u32(t0.val[1]), vget_low_u32(t1.val[1]));
+      x[i + 2] = vcombine_u32(vget_high_u32(t0.val[0]), vget_high_u32(t1.val[0]));
+      x[i + 3] = vcombine_u32(vget_high_u32(t0.val[1]), vget_high_u32(t1.val[1]));
+   }
+
+   //XOR the key stream with the input data (little-endian target)
+   for(i = 0; i < 16; i++)
+   {
+      //Vector i carries bytes 16 * (i / 4) to 16 * (i / 4) + 15 of block i % 4
+      b = vld1q_u8(input + (i % 4) * 64 + (i / 4) * 16);
+      b = veorq_u8(b, vreinterpretq_u8_u32(x[i]));
+      vst1q_u8(output + (i % 4) * 64 + (i / 4) * 16, b);
+   }
+
+   //Increment block counter
+   w[12] += 4;
+}
+
+#endif
+#endif
@@ -0,0 +1,90 @@
+/**
+ * @file chacha.h
+ * @brief ChaCha encryption algorithm
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneCrypto Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+#ifndef _CHACHA_H
+#define _CHACHA_H
+
+//Dependencies
+#include "crypto.h"
+
+//SSE2 instruction set support
+#ifndef CHACHA_SSE2_SUPPORT
+   #define CHACHA_SSE2_SUPPORT DISABLED
+#elif (CHACHA_SSE2_SUPPORT != ENABLED && CHACHA_SSE2_SUPPORT != DISABLED)
+   #error CHACHA_SSE2_SUPPORT parameter is invalid
+#endif
+
+//The compiler must target a processor that implements SSE2
+#if (CHACHA_SSE2_SUPPORT == ENABLED && !defined(__SSE2__))
+   #error CHACHA_SSE2_SUPPORT requires a target with SSE2 instructions
+#endif
+
+//NEON instruction set support
+#ifndef CHACHA_NEON_SUPPORT
+   #define CHACHA_NEON_SUPPORT DISABLED
+#elif (CHACHA_NEON_SUPPORT != ENABLED && CHACHA_NEON_SUPPORT != DISABLED)
+   #error CHACHA_NEON_SUPPORT parameter is invalid
+#endif
+
+//The compiler must target a processor that implements NEON
+#if (CHACHA_NEON_SUPPORT == ENABLED && !defined(__ARM_NEON))
+   #error CHACHA_NEON_SUPPORT requires a target with NEON instructions
+#endif
+
+//ChaCha block size
+#define CHACHA_BLOCK_SIZE 64
+//Common interface for encryption algorithms
+#define CHACHA20_CIPHER_ALGO (&chacha20CipherAlgo)
+
+
+/**
+ * @brief ChaCha algorithm context
+ **/
+
+typedef struct
+{
+   uint_t nr;                          ///<Number of rounds
+   uint32_t state[16];                 ///<Input block (key, counter and nonce)
+   uint8_t block[CHACHA_BLOCK_SIZE];   ///<Current key stream block
+   size_t pos;                         ///<Number of key stream bytes already used
+} ChachaContext;
+
+
+//ChaCha related constants
+extern const CipherAlgo chacha20CipherAlgo;
+
+//ChaCha related functions
+error_t chachaInit(ChachaContext *context, uint_t nr, const uint8_t *key,
+   size_t keyLength, const uint8_t *nonce, size_t nonceLength);
+
+error_t chacha20Init(ChachaContext *context, const uint8_t *key, size_t keyLength);
+
+void chachaCipher(ChachaContext *context, const uint8_t *input,
+   uint8_t *output, size_t length);
+
+#endif
@@ -0,0 +1,251 @@
+/**
+ * @file chacha20_poly1305.c
+ * @brief ChaCha20Poly1305 AEAD
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneCrypto Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * ChaCha20Poly1305 is an authenticated encryption algorithm that combines
+ * the ChaCha20 stream cipher with the Poly1305 message-authentication code.
+ * Refer to RFC 7539 for more details
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL CRYPTO_TRACE_LEVEL
+
+//Dependencies
+#include <string.h>
+#include "crypto.h"
+#include "chacha.h"
+#include "poly1305.h"
+#include "chacha20_poly1305.h"
+#include "debug.h"
+
+//Check crypto library configuration
+#if (CHACHA20_POLY1305_SUPPORT == ENABLED)
+
+//Forward declaration of functions
+static error_t chacha20Poly1305Setup(ChachaContext *chachaContext,
+   Poly1305Context *poly1305Context, const uint8_t *k, size_t kLen,
+   const uint8_t *n, size_t nLen);
+
+static void chacha20Poly1305ComputeTag(Poly1305Context *poly1305Context,
+   const uint8_t *a, size_t aLen, const uint8_t *c, size_t length,
+   uint8_t *t);
+
+
+/**
+ * @brief Authenticated encryption using ChaCha20Poly1305
+ * @param[in] k 256-bit key
+ * @param[in] kLen Length of the key
+ * @param[in] n 96-bit nonce
+ * @param[in] nLen Length of the nonce
+ * @param[in] a Additional authenticated data
+ * @param[in] aLen Length of the additional data
+ * @param[in] p Plaintext to be encrypted
+ * @param[out] c Ciphertext resulting from the encryption
+ * @param[in] length Total number of data bytes to be encrypted
+ * @param[out] t MAC resulting from the encryption process
+ * @param[in] tLen Length of the MAC
+ * @return Error code
+ **/
+
+error_t chacha20Poly1305Encrypt(const uint8_t *k, size_t kLen,
+   const uint8_t *n, size_t nLen, const uint8_t *a, size_t aLen,
+   const uint8_t *p, uint8_t *c, size_t length, uint8_t *t, size_t tLen)
+{
+   error_t error;
+   ChachaContext chachaContext;
+   Poly1305Context poly1305Context;
+   uint8_t tag[POLY1305_TAG_SIZE];
+
+   //Check the length of the MAC
+   if(tLen < 4 || tLen > POLY1305_TAG_SIZE)
+      return ERROR_INVALID_LENGTH;
+
+   //Initialize ChaCha20 and derive the one-time Poly1305 key
+   error = chacha20Poly1305Setup(&chachaContext, &poly1305Context, k, kLen, n, nLen);
+   //Any error to report?
+   if(error)
+      return error;
+
+   //Encrypt the plaintext (the block counter starts at 1)
+   chachaCipher(&chachaContext, p, c, length);
+   //Authenticate the additional data and the ciphertext
+   chacha20Poly1305ComputeTag(&poly1305Context, a, aLen, c, length, tag);
+
+   //Copy the resulting MAC (possibly truncated)
+   memcpy(t, tag, tLen);
+
+   //Erase the key stream from memory
+   memset(&chachaContext, 0, sizeof(ChachaContext));
+
+   //Successful encryption
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Authenticated decryption using ChaCha20Poly1305
+ * @param[in] k 256-bit key
+ * @param[in] kLen Length of the key
+ * @param[in] n 96-bit nonce
+ * @param[in] nLen Length of the nonce
+ * @param[in] a Additional authenticated data
+ * @param[in] aLen Length of the additional data
+ * @param[in] c Ciphertext to be decrypted
+ * @param[out] p Plaintext resulting from the decryption
+ * @param[in] length Total number of data bytes to be decrypted
+ * @param[in] t MAC to be verified
+ * @param[in] tLen Length of the MAC
+ * @return Error code
+ **/
+
+error_t chacha20Poly1305Decrypt(const uint8_t *k, size_t kLen,
+   const uint8_t *n, size_t nLen, const uint8_t *a, size_t aLen,
+   const uint8_t *c, uint8_t *p, size_t length, const uint8_t *t, size_t tLen)
+{
+   error_t error;
+   size_t i;
+   uint8_t mask;
+   ChachaContext chachaContext;
+   Poly1305Context poly1305Context;
+   uint8_t tag[POLY1305_TAG_SIZE];
+
+   //Check the length of the MAC
+   if(tLen < 4 || tLen > POLY1305_TAG_SIZE)
+      return ERROR_INVALID_LENGTH;
+
+   //Initialize ChaCha20 and derive the one-time Poly1305 key
+   error = chacha20Poly1305Setup(&chachaContext, &poly1305Context, k, kLen, n, nLen);
+   //Any error to report?
+   if(error)
+      return error;
+
+   //Authenticate the additional data and the ciphertext before decrypting,
+   //since the ciphertext and the plaintext may share the same buffer
+   chacha20Poly1305ComputeTag(&poly1305Context, a, aLen, c, length, tag);
+   //Decrypt the ciphertext
+   chachaCipher(&chachaContext, c, p, length);
+
+   //Erase the key stream from memory
+   memset(&chachaContext, 0, sizeof(ChachaContext));
+
+   //The calculated tag is compared in constant time
+   for(mask = 0, i = 0; i < tLen; i++)
+      mask |= tag[i] ^ t[i];
+
+   //The message is rejected if the tags do not match
+   return (mask == 0) ? NO_ERROR : ERROR_FAILURE;
+}
+
+
+/**
+ * @brief Initialize ChaCha20 and derive the one-time Poly1305 key
+ * @param[out] chachaContext ChaCha20 context, positioned on block 1
+ * @param[out] poly1305Context Poly1305 context
+ * @param[in] k 256-bit key
+ * @param[in] kLen Length of the key
+ * @param[in] n 96-bit nonce
+ * @param[in] nLen Length of the nonce
+ * @return Error code
+ **/
+
+static error_t chacha20Poly1305Setup(ChachaContext *chachaContext,
+   Poly1305Context *poly1305Context, const uint8_t *k, size_t kLen,
+   const uint8_t *n, size_t nLen)
+{
+   error_t error;
+   uint8_t temp[CHACHA_BLOCK_SIZE];
+
+   //ChaCha20Poly1305 requires a 256-bit key and a 96-bit nonce
+   if(kLen != 32 || nLen != 12)
+      return ERROR_INVALID_PARAMETER;
+
+   //Initialize ChaCha20 with a block counter set to 0
+   error = chachaInit(chachaContext, 20, k, kLen, n, nLen);
+   //Any error to report?
+   if(error)
+      return error;
+
+   //The first 32 bytes of the first key stream block form the one-time
+   //Poly1305 key. The remaining bytes are discarded
+   chachaCipher(chachaContext, NULL, temp, CHACHA_BLOCK_SIZE);
+   //Initialize Poly1305
+   poly1305Init(poly1305Context, temp);
+
+   //Erase the one-time key from the stack
+   memset(temp, 0, CHACHA_BLOCK_SIZE);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Compute the Poly1305 tag over the AAD and the ciphertext
+ * @param[in] poly1305Context Poly1305 context
+ * @param[in] a Additional authenticated data
+ * @param[in] aLen Length of the additional data
+ * @param[in] c Ciphertext
+ * @param[in] length Length of the ciphertext
+ * @param[out] t Calculated 128-bit tag
+ **/
+
+static void chacha20Poly1305ComputeTag(Poly1305Context *poly1305Context,
+   const uint8_t *a, size_t aLen, const uint8_t *c, size_t length,
+   uint8_t *t)
+{
+   uint8_t temp[POLY1305_BLOCK_SIZE];
+
+   //Clear the padding bytes
+   memset(temp, 0, POLY1305_BLOCK_SIZE);
+
+   //Process the additional data, padded to a multiple of 16 bytes
+   poly1305Update(poly1305Context, a, aLen);
+
+   if((aLen % POLY1305_BLOCK_SIZE) != 0)
+      poly1305Update(poly1305Context, temp, POLY1305_BLOCK_SIZE - (aLen % POLY1305_BLOCK_SIZE));
+
+   //Process the ciphertext, padded to a multiple of 16 bytes
+   poly1305Update(poly1305Context, c, length);
+
+   if((length % POLY1305_BLOCK_SIZE) != 0)
+      poly1305Update(poly1305Context, temp, POLY1305_BLOCK_SIZE - (length % POLY1305_BLOCK_SIZE));
+
+   //Append the lengths of the additional data and of the ciphertext,
+   //encoded as 64-bit little-endian integers
+   STORE32LE((uint32_t) aLen, temp);
+   STORE32LE(0, temp + 4);
+   STORE32LE((uint32_t) length, temp + 8);
+   STORE32LE(0, temp + 12);
+   poly1305Update(poly1305Context, temp, POLY1305_BLOCK_SIZE);
+
+   //Finalize the tag computation
+   poly1305Final(poly1305Context, t);
+}
+
+#endif
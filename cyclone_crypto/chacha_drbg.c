@@ -0,0 +1,377 @@
+/**
+ * @file chacha_drbg.c
+ * @brief ChaCha-based deterministic random bit generator
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneCrypto Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * The generator follows the fast-key-erasure construction: the ChaCha20
+ * key stream fills an output buffer, and its first 32 bytes immediately
+ * replace the key. The bytes handed out to the caller are wiped from the
+ * buffer, so that a compromise of the state does not reveal previous
+ * outputs. A child generator draws its seed from a master PRNG and
+ * reseeds itself periodically, which lets each task or connection use
+ * its own generator instead of contending for a shared one
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL CRYPTO_TRACE_LEVEL
+
+//Dependencies
+#include <string.h>
+#include "crypto.h"
+#include "chacha_drbg.h"
+#include "sha256.h"
+#include "debug.h"
+
+//Check crypto library configuration
+#if (CHACHA_DRBG_SUPPORT == ENABLED)
+
+//Common interface for PRNG algorithms
+const PrngAlgo chachaDrbgPrngAlgo =
+{
+   "ChaCha-DRBG",
+   sizeof(ChachaDrbgContext),
+   (PrngAlgoInit) chachaDrbgInit,
+   (PrngAlgoRelease) chachaDrbgRelease,
+   (PrngAlgoSeed) chachaDrbgSeed,
+   (PrngAlgoAddEntropy) chachaDrbgAddEntropy,
+   (PrngAlgoRead) chachaDrbgRead
+};
+
+//Internal functions
+static void chachaDrbgMix(ChachaDrbgContext *context,
+   const uint8_t *input, size_t length);
+
+static void chachaDrbgGenerate(ChachaDrbgContext *context);
+
+
+/**
+ * @brief Initialize PRNG context
+ * @param[in] context Pointer to the PRNG context to initialize
+ * @return Error code
+ **/
+
+error_t chachaDrbgInit(ChachaDrbgContext *context)
+{
+   //Clear PRNG state
+   memset(context, 0, sizeof(ChachaDrbgContext));
+
+   //Create a mutex to prevent simultaneous access to the PRNG state
+   context->mutex = osMutexCreate(FALSE);
+   //Out of resources?
+   if(context->mutex == OS_INVALID_HANDLE)
+      return ERROR_OUT_OF_RESOURCES;
+
+   //The buffer does not hold any output yet
+   context->pos = CHACHA_DRBG_BUFFER_SIZE;
+   //The PRNG is not ready to generate random data
+   context->ready = FALSE;
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Initialize a child generator
+ *
+ * The child generator is seeded from the master PRNG the first time
+ * random data is requested, then every CHACHA_DRBG_RESEED_INTERVAL bytes.
+ * The master PRNG does not need to be seeded at this point
+ *
+ * @param[in] context Pointer to the PRNG context to initialize
+ * @param[in] masterAlgo Master PRNG algorithm
+ * @param[in] masterContext Pointer to the master PRNG context
+ * @return Error code
+ **/
+
+error_t chachaDrbgInitChild(ChachaDrbgContext *context,
+   const PrngAlgo *masterAlgo, void *masterContext)
+{
+   error_t error;
+
+   //Check parameters
+   if(masterAlgo == NULL || masterContext == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Initialize PRNG context
+   error = chachaDrbgInit(context);
+   //Any error to report?
+   if(error) return error;
+
+   //Save the master PRNG
+   context->masterAlgo = masterAlgo;
+   context->masterContext = masterContext;
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Release PRNG context
+ * @param[in] context Pointer to the PRNG context
+ **/
+
+void chachaDrbgRelease(ChachaDrbgContext *context)
+{
+   //Release previously allocated resources
+   if(context->mutex != OS_INVALID_HANDLE)
+      osMutexClose(context->mutex);
+
+   //Clear PRNG state
+   memset(context, 0, sizeof(ChachaDrbgContext));
+}
+
+
+/**
+ * @brief Seed the PRNG state
+ * @param[in] context Pointer to the PRNG context
+ * @param[in] input Pointer to the input data
+ * @param[in] length Length of the input data
+ * @return Error code
+ **/
+
+error_t chachaDrbgSeed(ChachaDrbgContext *context, const uint8_t *input, size_t length)
+{
+   //Check parameters
+   if(length < CHACHA_DRBG_KEY_SIZE)
+      return ERROR_INVALID_PARAMETER;
+
+   //Acquire exclusive access to the PRNG state
+   osMutexAcquire(context->mutex);
+
+   //Derive a new key from the current key and the seed
+   chachaDrbgMix(context, input, length);
+
+   //Reseed accounting
+   context->byteCount = 0;
+   context->reseedCount++;
+
+   //The PRNG is ready to generate random data
+   context->ready = TRUE;
+
+   //Release exclusive access to the PRNG state
+   osMutexRelease(context->mutex);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Add entropy to the PRNG state
+ * @param[in] context Pointer to the PRNG context
+ * @param[in] source Entropy source identifier
+ * @param[in] input Pointer to the input data
+ * @param[in] length Length of the input data
+ * @param[in] entropy Actual number of bits of entropy
+ * @return Error code
+ **/
+
+error_t chachaDrbgAddEntropy(ChachaDrbgContext *context, uint_t source,
+   const uint8_t *input, size_t length, size_t entropy)
+{
+   //Acquire exclusive access to the PRNG state
+   osMutexAcquire(context->mutex);
+
+   //The input is mixed into the key right away
+   chachaDrbgMix(context, input, length);
+
+   //Update the entropy estimate
+   context->entropy += entropy;
+
+   //Enough entropy has been collected?
+   if(context->entropy >= CHACHA_DRBG_ENTROPY_THRESHOLD)
+   {
+      //Reseed accounting
+      context->entropy = 0;
+      context->byteCount = 0;
+      context->reseedCount++;
+
+      //The PRNG is ready to generate random data
+      context->ready = TRUE;
+   }
+
+   //Release exclusive access to the PRNG state
+   osMutexRelease(context->mutex);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Generate random data
+ * @param[in] context Pointer to the PRNG context
+ * @param[out] output Buffer where to store the output data
+ * @param[in] length Desired length in bytes
+ * @return Error code
+ **/
+
+error_t chachaDrbgRead(ChachaDrbgContext *context, uint8_t *output, size_t length)
+{
+   error_t error;
+   size_t n;
+   uint8_t seed[CHACHA_DRBG_KEY_SIZE];
+
+   //Initialize status code
+   error = NO_ERROR;
+
+   //Acquire exclusive access to the PRNG state
+   osMutexAcquire(context->mutex);
+
+   //Child generator that must be (re)seeded from its master?
+   if(context->masterAlgo != NULL && (!context->ready ||
+      context->byteCount >= CHACHA_DRBG_RESEED_INTERVAL))
+   {
+      //Draw a fresh seed from the master PRNG
+      error = context->masterAlgo->read(context->masterContext, seed, sizeof(seed));
+
+      //Check status code
+      if(!error)
+      {
+         //Derive a new key from the current key and the seed
+         chachaDrbgMix(context, seed, sizeof(seed));
+
+         //Reseed accounting
+         context->byteCount = 0;
+         context->reseedCount++;
+
+         //The PRNG is ready to generate random data
+         context->ready = TRUE;
+      }
+
+      //Erase the seed
+      memset(seed, 0, sizeof(seed));
+   }
+
+   //Make sure that the PRNG has been properly seeded
+   if(!error && !context->ready)
+      error = ERROR_PRNG_NOT_READY;
+
+   //Check status code
+   if(!error)
+   {
+      //Reseed accounting
+      context->byteCount += length;
+
+      //Copy the requested number of bytes from the buffer
+      while(length > 0)
+      {
+         //Refill the buffer when it is exhausted
+         if(context->pos >= CHACHA_DRBG_BUFFER_SIZE)
+            chachaDrbgGenerate(context);
+
+         //Number of bytes to copy at a time
+         n = min(length, CHACHA_DRBG_BUFFER_SIZE - context->pos);
+
+         //Copy data to the output buffer
+         memcpy(output, context->buffer + context->pos, n);
+         //Wipe the bytes that have been handed out
+         memset(context->buffer + context->pos, 0, n);
+
+         //Advance data pointer
+         context->pos += n;
+         output += n;
+         length -= n;
+      }
+   }
+
+   //Release exclusive access to the PRNG state
+   osMutexRelease(context->mutex);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Mix input data into the key
+ *
+ * The new key is the SHA-256 digest of the current key and the input.
+ * The buffered output is discarded, so that the next bytes depend on
+ * the input
+ *
+ * @param[in] context Pointer to the PRNG context
+ * @param[in] input Pointer to the input data
+ * @param[in] length Length of the input data
+ **/
+
+static void chachaDrbgMix(ChachaDrbgContext *context,
+   const uint8_t *input, size_t length)
+{
+   Sha256Context sha256Context;
+
+   //Compute K = SHA-256(K || input)
+   sha256Init(&sha256Context);
+   sha256Update(&sha256Context, context->key, CHACHA_DRBG_KEY_SIZE);
+   sha256Update(&sha256Context, input, length);
+   sha256Final(&sha256Context, context->key);
+
+   //Discard the buffered output
+   memset(context->buffer, 0, CHACHA_DRBG_BUFFER_SIZE);
+   context->pos = CHACHA_DRBG_BUFFER_SIZE;
+
+   //Erase the hash context
+   memset(&sha256Context, 0, sizeof(Sha256Context));
+}
+
+
+/**
+ * @brief Refill the output buffer
+ *
+ * The buffer is filled with the ChaCha20 key stream, and its first bytes
+ * are used as the new key (fast key erasure)
+ *
+ * @param[in] context Pointer to the PRNG context
+ **/
+
+static void chachaDrbgGenerate(ChachaDrbgContext *context)
+{
+   ChachaContext chachaContext;
+
+   //Each key is only used once, so that the nonce can be zero
+   chacha20Init(&chachaContext, context->key, CHACHA_DRBG_KEY_SIZE);
+
+   //Encrypting an all-zero buffer yields the key stream and takes
+   //advantage of the multi-block implementation
+   memset(context->buffer, 0, CHACHA_DRBG_BUFFER_SIZE);
+   chachaCipher(&chachaContext, context->buffer, context->buffer,
+      CHACHA_DRBG_BUFFER_SIZE);
+
+   //The first bytes of the key stream replace the key
+   memcpy(context->key, context->buffer, CHACHA_DRBG_KEY_SIZE);
+   memset(context->buffer, 0, CHACHA_DRBG_KEY_SIZE);
+
+   //The remaining bytes are available to the caller
+   context->pos = CHACHA_DRBG_KEY_SIZE;
+
+   //Erase the ChaCha context
+   memset(&chachaContext, 0, sizeof(ChachaContext));
+}
+
+#endif
@@ -0,0 +1,96 @@
+/**
+ * @file chacha_drbg.h
+ * @brief ChaCha-based deterministic random bit generator
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneCrypto Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+#ifndef _CHACHA_DRBG_H
+#define _CHACHA_DRBG_H
+
+//Dependencies
+#include "crypto.h"
+#include "chacha.h"
+
+//Size of the output buffer
+#ifndef CHACHA_DRBG_BUFFER_SIZE
+   #define CHACHA_DRBG_BUFFER_SIZE 512
+#elif (CHACHA_DRBG_BUFFER_SIZE < 128 || (CHACHA_DRBG_BUFFER_SIZE % 64) != 0)
+   #error CHACHA_DRBG_BUFFER_SIZE parameter is invalid
+#endif
+
+//Number of bytes a child generator outputs before reseeding from its master
+#ifndef CHACHA_DRBG_RESEED_INTERVAL
+   #define CHACHA_DRBG_RESEED_INTERVAL 65536
+#elif (CHACHA_DRBG_RESEED_INTERVAL < 1)
+   #error CHACHA_DRBG_RESEED_INTERVAL parameter is invalid
+#endif
+
+//Size of the generator key
+#define CHACHA_DRBG_KEY_SIZE 32
+//Amount of entropy required before the generator can be used (in bits)
+#define CHACHA_DRBG_ENTROPY_THRESHOLD 256
+
+//Common interface for PRNG algorithms
+#define CHACHA_DRBG_PRNG_ALGO (&chachaDrbgPrngAlgo)
+
+
+/**
+ * @brief ChaCha DRBG context
+ **/
+
+typedef struct
+{
+   OsMutex *mutex;                          ///<Mutex preventing simultaneous access to the generator
+   bool_t ready;                            ///<The generator has been properly seeded
+   const PrngAlgo *masterAlgo;              ///<Master PRNG (child generators only)
+   void *masterContext;                     ///<Master PRNG context
+   uint8_t key[CHACHA_DRBG_KEY_SIZE];       ///<Current key
+   uint8_t buffer[CHACHA_DRBG_BUFFER_SIZE]; ///<Buffered output
+   size_t pos;                              ///<Number of buffered bytes already used
+   size_t entropy;                          ///<Entropy collected so far (in bits)
+   size_t byteCount;                        ///<Number of bytes generated since the last reseed
+   uint_t reseedCount;                      ///<Number of reseeds
+} ChachaDrbgContext;
+
+
+//ChaCha DRBG related constants
+extern const PrngAlgo chachaDrbgPrngAlgo;
+
+//ChaCha DRBG related functions
+error_t chachaDrbgInit(ChachaDrbgContext *context);
+
+error_t chachaDrbgInitChild(ChachaDrbgContext *context,
+   const PrngAlgo *masterAlgo, void *masterContext);
+
+void chachaDrbgRelease(ChachaDrbgContext *context);
+
+error_t chachaDrbgSeed(ChachaDrbgContext *context, const uint8_t *input, size_t length);
+
+error_t chachaDrbgAddEntropy(ChachaDrbgContext *context, uint_t source,
+   const uint8_t *input, size_t length, size_t entropy);
+
+error_t chachaDrbgRead(ChachaDrbgContext *context, uint8_t *output, size_t length);
+
+#endif
@@ -106,7 +106,41 @@ error_t cbcDecrypt(const CipherAlgo *cipher, void *context,
    uint8_t *iv, const uint8_t *c, uint8_t *p, size_t length)
 {
    size_t i;
-   uint8_t t[16];
+   size_t k;
+   uint8_t t[16 * CIPHER_PARALLEL_BLOCKS];
+
+   //Multi-block interface available?
+   if(cipher->decryptBlocks != NULL)
+   {
+      //Unlike encryption, CBC decryption can be parallelized
+      while(length >= cipher->blockSize)
+      {
+         //Number of blocks to be processed at a time
+         k = min(length / cipher->blockSize, CIPHER_PARALLEL_BLOCKS);
+
+         //Save input blocks
+         memcpy(t, c, k * cipher->blockSize);
+
+         //Decrypt the current blocks
+         cipher->decryptBlocks(context, c, p, k);
+
+         //XOR the first output block with IV contents
+         for(i = 0; i < cipher->blockSize; i++)
+            p[i] ^= iv[i];
+
+         //XOR the subsequent output blocks with the previous input blocks
+         for(i = cipher->blockSize; i < (k * cipher->blockSize); i++)
+            p[i] ^= t[i - cipher->blockSize];
+
+         //Update IV with the last input block
+         memcpy(iv, t + (k - 1) * cipher->blockSize, cipher->blockSize);
+
+         //Next blocks
+         c += k * cipher->blockSize;
+         p += k * cipher->blockSize;
+         length -= k * cipher->blockSize;
+      }
+   }
 
    //CBC mode operates in a block-by-block fashion
    while(length >= cipher->blockSize)
@@ -62,8 +62,9 @@ error_t ctrEncrypt(const CipherAlgo *cipher, void *context, uint_t m,
    uint8_t *t, const uint8_t *p, uint8_t *c, size_t length)
 {
    size_t i;
+   size_t k;
    size_t n;
-   uint8_t o[16];
+   uint8_t o[16 * CIPHER_PARALLEL_BLOCKS];
 
    //The parameter must be a multiple of 8
    if(m % 8)
@@ -80,25 +81,42 @@ error_t ctrEncrypt(const CipherAlgo *cipher, void *context, uint_t m,
    //Process plaintext
    while(length > 0)
    {
-      //CTR mode operates in a block-by-block fashion
-      n = min(length, cipher->blockSize);
+      //Multi-block interface available?
+      if(cipher->encryptBlocks != NULL)
+      {
+         //Number of blocks to be processed at a time
+         k = (length + cipher->blockSize - 1) / cipher->blockSize;
+         k = min(k, CIPHER_PARALLEL_BLOCKS);
+
+         //Generate the counter blocks T(j) to T(j + k - 1)
+         for(i = 0; i < k; i++)
+         {
+            memcpy(o + i * cipher->blockSize, t, cipher->blockSize);
+            ctrIncCounter(t, cipher->blockSize, m);
+         }
+
+         //Compute O(j) = CIPH(T(j)) for all the blocks at once
+         cipher->encryptBlocks(context, o, o, k);
+
+         //Number of data bytes covered by the key stream
+         n = min(length, k * cipher->blockSize);
+      }
+      else
+      {
+         //CTR mode operates in a block-by-block fashion
+         n = min(length, cipher->blockSize);
 
-      //Compute O(j) = CIPH(T(j))
-      cipher->encryptBlock(context, t, o);
+         //Compute O(j) = CIPH(T(j))
+         cipher->encryptBlock(context, t, o);
+         //Standard incrementing function
+         ctrIncCounter(t, cipher->blockSize, m);
+      }
 
-      //Compute C(j) = P(j) XOR T(j)
+      //Compute C(j) = P(j) XOR O(j)
       for(i = 0; i < n; i++)
          c[i] = p[i] ^ o[i];
 
-      //Standard incrementing function
-      for(i = 0; i < m; i++)
-      {
-         //Increment the current byte and propagate the carry if necessary
-         if(++(t[cipher->blockSize - 1 - i]) != 0)
-            break;
-      }
-
-      //Next block
+      //Next blocks
       p += n;
       c += n;
       length -= n;
@@ -124,51 +142,29 @@ error_t ctrEncrypt(const CipherAlgo *cipher, void *context, uint_t m,
 error_t ctrDecrypt(const CipherAlgo *cipher, void *context, uint_t m,
    uint8_t *t, const uint8_t *c, uint8_t *p, size_t length)
 {
-   size_t i;
-   size_t n;
-   uint8_t o[16];
+   //CTR decryption is identical to CTR encryption
+   return ctrEncrypt(cipher, context, m, t, c, p, length);
+}
 
-   //The parameter must be a multiple of 8
-   if(m % 8)
-      return ERROR_INVALID_PARAMETER;
 
-   //Determine the size, in bytes, of the specific part of
-   //the block to be incremented
-   m = m / 8;
+/**
+ * @brief Standard incrementing function
+ * @param[in,out] t Counter block
+ * @param[in] n Size of the counter block
+ * @param[in] m Size in bytes of the specific part of the block to be incremented
+ **/
 
-   //Check the resulting value
-   if(m > cipher->blockSize)
-      return ERROR_INVALID_PARAMETER;
+void ctrIncCounter(uint8_t *t, size_t n, size_t m)
+{
+   size_t i;
 
-   //Process ciphertext
-   while(length > 0)
+   //The m right-most bytes of the block are incremented
+   for(i = 0; i < m; i++)
    {
-      //CTR mode operates in a block-by-block fashion
-      n = min(length, cipher->blockSize);
-
-      //Compute O(j) = CIPH(T(j))
-      cipher->encryptBlock(context, t, o);
-
-      //Compute P(j) = C(j) XOR T(j)
-      for(i = 0; i < n; i++)
-         p[i] = c[i] ^ o[i];
-
-      //Standard incrementing function
-      for(i = 0; i < m; i++)
-      {
-         //Increment the current byte and propagate the carry if necessary
-         if(++(t[cipher->blockSize - 1 - i]) != 0)
-            break;
-      }
-
-      //Next block
-      c += n;
-      p += n;
-      length -= n;
+      //Increment the current byte and propagate the carry if necessary
+      if(++(t[n - 1 - i]) != 0)
+         break;
    }
-
-   //Successful encryption
-   return NO_ERROR;
 }
 
 #endif
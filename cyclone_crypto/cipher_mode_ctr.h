@@ -39,4 +39,6 @@ error_t ctrEncrypt(const CipherAlgo *cipher, void *context, uint_t m,
 error_t ctrDecrypt(const CipherAlgo *cipher, void *context, uint_t m,
    uint8_t *t, const uint8_t *c, uint8_t *p, size_t length);
 
+void ctrIncCounter(uint8_t *t, size_t n, size_t m);
+
 #endif
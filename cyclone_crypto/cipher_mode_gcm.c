@@ -41,14 +41,150 @@
 #include "cipher_mode_gcm.h"
 #include "debug.h"
 
+#if (GCM_CLMUL_SUPPORT == ENABLED)
+   #include <wmmintrin.h>
+   #include <tmmintrin.h>
+#endif
+
 //Check crypto library configuration
 #if (GCM_SUPPORT == ENABLED)
 
+#if (GCM_CLMUL_SUPPORT == DISABLED && GCM_TABLE_W == 4)
+
+//Reduction table (4-bit multiplier)
+static const uint16_t r[16] =
+{
+   0x0000, 0x1C20, 0x3840, 0x2460, 0x7080, 0x6CA0, 0x48C0, 0x54E0,
+   0xE100, 0xFD20, 0xD940, 0xC560, 0x9180, 0x8DA0, 0xA9C0, 0xB5E0
+};
+
+#elif (GCM_CLMUL_SUPPORT == DISABLED && GCM_TABLE_W == 8)
+
+//Reduction table (8-bit multiplier)
+static const uint16_t r[256] =
+{
+   0x0000, 0x01C2, 0x0384, 0x0246, 0x0708, 0x06CA, 0x048C, 0x054E, 0x0E10, 0x0FD2, 0x0D94, 0x0C56, 0x0918, 0x08DA, 0x0A9C, 0x0B5E,
+   0x1C20, 0x1DE2, 0x1FA4, 0x1E66, 0x1B28, 0x1AEA, 0x18AC, 0x196E, 0x1230, 0x13F2, 0x11B4, 0x1076, 0x1538, 0x14FA, 0x16BC, 0x177E,
+   0x3840, 0x3982, 0x3BC4, 0x3A06, 0x3F48, 0x3E8A, 0x3CCC, 0x3D0E, 0x3650, 0x3792, 0x35D4, 0x3416, 0x3158, 0x309A, 0x32DC, 0x331E,
+   0x2460, 0x25A2, 0x27E4, 0x2626, 0x2368, 0x22AA, 0x20EC, 0x212E, 0x2A70, 0x2BB2, 0x29F4, 0x2836, 0x2D78, 0x2CBA, 0x2EFC, 0x2F3E,
+   0x7080, 0x7142, 0x7304, 0x72C6, 0x7788, 0x764A, 0x740C, 0x75CE, 0x7E90, 0x7F52, 0x7D14, 0x7CD6, 0x7998, 0x785A, 0x7A1C, 0x7BDE,
+   0x6CA0, 0x6D62, 0x6F24, 0x6EE6, 0x6BA8, 0x6A6A, 0x682C, 0x69EE, 0x62B0, 0x6372, 0x6134, 0x60F6, 0x65B8, 0x647A, 0x663C, 0x67FE,
+   0x48C0, 0x4902, 0x4B44, 0x4A86, 0x4FC8, 0x4E0A, 0x4C4C, 0x4D8E, 0x46D0, 0x4712, 0x4554, 0x4496, 0x41D8, 0x401A, 0x425C, 0x439E,
+   0x54E0, 0x5522, 0x5764, 0x56A6, 0x53E8, 0x522A, 0x506C, 0x51AE, 0x5AF0, 0x5B32, 0x5974, 0x58B6, 0x5DF8, 0x5C3A, 0x5E7C, 0x5FBE,
+   0xE100, 0xE0C2, 0xE284, 0xE346, 0xE608, 0xE7CA, 0xE58C, 0xE44E, 0xEF10, 0xEED2, 0xEC94, 0xED56, 0xE818, 0xE9DA, 0xEB9C, 0xEA5E,
+   0xFD20, 0xFCE2, 0xFEA4, 0xFF66, 0xFA28, 0xFBEA, 0xF9AC, 0xF86E, 0xF330, 0xF2F2, 0xF0B4, 0xF176, 0xF438, 0xF5FA, 0xF7BC, 0xF67E,
+   0xD940, 0xD882, 0xDAC4, 0xDB06, 0xDE48, 0xDF8A, 0xDDCC, 0xDC0E, 0xD750, 0xD692, 0xD4D4, 0xD516, 0xD058, 0xD19A, 0xD3DC, 0xD21E,
+   0xC560, 0xC4A2, 0xC6E4, 0xC726, 0xC268, 0xC3AA, 0xC1EC, 0xC02E, 0xCB70, 0xCAB2, 0xC8F4, 0xC936, 0xCC78, 0xCDBA, 0xCFFC, 0xCE3E,
+   0x9180, 0x9042, 0x9204, 0x93C6, 0x9688, 0x974A, 0x950C, 0x94CE, 0x9F90, 0x9E52, 0x9C14, 0x9DD6, 0x9898, 0x995A, 0x9B1C, 0x9ADE,
+   0x8DA0, 0x8C62, 0x8E24, 0x8FE6, 0x8AA8, 0x8B6A, 0x892C, 0x88EE, 0x83B0, 0x8272, 0x8034, 0x81F6, 0x84B8, 0x857A, 0x873C, 0x86FE,
+   0xA9C0, 0xA802, 0xAA44, 0xAB86, 0xAEC8, 0xAF0A, 0xAD4C, 0xAC8E, 0xA7D0, 0xA612, 0xA454, 0xA596, 0xA0D8, 0xA11A, 0xA35C, 0xA29E,
+   0xB5E0, 0xB422, 0xB664, 0xB7A6, 0xB2E8, 0xB32A, 0xB16C, 0xB0AE, 0xBBF0, 0xBA32, 0xB874, 0xB9B6, 0xBCF8, 0xBD3A, 0xBF7C, 0xBEBE
+};
+
+#endif
+
+
+/**
+ * @brief Initialize GCM context
+ *
+ * The hash subkey H is computed once per key. Depending on the configuration,
+ * the multiples of H are precomputed so that GHASH can process 4 or 8 bits
+ * of data per table lookup, or H is kept for the carry-less multiplication
+ *
+ * @param[in] context Pointer to the GCM context
+ * @param[in] cipherAlgo Cipher algorithm
+ * @param[in] cipherContext Pointer to the cipher algorithm context
+ * @return Error code
+ **/
+
+error_t gcmInit(GcmContext *context, const CipherAlgo *cipherAlgo, void *cipherContext)
+{
+   uint8_t h[16];
+#if (GCM_CLMUL_SUPPORT == DISABLED)
+   uint_t i;
+   uint_t j;
+   uint32_t c;
+#endif
+
+   //Check parameters
+   if(context == NULL || cipherAlgo == NULL || cipherContext == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //GCM supports only symmetric block ciphers whose block size is 128 bits
+   if(cipherAlgo->type != CIPHER_ALGO_TYPE_BLOCK || cipherAlgo->blockSize != 16)
+      return ERROR_INVALID_PARAMETER;
+
+   //Save cipher algorithm context
+   context->cipherAlgo = cipherAlgo;
+   context->cipherContext = cipherContext;
+
+   //Generate the hash subkey H
+   memset(h, 0, 16);
+   cipherAlgo->encryptBlock(cipherContext, h, h);
+
+#if (GCM_CLMUL_SUPPORT == ENABLED)
+   //Save the hash subkey H
+   memcpy(context->h, h, 16);
+#else
+   //The most significant bit of the table index is the coefficient of the
+   //lowest degree term, hence M(100...0) = H
+   j = GCM_TABLE_SIZE >> 1;
+
+   context->m[j][0] = LOAD32BE(h + 12);
+   context->m[j][1] = LOAD32BE(h + 8);
+   context->m[j][2] = LOAD32BE(h + 4);
+   context->m[j][3] = LOAD32BE(h);
+
+   //Compute M(i) = M(2 * i) * x for each power of two
+   for(i = j >> 1; i > 0; i >>= 1)
+   {
+      //Save the coefficient of the highest degree term
+      c = context->m[2 * i][0] & 0x01;
+
+      //Multiply by x
+      context->m[i][0] = (context->m[2 * i][0] >> 1) | (context->m[2 * i][1] << 31);
+      context->m[i][1] = (context->m[2 * i][1] >> 1) | (context->m[2 * i][2] << 31);
+      context->m[i][2] = (context->m[2 * i][2] >> 1) | (context->m[2 * i][3] << 31);
+      context->m[i][3] = (context->m[2 * i][3] >> 1);
+
+      //Reduce the result modulo the GCM polynomial
+      if(c)
+         context->m[i][3] ^= 0xE1000000;
+   }
+
+   //Let M(0) = 0
+   context->m[0][0] = 0;
+   context->m[0][1] = 0;
+   context->m[0][2] = 0;
+   context->m[0][3] = 0;
+
+   //The remaining entries are obtained by linearity
+   for(i = 2; i < GCM_TABLE_SIZE; i <<= 1)
+   {
+      //Compute M(i + j) = M(i) + M(j)
+      for(j = 1; j < i; j++)
+      {
+         context->m[i + j][0] = context->m[i][0] ^ context->m[j][0];
+         context->m[i + j][1] = context->m[i][1] ^ context->m[j][1];
+         context->m[i + j][2] = context->m[i][2] ^ context->m[j][2];
+         context->m[i + j][3] = context->m[i][3] ^ context->m[j][3];
+      }
+   }
+#endif
+
+   //Clear the hash subkey from the stack
+   memset(h, 0, 16);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+
 
 /**
  * @brief Authenticated encryption using GCM
- * @param[in] cipher Cipher algorithm
- * @param[in] context Cipher algorithm context
+ * @param[in] context Pointer to the GCM context
  * @param[in] iv Initialization vector
  * @param[in] ivLen Length of the initialization vector
  * @param[in] a Additional authenticated data
@@ -61,22 +197,19 @@
  * @return Error code
  **/
 
-error_t gcmEncrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, size_t ivLen,
+error_t gcmEncrypt(GcmContext *context, const uint8_t *iv, size_t ivLen,
    const uint8_t *a, size_t aLen, const uint8_t *p, uint8_t *c, size_t length, uint8_t *t, size_t tLen)
 {
+   size_t i;
    size_t k;
    size_t n;
    uint8_t b[16];
-   uint8_t h[16];
    uint8_t j[16];
    uint8_t s[16];
+   uint8_t o[16 * CIPHER_PARALLEL_BLOCKS];
 
    //Check parameters
-   if(cipher == NULL || context == NULL)
-      return ERROR_INVALID_PARAMETER;
-
-   //GCM supports only symmetric block ciphers whose block size is 128 bits
-   if(cipher->type != CIPHER_ALGO_TYPE_BLOCK || cipher->blockSize != 16)
+   if(context == NULL)
       return ERROR_INVALID_PARAMETER;
 
    //The length of the IV shall meet SP 800-38D requirements
@@ -86,10 +219,6 @@ error_t gcmEncrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, s
    if(tLen < 4 || tLen > 16)
       return ERROR_INVALID_PARAMETER;
 
-   //Generate the hash subkey H
-   memset(h, 0, 16 );
-   cipher->encryptBlock(context, h, h);
-
    //Check whether the length of the IV is 96 bits
    if(ivLen == 12)
    {
@@ -114,7 +243,7 @@ error_t gcmEncrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, s
 
          //Apply GHASH function
          gcmXorBlock(j, j, iv, k);
-         gcmMul(j, h);
+         gcmMul(context, j);
 
          //Next block
          iv += k;
@@ -129,11 +258,11 @@ error_t gcmEncrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, s
       //The GHASH function is applied to the resulting string to form the
       //pre-counter block
       gcmXorBlock(j, j, b, 16);
-      gcmMul(j, h);
+      gcmMul(context, j);
    }
 
    //Compute MSB(CIPH(J(0)))
-   cipher->encryptBlock(context, j, b);
+   context->cipherAlgo->encryptBlock(context->cipherContext, j, b);
    memcpy(t, b, tLen);
 
    //Initialize GHASH calculation
@@ -149,7 +278,7 @@ error_t gcmEncrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, s
 
       //Apply GHASH function
       gcmXorBlock(s, s, a, k);
-      gcmMul(s, h);
+      gcmMul(context, s);
 
       //Next block
       a += k;
@@ -162,21 +291,20 @@ error_t gcmEncrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, s
    //Process plaintext
    while(n > 0)
    {
-      //The encryption operates in a block-by-block fashion
-      k = min(n, 16);
-
-      //Increment counter
-      gcmIncCounter(j);
+      //Generate the key stream for several blocks at a time
+      k = gcmGenerateKeyStream(context, j, o, n);
 
       //Encrypt plaintext
-      cipher->encryptBlock(context, j, b);
-      gcmXorBlock(c, p, b, k);
+      gcmXorBlock(c, p, o, k);
 
-      //Apply GHASH function
-      gcmXorBlock(s, s, c, k);
-      gcmMul(s, h);
+      //Apply GHASH function to each block of ciphertext
+      for(i = 0; i < k; i += 16)
+      {
+         gcmXorBlock(s, s, c + i, min(k - i, 16));
+         gcmMul(context, s);
+      }
 
-      //Next block
+      //Next blocks
       p += k;
       c += k;
       n -= k;
@@ -189,7 +317,7 @@ error_t gcmEncrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, s
 
    //The GHASH function is applied to the result to produce a single output block S
    gcmXorBlock(s, s, b, 16);
-   gcmMul(s, h);
+   gcmMul(context, s);
 
    //Let T = MSB(GCTR(J(0), S)
    gcmXorBlock(t, t, s, tLen);
@@ -201,8 +329,7 @@ error_t gcmEncrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, s
 
 /**
  * @brief Authenticated decryption using GCM
- * @param[in] cipher Cipher algorithm
- * @param[in] context Cipher algorithm context
+ * @param[in] context Pointer to the GCM context
  * @param[in] iv Initialization vector
  * @param[in] ivLen Length of the initialization vector
  * @param[in] a Additional authenticated data
@@ -215,23 +342,20 @@ error_t gcmEncrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, s
  * @return Error code
  **/
 
-error_t gcmDecrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, size_t ivLen,
+error_t gcmDecrypt(GcmContext *context, const uint8_t *iv, size_t ivLen,
    const uint8_t *a, size_t aLen, const uint8_t *c, uint8_t *p, size_t length, const uint8_t *t, size_t tLen)
 {
+   size_t i;
    size_t k;
    size_t n;
    uint8_t b[16];
-   uint8_t h[16];
    uint8_t j[16];
    uint8_t r[16];
    uint8_t s[16];
+   uint8_t o[16 * CIPHER_PARALLEL_BLOCKS];
 
    //Check parameters
-   if(cipher == NULL || context == NULL)
-      return ERROR_INVALID_PARAMETER;
-
-   //GCM supports only symmetric block ciphers whose block size is 128 bits
-   if(cipher->type != CIPHER_ALGO_TYPE_BLOCK || cipher->blockSize != 16)
+   if(context == NULL)
       return ERROR_INVALID_PARAMETER;
 
    //The length of the IV shall meet SP 800-38D requirements
@@ -241,10 +365,6 @@ error_t gcmDecrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, s
    if(tLen < 4 || tLen > 16)
       return ERROR_INVALID_PARAMETER;
 
-   //Generate the hash subkey H
-   memset(h, 0, 16 );
-   cipher->encryptBlock(context, h, h);
-
    //Check whether the length of the IV is 96 bits
    if(ivLen == 12)
    {
@@ -269,7 +389,7 @@ error_t gcmDecrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, s
 
          //Apply GHASH function
          gcmXorBlock(j, j, iv, k);
-         gcmMul(j, h);
+         gcmMul(context, j);
 
          //Next block
          iv += k;
@@ -284,11 +404,11 @@ error_t gcmDecrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, s
       //The GHASH function is applied to the resulting string to form the
       //pre-counter block
       gcmXorBlock(j, j, b, 16);
-      gcmMul(j, h);
+      gcmMul(context, j);
    }
 
    //Compute MSB(CIPH(J(0)))
-   cipher->encryptBlock(context, j, b);
+   context->cipherAlgo->encryptBlock(context->cipherContext, j, b);
    memcpy(r, b, tLen);
 
    //Initialize GHASH calculation
@@ -304,7 +424,7 @@ error_t gcmDecrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, s
 
       //Apply GHASH function
       gcmXorBlock(s, s, a, k);
-      gcmMul(s, h);
+      gcmMul(context, s);
 
       //Next block
       a += k;
@@ -317,21 +437,20 @@ error_t gcmDecrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, s
    //Process ciphertext
    while(n > 0)
    {
-      //The decryption operates in a block-by-block fashion
-      k = min(n, 16);
+      //Generate the key stream for several blocks at a time
+      k = gcmGenerateKeyStream(context, j, o, n);
 
-      //Apply GHASH function
-      gcmXorBlock(s, s, c, k);
-      gcmMul(s, h);
-
-      //Increment counter
-      gcmIncCounter(j);
+      //Apply GHASH function to each block of ciphertext
+      for(i = 0; i < k; i += 16)
+      {
+         gcmXorBlock(s, s, c + i, min(k - i, 16));
+         gcmMul(context, s);
+      }
 
       //Decrypt ciphertext
-      cipher->encryptBlock(context, j, b);
-      gcmXorBlock(p, c, b, k);
+      gcmXorBlock(p, c, o, k);
 
-      //Next block
+      //Next blocks
       c += k;
       p += k;
       n -= k;
@@ -344,7 +463,7 @@ error_t gcmDecrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, s
 
    //The GHASH function is applied to the result to produce a single output block S
    gcmXorBlock(s, s, b, 16);
-   gcmMul(s, h);
+   gcmMul(context, s);
 
    //Let R = MSB(GCTR(J(0), S)
    gcmXorBlock(r, r, s, tLen);
@@ -359,43 +478,208 @@ error_t gcmDecrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, s
 
 
 /**
- * @brief Multiplication operation
- * @param[in, out] x First block
- * @param[in] y Second block
+ * @brief Multiplication in GF(2^128)
+ * @param[in] context Pointer to the GCM context
+ * @param[in, out] x Block to be multiplied by the hash subkey H
  **/
 
-void gcmMul(uint8_t *x, const uint8_t *y)
+#if (GCM_CLMUL_SUPPORT == ENABLED)
+
+void gcmMul(GcmContext *context, uint8_t *x)
+{
+   __m128i a;
+   __m128i b;
+   __m128i mask;
+   __m128i t0;
+   __m128i t1;
+   __m128i t2;
+   __m128i t3;
+   __m128i t4;
+   __m128i t5;
+
+   //GCM uses a reflected bit order, whereas the PCLMULQDQ instruction
+   //operates on little-endian operands
+   mask = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+   //Load operands
+   a = _mm_shuffle_epi8(_mm_loadu_si128((__m128i *) x), mask);
+   b = _mm_shuffle_epi8(_mm_loadu_si128((__m128i *) context->h), mask);
+
+   //Compute the 256-bit carry-less product (schoolbook method)
+   t0 = _mm_clmulepi64_si128(a, b, 0x00);
+   t1 = _mm_clmulepi64_si128(a, b, 0x10);
+   t2 = _mm_clmulepi64_si128(a, b, 0x01);
+   t3 = _mm_clmulepi64_si128(a, b, 0x11);
+
+   //Combine the middle terms
+   t1 = _mm_xor_si128(t1, t2);
+   t2 = _mm_slli_si128(t1, 8);
+   t1 = _mm_srli_si128(t1, 8);
+   t0 = _mm_xor_si128(t0, t2);
+   t3 = _mm_xor_si128(t3, t1);
+
+   //Shift the 256-bit product left by one bit to account for the
+   //reflected bit order
+   t4 = _mm_srli_epi32(t0, 31);
+   t5 = _mm_srli_epi32(t3, 31);
+   t0 = _mm_slli_epi32(t0, 1);
+   t3 = _mm_slli_epi32(t3, 1);
+   t2 = _mm_srli_si128(t4, 12);
+   t5 = _mm_slli_si128(t5, 4);
+   t4 = _mm_slli_si128(t4, 4);
+   t0 = _mm_or_si128(t0, t4);
+   t3 = _mm_or_si128(t3, t5);
+   t3 = _mm_or_si128(t3, t2);
+
+   //First phase of the reduction
+   t4 = _mm_slli_epi32(t0, 31);
+   t5 = _mm_slli_epi32(t0, 30);
+   t2 = _mm_slli_epi32(t0, 25);
+   t4 = _mm_xor_si128(t4, t5);
+   t4 = _mm_xor_si128(t4, t2);
+   t5 = _mm_srli_si128(t4, 4);
+   t4 = _mm_slli_si128(t4, 12);
+   t0 = _mm_xor_si128(t0, t4);
+
+   //Second phase of the reduction
+   t2 = _mm_srli_epi32(t0, 1);
+   t1 = _mm_srli_epi32(t0, 2);
+   t4 = _mm_srli_epi32(t0, 7);
+   t2 = _mm_xor_si128(t2, t1);
+   t2 = _mm_xor_si128(t2, t4);
+   t2 = _mm_xor_si128(t2, t5);
+   t0 = _mm_xor_si128(t0, t2);
+   t3 = _mm_xor_si128(t3, t0);
+
+   //Copy the resulting block
+   _mm_storeu_si128((__m128i *) x, _mm_shuffle_epi8(t3, mask));
+}
+
+#else
+
+void gcmMul(GcmContext *context, uint8_t *x)
+{
+   int_t i;
+   uint8_t b;
+   uint8_t c;
+   uint32_t z[4];
+
+   //Let Z = 0
+   z[0] = 0;
+   z[1] = 0;
+   z[2] = 0;
+   z[3] = 0;
+
+   //Horner's rule, starting with the highest degree terms
+   for(i = 15; i >= 0; i--)
+   {
+#if (GCM_TABLE_W == 4)
+      //Get the lower nibble
+      b = x[i] & 0x0F;
+
+      //Multiply Z by x^4
+      c = z[0] & 0x0F;
+      z[0] = (z[0] >> 4) | (z[1] << 28);
+      z[1] = (z[1] >> 4) | (z[2] << 28);
+      z[2] = (z[2] >> 4) | (z[3] << 28);
+      z[3] = (z[3] >> 4) ^ ((uint32_t) r[c] << 16);
+
+      //Add the precomputed multiple of H
+      z[0] ^= context->m[b][0];
+      z[1] ^= context->m[b][1];
+      z[2] ^= context->m[b][2];
+      z[3] ^= context->m[b][3];
+
+      //Get the upper nibble
+      b = (x[i] >> 4) & 0x0F;
+
+      //Multiply Z by x^4
+      c = z[0] & 0x0F;
+      z[0] = (z[0] >> 4) | (z[1] << 28);
+      z[1] = (z[1] >> 4) | (z[2] << 28);
+      z[2] = (z[2] >> 4) | (z[3] << 28);
+      z[3] = (z[3] >> 4) ^ ((uint32_t) r[c] << 16);
+
+      //Add the precomputed multiple of H
+      z[0] ^= context->m[b][0];
+      z[1] ^= context->m[b][1];
+      z[2] ^= context->m[b][2];
+      z[3] ^= context->m[b][3];
+#else
+      //Get the current byte
+      b = x[i];
+
+      //Multiply Z by x^8
+      c = z[0] & 0xFF;
+      z[0] = (z[0] >> 8) | (z[1] << 24);
+      z[1] = (z[1] >> 8) | (z[2] << 24);
+      z[2] = (z[2] >> 8) | (z[3] << 24);
+      z[3] = (z[3] >> 8) ^ ((uint32_t) r[c] << 16);
+
+      //Add the precomputed multiple of H
+      z[0] ^= context->m[b][0];
+      z[1] ^= context->m[b][1];
+      z[2] ^= context->m[b][2];
+      z[3] ^= context->m[b][3];
+#endif
+   }
+
+   //Copy the resulting block
+   STORE32BE(z[3], x);
+   STORE32BE(z[2], x + 4);
+   STORE32BE(z[1], x + 8);
+   STORE32BE(z[0], x + 12);
+}
+
+#endif
+
+
+/**
+ * @brief Generate the key stream for the GCTR function
+ * @param[in] context Pointer to the GCM context
+ * @param[in,out] j Counter block
+ * @param[out] o Key stream
+ * @param[in] n Number of data bytes remaining to be processed
+ * @return Number of key stream bytes generated
+ **/
+
+size_t gcmGenerateKeyStream(GcmContext *context, uint8_t *j, uint8_t *o, size_t n)
 {
    size_t i;
-   uint8_t z[16];
-   uint8_t v[16];
+   size_t k;
 
-   //Let Z(0) = 0
-   memset(z, 0, 16);
-   //Let V(0) = Y
-   memcpy(v, y, 16);
+   //Determine the number of counter blocks to be encrypted at a time
+   k = (n + 15) / 16;
 
-   //Iterate 128 times
-   for(i = 0; i < 128; i++)
+   //Multi-block interface available?
+   if(context->cipherAlgo->encryptBlocks != NULL)
    {
-      if(x[i / 8] & (0x80 >> (i % 8)))
-      {
-         gcmXorBlock(z, z, v, 16);
-      }
+      //Limit the number of blocks in flight
+      k = min(k, CIPHER_PARALLEL_BLOCKS);
 
-      if(v[15] & 0x01)
-      {
-         gcmShiftBlock(v);
-         v[0] ^= 0xE1;
-      }
-      else
+      //Generate successive counter blocks
+      for(i = 0; i < k; i++)
       {
-         gcmShiftBlock(v);
+         gcmIncCounter(j);
+         memcpy(o + 16 * i, j, 16);
       }
+
+      //Encrypt the counter blocks
+      context->cipherAlgo->encryptBlocks(context->cipherContext, o, o, k);
    }
+   else
+   {
+      //The key stream is generated in a block-by-block fashion
+      k = 1;
 
-   //Copy the resulting block
-   memcpy(x, z, 16);
+      //Increment counter
+      gcmIncCounter(j);
+      //Encrypt the counter block
+      context->cipherAlgo->encryptBlock(context->cipherContext, j, o);
+   }
+
+   //Return the number of key stream bytes that are actually used
+   return min(n, 16 * k);
 }
 
 
@@ -417,23 +701,6 @@ void gcmXorBlock(uint8_t *a, const uint8_t *b, const uint8_t *c, size_t n)
 }
 
 
-/**
- * @brief Shift operation
- * @param[in,out] a Block to be shifted
- **/
-
-void gcmShiftBlock(uint8_t *a)
-{
-   size_t i;
-
-   //Shift the block to the right
-   for(i = 0; i < 15; i++)
-      a[15 - i] = (a[15 - i] >> 1) | (a[14 - i] << 7);
-
-   a[0] = (a[0] >> 1);
-}
-
-
 /**
  * @brief Increment counter block
  * @param[in,out] a Pointer to the counter block
@@ -32,16 +32,57 @@
 //Dependencies
 #include "crypto.h"
 
+//Number of bits processed per table lookup (4 or 8)
+#ifndef GCM_TABLE_W
+   #define GCM_TABLE_W 4
+#elif (GCM_TABLE_W != 4 && GCM_TABLE_W != 8)
+   #error GCM_TABLE_W parameter is invalid
+#endif
+
+//Carry-less multiplication (PCLMULQDQ instruction) support
+#ifndef GCM_CLMUL_SUPPORT
+   #define GCM_CLMUL_SUPPORT DISABLED
+#elif (GCM_CLMUL_SUPPORT != ENABLED && GCM_CLMUL_SUPPORT != DISABLED)
+   #error GCM_CLMUL_SUPPORT parameter is invalid
+#endif
+
+//The carry-less multiplication requires PCLMULQDQ and SSSE3 instructions
+#if (GCM_CLMUL_SUPPORT == ENABLED && (!defined(__PCLMUL__) || !defined(__SSSE3__)))
+   #error GCM_CLMUL_SUPPORT requires a target with PCLMULQDQ and SSSE3 instructions
+#endif
+
+//Size of the precomputed multiplication table
+#define GCM_TABLE_SIZE (1 << GCM_TABLE_W)
+
+
+/**
+ * @brief GCM context
+ **/
+
+typedef struct
+{
+   const CipherAlgo *cipherAlgo; ///<Cipher algorithm
+   void *cipherContext;          ///<Cipher algorithm context
+#if (GCM_CLMUL_SUPPORT == ENABLED)
+   uint8_t h[16];                ///<Hash subkey H
+#else
+   uint32_t m[GCM_TABLE_SIZE][4]; ///<Precalculated multiples of the hash subkey H
+#endif
+} GcmContext;
+
+
 //GCM related functions
-error_t gcmEncrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, size_t ivLen,
+error_t gcmInit(GcmContext *context, const CipherAlgo *cipherAlgo, void *cipherContext);
+
+error_t gcmEncrypt(GcmContext *context, const uint8_t *iv, size_t ivLen,
    const uint8_t *a, size_t aLen, const uint8_t *p, uint8_t *c, size_t length, uint8_t *t, size_t tLen);
 
-error_t gcmDecrypt(const CipherAlgo *cipher, void *context, const uint8_t *iv, size_t ivLen,
+error_t gcmDecrypt(GcmContext *context, const uint8_t *iv, size_t ivLen,
    const uint8_t *a, size_t aLen, const uint8_t *c, uint8_t *p, size_t length, const uint8_t *t, size_t tLen);
 
-void gcmMul(uint8_t *x, const uint8_t *y);
+void gcmMul(GcmContext *context, uint8_t *x);
+size_t gcmGenerateKeyStream(GcmContext *context, uint8_t *j, uint8_t *o, size_t n);
 void gcmXorBlock(uint8_t *a, const uint8_t *b, const uint8_t *c, size_t n);
-void gcmShiftBlock(uint8_t *a);
 void gcmIncCounter(uint8_t *a);
 
 #endif
@@ -203,6 +203,20 @@
    #error ARIA_SUPPORT parameter is invalid
 #endif
 
+//ChaCha support
+#ifndef CHACHA_SUPPORT
+   #define CHACHA_SUPPORT ENABLED
+#elif (CHACHA_SUPPORT != ENABLED && CHACHA_SUPPORT != DISABLED)
+   #error CHACHA_SUPPORT parameter is invalid
+#endif
+
+//Poly1305 support
+#ifndef POLY1305_SUPPORT
+   #define POLY1305_SUPPORT ENABLED
+#elif (POLY1305_SUPPORT != ENABLED && POLY1305_SUPPORT != DISABLED)
+   #error POLY1305_SUPPORT parameter is invalid
+#endif
+
 //ECB mode support
 #ifndef ECB_SUPPORT
    #define ECB_SUPPORT ENABLED
@@ -252,6 +266,34 @@
    #error GCM_SUPPORT parameter is invalid
 #endif
 
+//ChaCha20Poly1305 support
+#ifndef CHACHA20_POLY1305_SUPPORT
+   #define CHACHA20_POLY1305_SUPPORT ENABLED
+#elif (CHACHA20_POLY1305_SUPPORT != ENABLED && CHACHA20_POLY1305_SUPPORT != DISABLED)
+   #error CHACHA20_POLY1305_SUPPORT parameter is invalid
+#endif
+
+//Batched RSA private-key operations
+#ifndef RSA_BATCH_SUPPORT
+   #define RSA_BATCH_SUPPORT ENABLED
+#elif (RSA_BATCH_SUPPORT != ENABLED && RSA_BATCH_SUPPORT != DISABLED)
+   #error RSA_BATCH_SUPPORT parameter is invalid
+#endif
+
+//ChaCha-based deterministic random bit generator
+#ifndef CHACHA_DRBG_SUPPORT
+   #define CHACHA_DRBG_SUPPORT ENABLED
+#elif (CHACHA_DRBG_SUPPORT != ENABLED && CHACHA_DRBG_SUPPORT != DISABLED)
+   #error CHACHA_DRBG_SUPPORT parameter is invalid
+#endif
+
+//Number of blocks processed per call to the multi-block interface
+#ifndef CIPHER_PARALLEL_BLOCKS
+   #define CIPHER_PARALLEL_BLOCKS 8
+#elif (CIPHER_PARALLEL_BLOCKS < 1 || CIPHER_PARALLEL_BLOCKS > 8)
+   #error CIPHER_PARALLEL_BLOCKS parameter is invalid
+#endif
+
 //Maximum context size (hash functions)
 #if (SHA512_SUPPORT == ENABLED)
    #define MAX_HASH_CONTEXT_SIZE sizeof(Sha512Context)
@@ -384,7 +426,8 @@ typedef enum
    CIPHER_MODE_OFB    = 4,
    CIPHER_MODE_CTR    = 5,
    CIPHER_MODE_CCM    = 6,
-   CIPHER_MODE_GCM    = 7
+   CIPHER_MODE_GCM    = 7,
+   CIPHER_MODE_CHACHA20_POLY1305 = 8
 } CipherMode;
 
 
@@ -400,6 +443,8 @@ typedef void (*CipherAlgoEncryptStream)(void *context, const uint8_t *input, uin
 typedef void (*CipherAlgoDecryptStream)(void *context, const uint8_t *input, uint8_t *output, size_t length);
 typedef void (*CipherAlgoEncryptBlock)(void *context, const uint8_t *input, uint8_t *output);
 typedef void (*CipherAlgoDecryptBlock)(void *context, const uint8_t *input, uint8_t *output);
+typedef void (*CipherAlgoEncryptBlocks)(void *context, const uint8_t *input, uint8_t *output, size_t n);
+typedef void (*CipherAlgoDecryptBlocks)(void *context, const uint8_t *input, uint8_t *output, size_t n);
 
 //Common API for pseudo-random number generators
 typedef error_t (*PrngAlgoInit)(void *context);
@@ -453,6 +498,8 @@ typedef struct
    CipherAlgoDecryptStream decryptStream;
    CipherAlgoEncryptBlock encryptBlock;
    CipherAlgoDecryptBlock decryptBlock;
+   CipherAlgoEncryptBlocks encryptBlocks;
+   CipherAlgoDecryptBlocks decryptBlocks;
 } CipherAlgo;
 
 
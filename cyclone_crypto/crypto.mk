@@ -10,23 +10,33 @@ CYCLONETCPSRC += $(CYCLONETCP)/cyclone_crypto/aes.c \
 				 $(CYCLONETCP)/cyclone_crypto/cipher_mode_ecb.c \
 				 $(CYCLONETCP)/cyclone_crypto/cipher_mode_gcm.c \
 				 $(CYCLONETCP)/cyclone_crypto/cipher_mode_ofb.c \
+				 $(CYCLONETCP)/cyclone_crypto/chacha.c \
+				 $(CYCLONETCP)/cyclone_crypto/chacha_drbg.c \
+				 $(CYCLONETCP)/cyclone_crypto/chacha20_poly1305.c \
+				 $(CYCLONETCP)/cyclone_crypto/curve25519.c \
 				 $(CYCLONETCP)/cyclone_crypto/des.c \
 				 $(CYCLONETCP)/cyclone_crypto/des3.c \
 				 $(CYCLONETCP)/cyclone_crypto/dh.c \
 				 $(CYCLONETCP)/cyclone_crypto/dsa.c \
+				 $(CYCLONETCP)/cyclone_crypto/ec.c \
+				 $(CYCLONETCP)/cyclone_crypto/ecdh.c \
+				 $(CYCLONETCP)/cyclone_crypto/ecdsa.c \
 				 $(CYCLONETCP)/cyclone_crypto/hmac.c \
 				 $(CYCLONETCP)/cyclone_crypto/idea.c \
 				 $(CYCLONETCP)/cyclone_crypto/md2.c \
 				 $(CYCLONETCP)/cyclone_crypto/md4.c \
 				 $(CYCLONETCP)/cyclone_crypto/md5.c \
 				 $(CYCLONETCP)/cyclone_crypto/mpi.c \
+				 $(CYCLONETCP)/cyclone_crypto/p256.c \
 				 $(CYCLONETCP)/cyclone_crypto/pem.c \
 				 $(CYCLONETCP)/cyclone_crypto/pkcs5.c \
+				 $(CYCLONETCP)/cyclone_crypto/poly1305.c \
 				 $(CYCLONETCP)/cyclone_crypto/rc4.c \
 				 $(CYCLONETCP)/cyclone_crypto/rc6.c \
 				 $(CYCLONETCP)/cyclone_crypto/ripemd128.c \
 				 $(CYCLONETCP)/cyclone_crypto/ripemd160.c \
 				 $(CYCLONETCP)/cyclone_crypto/rsa.c \
+				 $(CYCLONETCP)/cyclone_crypto/rsa_batch.c \
 				 $(CYCLONETCP)/cyclone_crypto/seed.c \
 				 $(CYCLONETCP)/cyclone_crypto/sha1.c \
 				 $(CYCLONETCP)/cyclone_crypto/sha224.c \
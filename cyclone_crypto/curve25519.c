@@ -0,0 +1,526 @@
+/**
+ * @file curve25519.c
+ * @brief Curve25519 elliptic curve (X25519 key agreement)
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneCrypto Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * X25519 is a Diffie-Hellman function built on the Montgomery form of
+ * Curve25519. Field elements modulo p = 2^255 - 19 are held in eight 32-bit
+ * words and kept below 2^256 between operations (2^256 = 38 mod p). The
+ * scalar multiplication uses the Montgomery ladder with constant-time
+ * conditional swaps. Refer to RFC 7748 for more details
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL CRYPTO_TRACE_LEVEL
+
+//Dependencies
+#include <string.h>
+#include "crypto.h"
+#include "curve25519.h"
+#include "debug.h"
+
+//X25519 OID (1.3.101.110)
+const uint8_t X25519_OID[3] = {0x2B, 0x65, 0x6E};
+
+//Common interface for elliptic curves
+const EcCurveInfo curve25519Curve =
+{
+   "curve25519",
+   X25519_OID,
+   sizeof(X25519_OID),
+   EC_CURVE_TYPE_MONTGOMERY,
+   CURVE25519_FIELD_SIZE,
+   CURVE25519_POINT_SIZE,
+   NULL,
+   curve25519CheckPoint,
+   curve25519MulBase,
+   curve25519Mul,
+   NULL
+};
+
+
+/**
+ * @brief Modular addition
+ * @param[out] r Resulting value r = (a + b) mod p
+ * @param[in] a First operand
+ * @param[in] b Second operand
+ **/
+
+static void curve25519Add(uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+   uint_t i;
+   uint32_t c;
+   uint64_t temp;
+
+   //Compute a + b
+   for(c = 0, i = 0; i < 8; i++)
+   {
+      temp = (uint64_t) a[i] + b[i] + c;
+      r[i] = (uint32_t) temp;
+      c = temp >> 32;
+   }
+
+   //Fold the carry (2^256 = 38 mod p)
+   for(c *= 38, i = 0; i < 8; i++)
+   {
+      temp = (uint64_t) r[i] + c;
+      r[i] = (uint32_t) temp;
+      c = temp >> 32;
+   }
+
+   //A second carry leaves a small value in the first word
+   r[0] += c * 38;
+}
+
+
+/**
+ * @brief Modular subtraction
+ * @param[out] r Resulting value r = (a - b) mod p
+ * @param[in] a First operand
+ * @param[in] b Second operand
+ **/
+
+static void curve25519Sub(uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+   uint_t i;
+   uint32_t c;
+   uint64_t temp;
+
+   //Compute a - b
+   for(c = 0, i = 0; i < 8; i++)
+   {
+      temp = (uint64_t) a[i] - b[i] - c;
+      r[i] = (uint32_t) temp;
+      c = (temp >> 32) & 1;
+   }
+
+   //Fold the borrow (2^256 = 38 mod p)
+   for(c *= 38, i = 0; i < 8; i++)
+   {
+      temp = (uint64_t) r[i] - c;
+      r[i] = (uint32_t) temp;
+      c = (temp >> 32) & 1;
+   }
+
+   //A second borrow leaves a large value in the first word
+   r[0] -= c * 38;
+}
+
+
+/**
+ * @brief Fold the upper half of a product
+ * @param[out] r Resulting value r = (lo + 38 * hi) mod p
+ * @param[in] u 512-bit value (or 288-bit value if n = 1)
+ * @param[in] n Number of upper words to fold
+ **/
+
+static void curve25519Fold(uint32_t *r, const uint32_t *u, uint_t n)
+{
+   uint_t i;
+   uint32_t c;
+   uint64_t temp;
+
+   //Compute lo + 38 * hi
+   for(c = 0, i = 0; i < 8; i++)
+   {
+      temp = (uint64_t) u[i] + c;
+      if(i < n) temp += (uint64_t) u[i + 8] * 38;
+      r[i] = (uint32_t) temp;
+      c = temp >> 32;
+   }
+
+   //Fold the remaining carry
+   for(c *= 38, i = 0; i < 8; i++)
+   {
+      temp = (uint64_t) r[i] + c;
+      r[i] = (uint32_t) temp;
+      c = temp >> 32;
+   }
+
+   //A second carry leaves a small value in the first word
+   r[0] += c * 38;
+}
+
+
+/**
+ * @brief Modular multiplication
+ * @param[out] r Resulting value r = (a * b) mod p
+ * @param[in] a First operand
+ * @param[in] b Second operand
+ **/
+
+static void curve25519Mul32(uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+   uint_t i;
+   uint_t j;
+   uint32_t c;
+   uint32_t u[16];
+   uint64_t temp;
+
+   //Clear the product
+   memset(u, 0, sizeof(u));
+
+   //Schoolbook multiplication
+   for(i = 0; i < 8; i++)
+   {
+      for(c = 0, j = 0; j < 8; j++)
+      {
+         temp = (uint64_t) a[i] * b[j] + u[i + j] + c;
+         u[i + j] = (uint32_t) temp;
+         c = temp >> 32;
+      }
+
+      u[i + 8] = c;
+   }
+
+   //Reduce the 512-bit product
+   curve25519Fold(r, u, 8);
+}
+
+
+/**
+ * @brief Multiplication by a small constant
+ * @param[out] r Resulting value r = (a * b) mod p
+ * @param[in] a First operand
+ * @param[in] b Second operand (less than 2^24)
+ **/
+
+static void curve25519MulInt(uint32_t *r, const uint32_t *a, uint32_t b)
+{
+   uint_t i;
+   uint32_t c;
+   uint32_t u[9];
+   uint64_t temp;
+
+   //Compute a * b
+   for(c = 0, i = 0; i < 8; i++)
+   {
+      temp = (uint64_t) a[i] * b + c;
+      u[i] = (uint32_t) temp;
+      c = temp >> 32;
+   }
+
+   u[8] = c;
+
+   //Reduce the 288-bit product
+   curve25519Fold(r, u, 1);
+}
+
+
+/**
+ * @brief Repeated squaring
+ * @param[out] r Resulting value r = a^(2^n) mod p
+ * @param[in] a Field element
+ * @param[in] n Number of squarings
+ **/
+
+static void curve25519Pow2(uint32_t *r, const uint32_t *a, uint_t n)
+{
+   //First squaring
+   curve25519Mul32(r, a, a);
+
+   //Remaining squarings
+   while(--n > 0)
+      curve25519Mul32(r, r, r);
+}
+
+
+/**
+ * @brief Modular inversion
+ *
+ * Compute a^(p - 2) = a^(2^255 - 21) using a fixed addition chain
+ * (254 squarings and 11 multiplications)
+ *
+ * @param[out] r Resulting value r = a^-1 mod p
+ * @param[in] a Field element to invert
+ **/
+
+static void curve25519Inv(uint32_t *r, const uint32_t *a)
+{
+   uint32_t a2[8];
+   uint32_t a9[8];
+   uint32_t a11[8];
+   uint32_t b5[8];
+   uint32_t b10[8];
+   uint32_t b20[8];
+   uint32_t b50[8];
+   uint32_t b100[8];
+   uint32_t t[8];
+
+   //Compute a^2, a^9 and a^11
+   curve25519Mul32(a2, a, a);
+   curve25519Pow2(t, a2, 2);
+   curve25519Mul32(a9, t, a);
+   curve25519Mul32(a11, a9, a2);
+
+   //Compute a^(2^5 - 1)
+   curve25519Mul32(t, a11, a11);
+   curve25519Mul32(b5, t, a9);
+   //Compute a^(2^10 - 1)
+   curve25519Pow2(t, b5, 5);
+   curve25519Mul32(b10, t, b5);
+   //Compute a^(2^20 - 1)
+   curve25519Pow2(t, b10, 10);
+   curve25519Mul32(b20, t, b10);
+   //Compute a^(2^40 - 1)
+   curve25519Pow2(t, b20, 20);
+   curve25519Mul32(t, t, b20);
+   //Compute a^(2^50 - 1)
+   curve25519Pow2(t, t, 10);
+   curve25519Mul32(b50, t, b10);
+   //Compute a^(2^100 - 1)
+   curve25519Pow2(t, b50, 50);
+   curve25519Mul32(b100, t, b50);
+   //Compute a^(2^200 - 1)
+   curve25519Pow2(t, b100, 100);
+   curve25519Mul32(t, t, b100);
+   //Compute a^(2^250 - 1)
+   curve25519Pow2(t, t, 50);
+   curve25519Mul32(t, t, b50);
+   //Compute a^(2^255 - 21)
+   curve25519Pow2(t, t, 5);
+   curve25519Mul32(r, t, a11);
+}
+
+
+/**
+ * @brief Constant-time conditional swap
+ * @param[in,out] a First field element
+ * @param[in,out] b Second field element
+ * @param[in] c Swap the values if c is set to 1
+ **/
+
+static void curve25519Swap(uint32_t *a, uint32_t *b, uint32_t c)
+{
+   uint_t i;
+   uint32_t t;
+   uint32_t mask;
+
+   //Build mask
+   mask = 0 - c;
+
+   //Conditional swap
+   for(i = 0; i < 8; i++)
+   {
+      t = (a[i] ^ b[i]) & mask;
+      a[i] ^= t;
+      b[i] ^= t;
+   }
+}
+
+
+/**
+ * @brief Final reduction and encoding of a field element
+ * @param[out] data Octet string (little-endian, 32 bytes)
+ * @param[in] a Field element (less than 2^256)
+ **/
+
+static void curve25519Export(uint8_t *data, const uint32_t *a)
+{
+   uint_t i;
+   uint_t n;
+   uint32_t b;
+   uint32_t mask;
+   uint32_t r[8];
+   uint32_t t[8];
+   uint64_t temp;
+
+   //Copy the value
+   memcpy(r, a, sizeof(r));
+
+   //Values below 2^256 may require two subtractions of p
+   for(n = 0; n < 2; n++)
+   {
+      //Compute t = r - p
+      for(b = 0, i = 0; i < 8; i++)
+      {
+         temp = (uint64_t) r[i] - b;
+         if(i == 0) temp -= 0xFFFFFFED;
+         else if(i == 7) temp -= 0x7FFFFFFF;
+         else temp -= 0xFFFFFFFF;
+
+         t[i] = (uint32_t) temp;
+         b = (temp >> 32) & 1;
+      }
+
+      //Select t if r >= p
+      mask = b - 1;
+
+      for(i = 0; i < 8; i++)
+         r[i] = (t[i] & mask) | (r[i] & ~mask);
+   }
+
+   //Little-endian encoding
+   for(i = 0; i < 8; i++)
+      STORE32LE(r[i], data + 4 * i);
+}
+
+
+/**
+ * @brief Check whether a u-coordinate is valid
+ * @param[in] p Encoded u-coordinate
+ * @param[in] length Length of the encoded u-coordinate
+ * @return Error code
+ **/
+
+error_t curve25519CheckPoint(const uint8_t *p, size_t length)
+{
+   //All 32-byte strings are valid u-coordinates. Low-order points are
+   //detected afterwards by checking the shared secret against zero
+   if(length != CURVE25519_POINT_SIZE)
+      return ERROR_INVALID_PARAMETER;
+
+   //The u-coordinate is acceptable
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief X25519 function (base point u = 9)
+ * @param[out] r Resulting u-coordinate
+ * @param[in] d Scalar (little-endian, 32 bytes)
+ * @return Error code
+ **/
+
+error_t curve25519MulBase(uint8_t *r, const uint8_t *d)
+{
+   static const uint8_t g[32] = {9};
+
+   //Compute d * G
+   return curve25519Mul(r, d, g);
+}
+
+
+/**
+ * @brief X25519 function (Montgomery ladder)
+ * @param[out] r Resulting u-coordinate
+ * @param[in] d Scalar (little-endian, 32 bytes)
+ * @param[in] p Input u-coordinate
+ * @return Error code
+ **/
+
+error_t curve25519Mul(uint8_t *r, const uint8_t *d, const uint8_t *p)
+{
+   int_t i;
+   uint32_t b;
+   uint32_t swap;
+   uint8_t k[32];
+   uint32_t u[8];
+   uint32_t x2[8];
+   uint32_t z2[8];
+   uint32_t x3[8];
+   uint32_t z3[8];
+   uint32_t t0[8];
+   uint32_t t1[8];
+   uint32_t t2[8];
+   uint32_t t3[8];
+
+   //Decode the scalar (clear the three least significant bits,
+   //clear the most significant bit and set the second most significant bit)
+   memcpy(k, d, 32);
+   k[0] &= 0xF8;
+   k[31] &= 0x7F;
+   k[31] |= 0x40;
+
+   //Decode the u-coordinate (the most significant bit is masked)
+   for(i = 0; i < 8; i++)
+      u[i] = LOAD32LE(p + 4 * i);
+   u[7] &= 0x7FFFFFFF;
+
+   //Initialize the ladder
+   memset(x2, 0, sizeof(x2));
+   memset(z2, 0, sizeof(z2));
+   memset(z3, 0, sizeof(z3));
+   memcpy(x3, u, sizeof(x3));
+   x2[0] = 1;
+   z3[0] = 1;
+   swap = 0;
+
+   //Montgomery ladder
+   for(i = 254; i >= 0; i--)
+   {
+      //Current bit of the scalar
+      b = (k[i / 8] >> (i % 8)) & 1;
+
+      //Conditional swap
+      swap ^= b;
+      curve25519Swap(x2, x3, swap);
+      curve25519Swap(z2, z3, swap);
+      swap = b;
+
+      //A = x2 + z2, B = x2 - z2
+      curve25519Add(t0, x2, z2);
+      curve25519Sub(t1, x2, z2);
+      //C = x3 + z3, D = x3 - z3
+      curve25519Add(t2, x3, z3);
+      curve25519Sub(t3, x3, z3);
+      //DA = D * A, CB = C * B
+      curve25519Mul32(t3, t3, t0);
+      curve25519Mul32(t2, t2, t1);
+      //AA = A^2, BB = B^2
+      curve25519Mul32(t0, t0, t0);
+      curve25519Mul32(t1, t1, t1);
+
+      //x3 = (DA + CB)^2
+      curve25519Add(x3, t3, t2);
+      curve25519Mul32(x3, x3, x3);
+      //z3 = u * (DA - CB)^2
+      curve25519Sub(z3, t3, t2);
+      curve25519Mul32(z3, z3, z3);
+      curve25519Mul32(z3, z3, u);
+
+      //x2 = AA * BB
+      curve25519Mul32(x2, t0, t1);
+      //E = AA - BB
+      curve25519Sub(t1, t0, t1);
+      //z2 = E * (AA + a24 * E)
+      curve25519MulInt(t2, t1, 121665);
+      curve25519Add(t2, t2, t0);
+      curve25519Mul32(z2, t1, t2);
+   }
+
+   //Final conditional swap
+   curve25519Swap(x2, x3, swap);
+   curve25519Swap(z2, z3, swap);
+
+   //Compute x2 / z2
+   curve25519Inv(z2, z2);
+   curve25519Mul32(x2, x2, z2);
+
+   //Encode the resulting u-coordinate
+   curve25519Export(r, x2);
+
+   //Clear intermediate values
+   memset(k, 0, sizeof(k));
+   memset(x2, 0, sizeof(x2));
+   memset(z2, 0, sizeof(z2));
+   memset(x3, 0, sizeof(x3));
+   memset(z3, 0, sizeof(z3));
+
+   //Successful processing
+   return NO_ERROR;
+}
@@ -0,0 +1,52 @@
+/**
+ * @file curve25519.h
+ * @brief Curve25519 elliptic curve (X25519 key agreement)
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneCrypto Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+#ifndef _CURVE25519_H
+#define _CURVE25519_H
+
+//Dependencies
+#include "crypto.h"
+#include "ec.h"
+
+//Size of a field element (in bytes)
+#define CURVE25519_FIELD_SIZE 32
+//Size of an encoded point (u-coordinate)
+#define CURVE25519_POINT_SIZE 32
+//Common interface for elliptic curves
+#define CURVE25519_CURVE (&curve25519Curve)
+
+//Curve25519 related constants
+extern const uint8_t X25519_OID[3];
+extern const EcCurveInfo curve25519Curve;
+
+//Curve25519 related functions
+error_t curve25519CheckPoint(const uint8_t *p, size_t length);
+error_t curve25519MulBase(uint8_t *r, const uint8_t *d);
+error_t curve25519Mul(uint8_t *r, const uint8_t *d, const uint8_t *p);
+
+#endif
@@ -54,7 +54,9 @@ const CipherAlgo des3CipherAlgo =
    NULL,
    NULL,
    (CipherAlgoEncryptBlock) des3EncryptBlock,
-   (CipherAlgoDecryptBlock) des3DecryptBlock
+   (CipherAlgoDecryptBlock) des3DecryptBlock,
+   NULL,
+   NULL
 };
 
 
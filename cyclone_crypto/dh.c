@@ -37,10 +37,22 @@
 
 //Dependencies
 #include <stdlib.h>
+#include <string.h>
 #include "crypto.h"
 #include "dh.h"
 #include "debug.h"
 
+//Forward declaration of functions
+static uint_t dhGetPrivateValueSize(uint_t k);
+
+static error_t dhGenerateShortPrivateValue(Mpi *xa, uint_t n,
+   const PrngAlgo *prngAlgo, void *prngContext);
+
+static error_t dhExpMod(DhParameters *params, Mpi *x, const Mpi *a, const Mpi *e);
+
+static error_t dhGroupComputeKeyPair(DhGroup *group, Mpi *xa, Mpi *ya,
+   const PrngAlgo *prngAlgo, void *prngContext);
+
 
 /**
  * @brief Initialize Diffie-Hellman parameters
@@ -55,6 +67,9 @@ void dhInitParameters(DhParameters *params)
    mpiInit(&params->xa);
    mpiInit(&params->ya);
    mpiInit(&params->yb);
+
+   //No shared group
+   params->group = NULL;
 }
 
 
@@ -71,6 +86,388 @@ void dhFreeParameters(DhParameters *params)
    mpiFree(&params->xa);
    mpiFree(&params->ya);
    mpiFree(&params->yb);
+
+   //The shared group is not owned by the parameters
+   params->group = NULL;
+}
+
+
+/**
+ * @brief Initialize a Diffie-Hellman group
+ * @param[out] group Pointer to the Diffie-Hellman group
+ * @param[in] p Prime modulus
+ * @param[in] g Generator
+ * @param[in] prngAlgo PRNG used by the key pair generator (optional)
+ * @param[in] prngContext Pointer to the PRNG context
+ * @return Error code
+ **/
+
+error_t dhGroupInit(DhGroup *group, const Mpi *p, const Mpi *g,
+   const PrngAlgo *prngAlgo, void *prngContext)
+{
+   error_t error;
+   uint_t i;
+
+   //Check parameters
+   if(group == NULL || p == NULL || g == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Clear the Diffie-Hellman group
+   memset(group, 0, sizeof(DhGroup));
+
+   //Initialize multiple precision integers
+   mpiInit(&group->p);
+   mpiInit(&group->g);
+
+   for(i = 0; i < DH_GROUP_POOL_SIZE; i++)
+   {
+      mpiInit(&group->poolXa[i]);
+      mpiInit(&group->poolYa[i]);
+   }
+
+   //Save the PRNG used by the key pair generator
+   group->prngAlgo = prngAlgo;
+   group->prngContext = prngContext;
+
+   //Save the group parameters
+   MPI_CHECK(mpiCopy(&group->p, p));
+   MPI_CHECK(mpiCopy(&group->g, g));
+
+   //Private values are sized according to the security strength of the group
+   group->privateValueSize = dhGetPrivateValueSize(mpiGetBitLength(p));
+
+   //Precompute the Montgomery parameters
+   MPI_CHECK(mpiMontgomeryInit(&group->montContext, p));
+   //Precompute the comb table of the generator
+   MPI_CHECK(mpiCombInit(&group->montContext, &group->combTable,
+      g, group->privateValueSize));
+
+   //Create a mutex to protect the pool
+   group->mutex = osMutexCreate(FALSE);
+   //Out of resources?
+   if(group->mutex == OS_INVALID_HANDLE)
+      MPI_CHECK(ERROR_OUT_OF_RESOURCES);
+
+   //Create the events used to communicate with the key pair generator
+   group->event = osEventCreate(FALSE, FALSE);
+   group->ackEvent = osEventCreate(FALSE, FALSE);
+
+   //Out of resources?
+   if(group->event == OS_INVALID_HANDLE || group->ackEvent == OS_INVALID_HANDLE)
+      MPI_CHECK(ERROR_OUT_OF_RESOURCES);
+
+end:
+   //Any error to report?
+   if(error)
+      dhGroupFree(group);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Release a Diffie-Hellman group
+ *
+ * The key pair generator must have been stopped beforehand
+ *
+ * @param[in] group Pointer to the Diffie-Hellman group
+ **/
+
+void dhGroupFree(DhGroup *group)
+{
+   uint_t i;
+
+   //Invalid group?
+   if(group == NULL)
+      return;
+
+   //Release precomputed data
+   mpiCombFree(&group->combTable);
+   mpiMontgomeryFree(&group->montContext);
+
+   //Release multiple precision integers
+   mpiFree(&group->p);
+   mpiFree(&group->g);
+
+   //Release precomputed key pairs
+   for(i = 0; i < DH_GROUP_POOL_SIZE; i++)
+   {
+      mpiFree(&group->poolXa[i]);
+      mpiFree(&group->poolYa[i]);
+   }
+
+   //Close mutex and event objects
+   if(group->mutex != OS_INVALID_HANDLE)
+      osMutexClose(group->mutex);
+   if(group->event != OS_INVALID_HANDLE)
+      osEventClose(group->event);
+   if(group->ackEvent != OS_INVALID_HANDLE)
+      osEventClose(group->ackEvent);
+
+   //Clear the Diffie-Hellman group
+   memset(group, 0, sizeof(DhGroup));
+}
+
+
+/**
+ * @brief Start the key pair generator
+ *
+ * The generator keeps the pool of precomputed key pairs full, so that
+ * ephemeral key pairs are available without any exponentiation when a
+ * key exchange starts
+ *
+ * @param[in] group Pointer to the Diffie-Hellman group
+ * @return Error code
+ **/
+
+error_t dhGroupStart(DhGroup *group)
+{
+   OsTask *task;
+
+   //Ensure the specified pointer is valid
+   if(group == NULL)
+      return ERROR_INVALID_PARAMETER;
+   //The generator requires a PRNG
+   if(group->prngAlgo == NULL)
+      return ERROR_INVALID_PARAMETER;
+   //Check the state of the generator
+   if(group->running)
+      return ERROR_WRONG_STATE;
+
+   //Debug message
+   TRACE_INFO("Starting Diffie-Hellman key pair generator...\r\n");
+
+   //The generator is about to run
+   group->running = TRUE;
+   group->stopRequest = FALSE;
+
+   //Create the generator task
+   task = osTaskCreate("DH Key Pair Generator", dhGroupTask,
+      group, DH_GROUP_STACK_SIZE, DH_GROUP_PRIORITY);
+
+   //Unable to create the task?
+   if(task == OS_INVALID_HANDLE)
+   {
+      //Key pairs will be generated on demand
+      group->running = FALSE;
+      //Report an error
+      return ERROR_OUT_OF_RESOURCES;
+   }
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Stop the key pair generator
+ * @param[in] group Pointer to the Diffie-Hellman group
+ * @return Error code
+ **/
+
+error_t dhGroupStop(DhGroup *group)
+{
+   //Ensure the specified pointer is valid
+   if(group == NULL)
+      return ERROR_INVALID_PARAMETER;
+   //Check the state of the generator
+   if(!group->running)
+      return ERROR_WRONG_STATE;
+
+   //Debug message
+   TRACE_INFO("Stopping Diffie-Hellman key pair generator...\r\n");
+
+   //Reset ACK event before sending the kill signal
+   osEventReset(group->ackEvent);
+
+   //Stop the generator task
+   osMutexAcquire(group->mutex);
+   group->stopRequest = TRUE;
+   osMutexRelease(group->mutex);
+
+   //Wake up the generator
+   osEventSet(group->event);
+   //Wait for the generator to terminate...
+   osEventWait(group->ackEvent, INFINITE_DELAY);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Get an ephemeral key pair from a Diffie-Hellman group
+ *
+ * A precomputed key pair is taken from the pool when available. Otherwise
+ * the key pair is generated using the comb table of the generator
+ *
+ * @param[in] group Pointer to the Diffie-Hellman group
+ * @param[out] params Diffie-Hellman parameters (p, g, xa and ya are updated)
+ * @param[in] prngAlgo PRNG algorithm
+ * @param[in] prngContext Pointer to the PRNG context
+ * @return Error code
+ **/
+
+error_t dhGroupGenerateKeyPair(DhGroup *group, DhParameters *params,
+   const PrngAlgo *prngAlgo, void *prngContext)
+{
+   error_t error;
+   bool_t found;
+
+   //Check parameters
+   if(group == NULL || params == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Debug message
+   TRACE_DEBUG("Generating Diffie-Hellman public value...\r\n");
+
+   //The parameters refer to the shared group
+   params->group = group;
+
+   //Copy the group parameters
+   MPI_CHECK(mpiCopy(&params->p, &group->p));
+   MPI_CHECK(mpiCopy(&params->g, &group->g));
+
+   //Initialize flag
+   found = FALSE;
+
+   //Acquire exclusive access to the pool
+   osMutexAcquire(group->mutex);
+
+   //Any precomputed key pair available?
+   if(group->poolCount > 0)
+   {
+      //Take the most recent key pair
+      group->poolCount--;
+
+      //Copy the key pair
+      error = mpiCopy(&params->xa, &group->poolXa[group->poolCount]);
+      if(!error)
+         error = mpiCopy(&params->ya, &group->poolYa[group->poolCount]);
+
+      //Each key pair is used only once
+      mpiFree(&group->poolXa[group->poolCount]);
+      mpiFree(&group->poolYa[group->poolCount]);
+
+      //Successful copy?
+      found = !error;
+   }
+
+   //Release exclusive access to the pool
+   osMutexRelease(group->mutex);
+
+   //Refill the pool
+   if(group->running)
+      osEventSet(group->event);
+
+   //Generate the key pair on demand if necessary
+   if(!found)
+   {
+      MPI_CHECK(dhGroupComputeKeyPair(group, &params->xa, &params->ya,
+         prngAlgo, prngContext));
+   }
+
+   //Debug message
+   TRACE_DEBUG("  Public value:\r\n");
+   TRACE_DEBUG_MPI("    ", &params->ya);
+
+end:
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Key pair generator
+ * @param[in] param Pointer to the Diffie-Hellman group
+ **/
+
+void dhGroupTask(void *param)
+{
+   error_t error;
+   bool_t full;
+   Mpi xa;
+   Mpi ya;
+
+   //Point to the Diffie-Hellman group
+   DhGroup *group = (DhGroup *) param;
+
+   //Initialize multiple precision integers
+   mpiInit(&xa);
+   mpiInit(&ya);
+
+   //Main loop
+   while(1)
+   {
+      //Acquire exclusive access to the pool
+      osMutexAcquire(group->mutex);
+
+      //Stop request?
+      if(group->stopRequest)
+      {
+         //The generator is about to stop
+         group->stopRequest = FALSE;
+         group->running = FALSE;
+
+         //Release exclusive access to the pool
+         osMutexRelease(group->mutex);
+
+         //Release multiple precision integers
+         mpiFree(&xa);
+         mpiFree(&ya);
+
+         //Acknowledge the reception of the user request
+         osEventSet(group->ackEvent);
+         //Kill ourselves
+         osTaskDelete(NULL);
+      }
+
+      //Check whether the pool is full
+      full = (group->poolCount >= DH_GROUP_POOL_SIZE);
+
+      //Release exclusive access to the pool
+      osMutexRelease(group->mutex);
+
+      //Nothing to do?
+      if(full)
+      {
+         //Wait for a key pair to be consumed
+         osEventWait(group->event, INFINITE_DELAY);
+         continue;
+      }
+
+      //Generate a new key pair outside of the critical section
+      error = dhGroupComputeKeyPair(group, &xa, &ya,
+         group->prngAlgo, group->prngContext);
+
+      //Key pair generation failed?
+      if(error)
+      {
+         //Wait for the next request before retrying
+         osEventWait(group->event, INFINITE_DELAY);
+         continue;
+      }
+
+      //Acquire exclusive access to the pool
+      osMutexAcquire(group->mutex);
+
+      //Add the key pair to the pool
+      if(group->poolCount < DH_GROUP_POOL_SIZE)
+      {
+         //The pool takes ownership of the integers
+         group->poolXa[group->poolCount] = xa;
+         group->poolYa[group->poolCount] = ya;
+         group->poolCount++;
+
+         //Reinitialize the working integers
+         mpiInit(&xa);
+         mpiInit(&ya);
+      }
+
+      //Release exclusive access to the pool
+      osMutexRelease(group->mutex);
+   }
 }
 
 
@@ -86,6 +483,11 @@ error_t dhGenerateKeyPair(DhParameters *params, const PrngAlgo *prngAlgo, void *
 {
    error_t error;
    uint_t k;
+   uint_t n;
+
+   //Shared group?
+   if(params->group != NULL)
+      return dhGroupGenerateKeyPair(params->group, params, prngAlgo, prngContext);
 
    //Debug message
    TRACE_DEBUG("Generating Diffie-Hellman public value...\r\n");
@@ -95,26 +497,40 @@ error_t dhGenerateKeyPair(DhParameters *params, const PrngAlgo *prngAlgo, void *
    //Ensure the length is valid
    if(!k) return ERROR_INVALID_PARAMETER;
 
-   //The private value shall be randomly generated
-   error = mpiRand(&params->xa, k, prngAlgo, prngContext);
-   //Any error to report?
-   if(error) return error;
+   //Length of the private value
+   n = dhGetPrivateValueSize(k);
 
-   //The private value shall be less than p
-   if(mpiComp(&params->xa, &params->p) >= 0)
+   //Short private value?
+   if(n < k)
    {
-      //Shift value to the right
-      error = mpiShiftRight(&params->xa, 1);
+      //The private value shall be randomly generated
+      error = dhGenerateShortPrivateValue(&params->xa, n, prngAlgo, prngContext);
       //Any error to report?
       if(error) return error;
    }
+   else
+   {
+      //The private value shall be randomly generated
+      error = mpiRand(&params->xa, k, prngAlgo, prngContext);
+      //Any error to report?
+      if(error) return error;
+
+      //The private value shall be less than p
+      if(mpiComp(&params->xa, &params->p) >= 0)
+      {
+         //Shift value to the right
+         error = mpiShiftRight(&params->xa, 1);
+         //Any error to report?
+         if(error) return error;
+      }
+   }
 
    //Debug message
    TRACE_DEBUG("  Private value:\r\n");
    TRACE_DEBUG_MPI("    ", &params->xa);
 
    //Calculate the corresponding public value (ya = g ^ xa mod p)
-   error = mpiExpMod(&params->ya, &params->g, &params->xa, &params->p);
+   error = dhExpMod(params, &params->ya, &params->g, &params->xa);
    //Any error to report?
    if(error) return error;
 
@@ -199,7 +615,7 @@ error_t dhComputeSharedSecret(DhParameters *params,
    do
    {
       //Calculate the shared secret key (k = yb ^ xa mod p)
-      error = mpiExpMod(&z, &params->yb, &params->xa, &params->p);
+      error = dhExpMod(params, &z, &params->yb, &params->xa);
       //Any error to report?
       if(error) return error;
 
@@ -223,3 +639,161 @@ error_t dhComputeSharedSecret(DhParameters *params,
    //Return status code
    return error;
 }
+
+
+/**
+ * @brief Length of the private values for a given prime modulus
+ *
+ * The private value is twice as long as the security strength of the
+ * group (refer to NIST SP 800-57, table 2)
+ *
+ * @param[in] k Length of the prime modulus, in bits
+ * @return Length of the private values, in bits
+ **/
+
+static uint_t dhGetPrivateValueSize(uint_t k)
+{
+   uint_t n;
+
+   //Estimate the security strength of the group
+   if(k >= 15360)
+      n = 256;
+   else if(k >= 7680)
+      n = 192;
+   else if(k >= 3072)
+      n = 128;
+   else if(k >= 2048)
+      n = 112;
+   else
+      n = 80;
+
+   //Short private values are not used with small moduli
+   return min(2 * n, k);
+}
+
+
+/**
+ * @brief Generate a short private value
+ *
+ * The most significant bit is always set, so that all the private values
+ * have the same length
+ *
+ * @param[out] xa Resulting private value
+ * @param[in] n Length of the private value, in bits
+ * @param[in] prngAlgo PRNG algorithm
+ * @param[in] prngContext Pointer to the PRNG context
+ * @return Error code
+ **/
+
+static error_t dhGenerateShortPrivateValue(Mpi *xa, uint_t n,
+   const PrngAlgo *prngAlgo, void *prngContext)
+{
+   error_t error;
+
+   //Generate a random value
+   error = mpiRand(xa, n, prngAlgo, prngContext);
+   //Any error to report?
+   if(error) return error;
+
+   //Set the most significant bit
+   return mpiSetBitValue(xa, n - 1, 1);
+}
+
+
+/**
+ * @brief Constant-time modular exponentiation with a private value
+ *
+ * The running time only depends on the length of the private values,
+ * which is public. The Montgomery parameters of the shared group are
+ * reused when available
+ *
+ * @param[in] params Pointer to the Diffie-Hellman parameters
+ * @param[out] x Resulting integer X = A ^ E mod p
+ * @param[in] a Base A
+ * @param[in] e Private value E
+ * @return Error code
+ **/
+
+static error_t dhExpMod(DhParameters *params, Mpi *x, const Mpi *a, const Mpi *e)
+{
+   error_t error;
+   uint_t n;
+   MpiMontgomeryContext context;
+
+   //Number of exponent bits to process
+   n = dhGetPrivateValueSize(mpiGetBitLength(&params->p));
+   n = max(n, mpiGetBitLength(e));
+
+   //Shared group?
+   if(params->group != NULL)
+   {
+      //Reuse the Montgomery parameters of the group
+      return mpiMontgomeryExpModLength(&params->group->montContext, x, a, e, n);
+   }
+
+   //Precompute the Montgomery parameters
+   error = mpiMontgomeryInit(&context, &params->p);
+   //Any error to report?
+   if(error) return error;
+
+   //Perform modular exponentiation
+   error = mpiMontgomeryExpModLength(&context, x, a, e, n);
+
+   //Release Montgomery context
+   mpiMontgomeryFree(&context);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Compute an ephemeral key pair using the comb table of a group
+ * @param[in] group Pointer to the Diffie-Hellman group
+ * @param[out] xa Private value
+ * @param[out] ya Public value
+ * @param[in] prngAlgo PRNG algorithm
+ * @param[in] prngContext Pointer to the PRNG context
+ * @return Error code
+ **/
+
+static error_t dhGroupComputeKeyPair(DhGroup *group, Mpi *xa, Mpi *ya,
+   const PrngAlgo *prngAlgo, void *prngContext)
+{
+   error_t error;
+
+   //The PRNG of the group is used by default
+   if(prngAlgo == NULL)
+   {
+      prngAlgo = group->prngAlgo;
+      prngContext = group->prngContext;
+   }
+
+   //Make sure a PRNG is available
+   if(prngAlgo == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Generate a private value of the appropriate length
+   error = dhGenerateShortPrivateValue(xa, group->privateValueSize,
+      prngAlgo, prngContext);
+   //Any error to report?
+   if(error) return error;
+
+   //The private value shall be less than p
+   if(mpiComp(xa, &group->p) >= 0)
+   {
+      //Shift value to the right
+      error = mpiShiftRight(xa, 1);
+      //Any error to report?
+      if(error) return error;
+   }
+
+   //Calculate the corresponding public value (ya = g ^ xa mod p)
+   error = mpiMontgomeryCombExpMod(&group->montContext,
+      &group->combTable, ya, xa);
+   //Any error to report?
+   if(error) return error;
+
+   //Check public value
+   return dhCheckPublicKey(ya, &group->p);
+}
@@ -33,6 +33,57 @@
 #include "crypto.h"
 #include "mpi.h"
 
+//Number of precomputed key pairs held by a Diffie-Hellman group
+#ifndef DH_GROUP_POOL_SIZE
+   #define DH_GROUP_POOL_SIZE 4
+#elif (DH_GROUP_POOL_SIZE < 1)
+   #error DH_GROUP_POOL_SIZE parameter is invalid
+#endif
+
+//Stack size required to run the key pair generator
+#ifndef DH_GROUP_STACK_SIZE
+   #define DH_GROUP_STACK_SIZE 650
+#elif (DH_GROUP_STACK_SIZE < 1)
+   #error DH_GROUP_STACK_SIZE parameter is invalid
+#endif
+
+//Priority at which the key pair generator should run
+#ifndef DH_GROUP_PRIORITY
+   #define DH_GROUP_PRIORITY 0
+#elif (DH_GROUP_PRIORITY < 0)
+   #error DH_GROUP_PRIORITY parameter is invalid
+#endif
+
+
+/**
+ * @brief Diffie-Hellman group
+ *
+ * Immutable data that depend only on the group (Montgomery parameters
+ * and comb table of the generator) are computed once and shared by all
+ * the key exchanges. The group may also hold a pool of ephemeral key
+ * pairs that are generated in the background
+ *
+ **/
+
+typedef struct
+{
+   Mpi p;                                ///<Prime modulus
+   Mpi g;                                ///<Generator
+   uint_t privateValueSize;              ///<Length of the private values, in bits
+   MpiMontgomeryContext montContext;     ///<Montgomery context for the prime modulus
+   MpiCombTable combTable;               ///<Comb table for the generator
+   const PrngAlgo *prngAlgo;             ///<PRNG used by the key pair generator
+   void *prngContext;                    ///<PRNG context
+   Mpi poolXa[DH_GROUP_POOL_SIZE];       ///<Precomputed private values
+   Mpi poolYa[DH_GROUP_POOL_SIZE];       ///<Precomputed public values
+   uint_t poolCount;                     ///<Number of precomputed key pairs
+   OsMutex *mutex;                       ///<Mutex preventing simultaneous access to the pool
+   OsEvent *event;                       ///<Event used to wake up the key pair generator
+   OsEvent *ackEvent;                    ///<Event used to acknowledge a stop request
+   bool_t running;                       ///<The key pair generator is currently running
+   bool_t stopRequest;                   ///<Stop request
+} DhGroup;
+
 
 /**
  * @brief Diffie-Hellman parameters
@@ -40,11 +91,12 @@
 
 typedef struct
 {
-   Mpi p;  ///<Prime modulus
-   Mpi g;  ///<Generator
-   Mpi xa; ///<Out private value
-   Mpi ya; ///<Our public value
-   Mpi yb; ///<Peer's public value
+   Mpi p;          ///<Prime modulus
+   Mpi g;          ///<Generator
+   Mpi xa;         ///<Out private value
+   Mpi ya;         ///<Our public value
+   Mpi yb;         ///<Peer's public value
+   DhGroup *group; ///<Shared group (optional)
 } DhParameters;
 
 
@@ -52,6 +104,19 @@ typedef struct
 void dhInitParameters(DhParameters *params);
 void dhFreeParameters(DhParameters *params);
 
+error_t dhGroupInit(DhGroup *group, const Mpi *p, const Mpi *g,
+   const PrngAlgo *prngAlgo, void *prngContext);
+
+void dhGroupFree(DhGroup *group);
+
+error_t dhGroupStart(DhGroup *group);
+error_t dhGroupStop(DhGroup *group);
+
+error_t dhGroupGenerateKeyPair(DhGroup *group, DhParameters *params,
+   const PrngAlgo *prngAlgo, void *prngContext);
+
+void dhGroupTask(void *param);
+
 error_t dhGenerateKeyPair(DhParameters *params, const PrngAlgo *prngAlgo, void *prngContext);
 
 error_t dhCheckPublicKey(const Mpi *publicKey, const Mpi *p);
@@ -347,7 +347,7 @@ error_t dsaGenerateSignature(const PrngAlgo *prngAlgo, void *prngContext, const
    TRACE_DEBUG_MPI("    ", &z);
 
    //Compute r = (g ^ k mod p) mod q
-   MPI_CHECK(mpiExpMod(&signature->r, &key->g, &k, &key->p));
+   MPI_CHECK(mpiExpModRegular(&signature->r, &key->g, &k, &key->p));
    MPI_CHECK(mpiMod(&signature->r, &signature->r, &key->q));
 
    //Compute k ^ -1 mod q
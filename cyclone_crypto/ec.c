@@ -0,0 +1,268 @@
+/**
+ * @file ec.c
+ * @brief Elliptic curve cryptography
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneCrypto Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * This module provides the curve-independent layer (key containers, scalar
+ * generation and curve lookup). Curve arithmetic is implemented in separate
+ * modules sharing a common interface (see EcCurveInfo)
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL CRYPTO_TRACE_LEVEL
+
+//Dependencies
+#include <string.h>
+#include "crypto.h"
+#include "ec.h"
+#include "p256.h"
+#include "curve25519.h"
+#include "debug.h"
+
+//EC public key OID (1.2.840.10045.2.1)
+const uint8_t EC_PUBLIC_KEY_OID[7] = {0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x02, 0x01};
+
+//List of supported elliptic curves
+static const EcCurveInfo *ecCurveList[] =
+{
+   SECP256R1_CURVE,
+   CURVE25519_CURVE
+};
+
+
+/**
+ * @brief Initialize an EC public key
+ * @param[in] key Pointer to the EC public key to initialize
+ **/
+
+void ecInitPublicKey(EcPublicKey *key)
+{
+   //Clear the key
+   memset(key, 0, sizeof(EcPublicKey));
+}
+
+
+/**
+ * @brief Release an EC public key
+ * @param[in] key Pointer to the EC public key to free
+ **/
+
+void ecFreePublicKey(EcPublicKey *key)
+{
+   //Clear the key
+   memset(key, 0, sizeof(EcPublicKey));
+}
+
+
+/**
+ * @brief Initialize an EC private key
+ * @param[in] key Pointer to the EC private key to initialize
+ **/
+
+void ecInitPrivateKey(EcPrivateKey *key)
+{
+   //Clear the key
+   memset(key, 0, sizeof(EcPrivateKey));
+}
+
+
+/**
+ * @brief Release an EC private key
+ * @param[in] key Pointer to the EC private key to free
+ **/
+
+void ecFreePrivateKey(EcPrivateKey *key)
+{
+   //Wipe the private scalar
+   memset(key, 0, sizeof(EcPrivateKey));
+}
+
+
+/**
+ * @brief Load an EC public key
+ * @param[out] key EC public key
+ * @param[in] curve Elliptic curve parameters
+ * @param[in] data Encoded public point
+ * @param[in] length Length of the encoded point
+ * @return Error code
+ **/
+
+error_t ecImportPublicKey(EcPublicKey *key, const EcCurveInfo *curve,
+   const uint8_t *data, size_t length)
+{
+   error_t error;
+
+   //Check parameters
+   if(key == NULL || curve == NULL || data == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Make sure the point lies on the curve
+   error = curve->checkPoint(data, length);
+   //Any error to report?
+   if(error) return error;
+
+   //Save the public key
+   key->curve = curve;
+   memcpy(key->q, data, length);
+   key->qLen = length;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Load an EC private key
+ * @param[out] key EC private key
+ * @param[in] curve Elliptic curve parameters
+ * @param[in] data Private scalar (native encoding of the curve)
+ * @param[in] length Length of the private scalar
+ * @return Error code
+ **/
+
+error_t ecImportPrivateKey(EcPrivateKey *key, const EcCurveInfo *curve,
+   const uint8_t *data, size_t length)
+{
+   size_t i;
+
+   //Check parameters
+   if(key == NULL || curve == NULL || data == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Weierstrass curve?
+   if(curve->type == EC_CURVE_TYPE_WEIERSTRASS)
+   {
+      //Skip leading zeros
+      while(length > curve->fieldSize && data[0] == 0)
+      {
+         data++;
+         length--;
+      }
+
+      //Check the length of the scalar
+      if(length > curve->fieldSize)
+         return ERROR_INVALID_PARAMETER;
+
+      //The scalar is left-padded with zeros
+      memset(key->d, 0, curve->fieldSize - length);
+      memcpy(key->d + curve->fieldSize - length, data, length);
+
+      //Check whether the scalar is zero
+      for(i = 0; i < curve->fieldSize && key->d[i] == 0; i++);
+
+      //The private scalar shall be in the range [1, n - 1]
+      if(i == curve->fieldSize || memcmp(key->d, curve->order, curve->fieldSize) >= 0)
+      {
+         //Wipe the invalid key
+         memset(key->d, 0, sizeof(key->d));
+         //Report an error
+         return ERROR_INVALID_PARAMETER;
+      }
+   }
+   else
+   {
+      //Montgomery curves use fixed-length scalars
+      if(length != curve->fieldSize)
+         return ERROR_INVALID_PARAMETER;
+
+      //Save the scalar
+      memcpy(key->d, data, length);
+   }
+
+   //Save the elliptic curve
+   key->curve = curve;
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Generate a random scalar
+ * @param[in] curve Elliptic curve parameters
+ * @param[in] prngAlgo PRNG algorithm
+ * @param[in] prngContext Pointer to the PRNG context
+ * @param[out] d Random scalar (native encoding of the curve)
+ * @return Error code
+ **/
+
+error_t ecGenerateScalar(const EcCurveInfo *curve,
+   const PrngAlgo *prngAlgo, void *prngContext, uint8_t *d)
+{
+   error_t error;
+   size_t i;
+
+   //Check parameters
+   if(curve == NULL || prngAlgo == NULL || d == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Generate random scalars until a suitable one is found
+   while(1)
+   {
+      //Generate a random octet string
+      error = prngAlgo->read(prngContext, d, curve->fieldSize);
+      //Any error to report?
+      if(error) return error;
+
+      //Montgomery curves apply clamping to any random string
+      if(curve->type != EC_CURVE_TYPE_WEIERSTRASS)
+         break;
+
+      //Check whether the scalar is zero
+      for(i = 0; i < curve->fieldSize && d[i] == 0; i++);
+
+      //The scalar shall be in the range [1, n - 1]
+      if(i < curve->fieldSize && memcmp(d, curve->order, curve->fieldSize) < 0)
+         break;
+   }
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Get the elliptic curve that matches the specified OID
+ * @param[in] oid Object identifier
+ * @param[in] length OID length
+ * @return Elliptic curve parameters
+ **/
+
+const EcCurveInfo *ecGetCurveInfo(const uint8_t *oid, size_t length)
+{
+   uint_t i;
+
+   //Loop through the list of supported elliptic curves
+   for(i = 0; i < arraysize(ecCurveList); i++)
+   {
+      //Compare object identifiers
+      if(ecCurveList[i]->oidSize == length && !memcmp(ecCurveList[i]->oid, oid, length))
+         return ecCurveList[i];
+   }
+
+   //Unknown curve
+   return NULL;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file ec.h
+ * @brief Elliptic curve cryptography
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneCrypto Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+#ifndef _EC_H
+#define _EC_H
+
+//Dependencies
+#include "crypto.h"
+
+//Maximum size of a field element (in bytes)
+#define EC_MAX_FIELD_SIZE 32
+//Maximum size of an encoded point (uncompressed form)
+#define EC_MAX_POINT_SIZE (2 * EC_MAX_FIELD_SIZE + 1)
+
+//Point encoding (uncompressed form)
+#define EC_POINT_UNCOMPRESSED 0x04
+
+
+/**
+ * @brief Elliptic curve type
+ **/
+
+typedef enum
+{
+   EC_CURVE_TYPE_WEIERSTRASS = 1, ///<Short Weierstrass curve (a = -3)
+   EC_CURVE_TYPE_MONTGOMERY  = 2  ///<Montgomery curve (u-coordinate only)
+} EcCurveType;
+
+
+//Common interface for elliptic curves
+typedef error_t (*EcCheckPoint)(const uint8_t *p, size_t length);
+typedef error_t (*EcMulBase)(uint8_t *r, const uint8_t *d);
+typedef error_t (*EcMul)(uint8_t *r, const uint8_t *d, const uint8_t *p);
+typedef error_t (*EcMulAdd)(uint8_t *r, const uint8_t *u1, const uint8_t *u2, const uint8_t *q);
+
+
+/**
+ * @brief Elliptic curve parameters
+ *
+ * Scalars are encoded in the native format of the curve (big-endian
+ * octet strings for Weierstrass curves, little-endian octet strings for
+ * Montgomery curves). Points are encoded in uncompressed form (0x04 || X || Y)
+ * for Weierstrass curves and as a single u-coordinate for Montgomery curves
+ **/
+
+typedef struct
+{
+   const char_t *name;    ///<Curve name
+   const uint8_t *oid;    ///<Object identifier
+   size_t oidSize;        ///<OID size
+   EcCurveType type;      ///<Curve type
+   size_t fieldSize;      ///<Size of a field element, in bytes
+   size_t pointSize;      ///<Size of an encoded point, in bytes
+   const uint8_t *order;  ///<Order of the base point (Weierstrass curves only)
+   EcCheckPoint checkPoint;
+   EcMulBase mulBase;
+   EcMul mul;
+   EcMulAdd mulAdd;
+} EcCurveInfo;
+
+
+/**
+ * @brief EC public key
+ **/
+
+typedef struct
+{
+   const EcCurveInfo *curve;      ///<Elliptic curve
+   uint8_t q[EC_MAX_POINT_SIZE];  ///<Public point Q
+   size_t qLen;                   ///<Length of the encoded point
+} EcPublicKey;
+
+
+/**
+ * @brief EC private key
+ **/
+
+typedef struct
+{
+   const EcCurveInfo *curve;      ///<Elliptic curve
+   uint8_t d[EC_MAX_FIELD_SIZE];  ///<Private scalar d
+} EcPrivateKey;
+
+
+//EC related constants
+extern const uint8_t EC_PUBLIC_KEY_OID[7];
+
+//EC related functions
+void ecInitPublicKey(EcPublicKey *key);
+void ecFreePublicKey(EcPublicKey *key);
+
+void ecInitPrivateKey(EcPrivateKey *key);
+void ecFreePrivateKey(EcPrivateKey *key);
+
+error_t ecImportPublicKey(EcPublicKey *key, const EcCurveInfo *curve,
+   const uint8_t *data, size_t length);
+
+error_t ecImportPrivateKey(EcPrivateKey *key, const EcCurveInfo *curve,
+   const uint8_t *data, size_t length);
+
+error_t ecGenerateScalar(const EcCurveInfo *curve,
+   const PrngAlgo *prngAlgo, void *prngContext, uint8_t *d);
+
+const EcCurveInfo *ecGetCurveInfo(const uint8_t *oid, size_t length);
+
+#endif
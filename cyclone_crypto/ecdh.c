@@ -0,0 +1,207 @@
+/**
+ * @file ecdh.c
+ * @brief ECDH (Elliptic Curve Diffie-Hellman) key exchange
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneCrypto Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * The ECDH key agreement allows two parties to establish a shared secret
+ * over an insecure channel, using any curve that implements the common
+ * EcCurveInfo interface. Refer to SEC 1 and RFC 7748 for more details
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL CRYPTO_TRACE_LEVEL
+
+//Dependencies
+#include <string.h>
+#include "crypto.h"
+#include "ecdh.h"
+#include "debug.h"
+
+
+/**
+ * @brief Initialize ECDH context
+ * @param[in] context Pointer to the ECDH context
+ **/
+
+void ecdhInit(EcdhContext *context)
+{
+   //Clear the context
+   memset(context, 0, sizeof(EcdhContext));
+}
+
+
+/**
+ * @brief Release ECDH context
+ * @param[in] context Pointer to the ECDH context
+ **/
+
+void ecdhFree(EcdhContext *context)
+{
+   //Wipe the private key
+   memset(context, 0, sizeof(EcdhContext));
+}
+
+
+/**
+ * @brief ECDH key pair generation
+ * @param[in] context Pointer to the ECDH context
+ * @param[in] prngAlgo PRNG algorithm
+ * @param[in] prngContext Pointer to the PRNG context
+ * @return Error code
+ **/
+
+error_t ecdhGenerateKeyPair(EcdhContext *context,
+   const PrngAlgo *prngAlgo, void *prngContext)
+{
+   error_t error;
+
+   //Make sure the elliptic curve has been selected
+   if(context->curve == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Debug message
+   TRACE_DEBUG("Generating ECDH key pair (%s)...\r\n", context->curve->name);
+
+   //Generate a private key
+   error = ecGenerateScalar(context->curve, prngAlgo, prngContext, context->da);
+   //Any error to report?
+   if(error) return error;
+
+   //Compute Qa = da * G
+   error = context->curve->mulBase(context->qa, context->da);
+   //Any error to report?
+   if(error) return error;
+
+   //Length of the public key
+   context->qaLen = context->curve->pointSize;
+
+   //Debug message
+   TRACE_DEBUG("  Public key:\r\n");
+   TRACE_DEBUG_ARRAY("    ", context->qa, context->qaLen);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Check ECDH public key
+ * @param[in] curve Elliptic curve parameters
+ * @param[in] publicKey Encoded public key to be checked
+ * @param[in] length Length of the public key
+ * @return Error code
+ **/
+
+error_t ecdhCheckPublicKey(const EcCurveInfo *curve,
+   const uint8_t *publicKey, size_t length)
+{
+   //Check parameters
+   if(curve == NULL || publicKey == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Make sure the point is valid
+   if(curve->checkPoint(publicKey, length))
+      return ERROR_ILLEGAL_PARAMETER;
+
+   //The public key is acceptable
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Compute ECDH shared secret
+ * @param[in] context Pointer to the ECDH context
+ * @param[out] output Buffer where to store the shared secret
+ * @param[in] outputSize Size of the buffer in bytes
+ * @param[out] outputLength Length of the resulting shared secret
+ * @return Error code
+ **/
+
+error_t ecdhComputeSharedSecret(EcdhContext *context,
+   uint8_t *output, size_t outputSize, size_t *outputLength)
+{
+   error_t error;
+   size_t i;
+   uint8_t mask;
+   uint8_t z[EC_MAX_POINT_SIZE];
+
+   //Make sure the elliptic curve has been selected
+   if(context->curve == NULL)
+      return ERROR_INVALID_PARAMETER;
+   //Check the length of the output buffer
+   if(outputSize < context->curve->fieldSize)
+      return ERROR_INVALID_LENGTH;
+
+   //Debug message
+   TRACE_DEBUG("Computing ECDH shared secret...\r\n");
+
+   //Validate the peer's public key
+   error = ecdhCheckPublicKey(context->curve, context->qb, context->qbLen);
+   //Any error to report?
+   if(error) return error;
+
+   //Compute Z = da * Qb
+   error = context->curve->mul(z, context->da, context->qb);
+   //Any error to report?
+   if(error) return error;
+
+   //Weierstrass curve?
+   if(context->curve->type == EC_CURVE_TYPE_WEIERSTRASS)
+   {
+      //The shared secret is the x-coordinate of Z
+      memcpy(output, z + 1, context->curve->fieldSize);
+   }
+   else
+   {
+      //The shared secret is the u-coordinate of Z
+      memcpy(output, z, context->curve->fieldSize);
+
+      //An all-zero value indicates a low-order input point
+      for(mask = 0, i = 0; i < context->curve->fieldSize; i++)
+         mask |= output[i];
+
+      //Abort if the shared secret is zero
+      if(mask == 0)
+         error = ERROR_ILLEGAL_PARAMETER;
+   }
+
+   //Clear intermediate values
+   memset(z, 0, sizeof(z));
+
+   //Any error to report?
+   if(error) return error;
+
+   //Return the length of the shared secret
+   *outputLength = context->curve->fieldSize;
+
+   //Debug message
+   TRACE_DEBUG("  Shared secret (%u bytes):\r\n", *outputLength);
+   TRACE_DEBUG_ARRAY("    ", output, *outputLength);
+
+   //Successful processing
+   return NO_ERROR;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file ecdh.h
+ * @brief ECDH (Elliptic Curve Diffie-Hellman) key exchange
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneCrypto Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+#ifndef _ECDH_H
+#define _ECDH_H
+
+//Dependencies
+#include "crypto.h"
+#include "ec.h"
+
+
+/**
+ * @brief ECDH context
+ **/
+
+typedef struct
+{
+   const EcCurveInfo *curve;        ///<Elliptic curve
+   uint8_t da[EC_MAX_FIELD_SIZE];   ///<One's own private key
+   uint8_t qa[EC_MAX_POINT_SIZE];   ///<One's own public key
+   size_t qaLen;                    ///<Length of one's own public key
+   uint8_t qb[EC_MAX_POINT_SIZE];   ///<Peer's public key
+   size_t qbLen;                    ///<Length of the peer's public key
+} EcdhContext;
+
+
+//ECDH related functions
+void ecdhInit(EcdhContext *context);
+void ecdhFree(EcdhContext *context);
+
+error_t ecdhGenerateKeyPair(EcdhContext *context,
+   const PrngAlgo *prngAlgo, void *prngContext);
+
+error_t ecdhCheckPublicKey(const EcCurveInfo *curve,
+   const uint8_t *publicKey, size_t length);
+
+error_t ecdhComputeSharedSecret(EcdhContext *context,
+   uint8_t *output, size_t outputSize, size_t *outputLength);
+
+#endif
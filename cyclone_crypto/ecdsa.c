@@ -0,0 +1,475 @@
+/**
+ * @file ecdsa.c
+ * @brief ECDSA (Elliptic Curve Digital Signature Algorithm)
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneCrypto Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * ECDSA is the elliptic curve analogue of DSA. Scalar arithmetic modulo the
+ * order of the base point relies on multiple precision integers, while point
+ * arithmetic is delegated to the curve module. Refer to FIPS 186-3 and
+ * SEC 1 for more details
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL CRYPTO_TRACE_LEVEL
+
+//Dependencies
+#include <stdlib.h>
+#include <string.h>
+#include "crypto.h"
+#include "ecdsa.h"
+#include "mpi.h"
+#include "asn1.h"
+#include "debug.h"
+
+//ECDSA with SHA-1 OID (1.2.840.10045.4.1)
+const uint8_t ECDSA_WITH_SHA1_OID[7] = {0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x01};
+//ECDSA with SHA-224 OID (1.2.840.10045.4.3.1)
+const uint8_t ECDSA_WITH_SHA224_OID[8] = {0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x01};
+//ECDSA with SHA-256 OID (1.2.840.10045.4.3.2)
+const uint8_t ECDSA_WITH_SHA256_OID[8] = {0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x02};
+//ECDSA with SHA-384 OID (1.2.840.10045.4.3.3)
+const uint8_t ECDSA_WITH_SHA384_OID[8] = {0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x03};
+//ECDSA with SHA-512 OID (1.2.840.10045.4.3.4)
+const uint8_t ECDSA_WITH_SHA512_OID[8] = {0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x04, 0x03, 0x04};
+
+
+/**
+ * @brief Initialize an ECDSA signature
+ * @param[in] signature Pointer to the ECDSA signature to initialize
+ **/
+
+void ecdsaInitSignature(EcdsaSignature *signature)
+{
+   //Initialize multiple precision integers
+   mpiInit(&signature->r);
+   mpiInit(&signature->s);
+}
+
+
+/**
+ * @brief Release an ECDSA signature
+ * @param[in] signature Pointer to the ECDSA signature to free
+ **/
+
+void ecdsaFreeSignature(EcdsaSignature *signature)
+{
+   //Release multiple precision integers
+   mpiFree(&signature->r);
+   mpiFree(&signature->s);
+}
+
+
+/**
+ * @brief Encode ECDSA signature using ASN.1
+ *
+ * Integers are encoded with the minimum number of octets (DER), since
+ * many implementations re-encode the signature before comparing it
+ *
+ * @param[in] signature (R, S) integer pair
+ * @param[out] data Pointer to the buffer where to store the resulting ASN.1 structure
+ * @param[out] length Length of the ASN.1 structure
+ * @return Error code
+ **/
+
+error_t ecdsaWriteSignature(const EcdsaSignature *signature, uint8_t *data, size_t *length)
+{
+   error_t error;
+   size_t rLen;
+   size_t sLen;
+
+   //Debug message
+   TRACE_DEBUG("Writing ECDSA signature...\r\n");
+
+   //A leading zero is required when the most significant bit is set
+   rLen = mpiGetBitLength(&signature->r) / 8 + 1;
+   sLen = mpiGetBitLength(&signature->s) / 8 + 1;
+
+   //Only short length fields are supported
+   if((rLen + sLen + 4) > 127)
+      return ERROR_INVALID_LENGTH;
+
+   data[0] = ASN1_ENCODING_CONSTRUCTED | ASN1_TYPE_SEQUENCE;
+   data[1] = rLen + sLen + 4;
+   data[2] = ASN1_TYPE_INTEGER;
+   data[3] = rLen;
+
+   //Convert R to an octet string
+   error = mpiWriteRaw(&signature->r, data + 4, rLen);
+   //Any error to report?
+   if(error) return error;
+
+   data[rLen + 4] = ASN1_TYPE_INTEGER;
+   data[rLen + 5] = sLen;
+
+   //Convert S to an octet string
+   error = mpiWriteRaw(&signature->s, data + rLen + 6, sLen);
+   //Any error to report?
+   if(error) return error;
+
+   //Total length of the ASN.1 structure
+   *length = rLen + sLen + 6;
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Read an ASN.1 encoded ECDSA signature
+ * @param[in] data Pointer to the ASN.1 structure to decode
+ * @param[in] length Length of the ASN.1 structure
+ * @param[out] signature (R, S) integer pair
+ * @return Error code
+ **/
+
+error_t ecdsaReadSignature(const uint8_t *data, size_t length, EcdsaSignature *signature)
+{
+   error_t error;
+   Asn1Tag tag;
+
+   //Debug message
+   TRACE_DEBUG("Reading ECDSA signature...\r\n");
+
+   //Start of exception handling block
+   do
+   {
+      //Display ASN.1 structure
+      error = asn1DumpObject(data, length, 0);
+      //Any error to report?
+      if(error) break;
+
+      //Read the contents of the ASN.1 structure
+      error = asn1ReadTag(data, length, &tag);
+      //Failed to decode ASN.1 tag?
+      if(error) break;
+
+      //Enforce encoding, type and class
+      error = asn1CheckTag(&tag, TRUE, ASN1_CLASS_UNIVERSAL, ASN1_TYPE_SEQUENCE);
+      //The tag does not match the criteria?
+      if(error) break;
+
+      //Point to the first field
+      data = tag.value;
+      length = tag.length;
+
+      //Read the parameter r
+      error = asn1ReadTag(data, length, &tag);
+      //Failed to decode ASN.1 tag?
+      if(error) break;
+
+      //Enforce encoding, type and class
+      error = asn1CheckTag(&tag, FALSE, ASN1_CLASS_UNIVERSAL, ASN1_TYPE_INTEGER);
+      //The tag does not match the criteria?
+      if(error) break;
+
+      //Convert the octet string to a multiple precision integer
+      error = mpiReadRaw(&signature->r, tag.value, tag.length);
+      //Any error to report?
+      if(error) break;
+
+      //Point to the next field
+      data += tag.totalLength;
+      length -= tag.totalLength;
+
+      //Read the parameter s
+      error = asn1ReadTag(data, length, &tag);
+      //Failed to decode ASN.1 tag?
+      if(error) break;
+
+      //Enforce encoding, type and class
+      error = asn1CheckTag(&tag, FALSE, ASN1_CLASS_UNIVERSAL, ASN1_TYPE_INTEGER);
+      //The tag does not match the criteria?
+      if(error) break;
+
+      //Convert the octet string to a multiple precision integer
+      error = mpiReadRaw(&signature->s, tag.value, tag.length);
+      //Any error to report?
+      if(error) break;
+
+      //Dump ECDSA signature
+      TRACE_DEBUG("  r:\r\n");
+      TRACE_DEBUG_MPI("    ", &signature->r);
+      TRACE_DEBUG("  s:\r\n");
+      TRACE_DEBUG_MPI("    ", &signature->s);
+
+      //End of exception handling block
+   } while(0);
+
+   //Clean up side effects if necessary
+   if(error)
+      ecdsaFreeSignature(signature);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Convert a digest to an integer modulo n
+ * @param[out] z Resulting integer
+ * @param[in] n Order of the base point
+ * @param[in] digest Digest of the message
+ * @param[in] digestLength Length in octets of the digest
+ * @return Error code
+ **/
+
+static error_t ecdsaReadDigest(Mpi *z, const Mpi *n, const uint8_t *digest, size_t digestLength)
+{
+   error_t error;
+   uint_t k;
+
+   //Let N be the bit length of n
+   k = mpiGetBitLength(n);
+   //Compute N = min(N, outlen)
+   k = min(k, digestLength * 8);
+
+   //Convert the digest to a multiple precision integer
+   error = mpiReadRaw(z, digest, (k + 7) / 8);
+   //Any error to report?
+   if(error) return error;
+
+   //Keep the leftmost N bits of the hash value
+   if(k % 8)
+      error = mpiShiftRight(z, 8 - (k % 8));
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief ECDSA signature generation
+ * @param[in] prngAlgo PRNG algorithm
+ * @param[in] prngContext Pointer to the PRNG context
+ * @param[in] key Signer's EC private key
+ * @param[in] digest Digest of the message to be signed
+ * @param[in] digestLength Length in octets of the digest
+ * @param[out] signature (R, S) integer pair
+ * @return Error code
+ **/
+
+error_t ecdsaGenerateSignature(const PrngAlgo *prngAlgo, void *prngContext, const EcPrivateKey *key,
+   const uint8_t *digest, size_t digestLength, EcdsaSignature *signature)
+{
+   error_t error;
+   const EcCurveInfo *curve;
+   Mpi n;
+   Mpi k;
+   Mpi d;
+   Mpi z;
+   uint8_t buffer[EC_MAX_FIELD_SIZE];
+   uint8_t point[EC_MAX_POINT_SIZE];
+
+   //Check parameters
+   if(key == NULL || digest == NULL || signature == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Point to the elliptic curve
+   curve = key->curve;
+
+   //ECDSA requires a curve in Weierstrass form
+   if(curve == NULL || curve->type != EC_CURVE_TYPE_WEIERSTRASS)
+      return ERROR_INVALID_PARAMETER;
+
+   //Debug message
+   TRACE_DEBUG("ECDSA signature generation (%s)...\r\n", curve->name);
+   TRACE_DEBUG("  digest:\r\n");
+   TRACE_DEBUG_ARRAY("    ", digest, digestLength);
+
+   //Initialize multiple precision integers
+   mpiInit(&n);
+   mpiInit(&k);
+   mpiInit(&d);
+   mpiInit(&z);
+
+   //Load the order of the base point and the private key
+   MPI_CHECK(mpiReadRaw(&n, curve->order, curve->fieldSize));
+   MPI_CHECK(mpiReadRaw(&d, key->d, curve->fieldSize));
+   //Convert the digest to an integer
+   MPI_CHECK(ecdsaReadDigest(&z, &n, digest, digestLength));
+
+   //Repeat until a valid signature is obtained
+   do
+   {
+      //Generate a per-message secret number 0 < k < n
+      MPI_CHECK(ecGenerateScalar(curve, prngAlgo, prngContext, buffer));
+      MPI_CHECK(mpiReadRaw(&k, buffer, curve->fieldSize));
+
+      //Compute (x1, y1) = k * G
+      MPI_CHECK(curve->mulBase(point, buffer));
+
+      //Compute r = x1 mod n
+      MPI_CHECK(mpiReadRaw(&signature->r, point + 1, curve->fieldSize));
+      MPI_CHECK(mpiMod(&signature->r, &signature->r, &n));
+
+      //Compute k ^ -1 mod n
+      MPI_CHECK(mpiInvMod(&k, &k, &n));
+
+      //Compute s = k ^ -1 * (z + d * r) mod n
+      MPI_CHECK(mpiMul(&signature->s, &d, &signature->r));
+      MPI_CHECK(mpiAdd(&signature->s, &signature->s, &z));
+      MPI_CHECK(mpiMod(&signature->s, &signature->s, &n));
+      MPI_CHECK(mpiMulMod(&signature->s, &signature->s, &k, &n));
+
+      //The values r = 0 and s = 0 are not allowed
+   } while(!mpiCompInt(&signature->r, 0) || !mpiCompInt(&signature->s, 0));
+
+   //Dump ECDSA signature
+   TRACE_DEBUG("  r:\r\n");
+   TRACE_DEBUG_MPI("    ", &signature->r);
+   TRACE_DEBUG("  s:\r\n");
+   TRACE_DEBUG_MPI("    ", &signature->s);
+
+end:
+   //Clear intermediate values
+   memset(buffer, 0, sizeof(buffer));
+
+   //Release multiple precision integers
+   mpiFree(&n);
+   mpiFree(&k);
+   mpiFree(&d);
+   mpiFree(&z);
+
+   //Clean up side effects if necessary
+   if(error)
+      ecdsaFreeSignature(signature);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief ECDSA signature verification
+ * @param[in] key Signer's EC public key
+ * @param[in] digest Digest of the message whose signature is to be verified
+ * @param[in] digestLength Length in octets of the digest
+ * @param[in] signature (R, S) integer pair
+ * @return Error code
+ **/
+
+error_t ecdsaVerifySignature(const EcPublicKey *key,
+   const uint8_t *digest, size_t digestLength, const EcdsaSignature *signature)
+{
+   error_t error;
+   const EcCurveInfo *curve;
+   Mpi n;
+   Mpi w;
+   Mpi z;
+   Mpi u1;
+   Mpi u2;
+   uint8_t buffer1[EC_MAX_FIELD_SIZE];
+   uint8_t buffer2[EC_MAX_FIELD_SIZE];
+   uint8_t point[EC_MAX_POINT_SIZE];
+
+   //Check parameters
+   if(key == NULL || digest == NULL || signature == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Point to the elliptic curve
+   curve = key->curve;
+
+   //ECDSA requires a curve in Weierstrass form
+   if(curve == NULL || curve->type != EC_CURVE_TYPE_WEIERSTRASS)
+      return ERROR_INVALID_PARAMETER;
+   //Check the length of the public key
+   if(key->qLen != curve->pointSize)
+      return ERROR_INVALID_KEY;
+
+   //Debug message
+   TRACE_DEBUG("ECDSA signature verification (%s)...\r\n", curve->name);
+   TRACE_DEBUG("  digest:\r\n");
+   TRACE_DEBUG_ARRAY("    ", digest, digestLength);
+   TRACE_DEBUG("  r:\r\n");
+   TRACE_DEBUG_MPI("    ", &signature->r);
+   TRACE_DEBUG("  s:\r\n");
+   TRACE_DEBUG_MPI("    ", &signature->s);
+
+   //Initialize multiple precision integers
+   mpiInit(&n);
+   mpiInit(&w);
+   mpiInit(&z);
+   mpiInit(&u1);
+   mpiInit(&u2);
+
+   //Load the order of the base point
+   MPI_CHECK(mpiReadRaw(&n, curve->order, curve->fieldSize));
+
+   //The verifier shall check that 0 < r < n and 0 < s < n. If either
+   //condition is violated, the signature shall be rejected as invalid
+   if(mpiCompInt(&signature->r, 0) <= 0 || mpiComp(&signature->r, &n) >= 0 ||
+      mpiCompInt(&signature->s, 0) <= 0 || mpiComp(&signature->s, &n) >= 0)
+   {
+      //Report an error
+      error = ERROR_INVALID_SIGNATURE;
+      goto end;
+   }
+
+   //Convert the digest to an integer
+   MPI_CHECK(ecdsaReadDigest(&z, &n, digest, digestLength));
+
+   //Compute w = s ^ -1 mod n
+   MPI_CHECK(mpiInvMod(&w, &signature->s, &n));
+   //Compute u1 = z * w mod n
+   MPI_CHECK(mpiMulMod(&u1, &z, &w, &n));
+   //Compute u2 = r * w mod n
+   MPI_CHECK(mpiMulMod(&u2, &signature->r, &w, &n));
+
+   //Convert u1 and u2 to octet strings
+   MPI_CHECK(mpiWriteRaw(&u1, buffer1, curve->fieldSize));
+   MPI_CHECK(mpiWriteRaw(&u2, buffer2, curve->fieldSize));
+
+   //Compute (x1, y1) = u1 * G + u2 * Q
+   if(curve->mulAdd(point, buffer1, buffer2, key->q))
+   {
+      //The point at infinity or an invalid public key is rejected
+      error = ERROR_INVALID_SIGNATURE;
+      goto end;
+   }
+
+   //Compute v = x1 mod n
+   MPI_CHECK(mpiReadRaw(&w, point + 1, curve->fieldSize));
+   MPI_CHECK(mpiMod(&w, &w, &n));
+
+   //Debug message
+   TRACE_DEBUG("  v:\r\n");
+   TRACE_DEBUG_MPI("    ", &w);
+
+   //If v = r, then the signature is verified. If v does not equal r,
+   //then the message or the signature may have been modified
+   error = mpiComp(&w, &signature->r) ? ERROR_INVALID_SIGNATURE : NO_ERROR;
+
+end:
+   //Release multiple precision integers
+   mpiFree(&n);
+   mpiFree(&w);
+   mpiFree(&z);
+   mpiFree(&u1);
+   mpiFree(&u2);
+
+   //Return status code
+   return error;
+}
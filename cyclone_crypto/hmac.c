@@ -107,6 +107,7 @@ void hmacInit(HmacContext *context, const HashAlgo *hash,
    const void *key, size_t keyLength)
 {
    uint_t i;
+   uint8_t k[MAX_HASH_BLOCK_SIZE];
 
    //Hash algorithm used to compute HMAC
    context->hash = hash;
@@ -119,26 +120,51 @@ void hmacInit(HmacContext *context, const HashAlgo *hash,
       //Digest the original key
       hash->update(context->hashContext, key, keyLength);
       //Finalize the message digest computation
-      hash->final(context->hashContext, context->key);
+      hash->final(context->hashContext, k);
       //Key is padded to the right with extra zeros
-      memset(context->key + hash->digestSize, 0, hash->blockSize - hash->digestSize);
+      memset(k + hash->digestSize, 0, hash->blockSize - hash->digestSize);
    }
    else
    {
       //Copy the key
-      memcpy(context->key, key, keyLength);
+      memcpy(k, key, keyLength);
       //Key is padded to the right with extra zeros
-      memset(context->key + keyLength, 0, hash->blockSize - keyLength);
+      memset(k + keyLength, 0, hash->blockSize - keyLength);
    }
 
    //XOR the resulting key with ipad
    for(i = 0; i < hash->blockSize; i++)
-      context->key[i] ^= HMAC_IPAD;
+      k[i] ^= HMAC_IPAD;
+
+   //Precompute the hash context for the first pass
+   hash->init(context->innerContext);
+   hash->update(context->innerContext, k, hash->blockSize);
+
+   //XOR the original key with opad
+   for(i = 0; i < hash->blockSize; i++)
+      k[i] ^= HMAC_IPAD ^ HMAC_OPAD;
+
+   //Precompute the hash context for the second pass
+   hash->init(context->outerContext);
+   hash->update(context->outerContext, k, hash->blockSize);
+
+   //Erase the padded key from the stack
+   memset(k, 0, MAX_HASH_BLOCK_SIZE);
 
-   //Initialize context for the first pass
-   hash->init(context->hashContext);
    //Start with the inner pad
-   hash->update(context->hashContext, context->key, hash->blockSize);
+   memcpy(context->hashContext, context->innerContext, hash->contextSize);
+}
+
+
+/**
+ * @brief Start a new HMAC calculation using the current key
+ * @param[in] context Pointer to the HMAC context
+ **/
+
+void hmacReset(HmacContext *context)
+{
+   //Restore the hash context obtained after digesting the inner pad
+   memcpy(context->hashContext, context->innerContext, context->hash->contextSize);
 }
 
 
@@ -166,21 +192,13 @@ void hmacUpdate(HmacContext *context, const void *data, size_t length)
 
 void hmacFinal(HmacContext *context, uint8_t *digest)
 {
-   uint_t i;
-
    //Hash algorithm used to compute HMAC
    const HashAlgo *hash = context->hash;
    //Finish the first pass
    hash->final(context->hashContext, context->digest);
 
-   //XOR the original key with opad
-   for(i = 0; i < hash->blockSize; i++)
-      context->key[i] ^= HMAC_IPAD ^ HMAC_OPAD;
-
-   //Initialize context for the second pass
-   hash->init(context->hashContext);
-   //Start with outer pad
-   hash->update(context->hashContext, context->key, hash->blockSize);
+   //Start the second pass with the precomputed outer pad
+   memcpy(context->hashContext, context->outerContext, hash->contextSize);
    //Then digest the result of the first hash
    hash->update(context->hashContext, context->digest, hash->digestSize);
    //Finish the second pass
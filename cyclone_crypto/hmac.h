@@ -54,13 +54,18 @@
 
 /**
  * @brief HMAC algorithm context
+ *
+ * The hash contexts obtained after absorbing the inner and outer padded
+ * keys are computed once by hmacInit(). hmacReset() then restarts a new
+ * message under the same key without hashing the padded key again
  **/
 
 typedef struct
 {
    const HashAlgo *hash;
    uint8_t hashContext[MAX_HASH_CONTEXT_SIZE];
-   uint8_t key[MAX_HASH_BLOCK_SIZE];
+   uint8_t innerContext[MAX_HASH_CONTEXT_SIZE];
+   uint8_t outerContext[MAX_HASH_CONTEXT_SIZE];
    uint8_t digest[MAX_HASH_DIGEST_SIZE];
 } HmacContext;
 
@@ -82,6 +87,7 @@ error_t hmacCompute(const HashAlgo *hash, const void *key, size_t keyLength,
 void hmacInit(HmacContext *context, const HashAlgo *hash,
    const void *key, size_t length);
 
+void hmacReset(HmacContext *context);
 void hmacUpdate(HmacContext *context, const void *data, size_t length);
 void hmacFinal(HmacContext *context, uint8_t *digest);
 
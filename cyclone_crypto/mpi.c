@@ -36,6 +36,89 @@
 #include "mpi.h"
 #include "debug.h"
 
+//Number of words per limb
+#define MPI_LIMB_WORDS (sizeof(MpiLimb) / MPI_INT_SIZE)
+
+//x86-64 assembly (64-bit limbs)
+#if (MPI_ASM_SUPPORT == ENABLED && MPI_LIMB_SIZE == 64 && defined(__GNUC__) && \
+   defined(__x86_64__))
+
+//Column accumulation (C2:C1:C0 = C2:C1:C0 + A * B)
+#define MPI_MUL_ACC(c0, c1, c2, a, b) \
+{ \
+   MpiLimb _lo = (a); \
+   MpiLimb _hi; \
+   __asm__("mulq %5\n\t" \
+      "addq %%rax, %0\n\t" \
+      "adcq %%rdx, %1\n\t" \
+      "adcq $0, %2" \
+      : "+r" (c0), "+r" (c1), "+r" (c2), "+a" (_lo), "=&d" (_hi) \
+      : "rm" ((MpiLimb) (b)) : "cc"); \
+}
+
+//ARM assembly (32-bit limbs, ARM or Thumb-2 instruction set)
+#elif (MPI_ASM_SUPPORT == ENABLED && MPI_LIMB_SIZE == 32 && defined(__GNUC__) && \
+   defined(__arm__) && (!defined(__thumb__) || defined(__thumb2__)))
+
+//Column accumulation (C2:C1:C0 = C2:C1:C0 + A * B)
+#define MPI_MUL_ACC(c0, c1, c2, a, b) \
+{ \
+   MpiLimb _lo; \
+   MpiLimb _hi; \
+   __asm__("umull %3, %4, %5, %6\n\t" \
+      "adds %0, %0, %3\n\t" \
+      "adcs %1, %1, %4\n\t" \
+      "adc %2, %2, #0" \
+      : "+r" (c0), "+r" (c1), "+r" (c2), "=&r" (_lo), "=&r" (_hi) \
+      : "r" ((MpiLimb) (a)), "r" ((MpiLimb) (b)) : "cc"); \
+}
+
+//The UMAAL instruction requires ARMv6 (ARMv7E-M for Cortex-M cores)
+#if (__ARM_ARCH >= 6 && (!defined(__ARM_ARCH_PROFILE) || \
+   __ARM_ARCH_PROFILE != 'M' || defined(__ARM_FEATURE_DSP)))
+
+//Multiply-add (HI:LO = A * B + LO + HI)
+#define MPI_MUL_ADD(lo, hi, a, b) \
+   __asm__("umaal %0, %1, %2, %3" \
+      : "+r" (lo), "+r" (hi) \
+      : "r" ((MpiLimb) (a)), "r" ((MpiLimb) (b)))
+
+#endif
+#endif
+
+//Generic column accumulation (C2:C1:C0 = C2:C1:C0 + A * B)
+#ifndef MPI_MUL_ACC
+#define MPI_MUL_ACC(c0, c1, c2, a, b) \
+{ \
+   MpiDoubleLimb _d = (MpiDoubleLimb) (a) * (b) + (c0); \
+   c0 = (MpiLimb) _d; \
+   _d = (_d >> MPI_LIMB_SIZE) + (c1); \
+   c1 = (MpiLimb) _d; \
+   c2 += (MpiLimb) (_d >> MPI_LIMB_SIZE); \
+}
+#endif
+
+//Generic multiply-add (HI:LO = A * B + LO + HI)
+#ifndef MPI_MUL_ADD
+#define MPI_MUL_ADD(lo, hi, a, b) \
+{ \
+   MpiDoubleLimb _d = (MpiDoubleLimb) (a) * (b) + (lo) + (hi); \
+   lo = (MpiLimb) _d; \
+   hi = (MpiLimb) (_d >> MPI_LIMB_SIZE); \
+}
+#endif
+
+//Limb array helpers
+static void mpiLoadLimbs(MpiLimb *r, uint_t n, const Mpi *a, uint_t offset);
+static error_t mpiStoreLimbs(Mpi *x, const MpiLimb *r, uint_t n);
+static void mpiMulLimbs(MpiLimb *r, const MpiLimb *a, uint_t m,
+   const MpiLimb *b, uint_t n);
+static void mpiKaratsubaMulLimbs(MpiLimb *r, const MpiLimb *a,
+   const MpiLimb *b, uint_t n, MpiLimb *t);
+static void mpiKaratsubaSqrLimbs(MpiLimb *r, const MpiLimb *a,
+   uint_t n, MpiLimb *t);
+static uint_t mpiGetKaratsubaTempSize(uint_t n);
+
 
 /**
  * @brief Initialize a big number
@@ -960,87 +1043,86 @@ error_t mpiShiftRight(Mpi *x, uint_t n)
 }
 
 
-#define ADDC(x, a, c) \
-   x += c; \
-   if((x) != 0) c = 0; \
-   x += a; \
-   if((x) < (a)) c = 1
+/**
+ * @brief Multiple precision multiplication
+ *
+ * The column-wise (Comba) method is used for small operands. Large
+ * operands are processed with Karatsuba multiplication, and a dedicated
+ * squaring routine is used when both operands are the same integer
+ *
+ * @param[out] x Resulting integer X = A * B
+ * @param[in] a First operand A
+ * @param[in] b Second operand B
+ * @return Error code
+ **/
 
 error_t mpiMul(Mpi *x, const Mpi *a, const Mpi *b)
 {
    error_t error;
-   int_t i;
-   int_t k;
-   int_t m;
-   int_t n;
-   uint64_t p;
-   Mpi ta;
-   Mpi tb;
+   int_t sign;
+   uint_t m;
+   uint_t n;
+   size_t size;
+   MpiLimb *buffer;
+   MpiLimb *r;
+   MpiLimb *u;
+   MpiLimb *v;
+   MpiLimb *t;
 
-   mpiInit(&ta);
-   mpiInit(&tb);
+   //Determine the actual length of A and B, in limbs
+   m = (mpiGetLength(a) + MPI_LIMB_WORDS - 1) / MPI_LIMB_WORDS;
+   n = (mpiGetLength(b) + MPI_LIMB_WORDS - 1) / MPI_LIMB_WORDS;
 
-   if(x == a)
-   {
-      //Copy A to TA
-      error = mpiCopy(&ta, a);
-      //Any error to report?
-      if(error) return error;
-      //Use TA instead of A
-      a = &ta;
-   }
-   if(x == b)
-   {
-      //Copy B to TB
-      error = mpiCopy(&tb, b);
-      //Any error to report?
-      if(error)
-      {
-         //Free previously allocated memory
-         mpiFree(&ta);
-         return error;
-      }
-      //Use TB instead of B
-      b = &tb;
-   }
+   //Sign of the result
+   sign = (a->sign == b->sign) ? 1 : -1;
 
-   //Determine the actual length of A and B
-   m = mpiGetLength(a);
-   n = mpiGetLength(b);
+   //Multiplication by zero?
+   if(m == 0 || n == 0)
+      return mpiSetValue(x, 0);
 
-   //Adjust the size of the destination operand
-   error = mpiGrow(x, m + n);
-   //Any error to report?
-   if(error)
-   {
-      //Free previously allocated memory
-      mpiFree(&ta);
-      mpiFree(&tb);
-      return error;
-   }
+   //Karatsuba multiplication requires operands of the same length
+   if(a == b || min(m, n) >= MPI_KARATSUBA_THRESHOLD)
+      m = n = max(m, n);
+
+   //The operands are copied, so that X may point to A or B
+   size = 2 * (m + n) + mpiGetKaratsubaTempSize(max(m, n));
 
+   //Allocate a memory buffer to hold the operands and the product
+   buffer = osMemAlloc(size * sizeof(MpiLimb));
+   //Failed to allocate memory?
+   if(!buffer) return ERROR_OUT_OF_MEMORY;
+
+   //Split the buffer
+   u = buffer;
+   v = u + m;
+   r = v + n;
+   t = r + m + n;
+
+   //Load A and B
+   mpiLoadLimbs(u, m, a, 0);
+   mpiLoadLimbs(v, n, b, 0);
+
+   //Squaring?
+   if(a == b)
+      mpiKaratsubaSqrLimbs(r, u, m, t);
+   //Balanced multiplication?
+   else if(m == n)
+      mpiKaratsubaMulLimbs(r, u, v, m, t);
+   //Unbalanced multiplication?
+   else
+      mpiMulLimbs(r, u, m, v, n);
+
+   //Copy the product
+   error = mpiStoreLimbs(x, r, m + n);
    //Set the sign of the result X
-   x->sign = (a->sign == b->sign) ? 1 : -1;
-   //Clear the contents of X
-   memset(x->data, 0, x->size * MPI_INT_SIZE);
+   x->sign = sign;
 
-   for(k = 0; k <= (m + n - 2); k++)
-   {
-      for(i = max(k - n + 1, 0); i <= min(k, m - 1); i++)
-      {
-         uint_t c = 0;
-         p = (uint64_t) a->data[i] * b->data[k - i];
-         ADDC(x->data[k], (uint32_t ) p, c);
-         ADDC(x->data[k + 1], (uint32_t) (p >> 32), c);
-         ADDC(x->data[k + 2], 0, c);
-      }
-   }
+   //Erase contents before releasing memory
+   memset(buffer, 0, size * sizeof(MpiLimb));
+   osMemFree(buffer);
 
-   //Release previously allocated memory
-   mpiFree(&ta);
-   mpiFree(&tb);
-   //Successful operation
-   return NO_ERROR;
+   //Return status code
+   return error;
 }
 
 error_t mpiMulInt(Mpi *x, const Mpi *a, int_t b)
@@ -1057,11 +1139,36 @@ error_t mpiMulInt(Mpi *x, const Mpi *a, int_t b)
 }
 
 
+/**
+ * @brief Multiple precision division
+ *
+ * Knuth's algorithm D is used. The divisor is first normalized so that
+ * each quotient word can be estimated from the leading words of the
+ * partial remainder
+ *
+ * @param[out] x Quotient Q = A / B (optional parameter)
+ * @param[out] y Remainder R = A - Q * B, with the sign of A (optional parameter)
+ * @param[in] a Dividend A
+ * @param[in] b Divisor B
+ * @return Error code
+ **/
+
 error_t mpiDiv(Mpi *x, Mpi *y, const Mpi *a, const Mpi *b)
 {
    error_t error;
+   int_t qSign;
+   int_t rSign;
+   uint_t i;
+   uint_t j;
    uint_t m;
    uint_t n;
+   uint_t s;
+   uint_t borrow;
+   uint64_t carry;
+   uint64_t p;
+   uint64_t q;
+   uint64_t r;
+   uint64_t t;
    Mpi c;
    Mpi d;
    Mpi e;
@@ -1069,34 +1176,99 @@ error_t mpiDiv(Mpi *x, Mpi *y, const Mpi *a, const Mpi *b)
    if(!mpiCompInt(b, 0))
       return ERROR_INVALID_PARAMETER;
 
+   //Sign of the quotient and of the remainder
+   qSign = (a->sign == b->sign) ? 1 : -1;
+   rSign = a->sign;
+
    //Initialize multiple precision integers
    mpiInit(&c);
    mpiInit(&d);
    mpiInit(&e);
 
+   //Work with the absolute values of A and B
    MPI_CHECK(mpiCopy(&c, a));
    MPI_CHECK(mpiCopy(&d, b));
    MPI_CHECK(mpiSetValue(&e, 0));
+   c.sign = 1;
+   d.sign = 1;
 
-   m = mpiGetBitLength(&c);
-   n = mpiGetBitLength(&d);
+   //The quotient is zero if |A| < |B|
+   if(mpiCompAbs(&c, &d) >= 0)
+   {
+      //Normalize the operands so that the most significant bit of B is set
+      s = (32 - mpiGetBitLength(&d) % 32) % 32;
+      MPI_CHECK(mpiShiftLeft(&c, s));
+      MPI_CHECK(mpiShiftLeft(&d, s));
 
-   if(m > n)
-      MPI_CHECK(mpiShiftLeft(&d, m - n));
+      //Length of the normalized operands, in words
+      m = mpiGetLength(&c);
+      n = mpiGetLength(&d);
 
-   while(n++ <= m)
-   {
-      MPI_CHECK(mpiShiftLeft(&e, 1));
+      //The partial remainder requires an extra word
+      MPI_CHECK(mpiGrow(&c, m + 1));
+      MPI_CHECK(mpiGrow(&e, m - n + 1));
 
-      if(mpiComp(&c, &d) >= 0)
+      //Compute the quotient one word at a time
+      for(j = m - n + 1; j-- > 0; )
       {
-         MPI_CHECK(mpiSetBitValue(&e, 0, 1));
-         MPI_CHECK(mpiSub(&c, &c, &d));
+         //Estimate the current word from the two leading words
+         t = ((uint64_t) c.data[j + n] << 32) | c.data[j + n - 1];
+         q = t / d.data[n - 1];
+         r = t % d.data[n - 1];
+
+         //The estimate is at most two units too large
+         while(q > 0xFFFFFFFF || (n > 1 &&
+            q * d.data[n - 2] > ((r << 32) | c.data[j + n - 2])))
+         {
+            q--;
+            r += d.data[n - 1];
+
+            //The test is only relevant while R fits in a word
+            if(r > 0xFFFFFFFF)
+               break;
+         }
+
+         //Subtract Q * B from the partial remainder
+         for(carry = 0, borrow = 0, i = 0; i < n; i++)
+         {
+            p = q * d.data[i] + carry;
+            carry = p >> 32;
+            t = (uint64_t) c.data[i + j] - (uint32_t) p - borrow;
+            c.data[i + j] = (uint32_t) t;
+            borrow = (uint32_t) (t >> 32) & 1;
+         }
+
+         t = (uint64_t) c.data[j + n] - carry - borrow;
+         c.data[j + n] = (uint32_t) t;
+
+         //The estimate was still one unit too large?
+         if(t >> 63)
+         {
+            q--;
+
+            //Add B back to the partial remainder
+            for(carry = 0, i = 0; i < n; i++)
+            {
+               p = (uint64_t) c.data[i + j] + d.data[i] + carry;
+               c.data[i + j] = (uint32_t) p;
+               carry = p >> 32;
+            }
+
+            c.data[j + n] += (uint32_t) carry;
+         }
+
+         //Save the current word of the quotient
+         e.data[j] = (uint32_t) q;
       }
 
-      MPI_CHECK(mpiShiftRight(&d, 1));
+      //Denormalize the remainder
+      MPI_CHECK(mpiShiftRight(&c, s));
    }
 
+   //Set the sign of the results
+   e.sign = qSign;
+   c.sign = rSign;
+
    if(x != NULL)
       MPI_CHECK(mpiCopy(x, &e));
 
@@ -1129,51 +1301,43 @@ error_t mpiDivInt(Mpi *x, Mpi *y, const Mpi *a, int_t b)
 }
 
 
-error_t mpiMod(Mpi *x, const Mpi *a, const Mpi *b)
+/**
+ * @brief Modular reduction
+ * @param[out] x Resulting integer R = A mod P, with 0 <= R < P
+ * @param[in] a The multiple precision integer to be reduced
+ * @param[in] p The modulus P
+ * @return Error code
+ **/
+
+error_t mpiMod(Mpi *x, const Mpi *a, const Mpi *p)
 {
    error_t error;
-   int_t sign;
-   uint_t m;
-   uint_t n;
    Mpi c;
 
    //Make sure the modulus is positive
-   if(mpiCompInt(b, 0) <= 0)
+   if(mpiCompInt(p, 0) <= 0)
       return ERROR_INVALID_PARAMETER;
 
-   sign = a->sign;
-   m = mpiGetBitLength(a);
-   n = mpiGetBitLength(b);
-
-   if(m < n) return NO_ERROR;
-
    //Initialize multiple precision integer
    mpiInit(&c);
 
-   MPI_CHECK(mpiCopy(&c, b));
-   MPI_CHECK(mpiShiftLeft(&c, m - n));
-   MPI_CHECK(mpiCopy(x, a));
+   //Compute the remainder of the division, which has the sign of A
+   MPI_CHECK(mpiDiv(NULL, &c, a, p));
 
-   while(mpiCompAbs(x, b) >= 0)
+   //Negative remainder?
+   if(mpiCompInt(&c, 0) < 0)
    {
-      if(mpiCompAbs(x, &c) >= 0)
-      {
-         MPI_CHECK(mpiSubAbs(x, x, &c));
-      }
-
-      MPI_CHECK(mpiShiftRight(&c, 1));
+      MPI_CHECK(mpiAdd(&c, &c, p));
    }
 
-   if(sign < 0)
-   {
-      MPI_CHECK(mpiSubAbs(x, b, x));
-   }
+   //Copy the result
+   MPI_CHECK(mpiCopy(x, &c));
 
 end:
    //Release previously allocated memory
    mpiFree(&c);
    //Return status code
-   return NO_ERROR;
+   return error;
 }
 
 
@@ -1258,87 +1422,123 @@ end:
 }
 
 
+/**
+ * @brief Modular exponentiation
+ *
+ * Odd moduli are handled by the sliding window Montgomery exponentiation,
+ * which runs in variable time and is therefore suitable for public
+ * exponents only. Use mpiExpModRegular() for secret exponents
+ *
+ * @param[out] x Resulting integer X = A ^ E mod P
+ * @param[in] a Base A
+ * @param[in] e Exponent E
+ * @param[in] p Modulus P
+ * @return Error code
+ **/
+
 error_t mpiExpMod(Mpi *x, const Mpi *a, const Mpi *e, const Mpi *p)
 {
    error_t error;
    int_t i;
-   uint_t k;
    Mpi b;
-   Mpi y;
-   Mpi r2;
 
-   //Initialize multiple precision integers
+   //Odd modulus?
+   if(mpiIsOdd(p))
+      return mpiExpModFast(x, a, e, p);
+
+   //Initialize multiple precision integer
    mpiInit(&b);
-   mpiInit(&y);
-   mpiInit(&r2);
 
-   if(mpiIsEven(p))
+   if(x == a)
    {
-      if(x == a)
-      {
-         MPI_CHECK(mpiCopy(&b, a));
-         a = &b;
-      }
+      MPI_CHECK(mpiCopy(&b, a));
+      a = &b;
+   }
 
-      MPI_CHECK(mpiSetValue(x, 1));
+   MPI_CHECK(mpiSetValue(x, 1));
 
-      for(i = mpiGetBitLength(e) - 1; i >= 0; i--)
-      {
-         MPI_CHECK(mpiMulMod(x, x, x, p));
+   for(i = mpiGetBitLength(e) - 1; i >= 0; i--)
+   {
+      MPI_CHECK(mpiMulMod(x, x, x, p));
 
-         if(mpiGetBitValue(e, i))
-         {
-            MPI_CHECK(mpiMulMod(x, x, a, p));
-         }
+      if(mpiGetBitValue(e, i))
+      {
+         MPI_CHECK(mpiMulMod(x, x, a, p));
       }
    }
-   else
-   {
-      //Compute the smaller R = (2^32)^k such as R > P
-      k = mpiGetLength(p);
 
-      //Compute R^2 mod P
-      MPI_CHECK(mpiSetValue(&r2, 1));
-      MPI_CHECK(mpiShiftLeft(&r2, 2 * k * (MPI_INT_SIZE * 8)));
-      MPI_CHECK(mpiMod(&r2, &r2, p));
+end:
+   //Release multiple precision integer
+   mpiFree(&b);
 
-      //Compute B = A * R mod P
-      if(mpiComp(a, p) >= 0)
-      {
-         MPI_CHECK(mpiMod(&b, a, p));
-         MPI_CHECK(mpiMontgomeryMul(&b, &b, &r2, k, p));
-      }
-      else
-      {
-         MPI_CHECK(mpiMontgomeryMul(&b, a, &r2, k, p));
-      }
+   //Return status code
+   return error;
+}
 
-      //Compute X = R mod P
-      MPI_CHECK(mpiCopy(&y, &r2));
-      MPI_CHECK(mpiMontgomeryRed(&y, k, p));
 
-      for(i = mpiGetBitLength(e) - 1; i >= 0; i--)
-      {
-         //Compute X = X^2 * R^-1 mod P
-         MPI_CHECK(mpiMontgomeryMul(&y, &y, &y, k, p));
+/**
+ * @brief Modular exponentiation (fast calculation)
+ *
+ * The sliding window method is used. The execution time depends on the
+ * exponent, hence this function shall only be used with public exponents
+ *
+ * @param[out] x Resulting integer X = A ^ E mod P
+ * @param[in] a Base A
+ * @param[in] e Exponent E
+ * @param[in] p Odd modulus P
+ * @return Error code
+ **/
 
-         if(mpiGetBitValue(e, i))
-         {
-            //Compute X = X * B * R^-1 mod P
-            MPI_CHECK(mpiMontgomeryMul(&y, &y, &b, k, p));
-         }
-      }
+error_t mpiExpModFast(Mpi *x, const Mpi *a, const Mpi *e, const Mpi *p)
+{
+   error_t error;
+   MpiMontgomeryContext context;
 
-      //Compute X = X * R^-1 mod N
-      MPI_CHECK(mpiMontgomeryRed(&y, k, p));
-      MPI_CHECK(mpiCopy(x, &y));
-   }
+   //Precompute the Montgomery parameters
+   error = mpiMontgomeryInit(&context, p);
+   //Any error to report?
+   if(error) return error;
 
-end:
-   //Release multiple precision integers
-   mpiFree(&b);
-   mpiFree(&y);
-   mpiFree(&r2);
+   //Perform modular exponentiation
+   error = mpiMontgomeryExpMod(&context, x, a, e, FALSE);
+
+   //Release Montgomery context
+   mpiMontgomeryFree(&context);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Modular exponentiation (regular calculation)
+ *
+ * The fixed window method is used with a constant-time table lookup, so
+ * that the sequence of operations and the memory access pattern do not
+ * depend on the exponent. This function shall be used with private exponents
+ *
+ * @param[out] x Resulting integer X = A ^ E mod P
+ * @param[in] a Base A
+ * @param[in] e Exponent E
+ * @param[in] p Odd modulus P
+ * @return Error code
+ **/
+
+error_t mpiExpModRegular(Mpi *x, const Mpi *a, const Mpi *e, const Mpi *p)
+{
+   error_t error;
+   MpiMontgomeryContext context;
+
+   //Precompute the Montgomery parameters
+   error = mpiMontgomeryInit(&context, p);
+   //Any error to report?
+   if(error) return error;
+
+   //Perform modular exponentiation
+   error = mpiMontgomeryExpMod(&context, x, a, e, TRUE);
+
+   //Release Montgomery context
+   mpiMontgomeryFree(&context);
 
    //Return status code
    return error;
@@ -1430,6 +1630,1501 @@ end:
 }
 
 
+/**
+ * @brief Load a multiple precision integer into a limb array
+ * @param[out] r Limb array
+ * @param[in] n Size of the limb array
+ * @param[in] a Pointer to a multiple precision integer
+ * @param[in] offset Index of the first limb to be loaded
+ **/
+
+static void mpiLoadLimbs(MpiLimb *r, uint_t n, const Mpi *a, uint_t offset)
+{
+   uint_t i;
+   uint_t j;
+   uint_t k;
+
+   //Process each limb
+   for(i = 0; i < n; i++)
+   {
+      //Clear current limb
+      r[i] = 0;
+
+      //Each limb is made of one or several words
+      for(j = 0; j < MPI_LIMB_WORDS; j++)
+      {
+         //Index of the current word
+         k = (offset + i) * MPI_LIMB_WORDS + j;
+
+         //Out of range words are assumed to be zero
+         if(k < a->size)
+            r[i] |= (MpiLimb) a->data[k] << (j * MPI_INT_SIZE * 8);
+      }
+   }
+}
+
+
+/**
+ * @brief Store a limb array into a multiple precision integer
+ * @param[out] x Pointer to a multiple precision integer
+ * @param[in] r Limb array
+ * @param[in] n Size of the limb array
+ * @return Error code
+ **/
+
+static error_t mpiStoreLimbs(Mpi *x, const MpiLimb *r, uint_t n)
+{
+   error_t error;
+   uint_t i;
+
+   //Adjust the size of the destination operand
+   error = mpiGrow(x, n * MPI_LIMB_WORDS);
+   //Any error to report?
+   if(error) return error;
+
+   //Clear the contents of X
+   memset(x->data, 0, x->size * MPI_INT_SIZE);
+   //The result is always positive
+   x->sign = 1;
+
+   //Copy the words of each limb
+   for(i = 0; i < (n * MPI_LIMB_WORDS); i++)
+      x->data[i] = (uint_t) (r[i / MPI_LIMB_WORDS] >> ((i % MPI_LIMB_WORDS) * MPI_INT_SIZE * 8));
+
+   //Successful operation
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Multiplication of limb arrays (R = A * B)
+ *
+ * The product is computed column by column (Comba method), so that each
+ * limb of the result is written only once. R must not overlap A or B
+ *
+ * @param[out] r Resulting limb array (m + n limbs)
+ * @param[in] a First operand
+ * @param[in] m Size of the first operand, in limbs
+ * @param[in] b Second operand
+ * @param[in] n Size of the second operand, in limbs
+ **/
+
+static void mpiMulLimbs(MpiLimb *r, const MpiLimb *a, uint_t m,
+   const MpiLimb *b, uint_t n)
+{
+   uint_t i;
+   uint_t k;
+   MpiLimb c0;
+   MpiLimb c1;
+   MpiLimb c2;
+
+   //Clear the column accumulator
+   c0 = 0;
+   c1 = 0;
+   c2 = 0;
+
+   //Process each column of the product
+   for(k = 0; k < (m + n - 1); k++)
+   {
+      //Accumulate the products A[i] * B[k - i]
+      for(i = (k >= n) ? (k - n + 1) : 0; i <= k && i < m; i++)
+         MPI_MUL_ACC(c0, c1, c2, a[i], b[k - i]);
+
+      //Save the current limb and shift the accumulator
+      r[k] = c0;
+      c0 = c1;
+      c1 = c2;
+      c2 = 0;
+   }
+
+   //Save the most significant limb
+   r[m + n - 1] = c0;
+}
+
+
+/**
+ * @brief Squaring of a limb array (R = A^2)
+ *
+ * Each cross product A[i] * A[j] with i < j is computed once, then the
+ * sum of the cross products is doubled and the square terms are added,
+ * which saves almost half of the multiplications. R must not overlap A
+ *
+ * @param[out] r Resulting limb array (2 * n limbs)
+ * @param[in] a Operand
+ * @param[in] n Size of the operand, in limbs
+ **/
+
+static void mpiSqrLimbs(MpiLimb *r, const MpiLimb *a, uint_t n)
+{
+   uint_t i;
+   uint_t j;
+   MpiLimb c;
+   MpiLimb u;
+   MpiDoubleLimb d;
+
+   //Let R = 0
+   memset(r, 0, 2 * n * sizeof(MpiLimb));
+
+   //Compute the sum of the cross products A[i] * A[j] with i < j
+   for(i = 0; i < n; i++)
+   {
+      for(c = 0, j = i + 1; j < n; j++)
+         MPI_MUL_ADD(r[i + j], c, a[i], a[j]);
+
+      r[i + n] = c;
+   }
+
+   //Double the cross products
+   for(c = 0, i = 0; i < (2 * n); i++)
+   {
+      u = r[i];
+      r[i] = (u << 1) | c;
+      c = u >> (MPI_LIMB_SIZE - 1);
+   }
+
+   //Add the square terms A[i]^2
+   for(c = 0, i = 0; i < n; i++)
+   {
+      d = (MpiDoubleLimb) a[i] * a[i] + r[2 * i] + c;
+      r[2 * i] = (MpiLimb) d;
+      d = (d >> MPI_LIMB_SIZE) + r[2 * i + 1];
+      r[2 * i + 1] = (MpiLimb) d;
+      c = (MpiLimb) (d >> MPI_LIMB_SIZE);
+   }
+}
+
+
+/**
+ * @brief Absolute difference of limb arrays (R = |A - B|)
+ *
+ * The computation is performed in constant time
+ *
+ * @param[out] r Resulting limb array (m limbs)
+ * @param[in] a First operand
+ * @param[in] m Size of the first operand, in limbs
+ * @param[in] b Second operand
+ * @param[in] n Size of the second operand, in limbs (n <= m)
+ * @return All ones if A is lower than B, zero otherwise
+ **/
+
+static MpiLimb mpiAbsDiffLimbs(MpiLimb *r, const MpiLimb *a, uint_t m,
+   const MpiLimb *b, uint_t n)
+{
+   uint_t i;
+   MpiLimb c;
+   MpiLimb mask;
+   MpiDoubleLimb d;
+
+   //Compute R = A - B
+   for(c = 0, i = 0; i < m; i++)
+   {
+      d = (MpiDoubleLimb) a[i] - ((i < n) ? b[i] : 0) - c;
+      r[i] = (MpiLimb) d;
+      c = (MpiLimb) (d >> MPI_LIMB_SIZE) & 1;
+   }
+
+   //The mask is all ones if the subtraction borrowed
+   mask = 0 - c;
+
+   //Conditional negation (R = ~R + 1)
+   for(i = 0; i < m; i++)
+   {
+      d = (MpiDoubleLimb) (r[i] ^ mask) + c;
+      r[i] = (MpiLimb) d;
+      c = (MpiLimb) (d >> MPI_LIMB_SIZE);
+   }
+
+   //Return the sign of the difference
+   return mask;
+}
+
+
+/**
+ * @brief Middle term of Karatsuba multiplication
+ *
+ * Given R = A0 * B0 + A1 * B1 * 2^(2 * w * l) and Z = |A0 - A1| * |B0 - B1|,
+ * the term A0 * B1 + A1 * B0 = A0 * B0 + A1 * B1 -/+ Z is added to R at
+ * offset l
+ *
+ * @param[in,out] r Product being computed (2 * n limbs)
+ * @param[in] n Size of the operands, in limbs
+ * @param[in] l Size of the lower halves, in limbs
+ * @param[in] z Product of the differences (2 * l limbs)
+ * @param[in] mask All ones if Z must be added, zero if Z must be subtracted
+ * @param[in] s Temporary buffer (2 * l + 1 limbs)
+ **/
+
+static void mpiKaratsubaMiddleLimbs(MpiLimb *r, uint_t n, uint_t l,
+   const MpiLimb *z, MpiLimb mask, MpiLimb *s)
+{
+   uint_t i;
+   uint_t h;
+   MpiLimb c;
+   MpiDoubleLimb d;
+
+   //Size of the upper halves
+   h = n - l;
+
+   //Compute S = A0 * B0 + A1 * B1
+   for(c = 0, i = 0; i < (2 * l); i++)
+   {
+      d = (MpiDoubleLimb) r[i] + ((i < (2 * h)) ? r[2 * l + i] : 0) + c;
+      s[i] = (MpiLimb) d;
+      c = (MpiLimb) (d >> MPI_LIMB_SIZE);
+   }
+
+   s[2 * l] = c;
+
+   //Compute S = S + Z or S = S + ~Z + 1, in constant time
+   for(c = ~mask & 1, i = 0; i <= (2 * l); i++)
+   {
+      d = (MpiDoubleLimb) s[i] + (((i < (2 * l)) ? z[i] : 0) ^ ~mask) + c;
+      s[i] = (MpiLimb) d;
+      c = (MpiLimb) (d >> MPI_LIMB_SIZE);
+   }
+
+   //The middle term fits in n + 1 limbs. Add it to R at offset l
+   for(c = 0, i = l; i < (2 * n); i++)
+   {
+      d = (MpiDoubleLimb) r[i] + (((i - l) <= (2 * l)) ? s[i - l] : 0) + c;
+      r[i] = (MpiLimb) d;
+      c = (MpiLimb) (d >> MPI_LIMB_SIZE);
+   }
+}
+
+
+/**
+ * @brief Karatsuba multiplication of limb arrays (R = A * B)
+ *
+ * The operands are split in two halves, and three half-size products are
+ * computed recursively. The Comba method is used below the threshold.
+ * R must not overlap A or B
+ *
+ * @param[out] r Resulting limb array (2 * n limbs)
+ * @param[in] a First operand
+ * @param[in] b Second operand
+ * @param[in] n Size of the operands, in limbs
+ * @param[in] t Temporary buffer (see mpiGetKaratsubaTempSize)
+ **/
+
+static void mpiKaratsubaMulLimbs(MpiLimb *r, const MpiLimb *a,
+   const MpiLimb *b, uint_t n, MpiLimb *t)
+{
+   uint_t l;
+   MpiLimb mask;
+   MpiLimb *da;
+   MpiLimb *db;
+   MpiLimb *z;
+   MpiLimb *s;
+
+   //Small operands?
+   if(n < MPI_KARATSUBA_THRESHOLD)
+   {
+      mpiMulLimbs(r, a, n, b, n);
+      return;
+   }
+
+   //Size of the lower halves
+   l = (n + 1) / 2;
+
+   //Split the temporary buffer
+   da = t;
+   db = da + l;
+   z = db + l;
+   s = z + 2 * l;
+   t = s + 2 * l + 1;
+
+   //Compute A0 * B0 and A1 * B1
+   mpiKaratsubaMulLimbs(r, a, b, l, t);
+   mpiKaratsubaMulLimbs(r + 2 * l, a + l, b + l, n - l, t);
+
+   //Compute Z = |A0 - A1| * |B0 - B1|
+   mask = mpiAbsDiffLimbs(da, a, l, a + l, n - l);
+   mask ^= mpiAbsDiffLimbs(db, b, l, b + l, n - l);
+   mpiKaratsubaMulLimbs(z, da, db, l, t);
+
+   //(A0 - A1) * (B0 - B1) is negative when exactly one difference is
+   mpiKaratsubaMiddleLimbs(r, n, l, z, mask, s);
+}
+
+
+/**
+ * @brief Karatsuba squaring of a limb array (R = A^2)
+ * @param[out] r Resulting limb array (2 * n limbs)
+ * @param[in] a Operand
+ * @param[in] n Size of the operand, in limbs
+ * @param[in] t Temporary buffer (see mpiGetKaratsubaTempSize)
+ **/
+
+static void mpiKaratsubaSqrLimbs(MpiLimb *r, const MpiLimb *a,
+   uint_t n, MpiLimb *t)
+{
+   uint_t l;
+   MpiLimb *da;
+   MpiLimb *z;
+   MpiLimb *s;
+
+   //Small operand?
+   if(n < MPI_KARATSUBA_THRESHOLD)
+   {
+      mpiSqrLimbs(r, a, n);
+      return;
+   }
+
+   //Size of the lower half
+   l = (n + 1) / 2;
+
+   //Split the temporary buffer
+   da = t;
+   z = da + 2 * l;
+   s = z + 2 * l;
+   t = s + 2 * l + 1;
+
+   //Compute A0^2 and A1^2
+   mpiKaratsubaSqrLimbs(r, a, l, t);
+   mpiKaratsubaSqrLimbs(r + 2 * l, a + l, n - l, t);
+
+   //Compute Z = (A0 - A1)^2
+   mpiAbsDiffLimbs(da, a, l, a + l, n - l);
+   mpiKaratsubaSqrLimbs(z, da, l, t);
+
+   //The middle term is A0^2 + A1^2 - Z
+   mpiKaratsubaMiddleLimbs(r, n, l, z, 0, s);
+}
+
+
+/**
+ * @brief Size of the temporary buffer used by Karatsuba multiplication
+ * @param[in] n Size of the operands, in limbs
+ * @return Size of the temporary buffer, in limbs
+ **/
+
+static uint_t mpiGetKaratsubaTempSize(uint_t n)
+{
+   uint_t size;
+
+   //Each level of recursion requires 6 * l + 1 limbs
+   for(size = 0; n >= MPI_KARATSUBA_THRESHOLD; )
+   {
+      n = (n + 1) / 2;
+      size += 6 * n + 1;
+   }
+
+   //Return the size of the buffer
+   return size;
+}
+
+
+/**
+ * @brief Modular addition of limb arrays (R = A + B mod P)
+ * @param[in] context Pointer to the Montgomery context
+ * @param[out] r Resulting limb array
+ * @param[in] a First operand, lower than P
+ * @param[in] b Second operand, lower than P
+ * @param[in] t Temporary buffer (n limbs)
+ **/
+
+static void mpiAddModLimbs(MpiMontgomeryContext *context,
+   MpiLimb *r, const MpiLimb *a, const MpiLimb *b, MpiLimb *t)
+{
+   uint_t i;
+   MpiLimb c;
+   MpiLimb mask;
+   MpiDoubleLimb d;
+
+   //Compute T = A + B
+   for(c = 0, i = 0; i < context->n; i++)
+   {
+      d = (MpiDoubleLimb) a[i] + b[i] + c;
+      t[i] = (MpiLimb) d;
+      c = (MpiLimb) (d >> MPI_LIMB_SIZE);
+   }
+
+   //Compute R = T - P
+   for(mask = 0, i = 0; i < context->n; i++)
+   {
+      d = (MpiDoubleLimb) t[i] - context->p[i] - mask;
+      r[i] = (MpiLimb) d;
+      mask = (MpiLimb) (d >> MPI_LIMB_SIZE) & 1;
+   }
+
+   //Keep T if the subtraction borrowed and the addition did not carry
+   mask = 0 - (mask & (c ^ 1));
+
+   //Constant-time selection
+   for(i = 0; i < context->n; i++)
+      r[i] = (t[i] & mask) | (r[i] & ~mask);
+}
+
+
+/**
+ * @brief Size of the temporary buffer used by Montgomery multiplication
+ * @param[in] n Size of the modulus, in limbs
+ * @return Size of the temporary buffer, in limbs
+ **/
+
+static uint_t mpiGetMontgomeryTempSize(uint_t n)
+{
+   //The double-length product is followed by the Karatsuba work area
+   return 2 * n + 2 + mpiGetKaratsubaTempSize(n);
+}
+
+
+/**
+ * @brief Montgomery reduction of a limb array (R = T / 2^(w * n) mod P)
+ *
+ * The final subtraction is performed in constant time
+ *
+ * @param[in] context Pointer to the Montgomery context
+ * @param[out] r Resulting limb array
+ * @param[in,out] t Double-length value to be reduced, lower than P * 2^(w * n)
+ **/
+
+static void mpiMontgomeryRedLimbs(MpiMontgomeryContext *context,
+   MpiLimb *r, MpiLimb *t)
+{
+   uint_t i;
+   uint_t j;
+   uint_t n;
+   MpiLimb c;
+   MpiLimb c2;
+   MpiLimb m;
+   MpiLimb mask;
+   MpiDoubleLimb d;
+   const MpiLimb *p;
+
+   //Size of the modulus
+   n = context->n;
+   p = context->p;
+
+   //Clear the limb that is shifted out of T
+   c2 = 0;
+
+   //Process each limb of T
+   for(i = 0; i < n; i++)
+   {
+      //Compute M = T[i] * (-1/P) mod 2^w
+      m = t[i] * context->m0;
+
+      //Compute T = T + M * P * 2^(w * i)
+      for(c = 0, j = 0; j < n; j++)
+         MPI_MUL_ADD(t[i + j], c, m, p[j]);
+
+      //Propagate the carry
+      d = (MpiDoubleLimb) t[i + n] + c + c2;
+      t[i + n] = (MpiLimb) d;
+      c2 = (MpiLimb) (d >> MPI_LIMB_SIZE);
+   }
+
+   //T / 2^(w * n) is lower than 2P. Compute R = T / 2^(w * n) - P
+   for(c = 0, j = 0; j < n; j++)
+   {
+      d = (MpiDoubleLimb) t[n + j] - p[j] - c;
+      r[j] = (MpiLimb) d;
+      c = (MpiLimb) (d >> MPI_LIMB_SIZE) & 1;
+   }
+
+   //Keep T / 2^(w * n) if it is lower than P
+   mask = 0 - (c & (c2 ^ 1));
+
+   //Constant-time selection
+   for(j = 0; j < n; j++)
+      r[j] = (t[n + j] & mask) | (r[j] & ~mask);
+}
+
+
+/**
+ * @brief Montgomery squaring of a limb array (R = A^2 / 2^(w * n) mod P)
+ * @param[in] context Pointer to the Montgomery context
+ * @param[out] r Resulting limb array
+ * @param[in] a Operand, lower than P
+ * @param[in] t Temporary buffer (see mpiGetMontgomeryTempSize)
+ **/
+
+static void mpiMontgomerySqrLimbs(MpiMontgomeryContext *context,
+   MpiLimb *r, const MpiLimb *a, MpiLimb *t)
+{
+   //Compute T = A^2
+   mpiKaratsubaSqrLimbs(t, a, context->n, t + 2 * context->n + 2);
+   //Compute R = T / 2^(w * n) mod P
+   mpiMontgomeryRedLimbs(context, r, t);
+}
+
+
+/**
+ * @brief Montgomery multiplication of limb arrays (R = A * B / 2^(w * n) mod P)
+ *
+ * The multiplication and the reduction are interleaved (CIOS method). Large
+ * moduli use Karatsuba multiplication followed by a separate reduction. The
+ * final subtraction is performed in constant time. R may point to A or B
+ *
+ * @param[in] context Pointer to the Montgomery context
+ * @param[out] r Resulting limb array
+ * @param[in] a First operand
+ * @param[in] b Second operand, lower than P
+ * @param[in] t Temporary buffer (see mpiGetMontgomeryTempSize)
+ **/
+
+static void mpiMontgomeryMulLimbs(MpiMontgomeryContext *context,
+   MpiLimb *r, const MpiLimb *a, const MpiLimb *b, MpiLimb *t)
+{
+   uint_t i;
+   uint_t j;
+   uint_t n;
+   MpiLimb c;
+   MpiLimb m;
+   MpiLimb u;
+   MpiLimb mask;
+   MpiDoubleLimb d;
+   const MpiLimb *p;
+
+   //Size of the modulus
+   n = context->n;
+   p = context->p;
+
+   //Large modulus?
+   if(n >= MPI_KARATSUBA_THRESHOLD)
+   {
+      //Compute T = A * B
+      mpiKaratsubaMulLimbs(t, a, b, n, t + 2 * n + 2);
+      //Compute R = T / 2^(w * n) mod P
+      mpiMontgomeryRedLimbs(context, r, t);
+      return;
+   }
+
+   //Let T = 0
+   memset(t, 0, (n + 2) * sizeof(MpiLimb));
+
+   //Process each limb of B
+   for(i = 0; i < n; i++)
+   {
+      //Compute T = T + A * B[i]
+      for(c = 0, j = 0; j < n; j++)
+         MPI_MUL_ADD(t[j], c, a[j], b[i]);
+
+      d = (MpiDoubleLimb) t[n] + c;
+      t[n] = (MpiLimb) d;
+      t[n + 1] = (MpiLimb) (d >> MPI_LIMB_SIZE);
+
+      //Compute M = T[0] * (-1/P) mod 2^w
+      m = t[0] * context->m0;
+
+      //Compute T = (T + M * P) / 2^w
+      d = (MpiDoubleLimb) m * p[0] + t[0];
+      c = (MpiLimb) (d >> MPI_LIMB_SIZE);
+
+      for(j = 1; j < n; j++)
+      {
+         u = t[j];
+         MPI_MUL_ADD(u, c, m, p[j]);
+         t[j - 1] = u;
+      }
+
+      d = (MpiDoubleLimb) t[n] + c;
+      t[n - 1] = (MpiLimb) d;
+      t[n] = t[n + 1] + (MpiLimb) (d >> MPI_LIMB_SIZE);
+   }
+
+   //T is lower than 2P. Compute R = T - P
+   for(c = 0, j = 0; j < n; j++)
+   {
+      d = (MpiDoubleLimb) t[j] - p[j] - c;
+      r[j] = (MpiLimb) d;
+      c = (MpiLimb) (d >> MPI_LIMB_SIZE) & 1;
+   }
+
+   //Keep T if T is lower than P
+   mask = 0 - (c & (t[n] ^ 1));
+
+   //Constant-time selection
+   for(j = 0; j < n; j++)
+      r[j] = (t[j] & mask) | (r[j] & ~mask);
+}
+
+
+/**
+ * @brief Conversion to Montgomery form (R = A * 2^(w * n) mod P)
+ *
+ * A may be larger than P. It is processed n limbs at a time using
+ * Horner's rule, starting with the most significant chunk
+ *
+ * @param[in] context Pointer to the Montgomery context
+ * @param[out] r Resulting limb array
+ * @param[in] a Pointer to a non-negative multiple precision integer
+ * @param[in] b Temporary buffer (n limbs)
+ * @param[in] t Temporary buffer (see mpiGetMontgomeryTempSize)
+ **/
+
+static void mpiMontgomeryImportLimbs(MpiMontgomeryContext *context,
+   MpiLimb *r, const Mpi *a, MpiLimb *b, MpiLimb *t)
+{
+   int_t j;
+   uint_t l;
+   uint_t n;
+
+   //Size of the modulus, in limbs
+   n = context->n;
+
+   //Number of limbs in A
+   l = (mpiGetLength(a) + MPI_LIMB_WORDS - 1) / MPI_LIMB_WORDS;
+   //Number of n-limb chunks in A
+   j = max((l + n - 1) / n, 1);
+
+   //Convert the most significant chunk of A to Montgomery form
+   mpiLoadLimbs(b, n, a, (j - 1) * n);
+   mpiMontgomeryMulLimbs(context, r, b, context->r2, t);
+
+   //Process the remaining chunks
+   for(j = j - 2; j >= 0; j--)
+   {
+      //Multiply the intermediate result by R
+      mpiMontgomeryMulLimbs(context, r, r, context->r2, t);
+      //Convert the current chunk to Montgomery form
+      mpiLoadLimbs(b, n, a, j * n);
+      mpiMontgomeryMulLimbs(context, b, b, context->r2, t);
+      //Accumulate the result
+      mpiAddModLimbs(context, r, r, b, t);
+   }
+}
+
+
+/**
+ * @brief Constant-time table lookup
+ *
+ * Every entry of the table is read, regardless of the index
+ *
+ * @param[out] r Selected limb array
+ * @param[in] table Table of limb arrays
+ * @param[in] tableSize Number of entries in the table
+ * @param[in] n Size of each entry, in limbs
+ * @param[in] index Index of the entry to be selected
+ **/
+
+static void mpiSelectLimbs(MpiLimb *r, const MpiLimb *table,
+   uint_t tableSize, uint_t n, uint_t index)
+{
+   uint_t i;
+   uint_t j;
+   MpiLimb mask;
+
+   //Clear the resulting limb array
+   memset(r, 0, n * sizeof(MpiLimb));
+
+   //Loop through the table
+   for(i = 0; i < tableSize; i++)
+   {
+      //The mask is all ones if the entry matches the index
+      mask = 0 - (MpiLimb) ((((uint32_t) i ^ index) - 1) >> 31);
+
+      //Accumulate the selected entry
+      for(j = 0; j < n; j++)
+         r[j] |= table[i * n + j] & mask;
+   }
+}
+
+
+/**
+ * @brief Select the window size for modular exponentiation
+ * @param[in] bits Length of the exponent, in bits
+ * @return Window size
+ **/
+
+static uint_t mpiGetWindowSize(uint_t bits)
+{
+   uint_t k;
+
+   //Select the window size that minimizes the number of multiplications
+   if(bits > 671)
+      k = 6;
+   else if(bits > 239)
+      k = 5;
+   else if(bits > 79)
+      k = 4;
+   else if(bits > 23)
+      k = 3;
+   else if(bits > 1)
+      k = 2;
+   else
+      k = 1;
+
+   //The size of the precomputed table is limited
+   return min(k, MPI_MAX_WINDOW_SIZE);
+}
+
+
+/**
+ * @brief Initialize a Montgomery context
+ *
+ * The values that depend only on the modulus (-1/P mod 2^w and R^2 mod P)
+ * are computed once, so that the context can be reused by several
+ * exponentiations with the same modulus
+ *
+ * @param[out] context Pointer to the Montgomery context
+ * @param[in] p Odd modulus P
+ * @return Error code
+ **/
+
+error_t mpiMontgomeryInit(MpiMontgomeryContext *context, const Mpi *p)
+{
+   int_t i;
+   uint_t n;
+   uint_t k;
+   MpiLimb m;
+   MpiLimb *b;
+   MpiLimb *t;
+
+   //Initialize context
+   context->n = 0;
+   context->p = NULL;
+   context->r2 = NULL;
+
+   //The modulus must be odd and greater than one
+   if(mpiCompInt(p, 1) <= 0 || mpiIsEven(p))
+      return ERROR_INVALID_PARAMETER;
+
+   //Size of the modulus, in limbs
+   n = (mpiGetLength(p) + MPI_LIMB_WORDS - 1) / MPI_LIMB_WORDS;
+
+   //Allocate a memory buffer to hold P and R^2 mod P
+   context->p = osMemAlloc(2 * n * sizeof(MpiLimb));
+   //Failed to allocate memory?
+   if(!context->p) return ERROR_OUT_OF_MEMORY;
+
+   //Allocate a temporary buffer
+   b = osMemAlloc((n + mpiGetMontgomeryTempSize(n)) * sizeof(MpiLimb));
+
+   //Failed to allocate memory?
+   if(!b)
+   {
+      //Clean up side effects
+      osMemFree(context->p);
+      context->p = NULL;
+      //Report an error
+      return ERROR_OUT_OF_MEMORY;
+   }
+
+   //Save the size of the modulus
+   context->n = n;
+   //Point to the precomputed value R^2 mod P
+   context->r2 = context->p + n;
+   //Point to the temporary buffer used by Montgomery multiplication
+   t = b + n;
+
+   //Load the modulus
+   mpiLoadLimbs(context->p, n, p, 0);
+
+   //Use Newton's method to compute the inverse of P[0] mod 2^w
+   for(m = context->p[0], i = 0; i < 5; i++)
+      m = m * (2 - m * context->p[0]);
+
+   //Precompute -1/P[0] mod 2^w
+   context->m0 = 0 - m;
+
+   //Bit length of the modulus
+   k = mpiGetBitLength(p);
+
+   //Let X = 2^(k - 1), which is lower than P
+   memset(context->r2, 0, n * sizeof(MpiLimb));
+   context->r2[(k - 1) / MPI_LIMB_SIZE] = (MpiLimb) 1 << ((k - 1) % MPI_LIMB_SIZE);
+
+   //Compute X = R mod P (1 in Montgomery form) by successive modular doublings
+   for(i = k - 1; i < (int_t) (n * MPI_LIMB_SIZE); i++)
+      mpiAddModLimbs(context, context->r2, context->r2, context->r2, t);
+
+   //Compute B = 2 * R mod P (2 in Montgomery form)
+   mpiAddModLimbs(context, b, context->r2, context->r2, t);
+
+   //Compute X = 2^(w * n) * R mod P = R^2 mod P by binary exponentiation
+   //in the Montgomery domain
+   for(i = 31; i >= 0; i--)
+   {
+      //Skip leading zeros
+      if(((n * MPI_LIMB_SIZE) >> i) == 0)
+         continue;
+
+      //Compute X = X^2
+      mpiMontgomerySqrLimbs(context, context->r2, context->r2, t);
+
+      //Compute X = X * 2
+      if(((n * MPI_LIMB_SIZE) >> i) & 1)
+         mpiMontgomeryMulLimbs(context, context->r2, context->r2, b, t);
+   }
+
+   //Erase contents before releasing memory
+   memset(b, 0, (n + mpiGetMontgomeryTempSize(n)) * sizeof(MpiLimb));
+   osMemFree(b);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Release a Montgomery context
+ * @param[in] context Pointer to the Montgomery context
+ **/
+
+void mpiMontgomeryFree(MpiMontgomeryContext *context)
+{
+   //Any memory previously allocated?
+   if(context->p != NULL)
+   {
+      //Erase contents before releasing memory
+      memset(context->p, 0, 2 * context->n * sizeof(MpiLimb));
+      osMemFree(context->p);
+   }
+
+   //Clear context
+   context->n = 0;
+   context->p = NULL;
+   context->r2 = NULL;
+}
+
+
+/**
+ * @brief Modular multiplication using a Montgomery context
+ * @param[in] context Pointer to the Montgomery context
+ * @param[out] x Resulting integer X = A * B mod P
+ * @param[in] a First operand (non-negative)
+ * @param[in] b Second operand (non-negative, lower than P)
+ * @return Error code
+ **/
+
+error_t mpiMontgomeryMulMod(MpiMontgomeryContext *context, Mpi *x,
+   const Mpi *a, const Mpi *b)
+{
+   error_t error;
+   uint_t n;
+   MpiLimb *buffer;
+   MpiLimb *acc;
+   MpiLimb *c;
+   MpiLimb *t;
+
+   //Check parameters
+   if(context->p == NULL || a->sign < 0 || b->sign < 0)
+      return ERROR_INVALID_PARAMETER;
+
+   //Size of the modulus, in limbs
+   n = context->n;
+
+   //Allocate a memory buffer to hold the temporary values
+   buffer = osMemAlloc((2 * n + mpiGetMontgomeryTempSize(n)) * sizeof(MpiLimb));
+   //Failed to allocate memory?
+   if(!buffer) return ERROR_OUT_OF_MEMORY;
+
+   //Split the buffer
+   acc = buffer;
+   c = acc + n;
+   t = c + n;
+
+   //Compute A * R mod P
+   mpiMontgomeryImportLimbs(context, acc, a, c, t);
+
+   //Compute (A * R) * B / R mod P = A * B mod P
+   mpiLoadLimbs(c, n, b, 0);
+   mpiMontgomeryMulLimbs(context, acc, acc, c, t);
+
+   //Copy the result
+   error = mpiStoreLimbs(x, acc, n);
+
+   //Erase contents before releasing memory
+   memset(buffer, 0, (2 * n + mpiGetMontgomeryTempSize(n)) * sizeof(MpiLimb));
+   osMemFree(buffer);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Windowed modular exponentiation
+ *
+ * All the intermediate values are held in a single buffer of fixed-size
+ * limb arrays that is allocated before the exponentiation starts
+ *
+ * @param[in] context Pointer to the Montgomery context
+ * @param[out] x Resulting integer X = A ^ E mod P
+ * @param[in] a Base A (non-negative)
+ * @param[in] e Exponent E
+ * @param[in] regular Use the constant-time fixed window method (TRUE)
+ *   or the sliding window method (FALSE)
+ * @param[in] bits Number of exponent bits to process
+ * @return Error code
+ **/
+
+static error_t mpiMontgomeryExpModWindow(MpiMontgomeryContext *context,
+   Mpi *x, const Mpi *a, const Mpi *e, bool_t regular, uint_t bits)
+{
+   error_t error;
+   int_t i;
+   int_t j;
+   int_t l;
+   uint_t k;
+   uint_t n;
+   uint_t u;
+   uint_t tableSize;
+   MpiLimb *buffer;
+   MpiLimb *table;
+   MpiLimb *acc;
+   MpiLimb *b;
+   MpiLimb *t;
+
+   //Check parameters
+   if(context->p == NULL || a->sign < 0)
+      return ERROR_INVALID_PARAMETER;
+
+   //Size of the modulus, in limbs
+   n = context->n;
+
+   //Select the window size
+   k = mpiGetWindowSize(bits);
+
+   //The sliding window method only requires the odd powers of A
+   tableSize = regular ? (1 << k) : (1 << (k - 1));
+
+   //Allocate a memory buffer to hold the precomputed table and the
+   //temporary values
+   buffer = osMemAlloc(((tableSize + 2) * n + mpiGetMontgomeryTempSize(n)) * sizeof(MpiLimb));
+   //Failed to allocate memory?
+   if(!buffer) return ERROR_OUT_OF_MEMORY;
+
+   //Split the buffer
+   table = buffer;
+   acc = table + tableSize * n;
+   b = acc + n;
+   t = b + n;
+
+   //Compute A * R mod P
+   mpiMontgomeryImportLimbs(context, acc, a, b, t);
+
+   //Let B = 1
+   memset(b, 0, n * sizeof(MpiLimb));
+   b[0] = 1;
+
+   //Fixed window method?
+   if(regular)
+   {
+      //Let T(0) = R mod P (1 in Montgomery form)
+      mpiMontgomeryMulLimbs(context, table, context->r2, b, t);
+      //Let T(1) = A * R mod P
+      memcpy(table + n, acc, n * sizeof(MpiLimb));
+
+      //Precompute T(i) = A^i * R mod P
+      for(u = 2; u < tableSize; u++)
+         mpiMontgomeryMulLimbs(context, table + u * n, table + (u - 1) * n, acc, t);
+
+      //Let X = 1
+      memcpy(acc, table, n * sizeof(MpiLimb));
+
+      //Process the exponent k bits at a time, regardless of their value
+      for(i = ((bits + k - 1) / k - 1) * k; i >= 0; i -= k)
+      {
+         //Compute X = X^(2^k)
+         for(j = 0; j < (int_t) k; j++)
+            mpiMontgomerySqrLimbs(context, acc, acc, t);
+
+         //Extract the current window
+         for(u = 0, j = k - 1; j >= 0; j--)
+            u = (u << 1) | mpiGetBitValue(e, i + j);
+
+         //Constant-time table lookup
+         mpiSelectLimbs(b, table, tableSize, n, u);
+
+         //Compute X = X * T(u)
+         mpiMontgomeryMulLimbs(context, acc, acc, b, t);
+      }
+
+      //Let B = 1
+      memset(b, 0, n * sizeof(MpiLimb));
+      b[0] = 1;
+   }
+   //Sliding window method?
+   else
+   {
+      //Let T(0) = A * R mod P
+      memcpy(table, acc, n * sizeof(MpiLimb));
+
+      //Precompute the odd powers T(i) = A^(2 * i + 1) * R mod P
+      if(tableSize > 1)
+      {
+         //Compute A^2 * R mod P
+         mpiMontgomerySqrLimbs(context, acc, acc, t);
+
+         for(u = 1; u < tableSize; u++)
+            mpiMontgomeryMulLimbs(context, table + u * n, table + (u - 1) * n, acc, t);
+      }
+
+      //Let X = R mod P (1 in Montgomery form)
+      mpiMontgomeryMulLimbs(context, acc, context->r2, b, t);
+
+      //Scan the exponent from the most significant bit
+      for(i = bits - 1; i >= 0; )
+      {
+         //Squaring only?
+         if(!mpiGetBitValue(e, i))
+         {
+            //Compute X = X^2
+            mpiMontgomerySqrLimbs(context, acc, acc, t);
+            i--;
+         }
+         else
+         {
+            //Find the longest window that ends with a non-zero bit
+            j = max(i - (int_t) k + 1, 0);
+            while(!mpiGetBitValue(e, j)) j++;
+
+            //Extract the value of the window and square X accordingly
+            for(u = 0, l = i; l >= j; l--)
+            {
+               u = (u << 1) | mpiGetBitValue(e, l);
+               mpiMontgomerySqrLimbs(context, acc, acc, t);
+            }
+
+            //Compute X = X * A^u
+            mpiMontgomeryMulLimbs(context, acc, acc, table + (u >> 1) * n, t);
+
+            //Next window
+            i = j - 1;
+         }
+      }
+   }
+
+   //Compute X = X * R^-1 mod P (conversion from Montgomery form)
+   mpiMontgomeryMulLimbs(context, acc, acc, b, t);
+
+   //Copy the result
+   error = mpiStoreLimbs(x, acc, n);
+
+   //Erase contents before releasing memory
+   memset(buffer, 0, ((tableSize + 2) * n + mpiGetMontgomeryTempSize(n)) * sizeof(MpiLimb));
+   osMemFree(buffer);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Modular exponentiation using a Montgomery context
+ *
+ * The regular method processes the full width of the modulus, so that
+ * the running time does not depend on the length of the exponent
+ *
+ * @param[in] context Pointer to the Montgomery context
+ * @param[out] x Resulting integer X = A ^ E mod P
+ * @param[in] a Base A (non-negative)
+ * @param[in] e Exponent E
+ * @param[in] regular Use the constant-time fixed window method (TRUE)
+ *   or the sliding window method (FALSE)
+ * @return Error code
+ **/
+
+error_t mpiMontgomeryExpMod(MpiMontgomeryContext *context, Mpi *x,
+   const Mpi *a, const Mpi *e, bool_t regular)
+{
+   uint_t bits;
+
+   //Length of the exponent, in bits
+   bits = mpiGetBitLength(e);
+
+   //The regular method processes the full width of the modulus
+   if(regular)
+      bits = max(bits, context->n * MPI_LIMB_SIZE);
+
+   //Perform modular exponentiation
+   return mpiMontgomeryExpModWindow(context, x, a, e, regular, bits);
+}
+
+
+/**
+ * @brief Constant-time modular exponentiation with a short exponent
+ *
+ * The fixed window method is applied to the specified number of bits.
+ * The running time only depends on this length, which is assumed to be
+ * public (short Diffie-Hellman private values, for instance)
+ *
+ * @param[in] context Pointer to the Montgomery context
+ * @param[out] x Resulting integer X = A ^ E mod P
+ * @param[in] a Base A (non-negative)
+ * @param[in] e Exponent E
+ * @param[in] bits Public length of the exponent, in bits
+ * @return Error code
+ **/
+
+error_t mpiMontgomeryExpModLength(MpiMontgomeryContext *context, Mpi *x,
+   const Mpi *a, const Mpi *e, uint_t bits)
+{
+   //The exponent shall not be longer than the specified length
+   if(bits == 0 || mpiGetBitLength(e) > bits)
+      return ERROR_INVALID_PARAMETER;
+
+   //Perform modular exponentiation
+   return mpiMontgomeryExpModWindow(context, x, a, e, TRUE, bits);
+}
+
+
+/**
+ * @brief Batch modular exponentiation using a Montgomery context
+ *
+ * Several bases are raised to the same exponent. The bases are processed
+ * in lockstep with the constant-time fixed window method, so that the
+ * exponent is scanned only once and the working sets of all the
+ * exponentiations are held in a single buffer
+ *
+ * @param[in] context Pointer to the Montgomery context
+ * @param[out] x Resulting integers X(i) = A(i) ^ E mod P
+ * @param[in] a Bases A(i) (non-negative)
+ * @param[in] e Exponent E
+ * @param[in] count Number of exponentiations to perform
+ * @return Error code
+ **/
+
+error_t mpiMontgomeryExpModBatch(MpiMontgomeryContext *context, Mpi *x[],
+   const Mpi *a[], const Mpi *e, uint_t count)
+{
+   error_t error;
+   int_t i;
+   int_t j;
+   uint_t k;
+   uint_t m;
+   uint_t n;
+   uint_t u;
+   uint_t bits;
+   uint_t tableSize;
+   size_t size;
+   MpiLimb *buffer;
+   MpiLimb *table;
+   MpiLimb *acc;
+   MpiLimb *b;
+   MpiLimb *t;
+
+   //Check parameters
+   if(context->p == NULL || count == 0)
+      return ERROR_INVALID_PARAMETER;
+
+   //The bases must be non-negative
+   for(m = 0; m < count; m++)
+   {
+      if(a[m]->sign < 0)
+         return ERROR_INVALID_PARAMETER;
+   }
+
+   //Size of the modulus, in limbs
+   n = context->n;
+
+   //The regular method processes the full width of the modulus
+   bits = max(mpiGetBitLength(e), n * MPI_LIMB_SIZE);
+
+   //Select the window size
+   k = mpiGetWindowSize(bits);
+   //Number of entries in each precomputed table
+   tableSize = 1 << k;
+
+   //Each exponentiation requires a precomputed table and an accumulator
+   size = (tableSize + 1) * n;
+
+   //Allocate a memory buffer to hold the working sets and the
+   //temporary values
+   buffer = osMemAlloc((count * size + n + mpiGetMontgomeryTempSize(n)) * sizeof(MpiLimb));
+   //Failed to allocate memory?
+   if(!buffer) return ERROR_OUT_OF_MEMORY;
+
+   //Point to the temporary values
+   b = buffer + count * size;
+   t = b + n;
+
+   //Precompute the table of each base
+   for(m = 0; m < count; m++)
+   {
+      //Point to the working set of the current exponentiation
+      table = buffer + m * size;
+      acc = table + tableSize * n;
+
+      //Compute A * R mod P
+      mpiMontgomeryImportLimbs(context, acc, a[m], b, t);
+
+      //Let B = 1
+      memset(b, 0, n * sizeof(MpiLimb));
+      b[0] = 1;
+
+      //Let T(0) = R mod P (1 in Montgomery form)
+      mpiMontgomeryMulLimbs(context, table, context->r2, b, t);
+      //Let T(1) = A * R mod P
+      memcpy(table + n, acc, n * sizeof(MpiLimb));
+
+      //Precompute T(i) = A^i * R mod P
+      for(u = 2; u < tableSize; u++)
+         mpiMontgomeryMulLimbs(context, table + u * n, table + (u - 1) * n, acc, t);
+
+      //Let X = 1
+      memcpy(acc, table, n * sizeof(MpiLimb));
+   }
+
+   //Process the exponent k bits at a time, regardless of their value
+   for(i = ((bits + k - 1) / k - 1) * k; i >= 0; i -= k)
+   {
+      //Extract the current window (shared by all the exponentiations)
+      for(u = 0, j = k - 1; j >= 0; j--)
+         u = (u << 1) | mpiGetBitValue(e, i + j);
+
+      //Advance each exponentiation by one window
+      for(m = 0; m < count; m++)
+      {
+         //Point to the working set of the current exponentiation
+         table = buffer + m * size;
+         acc = table + tableSize * n;
+
+         //Compute X = X^(2^k)
+         for(j = 0; j < (int_t) k; j++)
+            mpiMontgomerySqrLimbs(context, acc, acc, t);
+
+         //Constant-time table lookup
+         mpiSelectLimbs(b, table, tableSize, n, u);
+
+         //Compute X = X * T(u)
+         mpiMontgomeryMulLimbs(context, acc, acc, b, t);
+      }
+   }
+
+   //Let B = 1
+   memset(b, 0, n * sizeof(MpiLimb));
+   b[0] = 1;
+
+   //Initialize status code
+   error = NO_ERROR;
+
+   //Retrieve the results
+   for(m = 0; m < count && !error; m++)
+   {
+      //Point to the accumulator of the current exponentiation
+      acc = buffer + m * size + tableSize * n;
+
+      //Compute X = X * R^-1 mod P (conversion from Montgomery form)
+      mpiMontgomeryMulLimbs(context, acc, acc, b, t);
+
+      //Copy the result
+      error = mpiStoreLimbs(x[m], acc, n);
+   }
+
+   //Erase contents before releasing memory
+   memset(buffer, 0, (count * size + n + mpiGetMontgomeryTempSize(n)) * sizeof(MpiLimb));
+   osMemFree(buffer);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Precompute a fixed-base comb table
+ * @param[in] context Pointer to the Montgomery context
+ * @param[out] comb Pointer to the comb table
+ * @param[in] g Fixed base G (non-negative)
+ * @param[in] bits Maximum length of the exponents, in bits
+ * @return Error code
+ **/
+
+error_t mpiCombInit(MpiMontgomeryContext *context, MpiCombTable *comb,
+   const Mpi *g, uint_t bits)
+{
+   uint_t i;
+   uint_t j;
+   uint_t n;
+   uint_t h;
+   uint_t d;
+   MpiLimb *buffer;
+   MpiLimb *base;
+   MpiLimb *b;
+   MpiLimb *t;
+
+   //Initialize comb table
+   comb->n = 0;
+   comb->h = 0;
+   comb->d = 0;
+   comb->table = NULL;
+
+   //Check parameters
+   if(context->p == NULL || g->sign < 0 || bits == 0)
+      return ERROR_INVALID_PARAMETER;
+
+   //Size of the modulus, in limbs
+   n = context->n;
+   //Number of teeth
+   h = MPI_COMB_TEETH;
+   //Distance between two teeth
+   d = (bits + h - 1) / h;
+
+   //Allocate a memory buffer to hold the comb table
+   comb->table = osMemAlloc((1 << h) * n * sizeof(MpiLimb));
+   //Failed to allocate memory?
+   if(!comb->table) return ERROR_OUT_OF_MEMORY;
+
+   //Allocate a memory buffer to hold the temporary values
+   buffer = osMemAlloc((2 * n + mpiGetMontgomeryTempSize(n)) * sizeof(MpiLimb));
+
+   //Failed to allocate memory?
+   if(!buffer)
+   {
+      //Clean up side effects
+      osMemFree(comb->table);
+      comb->table = NULL;
+      //Report an error
+      return ERROR_OUT_OF_MEMORY;
+   }
+
+   //Split the buffer
+   base = buffer;
+   b = base + n;
+   t = b + n;
+
+   //Compute G * R mod P
+   mpiMontgomeryImportLimbs(context, base, g, b, t);
+
+   //Let B = 1
+   memset(b, 0, n * sizeof(MpiLimb));
+   b[0] = 1;
+
+   //Let T(0) = R mod P (1 in Montgomery form)
+   mpiMontgomeryMulLimbs(context, comb->table, context->r2, b, t);
+
+   //Process each tooth
+   for(i = 0; i < h; i++)
+   {
+      //Compute G^(2^(i * d)) * R mod P
+      for(j = 0; i > 0 && j < d; j++)
+         mpiMontgomerySqrLimbs(context, base, base, t);
+
+      //The entries whose bit i is set are derived from the previous ones
+      for(j = 0; j < (1U << i); j++)
+      {
+         mpiMontgomeryMulLimbs(context, comb->table + ((1 << i) + j) * n,
+            comb->table + j * n, base, t);
+      }
+   }
+
+   //Erase contents before releasing memory
+   memset(buffer, 0, (2 * n + mpiGetMontgomeryTempSize(n)) * sizeof(MpiLimb));
+   osMemFree(buffer);
+
+   //Save the parameters of the comb table
+   comb->n = n;
+   comb->h = h;
+   comb->d = d;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Release a fixed-base comb table
+ * @param[in] comb Pointer to the comb table
+ **/
+
+void mpiCombFree(MpiCombTable *comb)
+{
+   //Any memory previously allocated?
+   if(comb->table != NULL)
+   {
+      //Erase contents before releasing memory
+      memset(comb->table, 0, (1 << comb->h) * comb->n * sizeof(MpiLimb));
+      osMemFree(comb->table);
+   }
+
+   //Clear comb table
+   comb->n = 0;
+   comb->h = 0;
+   comb->d = 0;
+   comb->table = NULL;
+}
+
+
+/**
+ * @brief Fixed-base modular exponentiation (comb method)
+ *
+ * The table lookups are performed in constant time. The exponent shall
+ * not be longer than the length specified when the table was computed
+ *
+ * @param[in] context Pointer to the Montgomery context
+ * @param[in] comb Comb table of the fixed base G
+ * @param[out] x Resulting integer X = G ^ E mod P
+ * @param[in] e Exponent E
+ * @return Error code
+ **/
+
+error_t mpiMontgomeryCombExpMod(MpiMontgomeryContext *context,
+   const MpiCombTable *comb, Mpi *x, const Mpi *e)
+{
+   error_t error;
+   int_t i;
+   int_t j;
+   uint_t n;
+   uint_t u;
+   MpiLimb *buffer;
+   MpiLimb *acc;
+   MpiLimb *b;
+   MpiLimb *t;
+
+   //Check parameters
+   if(context->p == NULL || comb->table == NULL || comb->n != context->n)
+      return ERROR_INVALID_PARAMETER;
+
+   //The exponent must fit in the comb
+   if(mpiGetBitLength(e) > (comb->h * comb->d))
+      return ERROR_INVALID_PARAMETER;
+
+   //Size of the modulus, in limbs
+   n = context->n;
+
+   //Allocate a memory buffer to hold the temporary values
+   buffer = osMemAlloc((2 * n + mpiGetMontgomeryTempSize(n)) * sizeof(MpiLimb));
+   //Failed to allocate memory?
+   if(!buffer) return ERROR_OUT_OF_MEMORY;
+
+   //Split the buffer
+   acc = buffer;
+   b = acc + n;
+   t = b + n;
+
+   //Let X = 1
+   memcpy(acc, comb->table, n * sizeof(MpiLimb));
+
+   //Process the columns of the comb
+   for(i = comb->d - 1; i >= 0; i--)
+   {
+      //Compute X = X^2
+      mpiMontgomerySqrLimbs(context, acc, acc, t);
+
+      //Gather one bit of the exponent under each tooth
+      for(u = 0, j = comb->h - 1; j >= 0; j--)
+         u = (u << 1) | mpiGetBitValue(e, j * comb->d + i);
+
+      //Constant-time table lookup
+      mpiSelectLimbs(b, comb->table, 1 << comb->h, n, u);
+
+      //Compute X = X * T(u)
+      mpiMontgomeryMulLimbs(context, acc, acc, b, t);
+   }
+
+   //Let B = 1
+   memset(b, 0, n * sizeof(MpiLimb));
+   b[0] = 1;
+
+   //Compute X = X * R^-1 mod P (conversion from Montgomery form)
+   mpiMontgomeryMulLimbs(context, acc, acc, b, t);
+
+   //Copy the result
+   error = mpiStoreLimbs(x, acc, n);
+
+   //Erase contents before releasing memory
+   memset(buffer, 0, (2 * n + mpiGetMontgomeryTempSize(n)) * sizeof(MpiLimb));
+   osMemFree(buffer);
+
+   //Return status code
+   return error;
+}
+
+
 /**
  * @brief Display the contents of a big number
  * @param[in] stream Pointer to a FILE object that identifies an output stream
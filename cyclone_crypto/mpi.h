@@ -33,6 +33,46 @@
 #include <stdio.h>
 #include "crypto.h"
 
+//Size of the limbs used by Montgomery arithmetic (32 or 64 bits)
+#ifndef MPI_LIMB_SIZE
+   #define MPI_LIMB_SIZE 32
+#elif (MPI_LIMB_SIZE != 32 && MPI_LIMB_SIZE != 64)
+   #error MPI_LIMB_SIZE parameter is invalid
+#endif
+
+//64-bit limbs require 128-bit intermediate products
+#if (MPI_LIMB_SIZE == 64 && !defined(__SIZEOF_INT128__))
+   #error MPI_LIMB_SIZE requires a compiler that supports 128-bit integers
+#endif
+
+//Maximum window size for modular exponentiation
+#ifndef MPI_MAX_WINDOW_SIZE
+   #define MPI_MAX_WINDOW_SIZE 5
+#elif (MPI_MAX_WINDOW_SIZE < 1 || MPI_MAX_WINDOW_SIZE > 6)
+   #error MPI_MAX_WINDOW_SIZE parameter is invalid
+#endif
+
+//Number of teeth of the fixed-base comb method
+#ifndef MPI_COMB_TEETH
+   #define MPI_COMB_TEETH 6
+#elif (MPI_COMB_TEETH < 1 || MPI_COMB_TEETH > 8)
+   #error MPI_COMB_TEETH parameter is invalid
+#endif
+
+//Operand size (in limbs) above which Karatsuba multiplication is used
+#ifndef MPI_KARATSUBA_THRESHOLD
+   #define MPI_KARATSUBA_THRESHOLD 48
+#elif (MPI_KARATSUBA_THRESHOLD < 4)
+   #error MPI_KARATSUBA_THRESHOLD parameter is invalid
+#endif
+
+//Assembly optimizations for the multiply-accumulate primitives
+#ifndef MPI_ASM_SUPPORT
+   #define MPI_ASM_SUPPORT DISABLED
+#elif (MPI_ASM_SUPPORT != ENABLED && MPI_ASM_SUPPORT != DISABLED)
+   #error MPI_ASM_SUPPORT parameter is invalid
+#endif
+
 //Size of the sub data type
 #define MPI_INT_SIZE sizeof(uint_t)
 
@@ -56,6 +96,49 @@ typedef struct
 } Mpi;
 
 
+//Limb data types
+#if (MPI_LIMB_SIZE == 64)
+   typedef uint64_t MpiLimb;
+   typedef unsigned __int128 MpiDoubleLimb;
+#else
+   typedef uint32_t MpiLimb;
+   typedef uint64_t MpiDoubleLimb;
+#endif
+
+
+/**
+ * @brief Montgomery context
+ *
+ * The context depends only on the modulus and can be reused by any
+ * number of exponentiations with that modulus
+ **/
+
+typedef struct
+{
+   uint_t n;     ///<Size of the modulus, in limbs
+   MpiLimb m0;   ///<Precomputed value -1/P mod 2^w
+   MpiLimb *p;   ///<Modulus P
+   MpiLimb *r2;  ///<Precomputed value R^2 mod P
+} MpiMontgomeryContext;
+
+
+/**
+ * @brief Fixed-base comb table
+ *
+ * The table holds the 2^h products of the values G^(2^(i * d)), so that
+ * any exponent of at most h * d bits can be processed with d squarings
+ * and d multiplications
+ **/
+
+typedef struct
+{
+   uint_t n;       ///<Size of the modulus, in limbs
+   uint_t h;       ///<Number of teeth
+   uint_t d;       ///<Distance between two teeth, in bits
+   MpiLimb *table; ///<Precomputed values (Montgomery form)
+} MpiCombTable;
+
+
 //MPI related functions
 void mpiInit(Mpi *x);
 void mpiFree(Mpi *x);
@@ -103,6 +186,25 @@ error_t mpiMod(Mpi *x, const Mpi *a, const Mpi *b);
 error_t mpiMulMod(Mpi *x, const Mpi *a, const Mpi *b, const Mpi *p);
 error_t mpiInvMod(Mpi *x, const Mpi *a, const Mpi *p);
 error_t mpiExpMod(Mpi *x, const Mpi *a, const Mpi *e, const Mpi *p);
+error_t mpiExpModFast(Mpi *x, const Mpi *a, const Mpi *e, const Mpi *p);
+error_t mpiExpModRegular(Mpi *x, const Mpi *a, const Mpi *e, const Mpi *p);
+
+error_t mpiMontgomeryInit(MpiMontgomeryContext *context, const Mpi *p);
+void mpiMontgomeryFree(MpiMontgomeryContext *context);
+error_t mpiMontgomeryMulMod(MpiMontgomeryContext *context, Mpi *x,
+   const Mpi *a, const Mpi *b);
+error_t mpiMontgomeryExpMod(MpiMontgomeryContext *context, Mpi *x,
+   const Mpi *a, const Mpi *e, bool_t regular);
+error_t mpiMontgomeryExpModLength(MpiMontgomeryContext *context, Mpi *x,
+   const Mpi *a, const Mpi *e, uint_t bits);
+error_t mpiMontgomeryExpModBatch(MpiMontgomeryContext *context, Mpi *x[],
+   const Mpi *a[], const Mpi *e, uint_t count);
+
+error_t mpiCombInit(MpiMontgomeryContext *context, MpiCombTable *comb,
+   const Mpi *g, uint_t bits);
+void mpiCombFree(MpiCombTable *comb);
+error_t mpiMontgomeryCombExpMod(MpiMontgomeryContext *context,
+   const MpiCombTable *comb, Mpi *x, const Mpi *e);
 
 error_t mpiMontgomeryMul(Mpi *x, const Mpi *a, const Mpi *b, uint_t k, const Mpi *p);
 error_t mpiMontgomeryRed(Mpi *x, uint_t k, const Mpi *p);
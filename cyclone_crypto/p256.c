@@ -0,0 +1,980 @@
+/**
+ * @file p256.c
+ * @brief NIST P-256 elliptic curve (secp256r1)
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneCrypto Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * Field elements are held in eight 32-bit words and all arithmetic is
+ * performed in the Montgomery domain (R = 2^256). Since p = -1 mod 2^32,
+ * the Montgomery reduction does not require any precomputed inverse.
+ * Points are handled in Jacobian coordinates. Fixed-base multiplication
+ * uses a precomputed comb table (64 doublings are replaced by 32), while
+ * variable-base multiplication uses a 4-bit fixed window. Table lookups
+ * and point selection are performed with masks so that the sequence of
+ * operations does not depend on the value of the secret scalar. Refer
+ * to SEC 2 and FIPS 186-3 for more details
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL CRYPTO_TRACE_LEVEL
+
+//Dependencies
+#include <string.h>
+#include "crypto.h"
+#include "p256.h"
+#include "debug.h"
+
+//secp256r1 OID (1.2.840.10045.3.1.7)
+const uint8_t SECP256R1_OID[8] = {0x2A, 0x86, 0x48, 0xCE, 0x3D, 0x03, 0x01, 0x07};
+
+//Order of the base point
+static const uint8_t p256Order[32] =
+{
+   0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+   0xBC, 0xE6, 0xFA, 0xAD, 0xA7, 0x17, 0x9E, 0x84, 0xF3, 0xB9, 0xCA, 0xC2, 0xFC, 0x63, 0x25, 0x51
+};
+
+//Field modulus p = 2^256 - 2^224 + 2^192 + 2^96 - 1
+static const uint32_t p256P[8] =
+   {0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x00000000, 0x00000000, 0x00000000, 0x00000001, 0xFFFFFFFF};
+
+//Precomputed value R^2 mod p
+static const uint32_t p256R2[8] =
+   {0x00000003, 0x00000000, 0xFFFFFFFF, 0xFFFFFFFB, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFD, 0x00000004};
+
+//Montgomery representation of 1 (R mod p)
+static const uint32_t p256One[8] =
+   {0x00000001, 0x00000000, 0x00000000, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFE, 0x00000000};
+
+//Montgomery representation of the curve coefficient b
+static const uint32_t p256B[8] =
+   {0x29C4BDDF, 0xD89CDF62, 0x78843090, 0xACF005CD, 0xF7212ED6, 0xE5A220AB, 0x04874834, 0xDC30061D};
+
+//Precomputed comb tables for the base point G. Entry j - 1 of table t
+//holds the sum of 2^(64 * i + 32 * t) * G for every bit i set in j
+static const P256AffinePoint p256CombTable[2][15] =
+{
+   {
+      {{0x18A9143C, 0x79E730D4, 0x5FEDB601, 0x75BA95FC, 0x77622510, 0x79FB732B, 0xA53755C6, 0x18905F76},
+       {0xCE95560A, 0xDDF25357, 0xBA19E45C, 0x8B4AB8E4, 0xDD21F325, 0xD2E88688, 0x25885D85, 0x8571FF18}},
+      {{0x16A0D2BB, 0x4F922FC5, 0x1A623499, 0x0D5CC16C, 0x57C62C8B, 0x9241CF3A, 0xFD1B667F, 0x2F5E6961},
+       {0xF5A01797, 0x5C15C70B, 0x60956192, 0x3D20B44D, 0x071FDB52, 0x04911B37, 0x8D6F0F7B, 0xF648F916}},
+      {{0xE137BBBC, 0x9E566847, 0x8A6A0BEC, 0xE434469E, 0x79D73463, 0xB1C42761, 0x133D0015, 0x5ABE0285},
+       {0xC04C7DAB, 0x92AA837C, 0x43260C07, 0x573D9F4C, 0x78E6CC37, 0x0C931562, 0x6B6F7383, 0x94BB725B}},
+      {{0xBFE20925, 0x62A8C244, 0x8FDCE867, 0x91C19AC3, 0xDD387063, 0x5A96A5D5, 0x21D324F6, 0x61D587D4},
+       {0xA37173EA, 0xE87673A2, 0x53778B65, 0x23848008, 0x05BAB43E, 0x10F8441E, 0x4621EFBE, 0xFA11FE12}},
+      {{0x2CB19FFD, 0x1C891F2B, 0xB1923C23, 0x01BA8D5B, 0x8AC5CA8E, 0xB6D03D67, 0x1F13BEDC, 0x586EB04C},
+       {0x27E8ED09, 0x0C35C6E5, 0x1819EDE2, 0x1E81A33C, 0x56C652FA, 0x278FD6C0, 0x70864F11, 0x19D5AC08}},
+      {{0xD2B533D5, 0x62577734, 0xA1BDDDC0, 0x673B8AF6, 0xA79EC293, 0x577E7C9A, 0xC3B266B1, 0xBB6DE651},
+       {0xB65259B3, 0xE7E9303A, 0xD03A7480, 0xD6A0AFD3, 0x9B3CFC27, 0xC5AC83D1, 0x5D18B99B, 0x60B4619A}},
+      {{0x1AE5AA1C, 0xBD6A38E1, 0x49E73658, 0xB8B7652B, 0xEE5F87ED, 0x0B130014, 0xAEEBFFCD, 0x9D0F27B2},
+       {0x7A730A55, 0xCA924631, 0xDDBBC83A, 0x9C955B2F, 0xAC019A71, 0x07C1DFE0, 0x356EC48D, 0x244A566D}},
+      {{0xF4F8B16A, 0x56F8410E, 0xC47B266A, 0x97241AFE, 0x6D9C87C1, 0x0A406B8E, 0xCD42AB1B, 0x803F3E02},
+       {0x04DBEC69, 0x7F0309A8, 0x3BBAD05F, 0xA83B85F7, 0xAD8E197F, 0xC6097273, 0x5067ADC1, 0xC097440E}},
+      {{0xC379AB34, 0x846A56F2, 0x841DF8D1, 0xA8EE068B, 0x176C68EF, 0x20314459, 0x915F1F30, 0xF1AF32D5},
+       {0x5D75BD50, 0x99C37531, 0xF72F67BC, 0x837CFFBA, 0x48D7723F, 0x0613A418, 0xE2D41C8B, 0x23D0F130}},
+      {{0xD5BE5A2B, 0xED93E225, 0x5934F3C6, 0x6FE79983, 0x22626FFC, 0x43140926, 0x7990216A, 0x50BBB4D9},
+       {0xE57EC63E, 0x378191C6, 0x181DCDB2, 0x65422C40, 0x0236E0F6, 0x41A8099B, 0x01FE49C3, 0x2B100118}},
+      {{0x9B391593, 0xFC68B5C5, 0x598270FC, 0xC385F5A2, 0xD19ADCBB, 0x7144F3AA, 0x83FBAE0C, 0xDD558999},
+       {0x74B82FF4, 0x93B88B8E, 0x71E734C9, 0xD2E03C40, 0x43C0322A, 0x9A7A9EAF, 0x149D6041, 0xE6E4C551}},
+      {{0x80EC21FE, 0x5FE14BFE, 0xC255BE82, 0xF6CE116A, 0x2F4A5D67, 0x98BC5A07, 0xDB7E63AF, 0xFAD27148},
+       {0x29AB05B3, 0x90C0B6AC, 0x4E251AE6, 0x37A9A83C, 0xC2AADE7D, 0x0A7DC875, 0x9F0E1A84, 0x77387DE3}},
+      {{0xA56C0DD7, 0x1E9ECC49, 0x46086C74, 0xA5CFFCD8, 0xF505AECE, 0x8F7A1408, 0xBEF0C47E, 0xB37B85C0},
+       {0xCC0E6A8F, 0x3596B6E4, 0x6B388F23, 0xFD6D4BBF, 0xC39CEF4E, 0xABA453FA, 0xF9F628D5, 0x9C135AC8}},
+      {{0x95C8F8BE, 0x0A1C7294, 0x3BF362BF, 0x2961C480, 0xDF63D4AC, 0x9E418403, 0x91ECE900, 0xC109F9CB},
+       {0x58945705, 0xC2D095D0, 0xDDEB85C0, 0xB9083D96, 0x7A40449B, 0x84692B8D, 0x2EEE1EE1, 0x9BC3344F}},
+      {{0x42913074, 0x0D5AE356, 0x48A542B1, 0x55491B27, 0xB310732A, 0x469CA665, 0x5F1A4CC1, 0x29591D52},
+       {0xB84F983F, 0xE76F5B6B, 0x9F5F84E1, 0xBE7EEF41, 0x80BAA189, 0x1200D496, 0x18EF332C, 0x6376551F}}
+   },
+   {
+      {{0x4147519A, 0x20288602, 0x26B372F0, 0xD0981EAC, 0xA785EBC8, 0xA9D4A7CA, 0xDBDF58E9, 0xD953C50D},
+       {0xFD590F8F, 0x9D6361CC, 0x44E6C917, 0x72E9626B, 0x22EB64CF, 0x7FD96110, 0x9EB288F3, 0x863EBB7E}},
+      {{0xB0E63D34, 0x4FE7EE31, 0xA9E54FAB, 0xF4600572, 0xD5E7B5A4, 0xC0493334, 0x06D54831, 0x8589FB92},
+       {0x6583553A, 0xAA70F5CC, 0xE25649E5, 0x0879094A, 0x10044652, 0xCC904507, 0x02541C4F, 0xEBB0696D}},
+      {{0x3B89DA99, 0xABBAA0C0, 0xB8284022, 0xA6F2D79E, 0xB81C05E8, 0x27847862, 0x05E54D63, 0x337A4B59},
+       {0x21F7794A, 0x3C67500D, 0x7D6D7F61, 0x207005B7, 0x04CFD6E8, 0x0A5A3781, 0xF4C2FBD6, 0x0D65E0D5}},
+      {{0x6D3549CF, 0xD433E50F, 0xFACD665E, 0x6F33696F, 0xCE11FCB4, 0x695BFDAC, 0xAF7C9860, 0x810EE252},
+       {0x7159BB2C, 0x65450FE1, 0x758B357B, 0xF7DFBEBE, 0xD69FEA72, 0x2B057E74, 0x92731745, 0xD485717A}},
+      {{0xE83F7669, 0xCE1F69BB, 0x72877D6B, 0x09F8AE82, 0x3244278D, 0x9548AE54, 0xE3C2C19C, 0x207755DE},
+       {0x6FEF1945, 0x87BD61D9, 0xB12D28C3, 0x18813CEF, 0x72DF64AA, 0x9FBCD1D6, 0x7154B00D, 0x48DC5EE5}},
+      {{0xF49A3154, 0xEF0F469E, 0x6E2B2E9A, 0x3E85A595, 0xAA924A9C, 0x45AAEC1E, 0xA09E4719, 0xAA12DFC8},
+       {0x4DF69F1D, 0x26F27227, 0xA2FF5E73, 0xE0E4C82C, 0xB7A9DD44, 0xB9D8CE73, 0xE48CA901, 0x6C036E73}},
+      {{0xA47153F0, 0xE1E421E1, 0x920418C9, 0xB86C3B79, 0x705D7672, 0x93BDCE87, 0xCAB79A77, 0xF25AE793},
+       {0x6D869D0C, 0x1F3194A3, 0x4986C264, 0x9D55C882, 0x096E945E, 0x49FB5EA3, 0x13DB0A3E, 0x39B8E653}},
+      {{0x35D0B34A, 0xE3417BC0, 0x8327C0A7, 0x440B386B, 0xAC0362D1, 0x8FB7262D, 0xE0CDF943, 0x2C41114C},
+       {0xAD95A0B1, 0x2BA5CEF1, 0x67D54362, 0xC09B37A8, 0x01E486C9, 0x26D6CDD2, 0x42FF9297, 0x20477ABF}},
+      {{0xBC0A67D2, 0x0F121B41, 0x444D248A, 0x62D4760A, 0x659B4737, 0x0E044F1D, 0x250BB4A8, 0x08FDE365},
+       {0x848BF287, 0xACEEC3DA, 0xD3369D6E, 0xC2A62182, 0x92449482, 0x3582DFDC, 0x565D6CD7, 0x2F7E2FD2}},
+      {{0x178A876B, 0x0A0122B5, 0x085104B4, 0x51FF96FF, 0x14F29F76, 0x050B31AB, 0x5F87D4E6, 0x84ABB28B},
+       {0x8270790A, 0xD5ED439F, 0x85E3F46B, 0x2D6CB59D, 0x6C1E2212, 0x75F55C1B, 0x17655640, 0xE5436F67}},
+      {{0x9AEB596D, 0xC2965ECC, 0x023C92B4, 0x01EA03E7, 0x2E013961, 0x4704B4B6, 0x905EA367, 0x0CA8FD3F},
+       {0x551B2B61, 0x92523A42, 0x390FCD06, 0x1EB7A89C, 0x0392A63E, 0xE7F1D2BE, 0x4DDB0C33, 0x96DCA264}},
+      {{0x15339848, 0x231C210E, 0x70778C8D, 0xE87A28E8, 0x6956E170, 0x9D1DE661, 0x2BB09C0B, 0x4AC3C938},
+       {0x6998987D, 0x19BE0551, 0xAE09F4D6, 0x8B2376C4, 0x1A3F933D, 0x1DE0B765, 0xE39705F4, 0x380D94C7}},
+      {{0x8C31C31D, 0x3685954B, 0x5BF21A0C, 0x68533D00, 0x75C79EC9, 0x0BD7626E, 0x42C69D54, 0xCA177547},
+       {0xF6D2DBB2, 0xCC6EDAFF, 0x174A9D18, 0xFD0D8CBD, 0xAA4578E8, 0x875E8793, 0x9CAB2CE6, 0xA976A713}},
+      {{0xB43EA1DB, 0xCE37AB11, 0x5259D292, 0x0A7FF1A9, 0x8F84F186, 0x851B0221, 0xDEFAAD13, 0xA7222BEA},
+       {0x2B0A9144, 0xA2AC78EC, 0xF2FA59C5, 0x5A024051, 0x6147CE38, 0x91D1ECA5, 0xBC2AC690, 0xBE94D523}},
+      {{0x79EC1A0F, 0x2D8DAEFD, 0xCEB39C97, 0x3BBCD6FD, 0x58F61A95, 0xF5575FFC, 0xADF7B420, 0xDBD986C4},
+       {0x15F39EB7, 0x81AA8814, 0xB98D976C, 0x6EE2FCF5, 0xCF2F717D, 0x5465475D, 0x6860BBD0, 0x8E24D3C4}}
+   }
+};
+
+//Common interface for elliptic curves
+const EcCurveInfo secp256r1Curve =
+{
+   "secp256r1",
+   SECP256R1_OID,
+   sizeof(SECP256R1_OID),
+   EC_CURVE_TYPE_WEIERSTRASS,
+   P256_FIELD_SIZE,
+   P256_POINT_SIZE,
+   p256Order,
+   p256CheckPoint,
+   p256MulBase,
+   p256Mul,
+   p256MulAdd
+};
+
+
+/**
+ * @brief Convert an octet string to a field element
+ * @param[out] r Resulting field element
+ * @param[in] data Octet string (big-endian, 32 bytes)
+ **/
+
+static void p256Import(uint32_t *r, const uint8_t *data)
+{
+   uint_t i;
+
+   //Words are stored in little-endian order
+   for(i = 0; i < 8; i++)
+      r[i] = LOAD32BE(data + 28 - 4 * i);
+}
+
+
+/**
+ * @brief Convert a field element to an octet string
+ * @param[out] data Octet string (big-endian, 32 bytes)
+ * @param[in] a Field element to convert
+ **/
+
+static void p256Export(uint8_t *data, const uint32_t *a)
+{
+   uint_t i;
+
+   //Words are stored in little-endian order
+   for(i = 0; i < 8; i++)
+      STORE32BE(a[i], data + 28 - 4 * i);
+}
+
+
+/**
+ * @brief Check whether a field element is zero
+ * @param[in] a Field element
+ * @return Mask set to 0xFFFFFFFF if a is zero, else 0
+ **/
+
+static uint32_t p256IsZero(const uint32_t *a)
+{
+   uint_t i;
+   uint32_t t;
+
+   //Constant-time comparison
+   for(t = 0, i = 0; i < 8; i++)
+      t |= a[i];
+
+   //Return a mask
+   return ((t | (0 - t)) >> 31) - 1;
+}
+
+
+/**
+ * @brief Conditional subtraction of the modulus
+ * @param[out] r Resulting value
+ * @param[in] a Value to reduce (a < 2p)
+ * @param[in] c Carry bit of the value to reduce
+ **/
+
+static void p256Reduce(uint32_t *r, const uint32_t *a, uint32_t c)
+{
+   uint_t i;
+   uint32_t b;
+   uint32_t mask;
+   uint32_t t[8];
+   uint64_t temp;
+
+   //Compute t = a - p
+   for(b = 0, i = 0; i < 8; i++)
+   {
+      temp = (uint64_t) a[i] - p256P[i] - b;
+      t[i] = (uint32_t) temp;
+      b = (temp >> 32) & 1;
+   }
+
+   //Select t if a >= p, else a
+   mask = 0 - (c | (b ^ 1));
+
+   //Constant-time selection
+   for(i = 0; i < 8; i++)
+      r[i] = (t[i] & mask) | (a[i] & ~mask);
+}
+
+
+/**
+ * @brief Modular addition
+ * @param[out] r Resulting value r = (a + b) mod p
+ * @param[in] a First operand (a < p)
+ * @param[in] b Second operand (b < p)
+ **/
+
+static void p256AddMod(uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+   uint_t i;
+   uint32_t c;
+   uint32_t t[8];
+   uint64_t temp;
+
+   //Compute t = a + b
+   for(c = 0, i = 0; i < 8; i++)
+   {
+      temp = (uint64_t) a[i] + b[i] + c;
+      t[i] = (uint32_t) temp;
+      c = temp >> 32;
+   }
+
+   //Reduce the result
+   p256Reduce(r, t, c);
+}
+
+
+/**
+ * @brief Modular subtraction
+ * @param[out] r Resulting value r = (a - b) mod p
+ * @param[in] a First operand (a < p)
+ * @param[in] b Second operand (b < p)
+ **/
+
+static void p256SubMod(uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+   uint_t i;
+   uint32_t c;
+   uint32_t mask;
+   uint32_t t[8];
+   uint64_t temp;
+
+   //Compute t = a - b
+   for(c = 0, i = 0; i < 8; i++)
+   {
+      temp = (uint64_t) a[i] - b[i] - c;
+      t[i] = (uint32_t) temp;
+      c = (temp >> 32) & 1;
+   }
+
+   //Add p if the result is negative
+   mask = 0 - c;
+
+   //Compute r = t + (p & mask)
+   for(c = 0, i = 0; i < 8; i++)
+   {
+      temp = (uint64_t) t[i] + (p256P[i] & mask) + c;
+      r[i] = (uint32_t) temp;
+      c = temp >> 32;
+   }
+}
+
+
+/**
+ * @brief Montgomery multiplication
+ * @param[out] r Resulting value r = a * b / R mod p
+ * @param[in] a First operand (a < p)
+ * @param[in] b Second operand (b < p)
+ **/
+
+static void p256MulMont(uint32_t *r, const uint32_t *a, const uint32_t *b)
+{
+   uint_t i;
+   uint_t j;
+   uint32_t c;
+   uint32_t m;
+   uint32_t t[10];
+   uint64_t temp;
+
+   //Clear accumulator
+   memset(t, 0, sizeof(t));
+
+   //Coarsely integrated operand scanning
+   for(i = 0; i < 8; i++)
+   {
+      //Compute t = t + a * b[i]
+      for(c = 0, j = 0; j < 8; j++)
+      {
+         temp = (uint64_t) a[j] * b[i] + t[j] + c;
+         t[j] = (uint32_t) temp;
+         c = temp >> 32;
+      }
+
+      temp = (uint64_t) t[8] + c;
+      t[8] = (uint32_t) temp;
+      t[9] = temp >> 32;
+
+      //Since -1/p mod 2^32 = 1, the quotient digit is simply t[0]
+      m = t[0];
+
+      //Compute t = (t + m * p) / 2^32
+      temp = (uint64_t) m * p256P[0] + t[0];
+      c = temp >> 32;
+
+      for(j = 1; j < 8; j++)
+      {
+         temp = (uint64_t) m * p256P[j] + t[j] + c;
+         t[j - 1] = (uint32_t) temp;
+         c = temp >> 32;
+      }
+
+      temp = (uint64_t) t[8] + c;
+      t[7] = (uint32_t) temp;
+      t[8] = t[9] + (uint32_t) (temp >> 32);
+   }
+
+   //The result is less than 2p
+   p256Reduce(r, t, t[8]);
+}
+
+
+/**
+ * @brief Modular inversion (Montgomery representation)
+ * @param[out] r Resulting value r = a^-1 mod p
+ * @param[in] a Field element to invert
+ **/
+
+static void p256InvMont(uint32_t *r, const uint32_t *a)
+{
+   int_t i;
+   uint32_t e;
+   uint32_t t[8];
+
+   //Start with 1
+   memcpy(t, p256One, sizeof(t));
+
+   //Fermat's little theorem: a^-1 = a^(p - 2) mod p. The exponent
+   //is public, hence the sequence of operations does not leak anything
+   for(i = 255; i >= 0; i--)
+   {
+      //Retrieve the current bit of the exponent p - 2
+      e = (i < 32) ? (p256P[0] - 2) : p256P[i / 32];
+
+      //Square
+      p256MulMont(t, t, t);
+
+      //Multiply
+      if((e >> (i % 32)) & 1)
+         p256MulMont(t, t, a);
+   }
+
+   //Copy the resulting value
+   memcpy(r, t, sizeof(t));
+}
+
+
+/**
+ * @brief Constant-time point selection
+ * @param[in,out] r Destination point
+ * @param[in] a Source point
+ * @param[in] mask Copy a to r if the mask is set to 0xFFFFFFFF
+ **/
+
+static void p256Select(P256Point *r, const P256Point *a, uint32_t mask)
+{
+   uint_t i;
+
+   //Process the three coordinates
+   for(i = 0; i < 8; i++)
+   {
+      r->x[i] = (a->x[i] & mask) | (r->x[i] & ~mask);
+      r->y[i] = (a->y[i] & mask) | (r->y[i] & ~mask);
+      r->z[i] = (a->z[i] & mask) | (r->z[i] & ~mask);
+   }
+}
+
+
+/**
+ * @brief Point doubling
+ * @param[out] r Resulting point r = 2a
+ * @param[in] a Point to double
+ **/
+
+static void p256Double(P256Point *r, const P256Point *a)
+{
+   uint32_t delta[8];
+   uint32_t gamma[8];
+   uint32_t beta[8];
+   uint32_t alpha[8];
+   uint32_t t[8];
+
+   //delta = Z1^2
+   p256MulMont(delta, a->z, a->z);
+   //gamma = Y1^2
+   p256MulMont(gamma, a->y, a->y);
+   //beta = X1 * gamma
+   p256MulMont(beta, a->x, gamma);
+
+   //alpha = 3 * (X1 - delta) * (X1 + delta)
+   p256SubMod(t, a->x, delta);
+   p256AddMod(alpha, a->x, delta);
+   p256MulMont(alpha, alpha, t);
+   p256AddMod(t, alpha, alpha);
+   p256AddMod(alpha, alpha, t);
+
+   //Z3 = (Y1 + Z1)^2 - gamma - delta
+   p256AddMod(t, a->y, a->z);
+   p256MulMont(t, t, t);
+   p256SubMod(t, t, gamma);
+   p256SubMod(r->z, t, delta);
+
+   //Compute 4 * beta
+   p256AddMod(beta, beta, beta);
+   p256AddMod(beta, beta, beta);
+
+   //X3 = alpha^2 - 8 * beta
+   p256MulMont(t, alpha, alpha);
+   p256SubMod(t, t, beta);
+   p256SubMod(r->x, t, beta);
+
+   //Compute 8 * gamma^2
+   p256MulMont(gamma, gamma, gamma);
+   p256AddMod(gamma, gamma, gamma);
+   p256AddMod(gamma, gamma, gamma);
+   p256AddMod(gamma, gamma, gamma);
+
+   //Y3 = alpha * (4 * beta - X3) - 8 * gamma^2
+   p256SubMod(t, beta, r->x);
+   p256MulMont(t, alpha, t);
+   p256SubMod(r->y, t, gamma);
+}
+
+
+/**
+ * @brief Complete the addition formulas
+ * @param[out] r Resulting point
+ * @param[in] u1 First X coordinate, scaled to a common Z
+ * @param[in] s1 First Y coordinate, scaled to a common Z
+ * @param[in] h Difference of the X coordinates (U2 - U1)
+ * @param[in] rr Difference of the Y coordinates (S2 - S1)
+ **/
+
+static void p256AddFinal(P256Point *r, const uint32_t *u1,
+   const uint32_t *s1, const uint32_t *h, const uint32_t *rr)
+{
+   uint32_t hh[8];
+   uint32_t hhh[8];
+   uint32_t v[8];
+   uint32_t t[8];
+
+   //Compute H^2 and H^3
+   p256MulMont(hh, h, h);
+   p256MulMont(hhh, hh, h);
+   //V = U1 * H^2
+   p256MulMont(v, u1, hh);
+
+   //X3 = R^2 - H^3 - 2 * V
+   p256MulMont(t, rr, rr);
+   p256SubMod(t, t, hhh);
+   p256SubMod(t, t, v);
+   p256SubMod(r->x, t, v);
+
+   //Y3 = R * (V - X3) - S1 * H^3
+   p256SubMod(t, v, r->x);
+   p256MulMont(t, rr, t);
+   p256MulMont(hhh, s1, hhh);
+   p256SubMod(r->y, t, hhh);
+}
+
+
+/**
+ * @brief Point addition (Jacobian + affine coordinates)
+ *
+ * The point at infinity is not handled here. The caller takes care of
+ * it using constant-time selection
+ *
+ * @param[out] r Resulting point r = a + b
+ * @param[in] a First operand (Jacobian coordinates)
+ * @param[in] b Second operand (affine coordinates)
+ **/
+
+static void p256AddMixed(P256Point *r, const P256Point *a, const P256AffinePoint *b)
+{
+   uint32_t u1[8];
+   uint32_t s1[8];
+   uint32_t u2[8];
+   uint32_t s2[8];
+   uint32_t h[8];
+   uint32_t rr[8];
+   P256Point t;
+
+   //U1 = X1, S1 = Y1
+   memcpy(u1, a->x, sizeof(u1));
+   memcpy(s1, a->y, sizeof(s1));
+
+   //U2 = X2 * Z1^2
+   p256MulMont(h, a->z, a->z);
+   p256MulMont(u2, b->x, h);
+   //S2 = Y2 * Z1^3
+   p256MulMont(h, h, a->z);
+   p256MulMont(s2, b->y, h);
+
+   //H = U2 - U1, R = S2 - S1
+   p256SubMod(h, u2, u1);
+   p256SubMod(rr, s2, s1);
+
+   //Exceptional case (the two points have the same X coordinate)?
+   if(p256IsZero(h))
+   {
+      //Convert the second point to Jacobian coordinates
+      memcpy(t.x, b->x, sizeof(t.x));
+      memcpy(t.y, b->y, sizeof(t.y));
+      memcpy(t.z, p256One, sizeof(t.z));
+
+      //Equal points must be doubled, opposite points sum to infinity
+      if(p256IsZero(rr))
+         p256Double(r, &t);
+      else
+         memset(r->z, 0, sizeof(r->z));
+   }
+   else
+   {
+      //Z3 = Z1 * H
+      p256MulMont(r->z, a->z, h);
+      //Compute X3 and Y3
+      p256AddFinal(r, u1, s1, h, rr);
+   }
+}
+
+
+/**
+ * @brief Point addition (Jacobian coordinates)
+ *
+ * The point at infinity is not handled here. The caller takes care of
+ * it using constant-time selection
+ *
+ * @param[out] r Resulting point r = a + b
+ * @param[in] a First operand
+ * @param[in] b Second operand
+ **/
+
+static void p256Add(P256Point *r, const P256Point *a, const P256Point *b)
+{
+   uint32_t u1[8];
+   uint32_t s1[8];
+   uint32_t u2[8];
+   uint32_t s2[8];
+   uint32_t h[8];
+   uint32_t rr[8];
+
+   //U1 = X1 * Z2^2, S1 = Y1 * Z2^3
+   p256MulMont(h, b->z, b->z);
+   p256MulMont(u1, a->x, h);
+   p256MulMont(h, h, b->z);
+   p256MulMont(s1, a->y, h);
+
+   //U2 = X2 * Z1^2, S2 = Y2 * Z1^3
+   p256MulMont(h, a->z, a->z);
+   p256MulMont(u2, b->x, h);
+   p256MulMont(h, h, a->z);
+   p256MulMont(s2, b->y, h);
+
+   //H = U2 - U1, R = S2 - S1
+   p256SubMod(h, u2, u1);
+   p256SubMod(rr, s2, s1);
+
+   //Exceptional case (the two points have the same X coordinate)?
+   if(p256IsZero(h))
+   {
+      //Equal points must be doubled, opposite points sum to infinity
+      if(p256IsZero(rr))
+         p256Double(r, a);
+      else
+         memset(r->z, 0, sizeof(r->z));
+   }
+   else
+   {
+      //Z3 = Z1 * Z2 * H
+      p256MulMont(u2, a->z, b->z);
+      p256MulMont(r->z, u2, h);
+      //Compute X3 and Y3
+      p256AddFinal(r, u1, s1, h, rr);
+   }
+}
+
+
+/**
+ * @brief Decode and validate an encoded point
+ * @param[out] r Resulting point (Jacobian coordinates)
+ * @param[in] data Encoded point (uncompressed form)
+ * @param[in] length Length of the encoded point
+ * @return Error code
+ **/
+
+static error_t p256Decode(P256Point *r, const uint8_t *data, size_t length)
+{
+   int_t i;
+   uint32_t t[8];
+
+   //Only the uncompressed form is supported
+   if(length != P256_POINT_SIZE || data[0] != EC_POINT_UNCOMPRESSED)
+      return ERROR_INVALID_PARAMETER;
+
+   //Retrieve the affine coordinates
+   p256Import(r->x, data + 1);
+   p256Import(r->y, data + 1 + P256_FIELD_SIZE);
+
+   //The coordinates must be in range [0, p - 1]
+   for(i = 7; i >= 0 && r->x[i] == p256P[i]; i--);
+   if(i >= 0 && r->x[i] > p256P[i])
+      return ERROR_INVALID_PARAMETER;
+   if(i < 0)
+      return ERROR_INVALID_PARAMETER;
+
+   for(i = 7; i >= 0 && r->y[i] == p256P[i]; i--);
+   if(i >= 0 && r->y[i] > p256P[i])
+      return ERROR_INVALID_PARAMETER;
+   if(i < 0)
+      return ERROR_INVALID_PARAMETER;
+
+   //Convert the coordinates to Montgomery representation
+   p256MulMont(r->x, r->x, p256R2);
+   p256MulMont(r->y, r->y, p256R2);
+   memcpy(r->z, p256One, sizeof(r->z));
+
+   //Compute t = x^3 - 3x + b
+   p256MulMont(t, r->x, r->x);
+   p256MulMont(t, t, r->x);
+   p256SubMod(t, t, r->x);
+   p256SubMod(t, t, r->x);
+   p256SubMod(t, t, r->x);
+   p256AddMod(t, t, p256B);
+
+   //Check whether y^2 = x^3 - 3x + b
+   p256MulMont(r->z, r->y, r->y);
+   if(memcmp(r->z, t, sizeof(t)))
+      return ERROR_INVALID_PARAMETER;
+
+   //Z = 1
+   memcpy(r->z, p256One, sizeof(r->z));
+   //The point lies on the curve
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Encode a point (conversion to affine coordinates)
+ * @param[out] data Encoded point (uncompressed form)
+ * @param[in] a Point to encode (Jacobian coordinates)
+ * @return Error code
+ **/
+
+static error_t p256Encode(uint8_t *data, const P256Point *a)
+{
+   uint32_t z[8];
+   uint32_t t[8];
+   static const uint32_t one[8] = {1, 0, 0, 0, 0, 0, 0, 0};
+
+   //The point at infinity cannot be encoded
+   if(p256IsZero(a->z))
+      return ERROR_FAILURE;
+
+   //Compute Z^-1
+   p256InvMont(z, a->z);
+
+   //x = X / Z^2
+   p256MulMont(t, z, z);
+   p256MulMont(z, z, t);
+   p256MulMont(t, a->x, t);
+   //Leave the Montgomery domain
+   p256MulMont(t, t, one);
+   p256Export(data + 1, t);
+
+   //y = Y / Z^3
+   p256MulMont(t, a->y, z);
+   //Leave the Montgomery domain
+   p256MulMont(t, t, one);
+   p256Export(data + 1 + P256_FIELD_SIZE, t);
+
+   //Uncompressed form
+   data[0] = EC_POINT_UNCOMPRESSED;
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Fixed-base scalar multiplication (comb method)
+ * @param[out] r Resulting point r = d * G
+ * @param[in] d Scalar (big-endian, 32 bytes)
+ **/
+
+static void p256CombMul(P256Point *r, const uint8_t *d)
+{
+   int_t c;
+   uint_t i;
+   uint_t j;
+   uint_t t;
+   uint_t k;
+   uint_t index;
+   uint32_t mask;
+   P256AffinePoint a;
+   P256Point s;
+
+   //Initialize R to the point at infinity
+   memcpy(r->x, p256One, sizeof(r->x));
+   memcpy(r->y, p256One, sizeof(r->y));
+   memset(r->z, 0, sizeof(r->z));
+
+   //Process the 32 columns of the comb
+   for(c = 31; c >= 0; c--)
+   {
+      //Double the accumulator (the point at infinity remains unchanged)
+      p256Double(r, r);
+
+      //Each column involves one lookup in each table
+      for(t = 0; t < 2; t++)
+      {
+         //Gather the bits d[c + 32t], d[c + 32t + 64], ...
+         for(index = 0, i = 0; i < 4; i++)
+         {
+            k = c + 32 * t + 64 * i;
+            index |= ((d[31 - k / 8] >> (k % 8)) & 1) << i;
+         }
+
+         //Constant-time table lookup. A zero index still performs an
+         //addition with the first entry, whose result is discarded
+         a = p256CombTable[t][0];
+
+         for(j = 2; j <= 15; j++)
+         {
+            //Select the matching entry
+            mask = ((uint32_t) (j ^ index) - 1) >> 31;
+            mask = 0 - mask;
+
+            for(k = 0; k < 8; k++)
+            {
+               a.x[k] = (p256CombTable[t][j - 1].x[k] & mask) | (a.x[k] & ~mask);
+               a.y[k] = (p256CombTable[t][j - 1].y[k] & mask) | (a.y[k] & ~mask);
+            }
+         }
+
+         //Compute S = R + A
+         p256AddMixed(&s, r, &a);
+
+         //If R is the point at infinity, then S = A
+         mask = p256IsZero(r->z);
+         for(k = 0; k < 8; k++)
+         {
+            s.x[k] = (a.x[k] & mask) | (s.x[k] & ~mask);
+            s.y[k] = (a.y[k] & mask) | (s.y[k] & ~mask);
+            s.z[k] = (p256One[k] & mask) | (s.z[k] & ~mask);
+         }
+
+         //Update R unless the index is zero
+         mask = 0 - (((uint32_t) index | (0 - (uint32_t) index)) >> 31);
+         p256Select(r, &s, mask);
+      }
+   }
+}
+
+
+/**
+ * @brief Variable-base scalar multiplication (fixed window method)
+ * @param[out] r Resulting point r = d * P
+ * @param[in] d Scalar (big-endian, 32 bytes)
+ * @param[in] p Input point
+ **/
+
+static void p256WindowMul(P256Point *r, const uint8_t *d, const P256Point *p)
+{
+   uint_t i;
+   uint_t j;
+   uint_t index;
+   uint32_t mask;
+   P256Point a;
+   P256Point s;
+   P256Point table[15];
+
+   //Precompute P, 2P, ..., 15P. The input point is public, so the
+   //exceptional cases of the addition formulas cannot be triggered
+   table[0] = *p;
+   p256Double(&table[1], p);
+
+   for(i = 2; i < 15; i++)
+      p256Add(&table[i], &table[i - 1], p);
+
+   //Initialize R to the point at infinity
+   memcpy(r->x, p256One, sizeof(r->x));
+   memcpy(r->y, p256One, sizeof(r->y));
+   memset(r->z, 0, sizeof(r->z));
+
+   //Process the scalar 4 bits at a time, starting with the most significant
+   for(i = 0; i < 64; i++)
+   {
+      //Compute R = 16R
+      p256Double(r, r);
+      p256Double(r, r);
+      p256Double(r, r);
+      p256Double(r, r);
+
+      //Extract the current window
+      index = (d[i / 2] >> ((i % 2) ? 0 : 4)) & 0x0F;
+
+      //Constant-time table lookup
+      a = table[0];
+
+      for(j = 2; j <= 15; j++)
+      {
+         //Select the matching entry
+         mask = ((uint32_t) (j ^ index) - 1) >> 31;
+         p256Select(&a, &table[j - 1], 0 - mask);
+      }
+
+      //Compute S = R + A
+      p256Add(&s, r, &a);
+
+      //If R is the point at infinity, then S = A
+      p256Select(&s, &a, p256IsZero(r->z));
+
+      //Update R unless the window is zero
+      mask = 0 - (((uint32_t) index | (0 - (uint32_t) index)) >> 31);
+      p256Select(r, &s, mask);
+   }
+}
+
+
+/**
+ * @brief Check whether a point lies on the curve
+ * @param[in] p Encoded point (uncompressed form)
+ * @param[in] length Length of the encoded point
+ * @return Error code
+ **/
+
+error_t p256CheckPoint(const uint8_t *p, size_t length)
+{
+   P256Point a;
+
+   //Decode and validate the point
+   return p256Decode(&a, p, length);
+}
+
+
+/**
+ * @brief Fixed-base scalar multiplication
+ * @param[out] r Resulting point R = d * G (uncompressed form)
+ * @param[in] d Scalar (big-endian, 32 bytes)
+ * @return Error code
+ **/
+
+error_t p256MulBase(uint8_t *r, const uint8_t *d)
+{
+   error_t error;
+   P256Point a;
+
+   //Compute d * G using the precomputed comb tables
+   p256CombMul(&a, d);
+   //Convert the result to affine coordinates
+   error = p256Encode(r, &a);
+
+   //Clear intermediate values
+   memset(&a, 0, sizeof(P256Point));
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Variable-base scalar multiplication
+ * @param[out] r Resulting point R = d * P (uncompressed form)
+ * @param[in] d Scalar (big-endian, 32 bytes)
+ * @param[in] p Input point (uncompressed form)
+ * @return Error code
+ **/
+
+error_t p256Mul(uint8_t *r, const uint8_t *d, const uint8_t *p)
+{
+   error_t error;
+   P256Point a;
+   P256Point b;
+
+   //Decode and validate the input point
+   error = p256Decode(&a, p, P256_POINT_SIZE);
+   //Any error to report?
+   if(error) return error;
+
+   //Compute d * P
+   p256WindowMul(&b, d, &a);
+   //Convert the result to affine coordinates
+   error = p256Encode(r, &b);
+
+   //Clear intermediate values
+   memset(&b, 0, sizeof(P256Point));
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Twin scalar multiplication (signature verification)
+ * @param[out] r Resulting point R = u1 * G + u2 * Q (uncompressed form)
+ * @param[in] u1 First scalar (big-endian, 32 bytes)
+ * @param[in] u2 Second scalar (big-endian, 32 bytes)
+ * @param[in] q Input point (uncompressed form)
+ * @return Error code
+ **/
+
+error_t p256MulAdd(uint8_t *r, const uint8_t *u1, const uint8_t *u2, const uint8_t *q)
+{
+   error_t error;
+   P256Point a;
+   P256Point b;
+   P256Point c;
+
+   //Decode and validate the input point
+   error = p256Decode(&c, q, P256_POINT_SIZE);
+   //Any error to report?
+   if(error) return error;
+
+   //Compute u1 * G and u2 * Q
+   p256CombMul(&a, u1);
+   p256WindowMul(&b, u2, &c);
+
+   //The scalars are public, the point at infinity can be handled directly
+   if(p256IsZero(a.z))
+      c = b;
+   else if(p256IsZero(b.z))
+      c = a;
+   else
+      p256Add(&c, &a, &b);
+
+   //Convert the result to affine coordinates
+   return p256Encode(r, &c);
+}
@@ -0,0 +1,77 @@
+/**
+ * @file p256.h
+ * @brief NIST P-256 elliptic curve (secp256r1)
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneCrypto Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+#ifndef _P256_H
+#define _P256_H
+
+//Dependencies
+#include "crypto.h"
+#include "ec.h"
+
+//Size of a field element (in bytes)
+#define P256_FIELD_SIZE 32
+//Size of an encoded point (uncompressed form)
+#define P256_POINT_SIZE 65
+//Common interface for elliptic curves
+#define SECP256R1_CURVE (&secp256r1Curve)
+
+
+/**
+ * @brief Point in Jacobian coordinates (Montgomery representation)
+ **/
+
+typedef struct
+{
+   uint32_t x[8];
+   uint32_t y[8];
+   uint32_t z[8];
+} P256Point;
+
+
+/**
+ * @brief Point in affine coordinates (Montgomery representation)
+ **/
+
+typedef struct
+{
+   uint32_t x[8];
+   uint32_t y[8];
+} P256AffinePoint;
+
+
+//P-256 related constants
+extern const uint8_t SECP256R1_OID[8];
+extern const EcCurveInfo secp256r1Curve;
+
+//P-256 related functions
+error_t p256CheckPoint(const uint8_t *p, size_t length);
+error_t p256MulBase(uint8_t *r, const uint8_t *d);
+error_t p256Mul(uint8_t *r, const uint8_t *d, const uint8_t *p);
+error_t p256MulAdd(uint8_t *r, const uint8_t *u1, const uint8_t *u2, const uint8_t *q);
+
+#endif
@@ -34,11 +34,13 @@
 #include "dh.h"
 #include "rsa.h"
 #include "dsa.h"
+#include "ec.h"
 
 //PEM format decoding functions
 error_t pemReadDhParameters(const char_t *input, size_t length, DhParameters *params);
 error_t pemReadRsaPrivateKey(const char_t *input, size_t length, RsaPrivateKey *key);
 error_t pemReadDsaPrivateKey(const char_t *input, size_t length, DsaPrivateKey *key);
+error_t pemReadEcPrivateKey(const char_t *input, size_t length, EcPrivateKey *key);
 
 error_t pemReadCertificate(const char_t **input, size_t *inputLength,
    uint8_t **output, size_t *outputSize, size_t *outputLength);
@@ -161,6 +161,9 @@ error_t pbkdf2(const HashAlgo *hash, const uint8_t *p, size_t pLen,
       return ERROR_OUT_OF_MEMORY;
    }
 
+   //The padded password is digested only once
+   hmacInit(context, hash, p, pLen);
+
    //For each block of the derived key apply the function F
    for(i = 1; dkLen > 0; i++)
    {
@@ -171,7 +174,7 @@ error_t pbkdf2(const HashAlgo *hash, const uint8_t *p, size_t pLen,
       a[3] = i & 0xFF;
 
       //Compute U1 = PRF(P, S || INT(i))
-      hmacInit(context, hash, p, pLen);
+      hmacReset(context);
       hmacUpdate(context, s, sLen);
       hmacUpdate(context, a, 4);
       hmacFinal(context, u);
@@ -183,7 +186,7 @@ error_t pbkdf2(const HashAlgo *hash, const uint8_t *p, size_t pLen,
       for(j = 1; j < c; j++)
       {
          //Compute U(j) = PRF(P, U(j-1))
-         hmacInit(context, hash, p, pLen);
+         hmacReset(context);
          hmacUpdate(context, u, hash->digestSize);
          hmacFinal(context, u);
 
@@ -0,0 +1,288 @@
+/**
+ * @file poly1305.c
+ * @brief Poly1305 message-authentication code
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneCrypto Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL CRYPTO_TRACE_LEVEL
+
+//Dependencies
+#include <string.h>
+#include "crypto.h"
+#include "poly1305.h"
+
+//Check crypto library configuration
+#if (POLY1305_SUPPORT == ENABLED)
+
+//Forward declaration of functions
+static void poly1305ProcessBlock(Poly1305Context *context,
+   const uint8_t *data, uint32_t hibit);
+
+
+/**
+ * @brief Initialize Poly1305 message-authentication code computation
+ * @param[in] context Pointer to the Poly1305 context to initialize
+ * @param[in] key Pointer to the 256-bit one-time key
+ **/
+
+void poly1305Init(Poly1305Context *context, const uint8_t *key)
+{
+   //Clamp r and split it into five 26-bit limbs
+   context->r[0] = (LOAD32LE(key)) & 0x03FFFFFF;
+   context->r[1] = ((uint32_t) LOAD32LE(key + 3) >> 2) & 0x03FFFF03;
+   context->r[2] = ((uint32_t) LOAD32LE(key + 6) >> 4) & 0x03FFC0FF;
+   context->r[3] = ((uint32_t) LOAD32LE(key + 9) >> 6) & 0x03F03FFF;
+   context->r[4] = ((uint32_t) LOAD32LE(key + 12) >> 8) & 0x000FFFFF;
+
+   //The second half of the key is added at the end
+   context->s[0] = LOAD32LE(key + 16);
+   context->s[1] = LOAD32LE(key + 20);
+   context->s[2] = LOAD32LE(key + 24);
+   context->s[3] = LOAD32LE(key + 28);
+
+   //Clear the accumulator
+   context->h[0] = 0;
+   context->h[1] = 0;
+   context->h[2] = 0;
+   context->h[3] = 0;
+   context->h[4] = 0;
+
+   //The buffer is empty
+   context->size = 0;
+}
+
+
+/**
+ * @brief Update Poly1305 message-authentication code computation
+ * @param[in] context Pointer to the Poly1305 context
+ * @param[in] data Pointer to the input message
+ * @param[in] length Length of the input message
+ **/
+
+void poly1305Update(Poly1305Context *context, const void *data, size_t length)
+{
+   size_t n;
+   const uint8_t *p;
+
+   //Point to the input message
+   p = (const uint8_t *) data;
+
+   //Complete the pending block, if any
+   if(context->size > 0)
+   {
+      //Number of bytes that can be buffered
+      n = min(length, POLY1305_BLOCK_SIZE - context->size);
+      //Copy the data to the buffer
+      memcpy(context->buffer + context->size, p, n);
+
+      //Update the number of bytes in the buffer
+      context->size += n;
+      //Advance the data pointer
+      p += n;
+      //Remaining bytes to process
+      length -= n;
+
+      //Wait for more data if the block is still incomplete
+      if(context->size < POLY1305_BLOCK_SIZE)
+         return;
+
+      //Process the buffered block
+      poly1305ProcessBlock(context, context->buffer, 1UL << 24);
+      //Empty the buffer
+      context->size = 0;
+   }
+
+   //Process complete blocks directly from the input
+   while(length >= POLY1305_BLOCK_SIZE)
+   {
+      //Process the current block
+      poly1305ProcessBlock(context, p, 1UL << 24);
+
+      //Advance the data pointer
+      p += POLY1305_BLOCK_SIZE;
+      //Remaining bytes to process
+      length -= POLY1305_BLOCK_SIZE;
+   }
+
+   //Buffer the remaining bytes
+   if(length > 0)
+   {
+      memcpy(context->buffer, p, length);
+      context->size = length;
+   }
+}
+
+
+/**
+ * @brief Finish Poly1305 message-authentication code computation
+ * @param[in] context Pointer to the Poly1305 context
+ * @param[out] tag Calculated 128-bit tag
+ **/
+
+void poly1305Final(Poly1305Context *context, uint8_t *tag)
+{
+   uint32_t h0, h1, h2, h3, h4;
+   uint32_t g0, g1, g2, g3, g4;
+   uint32_t c;
+   uint32_t mask;
+   uint64_t f;
+
+   //Process the last partial block
+   if(context->size > 0)
+   {
+      //Append a single 1 byte and pad with zeroes
+      context->buffer[context->size] = 1;
+      memset(context->buffer + context->size + 1, 0,
+         POLY1305_BLOCK_SIZE - context->size - 1);
+
+      //The padding bit has already been set explicitly
+      poly1305ProcessBlock(context, context->buffer, 0);
+   }
+
+   //Load the accumulator
+   h0 = context->h[0];
+   h1 = context->h[1];
+   h2 = context->h[2];
+   h3 = context->h[3];
+   h4 = context->h[4];
+
+   //Fully carry h
+   c = h1 >> 26; h1 &= 0x03FFFFFF;
+   h2 += c; c = h2 >> 26; h2 &= 0x03FFFFFF;
+   h3 += c; c = h3 >> 26; h3 &= 0x03FFFFFF;
+   h4 += c; c = h4 >> 26; h4 &= 0x03FFFFFF;
+   h0 += c * 5; c = h0 >> 26; h0 &= 0x03FFFFFF;
+   h1 += c;
+
+   //Compute g = h + 5 - 2^130
+   g0 = h0 + 5; c = g0 >> 26; g0 &= 0x03FFFFFF;
+   g1 = h1 + c; c = g1 >> 26; g1 &= 0x03FFFFFF;
+   g2 = h2 + c; c = g2 >> 26; g2 &= 0x03FFFFFF;
+   g3 = h3 + c; c = g3 >> 26; g3 &= 0x03FFFFFF;
+   g4 = h4 + c - (1UL << 26);
+
+   //Select h if h < 2^130 - 5, g otherwise (constant time)
+   mask = (g4 >> 31) - 1;
+   g0 &= mask;
+   g1 &= mask;
+   g2 &= mask;
+   g3 &= mask;
+   g4 &= mask;
+   mask = ~mask;
+   h0 = (h0 & mask) | g0;
+   h1 = (h1 & mask) | g1;
+   h2 = (h2 & mask) | g2;
+   h3 = (h3 & mask) | g3;
+   h4 = (h4 & mask) | g4;
+
+   //Convert h to four 32-bit words
+   h0 = (h0) | (h1 << 26);
+   h1 = (h1 >> 6) | (h2 << 20);
+   h2 = (h2 >> 12) | (h3 << 14);
+   h3 = (h3 >> 18) | (h4 << 8);
+
+   //Compute the tag as (h + s) mod 2^128
+   f = (uint64_t) h0 + context->s[0];
+   STORE32LE((uint32_t) f, tag);
+   f = (uint64_t) h1 + context->s[1] + (f >> 32);
+   STORE32LE((uint32_t) f, tag + 4);
+   f = (uint64_t) h2 + context->s[2] + (f >> 32);
+   STORE32LE((uint32_t) f, tag + 8);
+   f = (uint64_t) h3 + context->s[3] + (f >> 32);
+   STORE32LE((uint32_t) f, tag + 12);
+
+   //Erase the key material
+   memset(context, 0, sizeof(Poly1305Context));
+}
+
+
+/**
+ * @brief Process a 16-byte block
+ * @param[in] context Pointer to the Poly1305 context
+ * @param[in] data Pointer to the 16-byte block
+ * @param[in] hibit Value of the bit 128 of the block (1 << 24 for full
+ *   blocks, 0 for a last block that has already been padded)
+ **/
+
+static void poly1305ProcessBlock(Poly1305Context *context,
+   const uint8_t *data, uint32_t hibit)
+{
+   uint32_t r0, r1, r2, r3, r4;
+   uint32_t s1, s2, s3, s4;
+   uint32_t h0, h1, h2, h3, h4;
+   uint64_t d0, d1, d2, d3, d4;
+   uint32_t c;
+
+   //Load r
+   r0 = context->r[0];
+   r1 = context->r[1];
+   r2 = context->r[2];
+   r3 = context->r[3];
+   r4 = context->r[4];
+
+   //Precompute 5 * r to fold the reduction modulo 2^130 - 5
+   s1 = r1 * 5;
+   s2 = r2 * 5;
+   s3 = r3 * 5;
+   s4 = r4 * 5;
+
+   //Add the block to the accumulator
+   h0 = context->h[0] + ((LOAD32LE(data)) & 0x03FFFFFF);
+   h1 = context->h[1] + (((uint32_t) LOAD32LE(data + 3) >> 2) & 0x03FFFFFF);
+   h2 = context->h[2] + (((uint32_t) LOAD32LE(data + 6) >> 4) & 0x03FFFFFF);
+   h3 = context->h[3] + (((uint32_t) LOAD32LE(data + 9) >> 6) & 0x03FFFFFF);
+   h4 = context->h[4] + (((uint32_t) LOAD32LE(data + 12) >> 8) | hibit);
+
+   //Compute h * r
+   d0 = (uint64_t) h0 * r0 + (uint64_t) h1 * s4 + (uint64_t) h2 * s3 +
+      (uint64_t) h3 * s2 + (uint64_t) h4 * s1;
+   d1 = (uint64_t) h0 * r1 + (uint64_t) h1 * r0 + (uint64_t) h2 * s4 +
+      (uint64_t) h3 * s3 + (uint64_t) h4 * s2;
+   d2 = (uint64_t) h0 * r2 + (uint64_t) h1 * r1 + (uint64_t) h2 * r0 +
+      (uint64_t) h3 * s4 + (uint64_t) h4 * s3;
+   d3 = (uint64_t) h0 * r3 + (uint64_t) h1 * r2 + (uint64_t) h2 * r1 +
+      (uint64_t) h3 * r0 + (uint64_t) h4 * s4;
+   d4 = (uint64_t) h0 * r4 + (uint64_t) h1 * r3 + (uint64_t) h2 * r2 +
+      (uint64_t) h3 * r1 + (uint64_t) h4 * r0;
+
+   //Partial reduction modulo 2^130 - 5
+   c = (uint32_t) (d0 >> 26); h0 = (uint32_t) d0 & 0x03FFFFFF;
+   d1 += c; c = (uint32_t) (d1 >> 26); h1 = (uint32_t) d1 & 0x03FFFFFF;
+   d2 += c; c = (uint32_t) (d2 >> 26); h2 = (uint32_t) d2 & 0x03FFFFFF;
+   d3 += c; c = (uint32_t) (d3 >> 26); h3 = (uint32_t) d3 & 0x03FFFFFF;
+   d4 += c; c = (uint32_t) (d4 >> 26); h4 = (uint32_t) d4 & 0x03FFFFFF;
+   h0 += c * 5; c = h0 >> 26; h0 &= 0x03FFFFFF;
+   h1 += c;
+
+   //Save the accumulator
+   context->h[0] = h0;
+   context->h[1] = h1;
+   context->h[2] = h2;
+   context->h[3] = h3;
+   context->h[4] = h4;
+}
+
+#endif
@@ -183,9 +183,9 @@ error_t rsadp(const RsaPrivateKey *key, const Mpi *c, Mpi *m)
       key->dp.size && key->dq.size && key->qinv.size)
    {
       //Compute m1 = c ^ dP mod p
-      MPI_CHECK(mpiExpMod(&m1, c, &key->dp, &key->p));
+      MPI_CHECK(mpiExpModRegular(&m1, c, &key->dp, &key->p));
       //Compute m2 = c ^ dQ mod q
-      MPI_CHECK(mpiExpMod(&m2, c, &key->dq, &key->q));
+      MPI_CHECK(mpiExpModRegular(&m2, c, &key->dq, &key->q));
       //Let h = (m1 - m2) * qInv mod p
       MPI_CHECK(mpiSub(&h, &m1, &m2));
       MPI_CHECK(mpiMulMod(&h, &h, &key->qinv, &key->p));
@@ -197,7 +197,7 @@ error_t rsadp(const RsaPrivateKey *key, const Mpi *c, Mpi *m)
    else if(key->n.size && key->d.size)
    {
       //Let m = c ^ d mod n
-      error = mpiExpMod(m, c, &key->d, &key->n);
+      error = mpiExpModRegular(m, c, &key->d, &key->n);
    }
    //Invalid parameters?
    else
@@ -406,7 +406,6 @@ error_t rsaesPkcs1v15Decrypt(const RsaPrivateKey *key, const uint8_t *ciphertext
    size_t ciphertextLength, uint8_t *message, size_t messageSize, size_t *messageLength)
 {
    error_t error;
-   uint_t i;
    uint_t k;
    uint8_t *em;
    Mpi c;
@@ -477,38 +476,10 @@ error_t rsaesPkcs1v15Decrypt(const RsaPrivateKey *key, const uint8_t *ciphertext
       TRACE_DEBUG("  Encoded message\r\n");
       TRACE_DEBUG_ARRAY("    ", em, k);
 
-      //The first octet of EM must have a value of 0x00
-      //and the block type BT shall be 0x02
-      if(em[0] != 0x00 || em[1] != 0x02)
-      {
-         //Report an error
-         error = ERROR_UNEXPECTED_VALUE;
-         break;
-      }
-
-      //An octet with hexadecimal value 0x00 is used to separate PS from M
-      for(i = 2; i < k && em[i] != 0x00; i++);
-
-      //Check whether the padding string is valid
-      if(i < 10 || i >= k)
-      {
-         //Report an error
-         error = ERROR_INVALID_PADDING;
-         break;
-      }
-
-      //Ensure that the output buffer is large enough
-      if(messageSize < (k - i - 1))
-      {
-         //Report an error
-         error = ERROR_INVALID_LENGTH;
-         break;
-      }
-
-      //Recover the length of the message
-      *messageLength = k - i - 1;
-      //Copy the message contents
-      memcpy(message, em + i + 1, *messageLength);
+      //Apply the EME-PKCS1-v1_5 decoding operation
+      error = emePkcs1v15Decode(em, k, message, messageSize, messageLength);
+      //Any error to report?
+      if(error) break;
 
       //Debug message
       TRACE_DEBUG("  Message:\r\n");
@@ -736,6 +707,47 @@ error_t rsassaPkcs1v15Verify(const RsaPublicKey *key, const HashAlgo *hash,
 }
 
 
+/**
+ * @brief PKCS #1 v1.5 decoding method (encryption scheme)
+ * @param[in] em Encoded message
+ * @param[in] emLength Length of the encoded message
+ * @param[out] message Output buffer where to store the decoded message
+ * @param[in] messageSize Size of the output buffer
+ * @param[out] messageLength Length of the decoded message
+ * @return Error code
+ **/
+
+error_t emePkcs1v15Decode(const uint8_t *em, size_t emLength,
+   uint8_t *message, size_t messageSize, size_t *messageLength)
+{
+   size_t i;
+
+   //The first octet of EM must have a value of 0x00
+   //and the block type BT shall be 0x02
+   if(emLength < 11 || em[0] != 0x00 || em[1] != 0x02)
+      return ERROR_UNEXPECTED_VALUE;
+
+   //An octet with hexadecimal value 0x00 is used to separate PS from M
+   for(i = 2; i < emLength && em[i] != 0x00; i++);
+
+   //Check whether the padding string is valid
+   if(i < 10 || i >= emLength)
+      return ERROR_INVALID_PADDING;
+
+   //Ensure that the output buffer is large enough
+   if(messageSize < (emLength - i - 1))
+      return ERROR_INVALID_LENGTH;
+
+   //Recover the length of the message
+   *messageLength = emLength - i - 1;
+   //Copy the message contents
+   memcpy(message, em + i + 1, *messageLength);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
 /**
  * @brief PKCS #1 v1.5 encoding method
  * @param[in] hash Hash function used to digest the message
@@ -95,6 +95,9 @@ error_t rsassaPkcs1v15Sign(const RsaPrivateKey *key, const HashAlgo *hash,
 error_t rsassaPkcs1v15Verify(const RsaPublicKey *key, const HashAlgo *hash,
    const uint8_t *digest, const uint8_t *signature, size_t signatureLength);
 
+error_t emePkcs1v15Decode(const uint8_t *em, size_t emLength,
+   uint8_t *message, size_t messageSize, size_t *messageLength);
+
 error_t emsaPkcs1v15Encode(const HashAlgo *hash,
    const uint8_t *digest, uint8_t *em, size_t emLength);
 
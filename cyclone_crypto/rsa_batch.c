@@ -0,0 +1,758 @@
+/**
+ * @file rsa_batch.c
+ * @brief Batched RSA private-key operations
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneCrypto Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * When many connections are established at the same time, the server
+ * spends most of its time in RSA private-key operations. The pending
+ * operations are queued and processed together by a worker task: the
+ * Montgomery parameters of both factors are computed once per key, the
+ * exponentiations modulo p and q are performed in lockstep over the whole
+ * batch, and the cost of RSA blinding is amortized by updating the
+ * blinding pair by squaring instead of generating a new one for every
+ * operation
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL CRYPTO_TRACE_LEVEL
+
+//Dependencies
+#include <string.h>
+#include "crypto.h"
+#include "rsa.h"
+#include "rsa_batch.h"
+#include "mpi.h"
+#include "debug.h"
+
+//Check crypto library configuration
+#if (RSA_BATCH_SUPPORT == ENABLED)
+
+//Forward declaration of functions
+static error_t rsaBatchGenerateBlinding(RsaBatchContext *context);
+
+static void rsaBatchProcess(RsaBatchContext *context,
+   RsaBatchRequest *request[], uint_t count);
+
+
+/**
+ * @brief Initialize a RSA batch context
+ * @param[out] context Pointer to the RSA batch context
+ * @param[in] key RSA private key (the CRT parameters are required)
+ * @param[in] prngAlgo PRNG algorithm used for RSA blinding (optional)
+ * @param[in] prngContext Pointer to the PRNG context
+ * @return Error code
+ **/
+
+error_t rsaBatchInit(RsaBatchContext *context, const RsaPrivateKey *key,
+   const PrngAlgo *prngAlgo, void *prngContext)
+{
+   error_t error;
+
+   //Check parameters
+   if(context == NULL || key == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Clear the RSA batch context
+   memset(context, 0, sizeof(RsaBatchContext));
+
+   //Initialize RSA private key
+   rsaInitPrivateKey(&context->key);
+   //Initialize blinding pair
+   mpiInit(&context->vi);
+   mpiInit(&context->vf);
+
+   //Batch processing relies on the Chinese remainder algorithm
+   if(!key->n.size || !key->p.size || !key->q.size ||
+      !key->dp.size || !key->dq.size || !key->qinv.size)
+   {
+      return ERROR_INVALID_KEY;
+   }
+
+   //Save the PRNG used to generate blinding values
+   context->prngAlgo = prngAlgo;
+   context->prngContext = prngContext;
+
+   //Save the RSA private key
+   MPI_CHECK(mpiCopy(&context->key.n, &key->n));
+   MPI_CHECK(mpiCopy(&context->key.e, &key->e));
+   MPI_CHECK(mpiCopy(&context->key.d, &key->d));
+   MPI_CHECK(mpiCopy(&context->key.p, &key->p));
+   MPI_CHECK(mpiCopy(&context->key.q, &key->q));
+   MPI_CHECK(mpiCopy(&context->key.dp, &key->dp));
+   MPI_CHECK(mpiCopy(&context->key.dq, &key->dq));
+   MPI_CHECK(mpiCopy(&context->key.qinv, &key->qinv));
+
+   //The Montgomery parameters are computed once and shared by all
+   //the private-key operations
+   MPI_CHECK(mpiMontgomeryInit(&context->nContext, &key->n));
+   MPI_CHECK(mpiMontgomeryInit(&context->pContext, &key->p));
+   MPI_CHECK(mpiMontgomeryInit(&context->qContext, &key->q));
+
+   //Create a mutex to protect the request queue
+   context->mutex = osMutexCreate(FALSE);
+   //Out of resources?
+   if(context->mutex == OS_INVALID_HANDLE)
+      MPI_CHECK(ERROR_OUT_OF_RESOURCES);
+
+   //Create the events used to communicate with the worker
+   context->event = osEventCreate(FALSE, FALSE);
+   context->ackEvent = osEventCreate(FALSE, FALSE);
+
+   //Out of resources?
+   if(context->event == OS_INVALID_HANDLE || context->ackEvent == OS_INVALID_HANDLE)
+      MPI_CHECK(ERROR_OUT_OF_RESOURCES);
+
+end:
+   //Any error to report?
+   if(error)
+      rsaBatchFree(context);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Release a RSA batch context
+ *
+ * The worker must have been stopped beforehand
+ *
+ * @param[in] context Pointer to the RSA batch context
+ **/
+
+void rsaBatchFree(RsaBatchContext *context)
+{
+   //Invalid context?
+   if(context == NULL)
+      return;
+
+   //Release Montgomery contexts
+   mpiMontgomeryFree(&context->nContext);
+   mpiMontgomeryFree(&context->pContext);
+   mpiMontgomeryFree(&context->qContext);
+
+   //Release RSA private key
+   rsaFreePrivateKey(&context->key);
+   //Release blinding pair
+   mpiFree(&context->vi);
+   mpiFree(&context->vf);
+
+   //Close mutex and event objects
+   if(context->mutex != OS_INVALID_HANDLE)
+      osMutexClose(context->mutex);
+   if(context->event != OS_INVALID_HANDLE)
+      osEventClose(context->event);
+   if(context->ackEvent != OS_INVALID_HANDLE)
+      osEventClose(context->ackEvent);
+
+   //Clear the RSA batch context
+   memset(context, 0, sizeof(RsaBatchContext));
+}
+
+
+/**
+ * @brief Start the worker that processes queued operations
+ * @param[in] context Pointer to the RSA batch context
+ * @return Error code
+ **/
+
+error_t rsaBatchStart(RsaBatchContext *context)
+{
+   OsTask *task;
+
+   //Ensure the specified pointer is valid
+   if(context == NULL)
+      return ERROR_INVALID_PARAMETER;
+   //Check the state of the worker
+   if(context->running)
+      return ERROR_WRONG_STATE;
+
+   //Debug message
+   TRACE_INFO("Starting RSA batch worker...\r\n");
+
+   //The worker is about to run
+   context->running = TRUE;
+   context->stopRequest = FALSE;
+
+   //Create the worker task
+   task = osTaskCreate("RSA Batch", rsaBatchTask,
+      context, RSA_BATCH_STACK_SIZE, RSA_BATCH_PRIORITY);
+
+   //Unable to create the task?
+   if(task == OS_INVALID_HANDLE)
+   {
+      //Requests will be processed synchronously
+      context->running = FALSE;
+      //Report an error
+      return ERROR_OUT_OF_RESOURCES;
+   }
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Stop the worker
+ *
+ * Pending operations are completed before the worker terminates. Further
+ * operations are processed synchronously by the calling task
+ *
+ * @param[in] context Pointer to the RSA batch context
+ * @return Error code
+ **/
+
+error_t rsaBatchStop(RsaBatchContext *context)
+{
+   //Ensure the specified pointer is valid
+   if(context == NULL)
+      return ERROR_INVALID_PARAMETER;
+   //Check the state of the worker
+   if(!context->running)
+      return ERROR_WRONG_STATE;
+
+   //Debug message
+   TRACE_INFO("Stopping RSA batch worker...\r\n");
+
+   //Reset ACK event before sending the kill signal
+   osEventReset(context->ackEvent);
+
+   //Stop accepting new requests
+   osMutexAcquire(context->mutex);
+   context->stopRequest = TRUE;
+   osMutexRelease(context->mutex);
+
+   //Wake up the worker
+   osEventSet(context->event);
+   //Wait for the worker to terminate...
+   osEventWait(context->ackEvent, INFINITE_DELAY);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief RSA private-key primitive (RSADP/RSASP1)
+ *
+ * The operation is queued and the calling task is blocked until the worker
+ * has processed the batch it belongs to. When the worker is not running,
+ * the operation is performed by the calling task
+ *
+ * @param[in] context Pointer to the RSA batch context
+ * @param[in] c Ciphertext (or message) representative
+ * @param[out] m Message (or signature) representative
+ * @return Error code
+ **/
+
+error_t rsaBatchPrivateOp(RsaBatchContext *context, const Mpi *c, Mpi *m)
+{
+   RsaBatchRequest request;
+   RsaBatchRequest *p;
+
+   //Check parameters
+   if(context == NULL || c == NULL || m == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Format the request
+   request.next = NULL;
+   request.input = c;
+   request.output = m;
+   request.error = NO_ERROR;
+
+   //Create an event to be signaled upon completion
+   request.event = osEventCreate(FALSE, FALSE);
+   //Out of resources?
+   if(request.event == OS_INVALID_HANDLE)
+      return ERROR_OUT_OF_RESOURCES;
+
+   //Acquire exclusive access to the RSA batch context
+   osMutexAcquire(context->mutex);
+
+   //Check whether the worker accepts requests
+   if(context->running && !context->stopRequest)
+   {
+      //Append the request to the queue
+      if(context->tail != NULL)
+         context->tail->next = &request;
+      else
+         context->head = &request;
+
+      //Update the tail of the queue
+      context->tail = &request;
+
+      //Release exclusive access to the RSA batch context
+      osMutexRelease(context->mutex);
+
+      //Notify the worker
+      osEventSet(context->event);
+      //Wait for the request to be processed
+      osEventWait(request.event, INFINITE_DELAY);
+   }
+   else
+   {
+      //Process the request immediately
+      p = &request;
+      rsaBatchProcess(context, &p, 1);
+
+      //Release exclusive access to the RSA batch context
+      osMutexRelease(context->mutex);
+   }
+
+   //Close event object
+   osEventClose(request.event);
+
+   //Return status code
+   return request.error;
+}
+
+
+/**
+ * @brief PKCS #1 v1.5 decryption operation using a RSA batch context
+ * @param[in] context Pointer to the RSA batch context
+ * @param[in] ciphertext Ciphertext to be decrypted
+ * @param[in] ciphertextLength Length of the ciphertext to be decrypted
+ * @param[out] message Output buffer where to store the decrypted message
+ * @param[in] messageSize Size of the output buffer
+ * @param[out] messageLength Length of the decrypted message
+ * @return Error code
+ **/
+
+error_t rsaBatchDecrypt(RsaBatchContext *context, const uint8_t *ciphertext,
+   size_t ciphertextLength, uint8_t *message, size_t messageSize, size_t *messageLength)
+{
+   error_t error;
+   uint_t k;
+   uint8_t *em;
+   Mpi c;
+   Mpi m;
+
+   //Check parameters
+   if(context == NULL || ciphertext == NULL)
+      return ERROR_INVALID_PARAMETER;
+   if(message == NULL || messageLength == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Get the length in octets of the modulus n
+   k = mpiGetByteLength(&context->key.n);
+
+   //Check the length of the ciphertext
+   if(ciphertextLength != k || ciphertextLength < 11)
+      return ERROR_INVALID_LENGTH;
+
+   //Allocate a buffer to store the encoded message EM
+   em = osMemAlloc(k);
+   //Failed to allocate memory?
+   if(!em) return ERROR_OUT_OF_MEMORY;
+
+   //Initialize multiple-precision integers
+   mpiInit(&c);
+   mpiInit(&m);
+
+   //Start of exception handling block
+   do
+   {
+      //Convert the ciphertext to an integer ciphertext representative c
+      error = mpiReadRaw(&c, ciphertext, ciphertextLength);
+      //Conversion failed?
+      if(error) break;
+
+      //Apply the RSADP decryption primitive
+      error = rsaBatchPrivateOp(context, &c, &m);
+      //Any error to report?
+      if(error) break;
+
+      //Convert the message representative m to an encoded message EM of length k octets
+      error = mpiWriteRaw(&m, em, k);
+      //Conversion failed?
+      if(error) break;
+
+      //Apply the EME-PKCS1-v1_5 decoding operation
+      error = emePkcs1v15Decode(em, k, message, messageSize, messageLength);
+
+      //End of exception handling block
+   } while(0);
+
+   //Release multiple precision integers
+   mpiFree(&c);
+   mpiFree(&m);
+
+   //Erase contents before releasing memory
+   memset(em, 0, k);
+   osMemFree(em);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief PKCS #1 v1.5 signature generation using a RSA batch context
+ * @param[in] context Pointer to the RSA batch context
+ * @param[in] hash Hash function used to digest the message
+ * @param[in] digest Digest of the message to be signed
+ * @param[out] signature Resulting signature
+ * @param[out] signatureLength Length of the resulting signature
+ * @return Error code
+ **/
+
+error_t rsaBatchSign(RsaBatchContext *context, const HashAlgo *hash,
+   const uint8_t *digest, uint8_t *signature, size_t *signatureLength)
+{
+   error_t error;
+   uint_t k;
+   Mpi m;
+   Mpi s;
+
+   //Check parameters
+   if(context == NULL || hash == NULL || digest == NULL)
+      return ERROR_INVALID_PARAMETER;
+   if(signature == NULL || signatureLength == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Get the length in octets of the modulus n
+   k = mpiGetByteLength(&context->key.n);
+
+   //Apply the EMSA-PKCS1-v1.5 encoding operation
+   error = emsaPkcs1v15Encode(hash, digest, signature, k);
+   //Any error to report?
+   if(error) return error;
+
+   //Initialize multiple-precision integers
+   mpiInit(&m);
+   mpiInit(&s);
+
+   //Start of exception handling block
+   do
+   {
+      //Convert the encoded message EM to an integer message representative m
+      error = mpiReadRaw(&m, signature, k);
+      //Conversion failed?
+      if(error) break;
+
+      //Apply the RSASP1 signature primitive
+      error = rsaBatchPrivateOp(context, &m, &s);
+      //Any error to report?
+      if(error) break;
+
+      //Convert the signature representative s to a signature of length k octets
+      error = mpiWriteRaw(&s, signature, k);
+      //Conversion failed?
+      if(error) break;
+
+      //Length of the resulting signature
+      *signatureLength = k;
+
+      //End of exception handling block
+   } while(0);
+
+   //Free previously allocated memory
+   mpiFree(&m);
+   mpiFree(&s);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief RSA batch worker
+ * @param[in] param Pointer to the RSA batch context
+ **/
+
+void rsaBatchTask(void *param)
+{
+   uint_t i;
+   uint_t count;
+   RsaBatchRequest *request[RSA_BATCH_MAX_SIZE];
+
+   //Point to the RSA batch context
+   RsaBatchContext *context = (RsaBatchContext *) param;
+
+   //Main loop
+   while(1)
+   {
+      //Wait for incoming requests
+      osEventWait(context->event, INFINITE_DELAY);
+
+      //Process the pending requests
+      while(1)
+      {
+         //Acquire exclusive access to the RSA batch context
+         osMutexAcquire(context->mutex);
+
+         //Dequeue as many requests as possible
+         for(count = 0; count < RSA_BATCH_MAX_SIZE && context->head != NULL; count++)
+         {
+            request[count] = context->head;
+            context->head = context->head->next;
+         }
+
+         //Empty queue?
+         if(context->head == NULL)
+            context->tail = NULL;
+
+         //Stop request?
+         if(!count && context->stopRequest)
+         {
+            //The worker is about to stop
+            context->stopRequest = FALSE;
+            context->running = FALSE;
+
+            //Release exclusive access to the RSA batch context
+            osMutexRelease(context->mutex);
+
+            //Acknowledge the reception of the user request
+            osEventSet(context->ackEvent);
+            //Kill ourselves
+            osTaskDelete(NULL);
+         }
+
+         //Process the requests as a single batch. The blinding pair is
+         //shared with the synchronous path, hence the mutex
+         if(count)
+            rsaBatchProcess(context, request, count);
+
+         //Release exclusive access to the RSA batch context
+         osMutexRelease(context->mutex);
+
+         //The queue has been drained?
+         if(!count) break;
+
+         //Wake up the tasks whose requests have been processed
+         for(i = 0; i < count; i++)
+            osEventSet(request[i]->event);
+      }
+   }
+}
+
+
+/**
+ * @brief Generate a new blinding pair
+ *
+ * A random value r is chosen and the pair (r^e mod n, r^-1 mod n)
+ * is computed
+ *
+ * @param[in] context Pointer to the RSA batch context
+ * @return Error code
+ **/
+
+static error_t rsaBatchGenerateBlinding(RsaBatchContext *context)
+{
+   error_t error;
+   Mpi r;
+
+   //Initialize multiple precision integer
+   mpiInit(&r);
+
+   do
+   {
+      //Generate a random value r lower than n
+      MPI_CHECK(mpiRand(&r, mpiGetBitLength(&context->key.n) - 1,
+         context->prngAlgo, context->prngContext));
+
+      //Compute r^-1 mod n (r must be coprime with n)
+      error = mpiInvMod(&context->vf, &r, &context->key.n);
+
+      //Any unexpected error to report?
+      if(error != NO_ERROR && error != ERROR_FAILURE)
+         goto end;
+
+      //Repeat until r is invertible
+   } while(error);
+
+   //Compute r^e mod n
+   MPI_CHECK(mpiExpMod(&context->vi, &r, &context->key.e, &context->key.n));
+
+end:
+   //Erase the random value before releasing memory
+   if(r.data != NULL)
+      memset(r.data, 0, r.size * MPI_INT_SIZE);
+
+   //Release multiple precision integer
+   mpiFree(&r);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Process a batch of private-key operations
+ *
+ * The exponentiations modulo p and q are performed in lockstep for all the
+ * requests, and the results are recombined using the Chinese remainder
+ * algorithm. The status code of each request is updated
+ *
+ * @param[in] context Pointer to the RSA batch context
+ * @param[in] request Requests to be processed
+ * @param[in] count Number of requests (at most RSA_BATCH_MAX_SIZE)
+ **/
+
+static void rsaBatchProcess(RsaBatchContext *context,
+   RsaBatchRequest *request[], uint_t count)
+{
+   error_t error;
+   uint_t i;
+   uint_t n;
+   Mpi h;
+   Mpi c[RSA_BATCH_MAX_SIZE];
+   Mpi u[RSA_BATCH_MAX_SIZE];
+   Mpi m1[RSA_BATCH_MAX_SIZE];
+   Mpi m2[RSA_BATCH_MAX_SIZE];
+   const Mpi *pc[RSA_BATCH_MAX_SIZE];
+   Mpi *pm1[RSA_BATCH_MAX_SIZE];
+   Mpi *pm2[RSA_BATCH_MAX_SIZE];
+   RsaBatchRequest *valid[RSA_BATCH_MAX_SIZE];
+
+   //Initialize status code
+   error = NO_ERROR;
+
+   //Initialize multiple precision integers
+   mpiInit(&h);
+
+   for(i = 0; i < count; i++)
+   {
+      mpiInit(&c[i]);
+      mpiInit(&u[i]);
+      mpiInit(&m1[i]);
+      mpiInit(&m2[i]);
+
+      //The batch primitive takes arrays of pointers
+      pc[i] = &c[i];
+      pm1[i] = &m1[i];
+      pm2[i] = &m2[i];
+   }
+
+   //Filter out invalid requests
+   for(n = 0, i = 0; i < count; i++)
+   {
+      //The representative shall be between 0 and n - 1
+      if(mpiCompInt(request[i]->input, 0) < 0 ||
+         mpiComp(request[i]->input, &context->key.n) >= 0)
+      {
+         //Report an error
+         request[i]->error = ERROR_OUT_OF_RANGE;
+      }
+      else
+      {
+         //Add the request to the batch
+         valid[n++] = request[i];
+      }
+   }
+
+   //Nothing to process?
+   if(!n) goto end;
+
+   //Prepare the input of each exponentiation
+   for(i = 0; i < n; i++)
+   {
+      //RSA blinding?
+      if(context->prngAlgo != NULL)
+      {
+         //Time to generate a new blinding pair?
+         if(!context->blindingCount ||
+            context->blindingCount >= RSA_BATCH_BLINDING_REFRESH)
+         {
+            MPI_CHECK(rsaBatchGenerateBlinding(context));
+            context->blindingCount = 0;
+         }
+         else
+         {
+            //Squaring the previous pair is much cheaper than generating
+            //a new one and still gives a different blinding value
+            MPI_CHECK(mpiMontgomeryMulMod(&context->nContext,
+               &context->vi, &context->vi, &context->vi));
+            MPI_CHECK(mpiMontgomeryMulMod(&context->nContext,
+               &context->vf, &context->vf, &context->vf));
+         }
+
+         //Update the usage counter
+         context->blindingCount++;
+
+         //Blind the input (c = c * r^e mod n)
+         MPI_CHECK(mpiMontgomeryMulMod(&context->nContext,
+            &c[i], valid[i]->input, &context->vi));
+         //Save the matching unblinding value
+         MPI_CHECK(mpiCopy(&u[i], &context->vf));
+      }
+      else
+      {
+         //Use the input as is
+         MPI_CHECK(mpiCopy(&c[i], valid[i]->input));
+      }
+   }
+
+   //Compute m1 = c ^ dP mod p for each request
+   MPI_CHECK(mpiMontgomeryExpModBatch(&context->pContext, pm1, pc, &context->key.dp, n));
+   //Compute m2 = c ^ dQ mod q for each request
+   MPI_CHECK(mpiMontgomeryExpModBatch(&context->qContext, pm2, pc, &context->key.dq, n));
+
+   //Recombine the results
+   for(i = 0; i < n; i++)
+   {
+      //Let h = m1 - m2
+      MPI_CHECK(mpiSub(&h, &m1[i], &m2[i]));
+
+      //Make sure h is non-negative
+      while(h.sign < 0)
+      {
+         MPI_CHECK(mpiAdd(&h, &h, &context->key.p));
+      }
+
+      //Let h = h * qInv mod p
+      MPI_CHECK(mpiMontgomeryMulMod(&context->pContext, &h, &h, &context->key.qinv));
+      //Let m = m2 + q * h
+      MPI_CHECK(mpiMul(valid[i]->output, &context->key.q, &h));
+      MPI_CHECK(mpiAdd(valid[i]->output, valid[i]->output, &m2[i]));
+
+      //Remove the blinding factor (m = m * r^-1 mod n)
+      if(context->prngAlgo != NULL)
+      {
+         MPI_CHECK(mpiMontgomeryMulMod(&context->nContext,
+            valid[i]->output, valid[i]->output, &u[i]));
+      }
+   }
+
+end:
+   //Update the status code of the valid requests
+   for(i = 0; i < n; i++)
+      valid[i]->error = error;
+
+   //Release multiple precision integers
+   mpiFree(&h);
+
+   for(i = 0; i < count; i++)
+   {
+      mpiFree(&c[i]);
+      mpiFree(&u[i]);
+      mpiFree(&m1[i]);
+      mpiFree(&m2[i]);
+   }
+}
+
+#endif
@@ -0,0 +1,128 @@
+/**
+ * @file rsa_batch.h
+ * @brief Batched RSA private-key operations
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneCrypto Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+#ifndef _RSA_BATCH_H
+#define _RSA_BATCH_H
+
+//Dependencies
+#include "crypto.h"
+#include "rsa.h"
+#include "mpi.h"
+
+//Maximum number of private-key operations processed together
+#ifndef RSA_BATCH_MAX_SIZE
+   #define RSA_BATCH_MAX_SIZE 8
+#elif (RSA_BATCH_MAX_SIZE < 1)
+   #error RSA_BATCH_MAX_SIZE parameter is invalid
+#endif
+
+//Number of operations that share the same blinding pair
+#ifndef RSA_BATCH_BLINDING_REFRESH
+   #define RSA_BATCH_BLINDING_REFRESH 32
+#elif (RSA_BATCH_BLINDING_REFRESH < 1)
+   #error RSA_BATCH_BLINDING_REFRESH parameter is invalid
+#endif
+
+//Stack size required to run the RSA batch worker
+#ifndef RSA_BATCH_STACK_SIZE
+   #define RSA_BATCH_STACK_SIZE 650
+#elif (RSA_BATCH_STACK_SIZE < 1)
+   #error RSA_BATCH_STACK_SIZE parameter is invalid
+#endif
+
+//Priority at which the RSA batch worker should run
+#ifndef RSA_BATCH_PRIORITY
+   #define RSA_BATCH_PRIORITY 1
+#elif (RSA_BATCH_PRIORITY < 0)
+   #error RSA_BATCH_PRIORITY parameter is invalid
+#endif
+
+
+/**
+ * @brief Pending private-key operation
+ **/
+
+typedef struct _RsaBatchRequest
+{
+   struct _RsaBatchRequest *next; ///<Next request in the queue
+   const Mpi *input;              ///<Ciphertext or message representative
+   Mpi *output;                   ///<Message or signature representative
+   OsEvent *event;                ///<Event signaled upon completion
+   error_t error;                 ///<Status code
+} RsaBatchRequest;
+
+
+/**
+ * @brief RSA batch context
+ *
+ * The context holds everything that depends only on the private key, so
+ * that it can be shared by all the connections that use this key
+ *
+ **/
+
+typedef struct
+{
+   RsaPrivateKey key;               ///<RSA private key
+   MpiMontgomeryContext nContext;   ///<Montgomery context for the modulus
+   MpiMontgomeryContext pContext;   ///<Montgomery context for the first factor
+   MpiMontgomeryContext qContext;   ///<Montgomery context for the second factor
+   const PrngAlgo *prngAlgo;        ///<PRNG used to generate blinding values
+   void *prngContext;               ///<PRNG context
+   Mpi vi;                          ///<Blinding value r^e mod n
+   Mpi vf;                          ///<Unblinding value r^-1 mod n
+   uint_t blindingCount;            ///<Number of operations performed with the current blinding pair
+   OsMutex *mutex;                  ///<Mutex preventing simultaneous access to the context
+   OsEvent *event;                  ///<Event used to wake up the worker
+   OsEvent *ackEvent;               ///<Event used to acknowledge a stop request
+   bool_t running;                  ///<The worker is currently running
+   bool_t stopRequest;              ///<Stop request
+   RsaBatchRequest *head;           ///<First pending request
+   RsaBatchRequest *tail;           ///<Last pending request
+} RsaBatchContext;
+
+
+//RSA batch related functions
+error_t rsaBatchInit(RsaBatchContext *context, const RsaPrivateKey *key,
+   const PrngAlgo *prngAlgo, void *prngContext);
+
+void rsaBatchFree(RsaBatchContext *context);
+
+error_t rsaBatchStart(RsaBatchContext *context);
+error_t rsaBatchStop(RsaBatchContext *context);
+
+error_t rsaBatchPrivateOp(RsaBatchContext *context, const Mpi *c, Mpi *m);
+
+error_t rsaBatchDecrypt(RsaBatchContext *context, const uint8_t *ciphertext,
+   size_t ciphertextLength, uint8_t *message, size_t messageSize, size_t *messageLength);
+
+error_t rsaBatchSign(RsaBatchContext *context, const HashAlgo *hash,
+   const uint8_t *digest, uint8_t *signature, size_t *signatureLength);
+
+void rsaBatchTask(void *param);
+
+#endif
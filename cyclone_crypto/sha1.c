@@ -39,6 +39,12 @@
 #include "crypto.h"
 #include "sha1.h"
 
+#if (SHA1_NI_SUPPORT == ENABLED)
+   #include <immintrin.h>
+#elif (SHA1_ARMV8_SUPPORT == ENABLED)
+   #include <arm_neon.h>
+#endif
+
 //Check crypto library configuration
 #if (SHA1_SUPPORT == ENABLED)
 
@@ -212,6 +218,136 @@ void sha1Final(Sha1Context *context, uint8_t *digest)
 }
 
 
+#if (SHA1_NI_SUPPORT == ENABLED)
+
+/**
+ * @brief Process message in 16-word blocks (SHA-NI)
+ * @param[in] context Pointer to the SHA-1 context
+ **/
+
+void sha1ProcessBlock(Sha1Context *context)
+{
+   uint_t t;
+   __m128i abcd;
+   __m128i abcdSave;
+   __m128i e0;
+   __m128i e1;
+   __m128i w[4];
+   const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090A0B0C0D0E0FULL);
+
+   //Load the hash value (A is held in the most significant word)
+   abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) context->h), 0x1B);
+   e0 = _mm_set_epi32(context->h[4], 0, 0, 0);
+
+   //Save the current hash value
+   abcdSave = abcd;
+
+   //Each iteration processes four rounds
+   for(t = 0; t < 20; t++)
+   {
+      //Prepare the message schedule
+      if(t < 4)
+      {
+         w[t] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (context->buffer + 16 * t)), mask);
+      }
+      else
+      {
+         w[t % 4] = _mm_sha1msg1_epu32(w[t % 4], w[(t + 1) % 4]);
+         w[t % 4] = _mm_xor_si128(w[t % 4], w[(t + 2) % 4]);
+         w[t % 4] = _mm_sha1msg2_epu32(w[t % 4], w[(t + 3) % 4]);
+      }
+
+      //Compute E for the next four rounds
+      if(t == 0)
+         e0 = _mm_add_epi32(e0, w[0]);
+      else
+         e0 = _mm_sha1nexte_epu32(e1, w[t % 4]);
+
+      //Save A, which is needed to compute the next value of E
+      e1 = abcd;
+
+      //The round function depends on the current step
+      if(t < 5)
+         abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+      else if(t < 10)
+         abcd = _mm_sha1rnds4_epu32(abcd, e0, 1);
+      else if(t < 15)
+         abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+      else
+         abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+   }
+
+   //Update the hash value
+   e0 = _mm_sha1nexte_epu32(e1, _mm_set_epi32(context->h[4], 0, 0, 0));
+   abcd = _mm_add_epi32(abcd, abcdSave);
+
+   //Save the resulting hash value
+   _mm_storeu_si128((__m128i *) context->h, _mm_shuffle_epi32(abcd, 0x1B));
+   context->h[4] = _mm_extract_epi32(e0, 3);
+}
+
+#elif (SHA1_ARMV8_SUPPORT == ENABLED)
+
+/**
+ * @brief Process message in 16-word blocks (ARMv8 cryptographic extension)
+ * @param[in] context Pointer to the SHA-1 context
+ **/
+
+void sha1ProcessBlock(Sha1Context *context)
+{
+   uint_t t;
+   uint32_t e0;
+   uint32_t e1;
+   uint32x4_t abcd;
+   uint32x4_t abcdSave;
+   uint32x4_t temp;
+   uint32x4_t w[4];
+
+   //Load the hash value
+   abcd = vld1q_u32(context->h);
+   e0 = context->h[4];
+
+   //Save the current hash value
+   abcdSave = abcd;
+
+   //Each iteration processes four rounds
+   for(t = 0; t < 20; t++)
+   {
+      //Prepare the message schedule
+      if(t < 4)
+      {
+         w[t] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(context->buffer + 16 * t)));
+      }
+      else
+      {
+         w[t % 4] = vsha1su0q_u32(w[t % 4], w[(t + 1) % 4], w[(t + 2) % 4]);
+         w[t % 4] = vsha1su1q_u32(w[t % 4], w[(t + 3) % 4]);
+      }
+
+      //Add the round constant
+      temp = vaddq_u32(w[t % 4], vdupq_n_u32(k[t / 5]));
+      //Compute E for the next four rounds
+      e1 = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+
+      //The round function depends on the current step
+      if(t < 5)
+         abcd = vsha1cq_u32(abcd, e0, temp);
+      else if(t < 10 || t >= 15)
+         abcd = vsha1pq_u32(abcd, e0, temp);
+      else
+         abcd = vsha1mq_u32(abcd, e0, temp);
+
+      //Update E
+      e0 = e1;
+   }
+
+   //Update the hash value
+   vst1q_u32(context->h, vaddq_u32(abcd, abcdSave));
+   context->h[4] += e0;
+}
+
+#else
+
 /**
  * @brief Process message in 16-word blocks
  * @param[in] context Pointer to the SHA-1 context
@@ -274,3 +410,4 @@ void sha1ProcessBlock(Sha1Context *context)
 }
 
 #endif
+#endif
@@ -32,6 +32,30 @@
 //Dependencies
 #include "crypto.h"
 
+//SHA-NI instruction set support
+#ifndef SHA1_NI_SUPPORT
+   #define SHA1_NI_SUPPORT DISABLED
+#elif (SHA1_NI_SUPPORT != ENABLED && SHA1_NI_SUPPORT != DISABLED)
+   #error SHA1_NI_SUPPORT parameter is invalid
+#endif
+
+//The compiler must target a processor that implements the SHA extensions
+#if (SHA1_NI_SUPPORT == ENABLED && (!defined(__SHA__) || !defined(__SSE4_1__)))
+   #error SHA1_NI_SUPPORT requires a target with SHA-NI instructions
+#endif
+
+//ARMv8 cryptographic extension support
+#ifndef SHA1_ARMV8_SUPPORT
+   #define SHA1_ARMV8_SUPPORT DISABLED
+#elif (SHA1_ARMV8_SUPPORT != ENABLED && SHA1_ARMV8_SUPPORT != DISABLED)
+   #error SHA1_ARMV8_SUPPORT parameter is invalid
+#endif
+
+//The compiler must target a processor that implements the SHA-1 instructions
+#if (SHA1_ARMV8_SUPPORT == ENABLED && !defined(__ARM_FEATURE_CRYPTO) && !defined(__ARM_FEATURE_SHA2))
+   #error SHA1_ARMV8_SUPPORT requires a target with ARMv8 SHA-1 instructions
+#endif
+
 //SHA-1 block size
 #define SHA1_BLOCK_SIZE 64
 //SHA-1 digest size
@@ -39,6 +39,16 @@
 #include "crypto.h"
 #include "sha256.h"
 
+#if (SHA256_NI_SUPPORT == ENABLED)
+   #include <immintrin.h>
+#elif (SHA256_ARMV8_SUPPORT == ENABLED)
+   #include <arm_neon.h>
+#endif
+
+#if (SHA256_SSE2_SUPPORT == ENABLED)
+   #include <emmintrin.h>
+#endif
+
 //Check crypto library configuration
 #if (SHA224_SUPPORT == ENABLED || SHA256_SUPPORT == ENABLED)
 
@@ -50,6 +60,19 @@
 #define SIGMA3(x) (ROR32(x, 7) ^ ROR32(x, 18) ^ SHR32(x, 3))
 #define SIGMA4(x) (ROR32(x, 17) ^ ROR32(x, 19) ^ SHR32(x, 10))
 
+#if (SHA256_SSE2_SUPPORT == ENABLED)
+
+//SHA-256 auxiliary functions (four independent lanes)
+#define ROR32_SSE2(x, n) _mm_or_si128(_mm_srli_epi32(x, n), _mm_slli_epi32(x, 32 - (n)))
+#define CH_SSE2(x, y, z) _mm_xor_si128(_mm_and_si128(x, y), _mm_andnot_si128(x, z))
+#define MAJ_SSE2(x, y, z) _mm_or_si128(_mm_and_si128(x, y), _mm_and_si128(z, _mm_or_si128(x, y)))
+#define SIGMA1_SSE2(x) _mm_xor_si128(_mm_xor_si128(ROR32_SSE2(x, 2), ROR32_SSE2(x, 13)), ROR32_SSE2(x, 22))
+#define SIGMA2_SSE2(x) _mm_xor_si128(_mm_xor_si128(ROR32_SSE2(x, 6), ROR32_SSE2(x, 11)), ROR32_SSE2(x, 25))
+#define SIGMA3_SSE2(x) _mm_xor_si128(_mm_xor_si128(ROR32_SSE2(x, 7), ROR32_SSE2(x, 18)), _mm_srli_epi32(x, 3))
+#define SIGMA4_SSE2(x) _mm_xor_si128(_mm_xor_si128(ROR32_SSE2(x, 17), ROR32_SSE2(x, 19)), _mm_srli_epi32(x, 10))
+
+#endif
+
 //SHA-256 padding
 static const uint8_t padding[64] =
 {
@@ -90,6 +113,14 @@ const HashAlgo sha256HashAlgo =
    (HashAlgoFinal) sha256Final
 };
 
+//Forward declaration of functions
+static void sha256ProcessBlocksMulti(Sha256Context *context[],
+   const uint8_t *data[], uint_t count);
+
+#if (SHA256_SSE2_SUPPORT == ENABLED)
+static void sha256ProcessBlocksSse2(uint32_t *state[], const uint8_t *data[]);
+#endif
+
 
 /**
  * @brief Digest a message using SHA-256
@@ -219,6 +250,463 @@ void sha256Final(Sha256Context *context, uint8_t *digest)
 }
 
 
+/**
+ * @brief Update several SHA-256 contexts in parallel
+ *
+ * Each context digests its own message. All the messages have the same
+ * length, so that contexts which were started together remain in lockstep
+ * and their blocks can be compressed side by side
+ *
+ * @param[in] context Array of pointers to the SHA-256 contexts
+ * @param[in] data Array of pointers to the buffers being hashed
+ * @param[in] length Length of each buffer
+ * @param[in] count Number of contexts
+ **/
+
+void sha256UpdateMulti(Sha256Context *context[], const void *data[],
+   size_t length, uint_t count)
+{
+   uint_t i;
+   uint_t n;
+   size_t m;
+   size_t offset;
+   const uint8_t *p[SHA256_MULTI_BUFFER_LANES];
+
+   //Process the contexts by groups
+   while(count > 0)
+   {
+      //Number of contexts in the current group
+      n = min(count, SHA256_MULTI_BUFFER_LANES);
+
+      //The blocks can be processed side by side only if all the buffers
+      //hold the same number of bytes
+      for(i = 1; i < n; i++)
+      {
+         if(context[i]->size != context[0]->size)
+            break;
+      }
+
+      //Contexts out of step?
+      if(i < n)
+      {
+         //Update each context separately
+         for(i = 0; i < n; i++)
+            sha256Update(context[i], data[i], length);
+      }
+      else
+      {
+         //Start with the beginning of the messages
+         offset = 0;
+
+         //Complete the pending block, if any
+         if(context[0]->size > 0)
+         {
+            //Number of bytes that can be buffered
+            m = min(length, 64 - context[0]->size);
+
+            //Copy the data to the buffers
+            for(i = 0; i < n; i++)
+            {
+               memcpy(context[i]->buffer + context[i]->size, data[i], m);
+               context[i]->size += m;
+               context[i]->totalSize += m;
+               p[i] = context[i]->buffer;
+            }
+
+            //Advance the data offset
+            offset = m;
+
+            //Process the buffered blocks once they are complete
+            if(context[0]->size == 64)
+            {
+               sha256ProcessBlocksMulti(context, p, n);
+
+               //Empty the buffers
+               for(i = 0; i < n; i++)
+                  context[i]->size = 0;
+            }
+         }
+
+         //Process complete blocks straight from the input messages
+         while((length - offset) >= 64)
+         {
+            //Point to the current block of each message
+            for(i = 0; i < n; i++)
+            {
+               p[i] = (const uint8_t *) data[i] + offset;
+               context[i]->totalSize += 64;
+            }
+
+            //Transform the blocks side by side
+            sha256ProcessBlocksMulti(context, p, n);
+            //Advance the data offset
+            offset += 64;
+         }
+
+         //Buffer the remaining bytes
+         if(offset < length)
+         {
+            for(i = 0; i < n; i++)
+            {
+               memcpy(context[i]->buffer, (const uint8_t *) data[i] + offset, length - offset);
+               context[i]->size = length - offset;
+               context[i]->totalSize += length - offset;
+            }
+         }
+      }
+
+      //Point to the next group of contexts
+      context += n;
+      data += n;
+      count -= n;
+   }
+}
+
+
+/**
+ * @brief Finish several SHA-256 message digests in parallel
+ * @param[in] context Array of pointers to the SHA-256 contexts
+ * @param[out] digest Array of pointers to the calculated digests
+ * @param[in] count Number of contexts
+ **/
+
+void sha256FinalMulti(Sha256Context *context[], uint8_t *digest[], uint_t count)
+{
+   uint_t i;
+   uint_t j;
+   uint_t n;
+   size_t paddingSize;
+   uint64_t totalSize[SHA256_MULTI_BUFFER_LANES];
+   const void *q[SHA256_MULTI_BUFFER_LANES];
+   const uint8_t *p[SHA256_MULTI_BUFFER_LANES];
+
+   //Process the contexts by groups
+   while(count > 0)
+   {
+      //Number of contexts in the current group
+      n = min(count, SHA256_MULTI_BUFFER_LANES);
+
+      //All the buffers must hold the same number of bytes
+      for(i = 1; i < n; i++)
+      {
+         if(context[i]->size != context[0]->size)
+            break;
+      }
+
+      //Contexts out of step?
+      if(i < n)
+      {
+         //Finish each message digest separately
+         for(i = 0; i < n; i++)
+            sha256Final(context[i], digest[i]);
+      }
+      else
+      {
+         //Pad the messages so that their length is congruent to 56 modulo 64
+         paddingSize = (context[0]->size < 56) ?
+            (56 - context[0]->size) : (64 + 56 - context[0]->size);
+
+         //Length of the original messages (before padding)
+         for(i = 0; i < n; i++)
+         {
+            totalSize[i] = context[i]->totalSize * 8;
+            q[i] = padding;
+         }
+
+         //Append padding
+         sha256UpdateMulti(context, q, paddingSize, n);
+
+         //Append the length of the original messages
+         for(i = 0; i < n; i++)
+         {
+            context[i]->w[14] = htobe32((uint32_t) (totalSize[i] >> 32));
+            context[i]->w[15] = htobe32((uint32_t) totalSize[i]);
+            p[i] = context[i]->buffer;
+         }
+
+         //Calculate the message digests
+         sha256ProcessBlocksMulti(context, p, n);
+
+         //Copy the resulting digests
+         for(i = 0; i < n; i++)
+         {
+            //Convert from host byte order to big-endian byte order
+            for(j = 0; j < 8; j++)
+               context[i]->h[j] = htobe32(context[i]->h[j]);
+
+            //Copy the resulting digest
+            if(digest[i] != NULL)
+               memcpy(digest[i], context[i]->digest, SHA256_DIGEST_SIZE);
+         }
+      }
+
+      //Point to the next group of contexts
+      context += n;
+      digest += n;
+      count -= n;
+   }
+}
+
+
+/**
+ * @brief Transform one block of each message
+ * @param[in] context Array of pointers to the SHA-256 contexts
+ * @param[in] data Array of pointers to the 64-byte blocks
+ * @param[in] count Number of contexts (at most SHA256_MULTI_BUFFER_LANES)
+ **/
+
+static void sha256ProcessBlocksMulti(Sha256Context *context[],
+   const uint8_t *data[], uint_t count)
+{
+   uint_t i;
+
+#if (SHA256_SSE2_SUPPORT == ENABLED)
+   uint32_t dummy[8];
+   uint32_t *state[SHA256_MULTI_BUFFER_LANES];
+   const uint8_t *block[SHA256_MULTI_BUFFER_LANES];
+
+   //Unused lanes operate on a dummy state
+   for(i = 0; i < SHA256_MULTI_BUFFER_LANES; i++)
+   {
+      state[i] = (i < count) ? context[i]->h : dummy;
+      block[i] = (i < count) ? data[i] : data[0];
+   }
+
+   //The dummy state is discarded
+   memset(dummy, 0, sizeof(dummy));
+
+   //Transform the blocks side by side
+   sha256ProcessBlocksSse2(state, block);
+#else
+   //Transform the blocks one after the other
+   for(i = 0; i < count; i++)
+   {
+      //Copy the block to the buffer of the context
+      if(data[i] != context[i]->buffer)
+         memcpy(context[i]->buffer, data[i], 64);
+
+      //Transform the 16-word block
+      sha256ProcessBlock(context[i]);
+   }
+#endif
+}
+
+#if (SHA256_SSE2_SUPPORT == ENABLED)
+
+/**
+ * @brief Transform four blocks side by side (SSE2)
+ *
+ * Lane i of each vector holds a working variable of the i-th message,
+ * so that the four compressions proceed in lockstep
+ *
+ * @param[in,out] state Array of pointers to the four hash values
+ * @param[in] data Array of pointers to the four 64-byte blocks
+ **/
+
+static void sha256ProcessBlocksSse2(uint32_t *state[], const uint8_t *data[])
+{
+   uint_t t;
+   uint32_t temp[4];
+   __m128i a, b, c, d, e, f, g, h;
+   __m128i temp1;
+   __m128i temp2;
+   __m128i w[16];
+
+   //Initialize the 8 working registers
+   a = _mm_set_epi32(state[3][0], state[2][0], state[1][0], state[0][0]);
+   b = _mm_set_epi32(state[3][1], state[2][1], state[1][1], state[0][1]);
+   c = _mm_set_epi32(state[3][2], state[2][2], state[1][2], state[0][2]);
+   d = _mm_set_epi32(state[3][3], state[2][3], state[1][3], state[0][3]);
+   e = _mm_set_epi32(state[3][4], state[2][4], state[1][4], state[0][4]);
+   f = _mm_set_epi32(state[3][5], state[2][5], state[1][5], state[0][5]);
+   g = _mm_set_epi32(state[3][6], state[2][6], state[1][6], state[0][6]);
+   h = _mm_set_epi32(state[3][7], state[2][7], state[1][7], state[0][7]);
+
+   //SHA-256 hash computation
+   for(t = 0; t < 64; t++)
+   {
+      //Prepare the message schedule (circular buffer)
+      if(t < 16)
+      {
+         w[t] = _mm_set_epi32(LOAD32BE(data[3] + 4 * t), LOAD32BE(data[2] + 4 * t),
+            LOAD32BE(data[1] + 4 * t), LOAD32BE(data[0] + 4 * t));
+      }
+      else
+      {
+         w[t & 15] = _mm_add_epi32(_mm_add_epi32(SIGMA4_SSE2(w[(t - 2) & 15]), w[(t - 7) & 15]),
+            _mm_add_epi32(SIGMA3_SSE2(w[(t - 15) & 15]), w[t & 15]));
+      }
+
+      //Calculate T1 and T2
+      temp1 = _mm_add_epi32(_mm_add_epi32(h, SIGMA2_SSE2(e)), CH_SSE2(e, f, g));
+      temp1 = _mm_add_epi32(temp1, _mm_add_epi32(_mm_set1_epi32(k[t]), w[t & 15]));
+      temp2 = _mm_add_epi32(SIGMA1_SSE2(a), MAJ_SSE2(a, b, c));
+
+      //Update the working registers
+      h = g;
+      g = f;
+      f = e;
+      e = _mm_add_epi32(d, temp1);
+      d = c;
+      c = b;
+      b = a;
+      a = _mm_add_epi32(temp1, temp2);
+   }
+
+   //Update the hash values
+   for(t = 0; t < 8; t++)
+   {
+      //Select the working register
+      switch(t)
+      {
+      case 0: temp1 = a; break;
+      case 1: temp1 = b; break;
+      case 2: temp1 = c; break;
+      case 3: temp1 = d; break;
+      case 4: temp1 = e; break;
+      case 5: temp1 = f; break;
+      case 6: temp1 = g; break;
+      default: temp1 = h; break;
+      }
+
+      //Extract the four lanes
+      _mm_storeu_si128((__m128i *) temp, temp1);
+
+      state[0][t] += temp[0];
+      state[1][t] += temp[1];
+      state[2][t] += temp[2];
+      state[3][t] += temp[3];
+   }
+}
+
+#endif
+#if (SHA256_NI_SUPPORT == ENABLED)
+
+/**
+ * @brief Process message in 16-word blocks (SHA-NI)
+ * @param[in] context Pointer to the SHA-256 context
+ **/
+
+void sha256ProcessBlock(Sha256Context *context)
+{
+   uint_t t;
+   __m128i state0;
+   __m128i state1;
+   __m128i abef;
+   __m128i cdgh;
+   __m128i temp;
+   __m128i w[4];
+   const __m128i mask = _mm_set_epi64x(0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+
+   //Load the hash value
+   temp = _mm_loadu_si128((const __m128i *) context->h);
+   state1 = _mm_loadu_si128((const __m128i *) (context->h + 4));
+
+   //The SHA-NI instructions operate on the (A, B, E, F) and (C, D, G, H) pairs
+   temp = _mm_shuffle_epi32(temp, 0xB1);
+   state1 = _mm_shuffle_epi32(state1, 0x1B);
+   state0 = _mm_alignr_epi8(temp, state1, 8);
+   state1 = _mm_blend_epi16(state1, temp, 0xF0);
+
+   //Save the current hash value
+   abef = state0;
+   cdgh = state1;
+
+   //Each iteration processes four rounds
+   for(t = 0; t < 16; t++)
+   {
+      //Prepare the message schedule
+      if(t < 4)
+      {
+         w[t] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (context->buffer + 16 * t)), mask);
+      }
+      else
+      {
+         temp = _mm_alignr_epi8(w[(t + 3) % 4], w[(t + 2) % 4], 4);
+         w[t % 4] = _mm_add_epi32(_mm_sha256msg1_epu32(w[t % 4], w[(t + 1) % 4]), temp);
+         w[t % 4] = _mm_sha256msg2_epu32(w[t % 4], w[(t + 3) % 4]);
+      }
+
+      //Add the round constants
+      temp = _mm_add_epi32(w[t % 4], _mm_loadu_si128((const __m128i *) (k + 4 * t)));
+
+      //Perform two rounds, then two more
+      state1 = _mm_sha256rnds2_epu32(state1, state0, temp);
+      temp = _mm_shuffle_epi32(temp, 0x0E);
+      state0 = _mm_sha256rnds2_epu32(state0, state1, temp);
+   }
+
+   //Update the hash value
+   state0 = _mm_add_epi32(state0, abef);
+   state1 = _mm_add_epi32(state1, cdgh);
+
+   //Restore the (A, B, C, D) and (E, F, G, H) word order
+   temp = _mm_shuffle_epi32(state0, 0x1B);
+   state1 = _mm_shuffle_epi32(state1, 0xB1);
+   state0 = _mm_blend_epi16(temp, state1, 0xF0);
+   state1 = _mm_alignr_epi8(state1, temp, 8);
+
+   //Save the resulting hash value
+   _mm_storeu_si128((__m128i *) context->h, state0);
+   _mm_storeu_si128((__m128i *) (context->h + 4), state1);
+}
+
+#elif (SHA256_ARMV8_SUPPORT == ENABLED)
+
+/**
+ * @brief Process message in 16-word blocks (ARMv8 cryptographic extension)
+ * @param[in] context Pointer to the SHA-256 context
+ **/
+
+void sha256ProcessBlock(Sha256Context *context)
+{
+   uint_t t;
+   uint32x4_t state0;
+   uint32x4_t state1;
+   uint32x4_t abcdSave;
+   uint32x4_t efghSave;
+   uint32x4_t abcd;
+   uint32x4_t temp;
+   uint32x4_t w[4];
+
+   //Load the hash value
+   state0 = vld1q_u32(context->h);
+   state1 = vld1q_u32(context->h + 4);
+
+   //Save the current hash value
+   abcdSave = state0;
+   efghSave = state1;
+
+   //Each iteration processes four rounds
+   for(t = 0; t < 16; t++)
+   {
+      //Prepare the message schedule
+      if(t < 4)
+      {
+         w[t] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(context->buffer + 16 * t)));
+      }
+      else
+      {
+         w[t % 4] = vsha256su0q_u32(w[t % 4], w[(t + 1) % 4]);
+         w[t % 4] = vsha256su1q_u32(w[t % 4], w[(t + 2) % 4], w[(t + 3) % 4]);
+      }
+
+      //Add the round constants
+      temp = vaddq_u32(w[t % 4], vld1q_u32(k + 4 * t));
+
+      //Perform four rounds
+      abcd = state0;
+      state0 = vsha256hq_u32(state0, state1, temp);
+      state1 = vsha256h2q_u32(state1, abcd, temp);
+   }
+
+   //Update the hash value
+   vst1q_u32(context->h, vaddq_u32(state0, abcdSave));
+   vst1q_u32(context->h + 4, vaddq_u32(state1, efghSave));
+}
+
+#else
+
 /**
  * @brief Process message in 16-word blocks
  * @param[in] context Pointer to the SHA-256 context
@@ -281,3 +769,4 @@ void sha256ProcessBlock(Sha256Context *context)
 }
 
 #endif
+#endif
@@ -32,12 +32,50 @@
 //Dependencies
 #include "crypto.h"
 
+//SHA-NI instruction set support
+#ifndef SHA256_NI_SUPPORT
+   #define SHA256_NI_SUPPORT DISABLED
+#elif (SHA256_NI_SUPPORT != ENABLED && SHA256_NI_SUPPORT != DISABLED)
+   #error SHA256_NI_SUPPORT parameter is invalid
+#endif
+
+//The compiler must target a processor that implements the SHA extensions
+#if (SHA256_NI_SUPPORT == ENABLED && (!defined(__SHA__) || !defined(__SSE4_1__)))
+   #error SHA256_NI_SUPPORT requires a target with SHA-NI instructions
+#endif
+
+//ARMv8 cryptographic extension support
+#ifndef SHA256_ARMV8_SUPPORT
+   #define SHA256_ARMV8_SUPPORT DISABLED
+#elif (SHA256_ARMV8_SUPPORT != ENABLED && SHA256_ARMV8_SUPPORT != DISABLED)
+   #error SHA256_ARMV8_SUPPORT parameter is invalid
+#endif
+
+//The compiler must target a processor that implements the SHA-256 instructions
+#if (SHA256_ARMV8_SUPPORT == ENABLED && !defined(__ARM_FEATURE_CRYPTO) && !defined(__ARM_FEATURE_SHA2))
+   #error SHA256_ARMV8_SUPPORT requires a target with ARMv8 SHA-256 instructions
+#endif
+
+//SSE2 multi-buffer support
+#ifndef SHA256_SSE2_SUPPORT
+   #define SHA256_SSE2_SUPPORT DISABLED
+#elif (SHA256_SSE2_SUPPORT != ENABLED && SHA256_SSE2_SUPPORT != DISABLED)
+   #error SHA256_SSE2_SUPPORT parameter is invalid
+#endif
+
+//The compiler must target a processor that implements SSE2
+#if (SHA256_SSE2_SUPPORT == ENABLED && !defined(__SSE2__))
+   #error SHA256_SSE2_SUPPORT requires a target with SSE2 instructions
+#endif
+
 //SHA-256 block size
 #define SHA256_BLOCK_SIZE 64
 //SHA-256 digest size
 #define SHA256_DIGEST_SIZE 32
 //Common interface for hash algorithms
 #define SHA256_HASH_ALGO (&sha256HashAlgo)
+//Number of messages hashed side by side by the multi-buffer interface
+#define SHA256_MULTI_BUFFER_LANES 4
 
 
 /**
@@ -71,4 +109,9 @@ void sha256Update(Sha256Context *context, const void *data, size_t length);
 void sha256Final(Sha256Context *context, uint8_t *digest);
 void sha256ProcessBlock(Sha256Context *context);
 
+void sha256UpdateMulti(Sha256Context *context[], const void *data[],
+   size_t length, uint_t count);
+
+void sha256FinalMulti(Sha256Context *context[], uint8_t *digest[], uint_t count);
+
 #endif
@@ -36,12 +36,15 @@
 #include "asn1.h"
 #include "rsa.h"
 #include "dsa.h"
+#include "ec.h"
+#include "ecdsa.h"
 #include "md5.h"
 #include "sha1.h"
 #include "sha224.h"
 #include "sha256.h"
 #include "sha384.h"
 #include "sha512.h"
+#include "date_time.h"
 #include "debug.h"
 
 //Common Name OID (2.5.4.3)
@@ -659,19 +662,9 @@ error_t x509ParseValidity(const uint8_t *data, size_t length,
    if(error) return error;
 
    //NotBefore field may be encoded as UTCTime or GeneralizedTime
-   if(!asn1CheckTag(&tag, FALSE, ASN1_CLASS_UNIVERSAL, ASN1_TYPE_UTC_TIME))
-   {
-
-   }
-   else if(!asn1CheckTag(&tag, FALSE, ASN1_CLASS_UNIVERSAL, ASN1_TYPE_GENERALIZED_TIME))
-   {
-
-   }
-   else
-   {
-      //The tag does not contain a valid date
-      return ERROR_FAILURE;
-   }
+   error = x509ParseTime(&tag, &certInfo->validity.notBefore);
+   //The tag does not contain a valid date?
+   if(error) return error;
 
    //Point to the next field
    data += tag.totalLength;
@@ -683,13 +676,58 @@ error_t x509ParseValidity(const uint8_t *data, size_t length,
    if(error) return error;
 
    //NotAfter field may be encoded as UTCTime or GeneralizedTime
-   if(!asn1CheckTag(&tag, FALSE, ASN1_CLASS_UNIVERSAL, ASN1_TYPE_UTC_TIME))
+   error = x509ParseTime(&tag, &certInfo->validity.notAfter);
+   //The tag does not contain a valid date?
+   if(error) return error;
+
+   //Validity field successfully parsed
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Parse UTCTime or GeneralizedTime field
+ * @param[in] tag ASN.1 tag that holds the date
+ * @param[out] time Resulting date, expressed in Unix time
+ * @return Error code
+ **/
+
+error_t x509ParseTime(const Asn1Tag *tag, uint32_t *time)
+{
+   uint_t i;
+   uint_t value[6];
+   uint_t century;
+   const uint8_t *p;
+   DateTime dateTime;
+
+   //Point to the first digit
+   p = tag->value;
+
+   //UTCTime field (YYMMDDHHMMSSZ)?
+   if(!asn1CheckTag(tag, FALSE, ASN1_CLASS_UNIVERSAL, ASN1_TYPE_UTC_TIME))
    {
+      //The year is encoded with two digits
+      if(tag->length != 13)
+         return ERROR_WRONG_ENCODING;
 
+      //The century is implied
+      century = 0;
    }
-   else if(!asn1CheckTag(&tag, FALSE, ASN1_CLASS_UNIVERSAL, ASN1_TYPE_GENERALIZED_TIME))
+   //GeneralizedTime field (YYYYMMDDHHMMSSZ)?
+   else if(!asn1CheckTag(tag, FALSE, ASN1_CLASS_UNIVERSAL, ASN1_TYPE_GENERALIZED_TIME))
    {
-
+      //The year is encoded with four digits
+      if(tag->length != 15)
+         return ERROR_WRONG_ENCODING;
+
+      //Make sure the characters are valid digits
+      if(p[0] < '0' || p[0] > '9' || p[1] < '0' || p[1] > '9')
+         return ERROR_WRONG_ENCODING;
+
+      //Decode the century
+      century = (p[0] - '0') * 10 + (p[1] - '0');
+      //Point to the next pair of digits
+      p += 2;
    }
    else
    {
@@ -697,7 +735,52 @@ error_t x509ParseValidity(const uint8_t *data, size_t length,
       return ERROR_FAILURE;
    }
 
-   //Validity field successfully parsed
+   //Dates are expressed in Greenwich Mean Time
+   if(tag->value[tag->length - 1] != 'Z')
+      return ERROR_WRONG_ENCODING;
+
+   //Decode year, month, day, hours, minutes and seconds
+   for(i = 0; i < 6; i++)
+   {
+      //Make sure the characters are valid digits
+      if(p[0] < '0' || p[0] > '9' || p[1] < '0' || p[1] > '9')
+         return ERROR_WRONG_ENCODING;
+
+      //Convert the current pair of digits
+      value[i] = (p[0] - '0') * 10 + (p[1] - '0');
+      //Point to the next pair of digits
+      p += 2;
+   }
+
+   //UTCTime values in the range 50 to 99 belong to the 20th century
+   if(tag->length == 13)
+      century = (value[0] >= 50) ? 19 : 20;
+
+   //Save the date
+   dateTime.year = century * 100 + value[0];
+   dateTime.month = value[1];
+   dateTime.date = value[2];
+   dateTime.hours = value[3];
+   dateTime.minutes = value[4];
+   dateTime.seconds = value[5];
+
+   //Check the range of each field
+   if(dateTime.month < 1 || dateTime.month > 12 || dateTime.date < 1 ||
+      dateTime.date > 31 || dateTime.hours > 23 || dateTime.minutes > 59 ||
+      dateTime.seconds > 59)
+   {
+      return ERROR_WRONG_ENCODING;
+   }
+
+   //Dates outside the range of the 32-bit Unix time are clamped
+   if(dateTime.year < 1970)
+      *time = 0;
+   else if(dateTime.year > 2105)
+      *time = 0xFFFFFFFF;
+   else
+      *time = dateTimeToUnixTime(&dateTime);
+
+   //Successful processing
    return NO_ERROR;
 }
 
@@ -815,6 +898,34 @@ error_t x509ParseSubjectPublicKeyInfo(const uint8_t *data, size_t length,
       //Any error to report?
       if(error) return error;
    }
+   //EC public key identifier?
+   else if(!asn1CheckOid(&tag, EC_PUBLIC_KEY_OID, sizeof(EC_PUBLIC_KEY_OID)))
+   {
+      //Read the ECParameters structure
+      error = x509ParseEcParameters(p, n, certInfo);
+      //Any error to report?
+      if(error) return error;
+
+      //Read the contents of the SubjectPublicKey field
+      error = asn1ReadTag(data, length, &tag);
+      //Failed to decode ASN.1 tag?
+      if(error) return error;
+
+      //The ECPoint is mapped directly to the bit string
+      error = asn1CheckTag(&tag, FALSE, ASN1_CLASS_UNIVERSAL, ASN1_TYPE_BIT_STRING);
+      //The tag does not match the criteria?
+      if(error) return error;
+
+      //The bit string shall contain an initial octet which encodes
+      //the number of unused bits in the final subsequent octet
+      if(tag.length < 1 || tag.value[0] != 0x00)
+         return ERROR_FAILURE;
+
+      //Read ECPoint structure
+      error = x509ParseEcPublicKey(tag.value + 1, tag.length - 1, certInfo);
+      //Any error to report?
+      if(error) return error;
+   }
 
    //No error to report
    return NO_ERROR;
@@ -1011,6 +1122,69 @@ error_t x509ParseDsaPublicKey(const uint8_t *data,
 }
 
 
+/**
+ * @brief Parse EC domain parameters
+ * @param[in] data Pointer to the ASN.1 structure to parse
+ * @param[in] length Length of the ASN.1 structure
+ * @param[out] certInfo Information resulting from the parsing process
+ * @return Error code
+ **/
+
+error_t x509ParseEcParameters(const uint8_t *data,
+   size_t length, X509CertificateInfo *certInfo)
+{
+   error_t error;
+   Asn1Tag tag;
+
+   //Debug message
+   TRACE_DEBUG("      Parsing ECParameters...\r\n");
+
+   //Read ECParameters structure
+   error = asn1ReadTag(data, length, &tag);
+   //Failed to decode ASN.1 tag?
+   if(error) return error;
+
+   //Only named curves are supported (RFC 5480)
+   error = asn1CheckTag(&tag, FALSE, ASN1_CLASS_UNIVERSAL, ASN1_TYPE_OBJECT_IDENTIFIER);
+   //The tag does not match the criteria?
+   if(error) return error;
+
+   //Save the named curve
+   certInfo->subjectPublicKey.namedCurve = tag.value;
+   certInfo->subjectPublicKey.namedCurveLen = tag.length;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Parse ECPoint structure
+ * @param[in] data Pointer to the encoded point
+ * @param[in] length Length of the encoded point
+ * @param[out] certInfo Information resulting from the parsing process
+ * @return Error code
+ **/
+
+error_t x509ParseEcPublicKey(const uint8_t *data,
+   size_t length, X509CertificateInfo *certInfo)
+{
+   //Debug message
+   TRACE_DEBUG("      Parsing ECPoint...\r\n");
+
+   //Check the length of the encoded point
+   if(length == 0 || length > EC_MAX_POINT_SIZE)
+      return ERROR_INVALID_LENGTH;
+
+   //Save the EC public key
+   certInfo->subjectPublicKey.ecPoint = data;
+   certInfo->subjectPublicKey.ecPointLen = length;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
 /**
  * @brief Parse IssuerUniqueID structure
  * @param[in] data Pointer to the ASN.1 structure to parse
@@ -1268,6 +1442,22 @@ error_t x509ParseExtensions(const uint8_t *data, size_t length,
             //Any error to report?
             if(error) return error;
          }
+         //The current extension matches the SubjectKeyIdentifier OID?
+         else if(!memcmp(oidTag.value, X509_SUBJECT_KEY_ID_OID, 3))
+         {
+            //Parse SubjectKeyIdentifier extension
+            error = x509ParseSubjectKeyId(tag.value, tag.length, certInfo);
+            //Any error to report?
+            if(error) return error;
+         }
+         //The current extension matches the AuthorityKeyIdentifier OID?
+         else if(!memcmp(oidTag.value, X509_AUTHORITY_KEY_ID_OID, 3))
+         {
+            //Parse AuthorityKeyIdentifier extension
+            error = x509ParseAuthorityKeyId(tag.value, tag.length, certInfo);
+            //Any error to report?
+            if(error) return error;
+         }
       }
    }
 
@@ -1359,6 +1549,100 @@ error_t x509ParseBasicConstraints(const uint8_t *data,
 }
 
 
+/**
+ * @brief Parse SubjectKeyIdentifier structure
+ * @param[in] data Pointer to the ASN.1 structure to parse
+ * @param[in] length Length of the ASN.1 structure
+ * @param[out] certInfo Information resulting from the parsing process
+ * @return Error code
+ **/
+
+error_t x509ParseSubjectKeyId(const uint8_t *data,
+   size_t length, X509CertificateInfo *certInfo)
+{
+   error_t error;
+   Asn1Tag tag;
+
+   //Debug message
+   TRACE_DEBUG("      Parsing SubjectKeyIdentifier...\r\n");
+
+   //The key identifier is encoded as an octet string
+   error = asn1ReadTag(data, length, &tag);
+   //Failed to decode ASN.1 tag?
+   if(error) return error;
+
+   //Enforce encoding, type and class
+   error = asn1CheckTag(&tag, FALSE, ASN1_CLASS_UNIVERSAL, ASN1_TYPE_OCTET_STRING);
+   //The tag does not match the criteria?
+   if(error) return error;
+
+   //Save the key identifier
+   certInfo->subjectKeyId.value = tag.value;
+   certInfo->subjectKeyId.length = tag.length;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Parse AuthorityKeyIdentifier structure
+ * @param[in] data Pointer to the ASN.1 structure to parse
+ * @param[in] length Length of the ASN.1 structure
+ * @param[out] certInfo Information resulting from the parsing process
+ * @return Error code
+ **/
+
+error_t x509ParseAuthorityKeyId(const uint8_t *data,
+   size_t length, X509CertificateInfo *certInfo)
+{
+   error_t error;
+   Asn1Tag tag;
+
+   //Debug message
+   TRACE_DEBUG("      Parsing AuthorityKeyIdentifier...\r\n");
+
+   //The AuthorityKeyIdentifier structure shall contain a valid sequence
+   error = asn1ReadTag(data, length, &tag);
+   //Failed to decode ASN.1 tag?
+   if(error) return error;
+
+   //Enforce encoding, type and class
+   error = asn1CheckTag(&tag, TRUE, ASN1_CLASS_UNIVERSAL, ASN1_TYPE_SEQUENCE);
+   //The tag does not match the criteria?
+   if(error) return error;
+
+   //Point to the first item of the sequence
+   data = tag.value;
+   length = tag.length;
+
+   //Loop through the items of the sequence
+   while(length > 0)
+   {
+      //Read current item
+      error = asn1ReadTag(data, length, &tag);
+      //Failed to decode ASN.1 tag?
+      if(error) return error;
+
+      //The keyIdentifier field is implicitly tagged with [0]
+      if(!asn1CheckTag(&tag, FALSE, ASN1_CLASS_CONTEXT_SPECIFIC, 0))
+      {
+         //Save the key identifier
+         certInfo->authorityKeyId.keyId = tag.value;
+         certInfo->authorityKeyId.keyIdLen = tag.length;
+      }
+
+      //The authorityCertIssuer and authorityCertSerialNumber
+      //fields are not used
+      data += tag.totalLength;
+      length -= tag.totalLength;
+   }
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
 /**
  * @brief Parse SignatureAlgorithm structure
  * @param[in] data Pointer to the ASN.1 structure to parse
@@ -1543,6 +1827,40 @@ error_t x509ReadDsaPublicKey(const X509CertificateInfo *certInfo, DsaPublicKey *
 }
 
 
+/**
+ * @brief Read an EC public key
+ * @param[in] certInfo X.509 certificate
+ * @param[out] key EC public key
+ * @return Error code
+ **/
+
+error_t x509ReadEcPublicKey(const X509CertificateInfo *certInfo, EcPublicKey *key)
+{
+   const EcCurveInfo *curve;
+
+   //The certificate shall contain a valid EC public key
+   if(!certInfo->subjectPublicKey.namedCurve || !certInfo->subjectPublicKey.ecPoint)
+      return ERROR_INVALID_KEY;
+
+   //Retrieve the elliptic curve that matches the OID
+   curve = ecGetCurveInfo(certInfo->subjectPublicKey.namedCurve,
+      certInfo->subjectPublicKey.namedCurveLen);
+
+   //Unknown elliptic curve?
+   if(curve == NULL)
+      return ERROR_UNSUPPORTED_ELLIPTIC_CURVE;
+
+   //Debug message
+   TRACE_DEBUG("EC public key (%s):\r\n", curve->name);
+   TRACE_DEBUG_ARRAY("    ", certInfo->subjectPublicKey.ecPoint,
+      certInfo->subjectPublicKey.ecPointLen);
+
+   //Make sure the point lies on the curve
+   return ecImportPublicKey(key, curve, certInfo->subjectPublicKey.ecPoint,
+      certInfo->subjectPublicKey.ecPointLen);
+}
+
+
 /**
  * @brief X.509 certificate validation
  * @param[in] certInfo X.509 certificate to be verified
@@ -1557,9 +1875,10 @@ error_t x509ValidateCertificate(const X509CertificateInfo *certInfo,
    const HashAlgo *hashAlgo;
    HashContext *hashContext;
 
-   //Use RSA or DSA signature algorithm?
+   //Use RSA, DSA or ECDSA signature algorithm?
    bool_t rsaSignAlgo = FALSE;
    bool_t dsaSignAlgo = FALSE;
+   bool_t ecdsaSignAlgo = FALSE;
 
    //Check the certificate validity period
    //if()
@@ -1632,6 +1951,41 @@ error_t x509ValidateCertificate(const X509CertificateInfo *certInfo,
       dsaSignAlgo = TRUE;
       hashAlgo = SHA256_HASH_ALGO;
    }
+   else if(certInfo->signatureAlgoLen == sizeof(ECDSA_WITH_SHA1_OID) &&
+      !memcmp(certInfo->signatureAlgo, ECDSA_WITH_SHA1_OID, sizeof(ECDSA_WITH_SHA1_OID)))
+   {
+      //ECDSA with SHA-1 signature algorithm
+      ecdsaSignAlgo = TRUE;
+      hashAlgo = SHA1_HASH_ALGO;
+   }
+   else if(certInfo->signatureAlgoLen == sizeof(ECDSA_WITH_SHA224_OID) &&
+      !memcmp(certInfo->signatureAlgo, ECDSA_WITH_SHA224_OID, sizeof(ECDSA_WITH_SHA224_OID)))
+   {
+      //ECDSA with SHA-224 signature algorithm
+      ecdsaSignAlgo = TRUE;
+      hashAlgo = SHA224_HASH_ALGO;
+   }
+   else if(certInfo->signatureAlgoLen == sizeof(ECDSA_WITH_SHA256_OID) &&
+      !memcmp(certInfo->signatureAlgo, ECDSA_WITH_SHA256_OID, sizeof(ECDSA_WITH_SHA256_OID)))
+   {
+      //ECDSA with SHA-256 signature algorithm
+      ecdsaSignAlgo = TRUE;
+      hashAlgo = SHA256_HASH_ALGO;
+   }
+   else if(certInfo->signatureAlgoLen == sizeof(ECDSA_WITH_SHA384_OID) &&
+      !memcmp(certInfo->signatureAlgo, ECDSA_WITH_SHA384_OID, sizeof(ECDSA_WITH_SHA384_OID)))
+   {
+      //ECDSA with SHA-384 signature algorithm
+      ecdsaSignAlgo = TRUE;
+      hashAlgo = SHA384_HASH_ALGO;
+   }
+   else if(certInfo->signatureAlgoLen == sizeof(ECDSA_WITH_SHA512_OID) &&
+      !memcmp(certInfo->signatureAlgo, ECDSA_WITH_SHA512_OID, sizeof(ECDSA_WITH_SHA512_OID)))
+   {
+      //ECDSA with SHA-512 signature algorithm
+      ecdsaSignAlgo = TRUE;
+      hashAlgo = SHA512_HASH_ALGO;
+   }
    else
    {
       //The specified signature algorithm is not supported
@@ -1702,6 +2056,38 @@ error_t x509ValidateCertificate(const X509CertificateInfo *certInfo,
       dsaFreePublicKey(&dsaPublicKey);
       dsaFreeSignature(&dsaSignature);
    }
+   else if(ecdsaSignAlgo)
+   {
+      EcPublicKey ecPublicKey;
+      EcdsaSignature ecdsaSignature;
+
+      //Initialize EC public key and ECDSA signature
+      ecInitPublicKey(&ecPublicKey);
+      ecdsaInitSignature(&ecdsaSignature);
+
+      //Get the EC public key
+      error = x509ReadEcPublicKey(issuerCertInfo, &ecPublicKey);
+
+      //Check status code
+      if(!error)
+      {
+         //Read the ASN.1 encoded signature
+         error = ecdsaReadSignature(certInfo->signatureValue,
+            certInfo->signatureValueLen, &ecdsaSignature);
+      }
+
+      //Check status code
+      if(!error)
+      {
+         //Verify ECDSA signature
+         error = ecdsaVerifySignature(&ecPublicKey, hashContext->digest,
+            hashAlgo->digestSize, &ecdsaSignature);
+      }
+
+      //Release previously allocated resources
+      ecFreePublicKey(&ecPublicKey);
+      ecdsaFreeSignature(&ecdsaSignature);
+   }
    else
    {
       //The signature algorithm is not supported...
@@ -31,8 +31,10 @@
 
 //Dependencies
 #include "crypto.h"
+#include "asn1.h"
 #include "rsa.h"
 #include "dsa.h"
+#include "ec.h"
 
 
 /**
@@ -138,6 +140,28 @@ typedef struct
 } X509DsaPublicKey;
 
 
+/**
+ * @brief EC domain parameters
+ **/
+
+typedef struct
+{
+   const uint8_t *namedCurve;
+   size_t namedCurveLen;
+} X509EcParameters;
+
+
+/**
+ * @brief EC public key
+ **/
+
+typedef struct
+{
+   const uint8_t *ecPoint;
+   size_t ecPointLen;
+} X509EcPublicKey;
+
+
 /**
  * @brief Subject public key
  **/
@@ -149,6 +173,8 @@ typedef struct
    X509RsaPublicKey;
    X509DsaParameters;
    X509DsaPublicKey;
+   X509EcParameters;
+   X509EcPublicKey;
 } X509SubjectPublicKey;
 
 
@@ -163,6 +189,28 @@ typedef struct
 } X509BasicContraints;
 
 
+/**
+ * @brief Subject key identifier
+ **/
+
+typedef struct
+{
+   const uint8_t *value;
+   size_t length;
+} X509SubjectKeyId;
+
+
+/**
+ * @brief Authority key identifier
+ **/
+
+typedef struct
+{
+   const uint8_t *keyId;
+   size_t keyIdLen;
+} X509AuthorityKeyId;
+
+
 /**
  * @brief X.509 certificate
  **/
@@ -179,6 +227,8 @@ typedef struct
    X509Name subject;
    X509SubjectPublicKey subjectPublicKey;
    X509BasicContraints basicConstraints;
+   X509SubjectKeyId subjectKeyId;
+   X509AuthorityKeyId authorityKeyId;
    const uint8_t *signatureAlgo;
    size_t signatureAlgoLen;
    const uint8_t *signatureValue;
@@ -241,6 +291,8 @@ error_t x509ParseName(const uint8_t *data, size_t length,
 error_t x509ParseValidity(const uint8_t *data, size_t length,
    size_t *totalLength, X509CertificateInfo *certInfo);
 
+error_t x509ParseTime(const Asn1Tag *tag, uint32_t *time);
+
 error_t x509ParseSubjectPublicKeyInfo(const uint8_t *data, size_t length,
    size_t *totalLength, X509CertificateInfo *certInfo);
 
@@ -253,6 +305,12 @@ error_t x509ParseDsaParameters(const uint8_t *data,
 error_t x509ParseDsaPublicKey(const uint8_t *data,
    size_t length, X509CertificateInfo *certInfo);
 
+error_t x509ParseEcParameters(const uint8_t *data,
+   size_t length, X509CertificateInfo *certInfo);
+
+error_t x509ParseEcPublicKey(const uint8_t *data,
+   size_t length, X509CertificateInfo *certInfo);
+
 error_t x509ParseIssuerUniqueId(const uint8_t *data, size_t length,
    size_t *totalLength, X509CertificateInfo *certInfo);
 
@@ -265,6 +323,12 @@ error_t x509ParseExtensions(const uint8_t *data, size_t length,
 error_t x509ParseBasicConstraints(const uint8_t *data,
    size_t length, X509CertificateInfo *certInfo);
 
+error_t x509ParseSubjectKeyId(const uint8_t *data,
+   size_t length, X509CertificateInfo *certInfo);
+
+error_t x509ParseAuthorityKeyId(const uint8_t *data,
+   size_t length, X509CertificateInfo *certInfo);
+
 error_t x509ParseSignatureAlgo(const uint8_t *data, size_t length,
    size_t *totalLength, X509CertificateInfo *certInfo);
 
@@ -273,6 +337,7 @@ error_t x509ParseSignatureValue(const uint8_t *data, size_t length,
 
 error_t x509ReadRsaPublicKey(const X509CertificateInfo *certInfo, RsaPublicKey *key);
 error_t x509ReadDsaPublicKey(const X509CertificateInfo *certInfo, DsaPublicKey *key);
+error_t x509ReadEcPublicKey(const X509CertificateInfo *certInfo, EcPublicKey *key);
 
 error_t x509ValidateCertificate(const X509CertificateInfo *certInfo,
    const X509CertificateInfo *issuerCertInfo);
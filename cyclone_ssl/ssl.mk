@@ -1,12 +1,15 @@
 CYCLONETCPSRC +=  $(CYCLONETCP)/cyclone_ssl/ssl_common.c \
 				 $(CYCLONETCP)/cyclone_ssl/tls.c \
+				 $(CYCLONETCP)/cyclone_ssl/tls_buffer.c \
 				 $(CYCLONETCP)/cyclone_ssl/tls_cache.c \
+				 $(CYCLONETCP)/cyclone_ssl/tls_cert_store.c \
 				 $(CYCLONETCP)/cyclone_ssl/tls_cipher_suites.c \
 				 $(CYCLONETCP)/cyclone_ssl/tls_client.c \
 				 $(CYCLONETCP)/cyclone_ssl/tls_common.c \
 				 $(CYCLONETCP)/cyclone_ssl/tls_io.c \
 				 $(CYCLONETCP)/cyclone_ssl/tls_misc.c \
 				 $(CYCLONETCP)/cyclone_ssl/tls_record.c \
-				 $(CYCLONETCP)/cyclone_ssl/tls_server.c
+				 $(CYCLONETCP)/cyclone_ssl/tls_server.c \
+				 $(CYCLONETCP)/cyclone_ssl/tls_ticket.c
 
 CYCLONETCPINC += $(CYCLONETCP)/cyclone_ssl/
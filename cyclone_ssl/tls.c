@@ -43,6 +43,7 @@
 #include "tls_server.h"
 #include "tls_common.h"
 #include "tls_record.h"
+#include "tls_buffer.h"
 #include "tls_misc.h"
 #include "x509.h"
 #include "pem.h"
@@ -84,28 +85,23 @@ TlsContext *tlsInit(void)
    //Default client authentication mode
    context->clientAuthMode = TLS_CLIENT_AUTH_NONE;
 
+#if (TLS_MAX_FRAG_LEN_SUPPORT == ENABLED)
+   //The client does not request a maximum fragment length by default
+   context->requestedMaxFragLength = TLS_MAX_RECORD_LENGTH;
+#endif
+   //Default maximum fragment length
+   context->maxFragLength = TLS_MAX_RECORD_LENGTH;
+
    //Initialize multiple precision integers
    dhInitParameters(&context->dhParameters);
    rsaInitPublicKey(&context->peerRsaPublicKey);
    dsaInitPublicKey(&context->peerDsaPublicKey);
 
-   //Allocate send and receive buffers
-   context->txBuffer = osMemAlloc(TLS_TX_BUFFER_SIZE);
-   context->rxBuffer = osMemAlloc(TLS_RX_BUFFER_SIZE);
-   //Failed to allocate memory?
-   if(!context->txBuffer || !context->rxBuffer)
-   {
-      //Free previously allocated memory
-      osMemFree(context->txBuffer);
-      osMemFree(context->rxBuffer);
-      osMemFree(context);
-      //Report an error
-      return NULL;
-   }
+   //Initialize ECDH context and EC public key
+   ecdhInit(&context->ecdhContext);
+   ecInitPublicKey(&context->peerEcPublicKey);
 
-   //Clear send and receive buffers
-   memset(context->txBuffer, 0, TLS_TX_BUFFER_SIZE);
-   memset(context->rxBuffer, 0, TLS_RX_BUFFER_SIZE);
+   //Send and receive buffers are allocated when the handshake starts
 
    //Return a handle to the freshly created TLS context
    return context;
@@ -169,6 +165,12 @@ error_t tlsSetConnectionEnd(TlsContext *context, TlsConnectionEnd entity)
 
 /**
  * @brief Set the pseudo-random number generator to be used
+ *
+ * When TLS_CHACHA_DRBG_SUPPORT is enabled, the connection uses its own
+ * ChaCha DRBG, which is seeded from the supplied PRNG and periodically
+ * reseeded from it. The supplied PRNG can therefore be shared by many
+ * connections without becoming a contention point
+ *
  * @param[in] context Pointer to the TLS context
  * @param[in] prngAlgo PRNG algorithm
  * @param[in] prngContext Pointer to the PRNG context
@@ -177,6 +179,10 @@ error_t tlsSetConnectionEnd(TlsContext *context, TlsConnectionEnd entity)
 
 error_t tlsSetPrng(TlsContext *context, const PrngAlgo *prngAlgo, void *prngContext)
 {
+#if (TLS_CHACHA_DRBG_SUPPORT == ENABLED)
+   error_t error;
+#endif
+
    //Invalid TLS context?
    if(context == NULL)
       return ERROR_INVALID_PARAMETER;
@@ -184,10 +190,25 @@ error_t tlsSetPrng(TlsContext *context, const PrngAlgo *prngAlgo, void *prngCont
    if(prngAlgo == NULL || prngContext == NULL)
       return ERROR_INVALID_PARAMETER;
 
+#if (TLS_CHACHA_DRBG_SUPPORT == ENABLED)
+   //Release the generator previously attached to the connection, if any
+   chachaDrbgRelease(&context->drbgContext);
+
+   //The per-connection generator draws its seed from the supplied PRNG
+   error = chachaDrbgInitChild(&context->drbgContext, prngAlgo, prngContext);
+   //Any error to report?
+   if(error) return error;
+
+   //PRNG algorithm that will be used to generate random numbers
+   context->prngAlgo = CHACHA_DRBG_PRNG_ALGO;
+   //PRNG context
+   context->prngContext = &context->drbgContext;
+#else
    //PRNG algorithm that will be used to generate random numbers
    context->prngAlgo = prngAlgo;
    //PRNG context
    context->prngContext = prngContext;
+#endif
 
    //Successful processing
    return NO_ERROR;
@@ -251,6 +272,266 @@ error_t tlsSetCache(TlsContext *context, TlsCache *cache)
 }
 
 
+/**
+ * @brief Set session ticket encryption context (server only)
+ *
+ * The server issues a session ticket to every client that supports the
+ * SessionTicket extension, so that the session can later be resumed
+ * without keeping any per-session state (RFC 5077). The same context is
+ * typically shared by all the connections of the server
+ *
+ * @param[in] context Pointer to the TLS context
+ * @param[in] ticketContext Session ticket encryption context
+ * @return Error code
+ **/
+
+error_t tlsSetTicketContext(TlsContext *context, TlsTicketContext *ticketContext)
+{
+#if (TLS_TICKET_SUPPORT == ENABLED)
+   //Check parameters
+   if(context == NULL || ticketContext == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Keys that will be used to protect the session tickets
+   context->ticketContext = ticketContext;
+
+   //Successful processing
+   return NO_ERROR;
+#else
+   //Session tickets are not supported
+   return ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
+
+/**
+ * @brief Enable or disable session tickets (client only)
+ *
+ * When session tickets are enabled, the client includes the SessionTicket
+ * extension in its ClientHello. The ticket received from the server is
+ * saved by tlsSaveSession() along with the other session parameters
+ *
+ * @param[in] context Pointer to the TLS context
+ * @param[in] enabled Specifies whether session tickets are requested
+ * @return Error code
+ **/
+
+error_t tlsEnableSessionTickets(TlsContext *context, bool_t enabled)
+{
+#if (TLS_TICKET_SUPPORT == ENABLED)
+   //Invalid TLS context?
+   if(context == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Save the setting
+   context->sessionTicketEnabled = enabled;
+
+   //Successful processing
+   return NO_ERROR;
+#else
+   //Session tickets are not supported
+   return ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
+
+/**
+ * @brief Enable or disable the coalescing of application data
+ *
+ * When coalescing is enabled, small writes are accumulated in the TX buffer
+ * until a full record can be sent. Buffered data is sent by tlsFlush(),
+ * before reading data from the peer and before closing the connection
+ *
+ * @param[in] context Pointer to the TLS context
+ * @param[in] enabled Specifies whether small writes are coalesced
+ * @return Error code
+ **/
+
+error_t tlsEnableRecordCoalescing(TlsContext *context, bool_t enabled)
+{
+   //Invalid TLS context?
+   if(context == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Save the setting
+   context->recordCoalescing = enabled;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Enable or disable dynamic record sizing
+ *
+ * When dynamic record sizing is enabled, application data is sent in
+ * records that fit in a single TCP segment at the beginning of the
+ * connection and after an idle period, so that the peer can start
+ * decrypting as soon as the first segment arrives. Records grow to their
+ * maximum size once TLS_SMALL_RECORD_THRESHOLD bytes have been sent
+ *
+ * @param[in] context Pointer to the TLS context
+ * @param[in] enabled Specifies whether the record size is adapted
+ * @return Error code
+ **/
+
+error_t tlsEnableDynamicRecordSizing(TlsContext *context, bool_t enabled)
+{
+   //Invalid TLS context?
+   if(context == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Save the setting
+   context->dynamicRecordSizing = enabled;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Set the pool from which record buffers are drawn
+ *
+ * Buffers are taken from the pool only while a record is being processed
+ * and are returned to it once the connection is idle. The heap is used
+ * whenever the pool is exhausted or its buffers are too small
+ *
+ * @param[in] context Pointer to the TLS context
+ * @param[in] bufferPool Pool of record buffers shared by several contexts
+ * @return Error code
+ **/
+
+error_t tlsSetBufferPool(TlsContext *context, TlsBufferPool *bufferPool)
+{
+   //Invalid TLS context?
+   if(context == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //The pool cannot be changed while buffers are held
+   if(context->txBuffer != NULL || context->rxBuffer != NULL)
+      return ERROR_WRONG_STATE;
+
+   //Save the buffer pool
+   context->bufferPool = bufferPool;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Request a maximum fragment length (client only)
+ *
+ * The client includes the MaxFragmentLength extension in its ClientHello
+ * (RFC 6066). If the server accepts it, records never carry more than the
+ * specified amount of data, and the buffers used once the connection is
+ * established are sized accordingly
+ *
+ * @param[in] context Pointer to the TLS context
+ * @param[in] maxFragLength Maximum fragment length (512, 1024, 2048, 4096
+ *   or 16384 bytes)
+ * @return Error code
+ **/
+
+error_t tlsSetMaxFragmentLength(TlsContext *context, size_t maxFragLength)
+{
+#if (TLS_MAX_FRAG_LEN_SUPPORT == ENABLED)
+   //Invalid TLS context?
+   if(context == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Make sure the specified value is acceptable
+   if(maxFragLength != 512 && maxFragLength != 1024 &&
+      maxFragLength != 2048 && maxFragLength != 4096 &&
+      maxFragLength != TLS_MAX_RECORD_LENGTH)
+   {
+      //Report an error
+      return ERROR_INVALID_PARAMETER;
+   }
+
+   //Save the maximum fragment length
+   context->requestedMaxFragLength = maxFragLength;
+
+   //Successful processing
+   return NO_ERROR;
+#else
+   //The MaxFragmentLength extension is not supported
+   return ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
+
+/**
+ * @brief Set the RSA batch context to be used for private-key operations
+ *
+ * The RSA batch context must hold the private key of the RSA certificate
+ * loaded with tlsAddCertificate. It can be shared by all the connections
+ * handled by the server, so that the RSA operations of concurrent
+ * handshakes are processed together
+ *
+ * @param[in] context Pointer to the TLS context
+ * @param[in] rsaBatchContext Pointer to the RSA batch context
+ * @return Error code
+ **/
+
+error_t tlsSetRsaBatchContext(TlsContext *context, RsaBatchContext *rsaBatchContext)
+{
+#if (RSA_BATCH_SUPPORT == ENABLED)
+   //Check parameters
+   if(context == NULL || rsaBatchContext == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Private-key operations will be submitted to the RSA batch context
+   context->rsaBatchContext = rsaBatchContext;
+
+   //Successful processing
+   return NO_ERROR;
+#else
+   return ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
+
+/**
+ * @brief Offload the private-key operations of the server
+ *
+ * The RSA decryption of the premaster secret and the RSA signature of the
+ * server's key exchange parameters are handed over to the application, for
+ * instance to be queued to a crypto worker or to a secure element. The
+ * handshake then returns ERROR_WANT_KEY_OPERATION and tlsConnect must be
+ * called again once the result is available. Since the application decides
+ * how many operations are processed at a time, the load generated by
+ * concurrent handshakes can be bounded
+ *
+ * @param[in] context Pointer to the TLS context
+ * @param[in] startCallback Function that submits a private-key operation
+ * @param[in] completeCallback Function that retrieves the result of the operation
+ * @param[in] param Opaque pointer passed to the callback functions
+ * @return Error code
+ **/
+
+error_t tlsSetKeyOpCallbacks(TlsContext *context, TlsKeyOpStartCallback startCallback,
+   TlsKeyOpCompleteCallback completeCallback, void *param)
+{
+#if (TLS_ASYNC_KEY_OP_SUPPORT == ENABLED)
+   //Check parameters
+   if(context == NULL || startCallback == NULL || completeCallback == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Save callback functions
+   context->keyOpStartCallback = startCallback;
+   context->keyOpCompleteCallback = completeCallback;
+   //Opaque pointer passed to the callback functions
+   context->keyOpParam = param;
+
+   //Successful processing
+   return NO_ERROR;
+#else
+   return ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
+
 /**
  * @brief Set client authentication mode
  * @param[in] context Pointer to the TLS context
@@ -325,6 +606,33 @@ error_t tlsSetDhParameters(TlsContext *context, const char_t *params, size_t len
 }
 
 
+/**
+ * @brief Set the shared Diffie-Hellman group
+ *
+ * The group holds the precomputed tables (and optionally the pool of
+ * key pairs) that are used to generate the ephemeral Diffie-Hellman
+ * key pairs. It can be shared by all the connections handled by the
+ * server, in which case there is no need to call tlsSetDhParameters
+ *
+ * @param[in] context Pointer to the TLS context
+ * @param[in] group Pointer to the Diffie-Hellman group
+ * @return Error code
+ **/
+
+error_t tlsSetDhGroup(TlsContext *context, DhGroup *group)
+{
+   //Check parameters
+   if(context == NULL || group == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Ephemeral key pairs will be generated using the shared group
+   context->dhParameters.group = group;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
 /**
  * @brief Import a trusted CA list
  * @param[in] context Pointer to the TLS context
@@ -351,6 +659,37 @@ error_t tlsSetTrustedCaList(TlsContext *context, const char_t *trustedCaList, si
 }
 
 
+/**
+ * @brief Use a certificate store to validate the peer's certificate chain
+ *
+ * The certificate store replaces the trusted CA list. It can be shared by
+ * several TLS contexts, so that a chain validated by one connection is
+ * not verified again by the next ones
+ *
+ * @param[in] context Pointer to the TLS context
+ * @param[in] certStore Certificate store created with tlsInitCertStore
+ * @return Error code
+ **/
+
+error_t tlsSetCertStore(TlsContext *context, TlsCertStore *certStore)
+{
+#if (TLS_CERT_STORE_SUPPORT == ENABLED)
+   //Check parameters
+   if(context == NULL || certStore == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Save the certificate store
+   context->certStore = certStore;
+
+   //Successful processing
+   return NO_ERROR;
+#else
+   //The certificate store is not supported
+   return ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
+
 /**
  * @brief Import a certificate and the corresponding private key
  * @param[in] context Pointer to the TLS context
@@ -454,6 +793,13 @@ error_t tlsAddCertificate(TlsContext *context, const char_t *certChain,
 
 /**
  * @brief Initiate the TLS handshake
+ *
+ * With a non-blocking socket, ERROR_WANT_READ or ERROR_WANT_WRITE is
+ * returned whenever the handshake cannot progress. The function must
+ * then be called again once the socket is readable or writable. Likewise,
+ * ERROR_WANT_KEY_OPERATION is returned while an offloaded private-key
+ * operation is in progress
+ *
  * @param[in] context Pointer to the TLS context
  * @return Error code
  **/
@@ -480,6 +826,15 @@ error_t tlsConnect(TlsContext *context)
    if(context->prngAlgo == NULL || context->prngContext == NULL)
       return ERROR_NOT_CONFIGURED;
 
+   //Allocate full-size send and receive buffers for the handshake
+   error = tlsAllocTxBuffer(context);
+   //Any error to report?
+   if(error) return error;
+
+   error = tlsAllocRxBuffer(context);
+   //Any error to report?
+   if(error) return error;
+
 #if (TLS_CLIENT_SUPPORT == ENABLED)
    //TLS operates as a client?
    if(context->entity == TLS_CONNECTION_END_CLIENT)
@@ -504,6 +859,9 @@ error_t tlsConnect(TlsContext *context)
       error = ERROR_INVALID_PARAMETER;
    }
 
+   //The handshake buffers are not needed anymore
+   tlsReleaseIdleBuffers(context);
+
    //Return status code
    return error;
 }
@@ -514,13 +872,63 @@ error_t tlsConnect(TlsContext *context)
  * @param[in] context Pointer to the TLS context
  * @param[in] data Pointer to a buffer containing the data to be transmitted
  * @param[in] length Number of bytes to be transmitted
+ * @param[out] written Actual number of bytes written (optional parameter)
+ * @param[in] flags Set of flags that influences the behavior of this function
+ * @return Error code
+ **/
+
+error_t tlsWrite(TlsContext *context, const void *data,
+   size_t length, size_t *written, uint_t flags)
+{
+   TlsIoVec iov;
+
+   //Invalid TLS context?
+   if(context == NULL)
+      return ERROR_INVALID_PARAMETER;
+   //Check parameters
+   if(data == NULL && length != 0)
+      return ERROR_INVALID_PARAMETER;
+
+   //Single data block
+   iov.data = data;
+   iov.length = length;
+
+   //Send application data
+   return tlsWritev(context, &iov, 1, written, flags);
+}
+
+
+/**
+ * @brief Send a list of data blocks to the remote host using TLS
+ *
+ * The data blocks are gathered into as few records as possible. Each block
+ * is copied once, directly after the room reserved for the explicit IV, and
+ * the record is then protected in place. When coalescing is enabled, the
+ * last incomplete record is kept in the TX buffer until more data is
+ * written or tlsFlush() is called.
+ *
+ * With a non-blocking socket, ERROR_WANT_WRITE is returned as soon as the
+ * socket cannot accept a complete record. The number of bytes written
+ * tells how much of the data has been taken over by the TLS layer. The
+ * rest must be written again, or tlsFlush() called, once the socket is
+ * writable
+ *
+ * @param[in] context Pointer to the TLS context
+ * @param[in] iov Array of data blocks to be transmitted
+ * @param[in] iovCount Number of entries in the array
+ * @param[out] written Actual number of bytes written (optional parameter)
  * @param[in] flags Set of flags that influences the behavior of this function
  * @return Error code
  **/
 
-error_t tlsWrite(TlsContext *context, const void *data, size_t length, uint_t flags)
+error_t tlsWritev(TlsContext *context, const TlsIoVec *iov,
+   uint_t iovCount, size_t *written, uint_t flags)
 {
    error_t error;
+   uint_t i;
+   size_t j;
+   size_t k;
+   size_t m;
    size_t n;
    uint8_t *p;
 
@@ -528,47 +936,162 @@ error_t tlsWrite(TlsContext *context, const void *data, size_t length, uint_t fl
    if(context == NULL)
       return ERROR_INVALID_PARAMETER;
    //Check parameters
-   if(data == NULL && length != 0)
+   if(iov == NULL && iovCount != 0)
       return ERROR_INVALID_PARAMETER;
 
-   //Pointer to the buffer where to copy the data
-   p = context->txBuffer + sizeof(TlsRecord);
+   //No data has been written yet
+   if(written != NULL)
+      *written = 0;
 
-   //Send all the data
-   while(length > 0)
+   //Check each data block
+   for(n = 0, i = 0; i < iovCount; i++)
    {
-      //Check the current state before sending data
-      if(context->state != TLS_STATE_APPLICATION_DATA)
-         return ERROR_NOT_CONNECTED;
+      //Invalid data block?
+      if(iov[i].data == NULL && iov[i].length != 0)
+         return ERROR_INVALID_PARAMETER;
 
-      //Calculate the number of bytes to write at a time
-      n = min(length, TLS_MAX_PROTOCOL_DATA_LENGTH);
-      //The record length cannot exceed 16384 bytes
-      n = min(n, TLS_MAX_RECORD_LENGTH);
+      //Total number of bytes to be written
+      n += iov[i].length;
+   }
 
-      //Copy data to the send buffer
-      memcpy(p, data, n);
+   //Nothing to send?
+   if(n == 0)
+      return NO_ERROR;
 
-      //Send application data
-      error = tlsWriteProtocolData(context, n, TLS_TYPE_APPLICATION_DATA);
+   //Check the current state before buffering data
+   if(context->state != TLS_STATE_APPLICATION_DATA)
+      return ERROR_NOT_CONNECTED;
 
-      //Failed to send data?
-      if(error)
+   //Make sure a send buffer is available
+   error = tlsAllocTxBuffer(context);
+   //Any error to report?
+   if(error) return error;
+
+   //Records that could not be sent at once must be flushed first
+   error = tlsSendPendingData(context);
+   //Any error to report?
+   if(error) return error;
+
+   //Index of the current data block
+   i = 0;
+   //Offset within the current data block
+   j = 0;
+
+   //Send all the data
+   while(1)
+   {
+      //Number of bytes to write in the current record
+      m = tlsGetWriteRecordLength(context);
+      //Data is written right after the room reserved for the explicit IV
+      p = context->txBuffer + sizeof(TlsRecord) + tlsGetRecordHeadroom(context);
+
+      //Gather as many bytes as the record can hold
+      for(n = context->txBufferLength; i < iovCount && n < m; )
       {
-         //Send an alert message to the peer
-         tlsProcessError(context, error);
-         //Report an error
-         return error;
+         //Number of bytes to copy from the current block
+         k = min(iov[i].length - j, m - n);
+
+         //Copy data to the send buffer
+         memcpy(p + n, (const uint8_t *) iov[i].data + j, k);
+
+         //Advance data pointers
+         n += k;
+         j += k;
+
+         //Total number of bytes taken over by the TLS layer
+         if(written != NULL)
+            *written += k;
+
+         //Current block is complete?
+         if(j >= iov[i].length)
+         {
+            //Jump to the next block
+            i++;
+            j = 0;
+         }
       }
 
-      //Advance data pointer
-      data = (uint8_t *) data + n;
-      //Data left to be written
-      length -= n;
+      //Number of bytes pending in the TX buffer
+      context->txBufferLength = n;
+
+      //No more data to send?
+      if(n == 0)
+         break;
+      //Keep the incomplete record until more data is written?
+      if(i >= iovCount && n < m && context->recordCoalescing)
+         break;
+
+      //Send application data
+      error = tlsFlush(context);
+      //Any error to report?
+      if(error) break;
    }
 
-   //Successful write operation
-   return NO_ERROR;
+   //Release the send buffer if it holds no pending data
+   tlsReleaseIdleBuffers(context);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Send the application data buffered by tlsWrite() or tlsWritev()
+ *
+ * This also sends the records that could not be written at once to a
+ * non-blocking socket. ERROR_WANT_WRITE is returned while some data
+ * remains pending
+ *
+ * @param[in] context Pointer to the TLS context
+ * @return Error code
+ **/
+
+error_t tlsFlush(TlsContext *context)
+{
+   error_t error;
+   size_t length;
+
+   //Invalid TLS context?
+   if(context == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Records that could not be sent at once must be flushed first
+   error = tlsSendPendingData(context);
+   //Any error to report?
+   if(error) return error;
+
+   //Number of bytes pending in the TX buffer
+   length = context->txBufferLength;
+   //Nothing to send?
+   if(length == 0)
+      return NO_ERROR;
+
+   //The buffered data is consumed in any case
+   context->txBufferLength = 0;
+
+   //Check the current state before sending data
+   if(context->state != TLS_STATE_APPLICATION_DATA)
+      return ERROR_NOT_CONNECTED;
+
+   //Send application data
+   error = tlsSendRecord(context, length, TLS_TYPE_APPLICATION_DATA);
+
+   //The record has been protected? Part of it may still be pending
+   if(!error || error == ERROR_WANT_WRITE)
+   {
+      //Keep track of the amount of data sent since the connection became active
+      context->txBurstLength += length;
+      //Save the time at which the data was sent
+      context->txTimestamp = osGetTickCount();
+   }
+   else
+   {
+      //Send an alert message to the peer
+      tlsProcessError(context, error);
+   }
+
+   //Return status code
+   return error;
 }
 
 
@@ -579,7 +1102,8 @@ error_t tlsWrite(TlsContext *context, const void *data, size_t length, uint_t fl
  * @param[in] size Maximum number of bytes that can be received
  * @param[out] received Number of bytes that have been received
  * @param[in] flags Set of flags that influences the behavior of this function
- * @return Error code
+ * @return Error code (ERROR_WANT_READ if no data is available on a
+ *   non-blocking socket)
  **/
 
 error_t tlsRead(TlsContext *context, void *data, size_t size, size_t *received, uint_t flags)
@@ -600,12 +1124,19 @@ error_t tlsRead(TlsContext *context, void *data, size_t size, size_t *received,
    //No data has been read yet
    *received = 0;
 
+   //Send any buffered data before waiting for the peer
+   error = tlsFlush(context);
+   //Any error to report?
+   if(error) return error;
+
    //Read as much data as possible
    for(*received = 0; *received < size; )
    {
       //Check the current state before reading data
       if(context->state == TLS_STATE_CLOSED)
       {
+         //Release the receive buffer if it holds no pending data
+         tlsReleaseIdleBuffers(context);
          //The user must be satisfied with data already on hand
          return (*received > 0) ? NO_ERROR : ERROR_END_OF_STREAM;
       }
@@ -703,11 +1234,16 @@ error_t tlsRead(TlsContext *context, void *data, size_t size, size_t *received,
       {
          //Send an alert message to the peer
          tlsProcessError(context, error);
+         //Release the receive buffer while waiting for more data
+         tlsReleaseIdleBuffers(context);
          //Exit immediately
          return error;
       }
    }
 
+   //Release the receive buffer if it holds no pending data
+   tlsReleaseIdleBuffers(context);
+
    //Successful read operation
    return NO_ERROR;
 }
@@ -730,9 +1266,25 @@ error_t tlsShutdown(TlsContext *context)
    if(context->state == TLS_STATE_APPLICATION_DATA ||
       context->state == TLS_STATE_CLOSED)
    {
+      //Send any buffered data first
+      error = tlsFlush(context);
+
       //Notifies the recipient that the sender will not send
       //any more messages on this connection
-      error = tlsSendAlert(context, TLS_ALERT_LEVEL_WARNING, TLS_ALERT_CLOSE_NOTIFY);
+      if(!error && !context->closeNotifySent)
+      {
+         //Send a close_notify alert
+         error = tlsSendAlert(context, TLS_ALERT_LEVEL_WARNING, TLS_ALERT_CLOSE_NOTIFY);
+
+         //The alert is sent only once, even if the function has to be
+         //called again (non-blocking mode)
+         if(!error)
+         {
+            context->closeNotifySent = TRUE;
+            error = tlsSendPendingData(context);
+         }
+      }
+
       //Update FSM state
       context->state = TLS_STATE_CLOSED;
    }
@@ -764,23 +1316,25 @@ void tlsFree(TlsContext *context)
    //Release server name
    osMemFree(context->serverName);
 
+#if (TLS_CHACHA_DRBG_SUPPORT == ENABLED)
+   //Release the per-connection generator
+   chachaDrbgRelease(&context->drbgContext);
+#endif
+
    //Free multiple precision integers
    dhFreeParameters(&context->dhParameters);
    rsaFreePublicKey(&context->peerRsaPublicKey);
    dsaFreePublicKey(&context->peerDsaPublicKey);
 
-   //Release send buffer
-   memset(context->txBuffer, 0, TLS_TX_BUFFER_SIZE);
-   osMemFree(context->txBuffer);
+   //Release ECDH context and EC public key
+   ecdhFree(&context->ecdhContext);
+   ecFreePublicKey(&context->peerEcPublicKey);
 
-   //Release receive buffer
-   memset(context->rxBuffer, 0, TLS_RX_BUFFER_SIZE);
-   osMemFree(context->rxBuffer);
+   //Release send and receive buffers
+   tlsReleaseBuffers(context);
 
    //Release resources used to compute handshake message hash
-   osMemFree(context->handshakeMd5Context);
-   osMemFree(context->handshakeSha1Context);
-   osMemFree(context->handshakeHashContext);
+   tlsFreeHandshakeHash(context);
 
    //Release the write encryption context
    if(context->writeCipherContext)
@@ -798,6 +1352,42 @@ void tlsFree(TlsContext *context)
       osMemFree(context->readCipherContext);
    }
 
+#if (TLS_GCM_CIPHER_SUPPORT == ENABLED)
+   //Release the write GCM context
+   if(context->writeGcmContext)
+   {
+      //Clear context contents, then release memory
+      memset(context->writeGcmContext, 0, sizeof(GcmContext));
+      osMemFree(context->writeGcmContext);
+   }
+
+   //Release the read GCM context
+   if(context->readGcmContext)
+   {
+      //Clear context contents, then release memory
+      memset(context->readGcmContext, 0, sizeof(GcmContext));
+      osMemFree(context->readGcmContext);
+   }
+#endif
+
+#if (TLS_MAX_VERSION >= TLS_VERSION_1_0 && TLS_MIN_VERSION <= TLS_VERSION_1_2)
+   //Release the write HMAC context
+   if(context->writeHmacContext)
+   {
+      //Clear context contents, then release memory
+      memset(context->writeHmacContext, 0, sizeof(HmacContext));
+      osMemFree(context->writeHmacContext);
+   }
+
+   //Release the read HMAC context
+   if(context->readHmacContext)
+   {
+      //Clear context contents, then release memory
+      memset(context->readHmacContext, 0, sizeof(HmacContext));
+      osMemFree(context->readHmacContext);
+   }
+#endif
+
    //Clear the TLS context before freeing memory
    memset(context, 0, sizeof(TlsContext));
    osMemFree(context);
@@ -817,8 +1407,18 @@ error_t tlsSaveSession(const TlsContext *context, TlsSession *session)
    if(context == NULL || session == NULL)
       return ERROR_INVALID_PARAMETER;
 
+#if (TLS_TICKET_SUPPORT == ENABLED)
+   //A session can be identified by its ID or by a session ticket
+   if(!context->sessionIdLength && !context->ticketLength)
+      return ERROR_FAILURE;
+#else
+   //Invalid session identifier?
+   if(!context->sessionIdLength)
+      return ERROR_FAILURE;
+#endif
+
    //Invalid session parameters?
-   if(!context->sessionIdLength || !context->cipherSuite)
+   if(!context->cipherSuite)
       return ERROR_FAILURE;
 
    //Save session identifier
@@ -835,6 +1435,12 @@ error_t tlsSaveSession(const TlsContext *context, TlsSession *session)
    //Save master secret
    memcpy(session->masterSecret, context->masterSecret, 48);
 
+#if (TLS_TICKET_SUPPORT == ENABLED)
+   //Save session ticket
+   memcpy(session->ticket, context->ticket, context->ticketLength);
+   session->ticketLength = context->ticketLength;
+#endif
+
    //Successful processing
    return NO_ERROR;
 }
@@ -864,6 +1470,12 @@ error_t tlsRestoreSession(TlsContext *context, const TlsSession *session)
    //Restore master secret
    memcpy(context->masterSecret, session->masterSecret, 48);
 
+#if (TLS_TICKET_SUPPORT == ENABLED)
+   //Restore session ticket
+   memcpy(context->ticket, session->ticket, session->ticketLength);
+   context->ticketLength = session->ticketLength;
+#endif
+
    //Successful processing
    return NO_ERROR;
 }
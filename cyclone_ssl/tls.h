@@ -34,8 +34,16 @@
 #include "tls_config.h"
 #include "hmac.h"
 #include "rsa.h"
+#include "rsa_batch.h"
+#include "chacha_drbg.h"
 #include "dsa.h"
 #include "dh.h"
+#include "ecdh.h"
+#include "ecdsa.h"
+#include "aes.h"
+#include "cipher_mode_gcm.h"
+#include "sha256.h"
+#include "x509.h"
 
 //TLS version numbers
 #define SSL_VERSION_3_0 0x0300
@@ -99,6 +107,46 @@
    #error TLS_SESSION_CACHE_LIFETIME parameter is invalid
 #endif
 
+//Number of independently locked session cache shards
+#ifndef TLS_SESSION_CACHE_SHARDS
+   #define TLS_SESSION_CACHE_SHARDS 4
+#elif (TLS_SESSION_CACHE_SHARDS < 1 || TLS_SESSION_CACHE_SHARDS > 64)
+   #error TLS_SESSION_CACHE_SHARDS parameter is invalid
+#endif
+
+//Session ticket mechanism (RFC 5077)
+#ifndef TLS_TICKET_SUPPORT
+   #define TLS_TICKET_SUPPORT TLS_SESSION_RESUME_SUPPORT
+#elif (TLS_TICKET_SUPPORT != ENABLED && TLS_TICKET_SUPPORT != DISABLED)
+   #error TLS_TICKET_SUPPORT parameter is invalid
+#endif
+
+//Session tickets are a session resumption mechanism
+#if (TLS_TICKET_SUPPORT == ENABLED && TLS_SESSION_RESUME_SUPPORT != ENABLED)
+   #error TLS_TICKET_SUPPORT requires TLS_SESSION_RESUME_SUPPORT
+#endif
+
+//Lifetime of session tickets
+#ifndef TLS_TICKET_LIFETIME
+   #define TLS_TICKET_LIFETIME 3600000
+#elif (TLS_TICKET_LIFETIME < 1000)
+   #error TLS_TICKET_LIFETIME parameter is invalid
+#endif
+
+//Period after which a new ticket protection key is generated
+#ifndef TLS_TICKET_KEY_LIFETIME
+   #define TLS_TICKET_KEY_LIFETIME TLS_TICKET_LIFETIME
+#elif (TLS_TICKET_KEY_LIFETIME < 1000)
+   #error TLS_TICKET_KEY_LIFETIME parameter is invalid
+#endif
+
+//Maximum size of a session ticket the client can store
+#ifndef TLS_MAX_TICKET_SIZE
+   #define TLS_MAX_TICKET_SIZE 256
+#elif (TLS_MAX_TICKET_SIZE < 128)
+   #error TLS_MAX_TICKET_SIZE parameter is invalid
+#endif
+
 //SNI (Server Name Indication) extension
 #ifndef TLS_SNI_SUPPORT
    #define TLS_SNI_SUPPORT ENABLED
@@ -106,6 +154,41 @@
    #error TLS_SNI_SUPPORT parameter is invalid
 #endif
 
+//Trusted CA store and certificate chain cache
+#ifndef TLS_CERT_STORE_SUPPORT
+   #define TLS_CERT_STORE_SUPPORT ENABLED
+#elif (TLS_CERT_STORE_SUPPORT != ENABLED && TLS_CERT_STORE_SUPPORT != DISABLED)
+   #error TLS_CERT_STORE_SUPPORT parameter is invalid
+#endif
+
+//Number of hash buckets used to index trusted CA certificates
+#ifndef TLS_CERT_STORE_BUCKETS
+   #define TLS_CERT_STORE_BUCKETS 16
+#elif (TLS_CERT_STORE_BUCKETS < 1 || (TLS_CERT_STORE_BUCKETS & (TLS_CERT_STORE_BUCKETS - 1)))
+   #error TLS_CERT_STORE_BUCKETS parameter is invalid
+#endif
+
+//Maximum lifetime of validated certificate chains, in milliseconds
+#ifndef TLS_CHAIN_CACHE_LIFETIME
+   #define TLS_CHAIN_CACHE_LIFETIME 86400000
+#elif (TLS_CHAIN_CACHE_LIFETIME < 1000)
+   #error TLS_CHAIN_CACHE_LIFETIME parameter is invalid
+#endif
+
+//Maximum Fragment Length extension
+#ifndef TLS_MAX_FRAG_LEN_SUPPORT
+   #define TLS_MAX_FRAG_LEN_SUPPORT ENABLED
+#elif (TLS_MAX_FRAG_LEN_SUPPORT != ENABLED && TLS_MAX_FRAG_LEN_SUPPORT != DISABLED)
+   #error TLS_MAX_FRAG_LEN_SUPPORT parameter is invalid
+#endif
+
+//Asynchronous private-key operations (server only)
+#ifndef TLS_ASYNC_KEY_OP_SUPPORT
+   #define TLS_ASYNC_KEY_OP_SUPPORT ENABLED
+#elif (TLS_ASYNC_KEY_OP_SUPPORT != ENABLED && TLS_ASYNC_KEY_OP_SUPPORT != DISABLED)
+   #error TLS_ASYNC_KEY_OP_SUPPORT parameter is invalid
+#endif
+
 //Maximum number of certificates the end entity can load
 #ifndef TLS_MAX_CERTIFICATES
    #define TLS_MAX_CERTIFICATES 3
@@ -120,6 +203,27 @@
    #error TLS_MAX_PROTOCOL_DATA_LENGTH parameter is invalid
 #endif
 
+//Application data sent in small records before switching to full-size records
+#ifndef TLS_SMALL_RECORD_THRESHOLD
+   #define TLS_SMALL_RECORD_THRESHOLD 65536
+#elif (TLS_SMALL_RECORD_THRESHOLD < 0)
+   #error TLS_SMALL_RECORD_THRESHOLD parameter is invalid
+#endif
+
+//Idle time after which records shrink back to their initial size
+#ifndef TLS_RECORD_IDLE_TIMEOUT
+   #define TLS_RECORD_IDLE_TIMEOUT 1000
+#elif (TLS_RECORD_IDLE_TIMEOUT < 0)
+   #error TLS_RECORD_IDLE_TIMEOUT parameter is invalid
+#endif
+
+//Size of small records when the TCP MSS cannot be retrieved
+#ifndef TLS_SMALL_RECORD_LENGTH
+   #define TLS_SMALL_RECORD_LENGTH 1300
+#elif (TLS_SMALL_RECORD_LENGTH < 256 || TLS_SMALL_RECORD_LENGTH > 16384)
+   #error TLS_SMALL_RECORD_LENGTH parameter is invalid
+#endif
+
 //RSA key exchange support
 #ifndef TLS_RSA_SUPPORT
    #define TLS_RSA_SUPPORT ENABLED
@@ -148,6 +252,20 @@
    #error TLS_DH_ANON_SUPPORT parameter is invalid
 #endif
 
+//ECDHE_RSA key exchange support
+#ifndef TLS_ECDHE_RSA_SUPPORT
+   #define TLS_ECDHE_RSA_SUPPORT ENABLED
+#elif (TLS_ECDHE_RSA_SUPPORT != ENABLED && TLS_ECDHE_RSA_SUPPORT != DISABLED)
+   #error TLS_ECDHE_RSA_SUPPORT parameter is invalid
+#endif
+
+//ECDHE_ECDSA key exchange support
+#ifndef TLS_ECDHE_ECDSA_SUPPORT
+   #define TLS_ECDHE_ECDSA_SUPPORT ENABLED
+#elif (TLS_ECDHE_ECDSA_SUPPORT != ENABLED && TLS_ECDHE_ECDSA_SUPPORT != DISABLED)
+   #error TLS_ECDHE_ECDSA_SUPPORT parameter is invalid
+#endif
+
 //RSA signature capability
 #ifndef TLS_RSA_SIGN_SUPPORT
    #define TLS_RSA_SIGN_SUPPORT ENABLED
@@ -162,6 +280,13 @@
    #error TLS_DSA_SIGN_SUPPORT parameter is invalid
 #endif
 
+//ECDSA signature capability
+#ifndef TLS_ECDSA_SIGN_SUPPORT
+   #define TLS_ECDSA_SIGN_SUPPORT ENABLED
+#elif (TLS_ECDSA_SIGN_SUPPORT != ENABLED && TLS_ECDSA_SIGN_SUPPORT != DISABLED)
+   #error TLS_ECDSA_SIGN_SUPPORT parameter is invalid
+#endif
+
 //Stream cipher support
 #ifndef TLS_STREAM_CIPHER_SUPPORT
    #define TLS_STREAM_CIPHER_SUPPORT ENABLED
@@ -190,6 +315,25 @@
    #error TLS_GCM_CIPHER_SUPPORT parameter is invalid
 #endif
 
+//ChaCha20Poly1305 AEAD support
+#ifndef TLS_CHACHA20_POLY1305_SUPPORT
+   #define TLS_CHACHA20_POLY1305_SUPPORT ENABLED
+#elif (TLS_CHACHA20_POLY1305_SUPPORT != ENABLED && TLS_CHACHA20_POLY1305_SUPPORT != DISABLED)
+   #error TLS_CHACHA20_POLY1305_SUPPORT parameter is invalid
+#endif
+
+//Per-connection random number generator
+#ifndef TLS_CHACHA_DRBG_SUPPORT
+   #define TLS_CHACHA_DRBG_SUPPORT ENABLED
+#elif (TLS_CHACHA_DRBG_SUPPORT != ENABLED && TLS_CHACHA_DRBG_SUPPORT != DISABLED)
+   #error TLS_CHACHA_DRBG_SUPPORT parameter is invalid
+#endif
+
+//The per-connection generator relies on the ChaCha DRBG
+#if (TLS_CHACHA_DRBG_SUPPORT == ENABLED && CHACHA_DRBG_SUPPORT != ENABLED)
+   #error TLS_CHACHA_DRBG_SUPPORT requires CHACHA_DRBG_SUPPORT
+#endif
+
 //RC4 cipher support
 #ifndef TLS_RC4_SUPPORT
    #define TLS_RC4_SUPPORT ENABLED
@@ -563,6 +707,19 @@ typedef enum
 } TlsNameType;
 
 
+/**
+ * @brief Maximum fragment length
+ **/
+
+typedef enum
+{
+   TLS_MAX_FRAG_LENGTH_512  = 1,
+   TLS_MAX_FRAG_LENGTH_1024 = 2,
+   TLS_MAX_FRAG_LENGTH_2048 = 3,
+   TLS_MAX_FRAG_LENGTH_4096 = 4
+} TlsMaxFragLength;
+
+
 /**
  * @brief EC named curves
  **/
@@ -594,6 +751,7 @@ typedef enum
    TLS_EC_CURVE_SECP256R1                = 23,
    TLS_EC_CURVE_SECP384R1                = 24,
    TLS_EC_CURVE_SECP521R1                = 25,
+   TLS_EC_CURVE_ECDH_X25519              = 29,
    TLS_EC_CURVE_ARBITRARY_EXPLICIT_PRIME = 65281,
    TLS_EC_CURVE_ARBITRARY_EXPLICIT_CHAR2 = 65282
 } TlsEcNamedCurve;
@@ -641,11 +799,12 @@ typedef enum
    TLS_STATE_CERTIFICATE_VERIFY        = 9,
    TLS_STATE_CLIENT_CHANGE_CIPHER_SPEC = 10,
    TLS_STATE_CLIENT_FINISHED           = 11,
-   TLS_STATE_SERVER_CHANGE_CIPHER_SPEC = 12,
-   TLS_STATE_SERVER_FINISHED           = 13,
-   TLS_STATE_APPLICATION_DATA          = 14,
-   TLS_STATE_CLOSED                    = 15,
-   TLS_STATE_FATAL_ERROR               = 16
+   TLS_STATE_NEW_SESSION_TICKET        = 12,
+   TLS_STATE_SERVER_CHANGE_CIPHER_SPEC = 13,
+   TLS_STATE_SERVER_FINISHED           = 14,
+   TLS_STATE_APPLICATION_DATA          = 15,
+   TLS_STATE_CLOSED                    = 16,
+   TLS_STATE_FATAL_ERROR               = 17
 } TlsState;
 
 
@@ -803,6 +962,28 @@ typedef __packed struct
 } TlsServerNameList;
 
 
+/**
+ * @brief List of supported elliptic curves
+ **/
+
+typedef __packed struct
+{
+   uint16_t length;  //0-1
+   uint16_t value[]; //2
+} TlsEllipticCurveList;
+
+
+/**
+ * @brief List of supported EC point formats
+ **/
+
+typedef __packed struct
+{
+   uint8_t length;  //0
+   uint8_t value[]; //1
+} TlsEcPointFormatList;
+
+
 /**
  * @brief Digitally-signed element (SSL 3.0, TLS 1.0 and TLS 1.1)
  **/
@@ -951,6 +1132,20 @@ typedef __packed struct
 } TlsCertificateVerify;
 
 
+/**
+ * @brief NewSessionTicket message
+ **/
+
+typedef __packed struct
+{
+   uint8_t msgType;             //0
+   uint8_t length[3];           //1-3
+   uint32_t ticketLifetimeHint; //4-7
+   uint16_t ticketLength;       //8-9
+   uint8_t ticket[];            //10
+} TlsNewSessionTicket;
+
+
 /**
  * @brief Finished message
  **/
@@ -1031,21 +1226,187 @@ typedef struct
    uint16_t cipherSuite;      ///<Cipher suite identifier
    uint8_t compressionMethod; ///<Compression method
    uint8_t masterSecret[48];  ///<Master secret
+#if (TLS_TICKET_SUPPORT == ENABLED)
+   uint8_t ticket[TLS_MAX_TICKET_SIZE]; ///<Session ticket (client only)
+   size_t ticketLength;       ///<Length of the session ticket
+#endif
 } TlsSession;
 
 
+/**
+ * @brief Session cache entry
+ **/
+
+typedef struct _TlsCacheEntry
+{
+   TlsSession session;              ///<Session parameters
+   uint32_t hash;                   ///<Hash value of the session ID
+   struct _TlsCacheEntry *hashNext; ///<Next entry in the hash chain (or in the pool)
+   struct _TlsCacheEntry *lruPrev;  ///<More recently used entry
+   struct _TlsCacheEntry *lruNext;  ///<Less recently used entry
+} TlsCacheEntry;
+
+
+/**
+ * @brief Session cache shard
+ *
+ * Each shard has its own hash table indexed by session ID and its own
+ * LRU list, both protected by a dedicated mutex
+ **/
+
+typedef struct
+{
+   OsMutex *mutex;           ///<Mutex preventing simultaneous access to the shard
+   uint_t numBuckets;        ///<Number of hash buckets (power of two)
+   TlsCacheEntry **buckets;  ///<Hash buckets
+   TlsCacheEntry *lruHead;   ///<Most recently used entry
+   TlsCacheEntry *lruTail;   ///<Least recently used entry
+   uint_t count;             ///<Number of entries in use
+   uint32_t hits;            ///<Successful lookups
+   uint32_t misses;          ///<Failed lookups
+   uint32_t insertions;      ///<Sessions added to the shard
+   uint32_t evictions;       ///<Live sessions dropped to make room
+   uint32_t expirations;     ///<Outdated sessions dropped
+} TlsCacheShard;
+
+
 /**
  * @brief Session cache
  **/
 
 typedef struct
 {
-   OsMutex *mutex;        ///<Mutex preventing simultaneous access to the cache
-   uint_t size;           ///<Maximum number of entries
-   TlsSession sessions[]; ///<Cache entries
+   OsMutex *mutex;                                 ///<Mutex protecting the pool of free entries
+   TlsCacheEntry *freeList;                        ///<Pool of free entries shared by all shards
+   uint_t size;                                    ///<Maximum number of entries
+   uint_t numShards;                               ///<Number of shards
+   TlsCacheShard shards[TLS_SESSION_CACHE_SHARDS]; ///<Cache shards
+   TlsCacheEntry *entries;                         ///<Cache entries
 } TlsCache;
 
 
+/**
+ * @brief Session cache statistics
+ **/
+
+typedef struct
+{
+   uint_t size;          ///<Maximum number of entries
+   uint_t count;         ///<Number of entries in use
+   uint32_t hits;        ///<Successful lookups
+   uint32_t misses;      ///<Failed lookups
+   uint32_t insertions;  ///<Sessions added to the cache
+   uint32_t evictions;   ///<Live sessions dropped to make room
+   uint32_t expirations; ///<Outdated sessions dropped
+} TlsCacheStats;
+
+
+/**
+ * @brief Pool of record buffers shared by several TLS contexts
+ **/
+
+typedef struct
+{
+   OsMutex *mutex;      ///<Mutex preventing simultaneous access to the pool
+   size_t bufferSize;   ///<Size of each buffer
+   uint_t count;        ///<Number of buffers
+   uint_t freeCount;    ///<Number of free buffers
+   uint_t minFreeCount; ///<Lowest number of free buffers seen so far
+   void *freeList;      ///<List of free buffers
+   uint8_t *buffers;    ///<Memory holding the buffers
+} TlsBufferPool;
+
+
+/**
+ * @brief Session ticket protection key
+ **/
+
+typedef struct
+{
+   bool_t valid;           ///<The key can be used
+   uint8_t name[16];       ///<Key name, sent in clear at the start of the ticket
+   time_t timestamp;       ///<Time at which the key was generated
+   AesContext aesContext;  ///<AES-256 key schedule
+   GcmContext gcmContext;  ///<GCM context
+} TlsTicketKey;
+
+
+/**
+ * @brief Session ticket encryption context
+ *
+ * Tickets are sealed under the current key. The previous key is kept
+ * so that tickets issued before a rotation can still be decrypted
+ *
+ **/
+
+typedef struct
+{
+   OsMutex *mutex;         ///<Mutex preventing simultaneous access to the keys
+   uint_t index;           ///<Index of the current key
+   TlsTicketKey keys[2];   ///<Current and previous keys
+} TlsTicketContext;
+
+
+/**
+ * @brief Trusted CA certificate
+ **/
+
+typedef struct _TlsTrustedCa
+{
+   struct _TlsTrustedCa *next;     ///<Next certificate in the list
+   struct _TlsTrustedCa *hashNext; ///<Next certificate in the hash chain
+   uint32_t hash;                  ///<Hash value of the subject name
+   uint8_t *derCert;               ///<DER encoded certificate
+   size_t derCertLength;           ///<Length of the DER encoded certificate
+   X509CertificateInfo certInfo;   ///<Parsed certificate
+} TlsTrustedCa;
+
+
+/**
+ * @brief Certificate chain that has been successfully validated
+ **/
+
+typedef struct
+{
+   uint8_t digest[SHA256_DIGEST_SIZE]; ///<Digest of the certificate list
+   uint32_t notAfter;                  ///<End of the validity period of the chain
+   time_t timestamp;                   ///<Time at which the chain was validated
+   bool_t valid;                       ///<The entry is in use
+} TlsChainCacheEntry;
+
+
+/**
+ * @brief Trusted CA store and certificate chain cache
+ *
+ * A certificate store can be shared by several TLS contexts. The
+ * trusted CA certificates are never modified once the store is created
+ *
+ **/
+
+typedef struct
+{
+   TlsTrustedCa *caList;                          ///<Trusted CA certificates
+   uint_t numCa;                                  ///<Number of trusted CA certificates
+   TlsTrustedCa *buckets[TLS_CERT_STORE_BUCKETS]; ///<Trusted CA certificates indexed by subject name
+   OsMutex *mutex;                                ///<Mutex preventing simultaneous access to the cache
+   TlsChainCacheEntry *chains;                    ///<Validated certificate chains
+   uint_t size;                                   ///<Maximum number of validated chains
+   uint32_t hits;                                 ///<Successful lookups
+   uint32_t misses;                               ///<Failed lookups
+} TlsCertStore;
+
+
+/**
+ * @brief Data block for scatter/gather writes
+ **/
+
+typedef struct
+{
+   const void *data; ///<Pointer to the data block
+   size_t length;    ///<Length of the data block, in bytes
+} TlsIoVec;
+
+
 /**
  * @brief Certificate descriptor
  **/
@@ -1062,6 +1423,54 @@ typedef struct
 } TlsCertDesc;
 
 
+/**
+ * @brief Private-key operations
+ **/
+
+typedef enum
+{
+   TLS_KEY_OP_NONE        = 0,
+   TLS_KEY_OP_RSA_DECRYPT = 1, ///<RSAES-PKCS1-v1_5 decryption of the premaster secret
+   TLS_KEY_OP_RSA_SIGN    = 2  ///<PKCS #1 v1.5 signature of the server's key exchange parameters
+} TlsKeyOpType;
+
+
+/**
+ * @brief Private-key operation to be performed asynchronously
+ **/
+
+typedef struct
+{
+   TlsKeyOpType type;        ///<Private-key operation
+   const TlsCertDesc *cert;  ///<Certificate whose private key is to be used
+   const HashAlgo *hashAlgo; ///<Hash algorithm (NULL for the MD5/SHA-1 digest of SSL 3.0 to TLS 1.1)
+   const uint8_t *input;     ///<RSA-encrypted premaster secret or digest to be signed
+   size_t inputLength;       ///<Length of the input
+} TlsKeyOp;
+
+
+/**
+ * @brief Callback function that submits a private-key operation
+ *
+ * The input is only valid during the call and must be copied. NO_ERROR
+ * means that the operation has been queued
+ *
+ **/
+
+typedef error_t (*TlsKeyOpStartCallback)(const TlsKeyOp *op, void *param);
+
+
+/**
+ * @brief Callback function that retrieves the result of a private-key operation
+ *
+ * ERROR_WANT_KEY_OPERATION is returned as long as the operation is in progress
+ *
+ **/
+
+typedef error_t (*TlsKeyOpCompleteCallback)(uint8_t *output,
+   size_t size, size_t *length, void *param);
+
+
 /**
  * @brief TLS context
  *
@@ -1077,6 +1486,9 @@ typedef struct
 
    const PrngAlgo *prngAlgo;                ///<Pseudo-random number generator to be used
    void *prngContext;                       ///<Pseudo-random number generator context
+#if (TLS_CHACHA_DRBG_SUPPORT == ENABLED)
+   ChachaDrbgContext drbgContext;           ///<Per-connection generator, seeded from the application PRNG
+#endif
 
    const uint16_t *cipherSuites;            ///<List of supported cipher suites
    uint_t numCipherSuites;                  ///<Number of cipher suites in the list
@@ -1084,6 +1496,9 @@ typedef struct
    char_t *serverName;                      ///<Fully qualified DNS hostname of the server
 
    DhParameters dhParameters;               ///<Diffie-Hellman parameters
+   EcdhContext ecdhContext;                 ///<ECDH context
+   uint16_t namedCurve;                     ///<Named curve used for ECDHE key exchange
+   bool_t ecPointFormatsExtReceived;        ///<The EcPointFormats extension has been received
 
    TlsCertDesc certs[TLS_MAX_CERTIFICATES]; //End entity certificates
    uint_t numCerts;                         //Number of certificates available
@@ -1091,12 +1506,34 @@ typedef struct
 
    const char_t *trustedCaList;             ///<List of trusted CA (PEM format)
    size_t trustedCaListLength;              ///<Number of trusted CA in the list
+#if (TLS_CERT_STORE_SUPPORT == ENABLED)
+   TlsCertStore *certStore;                 ///<Trusted CA store and certificate chain cache
+#endif
 
    TlsCertificateType peerCertType;         ///<Peer certificate type
    RsaPublicKey peerRsaPublicKey;           ///<Peer RSA public key
    DsaPublicKey peerDsaPublicKey;           ///<Peer DSA public key
+   EcPublicKey peerEcPublicKey;             ///<Peer EC public key
 
    TlsCache *cache;                         ///<TLS session cache
+#if (TLS_TICKET_SUPPORT == ENABLED)
+   TlsTicketContext *ticketContext;         ///<Session ticket encryption context (server only)
+   bool_t sessionTicketEnabled;             ///<Session tickets are requested from the server (client only)
+   bool_t newSessionTicket;                 ///<A NewSessionTicket message is to be sent or received
+   uint8_t ticket[TLS_MAX_TICKET_SIZE];     ///<Session ticket (client only)
+   size_t ticketLength;                     ///<Length of the session ticket
+   uint32_t ticketLifetimeHint;             ///<Lifetime hint of the session ticket, in seconds
+#endif
+#if (RSA_BATCH_SUPPORT == ENABLED)
+   RsaBatchContext *rsaBatchContext;        ///<Shared RSA batch context (server only)
+#endif
+#if (TLS_ASYNC_KEY_OP_SUPPORT == ENABLED)
+   TlsKeyOpStartCallback keyOpStartCallback;       ///<Submit a private-key operation (server only)
+   TlsKeyOpCompleteCallback keyOpCompleteCallback; ///<Retrieve the result of a private-key operation
+   void *keyOpParam;                        ///<Opaque pointer passed to the callback functions
+   TlsKeyOpType keyOpType;                  ///<Private-key operation in progress
+   size_t keyOpLength;                      ///<Length of the data already formatted in the TX buffer
+#endif
 
    uint8_t sessionId[32];                   ///<Session identifier
    size_t sessionIdLength;                  ///<Length of the session identifier
@@ -1130,20 +1567,48 @@ typedef struct
 
    bool_t changeCipherSpecSent;             ///<A ChangeCipherSpec message has been sent
    bool_t changeCipherSpecReceived;         ///<A ChangeCipherSpec message has been received from the peer
+   bool_t closeNotifySent;                  ///<A close_notify alert has been sent
 
    void *writeCipherContext;                ///<Bulk cipher context for write operations
    void *readCipherContext;                 ///<Bulk cipher context for read operations
+#if (TLS_GCM_CIPHER_SUPPORT == ENABLED)
+   GcmContext *writeGcmContext;             ///<GCM context for write operations
+   GcmContext *readGcmContext;              ///<GCM context for read operations
+#endif
+#if (TLS_MAX_VERSION >= TLS_VERSION_1_0 && TLS_MIN_VERSION <= TLS_VERSION_1_2)
+   HmacContext *writeHmacContext;           ///<HMAC context keyed with the write MAC key
+   HmacContext *readHmacContext;            ///<HMAC context keyed with the read MAC key
+#endif
    HmacContext hmacContext;                 ///<HMAC context
 
+   TlsBufferPool *bufferPool;               ///<Shared pool of record buffers
+#if (TLS_MAX_FRAG_LEN_SUPPORT == ENABLED)
+   size_t requestedMaxFragLength;           ///<Maximum fragment length requested by the client
+#endif
+   size_t maxFragLength;                    ///<Negotiated maximum fragment length
+
    uint8_t *txBuffer;                       ///<TX buffer
+   size_t txBufferSize;                     ///<Size of the TX buffer
    TlsContentType txBufferType;             ///<Type of data that resides in the TX buffer
    size_t txBufferLength;                   ///<Number of bytes that are pending to be sent
+   size_t txRecordIndex;                    ///<Offset of the protected data that remains to be sent
+   size_t txRecordLength;                   ///<Number of protected bytes that remain to be sent
+   size_t txFragmentIndex;                  ///<Offset of the data that remains to be fragmented
+   size_t txFragmentLength;                 ///<Number of bytes that remain to be fragmented
+   bool_t recordCoalescing;                 ///<Coalesce small writes into larger records
+   bool_t dynamicRecordSizing;              ///<Adapt the record size to the state of the connection
+   size_t txBurstLength;                    ///<Application data sent since the connection became active
+   time_t txTimestamp;                      ///<Time at which application data was last sent
 
    uint8_t *rxBuffer;                       ///<RX buffer
+   size_t rxBufferSize;                     ///<Size of the RX buffer
    TlsContentType rxBufferType;             ///<Type of data that resides in the RX buffer
    size_t rxBufferLength;                   ///<Number of bytes available for reading
    size_t rxBufferWriteIndex;               ///<Current write index
    size_t rxBufferReadIndex;                ///<Current read index
+   TlsRecord rxRecord;                      ///<Header of the next record, read ahead
+   size_t rxRecordLength;                   ///<Number of header bytes already read
+   size_t rxRecordPos;                      ///<Number of record data bytes already read
 
    union
    {
@@ -1179,16 +1644,33 @@ error_t tlsSetConnectionEnd(TlsContext *context, TlsConnectionEnd entity);
 error_t tlsSetPrng(TlsContext *context, const PrngAlgo *prngAlgo, void *prngContext);
 error_t tlsSetServerName(TlsContext *context, const char_t *serverName);
 error_t tlsSetCache(TlsContext *context, TlsCache *cache);
+error_t tlsSetTicketContext(TlsContext *context, TlsTicketContext *ticketContext);
+error_t tlsEnableSessionTickets(TlsContext *context, bool_t enabled);
+error_t tlsEnableRecordCoalescing(TlsContext *context, bool_t enabled);
+error_t tlsEnableDynamicRecordSizing(TlsContext *context, bool_t enabled);
+error_t tlsSetBufferPool(TlsContext *context, TlsBufferPool *bufferPool);
+error_t tlsSetMaxFragmentLength(TlsContext *context, size_t maxFragLength);
 error_t tlsSetClientAuthMode(TlsContext *context, TlsClientAuthMode mode);
+error_t tlsSetRsaBatchContext(TlsContext *context, RsaBatchContext *rsaBatchContext);
+
+error_t tlsSetKeyOpCallbacks(TlsContext *context, TlsKeyOpStartCallback startCallback,
+   TlsKeyOpCompleteCallback completeCallback, void *param);
+
 error_t tlsSetCipherSuites(TlsContext *context, const uint16_t *cipherSuites, uint_t length);
 error_t tlsSetDhParameters(TlsContext *context, const char_t *params, size_t length);
+error_t tlsSetDhGroup(TlsContext *context, DhGroup *group);
 error_t tlsSetTrustedCaList(TlsContext *context, const char_t *trustedCaList, size_t length);
+error_t tlsSetCertStore(TlsContext *context, TlsCertStore *certStore);
 
 error_t tlsAddCertificate(TlsContext *context, const char_t *certChain,
    size_t certChainLength, const char_t *privateKey, size_t privateKeyLength);
 
 error_t tlsConnect(TlsContext *context);
-error_t tlsWrite(TlsContext *context, const void *data, size_t length, uint_t flags);
+error_t tlsWrite(TlsContext *context, const void *data,
+   size_t length, size_t *written, uint_t flags);
+error_t tlsWritev(TlsContext *context, const TlsIoVec *iov,
+   uint_t iovCount, size_t *written, uint_t flags);
+error_t tlsFlush(TlsContext *context);
 error_t tlsRead(TlsContext *context, void *data, size_t size, size_t *received, uint_t flags);
 error_t tlsShutdown(TlsContext *context);
 void tlsFree(TlsContext *context);
@@ -1197,6 +1679,17 @@ error_t tlsSaveSession(const TlsContext *context, TlsSession *session);
 error_t tlsRestoreSession(TlsContext *context, const TlsSession *session);
 
 TlsCache *tlsInitCache(uint_t size);
+error_t tlsGetCacheStats(TlsCache *cache, TlsCacheStats *stats);
 void tlsFreeCache(TlsCache *cache);
 
+TlsBufferPool *tlsInitBufferPool(uint_t count, size_t bufferSize);
+void tlsFreeBufferPool(TlsBufferPool *bufferPool);
+
+TlsTicketContext *tlsInitTicketContext(void);
+void tlsFreeTicketContext(TlsTicketContext *ticketContext);
+
+TlsCertStore *tlsInitCertStore(const char_t *trustedCaList,
+   size_t length, uint_t cacheSize);
+void tlsFreeCertStore(TlsCertStore *certStore);
+
 #endif
@@ -0,0 +1,441 @@
+/**
+ * @file tls_buffer.c
+ * @brief Record buffer management
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneSSL Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * Record buffers are only needed while a record is being built or parsed.
+ * Full-size buffers are allocated when the handshake starts, since a whole
+ * handshake message must fit in them. Once the connection is established,
+ * buffers are sized according to the negotiated maximum fragment length
+ * (RFC 6066). When a buffer pool is attached to the context, buffers are
+ * drawn from the pool on demand and returned to it as soon as they hold no
+ * pending data, so that idle connections do not tie up any record buffer
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL TLS_TRACE_LEVEL
+
+//Dependencies
+#include <string.h>
+#include "tls.h"
+#include "tls_buffer.h"
+#include "debug.h"
+
+//Check SSL library configuration
+#if (TLS_SUPPORT == ENABLED)
+
+
+/**
+ * @brief Create a pool of record buffers
+ * @param[in] count Number of buffers
+ * @param[in] bufferSize Size of each buffer (TLS_TX_BUFFER_SIZE for
+ *   buffers that can be used during the handshake)
+ * @return Handle referencing the fully initialized buffer pool
+ **/
+
+TlsBufferPool *tlsInitBufferPool(uint_t count, size_t bufferSize)
+{
+   uint_t i;
+   size_t n;
+   TlsBufferPool *pool;
+
+   //Make sure the parameters are acceptable
+   if(count < 1 || bufferSize < sizeof(void *))
+      return NULL;
+
+   //Keep each buffer suitably aligned
+   bufferSize = (bufferSize + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+   //Size of the memory required
+   n = sizeof(TlsBufferPool) + count * bufferSize;
+
+   //Allocate a memory buffer to hold the pool
+   pool = osMemAlloc(n);
+   //Failed to allocate memory?
+   if(pool == NULL) return NULL;
+
+   //Clear memory
+   memset(pool, 0, n);
+
+   //Create a mutex to prevent simultaneous access to the pool
+   pool->mutex = osMutexCreate(FALSE);
+
+   //Out of ressources?
+   if(pool->mutex == OS_INVALID_HANDLE)
+   {
+      //Clean up side effects
+      osMemFree(pool);
+      //Report an error
+      return NULL;
+   }
+
+   //Save parameters
+   pool->bufferSize = bufferSize;
+   pool->count = count;
+   pool->freeCount = count;
+   pool->minFreeCount = count;
+
+   //Buffers immediately follow the pool structure
+   pool->buffers = (uint8_t *) (pool + 1);
+
+   //Link the buffers together
+   for(i = 0; i < count; i++)
+   {
+      *((void **) (pool->buffers + i * bufferSize)) = pool->freeList;
+      pool->freeList = pool->buffers + i * bufferSize;
+   }
+
+   //Return a pointer to the newly created pool
+   return pool;
+}
+
+
+/**
+ * @brief Allocate a record buffer
+ * @param[in] context Pointer to the TLS context
+ * @param[in] size Minimum size of the buffer
+ * @param[out] actualSize Actual size of the buffer
+ * @return Pointer to the buffer, or NULL if no memory is available
+ **/
+
+static uint8_t *tlsAllocBuffer(TlsContext *context, size_t size, size_t *actualSize)
+{
+   uint8_t *p;
+   TlsBufferPool *pool;
+
+   //Point to the buffer pool
+   pool = context->bufferPool;
+
+   //Check whether the pool can provide a buffer of the requested size
+   if(pool != NULL && pool->bufferSize >= size)
+   {
+      //Acquire exclusive access to the pool
+      osMutexAcquire(pool->mutex);
+
+      //Pop the first free buffer
+      p = pool->freeList;
+
+      //Any buffer available?
+      if(p != NULL)
+      {
+         //Remove the buffer from the list
+         pool->freeList = *((void **) p);
+         pool->freeCount--;
+
+         //Keep track of the lowest number of free buffers
+         if(pool->freeCount < pool->minFreeCount)
+            pool->minFreeCount = pool->freeCount;
+      }
+
+      //Release exclusive access to the pool
+      osMutexRelease(pool->mutex);
+
+      //Successful allocation?
+      if(p != NULL)
+      {
+         //Save the actual size of the buffer
+         *actualSize = pool->bufferSize;
+         //Return a pointer to the buffer
+         return p;
+      }
+   }
+
+   //Fall back to the heap
+   p = osMemAlloc(size);
+
+   //Successful allocation?
+   if(p != NULL)
+      *actualSize = size;
+
+   //Return a pointer to the buffer
+   return p;
+}
+
+
+/**
+ * @brief Release a record buffer
+ * @param[in] context Pointer to the TLS context
+ * @param[in] p Pointer to the buffer
+ * @param[in] size Size of the buffer
+ **/
+
+static void tlsFreeBuffer(TlsContext *context, uint8_t *p, size_t size)
+{
+   TlsBufferPool *pool;
+
+   //Point to the buffer pool
+   pool = context->bufferPool;
+
+   //Clear the buffer before releasing it
+   memset(p, 0, size);
+
+   //Check whether the buffer belongs to the pool
+   if(pool != NULL && p >= pool->buffers &&
+      p < (pool->buffers + pool->count * pool->bufferSize))
+   {
+      //Acquire exclusive access to the pool
+      osMutexAcquire(pool->mutex);
+
+      //Push the buffer onto the list of free buffers
+      *((void **) p) = pool->freeList;
+      pool->freeList = p;
+      pool->freeCount++;
+
+      //Release exclusive access to the pool
+      osMutexRelease(pool->mutex);
+   }
+   else
+   {
+      //The buffer was allocated from the heap
+      osMemFree(p);
+   }
+}
+
+
+/**
+ * @brief Size of the TX buffer required in the current state
+ * @param[in] context Pointer to the TLS context
+ * @return Size of the buffer, in bytes
+ **/
+
+static size_t tlsGetTxBufferSize(TlsContext *context)
+{
+   //Whole handshake messages are built in the TX buffer
+   if(context->state < TLS_STATE_APPLICATION_DATA)
+      return TLS_TX_BUFFER_SIZE;
+
+   //Application data records are limited by the maximum fragment length
+   return sizeof(TlsRecord) + min(context->maxFragLength,
+      TLS_MAX_PROTOCOL_DATA_LENGTH) + TLS_MAX_RECORD_OVERHEAD;
+}
+
+
+/**
+ * @brief Size of the RX buffer required in the current state
+ * @param[in] context Pointer to the TLS context
+ * @return Size of the buffer, in bytes
+ **/
+
+static size_t tlsGetRxBufferSize(TlsContext *context)
+{
+   //Handshake messages are reassembled in the RX buffer
+   if(context->state < TLS_STATE_APPLICATION_DATA)
+      return TLS_RX_BUFFER_SIZE;
+
+   //Application data records are limited by the maximum fragment length
+   return min(context->maxFragLength, TLS_MAX_PROTOCOL_DATA_LENGTH) +
+      TLS_MAX_RECORD_OVERHEAD;
+}
+
+
+/**
+ * @brief Make sure a TX buffer is available
+ * @param[in] context Pointer to the TLS context
+ * @return Error code
+ **/
+
+error_t tlsAllocTxBuffer(TlsContext *context)
+{
+   size_t n;
+
+   //Size of the buffer required in the current state
+   n = tlsGetTxBufferSize(context);
+
+   //The current buffer is large enough?
+   if(context->txBuffer != NULL && context->txBufferSize >= n)
+      return NO_ERROR;
+
+   //Pending data cannot be moved to a larger buffer
+   if(context->txBuffer != NULL && (context->txBufferLength > 0 ||
+      context->txRecordLength > 0 || context->txFragmentLength > 0))
+   {
+      return ERROR_FAILURE;
+   }
+
+   //Release the current buffer
+   if(context->txBuffer != NULL)
+      tlsFreeBuffer(context, context->txBuffer, context->txBufferSize);
+
+   //Allocate a new buffer
+   context->txBuffer = tlsAllocBuffer(context, n, &context->txBufferSize);
+
+   //Failed to allocate memory?
+   if(context->txBuffer == NULL)
+   {
+      //The context does not hold any TX buffer
+      context->txBufferSize = 0;
+      //Report an error
+      return ERROR_OUT_OF_MEMORY;
+   }
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Make sure a RX buffer is available
+ * @param[in] context Pointer to the TLS context
+ * @return Error code
+ **/
+
+error_t tlsAllocRxBuffer(TlsContext *context)
+{
+   size_t n;
+
+   //Size of the buffer required in the current state
+   n = tlsGetRxBufferSize(context);
+
+   //The current buffer is large enough?
+   if(context->rxBuffer != NULL && context->rxBufferSize >= n)
+      return NO_ERROR;
+
+   //Pending data cannot be moved to a larger buffer
+   if(context->rxBuffer != NULL && (context->rxBufferLength > 0 ||
+      context->rxRecordPos > 0))
+   {
+      return ERROR_FAILURE;
+   }
+
+   //Release the current buffer
+   if(context->rxBuffer != NULL)
+      tlsFreeBuffer(context, context->rxBuffer, context->rxBufferSize);
+
+   //Allocate a new buffer
+   context->rxBuffer = tlsAllocBuffer(context, n, &context->rxBufferSize);
+
+   //Failed to allocate memory?
+   if(context->rxBuffer == NULL)
+   {
+      //The context does not hold any RX buffer
+      context->rxBufferSize = 0;
+      //Report an error
+      return ERROR_OUT_OF_MEMORY;
+   }
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Release the record buffers that are not needed anymore
+ *
+ * Buffers are kept during the handshake. Afterwards, a buffer that holds no
+ * pending data is returned to the pool, if any, or released when it is
+ * larger than required by the negotiated maximum fragment length
+ *
+ * @param[in] context Pointer to the TLS context
+ **/
+
+void tlsReleaseIdleBuffers(TlsContext *context)
+{
+   //Handshake in progress?
+   if(context->state < TLS_STATE_APPLICATION_DATA)
+      return;
+
+   //The TX buffer holds no pending data?
+   if(context->txBuffer != NULL && context->txBufferLength == 0 &&
+      context->txRecordLength == 0 && context->txFragmentLength == 0)
+   {
+      //Release the buffer if it comes from a pool or if it is oversized
+      if(context->bufferPool != NULL || context->txBufferSize > tlsGetTxBufferSize(context))
+      {
+         tlsFreeBuffer(context, context->txBuffer, context->txBufferSize);
+         context->txBuffer = NULL;
+         context->txBufferSize = 0;
+      }
+   }
+
+   //The RX buffer holds no pending data, nor a partially received record?
+   if(context->rxBuffer != NULL && context->rxBufferLength == 0 &&
+      context->rxRecordPos == 0)
+   {
+      //Release the buffer if it comes from a pool or if it is oversized
+      if(context->bufferPool != NULL || context->rxBufferSize > tlsGetRxBufferSize(context))
+      {
+         tlsFreeBuffer(context, context->rxBuffer, context->rxBufferSize);
+         context->rxBuffer = NULL;
+         context->rxBufferSize = 0;
+      }
+   }
+}
+
+
+/**
+ * @brief Release all the record buffers held by a TLS context
+ * @param[in] context Pointer to the TLS context
+ **/
+
+void tlsReleaseBuffers(TlsContext *context)
+{
+   //Release the TX buffer
+   if(context->txBuffer != NULL)
+      tlsFreeBuffer(context, context->txBuffer, context->txBufferSize);
+
+   //Release the RX buffer
+   if(context->rxBuffer != NULL)
+      tlsFreeBuffer(context, context->rxBuffer, context->rxBufferSize);
+
+   //The context does not hold any buffer anymore
+   context->txBuffer = NULL;
+   context->txBufferSize = 0;
+   context->txBufferLength = 0;
+   context->txRecordLength = 0;
+   context->txFragmentLength = 0;
+   context->rxBuffer = NULL;
+   context->rxBufferSize = 0;
+   context->rxBufferLength = 0;
+   context->rxRecordPos = 0;
+}
+
+
+/**
+ * @brief Properly dispose a pool of record buffers
+ * @param[in] bufferPool Pointer to the pool to be released
+ **/
+
+void tlsFreeBufferPool(TlsBufferPool *bufferPool)
+{
+   size_t n;
+
+   //Invalid pool?
+   if(bufferPool == NULL)
+      return;
+
+   //Release previously allocated ressources
+   osMutexClose(bufferPool->mutex);
+
+   //Compute the number of bytes allocated for the pool
+   n = sizeof(TlsBufferPool) + bufferPool->count * bufferPool->bufferSize;
+
+   //Clear the pool before freeing memory
+   memset(bufferPool, 0, n);
+   osMemFree(bufferPool);
+}
+
+#endif
@@ -0,0 +1,45 @@
+/**
+ * @file tls_buffer.h
+ * @brief Record buffer management
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneSSL Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+#ifndef _TLS_BUFFER_H
+#define _TLS_BUFFER_H
+
+//Dependencies
+#include "tls.h"
+
+//Record buffer management
+TlsBufferPool *tlsInitBufferPool(uint_t count, size_t bufferSize);
+
+error_t tlsAllocTxBuffer(TlsContext *context);
+error_t tlsAllocRxBuffer(TlsContext *context);
+void tlsReleaseIdleBuffers(TlsContext *context);
+void tlsReleaseBuffers(TlsContext *context);
+
+void tlsFreeBufferPool(TlsBufferPool *bufferPool);
+
+#endif
@@ -22,6 +22,16 @@
  * along with this program; if not, write to the Free Software Foundation,
  * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
  *
+ * @section Description
+ *
+ * The cache is split into shards, each protected by its own mutex. Within
+ * a shard, sessions are indexed by a hash table keyed on the session ID and
+ * kept on a LRU list that drives eviction. Free entries are drawn from a
+ * pool shared by all shards, so that an uneven distribution of session IDs
+ * does not cause premature evictions. Outdated entries are discarded lazily,
+ * whenever they are met while walking a hash chain or when they reach the
+ * tail of the LRU list
+ *
  * @author Oryx Embedded (www.oryx-embedded.com)
  * @version 1.3.8
  **/
@@ -39,6 +49,278 @@
 #if (TLS_SUPPORT == ENABLED)
 
 
+/**
+ * @brief Compute the hash value of a session ID (FNV-1a)
+ * @param[in] id Session ID
+ * @param[in] length Length of the session ID
+ * @return Hash value
+ **/
+
+static uint32_t tlsCacheHash(const uint8_t *id, size_t length)
+{
+   size_t i;
+   uint32_t h;
+
+   //FNV offset basis
+   h = 2166136261UL;
+
+   //Process the session ID byte by byte
+   for(i = 0; i < length; i++)
+   {
+      h ^= id[i];
+      h *= 16777619UL;
+   }
+
+   //Return the resulting hash value
+   return h;
+}
+
+
+/**
+ * @brief Select the shard responsible for a given hash value
+ * @param[in] cache Pointer to the session cache
+ * @param[in] hash Hash value of the session ID
+ * @return Pointer to the relevant shard
+ **/
+
+static TlsCacheShard *tlsCacheGetShard(TlsCache *cache, uint32_t hash)
+{
+   //The upper bits select the shard, the lower bits select the bucket
+   return &cache->shards[(hash >> 16) % cache->numShards];
+}
+
+
+/**
+ * @brief Remove an entry from the LRU list
+ * @param[in] shard Pointer to the shard that holds the entry
+ * @param[in] entry Entry that has already been unlinked from its hash chain
+ **/
+
+static void tlsCacheUnlinkEntry(TlsCacheShard *shard, TlsCacheEntry *entry)
+{
+   //Unlink the entry from the LRU list
+   if(entry->lruPrev != NULL)
+      entry->lruPrev->lruNext = entry->lruNext;
+   else
+      shard->lruHead = entry->lruNext;
+
+   if(entry->lruNext != NULL)
+      entry->lruNext->lruPrev = entry->lruPrev;
+   else
+      shard->lruTail = entry->lruPrev;
+
+   //Erase session parameters
+   memset(&entry->session, 0, sizeof(TlsSession));
+
+   //Clear links
+   entry->hash = 0;
+   entry->hashNext = NULL;
+   entry->lruPrev = NULL;
+   entry->lruNext = NULL;
+
+   //Update the number of entries in use
+   shard->count--;
+}
+
+
+/**
+ * @brief Return an unused entry to the pool
+ * @param[in] cache Pointer to the session cache
+ * @param[in] entry Entry to be released
+ **/
+
+static void tlsCacheReleaseEntry(TlsCache *cache, TlsCacheEntry *entry)
+{
+   //Acquire exclusive access to the pool
+   osMutexAcquire(cache->mutex);
+   //Push the entry onto the pool
+   entry->hashNext = cache->freeList;
+   cache->freeList = entry;
+   //Release exclusive access to the pool
+   osMutexRelease(cache->mutex);
+}
+
+
+/**
+ * @brief Take an unused entry from the pool
+ * @param[in] cache Pointer to the session cache
+ * @return Pointer to the entry, or NULL if the pool is empty
+ **/
+
+static TlsCacheEntry *tlsCacheAllocEntry(TlsCache *cache)
+{
+   TlsCacheEntry *entry;
+
+   //Acquire exclusive access to the pool
+   osMutexAcquire(cache->mutex);
+
+   //Pop the first entry from the pool
+   entry = cache->freeList;
+   if(entry != NULL)
+      cache->freeList = entry->hashNext;
+
+   //Release exclusive access to the pool
+   osMutexRelease(cache->mutex);
+
+   //Return the entry
+   return entry;
+}
+
+
+/**
+ * @brief Remove an entry from its hash chain
+ * @param[in] shard Pointer to the shard that holds the entry
+ * @param[in] entry Entry to be unlinked
+ **/
+
+static void tlsCacheUnchainEntry(TlsCacheShard *shard, TlsCacheEntry *entry)
+{
+   TlsCacheEntry **p;
+
+   //Point to the relevant hash bucket
+   p = &shard->buckets[entry->hash & (shard->numBuckets - 1)];
+
+   //Walk the hash chain until the entry is found
+   while(*p != NULL && *p != entry)
+      p = &(*p)->hashNext;
+
+   //Unlink the entry
+   if(*p != NULL)
+      *p = entry->hashNext;
+}
+
+
+/**
+ * @brief Move an entry to the head of the LRU list
+ * @param[in] shard Pointer to the shard that holds the entry
+ * @param[in] entry Entry that has just been used
+ **/
+
+static void tlsCacheTouchEntry(TlsCacheShard *shard, TlsCacheEntry *entry)
+{
+   //Already the most recently used entry?
+   if(shard->lruHead == entry)
+      return;
+
+   //Unlink the entry from its current position
+   entry->lruPrev->lruNext = entry->lruNext;
+
+   if(entry->lruNext != NULL)
+      entry->lruNext->lruPrev = entry->lruPrev;
+   else
+      shard->lruTail = entry->lruPrev;
+
+   //Insert the entry at the head of the list
+   entry->lruPrev = NULL;
+   entry->lruNext = shard->lruHead;
+   shard->lruHead->lruPrev = entry;
+   shard->lruHead = entry;
+}
+
+
+/**
+ * @brief Recycle the least recently used entry of a shard
+ * @param[in] shard Pointer to the shard
+ * @return Pointer to the recycled entry, or NULL if the shard is empty
+ **/
+
+static TlsCacheEntry *tlsCacheEvictEntry(TlsCacheShard *shard)
+{
+   time_t time;
+   TlsCacheEntry *entry;
+
+   //Acquire exclusive access to the shard
+   osMutexAcquire(shard->mutex);
+
+   //Point to the least recently used entry
+   entry = shard->lruTail;
+
+   //The shard holds at least one entry?
+   if(entry != NULL)
+   {
+      //Get current time
+      time = osGetTickCount();
+
+      //Update statistics
+      if((time - entry->session.timestamp) >= TLS_SESSION_CACHE_LIFETIME)
+         shard->expirations++;
+      else
+         shard->evictions++;
+
+      //Remove the entry from the shard
+      tlsCacheUnchainEntry(shard, entry);
+      tlsCacheUnlinkEntry(shard, entry);
+   }
+
+   //Release exclusive access to the shard
+   osMutexRelease(shard->mutex);
+
+   //Return the recycled entry
+   return entry;
+}
+
+
+/**
+ * @brief Search a shard for a given session ID
+ *
+ * Outdated entries met while walking the hash chain are discarded
+ *
+ * @param[in] cache Pointer to the session cache
+ * @param[in] shard Pointer to the shard
+ * @param[in] hash Hash value of the session ID
+ * @param[in] id Expected session ID
+ * @param[in] length Length of the session ID
+ * @return Pointer to the matching entry, or NULL if no valid entry exists
+ **/
+
+static TlsCacheEntry *tlsCacheLookup(TlsCache *cache, TlsCacheShard *shard,
+   uint32_t hash, const uint8_t *id, size_t length)
+{
+   time_t time;
+   TlsCacheEntry *entry;
+   TlsCacheEntry **p;
+
+   //Get current time
+   time = osGetTickCount();
+
+   //Point to the relevant hash bucket
+   p = &shard->buckets[hash & (shard->numBuckets - 1)];
+
+   //Walk the hash chain
+   while(*p != NULL)
+   {
+      //Point to the current entry
+      entry = *p;
+
+      //Outdated entry?
+      if((time - entry->session.timestamp) >= TLS_SESSION_CACHE_LIFETIME)
+      {
+         //This session is no more valid and should be removed from the cache
+         *p = entry->hashNext;
+         tlsCacheUnlinkEntry(shard, entry);
+         tlsCacheReleaseEntry(cache, entry);
+         //Update statistics
+         shard->expirations++;
+      }
+      //Check whether the current identifier matches the specified session ID
+      else if(entry->hash == hash && entry->session.idLength == length &&
+         !memcmp(entry->session.id, id, length))
+      {
+         //Matching entry found
+         return entry;
+      }
+      else
+      {
+         //Jump to the next entry in the chain
+         p = &entry->hashNext;
+      }
+   }
+
+   //No matching entry in the shard
+   return NULL;
+}
+
+
 /**
  * @brief Session cache initialization
  * @param[in] size Maximum number of cache entries
@@ -47,15 +329,32 @@
 
 TlsCache *tlsInitCache(uint_t size)
 {
+   uint_t i;
+   uint_t k;
+   uint_t m;
    size_t n;
    TlsCache *cache;
+   TlsCacheShard *shard;
+   TlsCacheEntry **buckets;
 
    //Make sure the parameter is acceptable
    if(size < 1)
       return NULL;
 
-   //Size of the memory required
-   n = sizeof(TlsCache) + size * sizeof(TlsSession);
+   //Size of the memory required for the cache and its entries
+   n = sizeof(TlsCache) + size * sizeof(TlsCacheEntry);
+
+   //Average number of entries per shard
+   k = (size + TLS_SESSION_CACHE_SHARDS - 1) / TLS_SESSION_CACHE_SHARDS;
+
+   //Each shard uses a power-of-two number of buckets, so that
+   //the average load factor never exceeds one
+   for(m = 1; m < k; m <<= 1)
+   {
+   }
+
+   //Add the memory required for the hash buckets
+   n += min(size, TLS_SESSION_CACHE_SHARDS) * m * sizeof(TlsCacheEntry *);
 
    //Allocate a memory buffer to hold the session cache
    cache = osMemAlloc(n);
@@ -65,20 +364,60 @@ TlsCache *tlsInitCache(uint_t size)
    //Clear memory
    memset(cache, 0, n);
 
-   //Create a mutex to prevent simultaneous access to the cache
+   //Save the maximum number of cache entries
+   cache->size = size;
+   //Small caches use fewer shards
+   cache->numShards = min(size, TLS_SESSION_CACHE_SHARDS);
+
+   //Cache entries immediately follow the cache structure
+   cache->entries = (TlsCacheEntry *) (cache + 1);
+   //Hash buckets immediately follow the cache entries
+   buckets = (TlsCacheEntry **) (cache->entries + size);
+
+   //All the entries are initially available
+   for(i = 0; i < size; i++)
+   {
+      cache->entries[i].hashNext = cache->freeList;
+      cache->freeList = &cache->entries[i];
+   }
+
+   //Assign hash buckets to each shard
+   for(i = 0; i < cache->numShards; i++)
+   {
+      cache->shards[i].numBuckets = m;
+      cache->shards[i].buckets = buckets + i * m;
+   }
+
+   //Create a mutex to prevent simultaneous access to the pool
    cache->mutex = osMutexCreate(FALSE);
 
    //Out of ressources?
    if(cache->mutex == OS_INVALID_HANDLE)
    {
       //Clean up side effects
-      osMemFree(cache);
+      tlsFreeCache(cache);
       //Report an error
       return NULL;
    }
 
-   //Save the maximum number of cache entries
-   cache->size = size;
+   //Initialize shards
+   for(i = 0; i < cache->numShards; i++)
+   {
+      //Point to the current shard
+      shard = &cache->shards[i];
+
+      //Create a mutex to prevent simultaneous access to the shard
+      shard->mutex = osMutexCreate(FALSE);
+
+      //Out of ressources?
+      if(shard->mutex == OS_INVALID_HANDLE)
+      {
+         //Clean up side effects
+         tlsFreeCache(cache);
+         //Report an error
+         return NULL;
+      }
+   }
 
    //Return a pointer to the newly created cache
    return cache;
@@ -90,67 +429,57 @@ TlsCache *tlsInitCache(uint_t size)
  * @param[in] cache Pointer to the session cache
  * @param[in] id Expected session ID
  * @param[in] length Length of the session ID
- * @return A pointer to the matching session is returned. NULL is returned
- *   if the specified ID could not be found in the session cache
+ * @param[out] session Copy of the matching session parameters
+ * @return Error code. ERROR_NOT_FOUND is returned if the specified ID
+ *   could not be found in the session cache
  **/
 
-TlsSession *tlsFindCache(TlsCache *cache, const uint8_t *id, size_t length)
+error_t tlsFindCache(TlsCache *cache, const uint8_t *id,
+   size_t length, TlsSession *session)
 {
-   uint_t i;
-   time_t time;
-   TlsSession *session;
+   uint32_t hash;
+   TlsCacheShard *shard;
+   TlsCacheEntry *entry;
 
-   //Check whether session caching is supported
-   if(cache == NULL)
-      return NULL;
+   //Check parameters
+   if(cache == NULL || session == NULL)
+      return ERROR_INVALID_PARAMETER;
    //Ensure the session ID is valid
    if(id == NULL || length == 0)
-      return NULL;
+      return ERROR_NOT_FOUND;
 
-   //Get current time
-   time = osGetTickCount();
+   //Hash the session ID
+   hash = tlsCacheHash(id, length);
+   //Select the relevant shard
+   shard = tlsCacheGetShard(cache, hash);
 
-   //Acquire exclusive access to the session cache
-   osMutexAcquire(cache->mutex);
+   //Acquire exclusive access to the shard
+   osMutexAcquire(shard->mutex);
 
-   //Flush expired entries
-   for(i = 0; i < cache->size; i++)
-   {
-      //Point to the current entry
-      session = &cache->sessions[i];
+   //Search the shard for the specified session ID
+   entry = tlsCacheLookup(cache, shard, hash, id, length);
 
-      //Skip unused entries
-      if(session->idLength)
-      {
-         //Outdated entry?
-         if((time - session->timestamp) >= TLS_SESSION_CACHE_LIFETIME)
-         {
-            //This session is no more valid and should be removed from the cache
-            memset(session, 0, sizeof(TlsSession));
-         }
-      }
+   //Matching entry found?
+   if(entry != NULL)
+   {
+      //Copy session parameters while the lock is still held
+      memcpy(session, &entry->session, sizeof(TlsSession));
+      //Mark the entry as the most recently used one
+      tlsCacheTouchEntry(shard, entry);
+      //Update statistics
+      shard->hits++;
    }
-
-   //Search the cache for the specified session ID
-   for(i = 0; i < cache->size; i++)
+   else
    {
-      //Point to the current entry
-      session = &cache->sessions[i];
-
-      //Check whether the current identifier matches the specified session ID
-      if(session->idLength == length && !memcmp(session->id, id, length))
-      {
-         //Release exclusive access to the session cache
-         osMutexRelease(cache->mutex);
-         //Return session parameters
-         return session;
-      }
+      //Update statistics
+      shard->misses++;
    }
 
-   //Release exclusive access to the session cache
-   osMutexRelease(cache->mutex);
-   //No matching entry in session cache
-   return NULL;
+   //Release exclusive access to the shard
+   osMutexRelease(shard->mutex);
+
+   //Return status code
+   return (entry != NULL) ? NO_ERROR : ERROR_NOT_FOUND;
 }
 
 
@@ -164,9 +493,11 @@ error_t tlsSaveToCache(TlsContext *context)
 {
    error_t error;
    uint_t i;
-   TlsSession *session;
-   TlsSession *firstFreeEntry;
-   TlsSession *oldestEntry;
+   uint_t n;
+   uint32_t hash;
+   TlsCache *cache;
+   TlsCacheShard *shard;
+   TlsCacheEntry *entry;
 
    //Check parameters
    if(context == NULL)
@@ -178,56 +509,86 @@ error_t tlsSaveToCache(TlsContext *context)
    if(context->sessionIdLength == 0)
       return NO_ERROR;
 
-   //Acquire exclusive access to the session cache
-   osMutexAcquire(context->cache->mutex);
+   //Point to the session cache
+   cache = context->cache;
 
-   //Keep track of the first free entry
-   firstFreeEntry = NULL;
-   //Keep track of the oldest entry
-   oldestEntry = NULL;
+   //Hash the session ID
+   hash = tlsCacheHash(context->sessionId, context->sessionIdLength);
+   //Select the relevant shard
+   shard = tlsCacheGetShard(cache, hash);
 
-   //Search the cache for the specified session ID
-   for(i = 0; i < context->cache->size; i++)
+   //Take an entry from the pool
+   entry = tlsCacheAllocEntry(cache);
+
+   //The cache is full?
+   if(entry == NULL)
    {
-      //Point to the current entry
-      session = &context->cache->sessions[i];
+      //Index of the shard
+      n = shard - cache->shards;
 
-      //If the session ID already exists, we are done
-      if(session->idLength == context->sessionIdLength &&
-         !memcmp(session->id, context->sessionId, session->idLength))
-      {
-         //Do not write to session cache
-         firstFreeEntry = NULL;
-         oldestEntry = NULL;
-         //Exit immedialtely
-         break;
-      }
+      //Recycle the least recently used entry of the shard or, if the
+      //shard is empty, the least recently used entry of another shard
+      for(i = 0; i < cache->numShards && entry == NULL; i++)
+         entry = tlsCacheEvictEntry(&cache->shards[(n + i) % cache->numShards]);
 
-      //Check whether current entry is free
-      if(!session->idLength)
-      {
-         //Keep track of the first free entry
-         if(!firstFreeEntry)
-            firstFreeEntry = session;
-      }
-      else
-      {
-         //Keep track of the oldest entry in the table
-         if(!oldestEntry || timeCompare(session->timestamp, oldestEntry->timestamp) < 0)
-            oldestEntry = session;
-      }
+      //No entry can be recycled?
+      if(entry == NULL)
+         return NO_ERROR;
+   }
+
+   //Acquire exclusive access to the shard
+   osMutexAcquire(shard->mutex);
+
+   //If the session ID already exists, we are done
+   if(tlsCacheLookup(cache, shard, hash, context->sessionId,
+      context->sessionIdLength) != NULL)
+   {
+      //Release exclusive access to the shard
+      osMutexRelease(shard->mutex);
+      //Return the entry to the pool
+      tlsCacheReleaseEntry(cache, entry);
+      //Do not write to session cache
+      return NO_ERROR;
    }
 
-   //Add current session to cache if necessary
-   if(firstFreeEntry != NULL)
-      error = tlsSaveSession(context, firstFreeEntry);
-   else if(oldestEntry != NULL)
-      error = tlsSaveSession(context, oldestEntry);
+   //Save session parameters
+   error = tlsSaveSession(context, &entry->session);
+
+   //Check status code
+   if(!error)
+   {
+      //Save the hash value of the session ID
+      entry->hash = hash;
+
+      //Insert the entry at the head of its hash chain
+      entry->hashNext = shard->buckets[hash & (shard->numBuckets - 1)];
+      shard->buckets[hash & (shard->numBuckets - 1)] = entry;
+
+      //Insert the entry at the head of the LRU list
+      entry->lruPrev = NULL;
+      entry->lruNext = shard->lruHead;
+
+      if(shard->lruHead != NULL)
+         shard->lruHead->lruPrev = entry;
+      else
+         shard->lruTail = entry;
+
+      shard->lruHead = entry;
+
+      //Update the number of entries in use
+      shard->count++;
+      //Update statistics
+      shard->insertions++;
+   }
    else
-      error = NO_ERROR;
+   {
+      //Return the entry to the pool
+      memset(&entry->session, 0, sizeof(TlsSession));
+      tlsCacheReleaseEntry(cache, entry);
+   }
 
-   //Release exclusive access to the session cache
-   osMutexRelease(context->cache->mutex);
+   //Release exclusive access to the shard
+   osMutexRelease(shard->mutex);
    //Return status code
    return error;
 }
@@ -241,8 +602,9 @@ error_t tlsSaveToCache(TlsContext *context)
 
 error_t tlsRemoveFromCache(TlsContext *context)
 {
-   uint_t i;
-   TlsSession *session;
+   uint32_t hash;
+   TlsCacheShard *shard;
+   TlsCacheEntry *entry;
 
    //Check parameters
    if(context == NULL)
@@ -255,26 +617,75 @@ error_t tlsRemoveFromCache(TlsContext *context)
    if(context->sessionIdLength == 0)
       return NO_ERROR;
 
-   //Acquire exclusive access to the session cache
-   osMutexAcquire(context->cache->mutex);
+   //Hash the session ID
+   hash = tlsCacheHash(context->sessionId, context->sessionIdLength);
+   //Select the relevant shard
+   shard = tlsCacheGetShard(context->cache, hash);
+
+   //Acquire exclusive access to the shard
+   osMutexAcquire(shard->mutex);
+
+   //Search the shard for the specified session ID
+   entry = tlsCacheLookup(context->cache, shard, hash,
+      context->sessionId, context->sessionIdLength);
 
-   //Search the cache for the specified session ID
-   for(i = 0; i < context->cache->size; i++)
+   //Drop the matching entry, if any
+   if(entry != NULL)
    {
-      //Point to the current entry
-      session = &context->cache->sessions[i];
+      tlsCacheUnchainEntry(shard, entry);
+      tlsCacheUnlinkEntry(shard, entry);
+      tlsCacheReleaseEntry(context->cache, entry);
+   }
 
-      //Check whether the current identifier matches the specified session ID
-      if(session->idLength == context->sessionIdLength &&
-         !memcmp(session->id, context->sessionId, session->idLength))
-      {
-         //Drop current entry
-         memset(session, 0, sizeof(TlsSession));
-      }
+   //Release exclusive access to the shard
+   osMutexRelease(shard->mutex);
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Retrieve session cache statistics
+ * @param[in] cache Pointer to the session cache
+ * @param[out] stats Counters accumulated over all shards
+ * @return Error code
+ **/
+
+error_t tlsGetCacheStats(TlsCache *cache, TlsCacheStats *stats)
+{
+   uint_t i;
+   TlsCacheShard *shard;
+
+   //Check parameters
+   if(cache == NULL || stats == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Clear statistics
+   memset(stats, 0, sizeof(TlsCacheStats));
+   //Maximum number of entries
+   stats->size = cache->size;
+
+   //Loop through the shards
+   for(i = 0; i < cache->numShards; i++)
+   {
+      //Point to the current shard
+      shard = &cache->shards[i];
+
+      //Acquire exclusive access to the shard
+      osMutexAcquire(shard->mutex);
+
+      //Accumulate counters
+      stats->count += shard->count;
+      stats->hits += shard->hits;
+      stats->misses += shard->misses;
+      stats->insertions += shard->insertions;
+      stats->evictions += shard->evictions;
+      stats->expirations += shard->expirations;
+
+      //Release exclusive access to the shard
+      osMutexRelease(shard->mutex);
    }
 
-   //Release exclusive access to the session cache
-   osMutexRelease(context->cache->mutex);
    //Successful processing
    return NO_ERROR;
 }
@@ -287,17 +698,30 @@ error_t tlsRemoveFromCache(TlsContext *context)
 
 void tlsFreeCache(TlsCache *cache)
 {
+   uint_t i;
    size_t n;
 
    //Invalid session cache?
    if(cache == NULL)
       return;
 
+   //Compute the number of bytes allocated for the session cache
+   n = sizeof(TlsCache) + cache->size * sizeof(TlsCacheEntry);
+
+   //All shards use the same number of hash buckets
+   n += cache->numShards * cache->shards[0].numBuckets * sizeof(TlsCacheEntry *);
+
    //Release previously allocated ressources
-   osMutexClose(cache->mutex);
+   if(cache->mutex != OS_INVALID_HANDLE)
+      osMutexClose(cache->mutex);
 
-   //Compute the number of bytes allocated for the session cache
-   n = sizeof(TlsCache) + cache->size * sizeof(TlsSession);
+   //Loop through the shards
+   for(i = 0; i < cache->numShards; i++)
+   {
+      //Release previously allocated ressources
+      if(cache->shards[i].mutex != OS_INVALID_HANDLE)
+         osMutexClose(cache->shards[i].mutex);
+   }
 
    //Clear the session cache before freeing memory
    memset(cache, 0, n);
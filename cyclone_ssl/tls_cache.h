@@ -34,9 +34,11 @@
 
 //Session cache management
 TlsCache *tlsInitCache(uint_t size);
-TlsSession *tlsFindCache(TlsCache *cache, const uint8_t *id, size_t length);
+error_t tlsFindCache(TlsCache *cache, const uint8_t *id,
+   size_t length, TlsSession *session);
 error_t tlsSaveToCache(TlsContext *context);
 error_t tlsRemoveFromCache(TlsContext *context);
+error_t tlsGetCacheStats(TlsCache *cache, TlsCacheStats *stats);
 void tlsFreeCache(TlsCache *cache);
 
 #endif
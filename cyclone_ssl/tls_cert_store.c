@@ -0,0 +1,445 @@
+/**
+ * @file tls_cert_store.c
+ * @brief Trusted CA store and certificate chain cache
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneSSL Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * The trusted CA list is decoded once, when the store is created, instead
+ * of being converted from PEM and parsed on every handshake. Trusted CA
+ * certificates are indexed by subject name, and the key identifier is
+ * used to tell apart CA certificates that share the same name. The store
+ * also remembers the certificate chains that have been successfully
+ * validated, keyed by the SHA-256 digest of the certificate list, so that
+ * the signatures of a known chain are not verified again. Such entries
+ * expire when the first certificate of the chain reaches the end of its
+ * validity period, and in any case after TLS_CHAIN_CACHE_LIFETIME
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL TLS_TRACE_LEVEL
+
+//Dependencies
+#include <string.h>
+#include "tls.h"
+#include "tls_cert_store.h"
+#include "pem.h"
+#include "debug.h"
+
+//Check SSL library configuration
+#if (TLS_SUPPORT == ENABLED && TLS_CERT_STORE_SUPPORT == ENABLED)
+
+
+/**
+ * @brief Compute the hash value of a distinguished name (FNV-1a)
+ * @param[in] name DER encoded name
+ * @param[in] length Length of the name
+ * @return Hash value
+ **/
+
+static uint32_t tlsCertStoreHash(const uint8_t *name, size_t length)
+{
+   size_t i;
+   uint32_t h;
+
+   //FNV offset basis
+   h = 2166136261UL;
+
+   //Process the name byte by byte
+   for(i = 0; i < length; i++)
+   {
+      h ^= name[i];
+      h *= 16777619UL;
+   }
+
+   //Return the resulting hash value
+   return h;
+}
+
+
+/**
+ * @brief Create a certificate store
+ * @param[in] trustedCaList List of trusted CA (PEM format)
+ * @param[in] length Total length of the list
+ * @param[in] cacheSize Maximum number of validated chains to remember
+ * @return Handle referencing the fully initialized certificate store
+ **/
+
+TlsCertStore *tlsInitCertStore(const char_t *trustedCaList,
+   size_t length, uint_t cacheSize)
+{
+   error_t error;
+   uint_t i;
+   uint8_t *derCert;
+   size_t derCertSize;
+   size_t derCertLength;
+   TlsCertStore *certStore;
+   TlsTrustedCa *ca;
+   TlsTrustedCa **last;
+
+   //Check parameters
+   if(trustedCaList == NULL && length != 0)
+      return NULL;
+
+   //Allocate a memory buffer to hold the certificate store
+   certStore = osMemAlloc(sizeof(TlsCertStore) + cacheSize * sizeof(TlsChainCacheEntry));
+   //Failed to allocate memory?
+   if(certStore == NULL) return NULL;
+
+   //Clear memory
+   memset(certStore, 0, sizeof(TlsCertStore) + cacheSize * sizeof(TlsChainCacheEntry));
+
+   //Cache entries immediately follow the store structure
+   certStore->chains = (TlsChainCacheEntry *) (certStore + 1);
+   //Save the maximum number of cache entries
+   certStore->size = cacheSize;
+
+   //Create a mutex to prevent simultaneous access to the cache
+   certStore->mutex = osMutexCreate(FALSE);
+
+   //Out of ressources?
+   if(certStore->mutex == OS_INVALID_HANDLE)
+   {
+      //Clean up side effects
+      tlsFreeCertStore(certStore);
+      //Report an error
+      return NULL;
+   }
+
+   //DER encoded certificate
+   derCert = NULL;
+   derCertSize = 0;
+   derCertLength = 0;
+
+   //Trusted CA certificates are kept in the order of the list
+   last = &certStore->caList;
+   //Clear status code
+   error = NO_ERROR;
+
+   //Loop through the list of trusted CA certificates
+   while(length > 0)
+   {
+      //Decode PEM certificate
+      error = pemReadCertificate(&trustedCaList, &length,
+         &derCert, &derCertSize, &derCertLength);
+
+      //End of the list?
+      if(error == ERROR_END_OF_FILE)
+      {
+         //The remaining characters do not hold any certificate
+         error = NO_ERROR;
+         break;
+      }
+      //Any other error to report?
+      else if(error)
+      {
+         break;
+      }
+
+      //The DER encoding immediately follows the descriptor
+      ca = osMemAlloc(sizeof(TlsTrustedCa) + derCertLength);
+
+      //Failed to allocate memory?
+      if(ca == NULL)
+      {
+         //Report an error
+         error = ERROR_OUT_OF_MEMORY;
+         break;
+      }
+
+      //Clear the descriptor
+      memset(ca, 0, sizeof(TlsTrustedCa));
+      //Copy the DER encoded certificate
+      ca->derCert = (uint8_t *) (ca + 1);
+      ca->derCertLength = derCertLength;
+      memcpy(ca->derCert, derCert, derCertLength);
+
+      //Append the certificate to the list
+      *last = ca;
+      last = &ca->next;
+      //Update the number of trusted CA certificates
+      certStore->numCa++;
+
+      //Parse X.509 certificate once and for all
+      error = x509ParseCertificate(ca->derCert, ca->derCertLength, &ca->certInfo);
+      //Failed to parse the X.509 certificate?
+      if(error) break;
+
+      //Index the certificate by subject name
+      ca->hash = tlsCertStoreHash(ca->certInfo.subject.rawData,
+         ca->certInfo.subject.rawDataLen);
+
+      //Insert the certificate in the relevant hash chain
+      i = ca->hash & (TLS_CERT_STORE_BUCKETS - 1);
+      ca->hashNext = certStore->buckets[i];
+      certStore->buckets[i] = ca;
+   }
+
+   //Free previously allocated memory
+   osMemFree(derCert);
+
+   //The trusted CA list could not be decoded?
+   if(error)
+   {
+      //Clean up side effects
+      tlsFreeCertStore(certStore);
+      //Report an error
+      return NULL;
+   }
+
+   //Debug message
+   TRACE_INFO("Certificate store holds %u trusted CA certificates\r\n", certStore->numCa);
+
+   //Return a pointer to the newly created certificate store
+   return certStore;
+}
+
+
+/**
+ * @brief Validate a certificate against the trusted CA certificates
+ * @param[in] certStore Pointer to the certificate store
+ * @param[in] certInfo Last certificate of the chain presented by the peer
+ * @param[in,out] notAfter End of the validity period of the chain, updated
+ *   with the validity period of the trusted CA certificate
+ * @return Error code
+ **/
+
+error_t tlsValidateWithCertStore(TlsCertStore *certStore,
+   const X509CertificateInfo *certInfo, uint32_t *notAfter)
+{
+   error_t error;
+   uint32_t hash;
+   TlsTrustedCa *ca;
+   const X509CertificateInfo *caInfo;
+
+   //An empty store does not restrict the accepted certificates
+   if(certStore->numCa == 0)
+      return NO_ERROR;
+
+   //The issuer of the certificate is the subject of the trusted CA
+   hash = tlsCertStoreHash(certInfo->issuer.rawData, certInfo->issuer.rawDataLen);
+
+   //Loop through the relevant hash chain
+   for(ca = certStore->buckets[hash & (TLS_CERT_STORE_BUCKETS - 1)];
+      ca != NULL; ca = ca->hashNext)
+   {
+      //Point to the trusted CA certificate
+      caInfo = &ca->certInfo;
+
+      //Check the subject name of the CA
+      if(ca->hash != hash || caInfo->subject.rawDataLen != certInfo->issuer.rawDataLen)
+         continue;
+      if(memcmp(caInfo->subject.rawData, certInfo->issuer.rawData, certInfo->issuer.rawDataLen))
+         continue;
+
+      //When both key identifiers are available, they must match
+      if(certInfo->authorityKeyId.keyIdLen > 0 && caInfo->subjectKeyId.length > 0)
+      {
+         if(certInfo->authorityKeyId.keyIdLen != caInfo->subjectKeyId.length)
+            continue;
+         if(memcmp(certInfo->authorityKeyId.keyId, caInfo->subjectKeyId.value, caInfo->subjectKeyId.length))
+            continue;
+      }
+
+      //Validate the certificate with the current trusted CA
+      error = x509ValidateCertificate(certInfo, caInfo);
+
+      //Certificate validation succeeded?
+      if(!error)
+      {
+         //The chain cannot outlive the trusted CA certificate
+         *notAfter = min(*notAfter, caInfo->validity.notAfter);
+         //The certificate is trusted
+         return NO_ERROR;
+      }
+   }
+
+   //The certificate could not be matched with a known, trusted CA
+   return ERROR_UNKNOWN_CA;
+}
+
+
+/**
+ * @brief Search the cache for a chain that has already been validated
+ * @param[in] certStore Pointer to the certificate store
+ * @param[in] digest SHA-256 digest of the certificate list
+ * @return Error code (NO_ERROR if the chain is known to be valid)
+ **/
+
+error_t tlsFindChainInCertStore(TlsCertStore *certStore, const uint8_t *digest)
+{
+   error_t error;
+   uint_t i;
+   time_t time;
+   time_t now;
+   TlsChainCacheEntry *entry;
+
+   //Get current time
+   time = osGetTickCount();
+   //Current date, if a calendar clock is available
+   now = osGetTime();
+
+   //Initialize status code
+   error = ERROR_NOT_FOUND;
+
+   //Acquire exclusive access to the cache
+   osMutexAcquire(certStore->mutex);
+
+   //Loop through the cache entries
+   for(i = 0; i < certStore->size; i++)
+   {
+      //Point to the current entry
+      entry = &certStore->chains[i];
+
+      //Skip unused entries
+      if(!entry->valid)
+         continue;
+
+      //Outdated entry?
+      if((time - entry->timestamp) >= TLS_CHAIN_CACHE_LIFETIME ||
+         (now != 0 && (uint32_t) now >= entry->notAfter))
+      {
+         //The chain must be validated again
+         entry->valid = FALSE;
+         continue;
+      }
+
+      //Matching digest?
+      if(!memcmp(entry->digest, digest, SHA256_DIGEST_SIZE))
+      {
+         //The chain is known to be valid
+         error = NO_ERROR;
+         break;
+      }
+   }
+
+   //Update statistics
+   if(!error)
+      certStore->hits++;
+   else
+      certStore->misses++;
+
+   //Release exclusive access to the cache
+   osMutexRelease(certStore->mutex);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Remember a chain that has been successfully validated
+ * @param[in] certStore Pointer to the certificate store
+ * @param[in] digest SHA-256 digest of the certificate list
+ * @param[in] notAfter End of the validity period of the chain
+ **/
+
+void tlsSaveChainToCertStore(TlsCertStore *certStore, const uint8_t *digest, uint32_t notAfter)
+{
+   uint_t i;
+   time_t time;
+   TlsChainCacheEntry *entry;
+   TlsChainCacheEntry *oldestEntry;
+
+   //The cache is disabled?
+   if(certStore->size == 0)
+      return;
+
+   //Get current time
+   time = osGetTickCount();
+
+   //Keep track of the oldest entry
+   oldestEntry = NULL;
+
+   //Acquire exclusive access to the cache
+   osMutexAcquire(certStore->mutex);
+
+   //Loop through the cache entries
+   for(i = 0; i < certStore->size; i++)
+   {
+      //Point to the current entry
+      entry = &certStore->chains[i];
+
+      //The chain is already in the cache?
+      if(entry->valid && !memcmp(entry->digest, digest, SHA256_DIGEST_SIZE))
+      {
+         //Refresh the entry
+         oldestEntry = entry;
+         break;
+      }
+
+      //Unused entries are preferred, then the oldest ones
+      if(oldestEntry == NULL || (oldestEntry->valid &&
+         (!entry->valid || timeCompare(entry->timestamp, oldestEntry->timestamp) < 0)))
+      {
+         oldestEntry = entry;
+      }
+   }
+
+   //Save the digest of the certificate list
+   memcpy(oldestEntry->digest, digest, SHA256_DIGEST_SIZE);
+   //Save the validity period of the chain
+   oldestEntry->notAfter = notAfter;
+   //Record the time at which the chain was validated
+   oldestEntry->timestamp = time;
+   //The entry is now in use
+   oldestEntry->valid = TRUE;
+
+   //Release exclusive access to the cache
+   osMutexRelease(certStore->mutex);
+}
+
+
+/**
+ * @brief Release a certificate store
+ * @param[in] certStore Pointer to the certificate store
+ **/
+
+void tlsFreeCertStore(TlsCertStore *certStore)
+{
+   TlsTrustedCa *ca;
+
+   //Invalid certificate store?
+   if(certStore == NULL)
+      return;
+
+   //Release the trusted CA certificates
+   while(certStore->caList != NULL)
+   {
+      ca = certStore->caList;
+      certStore->caList = ca->next;
+      osMemFree(ca);
+   }
+
+   //Release previously allocated ressources
+   if(certStore->mutex != OS_INVALID_HANDLE)
+      osMutexClose(certStore->mutex);
+
+   //Clear the cache before freeing memory
+   memset(certStore, 0, sizeof(TlsCertStore) + certStore->size * sizeof(TlsChainCacheEntry));
+   osMemFree(certStore);
+}
+
+#endif
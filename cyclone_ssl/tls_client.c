@@ -66,11 +66,22 @@ error_t tlsClientHandshake(TlsContext *context)
 
    //The client initiates the TLS handshake by sending
    //a ClientHello message to the server
-   context->state = TLS_STATE_CLIENT_HELLO;
+   if(context->state == TLS_STATE_INIT)
+      context->state = TLS_STATE_CLIENT_HELLO;
 
-   //Wait for the handshake to complete
+   //Clear status code
+   error = NO_ERROR;
+
+   //Wait for the handshake to complete. With a non-blocking socket, the
+   //function returns ERROR_WANT_READ or ERROR_WANT_WRITE and must be
+   //called again once the socket is ready
    while(context->state != TLS_STATE_APPLICATION_DATA)
    {
+      //Records that could not be sent at once must be flushed first
+      error = tlsSendPendingData(context);
+      //The socket cannot accept more data for the moment?
+      if(error) break;
+
       //The TLS handshake is implemented as a state machine
       //representing the current location in the protocol
       switch(context->state)
@@ -124,6 +135,7 @@ error_t tlsClientHandshake(TlsContext *context)
       case TLS_STATE_SERVER_KEY_EXCHANGE:
       case TLS_STATE_CERTIFICATE_REQUEST:
       case TLS_STATE_SERVER_HELLO_DONE:
+      case TLS_STATE_NEW_SESSION_TICKET:
       case TLS_STATE_SERVER_CHANGE_CIPHER_SPEC:
       case TLS_STATE_SERVER_FINISHED:
          //Parse incoming handshake message
@@ -153,6 +165,10 @@ error_t tlsClientHandshake(TlsContext *context)
       }
    }
 
+   //Make sure the last flight has been entirely sent
+   if(!error)
+      error = tlsSendPendingData(context);
+
    //Return status code
    return error;
 }
@@ -221,6 +237,12 @@ error_t tlsParseServerMessage(TlsContext *context)
          //end of the ServerHello and associated messages
          error = tlsParseServerHelloDone(context, message, length);
          break;
+      //NewSessionTicket message received?
+      case TLS_TYPE_NEW_SESSION_TICKET:
+         //The server sends this message to provide a new session ticket
+         //when it included the SessionTicket extension in its ServerHello
+         error = tlsParseNewSessionTicket(context, message, length);
+         break;
       //Finished message received?
       case TLS_TYPE_FINISHED:
          //A Finished message is always sent immediately after a changeCipherSpec
@@ -314,6 +336,22 @@ error_t tlsSendClientHello(TlsContext *context)
    message->clientVersion = HTONS(TLS_MAX_VERSION);
    message->random = context->clientRandom;
 
+#if (TLS_TICKET_SUPPORT == ENABLED)
+   //When presenting a ticket, the client generates a session ID. The server
+   //echoes it if it accepts the ticket, which tells the client that the
+   //session is being resumed (RFC 5077, section 3.4)
+   if(context->sessionTicketEnabled && context->ticketLength > 0)
+   {
+      //Generate a random session ID
+      error = context->prngAlgo->read(context->prngContext, context->sessionId, 32);
+      //Any error to report?
+      if(error) return error;
+
+      //Length of the session ID
+      context->sessionIdLength = 32;
+   }
+#endif
+
 #if (TLS_SESSION_RESUME_SUPPORT == ENABLED)
    //The SessionID value identifies a session the client wishes
    //to reuse for this connection
@@ -448,6 +486,37 @@ error_t tlsSendClientHello(TlsContext *context)
    }
 #endif
 
+#if (TLS_MAX_FRAG_LEN_SUPPORT == ENABLED)
+   //Clients may negotiate a smaller maximum fragment length (RFC 6066)
+   if(context->requestedMaxFragLength < TLS_MAX_RECORD_LENGTH)
+   {
+      TlsExtension *extension;
+
+      //Add the MaxFragmentLength extension
+      extension = (TlsExtension *) p;
+      //Type of the extension
+      extension->type = HTONS(TLS_EXT_MAX_FRAGMENT_LENGTH);
+
+      //Encode the maximum fragment length (2^9 = 1, 2^10 = 2, and so on)
+      for(n = TLS_MAX_FRAG_LENGTH_512; (512U << (n - 1)) < context->requestedMaxFragLength; n++);
+      //Copy the resulting value
+      extension->value[0] = (uint8_t) n;
+
+      //Fix the length of the extension
+      extension->length = HTONS(sizeof(uint8_t));
+
+      //Compute the length, in bytes, of the MaxFragmentLength extension
+      n = sizeof(TlsExtension) + sizeof(uint8_t);
+      //Fix the length of the extension list
+      extensionList->length += n;
+
+      //Point to the next field
+      p += n;
+      //Total length of the message
+      length += n;
+   }
+#endif
+
 #if (TLS_MAX_VERSION >= TLS_VERSION_1_2 && TLS_MIN_VERSION <= TLS_VERSION_1_2)
    //Include the SignatureAlgorithms extension only if TLS 1.2 is supported
    {
@@ -508,6 +577,30 @@ error_t tlsSendClientHello(TlsContext *context)
       supportedSignAlgos->value[n++].hash = TLS_HASH_ALGO_SHA256;
 #endif
 
+#if (TLS_ECDSA_SIGN_SUPPORT == ENABLED)
+      //ECDSA with SHA-1 is always supported
+      supportedSignAlgos->value[n].signature = TLS_SIGN_ALGO_ECDSA;
+      supportedSignAlgos->value[n++].hash = TLS_HASH_ALGO_SHA1;
+#if (TLS_SHA224_SUPPORT == ENABLED)
+      //ECDSA with SHA-224 support is optional
+      supportedSignAlgos->value[n].signature = TLS_SIGN_ALGO_ECDSA;
+      supportedSignAlgos->value[n++].hash = TLS_HASH_ALGO_SHA224;
+#endif
+      //ECDSA with SHA-256 is always supported
+      supportedSignAlgos->value[n].signature = TLS_SIGN_ALGO_ECDSA;
+      supportedSignAlgos->value[n++].hash = TLS_HASH_ALGO_SHA256;
+#if (TLS_SHA384_SUPPORT == ENABLED)
+      //ECDSA with SHA-384 support is optional
+      supportedSignAlgos->value[n].signature = TLS_SIGN_ALGO_ECDSA;
+      supportedSignAlgos->value[n++].hash = TLS_HASH_ALGO_SHA384;
+#endif
+#if (TLS_SHA512_SUPPORT == ENABLED)
+      //ECDSA with SHA-512 support is optional
+      supportedSignAlgos->value[n].signature = TLS_SIGN_ALGO_ECDSA;
+      supportedSignAlgos->value[n++].hash = TLS_HASH_ALGO_SHA512;
+#endif
+#endif
+
       //Compute the length, in bytes, of the list
       n *= sizeof(TlsSignHashAlgo);
       //Fix the length of the list
@@ -530,6 +623,107 @@ error_t tlsSendClientHello(TlsContext *context)
    }
 #endif
 
+#if (TLS_ECDHE_RSA_SUPPORT == ENABLED || TLS_ECDHE_ECDSA_SUPPORT == ENABLED)
+   //A client that proposes ECC cipher suites should include the
+   //EllipticCurves and EcPointFormats extensions (RFC 4492)
+   {
+      TlsExtension *extension;
+      TlsEllipticCurveList *ellipticCurveList;
+      TlsEcPointFormatList *ecPointFormatList;
+
+      //Add the EllipticCurves extension
+      extension = (TlsExtension *) p;
+      //Type of the extension
+      extension->type = HTONS(TLS_EXT_ELLIPTIC_CURVES);
+
+      //Point to the list of supported elliptic curves
+      ellipticCurveList = (TlsEllipticCurveList *) extension->value;
+
+      //Enumerate the supported curves in descending order of preference
+      n = 0;
+      ellipticCurveList->value[n++] = HTONS(TLS_EC_CURVE_ECDH_X25519);
+      ellipticCurveList->value[n++] = HTONS(TLS_EC_CURVE_SECP256R1);
+
+      //Compute the length, in bytes, of the list
+      n *= sizeof(uint16_t);
+      //Fix the length of the list
+      ellipticCurveList->length = htons(n);
+
+      //Consider the 2-byte length field that precedes the list
+      n += sizeof(TlsEllipticCurveList);
+      //Fix the length of the extension
+      extension->length = htons(n);
+
+      //Compute the length, in bytes, of the EllipticCurves extension
+      n += sizeof(TlsExtension);
+      //Fix the length of the extension list
+      extensionList->length += n;
+
+      //Point to the next field
+      p += n;
+      //Total length of the message
+      length += n;
+
+      //Add the EcPointFormats extension
+      extension = (TlsExtension *) p;
+      //Type of the extension
+      extension->type = HTONS(TLS_EXT_EC_POINT_FORMATS);
+
+      //Point to the list of supported EC point formats
+      ecPointFormatList = (TlsEcPointFormatList *) extension->value;
+
+      //Only the uncompressed point format is supported
+      ecPointFormatList->value[0] = TLS_EC_POINT_FORMAT_UNCOMPRESSED;
+      ecPointFormatList->length = 1;
+
+      //Consider the 1-byte length field that precedes the list
+      n = ecPointFormatList->length + sizeof(TlsEcPointFormatList);
+      //Fix the length of the extension
+      extension->length = htons(n);
+
+      //Compute the length, in bytes, of the EcPointFormats extension
+      n += sizeof(TlsExtension);
+      //Fix the length of the extension list
+      extensionList->length += n;
+
+      //Point to the next field
+      p += n;
+      //Total length of the message
+      length += n;
+   }
+#endif
+
+#if (TLS_TICKET_SUPPORT == ENABLED)
+   //A client that supports session tickets includes the SessionTicket
+   //extension, which holds the ticket to be used, if any (RFC 5077)
+   if(context->sessionTicketEnabled)
+   {
+      TlsExtension *extension;
+
+      //Add the SessionTicket extension
+      extension = (TlsExtension *) p;
+      //Type of the extension
+      extension->type = HTONS(TLS_EXT_SESSION_TICKET);
+
+      //An empty extension requests a new ticket
+      n = context->ticketLength;
+      //Copy the session ticket
+      memcpy(extension->value, context->ticket, n);
+      //Fix the length of the extension
+      extension->length = htons(n);
+
+      //Compute the length, in bytes, of the SessionTicket extension
+      n += sizeof(TlsExtension);
+      //Fix the length of the extension list
+      extensionList->length += n;
+
+      //Point to the next field
+      p += n;
+      //Total length of the message
+      length += n;
+   }
+#endif
+
    //Convert the length of the extension list to network byte order
    extensionList->length = htons(extensionList->length);
 
@@ -657,6 +851,31 @@ error_t tlsSendClientKeyExchange(TlsContext *context)
       }
    }
    else
+#endif
+#if (TLS_ECDHE_RSA_SUPPORT == ENABLED || TLS_ECDHE_ECDSA_SUPPORT == ENABLED)
+   //ECDH key exchange method?
+   if(context->keyExchMethod == TLS_KEY_EXCH_ECDHE_RSA ||
+      context->keyExchMethod == TLS_KEY_EXCH_ECDHE_ECDSA)
+   {
+      //Generate an ephemeral key pair on the curve selected by the server
+      error = ecdhGenerateKeyPair(&context->ecdhContext, context->prngAlgo, context->prngContext);
+      //Any error to report?
+      if(error) return error;
+
+      //Encode the client's public point to an opaque vector
+      error = tlsWriteEcPoint(context->ecdhContext.qa, context->ecdhContext.qaLen,
+         message->exchangeKeys, &length);
+      //Any error to report?
+      if(error) return error;
+
+      //Calculate the shared secret. Unlike Diffie-Hellman, leading zero
+      //bytes are preserved (RFC 4492, section 5.10)
+      error = ecdhComputeSharedSecret(&context->ecdhContext, context->premasterSecret,
+         sizeof(context->premasterSecret), &context->premasterSecretLength);
+      //Any error to report?
+      if(error) return error;
+   }
+   else
 #endif
    //Invalid key exchange method?
    {
@@ -713,7 +932,8 @@ error_t tlsSendCertificateVerify(TlsContext *context)
    {
       //Check certificate type
       if(context->cert->type == TLS_CERT_RSA_SIGN ||
-         context->cert->type == TLS_CERT_DSS_SIGN)
+         context->cert->type == TLS_CERT_DSS_SIGN ||
+         context->cert->type == TLS_CERT_ECDSA_SIGN)
       {
          //Point to the CertificateVerify message
          message = (TlsCertificateVerify *) (context->txBuffer + sizeof(TlsRecord));
@@ -792,6 +1012,36 @@ error_t tlsSendCertificateVerify(TlsContext *context)
                dsaFreePrivateKey(&dsaPrivateKey);
             }
             else
+#endif
+#if (TLS_ECDSA_SIGN_SUPPORT == ENABLED)
+            //The client's certificate contains a valid EC public key?
+            if(context->cert->type == TLS_CERT_ECDSA_SIGN)
+            {
+               EcPrivateKey ecPrivateKey;
+
+               //Digest all the handshake messages starting at ClientHello
+               error = tlsFinalizeHandshakeHash(context, SHA1_HASH_ALGO,
+                  context->handshakeSha1Context, "", context->verifyData);
+               //Any error to report?
+               if(error) return error;
+
+               //Initialize EC private key
+               ecInitPrivateKey(&ecPrivateKey);
+
+               //Decode the PEM structure that holds the EC private key
+               error = pemReadEcPrivateKey(context->cert->privateKey,
+                  context->cert->privateKeyLength, &ecPrivateKey);
+               //Any error to report?
+               if(error) return error;
+
+               //Generate an ECDSA signature using the client's private key
+               error = tlsGenerateEcdsaSignature(context->prngAlgo, context->prngContext,
+                  &ecPrivateKey, context->verifyData, SHA1_DIGEST_SIZE, signature->value, &length);
+
+               //Release previously allocated resources
+               ecFreePrivateKey(&ecPrivateKey);
+            }
+            else
 #endif
             //Invalid signature algorithm?
             {
@@ -895,6 +1145,34 @@ error_t tlsSendCertificateVerify(TlsContext *context)
                dsaFreePrivateKey(&dsaPrivateKey);
             }
             else
+#endif
+#if (TLS_ECDSA_SIGN_SUPPORT == ENABLED)
+            //The client's certificate contains a valid EC public key?
+            if(context->cert->type == TLS_CERT_ECDSA_SIGN)
+            {
+               EcPrivateKey ecPrivateKey;
+
+               //Set the relevant signature algorithm
+               signature->algorithm.signature = TLS_SIGN_ALGO_ECDSA;
+               signature->algorithm.hash = context->signHashAlgo;
+
+               //Initialize EC private key
+               ecInitPrivateKey(&ecPrivateKey);
+
+               //Decode the PEM structure that holds the EC private key
+               error = pemReadEcPrivateKey(context->cert->privateKey,
+                  context->cert->privateKeyLength, &ecPrivateKey);
+               //Any error to report?
+               if(error) return error;
+
+               //Generate an ECDSA signature using the client's private key
+               error = tlsGenerateEcdsaSignature(context->prngAlgo, context->prngContext,
+                  &ecPrivateKey, context->verifyData, hashAlgo->digestSize, signature->value, &length);
+
+               //Release previously allocated resources
+               ecFreePrivateKey(&ecPrivateKey);
+            }
+            else
 #endif
             //Invalid signature algorithm?
             {
@@ -963,6 +1241,9 @@ error_t tlsParseServerHello(TlsContext *context, const TlsServerHello *message,
    const uint8_t *p;
    TlsCipherSuite cipherSuite;
    TlsCompressionMethod compressionMethod;
+#if (TLS_TICKET_SUPPORT == ENABLED || TLS_MAX_FRAG_LEN_SUPPORT == ENABLED)
+   const TlsExtension *extension;
+#endif
 
    //Debug message
    TRACE_INFO("ServerHello message received (%u bytes)...\r\n", length);
@@ -1025,6 +1306,60 @@ error_t tlsParseServerHello(TlsContext *context, const TlsServerHello *message,
    //Compression method
    TRACE_DEBUG("  compressionMethod = 0x%02X\r\n", *compressionMethod);
 
+#if (TLS_TICKET_SUPPORT == ENABLED)
+   //Parse the SessionTicket extension
+   extension = tlsGetExtension(p, n, TLS_EXT_SESSION_TICKET);
+
+   //The SessionTicket extension was found?
+   if(extension)
+   {
+      //The server must not send the extension unless the client did
+      if(!context->sessionTicketEnabled)
+         return ERROR_ILLEGAL_PARAMETER;
+      //The extension data must be empty
+      if(ntohs(extension->length) != 0)
+         return ERROR_DECODING_FAILED;
+
+      //The server will send a NewSessionTicket message
+      context->newSessionTicket = TRUE;
+   }
+   else
+   {
+      //The server will not issue a new ticket
+      context->newSessionTicket = FALSE;
+   }
+#endif
+
+#if (TLS_MAX_FRAG_LEN_SUPPORT == ENABLED)
+   //Parse the MaxFragmentLength extension
+   extension = tlsGetExtension(p, n, TLS_EXT_MAX_FRAGMENT_LENGTH);
+
+   //The MaxFragmentLength extension was found?
+   if(extension)
+   {
+      //The server must not send the extension unless the client did
+      if(context->requestedMaxFragLength >= TLS_MAX_RECORD_LENGTH)
+         return ERROR_ILLEGAL_PARAMETER;
+      //Check the length of the extension
+      if(ntohs(extension->length) != sizeof(uint8_t))
+         return ERROR_DECODING_FAILED;
+      //Check the value of the extension
+      if(extension->value[0] < TLS_MAX_FRAG_LENGTH_512 || extension->value[0] > TLS_MAX_FRAG_LENGTH_4096)
+         return ERROR_ILLEGAL_PARAMETER;
+      //The value must be the same as the requested maximum fragment length
+      if((512U << (extension->value[0] - 1)) != context->requestedMaxFragLength)
+         return ERROR_ILLEGAL_PARAMETER;
+
+      //Records are limited to the requested length from now on
+      context->maxFragLength = context->requestedMaxFragLength;
+   }
+   else
+   {
+      //The server ignored the request
+      context->maxFragLength = TLS_MAX_RECORD_LENGTH;
+   }
+#endif
+
 #if (TLS_SESSION_RESUME_SUPPORT == ENABLED)
    //Check whether the session ID matches the value that was supplied by the client
    if(message->sessionId.length > 0 && message->sessionId.length == context->sessionIdLength &&
@@ -1050,6 +1385,11 @@ error_t tlsParseServerHello(TlsContext *context, const TlsServerHello *message,
    {
       //Perform a full handshake
       context->resume = FALSE;
+
+#if (TLS_TICKET_SUPPORT == ENABLED)
+      //The server did not accept the ticket
+      context->ticketLength = 0;
+#endif
    }
 
    //Save server random value
@@ -1091,6 +1431,13 @@ error_t tlsParseServerHello(TlsContext *context, const TlsServerHello *message,
       //Unable to generate key material?
       if(error) return error;
 
+#if (TLS_TICKET_SUPPORT == ENABLED)
+      //When renewing the ticket, the server sends a NewSessionTicket
+      //message right after the ServerHello
+      if(context->newSessionTicket)
+         context->state = TLS_STATE_NEW_SESSION_TICKET;
+      else
+#endif
       //At this point, both client and server must send ChangeCipherSpec
       //messages and proceed directly to Finished messages
       context->state = TLS_STATE_SERVER_CHANGE_CIPHER_SPEC;
@@ -1126,7 +1473,7 @@ error_t tlsParseServerHello(TlsContext *context, const TlsServerHello *message,
 error_t tlsParseServerKeyExchange(TlsContext *context, const TlsServerKeyExchange *message, size_t length)
 {
    error_t error;
-   uint_t n;
+   size_t n;
    const uint8_t *p;
 
    //Debug message
@@ -1144,17 +1491,17 @@ error_t tlsParseServerKeyExchange(TlsContext *context, const TlsServerKeyExchang
    //Update the hash value with the incoming handshake message
    tlsUpdateHandshakeHash(context, message, length);
 
+   //Point to the server's key exchange parameters
+   p = message->params;
+   //Remaining bytes to process
+   length -= sizeof(TlsServerKeyExchange);
+
 #if (TLS_DHE_RSA_SUPPORT == ENABLED || TLS_DHE_DSS_SUPPORT == ENABLED || TLS_DH_ANON_SUPPORT == ENABLED)
    //Diffie-Hellman key exchange method?
    if(context->keyExchMethod == TLS_KEY_EXCH_DHE_RSA ||
       context->keyExchMethod == TLS_KEY_EXCH_DHE_DSS ||
       context->keyExchMethod == TLS_KEY_EXCH_DH_ANON)
    {
-      //Point to the server's key exchange parameters
-      p = message->params;
-      //Remaining bytes to process
-      length -= sizeof(TlsServerKeyExchange);
-
       //Convert the prime modulus to a multiple precision integer
       error = tlsReadMpi(&context->dhParameters.p, p, length, &n);
       //Any error to report?
@@ -1190,9 +1537,6 @@ error_t tlsParseServerKeyExchange(TlsContext *context, const TlsServerKeyExchang
       //Weak public value?
       if(error) return error;
 
-      //Save the length of the server's Diffie-Hellman parameters
-      n = p - message->params;
-
       //Debug message
       TRACE_DEBUG("Diffie-Hellman parameters:\r\n");
       TRACE_DEBUG("  Prime modulus:\r\n");
@@ -1201,181 +1545,280 @@ error_t tlsParseServerKeyExchange(TlsContext *context, const TlsServerKeyExchang
       TRACE_DEBUG_MPI("    ", &context->dhParameters.g);
       TRACE_DEBUG("  Server public value:\r\n");
       TRACE_DEBUG_MPI("    ", &context->dhParameters.yb);
+   }
+   else
+#endif
+#if (TLS_ECDHE_RSA_SUPPORT == ENABLED || TLS_ECDHE_ECDSA_SUPPORT == ENABLED)
+   //ECDH key exchange method?
+   if(context->keyExchMethod == TLS_KEY_EXCH_ECDHE_RSA ||
+      context->keyExchMethod == TLS_KEY_EXCH_ECDHE_ECDSA)
+   {
+      //The ECParameters structure is made of a curve type and a named curve
+      if(length < 3)
+         return ERROR_DECODING_FAILED;
+
+      //Only named curves are supported
+      if(p[0] != TLS_EC_CURVE_TYPE_NAMED_CURVE)
+         return ERROR_ILLEGAL_PARAMETER;
+
+      //Retrieve the elliptic curve selected by the server
+      context->namedCurve = LOAD16BE(p + 1);
+      context->ecdhContext.curve = tlsGetCurveInfo(context->namedCurve);
+
+      //The server must select one of the curves offered by the client
+      if(context->ecdhContext.curve == NULL)
+         return ERROR_ILLEGAL_PARAMETER;
+
+      //Advance data pointer
+      p += 3;
+      //Remaining bytes to process
+      length -= 3;
+
+      //Read the server's ephemeral public point
+      error = tlsReadEcPoint(context->ecdhContext.qb, sizeof(context->ecdhContext.qb),
+         &context->ecdhContext.qbLen, p, length, &n);
+      //Any error to report?
+      if(error) return error;
+
+      //Advance data pointer
+      p += n;
+      //Remaining bytes to process
+      length -= n;
+
+      //Verify peer's public point
+      error = ecdhCheckPublicKey(context->ecdhContext.curve,
+         context->ecdhContext.qb, context->ecdhContext.qbLen);
+      //Invalid public point?
+      if(error) return error;
+
+      //Debug message
+      TRACE_DEBUG("ECDH parameters:\r\n");
+      TRACE_DEBUG("  Named curve: %s\r\n", context->ecdhContext.curve->name);
+      TRACE_DEBUG("  Server public point:\r\n");
+      TRACE_DEBUG_ARRAY("    ", context->ecdhContext.qb, context->ecdhContext.qbLen);
+   }
+   else
+#endif
+   //Invalid key exchange method?
+   {
+      //It is not legal to send the ServerKeyExchange message when a key
+      //exchange method other than DHE_DSS, DHE_RSA, DH_anon, ECDHE_RSA
+      //and ECDHE_ECDSA is selected
+      return ERROR_UNEXPECTED_MESSAGE;
+   }
+
+   //Save the length of the server's key exchange parameters
+   n = p - message->params;
+
+   //For non-anonymous key exchanges, the signature over the server's
+   //key exchange parameters shall be verified
+   if(context->keyExchMethod != TLS_KEY_EXCH_DH_ANON)
+   {
+      //Check the digitally-signed element that follows the parameters
+      error = tlsVerifyServerKeySignature(context, p, length, message->params, n);
+   }
+
+   //Prepare to decode a CertificateRequest or a ServerHelloDone message
+   context->state = TLS_STATE_CERTIFICATE_REQUEST;
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Verify the signature over the server's key exchange parameters
+ * @param[in] context Pointer to the TLS context
+ * @param[in] data Pointer to the digitally-signed element
+ * @param[in] length Number of bytes available in the input buffer
+ * @param[in] params Pointer to the server's key exchange parameters
+ * @param[in] paramsLength Length of the server's key exchange parameters
+ * @return Error code
+ **/
+
+error_t tlsVerifyServerKeySignature(TlsContext *context, const uint8_t *data,
+   size_t length, const uint8_t *params, size_t paramsLength)
+{
+   error_t error;
 
-#if (TLS_DHE_RSA_SUPPORT == ENABLED || TLS_DHE_DSS_SUPPORT == ENABLED)
-      //For non-anonymous Diffie-Hellman key exchanges, the signature
-      //over the server's key exchange parameters shall be verified
-      if(context->keyExchMethod == TLS_KEY_EXCH_DHE_RSA ||
-         context->keyExchMethod == TLS_KEY_EXCH_DHE_DSS)
-      {
 #if (TLS_MAX_VERSION >= SSL_VERSION_3_0 && TLS_MIN_VERSION <= TLS_VERSION_1_1)
-         //SSL 3.0, TLS 1.0 or TLS 1.1 currently selected?
-         if(context->version <= TLS_VERSION_1_1)
-         {
-            //Point to the digitally-signed element
-            TlsDigitalSignature *signature = (TlsDigitalSignature *) p;
+   //SSL 3.0, TLS 1.0 or TLS 1.1 currently selected?
+   if(context->version <= TLS_VERSION_1_1)
+   {
+      //Point to the digitally-signed element
+      TlsDigitalSignature *signature = (TlsDigitalSignature *) data;
 
-            //Check the length of the digitally-signed element
-            if(length < sizeof(TlsDigitalSignature))
-               return ERROR_DECODING_FAILED;
-            if(length < (sizeof(TlsDigitalSignature) + ntohs(signature->length)))
-               return ERROR_DECODING_FAILED;
+      //Check the length of the digitally-signed element
+      if(length < sizeof(TlsDigitalSignature))
+         return ERROR_DECODING_FAILED;
+      if(length < (sizeof(TlsDigitalSignature) + ntohs(signature->length)))
+         return ERROR_DECODING_FAILED;
 
-#if (TLS_DHE_RSA_SUPPORT == ENABLED)
-            //Check whether DHE_RSA key exchange method is currently used
-            if(context->keyExchMethod == TLS_KEY_EXCH_DHE_RSA)
-            {
-               Md5Context *md5Context;
-               Sha1Context *sha1Context;
-
-               //Allocate a memory buffer to hold the MD5 context
-               md5Context = osMemAlloc(sizeof(Md5Context));
-               //Failed to allocate memory?
-               if(!md5Context) return ERROR_OUT_OF_MEMORY;
-
-               //Compute MD5(ClientHello.random + ServerHello.random + ServerDhParams)
-               md5Init(md5Context);
-               md5Update(md5Context, context->random, 64);
-               md5Update(md5Context, message->params, n);
-               md5Final(md5Context, context->verifyData);
-               //Release previously allocated memory
-               osMemFree(md5Context);
-
-               //Allocate a memory buffer to hold the SHA-1 context
-               sha1Context = osMemAlloc(sizeof(Sha1Context));
-               //Failed to allocate memory?
-               if(!sha1Context) return ERROR_OUT_OF_MEMORY;
-
-               //Compute SHA(ClientHello.random + ServerHello.random + ServerDhParams)
-               sha1Init(sha1Context);
-               sha1Update(sha1Context, context->random, 64);
-               sha1Update(sha1Context, message->params, n);
-               sha1Final(sha1Context, context->verifyData + MD5_DIGEST_SIZE);
-               //Release previously allocated memory
-               osMemFree(sha1Context);
-
-               //RSA signature verification
-               error = tlsVerifyRsaSignature(&context->peerRsaPublicKey,
-                  context->verifyData, signature->value, ntohs(signature->length));
-            }
-            else
+#if (TLS_DHE_RSA_SUPPORT == ENABLED || TLS_ECDHE_RSA_SUPPORT == ENABLED)
+      //Check whether DHE_RSA or ECDHE_RSA key exchange method is currently used
+      if(context->keyExchMethod == TLS_KEY_EXCH_DHE_RSA ||
+         context->keyExchMethod == TLS_KEY_EXCH_ECDHE_RSA)
+      {
+         Md5Context *md5Context;
+         Sha1Context *sha1Context;
+
+         //Allocate a memory buffer to hold the MD5 context
+         md5Context = osMemAlloc(sizeof(Md5Context));
+         //Failed to allocate memory?
+         if(!md5Context) return ERROR_OUT_OF_MEMORY;
+
+         //Compute MD5(ClientHello.random + ServerHello.random + ServerParams)
+         md5Init(md5Context);
+         md5Update(md5Context, context->random, 64);
+         md5Update(md5Context, params, paramsLength);
+         md5Final(md5Context, context->verifyData);
+         //Release previously allocated memory
+         osMemFree(md5Context);
+
+         //Allocate a memory buffer to hold the SHA-1 context
+         sha1Context = osMemAlloc(sizeof(Sha1Context));
+         //Failed to allocate memory?
+         if(!sha1Context) return ERROR_OUT_OF_MEMORY;
+
+         //Compute SHA(ClientHello.random + ServerHello.random + ServerParams)
+         sha1Init(sha1Context);
+         sha1Update(sha1Context, context->random, 64);
+         sha1Update(sha1Context, params, paramsLength);
+         sha1Final(sha1Context, context->verifyData + MD5_DIGEST_SIZE);
+         //Release previously allocated memory
+         osMemFree(sha1Context);
+
+         //RSA signature verification
+         error = tlsVerifyRsaSignature(&context->peerRsaPublicKey,
+            context->verifyData, signature->value, ntohs(signature->length));
+      }
+      else
 #endif
+#if (TLS_DHE_DSS_SUPPORT == ENABLED || TLS_ECDHE_ECDSA_SUPPORT == ENABLED)
+      //Check whether DHE_DSS or ECDHE_ECDSA key exchange method is currently used
+      if(context->keyExchMethod == TLS_KEY_EXCH_DHE_DSS ||
+         context->keyExchMethod == TLS_KEY_EXCH_ECDHE_ECDSA)
+      {
+         //Allocate a memory buffer to hold the SHA-1 context
+         Sha1Context *sha1Context = osMemAlloc(sizeof(Sha1Context));
+         //Failed to allocate memory?
+         if(!sha1Context) return ERROR_OUT_OF_MEMORY;
+
+         //Compute SHA(ClientHello.random + ServerHello.random + ServerParams)
+         sha1Init(sha1Context);
+         sha1Update(sha1Context, context->random, 64);
+         sha1Update(sha1Context, params, paramsLength);
+         sha1Final(sha1Context, NULL);
+
 #if (TLS_DHE_DSS_SUPPORT == ENABLED)
-            //Check whether DHE_DSS key exchange method is currently used
-            if(context->keyExchMethod == TLS_KEY_EXCH_DHE_DSS)
-            {
-               //Allocate a memory buffer to hold the SHA-1 context
-               Sha1Context *sha1Context = osMemAlloc(sizeof(Sha1Context));
-               //Failed to allocate memory?
-               if(!sha1Context) return ERROR_OUT_OF_MEMORY;
-
-               //Compute SHA(ClientHello.random + ServerHello.random + ServerDhParams)
-               sha1Init(sha1Context);
-               sha1Update(sha1Context, context->random, 64);
-               sha1Update(sha1Context, message->params, n);
-               sha1Final(sha1Context, NULL);
-
-               //DSA signature verification
-               error = tlsVerifyDsaSignature(&context->peerDsaPublicKey, sha1Context->digest,
-                  SHA1_DIGEST_SIZE, signature->value, ntohs(signature->length));
-
-               //Release previously allocated memory
-               osMemFree(sha1Context);
-            }
-            else
-#endif
-            //Invalid signature algorithm?
-            {
-               //Report an error
-               error = ERROR_UNSUPPORTED_SIGNATURE_ALGO;
-            }
+         //DSA signature verification
+         if(context->keyExchMethod == TLS_KEY_EXCH_DHE_DSS)
+         {
+            error = tlsVerifyDsaSignature(&context->peerDsaPublicKey, sha1Context->digest,
+               SHA1_DIGEST_SIZE, signature->value, ntohs(signature->length));
          }
          else
 #endif
-#if (TLS_MAX_VERSION >= TLS_VERSION_1_2 && TLS_MIN_VERSION <= TLS_VERSION_1_2)
-         //TLS 1.2 currently selected?
-         if(context->version == TLS_VERSION_1_2)
+         //ECDSA signature verification
          {
-            const HashAlgo *hashAlgo;
-            HashContext *hashContext;
+            error = tlsVerifyEcdsaSignature(&context->peerEcPublicKey, sha1Context->digest,
+               SHA1_DIGEST_SIZE, signature->value, ntohs(signature->length));
+         }
 
-            //Point to the digitally-signed element
-            TlsDigitalSignature2 *signature = (TlsDigitalSignature2 *) p;
-
-            //Check the length of the digitally-signed element
-            if(length < sizeof(TlsDigitalSignature2))
-               return ERROR_DECODING_FAILED;
-            if(length < (sizeof(TlsDigitalSignature2) + ntohs(signature->length)))
-               return ERROR_DECODING_FAILED;
-
-            //Retrieve the hash algorithm used for signing
-            hashAlgo = tlsGetHashAlgo(signature->algorithm.hash);
-            //Hash algorithm not supported?
-            if(!hashAlgo) return ERROR_INVALID_SIGNATURE;
-
-            //Allocate a memory buffer to hold the hash context
-            hashContext = osMemAlloc(hashAlgo->contextSize);
-            //Failed to allocate memory?
-            if(!hashContext) return ERROR_OUT_OF_MEMORY;
-
-            //Compute SHA(ClientHello.random + ServerHello.random + ServerDhParams)
-            hashAlgo->init(hashContext);
-            hashAlgo->update(hashContext, context->random, 64);
-            hashAlgo->update(hashContext, message->params, n);
-            hashAlgo->final(hashContext, NULL);
-
-#if (TLS_DHE_RSA_SUPPORT == ENABLED)
-            //Check whether DHE_RSA key exchange method is currently used
-            if(context->keyExchMethod == TLS_KEY_EXCH_DHE_RSA &&
-               signature->algorithm.signature == TLS_SIGN_ALGO_RSA)
-            {
-               //Use the signature verification algorithm defined in PKCS #1 v1.5
-               error = rsassaPkcs1v15Verify(&context->peerRsaPublicKey, hashAlgo,
-                  hashContext->digest, signature->value, ntohs(signature->length));
-            }
-            else
+         //Release previously allocated memory
+         osMemFree(sha1Context);
+      }
+      else
 #endif
-#if (TLS_DHE_DSS_SUPPORT == ENABLED)
-            //Check whether DHE_DSS key exchange method is currently used
-            if(context->keyExchMethod == TLS_KEY_EXCH_DHE_DSS &&
-               signature->algorithm.signature == TLS_SIGN_ALGO_DSA)
-            {
-               //DSA signature verification
-               error = tlsVerifyDsaSignature(&context->peerDsaPublicKey, hashContext->digest,
-                  hashAlgo->digestSize, signature->value, ntohs(signature->length));
-            }
-            else
+      //Invalid signature algorithm?
+      {
+         //Report an error
+         error = ERROR_UNSUPPORTED_SIGNATURE_ALGO;
+      }
+   }
+   else
 #endif
-            //Invalid signature algorithm?
-            {
-               //Report an error
-               error = ERROR_UNSUPPORTED_SIGNATURE_ALGO;
-            }
+#if (TLS_MAX_VERSION >= TLS_VERSION_1_2 && TLS_MIN_VERSION <= TLS_VERSION_1_2)
+   //TLS 1.2 currently selected?
+   if(context->version == TLS_VERSION_1_2)
+   {
+      const HashAlgo *hashAlgo;
+      HashContext *hashContext;
 
-            //Release previously allocated memory
-            osMemFree(hashContext);
+      //Point to the digitally-signed element
+      TlsDigitalSignature2 *signature = (TlsDigitalSignature2 *) data;
 
-         }
-         else
+      //Check the length of the digitally-signed element
+      if(length < sizeof(TlsDigitalSignature2))
+         return ERROR_DECODING_FAILED;
+      if(length < (sizeof(TlsDigitalSignature2) + ntohs(signature->length)))
+         return ERROR_DECODING_FAILED;
+
+      //Retrieve the hash algorithm used for signing
+      hashAlgo = tlsGetHashAlgo(signature->algorithm.hash);
+      //Hash algorithm not supported?
+      if(!hashAlgo) return ERROR_INVALID_SIGNATURE;
+
+      //Allocate a memory buffer to hold the hash context
+      hashContext = osMemAlloc(hashAlgo->contextSize);
+      //Failed to allocate memory?
+      if(!hashContext) return ERROR_OUT_OF_MEMORY;
+
+      //Compute H(ClientHello.random + ServerHello.random + ServerParams)
+      hashAlgo->init(hashContext);
+      hashAlgo->update(hashContext, context->random, 64);
+      hashAlgo->update(hashContext, params, paramsLength);
+      hashAlgo->final(hashContext, NULL);
+
+#if (TLS_DHE_RSA_SUPPORT == ENABLED || TLS_ECDHE_RSA_SUPPORT == ENABLED)
+      //Check whether DHE_RSA or ECDHE_RSA key exchange method is currently used
+      if((context->keyExchMethod == TLS_KEY_EXCH_DHE_RSA ||
+         context->keyExchMethod == TLS_KEY_EXCH_ECDHE_RSA) &&
+         signature->algorithm.signature == TLS_SIGN_ALGO_RSA)
+      {
+         //Use the signature verification algorithm defined in PKCS #1 v1.5
+         error = rsassaPkcs1v15Verify(&context->peerRsaPublicKey, hashAlgo,
+            hashContext->digest, signature->value, ntohs(signature->length));
+      }
+      else
 #endif
-         {
-            //The negotiated TLS version is not valid
-            error = ERROR_INVALID_VERSION;
-         }
+#if (TLS_DHE_DSS_SUPPORT == ENABLED)
+      //Check whether DHE_DSS key exchange method is currently used
+      if(context->keyExchMethod == TLS_KEY_EXCH_DHE_DSS &&
+         signature->algorithm.signature == TLS_SIGN_ALGO_DSA)
+      {
+         //DSA signature verification
+         error = tlsVerifyDsaSignature(&context->peerDsaPublicKey, hashContext->digest,
+            hashAlgo->digestSize, signature->value, ntohs(signature->length));
       }
+      else
+#endif
+#if (TLS_ECDHE_ECDSA_SUPPORT == ENABLED)
+      //Check whether ECDHE_ECDSA key exchange method is currently used
+      if(context->keyExchMethod == TLS_KEY_EXCH_ECDHE_ECDSA &&
+         signature->algorithm.signature == TLS_SIGN_ALGO_ECDSA)
+      {
+         //ECDSA signature verification
+         error = tlsVerifyEcdsaSignature(&context->peerEcPublicKey, hashContext->digest,
+            hashAlgo->digestSize, signature->value, ntohs(signature->length));
+      }
+      else
 #endif
+      //Invalid signature algorithm?
+      {
+         //Report an error
+         error = ERROR_UNSUPPORTED_SIGNATURE_ALGO;
+      }
+
+      //Release previously allocated memory
+      osMemFree(hashContext);
    }
    else
 #endif
-   //Invalid key exchange method?
    {
-      //It is not legal to send the ServerKeyExchange message when a key
-      //exchange method other than DHE_DSS, DHE_RSA and DH_anon is selected
-      error = ERROR_UNEXPECTED_MESSAGE;
+      //The negotiated TLS version is not valid
+      error = ERROR_INVALID_VERSION;
    }
 
-   //Prepare to decode a CertificateRequest or a ServerHelloDone message
-   context->state = TLS_STATE_CERTIFICATE_REQUEST;
    //Return status code
    return error;
 }
@@ -1561,6 +2004,21 @@ error_t tlsParseServerHelloDone(TlsContext *context, const TlsServerHelloDone *m
       return ERROR_UNEXPECTED_MESSAGE;
    }
 
+#if (TLS_MAX_VERSION >= TLS_VERSION_1_2 && TLS_MIN_VERSION <= TLS_VERSION_1_2)
+   //TLS 1.2 currently selected?
+   if(context->version == TLS_VERSION_1_2)
+   {
+      //The SHA-1 transcript is only needed when the CertificateVerify
+      //message is to be signed using SHA-1
+      if(context->cert == NULL || context->signHashAlgo != TLS_HASH_ALGO_SHA1)
+      {
+         //Release SHA-1 context
+         osMemFree(context->handshakeSha1Context);
+         context->handshakeSha1Context = NULL;
+      }
+   }
+#endif
+
    //Update the hash value with the incoming handshake message
    tlsUpdateHandshakeHash(context, message, length);
 
@@ -1570,4 +2028,72 @@ error_t tlsParseServerHelloDone(TlsContext *context, const TlsServerHelloDone *m
    return NO_ERROR;
 }
 
+
+/**
+ * @brief Parse NewSessionTicket message
+ *
+ * This message is sent by the server during the handshake, before the
+ * ChangeCipherSpec message, when it included the SessionTicket extension
+ * in the ServerHello message
+ *
+ * @param[in] context Pointer to the TLS context
+ * @param[in] message Incoming NewSessionTicket message to parse
+ * @param[in] length Message length
+ * @return Error code
+ **/
+
+error_t tlsParseNewSessionTicket(TlsContext *context, const TlsNewSessionTicket *message, size_t length)
+{
+#if (TLS_TICKET_SUPPORT == ENABLED)
+   size_t n;
+
+   //Debug message
+   TRACE_INFO("NewSessionTicket message received (%u bytes)...\r\n", length);
+   TRACE_DEBUG_ARRAY("  ", message, length);
+
+   //Check the length of the NewSessionTicket message
+   if(length < sizeof(TlsNewSessionTicket))
+      return ERROR_DECODING_FAILED;
+
+   //Check current state
+   if(context->state != TLS_STATE_NEW_SESSION_TICKET)
+      return ERROR_UNEXPECTED_MESSAGE;
+
+   //Retrieve the length of the ticket
+   n = ntohs(message->ticketLength);
+
+   //Malformed message?
+   if(length != (sizeof(TlsNewSessionTicket) + n))
+      return ERROR_DECODING_FAILED;
+
+   //Tickets that do not fit in the buffer are silently dropped. An empty
+   //ticket means that the server does not want to issue a ticket
+   if(n <= TLS_MAX_TICKET_SIZE)
+   {
+      //Save the session ticket
+      memcpy(context->ticket, message->ticket, n);
+      context->ticketLength = n;
+   }
+   else
+   {
+      //The session cannot be resumed using a ticket
+      context->ticketLength = 0;
+   }
+
+   //The lifetime hint is expressed in seconds
+   context->ticketLifetimeHint = ntohl(message->ticketLifetimeHint);
+
+   //Update the hash value with the incoming handshake message
+   tlsUpdateHandshakeHash(context, message, length);
+
+   //Prepare to receive a ChangeCipherSpec message...
+   context->state = TLS_STATE_SERVER_CHANGE_CIPHER_SPEC;
+   //Successful processing
+   return NO_ERROR;
+#else
+   //Session tickets are not supported
+   return ERROR_UNEXPECTED_MESSAGE;
+#endif
+}
+
 #endif
@@ -42,7 +42,12 @@ error_t tlsSendCertificateVerify(TlsContext *context);
 
 error_t tlsParseServerHello(TlsContext *context, const TlsServerHello *message, size_t length);
 error_t tlsParseServerKeyExchange(TlsContext *context, const TlsServerKeyExchange *message, size_t length);
+
+error_t tlsVerifyServerKeySignature(TlsContext *context, const uint8_t *data,
+   size_t length, const uint8_t *params, size_t paramsLength);
+
 error_t tlsParseCertificateRequest(TlsContext *context, const TlsCertificateRequest *message, size_t length);
 error_t tlsParseServerHelloDone(TlsContext *context, const TlsServerHelloDone *message, size_t length);
+error_t tlsParseNewSessionTicket(TlsContext *context, const TlsNewSessionTicket *message, size_t length);
 
 #endif
@@ -36,7 +36,9 @@
 #include "tls_cipher_suites.h"
 #include "tls_common.h"
 #include "tls_record.h"
+#include "tls_buffer.h"
 #include "tls_cache.h"
+#include "tls_cert_store.h"
 #include "tls_misc.h"
 #include "asn1.h"
 #include "x509.h"
@@ -236,6 +238,39 @@ error_t tlsSendChangeCipherSpec(TlsContext *context)
    //Initialization failed?
    if(error) return error;
 
+#if (TLS_GCM_CIPHER_SUPPORT == ENABLED)
+   //GCM cipher mode?
+   if(context->cipherMode == CIPHER_MODE_GCM)
+   {
+      //Allocate a memory buffer to hold the GCM context
+      context->writeGcmContext = osMemAlloc(sizeof(GcmContext));
+      //Failed to allocate memory?
+      if(!context->writeGcmContext) return ERROR_OUT_OF_MEMORY;
+
+      //The hash subkey is computed once for the lifetime of the key
+      error = gcmInit(context->writeGcmContext, context->cipherAlgo,
+         context->writeCipherContext);
+      //Initialization failed?
+      if(error) return error;
+   }
+#endif
+
+#if (TLS_MAX_VERSION >= TLS_VERSION_1_0 && TLS_MIN_VERSION <= TLS_VERSION_1_2)
+   //TLS uses a HMAC construction?
+   if(context->hashAlgo != NULL && context->version >= TLS_VERSION_1_0)
+   {
+      //Allocate a memory buffer to hold the HMAC context
+      context->writeHmacContext = osMemAlloc(sizeof(HmacContext));
+      //Failed to allocate memory?
+      if(!context->writeHmacContext) return ERROR_OUT_OF_MEMORY;
+
+      //The inner and outer padded keys are digested once for the
+      //lifetime of the write MAC key
+      hmacInit(context->writeHmacContext, context->hashAlgo,
+         context->writeMacKey, context->macKeyLength);
+   }
+#endif
+
    //Inform the record layer that subsequent records will be protected
    //under the newly negotiated encryption algorithm
    context->changeCipherSpecSent = TRUE;
@@ -301,6 +336,11 @@ error_t tlsSendFinished(TlsContext *context)
       //Use abbreviated or full handshake?
       if(context->resume)
          context->state = TLS_STATE_APPLICATION_DATA;
+#if (TLS_TICKET_SUPPORT == ENABLED)
+      //The server announced a NewSessionTicket message?
+      else if(context->newSessionTicket)
+         context->state = TLS_STATE_NEW_SESSION_TICKET;
+#endif
       else
          context->state = TLS_STATE_SERVER_CHANGE_CIPHER_SPEC;
    }
@@ -332,22 +372,34 @@ error_t tlsSendAlert(TlsContext *context, uint8_t level, uint8_t description)
    size_t length;
    TlsAlert *message;
 
-   //Point to the Alert message
-   message = (TlsAlert *) (context->txBuffer + sizeof(TlsRecord));
-   //Severity of the message
-   message->level = level;
-   //Description of the alert
-   message->description = description;
+   //Make sure a send buffer is available
+   error = tlsAllocTxBuffer(context);
+   //Any error to report?
+   if(error) return error;
 
-   //The message of the Alert message
-   length = sizeof(TlsAlert);
+   //Records that could not be sent at once must be flushed first
+   error = tlsSendPendingData(context);
 
-   //Debug message
-   TRACE_INFO("Sending Alert message (%u bytes)...\r\n", length);
-   TRACE_INFO_ARRAY("  ", message, length);
+   //The TX buffer is available?
+   if(!error)
+   {
+      //Point to the Alert message
+      message = (TlsAlert *) (context->txBuffer + sizeof(TlsRecord));
+      //Severity of the message
+      message->level = level;
+      //Description of the alert
+      message->description = description;
 
-   //Send Alert message
-   error = tlsWriteProtocolData(context, length, TLS_TYPE_ALERT);
+      //The message of the Alert message
+      length = sizeof(TlsAlert);
+
+      //Debug message
+      TRACE_INFO("Sending Alert message (%u bytes)...\r\n", length);
+      TRACE_INFO_ARRAY("  ", message, length);
+
+      //Send Alert message
+      error = tlsWriteProtocolData(context, length, TLS_TYPE_ALERT);
+   }
 
    //Alert messages with a level of fatal result in the immediate
    //termination of the connection
@@ -365,6 +417,9 @@ error_t tlsSendAlert(TlsContext *context, uint8_t level, uint8_t description)
       context->state = TLS_STATE_FATAL_ERROR;
    }
 
+   //Release the send buffer if the connection is idle
+   tlsReleaseIdleBuffers(context);
+
    //Return status code
    return error;
 }
@@ -388,6 +443,10 @@ error_t tlsParseCertificate(TlsContext *context, const TlsCertificate *message,
    uint8_t *derCert;
    size_t derCertSize;
    size_t derCertLength;
+#if (TLS_CERT_STORE_SUPPORT == ENABLED)
+   uint32_t notAfter;
+   uint8_t digest[SHA256_DIGEST_SIZE];
+#endif
 
    //X.509 certificates
    X509CertificateInfo *certInfo = NULL;
@@ -575,6 +634,17 @@ error_t tlsParseCertificate(TlsContext *context, const TlsCertificate *message,
          //Save the certificate type
          context->peerCertType = TLS_CERT_DSS_SIGN;
       }
+      //The certificate contains a valid EC public key?
+      else if(certInfo->subjectPublicKey.namedCurve && certInfo->subjectPublicKey.ecPoint)
+      {
+         //Retrieve the EC public key
+         error = x509ReadEcPublicKey(certInfo, &context->peerEcPublicKey);
+         //Any error to report
+         if(error) break;
+
+         //Save the certificate type
+         context->peerCertType = TLS_CERT_ECDSA_SIGN;
+      }
       //The certificate does not contain any valid public key?
       else
       {
@@ -587,6 +657,30 @@ error_t tlsParseCertificate(TlsContext *context, const TlsCertificate *message,
       p += n;
       length -= n;
 
+#if (TLS_CERT_STORE_SUPPORT == ENABLED)
+      //Certificate store available?
+      if(context->certStore != NULL)
+      {
+         //The chain cannot outlive any of its certificates
+         notAfter = certInfo->validity.notAfter;
+
+         //Digest the whole certificate list
+         error = sha256Compute(message->certificateList,
+            LOAD24BE(message->certificateListLength), digest);
+         //Any error to report?
+         if(error) break;
+
+         //The very same chain has already been validated?
+         if(!tlsFindChainInCertStore(context->certStore, digest))
+         {
+            //Debug message
+            TRACE_INFO("Certificate chain found in cache\r\n");
+            //The signatures do not need to be verified again
+            break;
+         }
+      }
+#endif
+
       //PKIX path validation
       while(length > 0)
       {
@@ -627,6 +721,11 @@ error_t tlsParseCertificate(TlsContext *context, const TlsCertificate *message,
          //Certificate validation failed?
          if(error) break;
 
+#if (TLS_CERT_STORE_SUPPORT == ENABLED)
+         //Keep track of the end of the validity period of the chain
+         notAfter = min(notAfter, issuerCertInfo->validity.notAfter);
+#endif
+
          //Keep track of the issuer certificate
          memcpy(certInfo, issuerCertInfo, sizeof(X509CertificateInfo));
 
@@ -638,6 +737,22 @@ error_t tlsParseCertificate(TlsContext *context, const TlsCertificate *message,
       //Propagate exception if necessary...
       if(error) break;
 
+#if (TLS_CERT_STORE_SUPPORT == ENABLED)
+      //Certificate store available?
+      if(context->certStore != NULL)
+      {
+         //Look for the trusted CA that issued the last certificate of the chain
+         error = tlsValidateWithCertStore(context->certStore, certInfo, &notAfter);
+         //Certificate validation failed?
+         if(error) break;
+
+         //Remember the chain, so that it is not validated again
+         tlsSaveChainToCertStore(context->certStore, digest, notAfter);
+         //The trusted CA list is not used
+         break;
+      }
+#endif
+
       //Point to the first trusted CA certificate
       pemCert = context->trustedCaList;
       //Get the total length, in bytes, of the trusted CA list
@@ -688,6 +803,8 @@ error_t tlsParseCertificate(TlsContext *context, const TlsCertificate *message,
       //Release multiple precision integers
       rsaFreePublicKey(&context->peerRsaPublicKey);
       dsaFreePublicKey(&context->peerDsaPublicKey);
+      //Release EC public key
+      ecFreePublicKey(&context->peerEcPublicKey);
    }
 
    //TLS operates as a client or a server?
@@ -755,6 +872,39 @@ error_t tlsParseChangeCipherSpec(TlsContext *context, const TlsChangeCipherSpec
    //Any error to report?
    if(error) return error;
 
+#if (TLS_GCM_CIPHER_SUPPORT == ENABLED)
+   //GCM cipher mode?
+   if(context->cipherMode == CIPHER_MODE_GCM)
+   {
+      //Allocate a memory buffer to hold the GCM context
+      context->readGcmContext = osMemAlloc(sizeof(GcmContext));
+      //Failed to allocate memory?
+      if(!context->readGcmContext) return ERROR_OUT_OF_MEMORY;
+
+      //The hash subkey is computed once for the lifetime of the key
+      error = gcmInit(context->readGcmContext, context->cipherAlgo,
+         context->readCipherContext);
+      //Any error to report?
+      if(error) return error;
+   }
+#endif
+
+#if (TLS_MAX_VERSION >= TLS_VERSION_1_0 && TLS_MIN_VERSION <= TLS_VERSION_1_2)
+   //TLS uses a HMAC construction?
+   if(context->hashAlgo != NULL && context->version >= TLS_VERSION_1_0)
+   {
+      //Allocate a memory buffer to hold the HMAC context
+      context->readHmacContext = osMemAlloc(sizeof(HmacContext));
+      //Failed to allocate memory?
+      if(!context->readHmacContext) return ERROR_OUT_OF_MEMORY;
+
+      //The inner and outer padded keys are digested once for the
+      //lifetime of the read MAC key
+      hmacInit(context->readHmacContext, context->hashAlgo,
+         context->readMacKey, context->macKeyLength);
+   }
+#endif
+
    //Inform the record layer that subsequent records will be protected
    //under the newly negotiated encryption algorithm
    context->changeCipherSpecReceived = TRUE;
@@ -838,6 +988,11 @@ error_t tlsParseFinished(TlsContext *context, const TlsFinished *message, size_t
       //Use abbreviated or full handshake?
       if(context->resume)
          context->state = TLS_STATE_APPLICATION_DATA;
+#if (TLS_TICKET_SUPPORT == ENABLED)
+      //Issue a session ticket before the ChangeCipherSpec message?
+      else if(context->newSessionTicket)
+         context->state = TLS_STATE_NEW_SESSION_TICKET;
+#endif
       else
          context->state = TLS_STATE_SERVER_CHANGE_CIPHER_SPEC;
    }
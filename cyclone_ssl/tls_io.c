@@ -34,25 +34,55 @@
 #include "tls_io.h"
 #include "bsd_socket.h"
 
+//Non-blocking BSD sockets report through errno that an operation would block
+#if (TLS_BSD_SOCKET_SUPPORT == ENABLED)
+   #include <errno.h>
+   #define TLS_IO_WOULD_BLOCK() (errno == EWOULDBLOCK || errno == EAGAIN)
+#endif
+
 //Check SSL library configuration
 #if (TLS_SUPPORT == ENABLED)
 
 
 /**
  * @brief Write data to the underlying socket
+ *
+ * With a non-blocking socket, the function may return before all the data
+ * has been written. ERROR_WANT_WRITE is then reported and the number of
+ * bytes actually written tells the caller where to resume
+ *
  * @param[in] context Pointer to the TLS context
  * @param[in] data Buffer containing the data to be written
  * @param[in] length Total number of bytes to be transmitted
+ * @param[out] written Actual number of bytes written
  * @return Error code
  **/
 
-error_t tlsIoWrite(TlsContext *context, const void *data, size_t length)
+error_t tlsIoWrite(TlsContext *context, const void *data,
+   size_t length, size_t *written)
 {
 #if (TLS_BSD_SOCKET_SUPPORT == ENABLED)
+   int_t n;
+
+   //No data has been written yet
+   *written = 0;
+
    //Send the specified number of bytes
-   int_t n = send(context->socket, data, length, 0);
-   //Check return value
-   if(n != length) return ERROR_WRITE_FAILED;
+   while(*written < length)
+   {
+      //Write as much data as the socket accepts
+      n = send(context->socket, (const uint8_t *) data + *written, length - *written, 0);
+
+      //The socket cannot accept more data for the moment?
+      if(n < 0 && TLS_IO_WOULD_BLOCK())
+         return ERROR_WANT_WRITE;
+      //Any other error to report?
+      if(n <= 0)
+         return ERROR_WRITE_FAILED;
+
+      //Total number of bytes written
+      *written += n;
+   }
 
    //Successful write operation
    return NO_ERROR;
@@ -60,9 +90,14 @@ error_t tlsIoWrite(TlsContext *context, const void *data, size_t length)
    error_t error;
 
    //Send the specified number of bytes
-   error = socketSend(context->socket, data, length, NULL, 0);
-   //Any error to report?
-   if(error) return ERROR_WRITE_FAILED;
+   error = socketSend(context->socket, data, length, written, 0);
+
+   //The socket cannot accept more data for the moment?
+   if(error == ERROR_TIMEOUT)
+      return ERROR_WANT_WRITE;
+   //Any other error to report?
+   if(error)
+      return ERROR_WRITE_FAILED;
 
    //Successful write operation
    return NO_ERROR;
@@ -71,46 +106,75 @@ error_t tlsIoWrite(TlsContext *context, const void *data, size_t length)
 
 
 /**
- * @brief Read data from the underlying socket
+ * @brief Read data from the underlying socket, accepting extra bytes
+ *
+ * The function returns once at least the requested number of bytes has
+ * been read. Any data that is already available beyond that amount is
+ * returned as well, up to the size of the buffer. This lets the caller
+ * pick up the beginning of the next record without another system call.
+ * With a non-blocking socket, ERROR_WANT_READ is reported when the data
+ * is not available yet, the bytes already read being kept by the caller
+ *
  * @param[in] context Pointer to the TLS context
  * @param[out] data Buffer where to store the incoming data
- * @param[in] length Requested number of bytes to read
+ * @param[in] length Minimum number of bytes to read
+ * @param[in] size Size of the buffer, in bytes
+ * @param[out] received Actual number of bytes that have been read
  * @return Error code
  **/
 
-error_t tlsIoRead(TlsContext *context, void *data, size_t length)
+error_t tlsIoReadAhead(TlsContext *context, void *data,
+   size_t length, size_t size, size_t *received)
 {
 #if (TLS_BSD_SOCKET_SUPPORT == ENABLED)
-   //Read as much data as possible
-   while(length > 0)
+   int_t n;
+
+   //No data has been read yet
+   *received = 0;
+
+   //Read data until the minimum number of bytes is reached
+   while(*received < length)
    {
-      //Read data
-      int_t n = recv(context->socket, data, length, 0);
-      //Any error to report?
-      if(n <= 0) break;
-
-      //Advance data pointer
-      data = (uint8_t *) data + n;
-      //Number of bytes remaining to read
-      length -= n;
+      //Read as much data as available, within the limits of the buffer
+      n = recv(context->socket, (uint8_t *) data + *received, size - *received, 0);
+
+      //No data is available for the moment?
+      if(n < 0 && TLS_IO_WOULD_BLOCK())
+         return ERROR_WANT_READ;
+      //Any other error to report?
+      if(n <= 0)
+         return ERROR_READ_FAILED;
+
+      //Total number of bytes read
+      *received += n;
    }
 
-   //Make sure that the requested number of bytes have been read
-   if(length != 0) return ERROR_READ_FAILED;
-
    //Successful read operation
    return NO_ERROR;
 #else
    error_t error;
    size_t n;
 
-   //Read data
-   error = socketReceive(context->socket, data, length, &n, SOCKET_FLAG_WAIT_ALL);
-   //Any error to report?
-   if(error) return ERROR_READ_FAILED;
+   //No data has been read yet
+   *received = 0;
 
-   //Make sure that the requested number of bytes have been read
-   if(n != length) return ERROR_READ_FAILED;
+   //Read data until the minimum number of bytes is reached
+   while(*received < length)
+   {
+      //Read as much data as available, within the limits of the buffer
+      error = socketReceive(context->socket, (uint8_t *) data + *received,
+         size - *received, &n, 0);
+
+      //No data is available for the moment?
+      if(error == ERROR_TIMEOUT)
+         return ERROR_WANT_READ;
+      //Any other error to report?
+      if(error)
+         return ERROR_READ_FAILED;
+
+      //Total number of bytes read
+      *received += n;
+   }
 
    //Successful read operation
    return NO_ERROR;
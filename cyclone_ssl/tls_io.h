@@ -33,7 +33,9 @@
 #include "tls.h"
 
 //I/O abstraction layer
-error_t tlsIoWrite(TlsContext *context, const void *data, size_t length);
-error_t tlsIoRead(TlsContext *context, void *data, size_t length);
+error_t tlsIoWrite(TlsContext *context, const void *data,
+   size_t length, size_t *written);
+error_t tlsIoReadAhead(TlsContext *context, void *data,
+   size_t length, size_t size, size_t *received);
 
 #endif
@@ -40,6 +40,8 @@
 #include "asn1.h"
 #include "x509.h"
 #include "pem.h"
+#include "p256.h"
+#include "curve25519.h"
 #include "debug.h"
 
 //Check SSL library configuration
@@ -62,6 +64,11 @@ void tlsProcessError(TlsContext *context, error_t errorCode)
    case ERROR_WRITE_FAILED:
    case ERROR_READ_FAILED:
       break;
+   //The operation cannot complete without blocking and will be resumed later
+   case ERROR_WANT_READ:
+   case ERROR_WANT_WRITE:
+   case ERROR_WANT_KEY_OPERATION:
+      break;
    //An inappropriate message was received
    case ERROR_UNEXPECTED_MESSAGE:
       tlsSendAlert(context, TLS_ALERT_LEVEL_FATAL, TLS_ALERT_UNEXPECTED_MESSAGE);
@@ -76,6 +83,7 @@ void tlsProcessError(TlsContext *context, error_t errorCode)
       break;
    //Unable to negotiate an acceptable set of security parameters
    case ERROR_HANDSHAKE_FAILED:
+   case ERROR_UNSUPPORTED_ELLIPTIC_CURVE:
       tlsSendAlert(context, TLS_ALERT_LEVEL_FATAL, TLS_ALERT_HANDSHAKE_FAILURE);
       break;
    //A certificate was corrupt
@@ -204,6 +212,16 @@ error_t tlsSetCipherSuite(TlsContext *context, uint16_t identifier)
          acceptable = FALSE;
    }
 
+   //ECC cipher suites rely on hello extensions that SSL 3.0 does not provide
+   if(acceptable && context->version < TLS_VERSION_1_0)
+   {
+      if(cipherSuite->keyExchMethod == TLS_KEY_EXCH_ECDHE_RSA ||
+         cipherSuite->keyExchMethod == TLS_KEY_EXCH_ECDHE_ECDSA)
+      {
+         acceptable = FALSE;
+      }
+   }
+
    //Ensure that the selected cipher suite matches all the criteria
    if(acceptable)
    {
@@ -309,11 +327,18 @@ error_t tlsSelectSignHashAlgo(TlsContext *context,
             //TLS operates as a client?
             if(context->entity == TLS_CONNECTION_END_CLIENT)
             {
-               //Check whether the associated hash algorithm is supported
-               if(supportedSignAlgos->value[i].hash == TLS_HASH_ALGO_SHA1)
+               //The PRF hash algorithm is preferred since the handshake
+               //messages are already digested with it
+               if(tlsGetHashAlgo(supportedSignAlgos->value[i].hash) == context->prfHashAlgo)
+               {
                   context->signHashAlgo = (TlsHashAlgo) supportedSignAlgos->value[i].hash;
-               else if(tlsGetHashAlgo(supportedSignAlgos->value[i].hash) == context->prfHashAlgo)
+                  break;
+               }
+               //SHA-1 is used as a fallback
+               else if(supportedSignAlgos->value[i].hash == TLS_HASH_ALGO_SHA1)
+               {
                   context->signHashAlgo = (TlsHashAlgo) supportedSignAlgos->value[i].hash;
+               }
             }
             //TLS operates as a server?
             else
@@ -332,11 +357,11 @@ error_t tlsSelectSignHashAlgo(TlsContext *context,
                default:
                   break;
                }
-            }
 
-            //Acceptable hash algorithm found?
-            if(context->signHashAlgo != TLS_HASH_ALGO_NONE)
-               break;
+               //Acceptable hash algorithm found?
+               if(context->signHashAlgo != TLS_HASH_ALGO_NONE)
+                  break;
+            }
          }
       }
    }
@@ -357,34 +382,67 @@ error_t tlsSelectSignHashAlgo(TlsContext *context,
 
 /**
  * @brief Initialize handshake message hashing
+ *
+ * Hashing starts once the version and the cipher suite have been
+ * negotiated, so that only the hash functions that will actually be
+ * used to compute the verify data and the CertificateVerify message
+ * are run over the transcript
+ *
  * @param[in] context Pointer to the TLS context
  * @return Error code
  **/
 
 error_t tlsInitHandshakeHash(TlsContext *context)
 {
-   //Allocate SHA-1 context
-   context->handshakeSha1Context = osMemAlloc(sizeof(Sha1Context));
-   //Failed to allocate memory?
-   if(!context->handshakeSha1Context) return ERROR_OUT_OF_MEMORY;
+   bool_t sha1Needed;
+
+   //Release the hash contexts of any previous handshake
+   tlsFreeHandshakeHash(context);
+
+   //SSL 3.0, TLS 1.0 or 1.1 currently selected?
+   if(context->version <= TLS_VERSION_1_1)
+   {
+      //Verify data and signatures always use both MD5 and SHA-1
+      sha1Needed = TRUE;
+   }
+   //Abbreviated handshake?
+   else if(context->resume)
+   {
+      //Only the Finished messages are computed from the transcript
+      sha1Needed = FALSE;
+   }
+   //TLS operates as a client?
+   else if(context->entity == TLS_CONNECTION_END_CLIENT)
+   {
+      //A SHA-1 CertificateVerify message may have to be generated
+      sha1Needed = (context->numCerts > 0);
+   }
+   //TLS operates as a server?
+   else
+   {
+      //A SHA-1 CertificateVerify message may have to be checked
+      sha1Needed = (context->clientAuthMode != TLS_CLIENT_AUTH_NONE);
+   }
+
+   //The SHA-1 transcript is not maintained when TLS 1.2 does not need it
+   if(sha1Needed)
+   {
+      //Allocate SHA-1 context
+      context->handshakeSha1Context = osMemAlloc(sizeof(Sha1Context));
+      //Failed to allocate memory?
+      if(!context->handshakeSha1Context) return ERROR_OUT_OF_MEMORY;
 
-   //Initialize SHA-1 context
-   sha1Init(context->handshakeSha1Context);
+      //Initialize SHA-1 context
+      sha1Init(context->handshakeSha1Context);
+   }
 
    //SSL 3.0, TLS 1.0 or 1.1 currently selected?
    if(context->version <= TLS_VERSION_1_1)
    {
       //Allocate MD5 context
       context->handshakeMd5Context = osMemAlloc(sizeof(Md5Context));
-
       //Failed to allocate memory?
-      if(!context->handshakeMd5Context)
-      {
-         //Clean up side effects
-         osMemFree(context->handshakeSha1Context);
-         //Report an error
-         return ERROR_OUT_OF_MEMORY;
-      }
+      if(!context->handshakeMd5Context) return ERROR_OUT_OF_MEMORY;
 
       //Initialize MD5 context
       md5Init(context->handshakeMd5Context);
@@ -394,15 +452,8 @@ error_t tlsInitHandshakeHash(TlsContext *context)
    {
       //Allocate a memory buffer to hold the hash algorithm context
       context->handshakeHashContext = osMemAlloc(context->prfHashAlgo->contextSize);
-
       //Failed to allocate memory?
-      if(!context->handshakeHashContext)
-      {
-         //Clean up side effects
-         osMemFree(context->handshakeSha1Context);
-         //Report an error
-         return ERROR_OUT_OF_MEMORY;
-      }
+      if(!context->handshakeHashContext) return ERROR_OUT_OF_MEMORY;
 
       //Initialize the hash algorithm context
       context->prfHashAlgo->init(context->handshakeHashContext);
@@ -411,6 +462,8 @@ error_t tlsInitHandshakeHash(TlsContext *context)
    //TLS operates as a client?
    if(context->entity == TLS_CONNECTION_END_CLIENT)
    {
+      //The ClientHello message was sent before the version and the PRF
+      //hash were known. It is still held in the transmit buffer
       //Point to the ClientHello message
       TlsHandshake *message = (TlsHandshake *) (context->txBuffer + sizeof(TlsRecord));
       //Retrieve the length of the message
@@ -429,6 +482,27 @@ error_t tlsInitHandshakeHash(TlsContext *context)
 }
 
 
+/**
+ * @brief Release handshake message hashing resources
+ * @param[in] context Pointer to the TLS context
+ **/
+
+void tlsFreeHandshakeHash(TlsContext *context)
+{
+   //Release MD5 context
+   osMemFree(context->handshakeMd5Context);
+   context->handshakeMd5Context = NULL;
+
+   //Release SHA-1 context
+   osMemFree(context->handshakeSha1Context);
+   context->handshakeSha1Context = NULL;
+
+   //Release PRF hash context
+   osMemFree(context->handshakeHashContext);
+   context->handshakeHashContext = NULL;
+}
+
+
 /**
  * @brief Update hash value with a handshake message
  * @param[in] context Pointer to the TLS context
@@ -550,8 +624,16 @@ error_t tlsFinalizeHandshakeHash(TlsContext *context, const HashAlgo *hash,
 error_t tlsComputeVerifyData(TlsContext *context, TlsConnectionEnd entity)
 {
    error_t error;
+   bool_t last;
    const char_t *label;
 
+   //The Finished message sent by the server concludes a full handshake,
+   //whereas the one sent by the client concludes an abbreviated handshake
+   if(entity == TLS_CONNECTION_END_SERVER)
+      last = !context->resume;
+   else
+      last = context->resume;
+
 #if (TLS_MAX_VERSION >= SSL_VERSION_3_0 && TLS_MIN_VERSION <= SSL_VERSION_3_0)
    //SSL 3.0 currently selected?
    if(context->version == SSL_VERSION_3_0)
@@ -581,17 +663,27 @@ error_t tlsComputeVerifyData(TlsContext *context, TlsConnectionEnd entity)
       //and SHA-1 hash values before computing PRF
       uint8_t buffer[MD5_DIGEST_SIZE + SHA1_DIGEST_SIZE];
 
-      //Finalize MD5 hash computation
-      error = tlsFinalizeHandshakeHash(context, MD5_HASH_ALGO,
-         context->handshakeMd5Context, "", buffer);
-      //Any error to report?
-      if(error) return error;
-
-      //Finalize SHA-1 hash computation
-      error = tlsFinalizeHandshakeHash(context, SHA1_HASH_ALGO,
-         context->handshakeSha1Context, "", buffer + MD5_DIGEST_SIZE);
-      //Any error to report?
-      if(error) return error;
+      //No handshake message will follow the last Finished message
+      if(last)
+      {
+         //The hash contexts do not need to be preserved
+         md5Final(context->handshakeMd5Context, buffer);
+         sha1Final(context->handshakeSha1Context, buffer + MD5_DIGEST_SIZE);
+      }
+      else
+      {
+         //Finalize MD5 hash computation
+         error = tlsFinalizeHandshakeHash(context, MD5_HASH_ALGO,
+            context->handshakeMd5Context, "", buffer);
+         //Any error to report?
+         if(error) return error;
+
+         //Finalize SHA-1 hash computation
+         error = tlsFinalizeHandshakeHash(context, SHA1_HASH_ALGO,
+            context->handshakeSha1Context, "", buffer + MD5_DIGEST_SIZE);
+         //Any error to report?
+         if(error) return error;
+      }
 
       //Computation is performed at client or server side?
       label = (entity == TLS_CONNECTION_END_CLIENT) ? "client finished" : "server finished";
@@ -608,13 +700,25 @@ error_t tlsComputeVerifyData(TlsContext *context, TlsConnectionEnd entity)
    //TLS 1.2 currently selected?
    if(context->version == TLS_VERSION_1_2)
    {
-      //Allocate a memory buffer to hold the hash algorithm context
-      HashContext *hashContext = osMemAlloc(context->prfHashAlgo->contextSize);
-      //Failed to allocate memory?
-      if(!hashContext) return ERROR_OUT_OF_MEMORY;
+      HashContext *hashContext;
+
+      //No handshake message will follow the last Finished message
+      if(last)
+      {
+         //The hash context can be finalized in place
+         hashContext = context->handshakeHashContext;
+      }
+      else
+      {
+         //Allocate a memory buffer to hold the hash algorithm context
+         hashContext = osMemAlloc(context->prfHashAlgo->contextSize);
+         //Failed to allocate memory?
+         if(!hashContext) return ERROR_OUT_OF_MEMORY;
+
+         //The original hash context must be preserved
+         memcpy(hashContext, context->handshakeHashContext, context->prfHashAlgo->contextSize);
+      }
 
-      //The original hash context must be preserved
-      memcpy(hashContext, context->handshakeHashContext, context->prfHashAlgo->contextSize);
       //Finalize hash computation
       context->prfHashAlgo->final(hashContext, NULL);
 
@@ -626,7 +730,8 @@ error_t tlsComputeVerifyData(TlsContext *context, TlsConnectionEnd entity)
          context->prfHashAlgo->digestSize, context->verifyData, context->verifyDataLength);
 
       //Release previously allocated memory
-      osMemFree(hashContext);
+      if(!last)
+         osMemFree(hashContext);
 
       //Any error to report?
       if(error) return error;
@@ -639,6 +744,10 @@ error_t tlsComputeVerifyData(TlsContext *context, TlsConnectionEnd entity)
       return ERROR_INVALID_VERSION;
    }
 
+   //The transcript is no longer needed once the handshake is over
+   if(last)
+      tlsFreeHandshakeHash(context);
+
    //Debug message
    TRACE_DEBUG("Verify data:\r\n");
    TRACE_DEBUG_ARRAY("  ", context->verifyData, context->verifyDataLength);
@@ -716,6 +825,75 @@ error_t tlsReadMpi(Mpi *x, const uint8_t *data, size_t size, size_t *length)
 }
 
 
+/**
+ * @brief Encode an EC point to an opaque vector
+ * @param[in] point Encoded EC point
+ * @param[in] pointLength Length of the EC point
+ * @param[out] data Buffer where to store the opaque vector
+ * @param[out] length Total number of bytes that have been written
+ * @return Error code
+ **/
+
+error_t tlsWriteEcPoint(const uint8_t *point, size_t pointLength,
+   uint8_t *data, size_t *length)
+{
+   //The point is preceded by a 1-byte length field
+   if(pointLength == 0 || pointLength > 255)
+      return ERROR_INVALID_LENGTH;
+
+   //Write the length field
+   data[0] = (uint8_t) pointLength;
+   //Copy the encoded point
+   memcpy(data + 1, point, pointLength);
+
+   //Return the total number of bytes that have been written
+   *length = pointLength + 1;
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Read an EC point from an opaque vector
+ * @param[out] point Buffer where to store the encoded EC point
+ * @param[in] pointSize Size of the buffer
+ * @param[out] pointLength Length of the EC point
+ * @param[in] data Buffer where to read the opaque vector
+ * @param[in] size Total number of bytes available in the buffer
+ * @param[out] length Total number of bytes that have been read
+ * @return Error code
+ **/
+
+error_t tlsReadEcPoint(uint8_t *point, size_t pointSize, size_t *pointLength,
+   const uint8_t *data, size_t size, size_t *length)
+{
+   size_t n;
+
+   //Buffer underrun?
+   if(size < 1)
+      return ERROR_DECODING_FAILED;
+
+   //Decode the length field
+   n = data[0];
+
+   //Buffer underrun?
+   if(size < (n + 1))
+      return ERROR_DECODING_FAILED;
+   //Empty or oversized point?
+   if(n == 0 || n > pointSize)
+      return ERROR_ILLEGAL_PARAMETER;
+
+   //Copy the encoded point
+   memcpy(point, data + 1, n);
+   *pointLength = n;
+
+   //Return the total number of bytes that have been read
+   *length = n + 1;
+   //Successful processing
+   return NO_ERROR;
+}
+
+
 /**
  * @brief Generate RSA signature (SSL 3.0, TLS 1.0 and TLS 1.1)
  * @param[in] key Signer's RSA private key
@@ -1014,6 +1192,83 @@ error_t tlsVerifyDsaSignature(const DsaPublicKey *key, const uint8_t *digest,
 }
 
 
+/**
+ * @brief Generate ECDSA signature
+ * @param[in] prngAlgo PRNG algorithm
+ * @param[in] prngContext Pointer to the PRNG context
+ * @param[in] key Signer's EC private key
+ * @param[in] digest Digest of the message to be signed
+ * @param[in] digestLength Length in octets of the digest
+ * @param[out] signature Resulting signature
+ * @param[out] signatureLength Length of the resulting signature
+ * @return Error code
+ **/
+
+error_t tlsGenerateEcdsaSignature(const PrngAlgo *prngAlgo, void *prngContext, const EcPrivateKey *key,
+   const uint8_t *digest, size_t digestLength, uint8_t *signature, size_t *signatureLength)
+{
+   error_t error;
+   EcdsaSignature ecdsaSignature;
+
+   //Initialize ECDSA signature
+   ecdsaInitSignature(&ecdsaSignature);
+
+   //Generate ECDSA signature
+   error = ecdsaGenerateSignature(prngAlgo, prngContext,
+      key, digest, digestLength, &ecdsaSignature);
+
+   //Check status code
+   if(!error)
+   {
+      //Encode the resulting (R, S) integer pair using ASN.1
+      error = ecdsaWriteSignature(&ecdsaSignature, signature, signatureLength);
+   }
+
+   //Free previously allocated resources
+   ecdsaFreeSignature(&ecdsaSignature);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Verify ECDSA signature
+ * @param[in] key Signer's EC public key
+ * @param[in] digest Digest of the message whose signature is to be verified
+ * @param[in] digestLength Length in octets of the digest
+ * @param[in] signature Signature to be verified
+ * @param[in] signatureLength Length of the signature to be verified
+ * @return Error code
+ **/
+
+error_t tlsVerifyEcdsaSignature(const EcPublicKey *key, const uint8_t *digest,
+   size_t digestLength, const uint8_t *signature, size_t signatureLength)
+{
+   error_t error;
+   EcdsaSignature ecdsaSignature;
+
+   //Initialize ECDSA signature
+   ecdsaInitSignature(&ecdsaSignature);
+
+   //Read the ASN.1 encoded ECDSA signature
+   error = ecdsaReadSignature(signature, signatureLength, &ecdsaSignature);
+
+   //Check status code
+   if(!error)
+   {
+      //ECDSA signature verification
+      error = ecdsaVerifySignature(key, digest, digestLength, &ecdsaSignature);
+   }
+
+   //Free previously allocated resources
+   ecdsaFreeSignature(&ecdsaSignature);
+
+   //Return status code
+   return error;
+}
+
+
 /**
  * @brief Key generation
  * @param[in] context Pointer to the TLS context
@@ -1220,8 +1475,10 @@ error_t tlsPrf(const uint8_t *secret, size_t secretLength, const char_t *label,
    //S2 is taken from the second half
    s2 = secret + secretLength - sLength;
 
-   //First compute A(1) = HMAC_MD5(S1, label + seed)
+   //The inner and outer padded keys are digested once for all
    hmacInit(context, MD5_HASH_ALGO, s1, sLength);
+
+   //First compute A(1) = HMAC_MD5(S1, label + seed)
    hmacUpdate(context, label, labelLength);
    hmacUpdate(context, seed, seedLength);
    hmacFinal(context, a);
@@ -1230,7 +1487,7 @@ error_t tlsPrf(const uint8_t *secret, size_t secretLength, const char_t *label,
    for(i = 0; i < outputLength; )
    {
       //Compute HMAC_MD5(S1, A(i) + label + seed)
-      hmacInit(context, MD5_HASH_ALGO, s1, sLength);
+      hmacReset(context);
       hmacUpdate(context, a, MD5_DIGEST_SIZE);
       hmacUpdate(context, label, labelLength);
       hmacUpdate(context, seed, seedLength);
@@ -1241,13 +1498,15 @@ error_t tlsPrf(const uint8_t *secret, size_t secretLength, const char_t *label,
          output[i] = context->digest[j];
 
       //Compute A(i + 1) = HMAC_MD5(S1, A(i))
-      hmacInit(context, MD5_HASH_ALGO, s1, sLength);
+      hmacReset(context);
       hmacUpdate(context, a, MD5_DIGEST_SIZE);
       hmacFinal(context, a);
    }
 
-   //First compute A(1) = HMAC_SHA1(S2, label + seed)
+   //Same for the second half of the secret
    hmacInit(context, SHA1_HASH_ALGO, s2, sLength);
+
+   //First compute A(1) = HMAC_SHA1(S2, label + seed)
    hmacUpdate(context, label, labelLength);
    hmacUpdate(context, seed, seedLength);
    hmacFinal(context, a);
@@ -1256,7 +1515,7 @@ error_t tlsPrf(const uint8_t *secret, size_t secretLength, const char_t *label,
    for(i = 0; i < outputLength; )
    {
       //Compute HMAC_SHA1(S2, A(i) + label + seed)
-      hmacInit(context, SHA1_HASH_ALGO, s2, sLength);
+      hmacReset(context);
       hmacUpdate(context, a, SHA1_DIGEST_SIZE);
       hmacUpdate(context, label, labelLength);
       hmacUpdate(context, seed, seedLength);
@@ -1267,7 +1526,7 @@ error_t tlsPrf(const uint8_t *secret, size_t secretLength, const char_t *label,
          output[i] ^= context->digest[j];
 
       //Compute A(i + 1) = HMAC_SHA1(S2, A(i))
-      hmacInit(context, SHA1_HASH_ALGO, s2, sLength);
+      hmacReset(context);
       hmacUpdate(context, a, SHA1_DIGEST_SIZE);
       hmacFinal(context, a);
    }
@@ -1313,8 +1572,11 @@ error_t tlsPrf2(const HashAlgo *hash, const uint8_t *secret, size_t secretLength
    //Compute the length of the label
    labelLength = strlen(label);
 
-   //First compute A(1) = HMAC_hash(secret, label + seed)
+   //The inner and outer padded keys are digested once. Each of the
+   //subsequent HMAC computations starts from the precomputed states
    hmacInit(context, hash, secret, secretLength);
+
+   //First compute A(1) = HMAC_hash(secret, label + seed)
    hmacUpdate(context, label, labelLength);
    hmacUpdate(context, seed, seedLength);
    hmacFinal(context, a);
@@ -1323,7 +1585,7 @@ error_t tlsPrf2(const HashAlgo *hash, const uint8_t *secret, size_t secretLength
    while(outputLength > 0)
    {
       //Compute HMAC_hash(secret, A(i) + label + seed)
-      hmacInit(context, hash, secret, secretLength);
+      hmacReset(context);
       hmacUpdate(context, a, hash->digestSize);
       hmacUpdate(context, label, labelLength);
       hmacUpdate(context, seed, seedLength);
@@ -1335,7 +1597,7 @@ error_t tlsPrf2(const HashAlgo *hash, const uint8_t *secret, size_t secretLength
       memcpy(output, context->digest, n);
 
       //Compute A(i + 1) = HMAC_hash(secret, A(i))
-      hmacInit(context, hash, secret, secretLength);
+      hmacReset(context);
       hmacUpdate(context, a, hash->digestSize);
       hmacFinal(context, a);
 
@@ -1544,6 +1806,12 @@ error_t tlsGetCertificateType(const X509CertificateInfo *certInfo,
       //Save certificate type
       *certType = TLS_CERT_DSS_SIGN;
    }
+   //A valid EC public key has been found?
+   else if(certInfo->subjectPublicKey.namedCurve && certInfo->subjectPublicKey.ecPoint)
+   {
+      //Save certificate type
+      *certType = TLS_CERT_ECDSA_SIGN;
+   }
    //The certificate does not contain any valid public key...
    else
    {
@@ -1608,6 +1876,41 @@ error_t tlsGetCertificateType(const X509CertificateInfo *certInfo,
       *certSignAlgo = TLS_SIGN_ALGO_DSA;
       *certHashAlgo = TLS_HASH_ALGO_SHA256;
    }
+   else if(certInfo->signatureAlgoLen == sizeof(ECDSA_WITH_SHA1_OID) &&
+      !memcmp(certInfo->signatureAlgo, ECDSA_WITH_SHA1_OID, sizeof(ECDSA_WITH_SHA1_OID)))
+   {
+      //ECDSA with SHA-1 signature algorithm
+      *certSignAlgo = TLS_SIGN_ALGO_ECDSA;
+      *certHashAlgo = TLS_HASH_ALGO_SHA1;
+   }
+   else if(certInfo->signatureAlgoLen == sizeof(ECDSA_WITH_SHA224_OID) &&
+      !memcmp(certInfo->signatureAlgo, ECDSA_WITH_SHA224_OID, sizeof(ECDSA_WITH_SHA224_OID)))
+   {
+      //ECDSA with SHA-224 signature algorithm
+      *certSignAlgo = TLS_SIGN_ALGO_ECDSA;
+      *certHashAlgo = TLS_HASH_ALGO_SHA224;
+   }
+   else if(certInfo->signatureAlgoLen == sizeof(ECDSA_WITH_SHA256_OID) &&
+      !memcmp(certInfo->signatureAlgo, ECDSA_WITH_SHA256_OID, sizeof(ECDSA_WITH_SHA256_OID)))
+   {
+      //ECDSA with SHA-256 signature algorithm
+      *certSignAlgo = TLS_SIGN_ALGO_ECDSA;
+      *certHashAlgo = TLS_HASH_ALGO_SHA256;
+   }
+   else if(certInfo->signatureAlgoLen == sizeof(ECDSA_WITH_SHA384_OID) &&
+      !memcmp(certInfo->signatureAlgo, ECDSA_WITH_SHA384_OID, sizeof(ECDSA_WITH_SHA384_OID)))
+   {
+      //ECDSA with SHA-384 signature algorithm
+      *certSignAlgo = TLS_SIGN_ALGO_ECDSA;
+      *certHashAlgo = TLS_HASH_ALGO_SHA384;
+   }
+   else if(certInfo->signatureAlgoLen == sizeof(ECDSA_WITH_SHA512_OID) &&
+      !memcmp(certInfo->signatureAlgo, ECDSA_WITH_SHA512_OID, sizeof(ECDSA_WITH_SHA512_OID)))
+   {
+      //ECDSA with SHA-512 signature algorithm
+      *certSignAlgo = TLS_SIGN_ALGO_ECDSA;
+      *certHashAlgo = TLS_HASH_ALGO_SHA512;
+   }
    else
    {
       //The signature algorithm is not supported...
@@ -1730,4 +2033,24 @@ const HashAlgo *tlsGetHashAlgo(uint8_t hashAlgoId)
       return NULL;
 }
 
+
+/**
+ * @brief Get the elliptic curve that matches the specified named curve
+ * @param[in] namedCurve Named curve identifier
+ * @return Elliptic curve parameters
+ **/
+
+const EcCurveInfo *tlsGetCurveInfo(uint16_t namedCurve)
+{
+   //secp256r1 elliptic curve?
+   if(namedCurve == TLS_EC_CURVE_SECP256R1)
+      return SECP256R1_CURVE;
+   //Curve25519 elliptic curve?
+   else if(namedCurve == TLS_EC_CURVE_ECDH_X25519)
+      return CURVE25519_CURVE;
+   //Unknown curve identifier?
+   else
+      return NULL;
+}
+
 #endif
@@ -44,6 +44,7 @@ error_t tlsSelectSignHashAlgo(TlsContext *context,
    TlsSignatureAlgo signAlgo, const TlsSignHashAlgos *supportedSignAlgos);
 
 error_t tlsInitHandshakeHash(TlsContext *context);
+void tlsFreeHandshakeHash(TlsContext *context);
 void tlsUpdateHandshakeHash(TlsContext *context, const void *data, size_t length);
 
 error_t tlsFinalizeHandshakeHash(TlsContext *context, const HashAlgo *hash,
@@ -54,6 +55,12 @@ error_t tlsComputeVerifyData(TlsContext *context, TlsConnectionEnd entity);
 error_t tlsWriteMpi(const Mpi *x, uint8_t *data, size_t *length);
 error_t tlsReadMpi(Mpi *x, const uint8_t *data, size_t size, size_t *length);
 
+error_t tlsWriteEcPoint(const uint8_t *point, size_t pointLength,
+   uint8_t *data, size_t *length);
+
+error_t tlsReadEcPoint(uint8_t *point, size_t pointSize, size_t *pointLength,
+   const uint8_t *data, size_t size, size_t *length);
+
 error_t tlsGenerateRsaSignature(const RsaPrivateKey *key,
    const uint8_t *digest, uint8_t *signature, size_t *signatureLength);
 
@@ -66,6 +73,12 @@ error_t tlsGenerateDsaSignature(const PrngAlgo *prngAlgo, void *prngContext, con
 error_t tlsVerifyDsaSignature(const DsaPublicKey *key, const uint8_t *digest,
    size_t digestLength, const uint8_t *signature, size_t signatureLength);
 
+error_t tlsGenerateEcdsaSignature(const PrngAlgo *prngAlgo, void *prngContext, const EcPrivateKey *key,
+   const uint8_t *digest, size_t digestLength, uint8_t *signature, size_t *signatureLength);
+
+error_t tlsVerifyEcdsaSignature(const EcPublicKey *key, const uint8_t *digest,
+   size_t digestLength, const uint8_t *signature, size_t signatureLength);
+
 error_t tlsGenerateKeys(TlsContext *context);
 
 error_t tlsPrf(const uint8_t *secret, size_t secretLength, const char_t *label,
@@ -83,5 +96,6 @@ error_t tlsGetCertificateType(const X509CertificateInfo *certInfo,
 const TlsExtension *tlsGetExtension(const uint8_t *data, size_t length, uint16_t type);
 const char_t *tlsGetVersionName(uint16_t version);
 const HashAlgo *tlsGetHashAlgo(uint8_t hashAlgoId);
+const EcCurveInfo *tlsGetCurveInfo(uint16_t namedCurve);
 
 #endif
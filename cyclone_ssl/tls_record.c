@@ -34,12 +34,14 @@
 #include "tls.h"
 #include "tls_common.h"
 #include "tls_record.h"
+#include "tls_buffer.h"
 #include "tls_misc.h"
 #include "tls_io.h"
 #include "ssl_common.h"
 #include "cipher_mode_cbc.h"
 #include "cipher_mode_ccm.h"
 #include "cipher_mode_gcm.h"
+#include "chacha20_poly1305.h"
 #include "debug.h"
 
 //Check SSL library configuration
@@ -58,7 +60,6 @@ error_t tlsWriteProtocolData(TlsContext *context,
       size_t length, TlsContentType contentType)
 {
    error_t error;
-   size_t n;
    uint8_t *p;
 
    //Check the length of the data block
@@ -71,12 +72,10 @@ error_t tlsWriteProtocolData(TlsContext *context,
       tlsUpdateHandshakeHash(context, context->txBuffer + sizeof(TlsRecord), length);
 
    //All the data fits into a TLS single record?
-   if(length <= TLS_MAX_RECORD_LENGTH)
+   if(length <= context->maxFragLength)
    {
       //Send TLS record
       error = tlsWriteRecord(context, length, contentType);
-      //Any error to report?
-      if(error) return error;
    }
    else
    {
@@ -85,28 +84,22 @@ error_t tlsWriteProtocolData(TlsContext *context,
       //Make room for the encryption overhead
       memmove(p, p - TLS_MAX_RECORD_OVERHEAD, length);
 
-      //Fragmentation process
-      while(length > 0)
-      {
-         //The record length cannot exceed 16384 bytes
-         n = min(length, TLS_MAX_RECORD_LENGTH);
-         //Move current chunk of data to the beginning of the buffer
-         memmove(context->txBuffer + sizeof(TlsRecord), p, n);
-
-         //Send fragment
-         error = tlsWriteRecord(context, n, contentType);
-         //Any error to report?
-         if(error) return error;
+      //The fragments are protected and sent one after the other
+      context->txBufferType = contentType;
+      context->txFragmentIndex = p - context->txBuffer;
+      context->txFragmentLength = length;
 
-         //Advance data pointer
-         p += n;
-         //Data left to be written
-         length -= n;
-      }
+      //Send as many fragments as possible
+      error = tlsSendPendingData(context);
    }
 
-   //Successful write operation
-   return NO_ERROR;
+   //The remaining data is kept in the TX buffer until the socket
+   //accepts more data (non-blocking mode)
+   if(error == ERROR_WANT_WRITE)
+      error = NO_ERROR;
+
+   //Return status code
+   return error;
 }
 
 
@@ -123,6 +116,7 @@ error_t tlsReadProtocolData(TlsContext *context,
    void **data, size_t *length, TlsContentType *contentType)
 {
    error_t error;
+   size_t i;
    size_t n;
    TlsContentType type;
    TlsHandshake *message;
@@ -137,7 +131,7 @@ error_t tlsReadProtocolData(TlsContext *context,
       if(context->rxBufferLength == 0)
       {
          //Read a TLS record
-         error = tlsReadRecord(context, context->rxBuffer, TLS_RX_BUFFER_SIZE, &n, &type);
+         error = tlsReadRecord(context, 0, &i, &n, &type);
          //Any error to report?
          if(error) return error;
 
@@ -145,10 +139,10 @@ error_t tlsReadProtocolData(TlsContext *context,
          context->rxBufferType = type;
          //Number of bytes available for reading
          context->rxBufferLength = n;
-         //Rewind to the beginning of the buffer
-         context->rxBufferReadIndex = 0;
+         //The data is consumed where it has been decrypted
+         context->rxBufferReadIndex = i;
          //Set write index
-         context->rxBufferWriteIndex = context->rxBufferLength;
+         context->rxBufferWriteIndex = i + n;
       }
       //Imcomplete message received?
       else if(error == ERROR_MORE_DATA_REQUIRED)
@@ -167,8 +161,7 @@ error_t tlsReadProtocolData(TlsContext *context,
          }
 
          //Read a TLS record
-         error = tlsReadRecord(context, context->rxBuffer + context->rxBufferWriteIndex,
-            TLS_RX_BUFFER_SIZE - context->rxBufferLength, &n, &type);
+         error = tlsReadRecord(context, context->rxBufferWriteIndex, &i, &n, &type);
          //Any error to report?
          if(error) return error;
 
@@ -176,6 +169,10 @@ error_t tlsReadProtocolData(TlsContext *context,
          if(type != context->rxBufferType)
             return ERROR_UNEXPECTED_MESSAGE;
 
+         //Reassembled data must be contiguous
+         if(i != context->rxBufferWriteIndex)
+            memmove(context->rxBuffer + context->rxBufferWriteIndex, context->rxBuffer + i, n);
+
          //Number of bytes available for reading
          context->rxBufferLength += n;
          //Update write index
@@ -289,13 +286,144 @@ error_t tlsReadProtocolData(TlsContext *context,
 
 error_t tlsWriteRecord(TlsContext *context,
    size_t length, TlsContentType contentType)
+{
+   size_t headroom;
+   uint8_t *data;
+
+   //Number of bytes that the record protection inserts before the data
+   headroom = tlsGetRecordHeadroom(context);
+
+   //The data has been written right after the record header?
+   if(headroom > 0)
+   {
+      //Point to the record data
+      data = context->txBuffer + sizeof(TlsRecord);
+      //Make room for the explicit IV
+      memmove(data + headroom, data, length);
+   }
+
+   //Protect and send the record
+   return tlsSendRecord(context, length, contentType);
+}
+
+
+/**
+ * @brief Protect and send a TLS record
+ *
+ * The record data must have been written to the TX buffer after the
+ * record header, leaving tlsGetRecordHeadroom() bytes for the explicit IV
+ *
+ * @param[in] context Pointer to the TLS context
+ * @param[in] length Actual length of the record data
+ * @param[in] contentType Record type
+ * @return Error code
+ **/
+
+error_t tlsSendRecord(TlsContext *context,
+   size_t length, TlsContentType contentType)
+{
+   error_t error;
+
+   //Protect the record
+   error = tlsProtectRecord(context, length, contentType);
+   //Any error to report?
+   if(error) return error;
+
+   //Send as much of the record as possible
+   return tlsSendPendingData(context);
+}
+
+
+/**
+ * @brief Send the data that is pending in the TX buffer
+ *
+ * A record that could not be written at once, as well as the fragments
+ * of a long message that have not been protected yet, remain in the TX
+ * buffer until the socket accepts more data. No other data may be written
+ * to the TX buffer until this function has succeeded
+ *
+ * @param[in] context Pointer to the TLS context
+ * @return Error code
+ **/
+
+error_t tlsSendPendingData(TlsContext *context)
+{
+   error_t error;
+   size_t n;
+
+   //Send all the pending data
+   while(context->txRecordLength > 0 || context->txFragmentLength > 0)
+   {
+      //Part of a protected record is waiting to be sent?
+      if(context->txRecordLength > 0)
+      {
+         //Write as much data as the socket accepts
+         error = tlsIoWrite(context, context->txBuffer + context->txRecordIndex,
+            context->txRecordLength, &n);
+
+         //Advance data pointer
+         context->txRecordIndex += n;
+         //Number of bytes left to be sent
+         context->txRecordLength -= n;
+
+         //Any error to report?
+         if(error) return error;
+      }
+      else
+      {
+         //The record length cannot exceed the negotiated maximum fragment length
+         n = min(context->txFragmentLength, context->maxFragLength);
+
+         //Move current chunk of data after the room reserved for the explicit IV
+         memmove(context->txBuffer + sizeof(TlsRecord) + tlsGetRecordHeadroom(context),
+            context->txBuffer + context->txFragmentIndex, n);
+
+         //Advance data pointer
+         context->txFragmentIndex += n;
+         //Data left to be fragmented
+         context->txFragmentLength -= n;
+
+         //Protect the fragment
+         error = tlsProtectRecord(context, n, context->txBufferType);
+         //Any error to report?
+         if(error) return error;
+      }
+   }
+
+   //All the pending data has been sent
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Protect a TLS record
+ *
+ * The record data must have been written to the TX buffer after the
+ * record header, leaving tlsGetRecordHeadroom() bytes for the explicit IV.
+ * The protected record is left in the TX buffer for tlsSendPendingData()
+ *
+ * @param[in] context Pointer to the TLS context
+ * @param[in] length Actual length of the record data
+ * @param[in] contentType Record type
+ * @return Error code
+ **/
+
+error_t tlsProtectRecord(TlsContext *context,
+   size_t length, TlsContentType contentType)
 {
    error_t error;
    uint_t i;
+   size_t headroom;
    size_t paddingLength;
+   uint8_t *data;
 
    //Point to the TLS record
    TlsRecord *record = (TlsRecord *) context->txBuffer;
+
+   //Number of bytes reserved for the explicit IV
+   headroom = tlsGetRecordHeadroom(context);
+   //Point to the record data
+   data = record->data + headroom;
    //Format TLS record
    record->type = contentType;
    record->version = htons(context->version);
@@ -303,7 +431,7 @@ error_t tlsWriteRecord(TlsContext *context,
 
    //Debug message
    TRACE_DEBUG("Sending TLS record...\r\n");
-   TRACE_DEBUG_ARRAY("  ", record, length + sizeof(TlsRecord));
+   TRACE_DEBUG_ARRAY("  ", data, length);
 
    //Protect record payload?
    if(context->changeCipherSpecSent)
@@ -317,7 +445,7 @@ error_t tlsWriteRecord(TlsContext *context,
          {
             //SSL 3.0 uses an older obsolete version of the HMAC construction
             error = sslComputeMac(context, context->writeMacKey,
-               context->writeSeqNum, record, record->data, length, record->data + length);
+               context->writeSeqNum, record, data, length, data + length);
             //Any error to report?
             if(error) return error;
          }
@@ -327,14 +455,15 @@ error_t tlsWriteRecord(TlsContext *context,
          //Check whether TLS 1.0, TLS 1.1 or TLS 1.2 is currently used
          if(context->version >= TLS_VERSION_1_0)
          {
-            //TLS uses a HMAC construction
-            hmacInit(&context->hmacContext, context->hashAlgo,
-               context->writeMacKey, context->macKeyLength);
+            //TLS uses a HMAC construction. The padded MAC key has already
+            //been digested when the context was keyed
+            hmacReset(context->writeHmacContext);
             //Compute MAC over the sequence number and the record contents
-            hmacUpdate(&context->hmacContext, context->writeSeqNum, sizeof(TlsSequenceNumber));
-            hmacUpdate(&context->hmacContext, record, length + sizeof(TlsRecord));
+            hmacUpdate(context->writeHmacContext, context->writeSeqNum, sizeof(TlsSequenceNumber));
+            hmacUpdate(context->writeHmacContext, record, sizeof(TlsRecord));
+            hmacUpdate(context->writeHmacContext, data, length);
             //Append the resulting MAC to the message
-            hmacFinal(&context->hmacContext, record->data + length);
+            hmacFinal(context->writeHmacContext, data + length);
          }
          else
 #endif
@@ -348,7 +477,7 @@ error_t tlsWriteRecord(TlsContext *context,
          TRACE_DEBUG("Write sequence number:\r\n");
          TRACE_DEBUG_ARRAY("  ", context->writeSeqNum, sizeof(TlsSequenceNumber));
          TRACE_DEBUG("Computed MAC:\r\n");
-         TRACE_DEBUG_ARRAY("  ", record->data + length, context->hashAlgo->digestSize);
+         TRACE_DEBUG_ARRAY("  ", data + length, context->hashAlgo->digestSize);
 
          //Adjust the length of the message
          length += context->hashAlgo->digestSize;
@@ -383,10 +512,8 @@ error_t tlsWriteRecord(TlsContext *context,
             //TLS 1.1 and 1.2 use an explicit IV
             if(context->version >= TLS_VERSION_1_1)
             {
-               //Make room for the IV at the beginning of the data
-               memmove(record->data + context->recordIvLength, record->data, length);
-
-               //The initialization vector should be chosen at random
+               //The initialization vector should be chosen at random. Room
+               //has already been reserved at the beginning of the data
                error = context->prngAlgo->read(context->prngContext,
                   record->data, context->recordIvLength);
                //Any error to report?
@@ -429,7 +556,6 @@ error_t tlsWriteRecord(TlsContext *context,
          if(context->cipherMode == CIPHER_MODE_CCM ||
             context->cipherMode == CIPHER_MODE_GCM)
          {
-            uint8_t *data;
             uint8_t *tag;
             size_t nonceLength;
             uint8_t nonce[12];
@@ -446,17 +572,14 @@ error_t tlsWriteRecord(TlsContext *context,
             //Any error to report?
             if(error) return error;
 
-            //Make room for the explicit nonce at the beginning of the record
-            memmove(record->data + context->recordIvLength, record->data, length);
-            //The explicit part of the nonce is carried in each TLS record
+            //The explicit part of the nonce is carried in each TLS record. Room
+            //has already been reserved at the beginning of the record
             memcpy(record->data, nonce + context->fixedIvLength, context->recordIvLength);
 
             //Additional data to be authenticated
             memcpy(a, context->writeSeqNum, sizeof(TlsSequenceNumber));
             memcpy(a + sizeof(TlsSequenceNumber), record, sizeof(TlsRecord));
 
-            //Plaintext data
-            data = record->data + context->recordIvLength;
             //Buffer where to store the authentication tag
             tag = data + length;
 
@@ -475,7 +598,7 @@ error_t tlsWriteRecord(TlsContext *context,
             if(context->cipherMode == CIPHER_MODE_GCM)
             {
                //Authenticated encryption using GCM
-               error = gcmEncrypt(context->cipherAlgo, context->writeCipherContext,
+               error = gcmEncrypt(context->writeGcmContext,
                   nonce, nonceLength, a, 13, data, data, length, tag, context->authTagLength);
             }
             else
@@ -498,6 +621,44 @@ error_t tlsWriteRecord(TlsContext *context,
             tlsIncSequenceNumber(context->writeSeqNum);
          }
          else
+#endif
+#if (TLS_CHACHA20_POLY1305_SUPPORT == ENABLED)
+         //ChaCha20Poly1305 AEAD cipher?
+         if(context->cipherMode == CIPHER_MODE_CHACHA20_POLY1305)
+         {
+            uint8_t *tag;
+            uint8_t nonce[12];
+            uint8_t a[13];
+
+            //The 64-bit record sequence number is padded on the left by four
+            //zero bytes and XORed with the 96-bit write IV (refer to RFC 7905)
+            memcpy(nonce, context->writeIv, 12);
+
+            for(i = 0; i < sizeof(TlsSequenceNumber); i++)
+               nonce[4 + i] ^= context->writeSeqNum[i];
+
+            //Additional data to be authenticated
+            memcpy(a, context->writeSeqNum, sizeof(TlsSequenceNumber));
+            memcpy(a + sizeof(TlsSequenceNumber), record, sizeof(TlsRecord));
+
+            //No explicit nonce is carried in the record
+            tag = record->data + length;
+
+            //Authenticated encryption using ChaCha20Poly1305
+            error = chacha20Poly1305Encrypt(context->writeEncKey, context->encKeyLength,
+               nonce, 12, a, 13, record->data, record->data, length, tag, context->authTagLength);
+            //Failed to encrypt data?
+            if(error) return error;
+
+            //Compute the length of the resulting message
+            length += context->authTagLength;
+            //Fix length field
+            record->length = htons(length);
+
+            //Increment sequence number
+            tlsIncSequenceNumber(context->writeSeqNum);
+         }
+         else
 #endif
          //Invalid cipher mode?
          {
@@ -513,34 +674,162 @@ error_t tlsWriteRecord(TlsContext *context,
 
    //Compute the length of the complete TLS record
    length += sizeof(TlsRecord);
-   //Send TLS record
-   return tlsIoWrite(context, record, length);
+
+   //The protected record is ready to be sent
+   context->txRecordIndex = 0;
+   context->txRecordLength = length;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Get the number of bytes inserted before the data of outgoing records
+ *
+ * TLS 1.1 and 1.2 CBC ciphers and CCM/GCM AEAD ciphers carry an explicit IV
+ * in front of the record data. Writing the data after this headroom avoids
+ * moving it once the record is protected
+ *
+ * @param[in] context Pointer to the TLS context
+ * @return Length of the explicit IV, in bytes
+ **/
+
+size_t tlsGetRecordHeadroom(TlsContext *context)
+{
+   //Outgoing records are not protected yet?
+   if(!context->changeCipherSpecSent || !context->cipherAlgo)
+      return 0;
+
+#if (TLS_CBC_CIPHER_SUPPORT == ENABLED)
+#if (TLS_MAX_VERSION >= TLS_VERSION_1_1 && TLS_MIN_VERSION <= TLS_VERSION_1_2)
+   //TLS 1.1 and 1.2 use an explicit IV
+   if(context->cipherMode == CIPHER_MODE_CBC && context->version >= TLS_VERSION_1_1)
+      return context->recordIvLength;
+#endif
+#endif
+
+#if (TLS_CCM_CIPHER_SUPPORT == ENABLED || TLS_GCM_CIPHER_SUPPORT == ENABLED)
+   //The explicit part of the nonce is carried in each record
+   if(context->cipherMode == CIPHER_MODE_CCM || context->cipherMode == CIPHER_MODE_GCM)
+      return context->recordIvLength;
+#endif
+
+   //No headroom is required
+   return 0;
+}
+
+
+/**
+ * @brief Determine how much application data the next record should carry
+ *
+ * With dynamic record sizing, each record fits in a single TCP segment
+ * until TLS_SMALL_RECORD_THRESHOLD bytes have been sent, and again after
+ * the connection has been idle for TLS_RECORD_IDLE_TIMEOUT milliseconds
+ *
+ * @param[in] context Pointer to the TLS context
+ * @return Maximum length of the record data
+ **/
+
+size_t tlsGetWriteRecordLength(TlsContext *context)
+{
+   size_t n;
+#if (TLS_BSD_SOCKET_SUPPORT == DISABLED)
+   size_t k;
+#endif
+
+   //Full-size records
+   n = min(TLS_MAX_PROTOCOL_DATA_LENGTH, context->maxFragLength);
+
+   //Dynamic record sizing disabled?
+   if(!context->dynamicRecordSizing)
+      return n;
+
+   //The connection has been idle for a while?
+   if(timeCompare(osGetTickCount(), context->txTimestamp + TLS_RECORD_IDLE_TIMEOUT) >= 0)
+   {
+      //The congestion window has probably collapsed
+      context->txBurstLength = 0;
+   }
+
+   //Enough data sent to switch to full-size records?
+   if(context->txBurstLength >= TLS_SMALL_RECORD_THRESHOLD)
+      return n;
+
+#if (TLS_BSD_SOCKET_SUPPORT == ENABLED)
+   //The MSS is not available through the BSD socket API
+   n = min(n, TLS_SMALL_RECORD_LENGTH);
+#else
+   //Overhead of the record header and of the explicit IV
+   k = sizeof(TlsRecord) + tlsGetRecordHeadroom(context);
+
+   //Overhead of the record protection
+   if(context->hashAlgo != NULL)
+      k += context->hashAlgo->digestSize;
+   if(context->cipherMode == CIPHER_MODE_CBC)
+      k += context->cipherAlgo->blockSize;
+
+   k += context->authTagLength;
+
+   //Each record should fit in a single TCP segment
+   if(context->socket->mss > (k + 256))
+      n = min(n, context->socket->mss - k);
+   else
+      n = min(n, TLS_SMALL_RECORD_LENGTH);
+#endif
+
+   //Return the length of the record data
+   return n;
 }
 
 
 /**
  * @brief Read a TLS record from the underlying socket
+ *
+ * The receive buffer is only allocated once the record header has been
+ * received, so that a connection waiting for data does not hold it.
+ * The record is decrypted in place, hence the plaintext may start a few
+ * bytes past the specified offset (explicit IV)
+ *
  * @param[in] context Pointer to the TLS context
- * @param[out] data Buffer where to store the record data
- * @param[in] size Maximum acceptable size for the incoming record
+ * @param[in] offset Offset in the receive buffer where to store the record data
+ * @param[out] start Offset in the receive buffer where the plaintext starts
  * @param[out] length Actual length of the record data
  * @param[out] contentType Record type
  * @return Error code
  **/
 
-error_t tlsReadRecord(TlsContext *context, uint8_t *data,
-   size_t size, size_t *length, TlsContentType *contentType)
+error_t tlsReadRecord(TlsContext *context, size_t offset,
+   size_t *start, size_t *length, TlsContentType *contentType)
 {
    error_t error;
    size_t i;
+   size_t k;
+   size_t m;
    size_t n;
    size_t paddingLength;
+   uint8_t *data;
    TlsRecord record;
 
-   //Read TLS record header
-   error = tlsIoRead(context, &record, sizeof(TlsRecord));
-   //Any error to report?
-   if(error) return error;
+   //Part of the header may have been read along with the previous record,
+   //or by a previous call that could not complete (non-blocking mode)
+   if(context->rxRecordLength < sizeof(TlsRecord))
+   {
+      //Number of header bytes still missing
+      m = sizeof(TlsRecord) - context->rxRecordLength;
+
+      //Read the remaining part of the TLS record header
+      error = tlsIoReadAhead(context, (uint8_t *) &context->rxRecord +
+         context->rxRecordLength, m, m, &k);
+
+      //Number of header bytes read so far
+      context->rxRecordLength += k;
+      //Any error to report?
+      if(error) return error;
+   }
+
+   //Retrieve the TLS record header
+   record = context->rxRecord;
 
    //Debug message
    TRACE_DEBUG("Record header:\r\n");
@@ -558,14 +847,43 @@ error_t tlsReadRecord(TlsContext *context, uint8_t *data,
    //Convert the length field to host byte order
    n = ntohs(record.length);
 
+   //Make sure a receive buffer is available
+   error = tlsAllocRxBuffer(context);
+   //Any error to report?
+   if(error) return error;
+
    //Make sure that the buffer is large enough to hold the entire record
-   if(n > size)
+   if(n > (context->rxBufferSize - offset))
       return ERROR_RECORD_OVERFLOW;
 
-   //Read record contents
-   error = tlsIoRead(context, data, n);
-   //Any error to report?
-   if(error) return error;
+   //Point to the buffer where to store the record data
+   data = context->rxBuffer + offset;
+
+   //Enough room to read ahead the header of the next record?
+   if((context->rxBufferSize - offset - n) >= sizeof(TlsRecord))
+      m = n + sizeof(TlsRecord);
+   else
+      m = n;
+
+   //Read the remaining part of the record contents, along with
+   //the next header if already available
+   if(context->rxRecordPos < n)
+   {
+      error = tlsIoReadAhead(context, data + context->rxRecordPos,
+         n - context->rxRecordPos, m - context->rxRecordPos, &k);
+
+      //Number of bytes read so far
+      context->rxRecordPos += k;
+      //Any error to report?
+      if(error) return error;
+   }
+
+   //Save the bytes that belong to the next record
+   context->rxRecordLength = context->rxRecordPos - n;
+   memcpy(&context->rxRecord, data + n, context->rxRecordLength);
+
+   //The record has been entirely received
+   context->rxRecordPos = 0;
 
    //Record payload is protected?
    if(context->changeCipherSpecReceived)
@@ -593,20 +911,12 @@ error_t tlsReadRecord(TlsContext *context, uint8_t *data,
          //CBC block cipher?
          if(context->cipherMode == CIPHER_MODE_CBC)
          {
+            uint8_t *iv;
+
             //The length of the data must be a multiple of the block size
             if((n % context->cipherAlgo->blockSize) != 0)
                return ERROR_DECODING_FAILED;
 
-            //CBC decryption
-            error = cbcDecrypt(context->cipherAlgo,
-               context->readCipherContext, context->readIv, data, data, n);
-            //Any error to report?
-            if(error) return error;
-
-            //Debug message
-            TRACE_DEBUG("Decrypted record (%u bytes):\r\n", n);
-            TRACE_DEBUG_ARRAY("  ", data, n);
-
 #if (TLS_MAX_VERSION >= TLS_VERSION_1_1 && TLS_MIN_VERSION <= TLS_VERSION_1_2)
             //TLS 1.1 and 1.2 use an explicit IV
             if(context->version >= TLS_VERSION_1_1)
@@ -615,12 +925,31 @@ error_t tlsReadRecord(TlsContext *context, uint8_t *data,
                if(n < context->recordIvLength)
                   return ERROR_DECODING_FAILED;
 
+               //The first cipher block is the IV used to decrypt the record
+               iv = data;
+
+               //Skip the explicit IV rather than decrypting it and
+               //moving the plaintext afterwards
+               data += context->recordIvLength;
                //Adjust the length of the message
                n -= context->recordIvLength;
-               //Discard the first cipher block (corresponding to the explicit IV)
-               memmove(data, data + context->recordIvLength, n);
             }
+            else
 #endif
+            {
+               //SSL 3.0 and TLS 1.0 chain the IV from the previous record
+               iv = context->readIv;
+            }
+
+            //CBC decryption
+            error = cbcDecrypt(context->cipherAlgo,
+               context->readCipherContext, iv, data, data, n);
+            //Any error to report?
+            if(error) return error;
+
+            //Debug message
+            TRACE_DEBUG("Decrypted record (%u bytes):\r\n", n);
+            TRACE_DEBUG_ARRAY("  ", data, n);
             //Make sure the message length is acceptable
             if(n < context->cipherAlgo->blockSize)
                return ERROR_DECODING_FAILED;
@@ -700,7 +1029,7 @@ error_t tlsReadRecord(TlsContext *context, uint8_t *data,
             if(context->cipherMode == CIPHER_MODE_GCM)
             {
                //Decryption and verification (using GCM)
-               error = gcmDecrypt(context->cipherAlgo, context->readCipherContext, nonce,
+               error = gcmDecrypt(context->readGcmContext, nonce,
                   nonceLength, a, 13, ciphertext, ciphertext, n, tag, context->authTagLength);
             }
             else
@@ -714,8 +1043,54 @@ error_t tlsReadRecord(TlsContext *context, uint8_t *data,
             //Wrong authentication tag?
             if(error) return ERROR_BAD_RECORD_MAC;
 
-            //Discard the explicit part of the nonce
-            memmove(data, data + context->recordIvLength, n);
+            //The plaintext follows the explicit part of the nonce
+            data = ciphertext;
+
+            //Debug message
+            TRACE_DEBUG("Decrypted record (%u bytes):\r\n", n);
+            TRACE_DEBUG_ARRAY("  ", data, n);
+
+            //Increment sequence number
+            tlsIncSequenceNumber(context->readSeqNum);
+         }
+         else
+#endif
+#if (TLS_CHACHA20_POLY1305_SUPPORT == ENABLED)
+         //ChaCha20Poly1305 AEAD cipher?
+         if(context->cipherMode == CIPHER_MODE_CHACHA20_POLY1305)
+         {
+            uint8_t *tag;
+            uint8_t nonce[12];
+            uint8_t a[13];
+
+            //Make sure the message length is acceptable
+            if(n < context->authTagLength)
+               return ERROR_DECODING_FAILED;
+
+            //The 64-bit record sequence number is padded on the left by four
+            //zero bytes and XORed with the 96-bit read IV (refer to RFC 7905)
+            memcpy(nonce, context->readIv, 12);
+
+            for(i = 0; i < sizeof(TlsSequenceNumber); i++)
+               nonce[4 + i] ^= context->readSeqNum[i];
+
+            //Calculate the length of the ciphertext
+            n -= context->authTagLength;
+            //Fix the length field of the TLS record
+            record.length = htons(n);
+
+            //Additional data to be authenticated
+            memcpy(a, context->readSeqNum, sizeof(TlsSequenceNumber));
+            memcpy(a + sizeof(TlsSequenceNumber), &record, sizeof(TlsRecord));
+
+            //Authentication tag
+            tag = data + n;
+
+            //Decryption and verification (using ChaCha20Poly1305)
+            error = chacha20Poly1305Decrypt(context->readEncKey, context->encKeyLength,
+               nonce, 12, a, 13, data, data, n, tag, context->authTagLength);
+            //Wrong authentication tag?
+            if(error) return ERROR_BAD_RECORD_MAC;
 
             //Debug message
             TRACE_DEBUG("Decrypted record (%u bytes):\r\n", n);
@@ -761,13 +1136,14 @@ error_t tlsReadRecord(TlsContext *context, uint8_t *data,
          //Check whether TLS 1.0, TLS 1.1 or TLS 1.2 is currently used
          if(context->version >= TLS_VERSION_1_0)
          {
-            //TLS uses a HMAC construction
-            hmacInit(&context->hmacContext, context->hashAlgo, context->readMacKey, context->macKeyLength);
+            //TLS uses a HMAC construction. The padded MAC key has already
+            //been digested when the context was keyed
+            hmacReset(context->readHmacContext);
             //Compute MAC over the sequence number and the record contents
-            hmacUpdate(&context->hmacContext, context->readSeqNum, sizeof(TlsSequenceNumber));
-            hmacUpdate(&context->hmacContext, &record, sizeof(TlsRecord));
-            hmacUpdate(&context->hmacContext, data, n);
-            hmacFinal(&context->hmacContext, NULL);
+            hmacUpdate(context->readHmacContext, context->readSeqNum, sizeof(TlsSequenceNumber));
+            hmacUpdate(context->readHmacContext, &record, sizeof(TlsRecord));
+            hmacUpdate(context->readHmacContext, data, n);
+            hmacFinal(context->readHmacContext, context->hmacContext.digest);
          }
          else
 #endif
@@ -792,6 +1168,8 @@ error_t tlsReadRecord(TlsContext *context, uint8_t *data,
       }
    }
 
+   //Offset of the record data
+   *start = data - context->rxBuffer;
    //Actual length of the record data
    *length = n;
    //Record type
@@ -42,8 +42,19 @@ error_t tlsReadProtocolData(TlsContext *context,
 error_t tlsWriteRecord(TlsContext *context,
    size_t length, TlsContentType contentType);
 
-error_t tlsReadRecord(TlsContext *context, uint8_t *data,
-   size_t size, size_t *length, TlsContentType *contentType);
+error_t tlsSendRecord(TlsContext *context,
+   size_t length, TlsContentType contentType);
+
+error_t tlsSendPendingData(TlsContext *context);
+
+error_t tlsProtectRecord(TlsContext *context,
+   size_t length, TlsContentType contentType);
+
+size_t tlsGetRecordHeadroom(TlsContext *context);
+size_t tlsGetWriteRecordLength(TlsContext *context);
+
+error_t tlsReadRecord(TlsContext *context, size_t offset,
+   size_t *start, size_t *length, TlsContentType *contentType);
 
 void tlsIncSequenceNumber(TlsSequenceNumber seqNum);
 
@@ -42,7 +42,9 @@
 #include "tls_server.h"
 #include "tls_common.h"
 #include "tls_record.h"
+#include "tls_ticket.h"
 #include "tls_cache.h"
+#include "tls_cert_store.h"
 #include "tls_misc.h"
 #include "x509.h"
 #include "pem.h"
@@ -68,11 +70,22 @@ error_t tlsServerHandshake(TlsContext *context)
 
    //The client initiates the TLS handshake by sending
    //a ClientHello message to the server
-   context->state = TLS_STATE_CLIENT_HELLO;
+   if(context->state == TLS_STATE_INIT)
+      context->state = TLS_STATE_CLIENT_HELLO;
 
-   //Wait for the handshake to complete
+   //Clear status code
+   error = NO_ERROR;
+
+   //Wait for the handshake to complete. With a non-blocking socket, the
+   //function returns ERROR_WANT_READ or ERROR_WANT_WRITE and must be
+   //called again once the socket is ready
    while(context->state != TLS_STATE_APPLICATION_DATA)
    {
+      //Records that could not be sent at once must be flushed first
+      error = tlsSendPendingData(context);
+      //The socket cannot accept more data for the moment?
+      if(error) break;
+
       //The TLS handshake is implemented as a state machine
       //representing the current location in the protocol
       switch(context->state)
@@ -110,6 +123,12 @@ error_t tlsServerHandshake(TlsContext *context)
          //end of the ServerHello and associated messages
          error = tlsSendServerHelloDone(context);
          break;
+      //Send NewSessionTicket message?
+      case TLS_STATE_NEW_SESSION_TICKET:
+         //The server issues a session ticket right before its
+         //ChangeCipherSpec message
+         error = tlsSendNewSessionTicket(context);
+         break;
       //Send ChangeCipherSpec message?
       case TLS_STATE_SERVER_CHANGE_CIPHER_SPEC:
          //The ChangeCipherSpec message is sent by the server and to notify the
@@ -156,14 +175,19 @@ error_t tlsServerHandshake(TlsContext *context)
          //Exit immediately
          break;
       }
+
+      //Successful full handshake? Resumed sessions are either already
+      //cached or carried by a ticket
+      if(context->state == TLS_STATE_APPLICATION_DATA && !context->resume)
+      {
+         //Save current session in the session cache for further reuse
+         tlsSaveToCache(context);
+      }
    }
 
-   //Successful TLS handshake?
+   //Make sure the last flight has been entirely sent
    if(!error)
-   {
-      //Save current session in the session cache for further reuse
-      tlsSaveToCache(context);
-   }
+      error = tlsSendPendingData(context);
 
    //Return status code
    return error;
@@ -183,6 +207,13 @@ error_t tlsParseClientMessage(TlsContext *context)
    void *message;
    TlsContentType contentType;
 
+#if (TLS_ASYNC_KEY_OP_SUPPORT == ENABLED)
+   //The ClientKeyExchange message has been suspended while the
+   //premaster secret was decrypted?
+   if(context->keyOpType == TLS_KEY_OP_RSA_DECRYPT)
+      return tlsResumeClientKeyExchange(context);
+#endif
+
    //A message can be fragmented across several records...
    error = tlsReadProtocolData(context, &message, &length, &contentType);
    //Any error to report?
@@ -284,9 +315,11 @@ error_t tlsParseClientMessage(TlsContext *context)
 error_t tlsSendServerHello(TlsContext *context)
 {
    error_t error;
+   size_t n;
    size_t length;
    uint8_t *p;
    TlsServerHello *message;
+   TlsExtensions *extensionList;
 
    //Get the current time
    uint32_t t = (uint32_t) osGetTime();
@@ -351,6 +384,98 @@ error_t tlsSendServerHello(TlsContext *context)
    //Adjust the length of the message
    length += sizeof(TlsCompressionMethod);
 
+   //Point to the list of extensions
+   extensionList = (TlsExtensions *) p;
+   //Total length of the extension list
+   extensionList->length = 0;
+
+#if (TLS_ECDHE_RSA_SUPPORT == ENABLED || TLS_ECDHE_ECDSA_SUPPORT == ENABLED)
+   //A server that selects an ECC cipher suite in response to a ClientHello
+   //that included the EcPointFormats extension must echo it (RFC 4492)
+   if(context->ecPointFormatsExtReceived &&
+      (context->keyExchMethod == TLS_KEY_EXCH_ECDHE_RSA ||
+      context->keyExchMethod == TLS_KEY_EXCH_ECDHE_ECDSA))
+   {
+      TlsExtension *extension;
+      TlsEcPointFormatList *ecPointFormatList;
+
+      //Add the EcPointFormats extension
+      extension = (TlsExtension *) (extensionList->value + extensionList->length);
+      //Type of the extension
+      extension->type = HTONS(TLS_EXT_EC_POINT_FORMATS);
+
+      //Only the uncompressed point format is supported
+      ecPointFormatList = (TlsEcPointFormatList *) extension->value;
+      ecPointFormatList->value[0] = TLS_EC_POINT_FORMAT_UNCOMPRESSED;
+      ecPointFormatList->length = 1;
+
+      //Fix the length of the extension
+      n = sizeof(TlsEcPointFormatList) + ecPointFormatList->length;
+      extension->length = htons(n);
+
+      //Fix the length of the extension list
+      extensionList->length += sizeof(TlsExtension) + n;
+   }
+#endif
+
+#if (TLS_TICKET_SUPPORT == ENABLED)
+   //A server that intends to issue a ticket includes an empty
+   //SessionTicket extension (RFC 5077)
+   if(context->newSessionTicket)
+   {
+      TlsExtension *extension;
+
+      //Add the SessionTicket extension
+      extension = (TlsExtension *) (extensionList->value + extensionList->length);
+      //Type of the extension
+      extension->type = HTONS(TLS_EXT_SESSION_TICKET);
+      //The extension data is empty
+      extension->length = HTONS(0);
+
+      //Fix the length of the extension list
+      extensionList->length += sizeof(TlsExtension);
+   }
+#endif
+
+#if (TLS_MAX_FRAG_LEN_SUPPORT == ENABLED)
+   //A server that accepts the MaxFragmentLength extension must echo
+   //the value requested by the client (RFC 6066)
+   if(context->maxFragLength < TLS_MAX_RECORD_LENGTH)
+   {
+      TlsExtension *extension;
+
+      //Add the MaxFragmentLength extension
+      extension = (TlsExtension *) (extensionList->value + extensionList->length);
+      //Type of the extension
+      extension->type = HTONS(TLS_EXT_MAX_FRAGMENT_LENGTH);
+
+      //Encode the maximum fragment length (2^9 = 1, 2^10 = 2, and so on)
+      for(n = TLS_MAX_FRAG_LENGTH_512; (512U << (n - 1)) < context->maxFragLength; n++);
+      //Copy the resulting value
+      extension->value[0] = (uint8_t) n;
+
+      //Fix the length of the extension
+      extension->length = HTONS(sizeof(uint8_t));
+
+      //Fix the length of the extension list
+      extensionList->length += sizeof(TlsExtension) + sizeof(uint8_t);
+   }
+#endif
+
+   //The extension list is omitted when empty
+   if(extensionList->length > 0)
+   {
+      //Total length of the extension list
+      n = extensionList->length;
+      //Convert the length of the extension list to network byte order
+      extensionList->length = htons(n);
+
+      //Advance data pointer
+      p += sizeof(TlsExtensions) + n;
+      //Adjust the length of the message
+      length += sizeof(TlsExtensions) + n;
+   }
+
    //Fix the length field
    STORE24BE(length - sizeof(TlsHandshake), message->length);
 
@@ -404,20 +529,113 @@ error_t tlsSendServerKeyExchange(TlsContext *context)
    error_t error;
    size_t length;
    size_t n;
-   uint8_t *p;
    TlsServerKeyExchange *message;
 
+   //The ServerKeyExchange message is not used with RSA key exchange
+   if(context->keyExchMethod == TLS_KEY_EXCH_RSA)
+   {
+      //Prepare to send a CertificateRequest message...
+      context->state = TLS_STATE_CERTIFICATE_REQUEST;
+      //Successful processing
+      return NO_ERROR;
+   }
+
+   //Point to the ServerKeyExchange message
+   message = (TlsServerKeyExchange *) (context->txBuffer + sizeof(TlsRecord));
+
+#if (TLS_ASYNC_KEY_OP_SUPPORT == ENABLED)
+   //The handshake has been suspended while the parameters were signed?
+   if(context->keyOpType == TLS_KEY_OP_RSA_SIGN)
+   {
+      //The key exchange parameters are still held in the TX buffer
+      length = context->keyOpLength;
+
+      //Retrieve the digitally-signed element
+      error = tlsCompleteServerKeySignature(context, message->params + length, &n);
+      //The signature is not available yet?
+      if(error) return error;
+   }
+   else
+#endif
+   {
+      //Format message header
+      message->msgType = TLS_TYPE_SERVER_KEY_EXCHANGE;
+
+      //Format the server's key exchange parameters
+      error = tlsFormatServerKeyParams(context, message->params, &length);
+      //Any error to report?
+      if(error) return error;
+
+      //For non-anonymous key exchanges, the server's key exchange
+      //parameters shall be signed
+      if(context->keyExchMethod != TLS_KEY_EXCH_DH_ANON)
+      {
+         //Append the digitally-signed element
+         error = tlsGenerateServerKeySignature(context, message->params + length,
+            message->params, length, &n);
+
+#if (TLS_ASYNC_KEY_OP_SUPPORT == ENABLED)
+         //The signature is generated asynchronously?
+         if(error == ERROR_WANT_KEY_OPERATION)
+            context->keyOpLength = length;
+#endif
+         //Signature generation failed?
+         if(error) return error;
+      }
+      else
+      {
+         //Anonymous key exchange
+         n = 0;
+      }
+   }
+
+   //Adjust the length of the message
+   length += n;
+
+   //Fix message header
+   STORE24BE(length, message->length);
+   //Length of the complete handshake message
+   length += sizeof(TlsHandshake);
+
+   //Debug message
+   TRACE_INFO("Sending ServerKeyExchange message (%u bytes)...\r\n", length);
+   TRACE_DEBUG_ARRAY("  ", message, length);
+
+   //Send handshake message
+   error = tlsWriteProtocolData(context, length, TLS_TYPE_HANDSHAKE);
+   //Failed to send TLS record?
+   if(error) return error;
+
+   //Prepare to send a CertificateRequest message...
+   context->state = TLS_STATE_CERTIFICATE_REQUEST;
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Format the server's key exchange parameters
+ * @param[in] context Pointer to the TLS context
+ * @param[out] params Buffer where to format the parameters
+ * @param[out] length Length of the resulting parameters
+ * @return Error code
+ **/
+
+error_t tlsFormatServerKeyParams(TlsContext *context, uint8_t *params, size_t *length)
+{
+   error_t error;
+   size_t n;
+   uint8_t *p;
+
+   //Point to the server's key exchange parameters
+   p = params;
+
 #if (TLS_DHE_RSA_SUPPORT == ENABLED || TLS_DHE_DSS_SUPPORT == ENABLED || TLS_DH_ANON_SUPPORT == ENABLED)
    //Diffie-Hellman key exchange method?
    if(context->keyExchMethod == TLS_KEY_EXCH_DHE_RSA ||
       context->keyExchMethod == TLS_KEY_EXCH_DHE_DSS ||
       context->keyExchMethod == TLS_KEY_EXCH_DH_ANON)
    {
-      //Point to the ServerKeyExchange message
-      message = (TlsServerKeyExchange *) (context->txBuffer + sizeof(TlsRecord));
-      //Format message header
-      message->msgType = TLS_TYPE_SERVER_KEY_EXCHANGE;
-
       //Generate an ephemeral key pair
       error = dhGenerateKeyPair(&context->dhParameters, context->prngAlgo, context->prngContext);
       //Any error to report?
@@ -432,9 +650,6 @@ error_t tlsSendServerKeyExchange(TlsContext *context)
       TRACE_DEBUG("  Server public value:\r\n");
       TRACE_DEBUG_MPI("    ", &context->dhParameters.ya);
 
-      //Point to the server's key exchange parameters
-      p = message->params;
-
       //Encode the prime modulus to an opaque vector
       error = tlsWriteMpi(&context->dhParameters.p, p, &n);
       //Any error to report?
@@ -443,7 +658,7 @@ error_t tlsSendServerKeyExchange(TlsContext *context)
       //Advance data pointer
       p += n;
       //Initialize byte counter
-      length = n;
+      *length = n;
 
       //Encode the generator to an opaque vector
       error = tlsWriteMpi(&context->dhParameters.g, p, &n);
@@ -453,7 +668,7 @@ error_t tlsSendServerKeyExchange(TlsContext *context)
       //Advance data pointer
       p += n;
       //Adjust byte counter
-      length += n;
+      *length += n;
 
       //Encode the server's public value to an opaque vector
       error = tlsWriteMpi(&context->dhParameters.ya, p, &n);
@@ -463,262 +678,488 @@ error_t tlsSendServerKeyExchange(TlsContext *context)
       //Advance data pointer
       p += n;
       //Compute the total length of the key exchange parameters
-      length += n;
+      *length += n;
+   }
+   else
+#endif
+#if (TLS_ECDHE_RSA_SUPPORT == ENABLED || TLS_ECDHE_ECDSA_SUPPORT == ENABLED)
+   //ECDH key exchange method?
+   if(context->keyExchMethod == TLS_KEY_EXCH_ECDHE_RSA ||
+      context->keyExchMethod == TLS_KEY_EXCH_ECDHE_ECDSA)
+   {
+      //Retrieve the curve that has been selected when parsing the ClientHello
+      context->ecdhContext.curve = tlsGetCurveInfo(context->namedCurve);
+      //Curve not supported?
+      if(context->ecdhContext.curve == NULL)
+         return ERROR_UNSUPPORTED_ELLIPTIC_CURVE;
 
-#if (TLS_DHE_RSA_SUPPORT == ENABLED || TLS_DHE_DSS_SUPPORT == ENABLED)
-      //For non-anonymous Diffie-Hellman key exchanges, the signature
-      //over the server's key exchange parameters shall be verified
+      //Generate an ephemeral key pair
+      error = ecdhGenerateKeyPair(&context->ecdhContext, context->prngAlgo, context->prngContext);
+      //Any error to report?
+      if(error) return error;
+
+      //Debug message
+      TRACE_DEBUG("ECDH parameters:\r\n");
+      TRACE_DEBUG("  Named curve: %s\r\n", context->ecdhContext.curve->name);
+      TRACE_DEBUG("  Server public point:\r\n");
+      TRACE_DEBUG_ARRAY("    ", context->ecdhContext.qa, context->ecdhContext.qaLen);
+
+      //The ECParameters structure identifies a named curve
+      p[0] = TLS_EC_CURVE_TYPE_NAMED_CURVE;
+      STORE16BE(context->namedCurve, p + 1);
+
+      //Advance data pointer
+      p += 3;
+      //Initialize byte counter
+      *length = 3;
+
+      //Encode the server's ephemeral public point to an opaque vector
+      error = tlsWriteEcPoint(context->ecdhContext.qa, context->ecdhContext.qaLen, p, &n);
+      //Any error to report?
+      if(error) return error;
+
+      //Advance data pointer
+      p += n;
+      //Compute the total length of the key exchange parameters
+      *length += n;
+   }
+   else
+#endif
+   //Invalid key exchange method?
+   {
+      //The specified key exchange method is not supported
+      return ERROR_UNSUPPORTED_KEY_EXCH_METHOD;
+   }
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Sign the server's key exchange parameters
+ * @param[in] context Pointer to the TLS context
+ * @param[out] data Buffer where to format the digitally-signed element
+ * @param[in] params Pointer to the server's key exchange parameters
+ * @param[in] paramsLength Length of the server's key exchange parameters
+ * @param[out] length Length of the resulting digitally-signed element
+ * @return Error code
+ **/
+
+error_t tlsGenerateServerKeySignature(TlsContext *context, uint8_t *data,
+   const uint8_t *params, size_t paramsLength, size_t *length)
+{
+   error_t error;
+   size_t n;
+
+#if (TLS_MAX_VERSION >= SSL_VERSION_3_0 && TLS_MIN_VERSION <= TLS_VERSION_1_1)
+   //SSL 3.0, TLS 1.0 or TLS 1.1 currently selected?
+   if(context->version <= TLS_VERSION_1_1)
+   {
+      //Point to the digitally-signed element
+      TlsDigitalSignature *signature = (TlsDigitalSignature *) data;
+
+#if (TLS_DHE_RSA_SUPPORT == ENABLED || TLS_ECDHE_RSA_SUPPORT == ENABLED)
+      //Check whether DHE_RSA or ECDHE_RSA key exchange method is currently used
       if(context->keyExchMethod == TLS_KEY_EXCH_DHE_RSA ||
-         context->keyExchMethod == TLS_KEY_EXCH_DHE_DSS)
+         context->keyExchMethod == TLS_KEY_EXCH_ECDHE_RSA)
       {
-#if (TLS_MAX_VERSION >= SSL_VERSION_3_0 && TLS_MIN_VERSION <= TLS_VERSION_1_1)
-         //SSL 3.0, TLS 1.0 or TLS 1.1 currently selected?
-         if(context->version <= TLS_VERSION_1_1)
+         Md5Context *md5Context;
+         Sha1Context *sha1Context;
+         RsaPrivateKey rsaPrivateKey;
+
+         //Allocate a memory buffer to hold the MD5 context
+         md5Context = osMemAlloc(sizeof(Md5Context));
+         //Failed to allocate memory?
+         if(!md5Context) return ERROR_OUT_OF_MEMORY;
+
+         //Compute MD5(ClientHello.random + ServerHello.random + ServerParams)
+         md5Init(md5Context);
+         md5Update(md5Context, context->random, 64);
+         md5Update(md5Context, params, paramsLength);
+         md5Final(md5Context, context->verifyData);
+         //Release previously allocated memory
+         osMemFree(md5Context);
+
+         //Allocate a memory buffer to hold the SHA-1 context
+         sha1Context = osMemAlloc(sizeof(Sha1Context));
+         //Failed to allocate memory?
+         if(!sha1Context) return ERROR_OUT_OF_MEMORY;
+
+         //Compute SHA(ClientHello.random + ServerHello.random + ServerParams)
+         sha1Init(sha1Context);
+         sha1Update(sha1Context, context->random, 64);
+         sha1Update(sha1Context, params, paramsLength);
+         sha1Final(sha1Context, context->verifyData + MD5_DIGEST_SIZE);
+         //Release previously allocated memory
+         osMemFree(sha1Context);
+
+#if (TLS_ASYNC_KEY_OP_SUPPORT == ENABLED)
+         //Private-key operations are offloaded?
+         if(context->keyOpStartCallback != NULL)
+         {
+            //The handshake is suspended until the signature is available
+            error = tlsStartKeyOp(context, TLS_KEY_OP_RSA_SIGN, NULL,
+               context->verifyData, MD5_DIGEST_SIZE + SHA1_DIGEST_SIZE);
+         }
+         else
+#endif
          {
-            //Point to the digitally-signed element
-            TlsDigitalSignature *signature = (TlsDigitalSignature *) p;
+            //Initialize RSA private key
+            rsaInitPrivateKey(&rsaPrivateKey);
 
-#if (TLS_DHE_RSA_SUPPORT == ENABLED)
-            //Check whether DHE_RSA key exchange method is currently used
-            if(context->keyExchMethod == TLS_KEY_EXCH_DHE_RSA)
-            {
-               Md5Context *md5Context;
-               Sha1Context *sha1Context;
-               RsaPrivateKey rsaPrivateKey;
-
-               //Allocate a memory buffer to hold the MD5 context
-               md5Context = osMemAlloc(sizeof(Md5Context));
-               //Failed to allocate memory?
-               if(!md5Context) return ERROR_OUT_OF_MEMORY;
-
-               //Compute MD5(ClientHello.random + ServerHello.random + ServerDhParams)
-               md5Init(md5Context);
-               md5Update(md5Context, context->random, 64);
-               md5Update(md5Context, message->params, length);
-               md5Final(md5Context, context->verifyData);
-               //Release previously allocated memory
-               osMemFree(md5Context);
-
-               //Allocate a memory buffer to hold the SHA-1 context
-               sha1Context = osMemAlloc(sizeof(Sha1Context));
-               //Failed to allocate memory?
-               if(!sha1Context) return ERROR_OUT_OF_MEMORY;
-
-               //Compute SHA(ClientHello.random + ServerHello.random + ServerDhParams)
-               sha1Init(sha1Context);
-               sha1Update(sha1Context, context->random, 64);
-               sha1Update(sha1Context, message->params, length);
-               sha1Final(sha1Context, context->verifyData + MD5_DIGEST_SIZE);
-               //Release previously allocated memory
-               osMemFree(sha1Context);
-
-               //Initialize RSA private key
-               rsaInitPrivateKey(&rsaPrivateKey);
-
-               //Decode the PEM structure that holds the RSA private key
-               error = pemReadRsaPrivateKey(context->cert->privateKey,
-                  context->cert->privateKeyLength, &rsaPrivateKey);
-
-               //Check status code
-               if(!error)
-               {
-                  //Sign the key exchange parameters using RSA
-                  error = tlsGenerateRsaSignature(&rsaPrivateKey,
-                     context->verifyData, signature->value, &n);
-               }
+            //Decode the PEM structure that holds the RSA private key
+            error = pemReadRsaPrivateKey(context->cert->privateKey,
+               context->cert->privateKeyLength, &rsaPrivateKey);
 
-               //Release previously allocated resources
-               rsaFreePrivateKey(&rsaPrivateKey);
+            //Check status code
+            if(!error)
+            {
+               //Sign the key exchange parameters using RSA
+               error = tlsGenerateRsaSignature(&rsaPrivateKey,
+                  context->verifyData, signature->value, &n);
             }
-            else
+
+            //Release previously allocated resources
+            rsaFreePrivateKey(&rsaPrivateKey);
+         }
+      }
+      else
 #endif
 #if (TLS_DHE_DSS_SUPPORT == ENABLED)
-            //Check whether DHE_DSS key exchange method is currently used
-            if(context->keyExchMethod == TLS_KEY_EXCH_DHE_DSS)
-            {
-               Sha1Context *sha1Context;
-               DsaPrivateKey dsaPrivateKey;
+      //Check whether DHE_DSS key exchange method is currently used
+      if(context->keyExchMethod == TLS_KEY_EXCH_DHE_DSS)
+      {
+         Sha1Context *sha1Context;
+         DsaPrivateKey dsaPrivateKey;
 
-               //Allocate a memory buffer to hold the SHA-1 context
-               sha1Context = osMemAlloc(sizeof(Sha1Context));
-               //Failed to allocate memory?
-               if(!sha1Context) return ERROR_OUT_OF_MEMORY;
+         //Allocate a memory buffer to hold the SHA-1 context
+         sha1Context = osMemAlloc(sizeof(Sha1Context));
+         //Failed to allocate memory?
+         if(!sha1Context) return ERROR_OUT_OF_MEMORY;
 
-               //Compute SHA(ClientHello.random + ServerHello.random + ServerDhParams)
-               sha1Init(sha1Context);
-               sha1Update(sha1Context, context->random, 64);
-               sha1Update(sha1Context, message->params, length);
-               sha1Final(sha1Context, NULL);
+         //Compute SHA(ClientHello.random + ServerHello.random + ServerDhParams)
+         sha1Init(sha1Context);
+         sha1Update(sha1Context, context->random, 64);
+         sha1Update(sha1Context, params, paramsLength);
+         sha1Final(sha1Context, NULL);
 
-               //Initialize DSA private key
-               dsaInitPrivateKey(&dsaPrivateKey);
+         //Initialize DSA private key
+         dsaInitPrivateKey(&dsaPrivateKey);
 
-               //Decode the PEM structure that holds the DSA private key
-               error = pemReadDsaPrivateKey(context->cert->privateKey,
-                  context->cert->privateKeyLength, &dsaPrivateKey);
+         //Decode the PEM structure that holds the DSA private key
+         error = pemReadDsaPrivateKey(context->cert->privateKey,
+            context->cert->privateKeyLength, &dsaPrivateKey);
 
-               //Check status code
-               if(!error)
-               {
-                  //Sign the key exchange parameters using DSA
-                  error = tlsGenerateDsaSignature(context->prngAlgo, context->prngContext,
-                     &dsaPrivateKey, sha1Context->digest, SHA1_DIGEST_SIZE, signature->value, &n);
-               }
+         //Check status code
+         if(!error)
+         {
+            //Sign the key exchange parameters using DSA
+            error = tlsGenerateDsaSignature(context->prngAlgo, context->prngContext,
+               &dsaPrivateKey, sha1Context->digest, SHA1_DIGEST_SIZE, signature->value, &n);
+         }
 
-               //Release previously allocated memory
-               osMemFree(sha1Context);
-               dsaFreePrivateKey(&dsaPrivateKey);
-            }
-            else
+         //Release previously allocated memory
+         osMemFree(sha1Context);
+         dsaFreePrivateKey(&dsaPrivateKey);
+      }
+      else
 #endif
-            //Invalid signature algorithm?
-            {
-               //Report an error
-               error = ERROR_UNSUPPORTED_SIGNATURE_ALGO;
-            }
+#if (TLS_ECDHE_ECDSA_SUPPORT == ENABLED)
+      //Check whether ECDHE_ECDSA key exchange method is currently used
+      if(context->keyExchMethod == TLS_KEY_EXCH_ECDHE_ECDSA)
+      {
+         Sha1Context *sha1Context;
+         EcPrivateKey ecPrivateKey;
+
+         //Allocate a memory buffer to hold the SHA-1 context
+         sha1Context = osMemAlloc(sizeof(Sha1Context));
+         //Failed to allocate memory?
+         if(!sha1Context) return ERROR_OUT_OF_MEMORY;
+
+         //Compute SHA(ClientHello.random + ServerHello.random + ServerECDHParams)
+         sha1Init(sha1Context);
+         sha1Update(sha1Context, context->random, 64);
+         sha1Update(sha1Context, params, paramsLength);
+         sha1Final(sha1Context, NULL);
 
-            //Signature generation failed?
-            if(error) return error;
+         //Initialize EC private key
+         ecInitPrivateKey(&ecPrivateKey);
 
-            //Fix the length of the digitally-signed element
-            signature->length = htons(n);
-            //Adjust the length of the message
-            length += sizeof(TlsDigitalSignature) + n;
+         //Decode the PEM structure that holds the EC private key
+         error = pemReadEcPrivateKey(context->cert->privateKey,
+            context->cert->privateKeyLength, &ecPrivateKey);
+
+         //Check status code
+         if(!error)
+         {
+            //Sign the key exchange parameters using ECDSA
+            error = tlsGenerateEcdsaSignature(context->prngAlgo, context->prngContext,
+               &ecPrivateKey, sha1Context->digest, SHA1_DIGEST_SIZE, signature->value, &n);
          }
-         else
+
+         //Release previously allocated memory
+         osMemFree(sha1Context);
+         ecFreePrivateKey(&ecPrivateKey);
+      }
+      else
+#endif
+      //Invalid signature algorithm?
+      {
+         //Report an error
+         error = ERROR_UNSUPPORTED_SIGNATURE_ALGO;
+      }
+
+      //Signature generation failed?
+      if(error) return error;
+
+      //Fix the length of the digitally-signed element
+      signature->length = htons(n);
+      //Total length of the digitally-signed element
+      *length = sizeof(TlsDigitalSignature) + n;
+   }
+   else
 #endif
 #if (TLS_MAX_VERSION >= TLS_VERSION_1_2 && TLS_MIN_VERSION <= TLS_VERSION_1_2)
-         //TLS 1.2 currently selected?
-         if(context->version == TLS_VERSION_1_2)
-         {
-            const HashAlgo *hashAlgo;
-            HashContext *hashContext;
-
-            //Point to the digitally-signed element
-            TlsDigitalSignature2 *signature = (TlsDigitalSignature2 *) p;
-
-            //Retrieve the hash algorithm used for signing
-            hashAlgo = tlsGetHashAlgo(context->signHashAlgo);
-            //Hash algorithm not supported?
-            if(!hashAlgo) return ERROR_INVALID_SIGNATURE;
-
-            //Allocate a memory buffer to hold the hash context
-            hashContext = osMemAlloc(hashAlgo->contextSize);
-            //Failed to allocate memory?
-            if(!hashContext) return ERROR_OUT_OF_MEMORY;
-
-            //Compute SHA(ClientHello.random + ServerHello.random + ServerDhParams)
-            hashAlgo->init(hashContext);
-            hashAlgo->update(hashContext, context->random, 64);
-            hashAlgo->update(hashContext, message->params, length);
-            hashAlgo->final(hashContext, NULL);
-
-#if (TLS_DHE_RSA_SUPPORT == ENABLED)
-            //Check whether DHE_RSA key exchange method is currently used
-            if(context->keyExchMethod == TLS_KEY_EXCH_DHE_RSA)
-            {
-               RsaPrivateKey rsaPrivateKey;
+   //TLS 1.2 currently selected?
+   if(context->version == TLS_VERSION_1_2)
+   {
+      const HashAlgo *hashAlgo;
+      HashContext *hashContext;
 
-               //Set the relevant signature algorithm
-               signature->algorithm.signature = TLS_SIGN_ALGO_RSA;
-               signature->algorithm.hash = context->signHashAlgo;
+      //Point to the digitally-signed element
+      TlsDigitalSignature2 *signature = (TlsDigitalSignature2 *) data;
 
-               //Initialize RSA private key
-               rsaInitPrivateKey(&rsaPrivateKey);
+      //Retrieve the hash algorithm used for signing
+      hashAlgo = tlsGetHashAlgo(context->signHashAlgo);
+      //Hash algorithm not supported?
+      if(!hashAlgo) return ERROR_INVALID_SIGNATURE;
 
-               //Decode the PEM structure that holds the RSA private key
-               error = pemReadRsaPrivateKey(context->cert->privateKey,
-                  context->cert->privateKeyLength, &rsaPrivateKey);
+      //Allocate a memory buffer to hold the hash context
+      hashContext = osMemAlloc(hashAlgo->contextSize);
+      //Failed to allocate memory?
+      if(!hashContext) return ERROR_OUT_OF_MEMORY;
 
-               //Check status code
-               if(!error)
-               {
-                  //Use the signature algorithm defined in PKCS #1 v1.5
-                  error = rsassaPkcs1v15Sign(&rsaPrivateKey, hashAlgo,
-                     hashContext->digest, signature->value, &n);
-               }
+      //Compute H(ClientHello.random + ServerHello.random + ServerParams)
+      hashAlgo->init(hashContext);
+      hashAlgo->update(hashContext, context->random, 64);
+      hashAlgo->update(hashContext, params, paramsLength);
+      hashAlgo->final(hashContext, NULL);
+
+#if (TLS_DHE_RSA_SUPPORT == ENABLED || TLS_ECDHE_RSA_SUPPORT == ENABLED)
+      //Check whether DHE_RSA or ECDHE_RSA key exchange method is currently used
+      if(context->keyExchMethod == TLS_KEY_EXCH_DHE_RSA ||
+         context->keyExchMethod == TLS_KEY_EXCH_ECDHE_RSA)
+      {
+         RsaPrivateKey rsaPrivateKey;
+
+         //Set the relevant signature algorithm
+         signature->algorithm.signature = TLS_SIGN_ALGO_RSA;
+         signature->algorithm.hash = context->signHashAlgo;
 
-               //Release previously allocated resources
-               rsaFreePrivateKey(&rsaPrivateKey);
+#if (TLS_ASYNC_KEY_OP_SUPPORT == ENABLED)
+         //Private-key operations are offloaded?
+         if(context->keyOpStartCallback != NULL)
+         {
+            //The handshake is suspended until the signature is available
+            error = tlsStartKeyOp(context, TLS_KEY_OP_RSA_SIGN, hashAlgo,
+               hashContext->digest, hashAlgo->digestSize);
+         }
+         else
+#endif
+#if (RSA_BATCH_SUPPORT == ENABLED)
+         //Shared RSA batch context?
+         if(context->rsaBatchContext != NULL)
+         {
+            //The signature is processed together with the pending
+            //operations of the other connections
+            error = rsaBatchSign(context->rsaBatchContext, hashAlgo,
+               hashContext->digest, signature->value, &n);
+         }
+         else
+#endif
+         {
+            //Initialize RSA private key
+            rsaInitPrivateKey(&rsaPrivateKey);
+
+            //Decode the PEM structure that holds the RSA private key
+            error = pemReadRsaPrivateKey(context->cert->privateKey,
+               context->cert->privateKeyLength, &rsaPrivateKey);
+
+            //Check status code
+            if(!error)
+            {
+               //Use the signature algorithm defined in PKCS #1 v1.5
+               error = rsassaPkcs1v15Sign(&rsaPrivateKey, hashAlgo,
+                  hashContext->digest, signature->value, &n);
             }
-            else
+
+            //Release previously allocated resources
+            rsaFreePrivateKey(&rsaPrivateKey);
+         }
+      }
+      else
 #endif
 #if (TLS_DHE_DSS_SUPPORT == ENABLED)
-            //Check whether DHE_DSS key exchange method is currently used
-            if(context->keyExchMethod == TLS_KEY_EXCH_DHE_DSS)
-            {
-               DsaPrivateKey dsaPrivateKey;
+      //Check whether DHE_DSS key exchange method is currently used
+      if(context->keyExchMethod == TLS_KEY_EXCH_DHE_DSS)
+      {
+         DsaPrivateKey dsaPrivateKey;
 
-               //Set the relevant signature algorithm
-               signature->algorithm.signature = TLS_SIGN_ALGO_DSA;
-               signature->algorithm.hash = context->signHashAlgo;
+         //Set the relevant signature algorithm
+         signature->algorithm.signature = TLS_SIGN_ALGO_DSA;
+         signature->algorithm.hash = context->signHashAlgo;
 
-               //Initialize DSA private key
-               dsaInitPrivateKey(&dsaPrivateKey);
+         //Initialize DSA private key
+         dsaInitPrivateKey(&dsaPrivateKey);
 
-               //Decode the PEM structure that holds the DSA private key
-               error = pemReadDsaPrivateKey(context->cert->privateKey,
-                  context->cert->privateKeyLength, &dsaPrivateKey);
+         //Decode the PEM structure that holds the DSA private key
+         error = pemReadDsaPrivateKey(context->cert->privateKey,
+            context->cert->privateKeyLength, &dsaPrivateKey);
 
-               //Check status code
-               if(!error)
-               {
-                  //Sign the key exchange parameters using DSA
-                  error = tlsGenerateDsaSignature(context->prngAlgo, context->prngContext,
-                     &dsaPrivateKey, hashContext->digest, hashAlgo->digestSize, signature->value, &n);
-               }
+         //Check status code
+         if(!error)
+         {
+            //Sign the key exchange parameters using DSA
+            error = tlsGenerateDsaSignature(context->prngAlgo, context->prngContext,
+               &dsaPrivateKey, hashContext->digest, hashAlgo->digestSize, signature->value, &n);
+         }
 
-               //Release previously allocated resources
-               dsaFreePrivateKey(&dsaPrivateKey);
-            }
-            else
+         //Release previously allocated resources
+         dsaFreePrivateKey(&dsaPrivateKey);
+      }
+      else
 #endif
-            //Invalid signature algorithm?
-            {
-               //Report an error
-               error = ERROR_UNSUPPORTED_SIGNATURE_ALGO;
-            }
+#if (TLS_ECDHE_ECDSA_SUPPORT == ENABLED)
+      //Check whether ECDHE_ECDSA key exchange method is currently used
+      if(context->keyExchMethod == TLS_KEY_EXCH_ECDHE_ECDSA)
+      {
+         EcPrivateKey ecPrivateKey;
 
-            //Release previously allocated memory
-            osMemFree(hashContext);
+         //Set the relevant signature algorithm
+         signature->algorithm.signature = TLS_SIGN_ALGO_ECDSA;
+         signature->algorithm.hash = context->signHashAlgo;
 
-            //Fix the length of the digitally-signed element
-            signature->length = htons(n);
-            //Adjust the length of the message
-            length += sizeof(TlsDigitalSignature2) + n;
-         }
-         else
-#endif
+         //Initialize EC private key
+         ecInitPrivateKey(&ecPrivateKey);
+
+         //Decode the PEM structure that holds the EC private key
+         error = pemReadEcPrivateKey(context->cert->privateKey,
+            context->cert->privateKeyLength, &ecPrivateKey);
+
+         //Check status code
+         if(!error)
          {
-            //The negotiated TLS version is not valid
-            error = ERROR_INVALID_VERSION;
+            //Sign the key exchange parameters using ECDSA
+            error = tlsGenerateEcdsaSignature(context->prngAlgo, context->prngContext,
+               &ecPrivateKey, hashContext->digest, hashAlgo->digestSize, signature->value, &n);
          }
+
+         //Release previously allocated resources
+         ecFreePrivateKey(&ecPrivateKey);
       }
+      else
 #endif
+      //Invalid signature algorithm?
+      {
+         //Report an error
+         error = ERROR_UNSUPPORTED_SIGNATURE_ALGO;
+      }
+
+      //Release previously allocated memory
+      osMemFree(hashContext);
 
       //Signature generation failed?
       if(error) return error;
 
-      //Fix message header
-      STORE24BE(length, message->length);
-      //Length of the complete handshake message
-      length += sizeof(TlsHandshake);
+      //Fix the length of the digitally-signed element
+      signature->length = htons(n);
+      //Total length of the digitally-signed element
+      *length = sizeof(TlsDigitalSignature2) + n;
+   }
+   else
+#endif
+   {
+      //The negotiated TLS version is not valid
+      error = ERROR_INVALID_VERSION;
+   }
 
-      //Debug message
-      TRACE_INFO("Sending ServerKeyExchange message (%u bytes)...\r\n", length);
-      TRACE_DEBUG_ARRAY("  ", message, length);
+   //Return status code
+   return error;
+}
 
-      //Send handshake message
-      error = tlsWriteProtocolData(context, length, TLS_TYPE_HANDSHAKE);
-      //Failed to send TLS record?
+
+/**
+ * @brief Retrieve the signature of the server's key exchange parameters
+ * @param[in] context Pointer to the TLS context
+ * @param[out] data Buffer where to format the digitally-signed element
+ * @param[out] length Length of the resulting digitally-signed element
+ * @return Error code
+ **/
+
+error_t tlsCompleteServerKeySignature(TlsContext *context, uint8_t *data, size_t *length)
+{
+#if (TLS_ASYNC_KEY_OP_SUPPORT == ENABLED)
+   error_t error;
+   size_t n;
+   size_t size;
+
+#if (TLS_MAX_VERSION >= SSL_VERSION_3_0 && TLS_MIN_VERSION <= TLS_VERSION_1_1)
+   //SSL 3.0, TLS 1.0 or TLS 1.1 currently selected?
+   if(context->version <= TLS_VERSION_1_1)
+   {
+      //Point to the digitally-signed element
+      TlsDigitalSignature *signature = (TlsDigitalSignature *) data;
+
+      //Room available in the TX buffer for the signature
+      size = context->txBufferSize - (signature->value - context->txBuffer);
+
+      //Retrieve the signature
+      error = tlsCompleteKeyOp(context, signature->value, size, &n);
+      //The signature is not available yet?
       if(error) return error;
+
+      //Fix the length of the digitally-signed element
+      signature->length = htons(n);
+      //Total length of the digitally-signed element
+      *length = sizeof(TlsDigitalSignature) + n;
    }
+   else
 #endif
+#if (TLS_MAX_VERSION >= TLS_VERSION_1_2 && TLS_MIN_VERSION <= TLS_VERSION_1_2)
+   //TLS 1.2 currently selected?
+   if(context->version == TLS_VERSION_1_2)
+   {
+      //Point to the digitally-signed element. The signature algorithm
+      //has already been set before the handshake was suspended
+      TlsDigitalSignature2 *signature = (TlsDigitalSignature2 *) data;
+
+      //Room available in the TX buffer for the signature
+      size = context->txBufferSize - (signature->value - context->txBuffer);
+
+      //Retrieve the signature
+      error = tlsCompleteKeyOp(context, signature->value, size, &n);
+      //The signature is not available yet?
+      if(error) return error;
+
+      //Fix the length of the digitally-signed element
+      signature->length = htons(n);
+      //Total length of the digitally-signed element
+      *length = sizeof(TlsDigitalSignature2) + n;
+   }
+   else
+#endif
+   {
+      //The negotiated TLS version is not valid
+      return ERROR_INVALID_VERSION;
+   }
 
-   //Prepare to send a CertificateRequest message...
-   context->state = TLS_STATE_CERTIFICATE_REQUEST;
    //Successful processing
    return NO_ERROR;
+#else
+   //Asynchronous private-key operations are not supported
+   return ERROR_NOT_IMPLEMENTED;
+#endif
 }
 
 
@@ -747,8 +1188,11 @@ error_t tlsSendCertificateRequest(TlsContext *context)
    X509CertificateInfo *certInfo;
    TlsCertificateRequest *message;
    TlsCertAuthorities *certAuthorities;
+#if (TLS_CERT_STORE_SUPPORT == ENABLED)
+   TlsTrustedCa *ca;
+#endif
 
-#if (TLS_RSA_SIGN_SUPPORT == ENABLED || TLS_DSA_SIGN_SUPPORT == ENABLED)
+#if (TLS_RSA_SIGN_SUPPORT == ENABLED || TLS_DSA_SIGN_SUPPORT == ENABLED || TLS_ECDSA_SIGN_SUPPORT == ENABLED)
    //A server can optionally request a certificate from the client
    if(context->clientAuthMode != TLS_CLIENT_AUTH_NONE)
    {
@@ -768,6 +1212,10 @@ error_t tlsSendCertificateRequest(TlsContext *context)
       //Certificate containing a DSA key are supported
       message->certificateTypes.value[n++] = TLS_CERT_DSS_SIGN;
 #endif
+#if (TLS_ECDSA_SIGN_SUPPORT == ENABLED)
+      //Certificate containing an EC key are supported
+      message->certificateTypes.value[n++] = TLS_CERT_ECDSA_SIGN;
+#endif
 
       //Set the length of the list
       message->certificateTypes.length = n;
@@ -819,6 +1267,27 @@ error_t tlsSendCertificateRequest(TlsContext *context)
             supportedSignAlgos->value[n].signature = TLS_SIGN_ALGO_DSA;
             supportedSignAlgos->value[n++].hash = TLS_HASH_ALGO_SHA256;
          }
+#endif
+#if (TLS_ECDSA_SIGN_SUPPORT == ENABLED)
+         //ECDSA with SHA-1 is always supported
+         supportedSignAlgos->value[n].signature = TLS_SIGN_ALGO_ECDSA;
+         supportedSignAlgos->value[n++].hash = TLS_HASH_ALGO_SHA1;
+
+         //The hash algorithm used for PRF operations can also be used for signing
+         if(context->prfHashAlgo == SHA256_HASH_ALGO)
+         {
+            //ECDSA with SHA-256 is supported
+            supportedSignAlgos->value[n].signature = TLS_SIGN_ALGO_ECDSA;
+            supportedSignAlgos->value[n++].hash = TLS_HASH_ALGO_SHA256;
+         }
+#if (TLS_SHA384_SUPPORT == ENABLED)
+         if(context->prfHashAlgo == SHA384_HASH_ALGO)
+         {
+            //ECDSA with SHA-384 is supported
+            supportedSignAlgos->value[n].signature = TLS_SIGN_ALGO_ECDSA;
+            supportedSignAlgos->value[n++].hash = TLS_HASH_ALGO_SHA384;
+         }
+#endif
 #endif
 
          //Fix the length of the list
@@ -839,56 +1308,85 @@ error_t tlsSendCertificateRequest(TlsContext *context)
       //Length of the list in bytes
       n = 0;
 
-      //Point to the first trusted CA certificate
-      pemCert = context->trustedCaList;
-      //Get the total length, in bytes, of the trusted CA list
-      pemCertLength = context->trustedCaListLength;
-
-      //DER encoded certificate
-      derCert = NULL;
-      derCertSize = 0;
-      derCertLength = 0;
-
-      //Allocate a memory buffer to store X.509 certificate info
-      certInfo = osMemAlloc(sizeof(X509CertificateInfo));
-      //Failed to allocate memory?
-      if(!certInfo) return ERROR_OUT_OF_MEMORY;
-
-      //Loop through the list of trusted CA certificates
-      while(pemCertLength > 0)
+#if (TLS_CERT_STORE_SUPPORT == ENABLED)
+      //Certificate store available?
+      if(context->certStore != NULL)
       {
-         //Decode PEM certificate
-         error = pemReadCertificate(&pemCert, &pemCertLength,
-            &derCert, &derCertSize, &derCertLength);
-         //Any error to report?
-         if(error) break;
-
-         //Parse X.509 certificate
-         error = x509ParseCertificate(derCert, derCertLength, certInfo);
-         //Failed to parse the X.509 certificate?
-         if(error) break;
-
-         //Total length of the message
-         length += certInfo->subject.rawDataLen + 2;
-
-         //Prevent the buffer from overflowing
-         if(length > TLS_MAX_PROTOCOL_DATA_LENGTH)
-            return ERROR_MESSAGE_TOO_LONG;
-
-         //Each distinguished name is preceded by a 2-byte length field
-         STORE16BE(certInfo->subject.rawDataLen, p);
-         //The distinguished name shall be DER encoded
-         memcpy(p + 2, certInfo->subject.rawData, certInfo->subject.rawDataLen);
-
-         //Advance data pointer
-         p += certInfo->subject.rawDataLen + 2;
-         //Adjust the length of the list
-         n += certInfo->subject.rawDataLen + 2;
+         //The trusted CA certificates have already been decoded
+         for(ca = context->certStore->caList; ca != NULL; ca = ca->next)
+         {
+            //Total length of the message
+            length += ca->certInfo.subject.rawDataLen + 2;
+
+            //Prevent the buffer from overflowing
+            if(length > TLS_MAX_PROTOCOL_DATA_LENGTH)
+               return ERROR_MESSAGE_TOO_LONG;
+
+            //Each distinguished name is preceded by a 2-byte length field
+            STORE16BE(ca->certInfo.subject.rawDataLen, p);
+            //The distinguished name shall be DER encoded
+            memcpy(p + 2, ca->certInfo.subject.rawData, ca->certInfo.subject.rawDataLen);
+
+            //Advance data pointer
+            p += ca->certInfo.subject.rawDataLen + 2;
+            //Adjust the length of the list
+            n += ca->certInfo.subject.rawDataLen + 2;
+         }
       }
+      else
+#endif
+      {
+         //Point to the first trusted CA certificate
+         pemCert = context->trustedCaList;
+         //Get the total length, in bytes, of the trusted CA list
+         pemCertLength = context->trustedCaListLength;
+
+         //DER encoded certificate
+         derCert = NULL;
+         derCertSize = 0;
+         derCertLength = 0;
+
+         //Allocate a memory buffer to store X.509 certificate info
+         certInfo = osMemAlloc(sizeof(X509CertificateInfo));
+         //Failed to allocate memory?
+         if(!certInfo) return ERROR_OUT_OF_MEMORY;
+
+         //Loop through the list of trusted CA certificates
+         while(pemCertLength > 0)
+         {
+            //Decode PEM certificate
+            error = pemReadCertificate(&pemCert, &pemCertLength,
+               &derCert, &derCertSize, &derCertLength);
+            //Any error to report?
+            if(error) break;
+
+            //Parse X.509 certificate
+            error = x509ParseCertificate(derCert, derCertLength, certInfo);
+            //Failed to parse the X.509 certificate?
+            if(error) break;
+
+            //Total length of the message
+            length += certInfo->subject.rawDataLen + 2;
+
+            //Prevent the buffer from overflowing
+            if(length > TLS_MAX_PROTOCOL_DATA_LENGTH)
+               return ERROR_MESSAGE_TOO_LONG;
+
+            //Each distinguished name is preceded by a 2-byte length field
+            STORE16BE(certInfo->subject.rawDataLen, p);
+            //The distinguished name shall be DER encoded
+            memcpy(p + 2, certInfo->subject.rawData, certInfo->subject.rawDataLen);
+
+            //Advance data pointer
+            p += certInfo->subject.rawDataLen + 2;
+            //Adjust the length of the list
+            n += certInfo->subject.rawDataLen + 2;
+         }
 
-      //Free previously allocated memory
-      osMemFree(derCert);
-      osMemFree(certInfo);
+         //Free previously allocated memory
+         osMemFree(derCert);
+         osMemFree(certInfo);
+      }
 
       //Fix the length of the list
       certAuthorities->length = htons(n);
@@ -961,6 +1459,67 @@ error_t tlsSendServerHelloDone(TlsContext *context)
 }
 
 
+/**
+ * @brief Send NewSessionTicket message
+ *
+ * The server sends this message before its ChangeCipherSpec message when
+ * it included the SessionTicket extension in the ServerHello. The ticket
+ * holds the encrypted session state, so that the server does not need to
+ * keep it in memory
+ *
+ * @param[in] context Pointer to the TLS context
+ * @return Error code
+ **/
+
+error_t tlsSendNewSessionTicket(TlsContext *context)
+{
+#if (TLS_TICKET_SUPPORT == ENABLED)
+   error_t error;
+   size_t n;
+   size_t length;
+   TlsNewSessionTicket *message;
+
+   //Point to the NewSessionTicket message
+   message = (TlsNewSessionTicket *) (context->txBuffer + sizeof(TlsRecord));
+   //Format message header
+   message->msgType = TLS_TYPE_NEW_SESSION_TICKET;
+
+   //The lifetime hint is expressed in seconds
+   message->ticketLifetimeHint = htonl(TLS_TICKET_LIFETIME / 1000);
+
+   //Encrypt the session state
+   error = tlsEncryptTicket(context, message->ticket, &n);
+   //Any error to report?
+   if(error) return error;
+
+   //Length of the ticket
+   message->ticketLength = htons(n);
+
+   //Length of the complete handshake message
+   length = sizeof(TlsNewSessionTicket) + n;
+   //Fix the length field
+   STORE24BE(length - sizeof(TlsHandshake), message->length);
+
+   //Debug message
+   TRACE_INFO("Sending NewSessionTicket message (%u bytes)...\r\n", length);
+   TRACE_DEBUG_ARRAY("  ", message, length);
+
+   //Send handshake message
+   error = tlsWriteProtocolData(context, length, TLS_TYPE_HANDSHAKE);
+   //Failed to send TLS record?
+   if(error) return error;
+
+   //Prepare to send ChangeCipherSpec message...
+   context->state = TLS_STATE_SERVER_CHANGE_CIPHER_SPEC;
+   //Successful processing
+   return NO_ERROR;
+#else
+   //Session tickets are not supported
+   return ERROR_UNEXPECTED_STATE;
+#endif
+}
+
+
 /**
  * @brief Parse ClientHello message
  *
@@ -985,6 +1544,7 @@ error_t tlsParseClientHello(TlsContext *context, const TlsClientHello *message,
    size_t n;
    bool_t acceptable;
    uint8_t certType;
+   TlsSignatureAlgo signAlgo;
    const uint8_t *p;
    const TlsCipherSuites *cipherSuites;
    const TlsCompressionMethods *compressionMethods;
@@ -1098,6 +1658,99 @@ error_t tlsParseClientHello(TlsContext *context, const TlsClientHello *message,
       supportedSignAlgos = NULL;
    }
 
+#if (TLS_ECDHE_RSA_SUPPORT == ENABLED || TLS_ECDHE_ECDSA_SUPPORT == ENABLED)
+   //Parse the EllipticCurves extension
+   extension = tlsGetExtension(p, n, TLS_EXT_ELLIPTIC_CURVES);
+
+   //The EllipticCurves extension was found?
+   if(extension)
+   {
+      //Point to the list of elliptic curves supported by the client
+      const TlsEllipticCurveList *ellipticCurveList = (TlsEllipticCurveList *) extension->value;
+
+      //Check the length of the list
+      if(ntohs(extension->length) < sizeof(TlsEllipticCurveList))
+         return ERROR_DECODING_FAILED;
+      if(ntohs(extension->length) < (sizeof(TlsEllipticCurveList) + ntohs(ellipticCurveList->length)))
+         return ERROR_DECODING_FAILED;
+
+      //No common curve found for the moment
+      context->namedCurve = 0;
+
+      //The curves are listed in descending order of the client's preference
+      for(i = 0; i < ntohs(ellipticCurveList->length) / 2; i++)
+      {
+         //Select the first curve that is supported by the server
+         if(tlsGetCurveInfo(ntohs(ellipticCurveList->value[i])) != NULL)
+         {
+            context->namedCurve = ntohs(ellipticCurveList->value[i]);
+            break;
+         }
+      }
+   }
+   else
+   {
+      //A client that omits the extension is assumed to support secp256r1
+      context->namedCurve = TLS_EC_CURVE_SECP256R1;
+   }
+
+   //Parse the EcPointFormats extension
+   extension = tlsGetExtension(p, n, TLS_EXT_EC_POINT_FORMATS);
+
+   //The EcPointFormats extension was found?
+   if(extension)
+   {
+      //Point to the list of point formats supported by the client
+      const TlsEcPointFormatList *ecPointFormatList = (TlsEcPointFormatList *) extension->value;
+
+      //Check the length of the list
+      if(ntohs(extension->length) < sizeof(TlsEcPointFormatList))
+         return ERROR_DECODING_FAILED;
+      if(ntohs(extension->length) < (sizeof(TlsEcPointFormatList) + ecPointFormatList->length))
+         return ERROR_DECODING_FAILED;
+
+      //The uncompressed point format must be supported
+      if(memchr(ecPointFormatList->value, TLS_EC_POINT_FORMAT_UNCOMPRESSED,
+         ecPointFormatList->length) == NULL)
+      {
+         //ECC cipher suites cannot be negotiated
+         context->namedCurve = 0;
+      }
+
+      //The server shall echo the extension in its ServerHello
+      context->ecPointFormatsExtReceived = TRUE;
+   }
+   else
+   {
+      //The client did not send the EcPointFormats extension
+      context->ecPointFormatsExtReceived = FALSE;
+   }
+#endif
+
+#if (TLS_MAX_FRAG_LEN_SUPPORT == ENABLED)
+   //Parse the MaxFragmentLength extension
+   extension = tlsGetExtension(p, n, TLS_EXT_MAX_FRAGMENT_LENGTH);
+
+   //The MaxFragmentLength extension was found?
+   if(extension)
+   {
+      //Check the length of the extension
+      if(ntohs(extension->length) != sizeof(uint8_t))
+         return ERROR_DECODING_FAILED;
+      //Values outside the allowed range must be rejected (RFC 6066)
+      if(extension->value[0] < TLS_MAX_FRAG_LENGTH_512 || extension->value[0] > TLS_MAX_FRAG_LENGTH_4096)
+         return ERROR_ILLEGAL_PARAMETER;
+
+      //Records are limited to 2^(8 + value) bytes
+      context->maxFragLength = 512U << (extension->value[0] - 1);
+   }
+   else
+   {
+      //Use the default maximum fragment length
+      context->maxFragLength = TLS_MAX_RECORD_LENGTH;
+   }
+#endif
+
    //Get the version the client wishes to use during this session
    context->clientVersion = ntohs(message->clientVersion);
 
@@ -1111,23 +1764,91 @@ error_t tlsParseClientHello(TlsContext *context, const TlsClientHello *message,
    //Save client random value
    context->clientRandom = message->random;
 
+   //Perform a full handshake unless a session can be resumed
+   context->resume = FALSE;
+
+#if (TLS_TICKET_SUPPORT == ENABLED)
+   //No ticket is to be issued for the moment
+   context->newSessionTicket = FALSE;
+
+   //Check whether session tickets are supported
+   if(context->ticketContext != NULL)
+   {
+      //Parse the SessionTicket extension
+      extension = tlsGetExtension(p, n, TLS_EXT_SESSION_TICKET);
+
+      //The SessionTicket extension was found?
+      if(extension)
+      {
+         //The client presented a ticket?
+         if(ntohs(extension->length) > 0)
+         {
+            TlsSession session;
+
+            //Clear session parameters
+            memset(&session, 0, sizeof(TlsSession));
+
+            //Recover the session state. A ticket that cannot be decrypted
+            //or that has expired simply leads to a full handshake
+            error = tlsDecryptTicket(context, extension->value,
+               ntohs(extension->length), &session);
+
+            //Check status code
+            if(!error)
+            {
+               //Restore session parameters
+               tlsRestoreSession(context, &session);
+               //Select the relevant cipher suite
+               error = tlsSetCipherSuite(context, session.cipherSuite);
+            }
+
+            //Valid ticket?
+            if(!error)
+            {
+               //Perform abbreviated handshake
+               context->resume = TRUE;
+            }
+
+            //Erase the master secret
+            memset(&session, 0, sizeof(TlsSession));
+         }
+
+         //A new ticket is issued whenever a full handshake is performed
+         if(!context->resume)
+            context->newSessionTicket = TRUE;
+      }
+   }
+#endif
+
 #if (TLS_SESSION_RESUME_SUPPORT == ENABLED)
+   //Session resumed by means of a ticket?
+   if(context->resume)
+   {
+      //The server must respond with the session ID sent by the client
+      memcpy(context->sessionId, message->sessionId.value, message->sessionId.length);
+      context->sessionIdLength = message->sessionId.length;
+   }
    //Check whether session caching is supported
-   if(context->cache != NULL)
+   else if(context->cache != NULL)
    {
+      TlsSession session;
+
       //If the session ID was non-empty, the server will look in
-      //its session cache for a match
-      TlsSession *session = tlsFindCache(context->cache,
-         message->sessionId.value, message->sessionId.length);
+      //its session cache for a match. The entry is copied out while
+      //the cache lock is held
+      error = tlsFindCache(context->cache, message->sessionId.value,
+         message->sessionId.length, &session);
 
       //Check wether a matching entry has been found in the cache
-      if(session != NULL)
+      if(!error)
       {
          //Restore session parameters
-         tlsRestoreSession(context, session);
+         tlsRestoreSession(context, &session);
+         //Erase the local copy of the master secret
+         memset(&session, 0, sizeof(TlsSession));
 
          //Select the relevant cipher suite
-         error = tlsSetCipherSuite(context, session->cipherSuite);
+         error = tlsSetCipherSuite(context, context->cipherSuite);
          //Any error to report?
          if(error) return error;
 
@@ -1150,10 +1871,8 @@ error_t tlsParseClientHello(TlsContext *context, const TlsClientHello *message,
    else
 #endif
    {
-      //This session cannot be resumed
+      //This session cannot be resumed using its ID
       context->sessionIdLength = 0;
-      //Perform a full handshake
-      context->resume = FALSE;
    }
 
    //Full handshake?
@@ -1169,26 +1888,49 @@ error_t tlsParseClientHello(TlsContext *context, const TlsClientHello *message,
          //Check whether the current cipher suite is supported
          error = tlsSetCipherSuite(context, ntohs(cipherSuites->value[i]));
 
+         //Successful processing?
+         if(!error)
+         {
+            //ECC cipher suites require a curve supported by both peers
+            if(context->keyExchMethod == TLS_KEY_EXCH_ECDHE_RSA ||
+               context->keyExchMethod == TLS_KEY_EXCH_ECDHE_ECDSA)
+            {
+               //No common curve?
+               if(tlsGetCurveInfo(context->namedCurve) == NULL)
+                  error = ERROR_UNSUPPORTED_ELLIPTIC_CURVE;
+            }
+         }
+
          //Successful processing?
          if(!error)
          {
             //The server requires a valid certificate whenever the agreed-upon
             //key exchange method uses certificates for authentication
             if(context->keyExchMethod == TLS_KEY_EXCH_RSA ||
-               context->keyExchMethod == TLS_KEY_EXCH_DHE_RSA)
+               context->keyExchMethod == TLS_KEY_EXCH_DHE_RSA ||
+               context->keyExchMethod == TLS_KEY_EXCH_ECDHE_RSA)
             {
-               //RSA and DHE_RSA key exchanges methods require a RSA certificate
+               //RSA, DHE_RSA and ECDHE_RSA key exchanges methods require a RSA certificate
                certType = TLS_CERT_RSA_SIGN;
+               signAlgo = TLS_SIGN_ALGO_RSA;
             }
             else if(context->keyExchMethod == TLS_KEY_EXCH_DHE_DSS)
             {
                //DHE_DSS key exchanges method requires a DSA certificate
                certType = TLS_CERT_DSS_SIGN;
+               signAlgo = TLS_SIGN_ALGO_DSA;
+            }
+            else if(context->keyExchMethod == TLS_KEY_EXCH_ECDHE_ECDSA)
+            {
+               //ECDHE_ECDSA key exchange method requires an ECDSA-capable certificate
+               certType = TLS_CERT_ECDSA_SIGN;
+               signAlgo = TLS_SIGN_ALGO_ECDSA;
             }
             else
             {
                //DH_anon key exchanges method does not require any certificate
                certType = TLS_CERT_NONE;
+               signAlgo = TLS_SIGN_ALGO_ANONYMOUS;
             }
 
             //Check whether a certificate is required
@@ -1209,9 +1951,9 @@ error_t tlsParseClientHello(TlsContext *context, const TlsClientHello *message,
                   if(acceptable)
                   {
                      //The hash algorithm to be used when generating signatures must be
-                     //one of those present in the SignatureAlgorithms extension
-                     error = tlsSelectSignHashAlgo(context,
-                        context->certs[j].signAlgo, supportedSignAlgos);
+                     //one of those present in the SignatureAlgorithms extension. The
+                     //signature algorithm is dictated by the server's own key
+                     error = tlsSelectSignHashAlgo(context, signAlgo, supportedSignAlgos);
 
                      //If all the requirements were met, the certificate can be
                      //used in conjunction with the selected cipher suite
@@ -1320,7 +2062,6 @@ error_t tlsParseClientKeyExchange(TlsContext *context, const TlsClientKeyExchang
    //RSA key exchange method?
    if(context->keyExchMethod == TLS_KEY_EXCH_RSA)
    {
-      uint16_t version;
       RsaPrivateKey rsaPrivateKey;
 
       //The RSA-encrypted premaster secret in a ClientKeyExchange is preceded by
@@ -1344,41 +2085,48 @@ error_t tlsParseClientKeyExchange(TlsContext *context, const TlsClientKeyExchang
          p += 2;
       }
 
-      //Initialize RSA private key
-      rsaInitPrivateKey(&rsaPrivateKey);
-
-      //Decode the PEM structure that holds the RSA private key
-      error = pemReadRsaPrivateKey(context->cert->privateKey,
-         context->cert->privateKeyLength, &rsaPrivateKey);
-      //Any error to report?
-      if(error) return error;
-
-      //Decrypt the premaster secret using the server private key
-      error = rsaesPkcs1v15Decrypt(&rsaPrivateKey, p, length,
-         context->premasterSecret, 48, &context->premasterSecretLength);
-
-      //Release RSA private key
-      rsaFreePrivateKey(&rsaPrivateKey);
-
-      //Retrieve the latest version supported by the client. This is used
-      //to detect version roll-back attacks
-      version = LOAD16BE(context->premasterSecret);
-
-      //The best way to avoid vulnerability to the Bleichenbacher attack is to
-      //treat incorrectly formatted messages in a manner indistinguishable from
-      //correctly formatted RSA blocks
-      if(error || context->premasterSecretLength != 48 || version != context->clientVersion)
+#if (TLS_ASYNC_KEY_OP_SUPPORT == ENABLED)
+      //Private-key operations are offloaded?
+      if(context->keyOpStartCallback != NULL)
+      {
+         //The handshake is suspended until the premaster secret is available
+         return tlsStartKeyOp(context, TLS_KEY_OP_RSA_DECRYPT, NULL, p, length);
+      }
+      else
+#endif
+#if (RSA_BATCH_SUPPORT == ENABLED)
+      //Shared RSA batch context?
+      if(context->rsaBatchContext != NULL)
+      {
+         //The decryption is processed together with the pending
+         //operations of the other connections
+         error = rsaBatchDecrypt(context->rsaBatchContext, p, length,
+            context->premasterSecret, 48, &context->premasterSecretLength);
+      }
+      else
+#endif
       {
-         //When it receives an incorrectly formatted RSA block, the server
-         //should generate a random 48-byte value and proceed using it as
-         //the premaster secret
-         error = context->prngAlgo->read(context->prngContext, context->premasterSecret, 48);
+         //Initialize RSA private key
+         rsaInitPrivateKey(&rsaPrivateKey);
+
+         //Decode the PEM structure that holds the RSA private key
+         error = pemReadRsaPrivateKey(context->cert->privateKey,
+            context->cert->privateKeyLength, &rsaPrivateKey);
          //Any error to report?
          if(error) return error;
 
-         //Fix the length of the premaster secret
-         context->premasterSecretLength = 48;
+         //Decrypt the premaster secret using the server private key
+         error = rsaesPkcs1v15Decrypt(&rsaPrivateKey, p, length,
+            context->premasterSecret, 48, &context->premasterSecretLength);
+
+         //Release RSA private key
+         rsaFreePrivateKey(&rsaPrivateKey);
       }
+
+      //Check the decrypted premaster secret
+      error = tlsCheckRsaPremasterSecret(context, error);
+      //Any error to report?
+      if(error) return error;
    }
    else
 #endif
@@ -1424,6 +2172,32 @@ error_t tlsParseClientKeyExchange(TlsContext *context, const TlsClientKeyExchang
       }
    }
    else
+#endif
+#if (TLS_ECDHE_RSA_SUPPORT == ENABLED || TLS_ECDHE_ECDSA_SUPPORT == ENABLED)
+   //ECDH key exchange method?
+   if(context->keyExchMethod == TLS_KEY_EXCH_ECDHE_RSA ||
+      context->keyExchMethod == TLS_KEY_EXCH_ECDHE_ECDSA)
+   {
+      //Read the client's ephemeral public point
+      error = tlsReadEcPoint(context->ecdhContext.qb, sizeof(context->ecdhContext.qb),
+         &context->ecdhContext.qbLen, p, length, &n);
+      //Any error to report?
+      if(error) return error;
+
+      //Verify peer's public point
+      error = ecdhCheckPublicKey(context->ecdhContext.curve,
+         context->ecdhContext.qb, context->ecdhContext.qbLen);
+      //Invalid public point?
+      if(error) return error;
+
+      //Calculate the shared secret. Unlike Diffie-Hellman, leading zero
+      //bytes are preserved (RFC 4492, section 5.10)
+      error = ecdhComputeSharedSecret(&context->ecdhContext, context->premasterSecret,
+         sizeof(context->premasterSecret), &context->premasterSecretLength);
+      //Any error to report?
+      if(error) return error;
+   }
+   else
 #endif
    //Invalid key exchange method?
    {
@@ -1447,6 +2221,90 @@ error_t tlsParseClientKeyExchange(TlsContext *context, const TlsClientKeyExchang
 }
 
 
+/**
+ * @brief Resume the processing of the ClientKeyExchange message
+ *
+ * The handshake has been suspended while the RSA-encrypted premaster
+ * secret was being decrypted by the application
+ *
+ * @param[in] context Pointer to the TLS context
+ * @return Error code
+ **/
+
+error_t tlsResumeClientKeyExchange(TlsContext *context)
+{
+#if (TLS_ASYNC_KEY_OP_SUPPORT == ENABLED && TLS_RSA_SUPPORT == ENABLED)
+   error_t error;
+
+   //Retrieve the decrypted premaster secret
+   error = tlsCompleteKeyOp(context, context->premasterSecret,
+      48, &context->premasterSecretLength);
+   //The decryption is still in progress?
+   if(error == ERROR_WANT_KEY_OPERATION)
+      return error;
+
+   //Check the decrypted premaster secret
+   error = tlsCheckRsaPremasterSecret(context, error);
+   //Any error to report?
+   if(error) return error;
+
+   //Derive session keys from the premaster secret
+   error = tlsGenerateKeys(context);
+   //Unable to generate key material?
+   if(error) return error;
+
+   //Update FSM state
+   if(context->peerCertType != TLS_CERT_NONE)
+      context->state = TLS_STATE_CERTIFICATE_VERIFY;
+   else
+      context->state = TLS_STATE_CLIENT_CHANGE_CIPHER_SPEC;
+
+   //Successful processing
+   return NO_ERROR;
+#else
+   //Asynchronous private-key operations are not supported
+   return ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
+
+/**
+ * @brief Check the premaster secret decrypted with the server's RSA key
+ * @param[in] context Pointer to the TLS context
+ * @param[in] status Status code returned by the RSA decryption
+ * @return Error code
+ **/
+
+error_t tlsCheckRsaPremasterSecret(TlsContext *context, error_t status)
+{
+   error_t error;
+   uint16_t version;
+
+   //Retrieve the latest version supported by the client. This is used
+   //to detect version roll-back attacks
+   version = LOAD16BE(context->premasterSecret);
+
+   //The best way to avoid vulnerability to the Bleichenbacher attack is to
+   //treat incorrectly formatted messages in a manner indistinguishable from
+   //correctly formatted RSA blocks
+   if(status || context->premasterSecretLength != 48 || version != context->clientVersion)
+   {
+      //When it receives an incorrectly formatted RSA block, the server
+      //should generate a random 48-byte value and proceed using it as
+      //the premaster secret
+      error = context->prngAlgo->read(context->prngContext, context->premasterSecret, 48);
+      //Any error to report?
+      if(error) return error;
+
+      //Fix the length of the premaster secret
+      context->premasterSecretLength = 48;
+   }
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
 /**
  * @brief Parse CertificateVerify message
  *
@@ -1530,6 +2388,22 @@ error_t tlsParseCertificateVerify(TlsContext *context, const TlsCertificateVerif
             SHA1_DIGEST_SIZE, signature->value, ntohs(signature->length));
       }
       else
+#endif
+#if (TLS_ECDSA_SIGN_SUPPORT == ENABLED)
+      //The client's certificate contains a valid EC public key?
+      if(context->peerCertType == TLS_CERT_ECDSA_SIGN)
+      {
+         //Digest all the handshake messages starting at ClientHello
+         error = tlsFinalizeHandshakeHash(context, SHA1_HASH_ALGO,
+            context->handshakeSha1Context, "", context->verifyData);
+         //Any error to report?
+         if(error) return error;
+
+         //Verify ECDSA signature using client's public key
+         error = tlsVerifyEcdsaSignature(&context->peerEcPublicKey, context->verifyData,
+            SHA1_DIGEST_SIZE, signature->value, ntohs(signature->length));
+      }
+      else
 #endif
       //Invalid signature algorithm?
       {
@@ -1598,6 +2472,16 @@ error_t tlsParseCertificateVerify(TlsContext *context, const TlsCertificateVerif
             hashAlgo->digestSize, signature->value, ntohs(signature->length));
       }
       else
+#endif
+#if (TLS_ECDSA_SIGN_SUPPORT == ENABLED)
+      //The client's certificate contains a valid EC public key?
+      if(signature->algorithm.signature == TLS_SIGN_ALGO_ECDSA)
+      {
+         //Verify ECDSA signature using client's public key
+         error = tlsVerifyEcdsaSignature(&context->peerEcPublicKey, context->verifyData,
+            hashAlgo->digestSize, signature->value, ntohs(signature->length));
+      }
+      else
 #endif
       //Invalid signature algorithm?
       {
@@ -1621,4 +2505,75 @@ error_t tlsParseCertificateVerify(TlsContext *context, const TlsCertificateVerif
    return error;
 }
 
+
+/**
+ * @brief Submit a private-key operation to the application
+ * @param[in] context Pointer to the TLS context
+ * @param[in] type Private-key operation
+ * @param[in] hashAlgo Hash algorithm used to compute the digest (signature only)
+ * @param[in] input RSA-encrypted premaster secret or digest to be signed
+ * @param[in] inputLength Length of the input
+ * @return ERROR_WANT_KEY_OPERATION if the operation has been queued
+ **/
+
+error_t tlsStartKeyOp(TlsContext *context, TlsKeyOpType type,
+   const HashAlgo *hashAlgo, const uint8_t *input, size_t inputLength)
+{
+#if (TLS_ASYNC_KEY_OP_SUPPORT == ENABLED)
+   error_t error;
+   TlsKeyOp op;
+
+   //Describe the private-key operation
+   op.type = type;
+   op.cert = context->cert;
+   op.hashAlgo = hashAlgo;
+   op.input = input;
+   op.inputLength = inputLength;
+
+   //Hand over the operation to the application
+   error = context->keyOpStartCallback(&op, context->keyOpParam);
+   //The operation could not be queued?
+   if(error) return error;
+
+   //Save the pending operation
+   context->keyOpType = type;
+
+   //The handshake is suspended until the result is available
+   return ERROR_WANT_KEY_OPERATION;
+#else
+   //Asynchronous private-key operations are not supported
+   return ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
+
+/**
+ * @brief Retrieve the result of a private-key operation
+ * @param[in] context Pointer to the TLS context
+ * @param[out] output Buffer where to store the result
+ * @param[in] size Size of the output buffer
+ * @param[out] length Length of the result
+ * @return ERROR_WANT_KEY_OPERATION if the operation is still in progress
+ **/
+
+error_t tlsCompleteKeyOp(TlsContext *context, uint8_t *output, size_t size, size_t *length)
+{
+#if (TLS_ASYNC_KEY_OP_SUPPORT == ENABLED)
+   error_t error;
+
+   //Poll the application for the result
+   error = context->keyOpCompleteCallback(output, size, length, context->keyOpParam);
+
+   //The operation is over, whether it succeeded or not
+   if(error != ERROR_WANT_KEY_OPERATION)
+      context->keyOpType = TLS_KEY_OP_NONE;
+
+   //Return status code
+   return error;
+#else
+   //Asynchronous private-key operations are not supported
+   return ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
 #endif
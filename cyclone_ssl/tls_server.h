@@ -38,11 +38,26 @@ error_t tlsParseClientMessage(TlsContext *context);
 
 error_t tlsSendServerHello(TlsContext *context);
 error_t tlsSendServerKeyExchange(TlsContext *context);
+error_t tlsFormatServerKeyParams(TlsContext *context, uint8_t *params, size_t *length);
+
+error_t tlsGenerateServerKeySignature(TlsContext *context, uint8_t *data,
+   const uint8_t *params, size_t paramsLength, size_t *length);
+
+error_t tlsCompleteServerKeySignature(TlsContext *context, uint8_t *data, size_t *length);
+
 error_t tlsSendCertificateRequest(TlsContext *context);
 error_t tlsSendServerHelloDone(TlsContext *context);
+error_t tlsSendNewSessionTicket(TlsContext *context);
 
 error_t tlsParseClientHello(TlsContext *context, const TlsClientHello *message, size_t length);
 error_t tlsParseClientKeyExchange(TlsContext *context, const TlsClientKeyExchange *message, size_t length);
+error_t tlsResumeClientKeyExchange(TlsContext *context);
+error_t tlsCheckRsaPremasterSecret(TlsContext *context, error_t status);
 error_t tlsParseCertificateVerify(TlsContext *context, const TlsCertificateVerify *message, size_t length);
 
+error_t tlsStartKeyOp(TlsContext *context, TlsKeyOpType type,
+   const HashAlgo *hashAlgo, const uint8_t *input, size_t inputLength);
+
+error_t tlsCompleteKeyOp(TlsContext *context, uint8_t *output, size_t size, size_t *length);
+
 #endif
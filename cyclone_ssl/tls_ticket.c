@@ -0,0 +1,372 @@
+/**
+ * @file tls_ticket.c
+ * @brief Session tickets (RFC 5077)
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneSSL Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * A session ticket carries the session state (version, cipher suite,
+ * compression method, master secret and issue time) encrypted with
+ * AES-256-GCM under a key that only the server knows. The ticket is
+ * laid out as follows:
+ *
+ * - key_name (16 bytes, authenticated but not encrypted)
+ * - IV (12 bytes)
+ * - encrypted state (57 bytes)
+ * - authentication tag (16 bytes)
+ *
+ * A new key is generated every TLS_TICKET_KEY_LIFETIME milliseconds. The
+ * previous key is kept for one more period so that outstanding tickets
+ * remain valid across a rotation. Refer to RFC 5077 for more details
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL TLS_TRACE_LEVEL
+
+//Dependencies
+#include <string.h>
+#include "tls.h"
+#include "tls_ticket.h"
+#include "debug.h"
+
+//Check SSL library configuration
+#if (TLS_SUPPORT == ENABLED && TLS_TICKET_SUPPORT == ENABLED)
+
+//Internal functions
+static error_t tlsGenerateTicketKey(TlsContext *context, TlsTicketKey *key);
+
+
+/**
+ * @brief Session ticket encryption context initialization
+ * @return Handle referencing the fully initialized context
+ **/
+
+TlsTicketContext *tlsInitTicketContext(void)
+{
+   TlsTicketContext *ticketContext;
+
+   //Allocate a memory buffer to hold the context
+   ticketContext = osMemAlloc(sizeof(TlsTicketContext));
+   //Failed to allocate memory?
+   if(ticketContext == NULL) return NULL;
+
+   //Clear memory
+   memset(ticketContext, 0, sizeof(TlsTicketContext));
+
+   //Create a mutex to prevent simultaneous access to the keys
+   ticketContext->mutex = osMutexCreate(FALSE);
+
+   //Out of ressources?
+   if(ticketContext->mutex == OS_INVALID_HANDLE)
+   {
+      //Clean up side effects
+      osMemFree(ticketContext);
+      //Report an error
+      return NULL;
+   }
+
+   //The first key is generated when the first ticket is issued
+   return ticketContext;
+}
+
+
+/**
+ * @brief Encrypt the current session state into a ticket
+ * @param[in] context Pointer to the TLS context
+ * @param[out] ticket Buffer where to store the ticket (TLS_TICKET_SIZE bytes)
+ * @param[out] length Length of the resulting ticket
+ * @return Error code
+ **/
+
+error_t tlsEncryptTicket(TlsContext *context, uint8_t *ticket, size_t *length)
+{
+   error_t error;
+   time_t time;
+   uint8_t *iv;
+   uint8_t *state;
+   TlsTicketKey *key;
+   TlsTicketContext *ticketContext;
+
+   //Point to the session ticket encryption context
+   ticketContext = context->ticketContext;
+   //Session tickets not supported?
+   if(ticketContext == NULL)
+      return ERROR_FAILURE;
+
+   //Point to the fields of the ticket
+   iv = ticket + TLS_TICKET_KEY_NAME_SIZE;
+   state = iv + TLS_TICKET_IV_SIZE;
+
+   //Each ticket is encrypted with a fresh nonce
+   error = context->prngAlgo->read(context->prngContext, iv, TLS_TICKET_IV_SIZE);
+   //Any error to report?
+   if(error) return error;
+
+   //Get current time
+   time = osGetTickCount();
+
+   //Format the session state
+   STORE16BE(context->version, state);
+   STORE16BE(context->cipherSuite, state + 2);
+   state[4] = context->compressionMethod;
+   STORE32BE((uint32_t) time, state + 5);
+   memcpy(state + 9, context->masterSecret, 48);
+
+   //Acquire exclusive access to the keys
+   osMutexAcquire(ticketContext->mutex);
+
+   //Point to the current key
+   key = &ticketContext->keys[ticketContext->index];
+
+   //Time to rotate the key?
+   if(!key->valid || (time - key->timestamp) >= TLS_TICKET_KEY_LIFETIME)
+   {
+      //The current key becomes the previous one
+      ticketContext->index ^= 1;
+      key = &ticketContext->keys[ticketContext->index];
+
+      //Generate a new key
+      error = tlsGenerateTicketKey(context, key);
+   }
+
+   //Check status code
+   if(!error)
+   {
+      //The key name tells the server which key was used
+      memcpy(ticket, key->name, TLS_TICKET_KEY_NAME_SIZE);
+
+      //Encrypt the session state. The key name is authenticated as well
+      error = gcmEncrypt(&key->gcmContext, iv, TLS_TICKET_IV_SIZE,
+         ticket, TLS_TICKET_KEY_NAME_SIZE, state, state, TLS_TICKET_STATE_SIZE,
+         state + TLS_TICKET_STATE_SIZE, TLS_TICKET_TAG_SIZE);
+   }
+
+   //Release exclusive access to the keys
+   osMutexRelease(ticketContext->mutex);
+
+   //Any error to report?
+   if(error)
+   {
+      //Do not leave the master secret in the output buffer
+      memset(state, 0, TLS_TICKET_STATE_SIZE);
+      //Report an error
+      return error;
+   }
+
+   //Return the length of the ticket
+   *length = TLS_TICKET_SIZE;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Decrypt a session ticket
+ *
+ * The ticket is accepted only if it was issued with one of the current
+ * keys, has not expired, and matches the negotiated version
+ *
+ * @param[in] context Pointer to the TLS context
+ * @param[in] ticket Pointer to the ticket
+ * @param[in] length Length of the ticket
+ * @param[out] session Session parameters recovered from the ticket
+ * @return Error code
+ **/
+
+error_t tlsDecryptTicket(TlsContext *context, const uint8_t *ticket,
+   size_t length, TlsSession *session)
+{
+   error_t error;
+   uint_t i;
+   time_t time;
+   TlsTicketKey *key;
+   TlsTicketContext *ticketContext;
+   uint8_t state[TLS_TICKET_STATE_SIZE];
+
+   //Point to the session ticket encryption context
+   ticketContext = context->ticketContext;
+   //Session tickets not supported?
+   if(ticketContext == NULL)
+      return ERROR_FAILURE;
+
+   //Tickets issued by this implementation have a fixed length
+   if(length != TLS_TICKET_SIZE)
+      return ERROR_DECRYPTION_FAILED;
+
+   //Get current time
+   time = osGetTickCount();
+
+   //Acquire exclusive access to the keys
+   osMutexAcquire(ticketContext->mutex);
+
+   //Initialize status code
+   error = ERROR_DECRYPTION_FAILED;
+
+   //Loop through the current and previous keys
+   for(i = 0; i < 2; i++)
+   {
+      //Point to the current entry
+      key = &ticketContext->keys[i];
+
+      //Skip unused keys
+      if(!key->valid)
+         continue;
+
+      //Keys are kept for two periods, then discarded
+      if((time - key->timestamp) >= (2 * TLS_TICKET_KEY_LIFETIME))
+      {
+         //Destroy the key
+         memset(key, 0, sizeof(TlsTicketKey));
+         continue;
+      }
+
+      //Check whether the key name matches
+      if(!memcmp(ticket, key->name, TLS_TICKET_KEY_NAME_SIZE))
+      {
+         //Decrypt the session state and check the authentication tag
+         error = gcmDecrypt(&key->gcmContext, ticket + TLS_TICKET_KEY_NAME_SIZE,
+            TLS_TICKET_IV_SIZE, ticket, TLS_TICKET_KEY_NAME_SIZE,
+            ticket + TLS_TICKET_KEY_NAME_SIZE + TLS_TICKET_IV_SIZE, state,
+            TLS_TICKET_STATE_SIZE, ticket + TLS_TICKET_SIZE - TLS_TICKET_TAG_SIZE,
+            TLS_TICKET_TAG_SIZE);
+         //We are done
+         break;
+      }
+   }
+
+   //Release exclusive access to the keys
+   osMutexRelease(ticketContext->mutex);
+
+   //Check status code
+   if(!error)
+   {
+      //The ticket must not outlive its lifetime
+      if((uint32_t) ((uint32_t) time - LOAD32BE(state + 5)) >= TLS_TICKET_LIFETIME)
+         error = ERROR_DECRYPTION_FAILED;
+      //The version cannot change when a session is resumed
+      else if(LOAD16BE(state) != context->version)
+         error = ERROR_DECRYPTION_FAILED;
+   }
+
+   //Check status code
+   if(!error)
+   {
+      //Recover the session parameters
+      session->cipherSuite = LOAD16BE(state + 2);
+      session->compressionMethod = state[4];
+      memcpy(session->masterSecret, state + 9, 48);
+   }
+
+   //Erase the decrypted state
+   memset(state, 0, TLS_TICKET_STATE_SIZE);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Release session ticket encryption context
+ * @param[in] ticketContext Pointer to the context to be released
+ **/
+
+void tlsFreeTicketContext(TlsTicketContext *ticketContext)
+{
+   //Invalid context?
+   if(ticketContext == NULL)
+      return;
+
+   //Release previously allocated ressources
+   osMutexClose(ticketContext->mutex);
+
+   //Clear the keys before freeing memory
+   memset(ticketContext, 0, sizeof(TlsTicketContext));
+   osMemFree(ticketContext);
+}
+
+
+/**
+ * @brief Generate a new ticket protection key
+ * @param[in] context Pointer to the TLS context
+ * @param[out] key Key to be generated
+ * @return Error code
+ **/
+
+static error_t tlsGenerateTicketKey(TlsContext *context, TlsTicketKey *key)
+{
+   error_t error;
+   uint8_t k[TLS_TICKET_KEY_SIZE];
+
+   //Destroy the key that is being replaced
+   memset(key, 0, sizeof(TlsTicketKey));
+
+   //Generate a random key name
+   error = context->prngAlgo->read(context->prngContext,
+      key->name, TLS_TICKET_KEY_NAME_SIZE);
+
+   //Check status code
+   if(!error)
+   {
+      //Generate a random key
+      error = context->prngAlgo->read(context->prngContext,
+         k, TLS_TICKET_KEY_SIZE);
+   }
+
+   //Check status code
+   if(!error)
+   {
+      //Expand the AES-256 key schedule
+      error = aesInit(&key->aesContext, k, TLS_TICKET_KEY_SIZE);
+   }
+
+   //Check status code
+   if(!error)
+   {
+      //Precompute the GCM multiplication table
+      error = gcmInit(&key->gcmContext, AES_CIPHER_ALGO, &key->aesContext);
+   }
+
+   //Check status code
+   if(!error)
+   {
+      //The key can be used from now on
+      key->timestamp = osGetTickCount();
+      key->valid = TRUE;
+   }
+   else
+   {
+      //Discard the partially generated key
+      memset(key, 0, sizeof(TlsTicketKey));
+   }
+
+   //Erase the raw key
+   memset(k, 0, TLS_TICKET_KEY_SIZE);
+
+   //Return status code
+   return error;
+}
+
+#endif
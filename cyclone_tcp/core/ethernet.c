@@ -175,7 +175,12 @@ void ethProcessFrame(NetInterface *interface, EthHeader *ethFrame, size_t length
 
    //Ensure the length of the incoming frame is valid
    if(length < ETH_MIN_FRAME_SIZE)
+   {
+      //Number of inbound frames that contained errors
+      MIB2_IF_INC_COUNTER(interface, ifInErrors, 1);
+      //Discard the received frame
       return;
+   }
 
    //Debug message
    TRACE_DEBUG("Ethernet frame received (%u bytes)...\r\n", length);
@@ -190,6 +195,8 @@ void ethProcessFrame(NetInterface *interface, EthHeader *ethFrame, size_t length
       {
          //Debug message
          TRACE_WARNING("Wrong CRC detected!\r\n");
+         //Number of inbound frames that contained errors
+         MIB2_IF_INC_COUNTER(interface, ifInErrors, 1);
          //Discard the received frame
          return;
       }
@@ -202,7 +209,21 @@ void ethProcessFrame(NetInterface *interface, EthHeader *ethFrame, size_t length
 
    //Frame filtering based on destination MAC address
    if(ethCheckDestAddr(interface, &ethFrame->destAddr))
+   {
+      //Number of inbound frames that were discarded
+      MIB2_IF_INC_COUNTER(interface, ifInDiscards, 1);
+      //Discard the received frame
       return;
+   }
+
+   //Total number of octets received on the interface
+   MIB2_IF_INC_COUNTER(interface, ifInOctets, length);
+
+   //Unicast or multicast/broadcast frame?
+   if(ethFrame->destAddr.b[0] & MAC_ADDR_FLAG_MULTICAST)
+      MIB2_IF_INC_COUNTER(interface, ifInNUcastPkts, 1);
+   else
+      MIB2_IF_INC_COUNTER(interface, ifInUcastPkts, 1);
 
    //Calculate the length of the data payload
    length -= sizeof(EthHeader) + ETH_CRC_SIZE;
@@ -239,6 +260,9 @@ void ethProcessFrame(NetInterface *interface, EthHeader *ethFrame, size_t length
    default:
       //Debug message
       TRACE_WARNING("Unknown Ethernet type!\r\n");
+      //Number of frames received via the interface which were
+      //discarded because of an unknown or unsupported protocol
+      MIB2_IF_INC_COUNTER(interface, ifInUnknownProtos, 1);
       break;
    }
 }
@@ -321,7 +345,28 @@ error_t ethSendFrame(NetInterface *interface, const MacAddr *destAddr,
    ethDumpHeader(header);
 
    //Send the resulting packet over the specified link
-   return nicSendPacket(interface, buffer, offset);
+   error = nicSendPacket(interface, buffer, offset);
+
+   //Update interface statistics
+   if(!error)
+   {
+      //Total number of octets transmitted out of the interface
+      MIB2_IF_INC_COUNTER(interface, ifOutOctets, length);
+
+      //Unicast or multicast/broadcast frame?
+      if(destAddr->b[0] & MAC_ADDR_FLAG_MULTICAST)
+         MIB2_IF_INC_COUNTER(interface, ifOutNUcastPkts, 1);
+      else
+         MIB2_IF_INC_COUNTER(interface, ifOutUcastPkts, 1);
+   }
+   else
+   {
+      //Number of outbound frames that could not be transmitted
+      MIB2_IF_INC_COUNTER(interface, ifOutErrors, 1);
+   }
+
+   //Return status code
+   return error;
 }
 
 
@@ -46,10 +46,17 @@
    #error ETH_FAST_CRC_SUPPORT parameter is invalid
 #endif
 
+//Largest MTU that can be assigned to an interface (jumbo frames)
+#ifndef ETH_MAX_MTU
+   #define ETH_MAX_MTU 1500
+#elif (ETH_MAX_MTU < 1500 || ETH_MAX_MTU > 9000)
+   #error ETH_MAX_MTU parameter is invalid
+#endif
+
 //Minimum Ethernet frame size
 #define ETH_MIN_FRAME_SIZE 64
 //Maximum Ethernet frame size
-#define ETH_MAX_FRAME_SIZE 1518
+#define ETH_MAX_FRAME_SIZE (ETH_MAX_MTU + 18)
 //Ethernet maximum transmission unit
 #define ETH_MTU 1500
 //Ethernet CRC field size
@@ -47,12 +47,12 @@ const IpAddr IP_ADDR_ANY = {0};
  * @param[in] pseudoHeader IP pseudo header
  * @param[in] buffer Multi-part buffer containing the payload
  * @param[in] offset Offset to the first payload byte
- * @param[in] timeToLive TTL value
+ * @param[in] flags TTL value and ECN codepoint (see #IpFlags)
  * @return Error code
  **/
 
 error_t ipSendDatagram(NetInterface *interface, IpPseudoHeader *pseudoHeader,
-   ChunkedBuffer *buffer, size_t offset, uint8_t timeToLive)
+   ChunkedBuffer *buffer, size_t offset, uint_t flags)
 {
    error_t error;
 
@@ -62,7 +62,7 @@ error_t ipSendDatagram(NetInterface *interface, IpPseudoHeader *pseudoHeader,
    {
       //Form an IPv4 packet and send it
       error = ipv4SendDatagram(interface, &pseudoHeader->ipv4Data,
-         buffer, offset, timeToLive);
+         buffer, offset, flags);
    }
    else
 #endif
@@ -72,7 +72,7 @@ error_t ipSendDatagram(NetInterface *interface, IpPseudoHeader *pseudoHeader,
    {
       //Form an IPv6 packet and send it
       error = ipv6SendDatagram(interface, &pseudoHeader->ipv6Data,
-         buffer, offset, timeToLive);
+         buffer, offset, flags);
    }
    else
 #endif
@@ -133,6 +133,83 @@ error_t ipSelectSourceAddr(NetInterface **interface,
 }
 
 
+/**
+ * @brief Retrieve the MTU of the path to a given destination
+ * @param[in] interface Underlying network interface
+ * @param[in] destAddr Destination IP address
+ * @return Path MTU
+ **/
+
+size_t ipGetPathMtu(NetInterface *interface, const IpAddr *destAddr)
+{
+#if (IPV4_SUPPORT == ENABLED)
+   //The destination address is an IPv4 address?
+   if(destAddr->length == sizeof(Ipv4Addr))
+   {
+      //Search the IPv4 path MTU cache
+      return ipv4GetPathMtu(interface, destAddr->ipv4Addr);
+   }
+   else
+#endif
+#if (IPV6_SUPPORT == ENABLED)
+   //The destination address is an IPv6 address?
+   if(destAddr->length == sizeof(Ipv6Addr))
+   {
+      //Search the IPv6 path MTU cache
+      return ipv6GetPathMtu(interface, &destAddr->ipv6Addr);
+   }
+   else
+#endif
+   //The destination address is not valid?
+   {
+      //Use the MTU of the first hop
+      return interface->mtu;
+   }
+}
+
+
+/**
+ * @brief Lower the path MTU estimate for a given destination
+ *
+ * Packetization layers call this function when full-sized packets keep
+ * being lost while no ICMP error is received, which suggests that the
+ * path contains a black hole (refer to RFC 4821)
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] destAddr Destination IP address
+ **/
+
+void ipReducePathMtu(NetInterface *interface, const IpAddr *destAddr)
+{
+#if (IPV4_SUPPORT == ENABLED)
+   //The destination address is an IPv4 address?
+   if(destAddr->length == sizeof(Ipv4Addr))
+   {
+      size_t pathMtu;
+
+      //Retrieve the current estimate
+      pathMtu = ipv4GetPathMtu(interface, destAddr->ipv4Addr);
+      //Step down to the next plateau
+      ipv4UpdatePathMtu(interface, destAddr->ipv4Addr, ipv4GetPlateauMtu(pathMtu));
+   }
+   else
+#endif
+#if (IPV6_SUPPORT == ENABLED)
+   //The destination address is an IPv6 address?
+   if(destAddr->length == sizeof(Ipv6Addr))
+   {
+      //Fall back to the IPv6 minimum link MTU
+      ipv6UpdatePathMtu(interface, &destAddr->ipv6Addr, IPV6_DEFAULT_MTU);
+   }
+   else
+#endif
+   //The destination address is not valid?
+   {
+      //Just for sanity
+   }
+}
+
+
 /**
  * @brief IP checksum calculation
  * @param[in] data Pointer to the data over which to calculate the IP checksum
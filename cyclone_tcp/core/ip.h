@@ -45,6 +45,36 @@ typedef enum
 } IpProtocol;
 
 
+/**
+ * @brief ECN codepoints (refer to RFC 3168)
+ **/
+
+typedef enum
+{
+   IP_ECN_NOT_ECT = 0,
+   IP_ECN_ECT_1   = 1,
+   IP_ECN_ECT_0   = 2,
+   IP_ECN_CE      = 3
+} IpEcnCodepoint;
+
+
+/**
+ * @brief Flags used by IP send functions
+ *
+ * The lower byte holds the TTL (or Hop Limit) value and bits 8-9 hold
+ * the ECN codepoint to be written in the IP header
+ **/
+
+typedef enum
+{
+   IP_FLAG_TTL   = 0x00FF,
+   IP_FLAG_ECN   = 0x0300,
+   IP_FLAG_ECT_1 = 0x0100,
+   IP_FLAG_ECT_0 = 0x0200,
+   IP_FLAG_CE    = 0x0300
+} IpFlags;
+
+
 /**
  * @brief IP network address
  **/
@@ -89,11 +119,14 @@ extern const IpAddr IP_ADDR_ANY;
 
 //IP related functions
 error_t ipSendDatagram(NetInterface *interface, IpPseudoHeader *pseudoHeader,
-   ChunkedBuffer *buffer, size_t offset, uint8_t timeToLive);
+   ChunkedBuffer *buffer, size_t offset, uint_t flags);
 
 error_t ipSelectSourceAddr(NetInterface **interface,
    const IpAddr *destAddr, IpAddr *srcAddr);
 
+size_t ipGetPathMtu(NetInterface *interface, const IpAddr *destAddr);
+void ipReducePathMtu(NetInterface *interface, const IpAddr *destAddr);
+
 uint16_t ipCalcChecksum(const void *data, size_t length);
 uint16_t ipCalcChecksumEx(const ChunkedBuffer *buffer, size_t offset, size_t length);
 
@@ -0,0 +1,187 @@
+/**
+ * @file mib2.h
+ * @brief MIB-II style protocol statistics
+ *
+ * @section License
+ *
+ * Copyright (C) 2010-2013 Oryx Embedded. All rights reserved.
+ *
+ * This file is part of CycloneTCP Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded (www.oryx-embedded.com)
+ * @version 1.3.8
+ **/
+
+#ifndef _MIB2_H
+#define _MIB2_H
+
+//Dependencies
+#include "tcp_ip_stack.h"
+
+//MIB-II statistics support
+#ifndef MIB2_SUPPORT
+   #define MIB2_SUPPORT ENABLED
+#elif (MIB2_SUPPORT != ENABLED && MIB2_SUPPORT != DISABLED)
+   #error MIB2_SUPPORT parameter is invalid
+#endif
+
+//Macros used to update the counters
+#if (MIB2_SUPPORT == ENABLED)
+   #define MIB2_INC_COUNTER(name, value) mib2Stats.name += (value)
+   #define MIB2_IF_INC_COUNTER(interface, name, value) (interface)->ifStats.name += (value)
+#else
+   #define MIB2_INC_COUNTER(name, value)
+   #define MIB2_IF_INC_COUNTER(interface, name, value)
+#endif
+
+
+/**
+ * @brief Interface statistics (interfaces group)
+ **/
+
+typedef struct
+{
+   uint32_t ifInOctets;
+   uint32_t ifInUcastPkts;
+   uint32_t ifInNUcastPkts;
+   uint32_t ifInDiscards;
+   uint32_t ifInErrors;
+   uint32_t ifInUnknownProtos;
+   uint32_t ifOutOctets;
+   uint32_t ifOutUcastPkts;
+   uint32_t ifOutNUcastPkts;
+   uint32_t ifOutDiscards;
+   uint32_t ifOutErrors;
+} Mib2IfStats;
+
+
+/**
+ * @brief ARP statistics
+ **/
+
+typedef struct
+{
+   uint32_t arpInPkts;
+   uint32_t arpInErrors;
+   uint32_t arpInRequests;
+   uint32_t arpInReplies;
+   uint32_t arpOutRequests;
+   uint32_t arpOutReplies;
+} Mib2ArpStats;
+
+
+/**
+ * @brief IP statistics (ip group)
+ **/
+
+typedef struct
+{
+   uint32_t ipInReceives;
+   uint32_t ipInHdrErrors;
+   uint32_t ipInAddrErrors;
+   uint32_t ipInUnknownProtos;
+   uint32_t ipInDiscards;
+   uint32_t ipInDelivers;
+   uint32_t ipOutRequests;
+   uint32_t ipOutDiscards;
+   uint32_t ipOutNoRoutes;
+   uint32_t ipReasmReqds;
+   uint32_t ipReasmOKs;
+   uint32_t ipReasmFails;
+   uint32_t ipFragOKs;
+   uint32_t ipFragFails;
+   uint32_t ipFragCreates;
+} Mib2IpStats;
+
+
+/**
+ * @brief ICMP statistics (icmp group)
+ **/
+
+typedef struct
+{
+   uint32_t icmpInMsgs;
+   uint32_t icmpInErrors;
+   uint32_t icmpInDestUnreachs;
+   uint32_t icmpInPktTooBigs;
+   uint32_t icmpInEchos;
+   uint32_t icmpInEchoReps;
+   uint32_t icmpOutMsgs;
+   uint32_t icmpOutErrors;
+   uint32_t icmpOutDestUnreachs;
+   uint32_t icmpOutEchoReps;
+} Mib2IcmpStats;
+
+
+/**
+ * @brief UDP statistics (udp group)
+ **/
+
+typedef struct
+{
+   uint32_t udpInDatagrams;
+   uint32_t udpNoPorts;
+   uint32_t udpInErrors;
+   uint32_t udpOutDatagrams;
+} Mib2UdpStats;
+
+
+/**
+ * @brief TCP statistics (tcp group)
+ **/
+
+typedef struct
+{
+   uint32_t tcpActiveOpens;
+   uint32_t tcpPassiveOpens;
+   uint32_t tcpAttemptFails;
+   uint32_t tcpEstabResets;
+   uint32_t tcpInSegs;
+   uint32_t tcpOutSegs;
+   uint32_t tcpRetransSegs;
+   uint32_t tcpInErrs;
+   uint32_t tcpOutRsts;
+   uint32_t tcpRtoTimeouts;
+   uint32_t tcpDupAcks;
+   uint32_t tcpFastRetrans;
+} Mib2TcpStats;
+
+
+/**
+ * @brief System-wide protocol statistics
+ **/
+
+typedef struct
+{
+   Mib2ArpStats arp;       ///<ARP statistics
+   Mib2IpStats ipv4;       ///<IPv4 statistics
+   Mib2IcmpStats icmp;     ///<ICMP statistics
+   Mib2IpStats ipv6;       ///<IPv6 statistics
+   Mib2IcmpStats icmpv6;   ///<ICMPv6 statistics
+   Mib2UdpStats udp;       ///<UDP statistics
+   Mib2TcpStats tcp;       ///<TCP statistics
+} Mib2Stats;
+
+
+//Global variables
+extern Mib2Stats mib2Stats;
+
+//MIB-II related functions
+void mib2GetStats(Mib2Stats *stats);
+error_t mib2GetIfStats(NetInterface *interface, Mib2IfStats *stats);
+
+#endif
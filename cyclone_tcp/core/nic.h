@@ -71,6 +71,7 @@ typedef bool_t (*PhyEventHandler)(NetInterface *interface);
 
 typedef struct
 {
+   size_t mtu;
    NicInit init;
    NicTick tick;
    NicEnableIrq enableIrq;
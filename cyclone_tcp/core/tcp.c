@@ -91,11 +91,22 @@ error_t tcpConnect(Socket *socket)
    //Default retransmission timeout
    socket->rto = TCP_INITIAL_RTO;
 
+#if (TCP_ECN_SUPPORT == ENABLED)
+   //Request the use of ECN during connection setup
+   socket->ecnEnabled = TRUE;
+   socket->ecnEcho = FALSE;
+   socket->ecnCwr = FALSE;
+   socket->ecnRecover = socket->iss;
+#endif
+
    //Send a SYN segment
    error = tcpSendSegment(socket, TCP_FLAG_SYN, socket->iss, 0, 0, TRUE);
    //Failed to send TCP segment?
    if(error) return error;
 
+   //Number of direct transitions from CLOSED to SYN-SENT state
+   MIB2_INC_COUNTER(tcp.tcpActiveOpens, 1);
+
    //Switch to the SYN-SENT state
    tcpChangeState(socket, TCP_STATE_SYN_SENT);
    //Wait for the connection to be established
@@ -271,6 +282,14 @@ Socket *tcpAccept(Socket *socket, IpAddr *clientIpAddr, uint16_t *clientPort)
       //Slow start threshold should be set arbitrarily high
       newSocket->ssthresh = UINT16_MAX;
 
+#if (TCP_ECN_SUPPORT == ENABLED)
+      //Accept the use of ECN if requested by the client
+      newSocket->ecnEnabled = queueItem->ecnCapable;
+      newSocket->ecnEcho = FALSE;
+      newSocket->ecnCwr = FALSE;
+      newSocket->ecnRecover = newSocket->iss;
+#endif
+
       //Send a SYN ACK control segment
       error = tcpSendSegment(newSocket, TCP_FLAG_SYN | TCP_FLAG_ACK,
          newSocket->iss, newSocket->rcvNxt, 0, TRUE);
@@ -290,6 +309,9 @@ Socket *tcpAccept(Socket *socket, IpAddr *clientIpAddr, uint16_t *clientPort)
          continue;
       }
 
+      //Number of direct transitions from LISTEN to SYN-RECEIVED state
+      MIB2_INC_COUNTER(tcp.tcpPassiveOpens, 1);
+
       //Remove the item from the SYN queue
       socket->synQueue = queueItem->next;
       //Deallocate memory buffer
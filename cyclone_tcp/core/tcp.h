@@ -124,6 +124,13 @@
    #error TCP_MAX_RTO parameter is invalid
 #endif
 
+//Number of retransmissions after which a path MTU black hole is suspected
+#ifndef TCP_PMTU_BLACKHOLE_THRES
+   #define TCP_PMTU_BLACKHOLE_THRES 2
+#elif (TCP_PMTU_BLACKHOLE_THRES < 1)
+   #error TCP_PMTU_BLACKHOLE_THRES parameter is invalid
+#endif
+
 //Number of duplicate ACKs that triggers fast retransmit algorithm
 #ifndef TCP_FAST_RETRANSMIT_THRES
    #define TCP_FAST_RETRANSMIT_THRES 3
@@ -187,6 +194,13 @@
    #error TCP_SACK_SUPPORT parameter is invalid
 #endif
 
+//Explicit Congestion Notification support
+#ifndef TCP_ECN_SUPPORT
+   #define TCP_ECN_SUPPORT ENABLED
+#elif (TCP_ECN_SUPPORT != ENABLED && TCP_ECN_SUPPORT != DISABLED)
+   #error TCP_ECN_SUPPORT parameter is invalid
+#endif
+
 //Number of SACK blocks
 #ifndef TCP_MAX_SACK_BLOCKS
    #define TCP_MAX_SACK_BLOCKS 4
@@ -234,7 +248,9 @@ typedef enum
    TCP_FLAG_RST = 0x04,
    TCP_FLAG_PSH = 0x08,
    TCP_FLAG_ACK = 0x10,
-   TCP_FLAG_URG = 0x20
+   TCP_FLAG_URG = 0x20,
+   TCP_FLAG_ECE = 0x40,
+   TCP_FLAG_CWR = 0x80
 } TcpFlags;
 
 
@@ -272,8 +288,7 @@ typedef __packed struct
    uint32_t ackNum;        //8-11
    uint8_t reserved1 : 4;  //12
    uint8_t dataOffset : 4;
-   uint8_t flags : 6;      //13
-   uint8_t reserved2 : 2;
+   uint8_t flags;          //13
    uint16_t window;        //14-15
    uint16_t checksum;      //16-17
    uint16_t urgentPointer; //18-19
@@ -331,6 +346,7 @@ typedef struct _TcpSynQueueItem
    IpAddr destAddr;
    uint32_t isn;
    uint16_t mss;
+   bool_t ecnCapable;
 } TcpSynQueueItem;
 
 
@@ -430,6 +446,11 @@ typedef struct
    bool_t sackPermitted;                        ///<SACK Permitted option received
    TcpSackBlock sackBlock[TCP_MAX_SACK_BLOCKS]; ///<List of non-contiguous blocks that have been received
    uint_t sackBlockCount;                       ///<Number of non-contiguous blocks that have been received
+
+   bool_t ecnEnabled;             ///<ECN has been negotiated (or requested while in SYN-SENT state)
+   bool_t ecnEcho;                ///<Set the ECE flag until a segment with CWR is received
+   bool_t ecnCwr;                 ///<Set the CWR flag in the next data segment
+   uint32_t ecnRecover;           ///<Highest sequence number sent when congestion was last signaled
 } TcpControlBlock;
 
 
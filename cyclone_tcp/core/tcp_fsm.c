@@ -61,10 +61,11 @@
  * @param[in] pseudoHeader TCP pseudo header
  * @param[in] buffer Multi-part buffer that holds the incoming TCP segment
  * @param[in] offset Offset to the first byte of the TCP header
+ * @param[in] ecn ECN codepoint of the IP packet (see #IpEcnCodepoint)
  **/
 
-void tcpProcessSegment(NetInterface *interface,
-   IpPseudoHeader *pseudoHeader, const ChunkedBuffer *buffer, size_t offset)
+void tcpProcessSegment(NetInterface *interface, IpPseudoHeader *pseudoHeader,
+   const ChunkedBuffer *buffer, size_t offset, uint_t ecn)
 {
    uint_t i;
    size_t length;
@@ -101,6 +102,9 @@ void tcpProcessSegment(NetInterface *interface,
       return;
    }
 
+   //Total number of segments received
+   MIB2_INC_COUNTER(tcp.tcpInSegs, 1);
+
    //Retrieve the length of the TCP segment
    length = chunkedBufferGetLength(buffer) - offset;
 
@@ -114,6 +118,8 @@ void tcpProcessSegment(NetInterface *interface,
    {
       //Debug message
       TRACE_WARNING("TCP segment length is invalid!\r\n");
+      //Total number of segments received in error
+      MIB2_INC_COUNTER(tcp.tcpInErrs, 1);
       //Exit immediately
       return;
    }
@@ -122,6 +128,8 @@ void tcpProcessSegment(NetInterface *interface,
    {
       //Debug message
       TRACE_WARNING("TCP header length is invalid!\r\n");
+      //Total number of segments received in error
+      MIB2_INC_COUNTER(tcp.tcpInErrs, 1);
       //Exit immediately
       return;
    }
@@ -131,6 +139,8 @@ void tcpProcessSegment(NetInterface *interface,
    {
       //Debug message
       TRACE_WARNING("Wrong TCP header checksum!\r\n");
+      //Total number of segments received in error
+      MIB2_INC_COUNTER(tcp.tcpInErrs, 1);
       //Exit immediately
       return;
    }
@@ -268,6 +278,19 @@ void tcpProcessSegment(NetInterface *interface,
       return;
    }
 
+#if (TCP_ECN_SUPPORT == ENABLED)
+   //ECN-capable connection?
+   if(socket->ecnEnabled && !(segment->flags & TCP_FLAG_SYN))
+   {
+      //The sender has reduced its congestion window
+      if(segment->flags & TCP_FLAG_CWR)
+         socket->ecnEcho = FALSE;
+      //A router experienced congestion while forwarding the packet?
+      if(ecn == IP_ECN_CE)
+         socket->ecnEcho = TRUE;
+   }
+#endif
+
    //Check current state
    switch(socket->state)
    {
@@ -504,10 +527,19 @@ void tcpStateListen(Socket *socket, NetInterface *interface,
          //Debug message
          TRACE_DEBUG("Remote host MSS = %u\r\n", queueItem->mss);
          //Make sure that the MSS advertised by the peer is acceptable
-         queueItem->mss = min(queueItem->mss, TCP_MAX_MSS);
+         queueItem->mss = min(queueItem->mss, tcpGetMaxMss(interface, &queueItem->srcAddr));
          queueItem->mss = max(queueItem->mss, TCP_MIN_MSS);
       }
 
+#if (TCP_ECN_SUPPORT == ENABLED)
+      //The client requests ECN by setting both ECE and CWR flags in the SYN
+      queueItem->ecnCapable = ((segment->flags & (TCP_FLAG_ECE | TCP_FLAG_CWR)) ==
+         (TCP_FLAG_ECE | TCP_FLAG_CWR));
+#else
+      //ECN is not supported
+      queueItem->ecnCapable = FALSE;
+#endif
+
       //Notify user that a connection request is pending
       tcpUpdateEvents(socket);
 
@@ -593,7 +625,7 @@ void tcpStateSynSent(Socket *socket, TcpHeader *segment, size_t length)
          //Debug message
          TRACE_DEBUG("Remote host MSS = %u\r\n", socket->mss);
          //Make sure that the MSS advertised by the peer is acceptable
-         socket->mss = min(socket->mss, TCP_MAX_MSS);
+         socket->mss = min(socket->mss, tcpGetMaxMss(socket->interface, &socket->remoteIpAddr));
          socket->mss = max(socket->mss, TCP_MIN_MSS);
       }
 
@@ -602,6 +634,21 @@ void tcpStateSynSent(Socket *socket, TcpHeader *segment, size_t length)
       //Slow start threshold should be set arbitrarily high
       socket->ssthresh = UINT16_MAX;
 
+#if (TCP_ECN_SUPPORT == ENABLED)
+      //ECN is used only if the peer answers with an ECN-setup SYN-ACK (ECE
+      //set, CWR cleared) or, on simultaneous open, an ECN-setup SYN
+      if(segment->flags & TCP_FLAG_ACK)
+      {
+         if((segment->flags & (TCP_FLAG_ECE | TCP_FLAG_CWR)) != TCP_FLAG_ECE)
+            socket->ecnEnabled = FALSE;
+      }
+      else
+      {
+         if((segment->flags & (TCP_FLAG_ECE | TCP_FLAG_CWR)) != (TCP_FLAG_ECE | TCP_FLAG_CWR))
+            socket->ecnEnabled = FALSE;
+      }
+#endif
+
       //Check whether our SYN has been acknowledged (SND.UNA > ISS)
       if(TCP_CMP_SEQ(socket->sndUna, socket->iss) > 0)
       {
@@ -33,8 +33,8 @@
 #include "tcp.h"
 
 //TCP FSM related functions
-void tcpProcessSegment(NetInterface *interface,
-   IpPseudoHeader *pseudoHeader, const ChunkedBuffer *buffer, size_t offset);
+void tcpProcessSegment(NetInterface *interface, IpPseudoHeader *pseudoHeader,
+   const ChunkedBuffer *buffer, size_t offset, uint_t ecn);
 
 void tcpStateClosed(NetInterface *interface,
    IpPseudoHeader *pseudoHeader, TcpHeader *segment, size_t length);
@@ -40,11 +40,17 @@
 #include "ipv6.h"
 #include "mld.h"
 #include "ndp.h"
+#include "mib2.h"
 #include "debug.h"
 
 //Global variables
 NetInterface netInterface[NET_INTERFACE_COUNT];
 
+#if (MIB2_SUPPORT == ENABLED)
+//Protocol statistics
+Mib2Stats mib2Stats;
+#endif
+
 
 /**
  * @brief TCP/IP stack initialization
@@ -65,6 +71,11 @@ error_t tcpIpStackInit(void)
    //Clear configuration data for each interface
    memset(netInterface, 0, sizeof(netInterface));
 
+#if (MIB2_SUPPORT == ENABLED)
+   //Clear protocol statistics
+   memset(&mib2Stats, 0, sizeof(mib2Stats));
+#endif
+
    //Loop through network interfaces
    for(i = 0; i < NET_INTERFACE_COUNT; i++)
    {
@@ -72,6 +83,8 @@ error_t tcpIpStackInit(void)
       netInterface[i].identifier = i;
       //Default name
       sprintf(netInterface[i].name, "eth%u", i);
+      //Default MTU
+      netInterface[i].mtu = ETH_MTU;
    }
 
    //Socket related initialization
@@ -110,6 +123,20 @@ error_t tcpIpStackConfigInterface(NetInterface *interface)
    Ipv6Addr solicitedNodeAddr;
 #endif
 
+   //The MTU must not exceed the capabilities of the network controller
+   if(interface->mtu > min(interface->nicDriver->mtu, ETH_MAX_MTU))
+      return ERROR_INVALID_PARAMETER;
+
+#if (IPV6_SUPPORT == ENABLED)
+   //IPv6 requires that every link has an MTU of 1280 octets or greater
+   if(interface->mtu < IPV6_DEFAULT_MTU)
+      return ERROR_INVALID_PARAMETER;
+#else
+   //Make sure the link can carry datagrams of the minimum IPv4 size
+   if(interface->mtu < IPV4_DEFAULT_MTU)
+      return ERROR_INVALID_PARAMETER;
+#endif
+
    //Disable Ethernet controller interrupts
    interface->nicDriver->disableIrq(interface);
 
@@ -487,3 +514,63 @@ NetInterface *tcpIpStackGetDefaultInterface(void)
    //Default network interface
    return &netInterface[0];
 }
+
+
+#if (MIB2_SUPPORT == ENABLED)
+
+/**
+ * @brief Take a snapshot of the protocol statistics
+ *
+ * The counters are updated without any locking. Since each counter is a
+ * naturally aligned 32-bit word, it can be read atomically, but the snapshot
+ * as a whole may interleave with concurrent updates
+ *
+ * @param[out] stats Structure that receives the protocol statistics
+ **/
+
+void mib2GetStats(Mib2Stats *stats)
+{
+   uint_t i;
+   const volatile uint32_t *p;
+   uint32_t *q;
+
+   //Point to the counters
+   p = (const volatile uint32_t *) &mib2Stats;
+   q = (uint32_t *) stats;
+
+   //Copy the counters one word at a time
+   for(i = 0; i < (sizeof(Mib2Stats) / sizeof(uint32_t)); i++)
+      q[i] = p[i];
+}
+
+
+/**
+ * @brief Take a snapshot of the statistics of a given interface
+ * @param[in] interface Underlying network interface
+ * @param[out] stats Structure that receives the interface statistics
+ * @return Error code
+ **/
+
+error_t mib2GetIfStats(NetInterface *interface, Mib2IfStats *stats)
+{
+   uint_t i;
+   const volatile uint32_t *p;
+   uint32_t *q;
+
+   //Check parameters
+   if(!interface || !stats)
+      return ERROR_INVALID_PARAMETER;
+
+   //Point to the counters
+   p = (const volatile uint32_t *) &interface->ifStats;
+   q = (uint32_t *) stats;
+
+   //Copy the counters one word at a time
+   for(i = 0; i < (sizeof(Mib2IfStats) / sizeof(uint32_t)); i++)
+      q[i] = p[i];
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+#endif
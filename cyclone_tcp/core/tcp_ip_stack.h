@@ -52,6 +52,7 @@ struct _NetInterface;
 #include "arp.h"
 #include "ndp.h"
 #include "dns_client.h"
+#include "mib2.h"
 
 //Number of network adapters
 #ifndef NET_INTERFACE_COUNT
@@ -108,7 +109,7 @@ struct _NetInterface
    OsMutex *macFilterMutex;                             ///<Mutex preventing simultaneous access to the MAC filter table
    MacFilterEntry macFilter[MAC_FILTER_MAX_SIZE];       ///<MAC filter table
    uint_t macFilterSize;                                ///<Number of entries in the MAC filter table
-   uint8_t ethFrame[1534 /*ETH_MAX_FRAME_SIZE*/];       ///<Incoming Ethernet frame
+   uint8_t ethFrame[ETH_MAX_FRAME_SIZE + 16];           ///<Incoming Ethernet frame
    OsTask *tickTask;                                    ///<Handle to the task that manages periodic operations
    OsTask *rxTask;                                      ///<Handle to the task that handles incoming frames
    OsEvent *nicTxEvent;                                 ///<Network controller TX event
@@ -124,7 +125,11 @@ struct _NetInterface
    bool_t linkState;                                    ///<Link state
    bool_t speed100;                                     ///<Link speed
    bool_t fullDuplex;                                   ///<Duplex mode
+   size_t mtu;                                          ///<Maximum transmission unit
    bool_t configured;                                   ///<Configuration done
+#if (MIB2_SUPPORT == ENABLED)
+   Mib2IfStats ifStats;                                 ///<Interface statistics
+#endif
 
 #if (IPV4_SUPPORT == ENABLED)
    Ipv4Config ipv4Config;                               ///<IPv4 configuration
@@ -132,6 +137,12 @@ struct _NetInterface
 #if (IPV4_FRAG_SUPPORT == ENABLED)
    OsMutex *ipv4FragQueueMutex;                         ///<Mutex preventing simultaneous access to reassembly queue
    Ipv4FragDesc ipv4FragQueue[IPV4_MAX_FRAG_DATAGRAMS]; ///<IPv4 fragment reassembly queue
+   Ipv4FragDesc *ipv4FragTable[IPV4_FRAG_HASH_TABLE_SIZE]; ///<Hash table used to locate datagrams being reassembled
+   size_t ipv4FragMemUsage;                             ///<Memory consumed by the IPv4 reassembly queue
+#endif
+#if (IPV4_PMTU_SUPPORT == ENABLED)
+   OsMutex *ipv4PmtuCacheMutex;                         ///<Mutex preventing simultaneous access to the path MTU cache
+   Ipv4PmtuEntry ipv4PmtuCache[IPV4_PMTU_CACHE_SIZE];   ///<IPv4 path MTU cache
 #endif
    OsMutex *arpCacheMutex;                              ///<Mutex preventing simultaneous access to ARP cache
    ArpCacheEntry arpCache[ARP_CACHE_SIZE];              ///<ARP cache
@@ -150,6 +161,12 @@ struct _NetInterface
    uint32_t ipv6Identification;                         ///<IPv6 Fragment identification field
    OsMutex *ipv6FragQueueMutex;                         ///<Mutex preventing simultaneous access to reassembly queue
    Ipv6FragDesc ipv6FragQueue[IPV6_MAX_FRAG_DATAGRAMS]; ///<IPv6 fragment reassembly queue
+   Ipv6FragDesc *ipv6FragTable[IPV6_FRAG_HASH_TABLE_SIZE]; ///<Hash table used to locate datagrams being reassembled
+   size_t ipv6FragMemUsage;                             ///<Memory consumed by the IPv6 reassembly queue
+#endif
+#if (IPV6_PMTU_SUPPORT == ENABLED)
+   OsMutex *ipv6PmtuCacheMutex;                         ///<Mutex preventing simultaneous access to the path MTU cache
+   Ipv6PmtuEntry ipv6PmtuCache[IPV6_PMTU_CACHE_SIZE];   ///<IPv6 path MTU cache
 #endif
    OsMutex *ndpCacheMutex;                              ///<Mutex preventing simultaneous access to Neighbor cache
    NdpCacheEntry ndpCache[NDP_CACHE_SIZE];              ///<Neighbor cache
@@ -66,9 +66,50 @@ error_t tcpSendSegment(Socket *socket, uint8_t flags, uint32_t seqNum,
    TcpHeader *segment;
    TcpQueueItem *queueItem;
    IpPseudoHeader pseudoHeader;
+   uint16_t mss;
+   uint_t ecnFlags;
 
-   //Maximum segment size
-   const uint16_t mss = HTONS(TCP_MAX_MSS);
+   //Segments are not ECN-capable by default
+   ecnFlags = 0;
+
+#if (TCP_ECN_SUPPORT == ENABLED)
+   //ECN negotiated (or being negotiated) for this connection?
+   if(socket->ecnEnabled)
+   {
+      //SYN flag set?
+      if(flags & TCP_FLAG_SYN)
+      {
+         //An ECN-setup SYN segment has both ECE and CWR flags set, whereas
+         //an ECN-setup SYN-ACK segment only has ECE set (refer to RFC 3168)
+         if(flags & TCP_FLAG_ACK)
+            flags |= TCP_FLAG_ECE;
+         else
+            flags |= TCP_FLAG_ECE | TCP_FLAG_CWR;
+      }
+      else if(!(flags & TCP_FLAG_RST))
+      {
+         //Keep on reporting the congestion until a segment with
+         //the CWR flag set is received
+         if(socket->ecnEcho && (flags & TCP_FLAG_ACK))
+            flags |= TCP_FLAG_ECE;
+
+         //Any data to send?
+         if(length > 0)
+         {
+            //Tell the receiver that the congestion window has been reduced
+            if(socket->ecnCwr)
+            {
+               flags |= TCP_FLAG_CWR;
+               socket->ecnCwr = FALSE;
+            }
+
+            //Data segments are sent with the ECT(0) codepoint. Pure ACKs,
+            //window probes and retransmissions remain non-ECT
+            ecnFlags = IP_FLAG_ECT_0;
+         }
+      }
+   }
+#endif
 
    //Allocate a memory buffer to hold the TCP segment
    buffer = ipAllocBuffer(TCP_MAX_HEADER_LENGTH, &offset);
@@ -86,7 +127,6 @@ error_t tcpSendSegment(Socket *socket, uint8_t flags, uint32_t seqNum,
    segment->reserved1 = 0;
    segment->dataOffset = 5;
    segment->flags = flags;
-   segment->reserved2 = 0;
    segment->window = htons(socket->rcvWnd);
    segment->checksum = 0;
    segment->urgentPointer = 0;
@@ -94,6 +134,8 @@ error_t tcpSendSegment(Socket *socket, uint8_t flags, uint32_t seqNum,
    //SYN flag set?
    if(flags & TCP_FLAG_SYN)
    {
+      //Advertise the largest MSS the underlying interface can carry
+      mss = htons(tcpGetMaxMss(socket->interface, &socket->remoteIpAddr));
       //Append MSS option
       tcpAddOption(segment, TCP_OPTION_MAX_SEGMENT_SIZE, &mss, sizeof(mss));
 
@@ -248,8 +290,16 @@ error_t tcpSendSegment(Socket *socket, uint8_t flags, uint32_t seqNum,
    //Dump TCP header contents for debugging purpose
    tcpDumpHeader(segment, length, socket->iss, socket->irs);
 
+   //Total number of segments sent
+   MIB2_INC_COUNTER(tcp.tcpOutSegs, 1);
+
+   //Number of segments sent containing the RST flag
+   if(flags & TCP_FLAG_RST)
+      MIB2_INC_COUNTER(tcp.tcpOutRsts, 1);
+
    //Send TCP segment
-   error = ipSendDatagram(socket->interface, &pseudoHeader, buffer, offset, timeToLive);
+   error = ipSendDatagram(socket->interface, &pseudoHeader,
+      buffer, offset, timeToLive | ecnFlags);
 
    //Free previously allocated memory
    chunkedBufferFree(buffer);
@@ -320,7 +370,6 @@ error_t tcpSendResetSegment(NetInterface *interface,
    segment2->reserved1 = 0;
    segment2->dataOffset = 5;
    segment2->flags = flags;
-   segment2->reserved2 = 0;
    segment2->window = 0;
    segment2->checksum = 0;
    segment2->urgentPointer = 0;
@@ -380,6 +429,11 @@ error_t tcpSendResetSegment(NetInterface *interface,
    //Dump TCP header contents for debugging purpose
    tcpDumpHeader(segment2, length, 0, 0);
 
+   //Total number of segments sent
+   MIB2_INC_COUNTER(tcp.tcpOutSegs, 1);
+   //Number of segments sent containing the RST flag
+   MIB2_INC_COUNTER(tcp.tcpOutRsts, 1);
+
    //Send TCP segment
    error = ipSendDatagram(interface, &pseudoHeader2, buffer, offset, timeToLive);
 
@@ -390,6 +444,44 @@ error_t tcpSendResetSegment(NetInterface *interface,
 }
 
 
+/**
+ * @brief Compute the largest acceptable MSS for a given destination
+ *
+ * The MSS is derived from the MTU of the path to the remote host, so
+ * that full-sized segments never have to be fragmented at the IP layer
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] remoteIpAddr IP address of the remote host
+ * @return Maximum segment size
+ **/
+
+uint16_t tcpGetMaxMss(NetInterface *interface, const IpAddr *remoteIpAddr)
+{
+   size_t n;
+
+   //Use default network interface?
+   if(!interface)
+      interface = tcpIpStackGetDefaultInterface();
+
+   //Subtract the size of the TCP header from the path MTU
+   n = ipGetPathMtu(interface, remoteIpAddr) - sizeof(TcpHeader);
+
+#if (IPV4_SUPPORT == ENABLED)
+   //IPv4 is currently used?
+   if(remoteIpAddr->length == sizeof(Ipv4Addr))
+      n -= sizeof(Ipv4Header);
+#endif
+#if (IPV6_SUPPORT == ENABLED)
+   //IPv6 is currently used?
+   if(remoteIpAddr->length == sizeof(Ipv6Addr))
+      n -= sizeof(Ipv6Header);
+#endif
+
+   //The MSS cannot exceed the value allowed by the configuration
+   return min(n, TCP_MAX_MSS);
+}
+
+
 /**
  * @brief Append an option to a TCP segment
  * @param[in] segment Pointer to the TCP header
@@ -678,6 +770,35 @@ error_t tcpCheckAck(Socket *socket, TcpHeader *segment, size_t length)
          socket->dupAckCount = 0;
       }
 
+#if (TCP_ECN_SUPPORT == ENABLED)
+      //The receiver reports that the network is congested?
+      if(socket->ecnEnabled && (segment->flags & TCP_FLAG_ECE) &&
+         !(segment->flags & TCP_FLAG_SYN))
+      {
+         //The sender should react to congestion at most once per window
+         //of data (refer to RFC 3168 section 6.1.2)
+         if(TCP_CMP_SEQ(segment->ackNum, socket->ecnRecover) > 0)
+         {
+            //Amount of data that has been sent but not yet acknowledged
+            uint_t flightSize = socket->sndNxt - socket->sndUna;
+
+            //Debug message
+            TRACE_INFO("%s: TCP congestion notification received...\r\n",
+               timeFormat(osGetTickCount()));
+
+            //Halve the congestion window and reduce the slow start threshold,
+            //as for a lost packet, but without any retransmission
+            socket->ssthresh = max(flightSize / 2, 2 * socket->mss);
+            socket->cwnd = min(socket->ssthresh, socket->txBufferSize);
+
+            //Ignore further congestion indications for this window of data
+            socket->ecnRecover = socket->sndNxt;
+            //Set the CWR flag in the next new data segment
+            socket->ecnCwr = TRUE;
+         }
+      }
+#endif
+
       //The incoming ACK segment acknowledges new data?
       if(TCP_CMP_SEQ(segment->ackNum, socket->sndUna) > 0)
       {
@@ -719,10 +840,13 @@ error_t tcpCheckAck(Socket *socket, TcpHeader *segment, size_t length)
       //The incoming ACK segment does not acknowledge new data?
       else
       {
-         //Debug message
+         //Duplicate ACK received?
          if(socket->dupAckCount > 0)
          {
+            //Debug message
             TRACE_INFO("TCP duplicate ACK #%u\r\n", socket->dupAckCount);
+            //Number of duplicate ACKs received
+            MIB2_INC_COUNTER(tcp.tcpDupAcks, 1);
          }
 
          //Check the number of duplicate ACKs that have been received
@@ -735,6 +859,8 @@ error_t tcpCheckAck(Socket *socket, TcpHeader *segment, size_t length)
 
             //Debug message
             TRACE_INFO("%s: TCP fast retransmit...\r\n", timeFormat(osGetTickCount()));
+            //Number of fast retransmissions
+            MIB2_INC_COUNTER(tcp.tcpFastRetrans, 1);
 
             //TCP performs a retransmission of what appears to be the missing
             //segment, without waiting for the retransmission timer to expire
@@ -1149,6 +1275,9 @@ error_t tcpRetransmitSegment(Socket *socket)
       //Dump TCP header contents for debugging purpose
       tcpDumpHeader(&queueItem->header, queueItem->length, socket->iss, socket->irs);
 
+      //Total number of segments retransmitted
+      MIB2_INC_COUNTER(tcp.tcpRetransSegs, 1);
+
       //Retransmit the lost segment without waiting for the retransmission timer to expire
       error = ipSendDatagram(socket->interface, &queueItem->pseudoHeader,
          buffer, offset, queueItem->timeToLive);
@@ -1163,6 +1292,47 @@ error_t tcpRetransmitSegment(Socket *socket)
 }
 
 
+/**
+ * @brief Strip ECN setup flags from a pending SYN or SYN-ACK segment
+ * @param[in] socket Handle referencing the socket
+ * @return TRUE if the segment has been modified, else FALSE
+ **/
+
+bool_t tcpDisableEcnSetup(Socket *socket)
+{
+   TcpQueueItem *queueItem;
+
+   //Point to the segment to be retransmitted
+   queueItem = socket->retransmitQueue;
+
+   //Make sure the retransmission queue is not empty
+   if(!queueItem)
+      return FALSE;
+   //Only SYN and SYN-ACK segments are concerned
+   if(!(queueItem->header.flags & TCP_FLAG_SYN))
+      return FALSE;
+   //Check whether the segment carries any ECN flag
+   if(!(queueItem->header.flags & (TCP_FLAG_ECE | TCP_FLAG_CWR)))
+      return FALSE;
+
+   //Clear ECE and CWR flags
+   queueItem->header.flags &= ~(TCP_FLAG_ECE | TCP_FLAG_CWR);
+
+   //A SYN segment carries no data, so the checksum only
+   //covers the pseudo header and the TCP header
+   queueItem->header.checksum = 0;
+   queueItem->header.checksum = ipCalcUpperLayerChecksum(queueItem->pseudoHeader.data,
+      queueItem->pseudoHeader.length, &queueItem->header, queueItem->header.dataOffset * 4);
+
+   //ECN will not be used on this connection
+   socket->ecnEnabled = FALSE;
+   socket->ecnEcho = FALSE;
+
+   //The segment has been modified
+   return TRUE;
+}
+
+
 /**
  * @brief Nagle algorithm implementation
  * @param[in] socket Handle referencing the socket
@@ -1174,6 +1344,11 @@ error_t tcpNagleAlgo(Socket *socket)
    error_t error;
    uint_t n;
    uint_t u;
+   uint_t mss;
+
+   //Segments must not exceed the current path MTU, which may have
+   //decreased since the MSS was negotiated
+   mss = min(socket->mss, tcpGetMaxMss(socket->interface, &socket->remoteIpAddr));
 
    //The amount of data that can be sent at any given time is
    //limited by the receiver window and the congestion window
@@ -1194,10 +1369,10 @@ error_t tcpNagleAlgo(Socket *socket)
    {
       //Calculate the number of bytes to send at a time
       n = min(u, socket->sndUser);
-      n = min(n, socket->mss);
+      n = min(n, mss);
 
       //Transmit data if a maximum-sized segment can be sent
-      if(min(socket->sndUser, u) >= socket->mss)
+      if(min(socket->sndUser, u) >= mss)
       {
          //Send TCP segment
          error = tcpSendSegment(socket, TCP_FLAG_PSH | TCP_FLAG_ACK,
@@ -1253,6 +1428,21 @@ error_t tcpNagleAlgo(Socket *socket)
 
 void tcpChangeState(Socket *socket, TcpState newState)
 {
+   //Connection attempt failed?
+   if((socket->state == TCP_STATE_SYN_SENT || socket->state == TCP_STATE_SYN_RECEIVED) &&
+      (newState == TCP_STATE_CLOSED || newState == TCP_STATE_LISTEN))
+   {
+      //Number of failed connection attempts
+      MIB2_INC_COUNTER(tcp.tcpAttemptFails, 1);
+   }
+   //Established connection reset?
+   else if((socket->state == TCP_STATE_ESTABLISHED || socket->state == TCP_STATE_CLOSE_WAIT) &&
+      newState == TCP_STATE_CLOSED)
+   {
+      //Number of resets from the ESTABLISHED or CLOSE-WAIT states
+      MIB2_INC_COUNTER(tcp.tcpEstabResets, 1);
+   }
+
    //Enter CLOSED state?
    if(newState == TCP_STATE_CLOSED)
    {
@@ -1578,7 +1768,7 @@ void tcpReadRxBuffer(Socket *socket, uint32_t seqNum, uint8_t *data, size_t leng
 void tcpDumpHeader(const TcpHeader *segment, size_t length, uint32_t iss, uint32_t irs)
 {
    //Dump TCP header contents
-   TRACE_DEBUG("%u > %u: %c%c%c%c%c%c seq=%u(%u) ack=%u(%u) win=%u len=%u\r\n",
+   TRACE_DEBUG("%u > %u: %c%c%c%c%c%c%c%c seq=%u(%u) ack=%u(%u) win=%u len=%u\r\n",
       ntohs(segment->srcPort), ntohs(segment->destPort),
       (segment->flags & TCP_FLAG_FIN) ? 'F' : '-',
       (segment->flags & TCP_FLAG_SYN) ? 'S' : '-',
@@ -1586,6 +1776,8 @@ void tcpDumpHeader(const TcpHeader *segment, size_t length, uint32_t iss, uint32
       (segment->flags & TCP_FLAG_PSH) ? 'P' : '-',
       (segment->flags & TCP_FLAG_ACK) ? 'A' : '-',
       (segment->flags & TCP_FLAG_URG) ? 'U' : '-',
+      (segment->flags & TCP_FLAG_ECE) ? 'E' : '-',
+      (segment->flags & TCP_FLAG_CWR) ? 'C' : '-',
       ntohl(segment->seqNum), ntohl(segment->seqNum) - iss,
       ntohl(segment->ackNum), ntohl(segment->ackNum) - irs,
       ntohs(segment->window), length);
@@ -39,6 +39,8 @@ error_t tcpSendSegment(Socket *socket, uint8_t flags, uint32_t seqNum,
 error_t tcpSendResetSegment(NetInterface *interface,
    IpPseudoHeader *pseudoHeader, TcpHeader *segment, size_t length);
 
+uint16_t tcpGetMaxMss(NetInterface *interface, const IpAddr *remoteIpAddr);
+
 error_t tcpAddOption(TcpHeader *segment, uint8_t kind, const void *value, uint8_t length);
 TcpOption *tcpGetOption(TcpHeader *segment, uint8_t kind);
 
@@ -61,6 +63,7 @@ void tcpUpdateReceiveWindow(Socket *socket);
 
 void tcpComputeRto(Socket *socket);
 error_t tcpRetransmitSegment(Socket *socket);
+bool_t tcpDisableEcnSetup(Socket *socket);
 error_t tcpNagleAlgo(Socket *socket);
 
 void tcpChangeState(Socket *socket, TcpState newState);
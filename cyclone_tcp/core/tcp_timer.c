@@ -34,6 +34,7 @@
 #include "socket.h"
 #include "tcp.h"
 #include "tcp_misc.h"
+#include "ip.h"
 #include "ipv4.h"
 #include "debug.h"
 
@@ -78,6 +79,9 @@ void tcpTick(void)
          //Retransmission timeout?
          if(osTimerElapsed(&socket->retransmitTimer))
          {
+            //Number of retransmission timeouts
+            MIB2_INC_COUNTER(tcp.tcpRtoTimeouts, 1);
+
             //When a TCP sender detects segment loss using the retransmission
             //timer and the given segment has not yet been resent by way of
             //the retransmission timer, the value of ssthresh must be updated
@@ -93,6 +97,25 @@ void tcpTick(void)
             //the loss window, LW, which equals 1 full-sized segment
             socket->cwnd = min(TCP_LOSS_WINDOW * socket->mss, socket->txBufferSize);
 
+            //Repeated timeouts on a full-sized segment while no ICMP error is
+            //received suggest a path MTU black hole. Fall back to a smaller
+            //path MTU so that the data can get through (refer to RFC 4821)
+            if(socket->retransmitCount == TCP_PMTU_BLACKHOLE_THRES &&
+               socket->retransmitQueue->length > TCP_DEFAULT_MSS)
+            {
+               ipReducePathMtu(socket->interface, &socket->remoteIpAddr);
+            }
+
+#if (TCP_ECN_SUPPORT == ENABLED)
+            //An ECN-setup SYN or SYN-ACK may be dropped by a broken middlebox.
+            //The segment is resent without ECN flags (refer to RFC 3168)
+            if(tcpDisableEcnSetup(socket))
+            {
+               //Debug message
+               TRACE_INFO("TCP ECN setup falling back to non-ECN...\r\n");
+            }
+#endif
+
             //Make sure the maximum number of retransmissions has not been reached
             if(socket->retransmitCount < TCP_MAX_RETRIES)
             {
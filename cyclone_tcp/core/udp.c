@@ -70,6 +70,8 @@ error_t udpProcessDatagram(NetInterface *interface,
    {
       //Debug message
       TRACE_WARNING("UDP datagram length is invalid!\r\n");
+      //Number of received UDP datagrams that could not be delivered
+      MIB2_INC_COUNTER(udp.udpInErrors, 1);
       //Report an error
       return ERROR_INVALID_HEADER;
    }
@@ -93,6 +95,8 @@ error_t udpProcessDatagram(NetInterface *interface,
       {
          //Debug message
          TRACE_WARNING("Wrong UDP header checksum!\r\n");
+         //Number of received UDP datagrams that could not be delivered
+         MIB2_INC_COUNTER(udp.udpInErrors, 1);
          //Report an error
          return ERROR_WRONG_CHECKSUM;
       }
@@ -189,6 +193,8 @@ error_t udpProcessDatagram(NetInterface *interface,
    {
       //Leave critical section
       osMutexRelease(socketMutex);
+      //Number of received UDP datagrams for which there was no application
+      MIB2_INC_COUNTER(udp.udpNoPorts, 1);
       //Unreachable protocol...
       return ERROR_PROTOCOL_UNREACHABLE;
    }
@@ -231,6 +237,8 @@ error_t udpProcessDatagram(NetInterface *interface,
       {
          //Leave critical section
          osMutexRelease(socketMutex);
+         //Number of received UDP datagrams that could not be delivered
+         MIB2_INC_COUNTER(udp.udpInErrors, 1);
          //Notify the calling function that the queue is full
          return ERROR_RECEIVE_QUEUE_FULL;
       }
@@ -259,6 +267,8 @@ error_t udpProcessDatagram(NetInterface *interface,
    {
       //Leave critical section
       osMutexRelease(socketMutex);
+      //Number of received UDP datagrams that could not be delivered
+      MIB2_INC_COUNTER(udp.udpInErrors, 1);
       //Return error code
       return ERROR_OUT_OF_MEMORY;
    }
@@ -292,6 +302,9 @@ error_t udpProcessDatagram(NetInterface *interface,
    //Copy the payload
    chunkedBufferCopy(queueItem->buffer, queueItem->offset, buffer, offset, length);
 
+   //Total number of UDP datagrams delivered to UDP users
+   MIB2_INC_COUNTER(udp.udpInDatagrams, 1);
+
    //Notify user that data is available
    udpUpdateEvents(socket);
 
@@ -434,6 +447,9 @@ error_t udpSendDatagram(Socket *socket, const IpAddr *destIpAddr,
       //Failed to send datagram?
       if(error) break;
 
+      //Total number of UDP datagrams sent from this entity
+      MIB2_INC_COUNTER(udp.udpOutDatagrams, 1);
+
       //Total number of data bytes successfully transmitted
       if(written != NULL) *written = length;
 
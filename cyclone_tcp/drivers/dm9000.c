@@ -46,6 +46,7 @@ static uint8_t txBuffer[1536] __attribute__((aligned(2)));
 
 const NicDriver dm9000Driver =
 {
+   ETH_MTU,
    dm9000Init,
    dm9000Tick,
    dm9000EnableIrq,
@@ -63,6 +63,7 @@ static uint_t rxBufferIndex;
 
 const NicDriver k60EthDriver =
 {
+   ETH_MTU,
    k60EthInit,
    k60EthTick,
    k60EthEnableIrq,
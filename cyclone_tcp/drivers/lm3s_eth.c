@@ -58,6 +58,7 @@ static uint8_t txBuffer[1538] __attribute__((aligned(4)));
 
 const NicDriver lm3sEthDriver =
 {
+   ETH_MTU,
    lm3sEthInit,
    lm3sEthTick,
    lm3sEthEnableIrq,
@@ -55,6 +55,7 @@ static Lpc175xRxStatus rxStatus[LPC175X_TX_BUFFER_COUNT] __attribute__((aligned(
 
 const NicDriver lpc175xEthDriver =
 {
+   ETH_MTU,
    lpc175xEthInit,
    lpc175xEthTick,
    lpc175xEthEnableIrq,
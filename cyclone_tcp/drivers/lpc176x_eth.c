@@ -55,6 +55,7 @@ static Lpc176xRxStatus rxStatus[LPC176X_TX_BUFFER_COUNT] __attribute__((aligned(
 
 const NicDriver lpc176xEthDriver =
 {
+   ETH_MTU,
    lpc176xEthInit,
    lpc176xEthTick,
    lpc176xEthEnableIrq,
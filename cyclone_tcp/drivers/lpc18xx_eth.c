@@ -55,6 +55,7 @@ static Lpc18xxRxDmaDesc *rxCurDmaDesc;
 
 const NicDriver lpc18xxEthDriver =
 {
+   ETH_MTU,
    lpc18xxEthInit,
    lpc18xxEthTick,
    lpc18xxEthEnableIrq,
@@ -55,6 +55,7 @@ static Lpc43xxRxDmaDesc *rxCurDmaDesc;
 
 const NicDriver lpc43xxEthDriver =
 {
+   ETH_MTU,
    lpc43xxEthInit,
    lpc43xxEthTick,
    lpc43xxEthEnableIrq,
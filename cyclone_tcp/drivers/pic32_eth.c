@@ -56,6 +56,7 @@ static uint_t rxBufferIndex;
 
 const NicDriver pic32EthDriver =
 {
+   ETH_MTU,
    pic32EthInit,
    pic32EthTick,
    pic32EthEnableIrq,
@@ -56,6 +56,7 @@ static uint_t rxBufferIndex;
 
 const NicDriver sam3xEthDriver =
 {
+   ETH_MTU,
    sam3xEthInit,
    sam3xEthTick,
    sam3xEthEnableIrq,
@@ -56,6 +56,7 @@ static uint_t rxBufferIndex;
 
 const NicDriver sam4eEthDriver =
 {
+   ETH_MTU,
    sam4eEthInit,
    sam4eEthTick,
    sam4eEthEnableIrq,
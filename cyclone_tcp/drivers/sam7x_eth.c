@@ -56,6 +56,7 @@ static uint_t rxBufferIndex;
 
 const NicDriver sam7xEthDriver =
 {
+   ETH_MTU,
    sam7xEthInit,
    sam7xEthTick,
    sam7xEthEnableIrq,
@@ -56,6 +56,7 @@ static uint_t rxBufferIndex;
 
 const NicDriver sam9263EthDriver =
 {
+   ETH_MTU,
    sam9263EthInit,
    sam9263EthTick,
    sam9263EthEnableIrq,
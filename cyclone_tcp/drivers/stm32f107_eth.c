@@ -57,6 +57,7 @@ static Stm32f107RxDmaDesc *rxCurDmaDesc;
 
 const NicDriver stm32f107EthDriver =
 {
+   ETH_MTU,
    stm32f107EthInit,
    stm32f107EthTick,
    stm32f107EthEnableIrq,
@@ -57,6 +57,7 @@ static Stm32f2x7RxDmaDesc *rxCurDmaDesc;
 
 const NicDriver stm32f2x7EthDriver =
 {
+   STM32F2X7_MAX_MTU,
    stm32f2x7EthInit,
    stm32f2x7EthTick,
    stm32f2x7EthEnableIrq,
@@ -173,6 +174,10 @@ error_t stm32f2x7EthInit(NetInterface *interface)
    //Use default MAC configuration
    ETH->MACCR = ETH_MACCR_ROD;
 
+   //Jumbo frames would be truncated by the watchdog and jabber timers
+   if(interface->mtu > ETH_MTU)
+      ETH->MACCR |= ETH_MACCR_WD | ETH_MACCR_JD;
+
    //Set the MAC address
    ETH->MACA0LR = interface->macAddr.w[0] | (interface->macAddr.w[1] << 16);
    ETH->MACA0HR = interface->macAddr.w[2];
@@ -32,12 +32,36 @@
 //Dependencies
 #include "nic.h"
 
-//TX buffers
-#define STM32F4X7_TX_BUFFER_COUNT 2
-#define STM32F4X7_TX_BUFFER_SIZE 1536
-//RX buffers
-#define STM32F4X7_RX_BUFFER_COUNT 6
-#define STM32F4X7_RX_BUFFER_SIZE 1536
+//Number of TX buffers
+#ifndef STM32F4X7_TX_BUFFER_COUNT
+   #define STM32F4X7_TX_BUFFER_COUNT 2
+#elif (STM32F4X7_TX_BUFFER_COUNT < 1)
+   #error STM32F4X7_TX_BUFFER_COUNT parameter is invalid
+#endif
+
+//TX buffer size
+#ifndef STM32F4X7_TX_BUFFER_SIZE
+   #define STM32F4X7_TX_BUFFER_SIZE 1536
+#elif (STM32F4X7_TX_BUFFER_SIZE < 1536 || STM32F4X7_TX_BUFFER_SIZE > 8188 || (STM32F4X7_TX_BUFFER_SIZE % 4) != 0)
+   #error STM32F4X7_TX_BUFFER_SIZE parameter is invalid
+#endif
+
+//Number of RX buffers
+#ifndef STM32F4X7_RX_BUFFER_COUNT
+   #define STM32F4X7_RX_BUFFER_COUNT 6
+#elif (STM32F4X7_RX_BUFFER_COUNT < 1)
+   #error STM32F4X7_RX_BUFFER_COUNT parameter is invalid
+#endif
+
+//RX buffer size
+#ifndef STM32F4X7_RX_BUFFER_SIZE
+   #define STM32F4X7_RX_BUFFER_SIZE 1536
+#elif (STM32F4X7_RX_BUFFER_SIZE < 1536 || STM32F4X7_RX_BUFFER_SIZE > 8188 || (STM32F4X7_RX_BUFFER_SIZE % 4) != 0)
+   #error STM32F4X7_RX_BUFFER_SIZE parameter is invalid
+#endif
+
+//Largest MTU supported (each frame must fit in a single DMA buffer)
+#define STM32F4X7_MAX_MTU (min(STM32F4X7_TX_BUFFER_SIZE, STM32F4X7_RX_BUFFER_SIZE) - 18)
 
 //Transmit DMA descriptor flags
 #define ETH_TDES0_OWN    0x80000000
@@ -55,6 +55,7 @@ static Xmc4500RxDmaDesc *rxCurDmaDesc;
 
 const NicDriver xmc4500EthDriver =
 {
+   ETH_MTU,
    xmc4500EthInit,
    xmc4500EthTick,
    xmc4500EthEnableIrq,
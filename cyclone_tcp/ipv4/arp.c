@@ -546,7 +546,15 @@ void arpProcessPacket(NetInterface *interface, ArpPacket *arpPacket, size_t leng
 {
    //Discard invalid ARP packets
    if(length < sizeof(ArpPacket))
+   {
+      //Number of malformed ARP packets
+      MIB2_INC_COUNTER(arp.arpInErrors, 1);
+      //Exit immediately
       return;
+   }
+
+   //Total number of ARP packets received
+   MIB2_INC_COUNTER(arp.arpInPkts, 1);
 
    //Debug message
    TRACE_INFO("ARP packet received (%u bytes)...\r\n", length);
@@ -579,11 +587,15 @@ void arpProcessPacket(NetInterface *interface, ArpPacket *arpPacket, size_t leng
    {
    //ARP request?
    case ARP_OPCODE_ARP_REQUEST:
+      //Number of ARP requests received
+      MIB2_INC_COUNTER(arp.arpInRequests, 1);
       //Process incoming ARP request
       arpProcessRequest(interface, arpPacket);
       break;
    //ARP reply?
    case ARP_OPCODE_ARP_REPLY:
+      //Number of ARP replies received
+      MIB2_INC_COUNTER(arp.arpInReplies, 1);
       //Process incoming ARP reply
       arpProcessReply(interface, arpPacket);
       break;
@@ -735,6 +747,9 @@ error_t arpSendRequest(NetInterface *interface, Ipv4Addr senderIpAddr,
    //Dump ARP packet contents for debugging purpose
    arpDumpPacket(arpRequest);
 
+   //Number of ARP requests sent
+   MIB2_INC_COUNTER(arp.arpOutRequests, 1);
+
    //Send ARP request
    error = ethSendFrame(interface, destMacAddr, buffer, offset, ETH_TYPE_ARP);
 
@@ -786,6 +801,9 @@ error_t arpSendReply(NetInterface *interface, Ipv4Addr targetIpAddr,
    //Dump ARP packet contents for debugging purpose
    arpDumpPacket(arpReply);
 
+   //Number of ARP replies sent
+   MIB2_INC_COUNTER(arp.arpOutReplies, 1);
+
    //Send ARP reply
    error = ethSendFrame(interface, destMacAddr, buffer, offset, ETH_TYPE_ARP);
 
@@ -55,6 +55,9 @@ void icmpProcessMessage(NetInterface *interface,
    size_t length;
    IcmpHeader *header;
 
+   //Total number of ICMP messages which the entity received
+   MIB2_INC_COUNTER(icmp.icmpInMsgs, 1);
+
    //Retrieve the length of the ICMP message
    length = chunkedBufferGetLength(buffer) - offset;
 
@@ -63,6 +66,9 @@ void icmpProcessMessage(NetInterface *interface,
    {
       //Debug message
       TRACE_WARNING("ICMP message length is invalid!\r\n");
+      //Number of ICMP messages which the entity received but determined
+      //as having ICMP-specific errors
+      MIB2_INC_COUNTER(icmp.icmpInErrors, 1);
       //Silently discard incoming message
       return;
    }
@@ -82,6 +88,9 @@ void icmpProcessMessage(NetInterface *interface,
    {
       //Debug message
       TRACE_WARNING("Wrong ICMP header checksum!\r\n");
+      //Number of ICMP messages which the entity received but determined
+      //as having ICMP-specific errors
+      MIB2_INC_COUNTER(icmp.icmpInErrors, 1);
       //Drop incoming message
       return;
    }
@@ -91,9 +100,24 @@ void icmpProcessMessage(NetInterface *interface,
    {
    //Echo request?
    case ICMP_TYPE_ECHO_REQUEST:
+      //Number of ICMP Echo Request messages received
+      MIB2_INC_COUNTER(icmp.icmpInEchos, 1);
       //Process Echo Request message
       icmpProcessEchoRequest(interface, srcIpAddr, buffer, offset);
       break;
+   //Destination Unreachable message?
+   case ICMP_TYPE_DEST_UNREACHABLE:
+      //Number of ICMP Destination Unreachable messages received
+      MIB2_INC_COUNTER(icmp.icmpInDestUnreachs, 1);
+      //Process Destination Unreachable message
+      icmpProcessDestUnreachable(interface, srcIpAddr, buffer, offset);
+      break;
+   //Echo Reply message?
+   case ICMP_TYPE_ECHO_REPLY:
+      //Number of ICMP Echo Reply messages received
+      MIB2_INC_COUNTER(icmp.icmpInEchoReps, 1);
+      //Echo Reply messages are handled by raw sockets
+      break;
    //Unknown type?
    default:
       //Debug message
@@ -144,7 +168,14 @@ void icmpProcessEchoRequest(NetInterface *interface,
    //Allocate memory to hold the Echo Reply message
    reply = ipAllocBuffer(sizeof(IcmpEchoMessage), &replyOffset);
    //Failed to allocate memory?
-   if(!reply) return;
+   if(!reply)
+   {
+      //Number of ICMP messages which this entity did not send due
+      //to problems discovered within ICMP such as a lack of buffers
+      MIB2_INC_COUNTER(icmp.icmpOutErrors, 1);
+      //Exit immediately
+      return;
+   }
 
    //Point to the Echo Reply header
    replyHeader = chunkedBufferAt(reply, replyOffset);
@@ -188,6 +219,11 @@ void icmpProcessEchoRequest(NetInterface *interface,
    //Dump message contents for debugging purpose
    icmpDumpEchoMessage(replyHeader);
 
+   //Total number of ICMP messages which this entity attempted to send
+   MIB2_INC_COUNTER(icmp.icmpOutMsgs, 1);
+   //Number of ICMP Echo Reply messages sent
+   MIB2_INC_COUNTER(icmp.icmpOutEchoReps, 1);
+
    //Send Echo Reply message
    ipv4SendDatagram(interface, &pseudoHeader, reply, replyOffset, IPV4_DEFAULT_TTL);
 
@@ -196,6 +232,64 @@ void icmpProcessEchoRequest(NetInterface *interface,
 }
 
 
+/**
+ * @brief Destination Unreachable message processing
+ * @param[in] interface Underlying network interface
+ * @param[in] srcIpAddr Source IPv4 address
+ * @param[in] buffer Multi-part buffer containing the incoming Destination Unreachable message
+ * @param[in] offset Offset to the first byte of the Destination Unreachable message
+ **/
+
+void icmpProcessDestUnreachable(NetInterface *interface,
+   Ipv4Addr srcIpAddr, const ChunkedBuffer *buffer, size_t offset)
+{
+   size_t length;
+   size_t pathMtu;
+   IcmpFragNeededMessage *message;
+   Ipv4Header ipHeader;
+
+   //Retrieve the length of the message
+   length = chunkedBufferGetLength(buffer) - offset;
+
+   //The message must include the header of the invoking datagram
+   if(length < (sizeof(IcmpFragNeededMessage) + sizeof(Ipv4Header)))
+      return;
+
+   //Point to the message header
+   message = chunkedBufferAt(buffer, offset);
+   //Sanity check
+   if(!message) return;
+
+   //Only Fragmentation Needed messages are relevant
+   if(message->code != ICMP_CODE_FRAGMENTATION_NEEDED)
+      return;
+
+   //Debug message
+   TRACE_INFO("ICMP Fragmentation Needed message received (%u bytes)...\r\n", length);
+
+   //Copy the header of the invoking datagram
+   chunkedBufferRead(&ipHeader, buffer, offset + sizeof(IcmpFragNeededMessage), sizeof(Ipv4Header));
+
+   //Make sure the invoking datagram was originated by this host
+   if(ipHeader.srcAddr != interface->ipv4Config.addr)
+      return;
+
+   //Retrieve the MTU of the next-hop network
+   pathMtu = ntohs(message->nextHopMtu);
+
+   //Routers that do not implement RFC 1191 set the Next-Hop MTU field to zero
+   if(!pathMtu)
+      pathMtu = ipv4GetPlateauMtu(ntohs(ipHeader.totalLength));
+
+   //A reported MTU that is not smaller than the datagram is bogus
+   if(pathMtu >= ntohs(ipHeader.totalLength))
+      return;
+
+   //Update the path MTU cache
+   ipv4UpdatePathMtu(interface, ipHeader.destAddr, pathMtu);
+}
+
+
 /**
  * @brief Send an ICMP Error message
  * @param[in] interface Underlying network interface
@@ -243,7 +337,14 @@ error_t icmpSendErrorMessage(NetInterface *interface, uint8_t type,
    //Allocate a memory buffer to hold the ICMP message
    icmpMessage = ipAllocBuffer(sizeof(IcmpErrorMessage), &offset);
    //Failed to allocate memory?
-   if(!icmpMessage) return ERROR_OUT_OF_MEMORY;
+   if(!icmpMessage)
+   {
+      //Number of ICMP messages which this entity did not send due
+      //to problems discovered within ICMP such as a lack of buffers
+      MIB2_INC_COUNTER(icmp.icmpOutErrors, 1);
+      //Report an error
+      return ERROR_OUT_OF_MEMORY;
+   }
 
    //Point to the ICMP header
    icmpHeader = chunkedBufferAt(icmpMessage, offset);
@@ -283,6 +384,13 @@ error_t icmpSendErrorMessage(NetInterface *interface, uint8_t type,
    //Dump message contents for debugging purpose
    icmpDumpErrorMessage(icmpHeader);
 
+   //Total number of ICMP messages which this entity attempted to send
+   MIB2_INC_COUNTER(icmp.icmpOutMsgs, 1);
+
+   //Number of ICMP Destination Unreachable messages sent
+   if(type == ICMP_TYPE_DEST_UNREACHABLE)
+      MIB2_INC_COUNTER(icmp.icmpOutDestUnreachs, 1);
+
    //Send ICMP Error message
    error = ipv4SendDatagram(interface, &pseudoHeader,
       icmpMessage, offset, IPV4_DEFAULT_TTL);
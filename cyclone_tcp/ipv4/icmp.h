@@ -131,6 +131,25 @@ typedef __packed struct
 } IcmpDestUnreachableMessage;
 
 
+/**
+ * @brief ICMP Fragmentation Needed message
+ *
+ * A Destination Unreachable message with code 4 carries the MTU
+ * of the next-hop network (refer to RFC 1191)
+ *
+ **/
+
+typedef __packed struct
+{
+   uint8_t type;        //0
+   uint8_t code;        //1
+   uint16_t checksum;   //2-3
+   uint16_t unused;     //4-5
+   uint16_t nextHopMtu; //6-7
+   uint8_t data[];      //8
+} IcmpFragNeededMessage;
+
+
 /**
  * @brief ICMP Time Exceeded message
  **/
@@ -188,6 +207,9 @@ void icmpProcessMessage(NetInterface *interface,
 void icmpProcessEchoRequest(NetInterface *interface,
    Ipv4Addr srcIpAddr, const ChunkedBuffer *request, size_t requestOffset);
 
+void icmpProcessDestUnreachable(NetInterface *interface,
+   Ipv4Addr srcIpAddr, const ChunkedBuffer *buffer, size_t offset);
+
 error_t icmpSendErrorMessage(NetInterface *interface, uint8_t type,
    uint8_t code, uint8_t parameter, const ChunkedBuffer *ipPacket);
 
@@ -91,6 +91,28 @@ error_t ipv4Init(NetInterface *interface)
 
    //Clear the reassembly queue
    memset(interface->ipv4FragQueue, 0, sizeof(interface->ipv4FragQueue));
+   memset(interface->ipv4FragTable, 0, sizeof(interface->ipv4FragTable));
+   //The reassembly queue does not hold any memory yet
+   interface->ipv4FragMemUsage = 0;
+#endif
+
+#if (IPV4_PMTU_SUPPORT == ENABLED)
+   //Create a mutex to prevent simultaneous access to the path MTU cache
+   interface->ipv4PmtuCacheMutex = osMutexCreate(FALSE);
+   //Any error to report?
+   if(interface->ipv4PmtuCacheMutex == OS_INVALID_HANDLE)
+   {
+      //Clean up side effects
+      osMutexClose(interface->ipv4FilterMutex);
+#if (IPV4_FRAG_SUPPORT == ENABLED)
+      osMutexClose(interface->ipv4FragQueueMutex);
+#endif
+      //Stop immediately
+      return ERROR_OUT_OF_RESOURCES;
+   }
+
+   //Clear the path MTU cache
+   memset(interface->ipv4PmtuCache, 0, sizeof(interface->ipv4PmtuCache));
 #endif
 
    //Successful initialization
@@ -109,32 +131,47 @@ error_t ipv4Init(NetInterface *interface)
 void ipv4ProcessPacket(NetInterface *interface,
    const MacAddr *srcMacAddr, Ipv4Header *packet, size_t length)
 {
+   //Total number of input datagrams received
+   MIB2_INC_COUNTER(ipv4.ipInReceives, 1);
+
    //Ensure the packet length is greater than 20 bytes
    if(length < sizeof(Ipv4Header))
+   {
+      //Number of input datagrams discarded due to errors in their IP headers
+      MIB2_INC_COUNTER(ipv4.ipInHdrErrors, 1);
+      //Discard incoming packet
       return;
+   }
 
    //Debug message
    TRACE_INFO("IPv4 packet received (%u bytes)...\r\n", length);
    //Dump IP header contents for debugging purpose
    ipv4DumpHeader(packet);
 
-   //A packet whose version number is not 4 must be silently discarded
-   if(packet->version != IPV4_VERSION)
-      return;
-   //Valid IPv4 header shall contains more than five 32-bit words
-   if(packet->headerLength < 5)
-      return;
-   //Ensure the total length is correct before processing the packet
-   if(ntohs(packet->totalLength) < (packet->headerLength * 4))
-      return;
-   if(ntohs(packet->totalLength) > length)
-      return;
-   //Destination address filtering
-   if(ipv4CheckDestAddr(interface, packet->destAddr))
+   //A packet whose version number is not 4 must be silently discarded.
+   //Valid IPv4 header shall contains more than five 32-bit words. Also
+   //ensure the total length is correct before processing the packet
+   if(packet->version != IPV4_VERSION ||
+      packet->headerLength < 5 ||
+      ntohs(packet->totalLength) < (packet->headerLength * 4) ||
+      ntohs(packet->totalLength) > length)
+   {
+      //Number of input datagrams discarded due to errors in their IP headers
+      MIB2_INC_COUNTER(ipv4.ipInHdrErrors, 1);
+      //Discard incoming packet
       return;
-   //Source address filtering
-   if(ipv4CheckSourceAddr(interface, packet->srcAddr))
+   }
+
+   //Destination and source address filtering
+   if(ipv4CheckDestAddr(interface, packet->destAddr) ||
+      ipv4CheckSourceAddr(interface, packet->srcAddr))
+   {
+      //Number of input datagrams discarded because the IP address
+      //was not a valid address to be received at this entity
+      MIB2_INC_COUNTER(ipv4.ipInAddrErrors, 1);
+      //Discard incoming packet
       return;
+   }
 
    //The host must verify the IP header checksum on every received
    //datagram and silently discard every datagram that has a bad
@@ -143,6 +180,8 @@ void ipv4ProcessPacket(NetInterface *interface,
    {
       //Debug message
       TRACE_WARNING("Wrong IP header checksum!\r\n");
+      //Number of input datagrams discarded due to errors in their IP headers
+      MIB2_INC_COUNTER(ipv4.ipInHdrErrors, 1);
       //Discard incoming packet
       return;
    }
@@ -153,6 +192,9 @@ void ipv4ProcessPacket(NetInterface *interface,
    //A fragmented packet was received?
    if(ntohs(packet->fragmentOffset) & (IPV4_FLAG_MF | IPV4_OFFSET_MASK))
    {
+      //Number of IP fragments received which needed to be reassembled
+      MIB2_INC_COUNTER(ipv4.ipReasmReqds, 1);
+
 #if (IPV4_FRAG_SUPPORT == ENABLED)
       //Acquire exclusive access to the reassembly queue
       osMutexAcquire(interface->ipv4FragQueueMutex);
@@ -225,6 +267,8 @@ void ipv4ProcessDatagram(NetInterface *interface,
    {
    //ICMP protocol?
    case IPV4_PROTOCOL_ICMP:
+      //Number of input datagrams delivered to IP user-protocols
+      MIB2_INC_COUNTER(ipv4.ipInDelivers, 1);
       //Process incoming ICMP message
       icmpProcessMessage(interface, header->srcAddr, buffer, offset);
 #if (RAW_SOCKET_SUPPORT == ENABLED)
@@ -239,6 +283,8 @@ void ipv4ProcessDatagram(NetInterface *interface,
 #if (IGMP_SUPPORT == ENABLED)
    //IGMP protocol?
    case IPV4_PROTOCOL_IGMP:
+      //Number of input datagrams delivered to IP user-protocols
+      MIB2_INC_COUNTER(ipv4.ipInDelivers, 1);
       //Process incoming IGMP message
       igmpProcessMessage(interface, buffer, offset);
 #if (RAW_SOCKET_SUPPORT == ENABLED)
@@ -254,8 +300,11 @@ void ipv4ProcessDatagram(NetInterface *interface,
 #if (TCP_SUPPORT == ENABLED)
    //TCP protocol?
    case IPV4_PROTOCOL_TCP:
+      //Number of input datagrams delivered to IP user-protocols
+      MIB2_INC_COUNTER(ipv4.ipInDelivers, 1);
       //Process incoming TCP segment
-      tcpProcessSegment(interface, &pseudoHeader, buffer, offset);
+      tcpProcessSegment(interface, &pseudoHeader, buffer, offset,
+         header->typeOfService & IP_ECN_CE);
       //No error to report
       error = NO_ERROR;
       //Continue processing
@@ -265,6 +314,8 @@ void ipv4ProcessDatagram(NetInterface *interface,
 #if (UDP_SUPPORT == ENABLED)
    //UDP protocol?
    case IPV4_PROTOCOL_UDP:
+      //Number of input datagrams delivered to IP user-protocols
+      MIB2_INC_COUNTER(ipv4.ipInDelivers, 1);
       //Process incoming UDP datagram
       error = udpProcessDatagram(interface, &pseudoHeader, buffer, offset);
       //Continue processing
@@ -280,6 +331,11 @@ void ipv4ProcessDatagram(NetInterface *interface,
       //Report an error
       error = ERROR_PROTOCOL_UNREACHABLE;
 #endif
+      //Update statistics
+      if(error == ERROR_PROTOCOL_UNREACHABLE)
+         MIB2_INC_COUNTER(ipv4.ipInUnknownProtos, 1);
+      else
+         MIB2_INC_COUNTER(ipv4.ipInDelivers, 1);
       //Continue processing
       break;
    }
@@ -307,31 +363,53 @@ void ipv4ProcessDatagram(NetInterface *interface,
  * @param[in] pseudoHeader IPv4 pseudo header
  * @param[in] buffer Multi-part buffer containing the payload
  * @param[in] offset Offset to the first byte of the payload
- * @param[in] timeToLive TTL value
+ * @param[in] flags TTL value and ECN codepoint (see #IpFlags)
  * @return Error code
  **/
 
 error_t ipv4SendDatagram(NetInterface *interface, Ipv4PseudoHeader *pseudoHeader,
-   ChunkedBuffer *buffer, size_t offset, uint8_t timeToLive)
+   ChunkedBuffer *buffer, size_t offset, uint_t flags)
 {
    error_t error;
    size_t length;
+   size_t pathMtu;
    uint16_t id;
+   uint16_t fragOffset;
+
+   //Total number of IP datagrams which local IP user-protocols
+   //supplied to IP in requests for transmission
+   MIB2_INC_COUNTER(ipv4.ipOutRequests, 1);
 
    //Retrieve the length of payload
    length = chunkedBufferGetLength(buffer) - offset;
+   //Retrieve the MTU of the path to the destination
+   pathMtu = ipv4GetPathMtu(interface, pseudoHeader->destAddr);
 
    //Identification field is primarily used to identify
    //fragments of an original IP datagram
    id = osAtomicInc16(&interface->ipv4Identification);
 
-   //If the payload length is smaller than the network
-   //interface MTU then no fragmentation is needed
-   if(length <= IPV4_MAX_PAYLOAD_SIZE)
+   //If the payload length is smaller than the path MTU
+   //then no fragmentation is needed
+   if((length + sizeof(Ipv4Header)) <= pathMtu)
    {
+      //Routers are allowed to fragment the datagram by default
+      fragOffset = 0;
+
+#if (IPV4_PMTU_SUPPORT == ENABLED)
+      //Set the DF flag so that a router that cannot forward the datagram
+      //reports its next-hop MTU instead (refer to RFC 1191). Datagrams that
+      //any link is able to carry do not take part in the discovery
+      if((length + sizeof(Ipv4Header)) > IPV4_DEFAULT_MTU &&
+         !ipv4IsBroadcastAddr(interface, pseudoHeader->destAddr) &&
+         !ipv4IsMulticastAddr(pseudoHeader->destAddr))
+      {
+         fragOffset = IPV4_FLAG_DF;
+      }
+#endif
       //Send data as is
       error = ipv4SendPacket(interface,
-         pseudoHeader, id, 0, buffer, offset, timeToLive);
+         pseudoHeader, id, fragOffset, buffer, offset, flags);
    }
    //If the payload length exceeds the network interface MTU
    //then the device must fragment the data
@@ -340,8 +418,10 @@ error_t ipv4SendDatagram(NetInterface *interface, Ipv4PseudoHeader *pseudoHeader
 #if (IPV4_FRAG_SUPPORT == ENABLED)
       //Fragment IP datagram into smaller packets
       error = ipv4FragmentDatagram(interface,
-         pseudoHeader, id, buffer, offset, timeToLive);
+         pseudoHeader, id, buffer, offset, pathMtu, flags);
 #else
+      //Number of datagrams that needed to be fragmented but could not be
+      MIB2_INC_COUNTER(ipv4.ipFragFails, 1);
       //Fragmentation is not supported
       error = ERROR_MESSAGE_TOO_LONG;
 #endif
@@ -360,12 +440,12 @@ error_t ipv4SendDatagram(NetInterface *interface, Ipv4PseudoHeader *pseudoHeader
  * @param[in] fragOffset Fragment offset field
  * @param[in] buffer Multi-part buffer containing the payload
  * @param[in] offset Offset to the first byte of the payload
- * @param[in] timeToLive TTL value
+ * @param[in] flags TTL value and ECN codepoint (see #IpFlags)
  * @return Error code
  **/
 
 error_t ipv4SendPacket(NetInterface *interface, Ipv4PseudoHeader *pseudoHeader,
-   uint16_t fragId, uint16_t fragOffset, ChunkedBuffer *buffer, size_t offset, uint8_t timeToLive)
+   uint16_t fragId, uint16_t fragOffset, ChunkedBuffer *buffer, size_t offset, uint_t flags)
 {
    error_t error;
    size_t length;
@@ -388,11 +468,11 @@ error_t ipv4SendPacket(NetInterface *interface, Ipv4PseudoHeader *pseudoHeader,
    //Format IPv4 header
    packet->version = IPV4_VERSION;
    packet->headerLength = 5;
-   packet->typeOfService = 0;
+   packet->typeOfService = (flags & IP_FLAG_ECN) >> 8;
    packet->totalLength = htons(length);
    packet->identification = htons(fragId);
    packet->fragmentOffset = htons(fragOffset);
-   packet->timeToLive = timeToLive;
+   packet->timeToLive = flags & IP_FLAG_TTL;
    packet->protocol = pseudoHeader->protocol;
    packet->headerChecksum = 0;
    packet->srcAddr = pseudoHeader->srcAddr;
@@ -489,6 +569,12 @@ error_t ipv4SendPacket(NetInterface *interface, Ipv4PseudoHeader *pseudoHeader,
    {
       //Debug message
       TRACE_WARNING("Cannot map IPv4 address to Ethernet address!\r\n");
+
+      //No route could be found to transmit the datagram?
+      if(error == ERROR_NO_ROUTE)
+         MIB2_INC_COUNTER(ipv4.ipOutNoRoutes, 1);
+      else
+         MIB2_INC_COUNTER(ipv4.ipOutDiscards, 1);
    }
 
    //Return status code
@@ -735,6 +821,174 @@ error_t ipv4MapMulticastAddrToMac(Ipv4Addr ipAddr, MacAddr *macAddr)
 }
 
 
+/**
+ * @brief Retrieve the MTU of the path to a given destination
+ * @param[in] interface Underlying network interface
+ * @param[in] destAddr Destination IPv4 address
+ * @return Path MTU
+ **/
+
+size_t ipv4GetPathMtu(NetInterface *interface, Ipv4Addr destAddr)
+{
+   size_t pathMtu;
+
+#if (IPV4_PMTU_SUPPORT == ENABLED)
+   uint_t i;
+   time_t time;
+   Ipv4PmtuEntry *entry;
+
+   //Get current time
+   time = osGetTickCount();
+#endif
+
+   //Use the MTU of the first hop unless a smaller value has been learned
+   pathMtu = interface->mtu;
+
+#if (IPV4_PMTU_SUPPORT == ENABLED)
+   //Acquire exclusive access to the path MTU cache
+   osMutexAcquire(interface->ipv4PmtuCacheMutex);
+
+   //Loop through path MTU cache entries
+   for(i = 0; i < IPV4_PMTU_CACHE_SIZE; i++)
+   {
+      //Point to the current entry
+      entry = &interface->ipv4PmtuCache[i];
+
+      //Matching entry?
+      if(entry->pathMtu && entry->destAddr == destAddr)
+      {
+         //Stale estimates are discarded so that an increase in the
+         //path MTU can be detected (refer to RFC 1191 section 6.3)
+         if(timeCompare(time, entry->timestamp + IPV4_PMTU_TIMEOUT) >= 0)
+            entry->pathMtu = 0;
+         else
+            pathMtu = min(entry->pathMtu, interface->mtu);
+
+         //We are done
+         break;
+      }
+   }
+
+   //Release exclusive access to the path MTU cache
+   osMutexRelease(interface->ipv4PmtuCacheMutex);
+#endif
+
+   //Return the MTU of the path
+   return pathMtu;
+}
+
+
+/**
+ * @brief Record a lower path MTU for a given destination
+ * @param[in] interface Underlying network interface
+ * @param[in] destAddr Destination IPv4 address
+ * @param[in] pathMtu New path MTU estimate
+ **/
+
+void ipv4UpdatePathMtu(NetInterface *interface, Ipv4Addr destAddr, size_t pathMtu)
+{
+#if (IPV4_PMTU_SUPPORT == ENABLED)
+   uint_t i;
+   time_t time;
+   Ipv4PmtuEntry *entry;
+   Ipv4PmtuEntry *oldestEntry;
+
+   //Get current time
+   time = osGetTickCount();
+
+   //Do not let forged ICMP messages shrink the path MTU below the
+   //minimum every link must support
+   pathMtu = max(pathMtu, IPV4_DEFAULT_MTU);
+
+   //The path MTU cannot exceed the MTU of the first hop
+   if(pathMtu >= interface->mtu)
+      return;
+
+   //Acquire exclusive access to the path MTU cache
+   osMutexAcquire(interface->ipv4PmtuCacheMutex);
+
+   //Keep track of the oldest entry
+   oldestEntry = &interface->ipv4PmtuCache[0];
+
+   //Loop through path MTU cache entries
+   for(i = 0; i < IPV4_PMTU_CACHE_SIZE; i++)
+   {
+      //Point to the current entry
+      entry = &interface->ipv4PmtuCache[i];
+
+      //Matching entry?
+      if(entry->pathMtu && entry->destAddr == destAddr)
+         break;
+
+      //Keep track of the oldest entry (free entries are used first)
+      if(oldestEntry->pathMtu)
+      {
+         if(!entry->pathMtu || timeCompare(entry->timestamp, oldestEntry->timestamp) < 0)
+            oldestEntry = entry;
+      }
+   }
+
+   //No entry found for the specified destination?
+   if(i >= IPV4_PMTU_CACHE_SIZE)
+   {
+      //Reuse the oldest entry
+      entry = oldestEntry;
+      entry->destAddr = destAddr;
+      entry->pathMtu = pathMtu;
+      entry->timestamp = time;
+   }
+   //The path MTU can only be decreased, unless the estimate is stale
+   else if(pathMtu < entry->pathMtu ||
+      timeCompare(time, entry->timestamp + IPV4_PMTU_TIMEOUT) >= 0)
+   {
+      entry->pathMtu = pathMtu;
+      entry->timestamp = time;
+   }
+
+   //Debug message
+   TRACE_INFO("Path MTU to %s is now %u bytes\r\n",
+      ipv4AddrToString(destAddr, NULL), entry->pathMtu);
+
+   //Release exclusive access to the path MTU cache
+   osMutexRelease(interface->ipv4PmtuCacheMutex);
+#endif
+}
+
+
+/**
+ * @brief Estimate the path MTU using the plateau table
+ *
+ * Routers that predate RFC 1191 do not report their next-hop MTU. The
+ * estimate is then the greatest plateau value strictly less than the
+ * total length of the datagram that could not be forwarded
+ *
+ * @param[in] length Total length of the datagram
+ * @return Path MTU estimate
+ **/
+
+size_t ipv4GetPlateauMtu(size_t length)
+{
+   uint_t i;
+
+   //Table of MTU plateaus (refer to RFC 1191 section 7)
+   static const uint16_t plateau[] =
+   {
+      32000, 17914, 8166, 4352, 2002, 1492, 1006, 508, 296, 68
+   };
+
+   //Search the plateau table
+   for(i = 0; i < arraysize(plateau); i++)
+   {
+      //Greatest plateau less than the datagram length?
+      if(plateau[i] < length)
+         return plateau[i];
+   }
+
+   //Return the smallest plateau
+   return plateau[i - 1];
+}
+
+
 /**
  * @brief Convert a dot-decimal string to a binary IPv4 address
  * @param[in] str NULL-terminated string representing the IPv4 address
@@ -62,6 +62,27 @@
    #error IPV4_FILTER_MAX_SIZE parameter is invalid
 #endif
 
+//Path MTU discovery support
+#ifndef IPV4_PMTU_SUPPORT
+   #define IPV4_PMTU_SUPPORT ENABLED
+#elif (IPV4_PMTU_SUPPORT != ENABLED && IPV4_PMTU_SUPPORT != DISABLED)
+   #error IPV4_PMTU_SUPPORT parameter is invalid
+#endif
+
+//Size of the path MTU cache
+#ifndef IPV4_PMTU_CACHE_SIZE
+   #define IPV4_PMTU_CACHE_SIZE 8
+#elif (IPV4_PMTU_CACHE_SIZE < 1)
+   #error IPV4_PMTU_CACHE_SIZE parameter is invalid
+#endif
+
+//Lifetime of a path MTU estimate
+#ifndef IPV4_PMTU_TIMEOUT
+   #define IPV4_PMTU_TIMEOUT 600000
+#elif (IPV4_PMTU_TIMEOUT < 300000)
+   #error IPV4_PMTU_TIMEOUT parameter is invalid
+#endif
+
 //Version number for IPv4
 #define IPV4_VERSION 4
 //Minimum MTU that routers and physical links are required to handle
@@ -70,8 +91,6 @@
 #define IPV4_MIN_HEADER_LENGTH 20
 //Maximum header length
 #define IPV4_MAX_HEADER_LENGTH 60
-//Maximum payload size
-#define IPV4_MAX_PAYLOAD_SIZE (ETH_MTU - sizeof(Ipv4Header))
 //Shortcut to data field
 #define IPV4_DATA(packet) PTR_OFFSET(packet, packet->headerLength * 4)
 
@@ -246,6 +265,18 @@ typedef struct
 } Ipv4FilterEntry;
 
 
+/**
+ * @brief Path MTU cache entry
+ **/
+
+typedef struct
+{
+   Ipv4Addr destAddr; ///<Destination IPv4 address
+   size_t pathMtu;    ///<Path MTU estimate
+   time_t timestamp;  ///<Time at which the estimate was last decreased
+} Ipv4PmtuEntry;
+
+
 //IPv4 related functions
 error_t ipv4Init(NetInterface *interface);
 
@@ -256,10 +287,10 @@ void ipv4ProcessDatagram(NetInterface *interface,
    const MacAddr *srcMacAddr, const ChunkedBuffer *buffer);
 
 error_t ipv4SendDatagram(NetInterface *interface, Ipv4PseudoHeader *pseudoHeader,
-   ChunkedBuffer *buffer, size_t offset, uint8_t timeToLive);
+   ChunkedBuffer *buffer, size_t offset, uint_t flags);
 
 error_t ipv4SendPacket(NetInterface *interface, Ipv4PseudoHeader *pseudoHeader,
-   uint16_t fragId, uint16_t fragOffset, ChunkedBuffer *buffer, size_t offset, uint8_t timeToLive);
+   uint16_t fragId, uint16_t fragOffset, ChunkedBuffer *buffer, size_t offset, uint_t flags);
 
 error_t ipv4CheckSourceAddr(NetInterface *interface, Ipv4Addr ipAddr);
 error_t ipv4CheckDestAddr(NetInterface *interface, Ipv4Addr ipAddr);
@@ -272,6 +303,10 @@ error_t ipv4LeaveMulticastGroup(NetInterface *interface, Ipv4Addr groupAddr);
 
 error_t ipv4MapMulticastAddrToMac(Ipv4Addr ipAddr, MacAddr *macAddr);
 
+size_t ipv4GetPathMtu(NetInterface *interface, Ipv4Addr destAddr);
+void ipv4UpdatePathMtu(NetInterface *interface, Ipv4Addr destAddr, size_t pathMtu);
+size_t ipv4GetPlateauMtu(size_t length);
+
 error_t ipv4StringToAddr(const char_t *str, Ipv4Addr *ipAddr);
 char_t *ipv4AddrToString(Ipv4Addr ipAddr, char_t *str);
 
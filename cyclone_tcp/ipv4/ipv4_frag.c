@@ -30,6 +30,7 @@
  * following RFCs for complete details:
  * - RFC 791: Internet Protocol specification
  * - RFC 815: IP datagram reassembly algorithms
+ * - RFC 1858: Security Considerations for IP Fragment Filtering
  *
  * @author Oryx Embedded (www.oryx-embedded.com)
  * @version 1.3.8
@@ -57,28 +58,37 @@
  * @param[in] id Fragment identification
  * @param[in] payload Multi-part buffer containing the payload
  * @param[in] payloadOffset Offset to the first payload byte
- * @param[in] timeToLive TTL value
+ * @param[in] pathMtu MTU of the path to the destination
+ * @param[in] flags TTL value and ECN codepoint (see #IpFlags)
  * @return Error code
  **/
 
 error_t ipv4FragmentDatagram(NetInterface *interface, Ipv4PseudoHeader *pseudoHeader,
-   uint16_t id, const ChunkedBuffer *payload, size_t payloadOffset, uint8_t timeToLive)
+   uint16_t id, const ChunkedBuffer *payload, size_t payloadOffset, size_t pathMtu, uint_t flags)
 {
    error_t error;
    size_t offset;
    size_t length;
+   size_t maxFragSize;
    size_t payloadLength;
    size_t fragmentOffset;
    ChunkedBuffer *fragment;
 
    //Retrieve the length of the payload
    payloadLength = chunkedBufferGetLength(payload) - payloadOffset;
+   //Maximum payload size for fragmented packets (shall be a multiple of 8-byte blocks)
+   maxFragSize = (pathMtu - sizeof(Ipv4Header)) & ~0x0007;
 
    //Allocate a memory buffer to hold IP fragments
    fragment = ipAllocBuffer(0, &fragmentOffset);
    //Failed to allocate memory?
    if(!fragment)
+   {
+      //Number of datagrams that needed to be fragmented but could not be
+      MIB2_INC_COUNTER(ipv4.ipFragFails, 1);
+      //Report an error
       return ERROR_OUT_OF_MEMORY;
+   }
 
    //Split the payload into multiple IP fragments
    for(offset = 0; offset < payloadLength; offset += length)
@@ -89,7 +99,7 @@ error_t ipv4FragmentDatagram(NetInterface *interface, Ipv4PseudoHeader *pseudoHe
       if(error) break;
 
       //Process the last fragment?
-      if((payloadLength - offset) <= IPV4_MAX_FRAG_SIZE)
+      if((payloadLength - offset) <= maxFragSize)
       {
          //Size of the current fragment
          length = payloadLength - offset;
@@ -98,24 +108,33 @@ error_t ipv4FragmentDatagram(NetInterface *interface, Ipv4PseudoHeader *pseudoHe
 
          //Do not set the MF flag for the last fragment
          error = ipv4SendPacket(interface, pseudoHeader, id,
-            offset / 8, fragment, fragmentOffset, timeToLive);
+            offset / 8, fragment, fragmentOffset, flags);
       }
       else
       {
          //Size of the current fragment (must be a multiple of 8-byte blocks)
-         length = IPV4_MAX_FRAG_SIZE;
+         length = maxFragSize;
          //Copy fragment data
          chunkedBufferConcat(fragment, payload, payloadOffset + offset, length);
 
          //Fragmented packets must have the MF flag set
          error = ipv4SendPacket(interface, pseudoHeader, id,
-            IPV4_FLAG_MF | (offset / 8), fragment, fragmentOffset, timeToLive);
+            IPV4_FLAG_MF | (offset / 8), fragment, fragmentOffset, flags);
       }
 
       //Failed to send current IP packet?
       if(error) break;
+
+      //Number of IP datagram fragments that have been generated
+      MIB2_INC_COUNTER(ipv4.ipFragCreates, 1);
    }
 
+   //Update fragmentation statistics
+   if(!error)
+      MIB2_INC_COUNTER(ipv4.ipFragOKs, 1);
+   else
+      MIB2_INC_COUNTER(ipv4.ipFragFails, 1);
+
    //Free previously allocated memory
    chunkedBufferFree(fragment);
    //Return status code
@@ -125,6 +144,12 @@ error_t ipv4FragmentDatagram(NetInterface *interface, Ipv4PseudoHeader *pseudoHe
 
 /**
  * @brief IPv4 datagram reassembly algorithm
+ *
+ * Each fragment is copied once out of the receive frame into memory pool
+ * blocks, which are then linked, sorted by offset, into the reassembly
+ * buffer. The reconstructed datagram is passed to the higher layer as a
+ * multi-part buffer that references these blocks directly
+ *
  * @param[in] interface Underlying network interface
  * @param[in] srcMacAddr MAC address of the source
  * @param[in] packet Pointer to the IPv4 fragmented packet
@@ -135,18 +160,26 @@ void ipv4ReassembleDatagram(NetInterface *interface,
    const MacAddr *srcMacAddr, const Ipv4Header *packet, size_t length)
 {
    error_t error;
+   uint_t i;
+   uint_t j;
+   uint_t n;
+   size_t k;
+   size_t pos;
    uint16_t offset;
-   uint16_t dataFirst;
-   uint16_t dataLast;
+   size_t dataFirst;
+   size_t dataLast;
+   ChunkDesc *chunk;
    Ipv4FragDesc *frag;
-   Ipv4HoleDesc *hole;
-   Ipv4HoleDesc *prevHole;
 
    //Get the length of the payload
    length -= packet->headerLength * 4;
    //Convert the fragment offset from network byte order
    offset = ntohs(packet->fragmentOffset);
 
+   //Fragments that do not carry any data are silently discarded
+   if(!length)
+      return;
+
    //Every fragment except the last must contain a multiple of 8 bytes of data
    if((offset & IPV4_FLAG_MF) && (length % 8))
    {
@@ -162,183 +195,223 @@ void ipv4ReassembleDatagram(NetInterface *interface,
    //Search for a matching IP datagram being reassembled
    frag = ipv4SearchFragQueue(interface, packet);
    //No matching entry in the reassembly queue?
-   if(!frag) return;
+   if(!frag)
+   {
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv4.ipReasmFails, 1);
+      //Exit immediately
+      return;
+   }
 
-   //The very first fragment requires special handling
-   if(!(offset & IPV4_OFFSET_MASK))
+   //Enforce the size of the reconstructed datagram
+   if((packet->headerLength * 4 + dataLast) > IPV4_MAX_FRAG_DATAGRAM_SIZE)
    {
-      //Calculate the length of the IP header including options
-      frag->headerLength = packet->headerLength * 4;
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv4.ipReasmFails, 1);
+      //Drop the partially reconstructed datagram
+      ipv4RemoveFragDesc(interface, frag);
+      //Exit immediately
+      return;
+   }
 
-      //Enforce the size of the reconstructed datagram
-      if((frag->headerLength + frag->dataLength) > IPV4_MAX_FRAG_DATAGRAM_SIZE)
-      {
-         //Drop any allocated resources
-         chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer, 0);
-         //Exit immediately
-         return;
-      }
+   //The first fragment must be large enough to hold the whole transport
+   //header, so that overlapping fragment attacks cannot alter it (RFC 1858)
+   if(!dataFirst && (offset & IPV4_FLAG_MF) && length < IPV4_MIN_FIRST_FRAG_SIZE)
+   {
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv4.ipReasmFails, 1);
+      //Drop the partially reconstructed datagram
+      ipv4RemoveFragDesc(interface, frag);
+      //Exit immediately
+      return;
+   }
 
-      //Make sure the IP header entirely fits in the first chunk
-      if(frag->headerLength > frag->buffer.chunk[0].size)
+   //Point to the last chunk of the reassembly buffer
+   i = frag->buffer.chunkCount - 1;
+
+   //The last fragment determines the total length of the payload
+   if(!(offset & IPV4_FLAG_MF))
+   {
+      //Inconsistent length or data received beyond the end of the datagram?
+      if((frag->dataLength && frag->dataLength != dataLast) ||
+         (i > 0 && (frag->offset[i] + frag->buffer.chunk[i].length) > dataLast))
       {
-         //Drop the reconstructed datagram
-         chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer, 0);
+         //Number of failures detected by the IP reassembly algorithm
+         MIB2_INC_COUNTER(ipv4.ipReasmFails, 1);
+         //Drop the partially reconstructed datagram
+         ipv4RemoveFragDesc(interface, frag);
          //Exit immediately
          return;
       }
+   }
+   else if(frag->dataLength && dataLast > frag->dataLength)
+   {
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv4.ipReasmFails, 1);
+      //Drop the partially reconstructed datagram
+      ipv4RemoveFragDesc(interface, frag);
+      //Exit immediately
+      return;
+   }
 
-      //Fix the length of the first chunk
-      frag->buffer.chunk[0].length = frag->headerLength;
-      //Always take the IP header from the first fragment
-      chunkedBufferWrite((ChunkedBuffer *) &frag->buffer, 0, packet, frag->headerLength);
+   //Chunks are sorted by offset. Find the first chunk that
+   //ends beyond the beginning of the newly arrived fragment
+   for(i = 1; i < frag->buffer.chunkCount; i++)
+   {
+      if((frag->offset[i] + frag->buffer.chunk[i].length) > dataFirst)
+         break;
    }
 
-   //It may be necessary to increase the size of the buffer...
-   if(dataLast > frag->dataLength)
+   //Check whether the fragment overlaps data that has already been received
+   if(i < frag->buffer.chunkCount && frag->offset[i] < dataLast)
    {
-      //Enforce the size of the reconstructed datagram
-      if((frag->headerLength + dataLast) > IPV4_MAX_FRAG_DATAGRAM_SIZE)
+      //Determine the extent of the contiguous data starting at this chunk
+      for(pos = frag->offset[i], j = i; j < frag->buffer.chunkCount; j++)
       {
-         //Drop any allocated resources
-         chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer, 0);
-         //Exit immediately
-         return;
-      }
+         if(frag->offset[j] != pos || pos >= dataLast)
+            break;
 
-      //Adjust the size of the reconstructed datagram
-      error = chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer,
-         frag->headerLength + dataLast + sizeof(Ipv4HoleDesc));
+         pos += frag->buffer.chunk[j].length;
+      }
 
-      //Any error to report?
-      if(error)
+      //Duplicate fragments are silently ignored. Partial overlaps
+      //denote a malformed or malicious datagram that must be dropped
+      if(frag->offset[i] > dataFirst || pos < dataLast)
       {
-         //Drop the reconstructed datagram
-         chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer, 0);
-         //Exit immediately
-         return;
+         //Number of failures detected by the IP reassembly algorithm
+         MIB2_INC_COUNTER(ipv4.ipReasmFails, 1);
+         //Drop the partially reconstructed datagram
+         ipv4RemoveFragDesc(interface, frag);
       }
 
-      //Actual length of the payload
-      frag->dataLength = dataLast;
+      //Exit immediately
+      return;
    }
 
-   //Select the first hole descriptor from the list
-   hole = ipv4FindHole(frag, frag->firstHole);
-   //Keep track of the previous hole in the list
-   prevHole = NULL;
+   //Number of memory blocks required to hold the fragment data
+   n = (length + MEM_POOL_BUFFER_SIZE - 1) / MEM_POOL_BUFFER_SIZE;
 
-   //Iterate through the hole descriptors
-   while(hole != NULL)
+   //Make sure the reassembly buffer can accommodate the additional chunks
+   if((frag->buffer.chunkCount + n) > frag->buffer.maxChunkCount)
    {
-      //Save lower and upper boundaries for later use
-      uint16_t holeFirst = hole->first;
-      uint16_t holeLast = hole->last;
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv4.ipReasmFails, 1);
+      //Drop the partially reconstructed datagram
+      ipv4RemoveFragDesc(interface, frag);
+      //Exit immediately
+      return;
+   }
 
-      //Check whether the newly arrived fragment
-      //interacts with this hole in some way
-      if(dataFirst < holeLast && dataLast > holeFirst)
-      {
-         //The current descriptor is no longer valid. We will destroy
-         //it, and in the next two steps, we will determine whether
-         //or not it is necessary to create any new hole descriptors
-         if(prevHole != NULL)
-            prevHole->next = hole->next;
-         else
-            frag->firstHole = hole->next;
-
-         //Is there still a hole at the beginning of the segment?
-         if(dataFirst > holeFirst)
-         {
-            //Create a new entry that describes this hole
-            hole = ipv4FindHole(frag, holeFirst);
-            hole->first = holeFirst;
-            hole->last = dataFirst;
+   //Enforce the memory budget of the reassembly queue
+   error = ipv4FragReserveMem(interface, frag, n * MEM_POOL_BUFFER_SIZE);
+   //Any error to report?
+   if(error)
+   {
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv4.ipReasmFails, 1);
+      //Drop the partially reconstructed datagram
+      ipv4RemoveFragDesc(interface, frag);
+      //Exit immediately
+      return;
+   }
 
-            //Insert the newly created entry into the hole descriptor list
-            if(prevHole != NULL)
-            {
-               hole->next = prevHole->next;
-               prevHole->next = hole->first;
-            }
-            else
-            {
-               hole->next = frag->firstHole;
-               frag->firstHole = hole->first;
-            }
+   //Make room for the new chunks
+   memmove(&frag->buffer.chunk[i + n], &frag->buffer.chunk[i],
+      (frag->buffer.chunkCount - i) * sizeof(ChunkDesc));
+   memmove(&frag->offset[i + n], &frag->offset[i],
+      (frag->buffer.chunkCount - i) * sizeof(uint16_t));
 
-            //Always keep track of the previous hole
-            prevHole = hole;
-         }
+   //Adjust the number of chunks
+   frag->buffer.chunkCount += n;
 
-         //Is there still a hole at the end of the segment?
-         if(dataLast < holeLast && (offset & IPV4_FLAG_MF))
-         {
-            //Create a new entry that describes this hole
-            hole = ipv4FindHole(frag, dataLast);
-            hole->first = dataLast;
-            hole->last = holeLast;
+   //Copy the fragment data
+   for(k = 0, j = i; j < (i + n); j++)
+   {
+      //Point to the current chunk descriptor
+      chunk = &frag->buffer.chunk[j];
 
-            //Insert the newly created entry into the hole descriptor list
-            if(prevHole != NULL)
-            {
-               hole->next = prevHole->next;
-               prevHole->next = hole->first;
-            }
-            else
-            {
-               hole->next = frag->firstHole;
-               frag->firstHole = hole->first;
-            }
+      //Allocate a memory block
+      chunk->address = (error) ? NULL : memPoolAlloc(MEM_POOL_BUFFER_SIZE);
 
-            //Always keep track of the previous hole
-            prevHole = hole;
-         }
+      //Failed to allocate memory?
+      if(!chunk->address)
+      {
+         //Mark the current chunk as free
+         chunk->length = 0;
+         chunk->size = 0;
+         //Report an error
+         error = ERROR_OUT_OF_MEMORY;
       }
       else
       {
-         //The newly arrived fragment does not interact with the current hole
-         prevHole = hole;
+         //Copy the current block of data
+         chunk->length = min(length - k, MEM_POOL_BUFFER_SIZE);
+         chunk->size = MEM_POOL_BUFFER_SIZE;
+         memcpy(chunk->address, (uint8_t *) IPV4_DATA(packet) + k, chunk->length);
       }
 
-      //Select the next hole descriptor from the list
-      hole = ipv4FindHole(frag, prevHole ? prevHole->next : frag->firstHole);
+      //Save the offset of the chunk within the payload
+      frag->offset[j] = dataFirst + k;
+      //Next block
+      k += MEM_POOL_BUFFER_SIZE;
    }
 
-   //Copy data from the fragment to the reassembly buffer
-   chunkedBufferWrite((ChunkedBuffer *) &frag->buffer,
-      frag->headerLength + dataFirst, IPV4_DATA(packet), length);
+   //Failed to allocate memory?
+   if(error)
+   {
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv4.ipReasmFails, 1);
+      //Drop the partially reconstructed datagram
+      ipv4RemoveFragDesc(interface, frag);
+      //Exit immediately
+      return;
+   }
 
-   //Dump hole descriptor list
-   ipv4DumpHoleList(frag);
+   //Number of payload bytes received so far
+   frag->receivedLength += length;
 
-   //If the hole descriptor list is empty, the reassembly process is now complete
-   if(!ipv4FindHole(frag, frag->firstHole))
+   //The IP header is always taken from the first fragment
+   if(!dataFirst)
    {
-      //Discard the extra hole descriptor that follows the reconstructed datagram
-      error = chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer,
-         frag->headerLength + frag->dataLength);
+      //Calculate the length of the IP header including options
+      frag->headerLength = packet->headerLength * 4;
+      //Save the IP header
+      memcpy(frag->header, packet, frag->headerLength);
+      //Fix the length of the first chunk
+      frag->buffer.chunk[0].length = frag->headerLength;
+   }
 
-      //Check status code
-      if(!error)
-      {
-         //Point to the IP header
-         Ipv4Header *datagram = chunkedBufferAt((ChunkedBuffer *) &frag->buffer, 0);
+   //The last fragment gives the length of the original payload
+   if(!(offset & IPV4_FLAG_MF))
+      frag->dataLength = dataLast;
 
-         //Fix IP header
-         datagram->totalLength = htons(frag->headerLength + frag->dataLength);
-         datagram->fragmentOffset = 0;
-         datagram->headerChecksum = 0;
+   //Dump the list of received fragments
+   ipv4DumpFragList(frag);
 
-         //Recalculate IP header checksum
-         datagram->headerChecksum = ipCalcChecksum(datagram, frag->buffer.chunk[0].length);
+   //The reassembly process is complete when the first and the last fragments
+   //have been received and there is no remaining hole in the payload
+   if(frag->headerLength && frag->dataLength &&
+      frag->receivedLength == frag->dataLength)
+   {
+      //Point to the IP header
+      Ipv4Header *datagram = (Ipv4Header *) frag->header;
 
-         //Pass the original IPv4 datagram to the higher protocol layer
-         ipv4ProcessDatagram(interface, srcMacAddr, (ChunkedBuffer *) &frag->buffer);
-      }
+      //Fix IP header
+      datagram->totalLength = htons(frag->headerLength + frag->dataLength);
+      datagram->fragmentOffset = 0;
+      datagram->headerChecksum = 0;
+
+      //Recalculate IP header checksum
+      datagram->headerChecksum = ipCalcChecksum(datagram, frag->headerLength);
+
+      //Pass the original IPv4 datagram to the higher protocol layer
+      ipv4ProcessDatagram(interface, srcMacAddr, (ChunkedBuffer *) &frag->buffer);
+
+      //Number of IP datagrams successfully reassembled
+      MIB2_INC_COUNTER(ipv4.ipReasmOKs, 1);
 
       //Release previously allocated memory
-      chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer, 0);
+      ipv4RemoveFragDesc(interface, frag);
    }
 }
 
@@ -354,10 +427,8 @@ void ipv4ReassembleDatagram(NetInterface *interface,
 
 void ipv4FragTick(NetInterface *interface)
 {
-   error_t error;
    uint_t i;
    time_t time;
-   Ipv4HoleDesc *hole;
 
    //Acquire exclusive access to the reassembly queue
    osMutexAcquire(interface->ipv4FragQueueMutex);
@@ -380,31 +451,23 @@ void ipv4FragTick(NetInterface *interface)
          {
             //Debug message
             TRACE_INFO("IPv4 fragment reassembly timeout...\r\n");
-            //Dump IP header contents for debugging purpose
-            ipv4DumpHeader(frag->buffer.chunk[0].address);
-
-            //Point to the first hole descriptor
-            hole = ipv4FindHole(frag, frag->firstHole);
 
             //Make sure the fragment zero has been received
             //before sending an ICMP message
-            if(hole != NULL && hole->first > 0)
+            if(frag->headerLength > 0)
             {
-               //Fix the size of the reconstructed datagram
-               error = chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer,
-                  frag->headerLength + hole->first);
-
-               //Check status code
-               if(!error)
-               {
-                  //Send an ICMP Time Exceeded message
-                  icmpSendErrorMessage(interface, ICMP_TYPE_TIME_EXCEEDED,
-                     ICMP_CODE_REASSEMBLY_TIME_EXCEEDED, 0, (ChunkedBuffer *) &frag->buffer);
-               }
+               //Dump IP header contents for debugging purpose
+               ipv4DumpHeader((Ipv4Header *) frag->header);
+
+               //Send an ICMP Time Exceeded message
+               icmpSendErrorMessage(interface, ICMP_TYPE_TIME_EXCEEDED,
+                  ICMP_CODE_REASSEMBLY_TIME_EXCEEDED, 0, (ChunkedBuffer *) &frag->buffer);
             }
 
+            //Number of failures detected by the IP reassembly algorithm
+            MIB2_INC_COUNTER(ipv4.ipReasmFails, 1);
             //Drop the partially reconstructed datagram
-            chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer, 0);
+            ipv4RemoveFragDesc(interface, frag);
          }
       }
    }
@@ -423,40 +486,37 @@ void ipv4FragTick(NetInterface *interface)
 
 Ipv4FragDesc *ipv4SearchFragQueue(NetInterface *interface, const Ipv4Header *packet)
 {
-   error_t error;
    uint_t i;
-   Ipv4Header *datagram;
+   uint_t h;
    Ipv4FragDesc *frag;
-   Ipv4HoleDesc *hole;
-
-   //Search for a matching IP datagram being reassembled
-   for(i = 0; i < IPV4_MAX_FRAG_DATAGRAMS; i++)
-   {
-      //Point to the current entry in the reassembly queue
-      frag = &interface->ipv4FragQueue[i];
-
-      //Check whether the current entry is used?
-      if(frag->buffer.chunkCount > 0)
-      {
-         //Point to the corresponding datagram
-         datagram = chunkedBufferAt((ChunkedBuffer *) &frag->buffer, 0);
+   Ipv4FragDesc *oldestFrag;
 
-         //Check source and destination addresses
-         if(datagram->srcAddr != packet->srcAddr)
-            continue;
-         if(datagram->destAddr != packet->destAddr)
-            continue;
-         //Compare identification and protocol fields
-         if(datagram->identification != packet->identification)
-            continue;
-         if(datagram->protocol != packet->protocol)
-            continue;
+   //Datagrams being reassembled are indexed by source address, destination
+   //address, identification and protocol fields
+   h = ipv4FragHash(packet->srcAddr, packet->destAddr,
+      packet->identification, packet->protocol);
 
-         //A matching entry has been found in the reassembly queue
-         return frag;
-      }
+   //Search the corresponding hash bucket for a matching IP datagram
+   for(frag = interface->ipv4FragTable[h]; frag != NULL; frag = frag->next)
+   {
+      //Check source and destination addresses
+      if(frag->srcAddr != packet->srcAddr)
+         continue;
+      if(frag->destAddr != packet->destAddr)
+         continue;
+      //Compare identification and protocol fields
+      if(frag->identification != packet->identification)
+         continue;
+      if(frag->protocol != packet->protocol)
+         continue;
+
+      //A matching entry has been found in the reassembly queue
+      return frag;
    }
 
+   //Keep track of the oldest entry
+   oldestFrag = NULL;
+
    //If the current packet does not match an existing entry
    //in the reassembly queue, then create a new entry
    for(i = 0; i < IPV4_MAX_FRAG_DATAGRAMS; i++)
@@ -466,55 +526,56 @@ Ipv4FragDesc *ipv4SearchFragQueue(NetInterface *interface, const Ipv4Header *pac
 
       //The current entry is free?
       if(!frag->buffer.chunkCount)
-      {
-         //Number of chunks that comprise the reassembly buffer
-         frag->buffer.maxChunkCount = arraysize(frag->buffer.chunk);
+         break;
 
-         //Allocate sufficient memory to hold the IPv4 header and
-         //the first hole descriptor
-         error = chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer,
-            MEM_POOL_BUFFER_SIZE + sizeof(Ipv4HoleDesc));
-
-         //Failed to allocate memory?
-         if(error)
-         {
-            //Clean up side effects
-            chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer, 0);
-            //Exit immediately
-            return NULL;
-         }
-
-         //Initial length of the reconstructed datagram
-         frag->headerLength = packet->headerLength * 4;
-         frag->dataLength = 0;
-
-         //Fix the length of the first chunk
-         frag->buffer.chunk[0].length = frag->headerLength;
-         //Copy IPv4 header from the incoming fragment
-         chunkedBufferWrite((ChunkedBuffer *) &frag->buffer, 0, packet, frag->headerLength);
-
-         //Save current time
-         frag->timestamp = osGetTickCount();
-         //Create a new entry in the hole descriptor list
-         frag->firstHole = 0;
-
-         //Point to first hole descriptor
-         hole = ipv4FindHole(frag, frag->firstHole);
-         //The entry describes the datagram  as  being completely missing
-         hole->first = 0;
-         hole->last = IPV4_INFINITY;
-         hole->next = IPV4_INFINITY;
-
-         //Dump hole descriptor list
-         ipv4DumpHoleList(frag);
+      //Keep track of the oldest entry
+      if(oldestFrag == NULL || timeCompare(frag->timestamp, oldestFrag->timestamp) < 0)
+         oldestFrag = frag;
+   }
 
-         //Return the matching fragment descriptor
-         return frag;
-      }
+   //The reassembly queue is full?
+   if(i >= IPV4_MAX_FRAG_DATAGRAMS)
+   {
+      //Debug message
+      TRACE_INFO("IPv4 reassembly queue full, evicting the oldest datagram...\r\n");
+
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv4.ipReasmFails, 1);
+      //Drop the oldest partially reconstructed datagram
+      ipv4RemoveFragDesc(interface, oldestFrag);
+      //Reuse the corresponding entry
+      frag = oldestFrag;
    }
 
-   //The reassembly queue is full
-   return NULL;
+   //The first chunk holds the IP header
+   frag->buffer.chunkCount = 1;
+   frag->buffer.maxChunkCount = arraysize(frag->buffer.chunk);
+   frag->buffer.chunk[0].address = frag->header;
+   frag->buffer.chunk[0].length = 0;
+   frag->buffer.chunk[0].size = 0;
+   frag->offset[0] = 0;
+
+   //Save the fields that identify the datagram
+   frag->srcAddr = packet->srcAddr;
+   frag->destAddr = packet->destAddr;
+   frag->identification = packet->identification;
+   frag->protocol = packet->protocol;
+
+   //Initial length of the reconstructed datagram
+   frag->headerLength = 0;
+   frag->dataLength = 0;
+   frag->receivedLength = 0;
+   frag->memUsage = 0;
+
+   //Save current time
+   frag->timestamp = osGetTickCount();
+
+   //Insert the new entry at the head of the hash bucket
+   frag->next = interface->ipv4FragTable[h];
+   interface->ipv4FragTable[h] = frag;
+
+   //Return the matching fragment descriptor
+   return frag;
 }
 
 
@@ -534,7 +595,8 @@ void ipv4FlushFragQueue(NetInterface *interface)
    for(i = 0; i < IPV4_MAX_FRAG_DATAGRAMS; i++)
    {
       //Drop any partially reconstructed datagram
-      chunkedBufferSetLength((ChunkedBuffer *) &interface->ipv4FragQueue[i].buffer, 0);
+      if(interface->ipv4FragQueue[i].buffer.chunkCount > 0)
+         ipv4RemoveFragDesc(interface, &interface->ipv4FragQueue[i]);
    }
 
    //Release exclusive access to the reassembly queue
@@ -543,43 +605,151 @@ void ipv4FlushFragQueue(NetInterface *interface)
 
 
 /**
- * @brief Retrieve hole descriptor
- * @param[in] frag IPv4 fragment descriptor
- * @param[in] offset Offset of the hole
- * @return A pointer to the hole descriptor is returned if the
- *   specified offset is valid. Otherwise NULL is returned
+ * @brief Compute the hash bucket of a fragmented datagram
+ * @param[in] srcAddr Source address
+ * @param[in] destAddr Destination address
+ * @param[in] identification Identification field
+ * @param[in] protocol Protocol field
+ * @return Index of the hash bucket
+ **/
+
+uint_t ipv4FragHash(Ipv4Addr srcAddr, Ipv4Addr destAddr,
+   uint16_t identification, uint8_t protocol)
+{
+   uint32_t h;
+
+   //Combine the fields that identify the datagram
+   h = srcAddr ^ destAddr;
+   h ^= (uint32_t) identification << 16;
+   h ^= protocol;
+
+   //Fold the resulting value
+   h ^= h >> 16;
+   h ^= h >> 8;
+
+   //Return the index of the hash bucket
+   return h % IPV4_FRAG_HASH_TABLE_SIZE;
+}
+
+
+/**
+ * @brief Remove an entry from the reassembly queue
+ * @param[in] interface Underlying network interface
+ * @param[in] frag IPv4 fragment descriptor to be released
  **/
 
-Ipv4HoleDesc *ipv4FindHole(Ipv4FragDesc *frag, uint16_t offset)
+void ipv4RemoveFragDesc(NetInterface *interface, Ipv4FragDesc *frag)
 {
-   //Return a pointer to the hole descriptor
-   return chunkedBufferAt((ChunkedBuffer *) &frag->buffer, frag->headerLength + offset);
+   uint_t h;
+   Ipv4FragDesc **p;
+
+   //Retrieve the hash bucket the entry belongs to
+   h = ipv4FragHash(frag->srcAddr, frag->destAddr,
+      frag->identification, frag->protocol);
+
+   //Unlink the entry from its hash bucket
+   for(p = &interface->ipv4FragTable[h]; *p != NULL; p = &(*p)->next)
+   {
+      if(*p == frag)
+      {
+         *p = frag->next;
+         break;
+      }
+   }
+
+   //Release the memory blocks that hold the fragments
+   chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer, 0);
+
+   //Update the memory usage of the reassembly queue
+   interface->ipv4FragMemUsage -= frag->memUsage;
+
+   //Mark the entry as free
+   frag->next = NULL;
+   frag->memUsage = 0;
 }
 
 
 /**
- * @brief Dump hole descriptor list
+ * @brief Reserve memory for an incoming fragment
+ *
+ * When the memory budget of the reassembly queue is exhausted, the
+ * oldest datagrams are evicted until enough memory is available
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] frag IPv4 fragment descriptor the memory is reserved for
+ * @param[in] size Number of bytes to reserve
+ * @return Error code
+ **/
+
+error_t ipv4FragReserveMem(NetInterface *interface, Ipv4FragDesc *frag, size_t size)
+{
+   uint_t i;
+   Ipv4FragDesc *oldestFrag;
+
+   //Evict the oldest datagrams until the budget allows the reservation
+   while((interface->ipv4FragMemUsage + size) > IPV4_FRAG_MAX_MEM_USAGE)
+   {
+      //Keep track of the oldest entry
+      oldestFrag = NULL;
+
+      //Loop through the reassembly queue
+      for(i = 0; i < IPV4_MAX_FRAG_DATAGRAMS; i++)
+      {
+         //Skip free entries and the datagram the memory is reserved for
+         if(!interface->ipv4FragQueue[i].buffer.chunkCount)
+            continue;
+         if(&interface->ipv4FragQueue[i] == frag)
+            continue;
+
+         //Check the age of the current entry
+         if(oldestFrag == NULL || timeCompare(interface->ipv4FragQueue[i].timestamp,
+            oldestFrag->timestamp) < 0)
+         {
+            oldestFrag = &interface->ipv4FragQueue[i];
+         }
+      }
+
+      //No datagram can be evicted?
+      if(oldestFrag == NULL)
+         return ERROR_OUT_OF_RESOURCES;
+
+      //Debug message
+      TRACE_INFO("IPv4 reassembly memory exhausted, evicting the oldest datagram...\r\n");
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv4.ipReasmFails, 1);
+      //Drop the oldest partially reconstructed datagram
+      ipv4RemoveFragDesc(interface, oldestFrag);
+   }
+
+   //Update the memory usage of the reassembly queue
+   interface->ipv4FragMemUsage += size;
+   frag->memUsage += size;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Dump the list of received fragments
  * @param[in] frag IPv4 fragment descriptor
  **/
 
-void ipv4DumpHoleList(Ipv4FragDesc *frag)
+void ipv4DumpFragList(Ipv4FragDesc *frag)
 {
 //Check debugging level
 #if (TRACE_LEVEL >= TRACE_LEVEL_DEBUG)
-   Ipv4HoleDesc *hole;
+   uint_t i;
 
    //Debug message
-   TRACE_DEBUG("Hole descriptor list:\r\n");
-   //Select the first hole descriptor from the list
-   hole = ipv4FindHole(frag, frag->firstHole);
+   TRACE_DEBUG("Received fragments:\r\n");
 
-   //Loop through the hole descriptor list
-   while(hole != NULL)
+   //Loop through the chunks that hold the payload
+   for(i = 1; i < frag->buffer.chunkCount; i++)
    {
-      //Display current hole
-      TRACE_DEBUG("  %u - %u\r\n", hole->first, hole->last);
-      //Select the next hole descriptor from the list
-      hole = ipv4FindHole(frag, hole->next);
+      //Display current chunk
+      TRACE_DEBUG("  %u - %u\r\n", frag->offset[i],
+         frag->offset[i] + frag->buffer.chunk[i].length);
    }
 #endif
 }
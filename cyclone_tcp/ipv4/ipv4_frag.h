@@ -58,10 +58,31 @@
 //Maximum datagram size the host will accept when reassembling fragments
 #ifndef IPV4_MAX_FRAG_DATAGRAM_SIZE
    #define IPV4_MAX_FRAG_DATAGRAM_SIZE 8192
-#elif (IPV4_MAX_FRAG_DATAGRAM_SIZE < 1)
+#elif (IPV4_MAX_FRAG_DATAGRAM_SIZE < 1 || IPV4_MAX_FRAG_DATAGRAM_SIZE > 65535)
    #error IPV4_MAX_FRAG_DATAGRAM_SIZE parameter is invalid
 #endif
 
+//Maximum number of data chunks that make up a reassembled datagram
+#ifndef IPV4_MAX_FRAG_CHUNKS
+   #define IPV4_MAX_FRAG_CHUNKS 16
+#elif (IPV4_MAX_FRAG_CHUNKS < 2)
+   #error IPV4_MAX_FRAG_CHUNKS parameter is invalid
+#endif
+
+//Size of the hash table used to locate datagrams being reassembled
+#ifndef IPV4_FRAG_HASH_TABLE_SIZE
+   #define IPV4_FRAG_HASH_TABLE_SIZE 8
+#elif (IPV4_FRAG_HASH_TABLE_SIZE < 1)
+   #error IPV4_FRAG_HASH_TABLE_SIZE parameter is invalid
+#endif
+
+//Maximum amount of memory the reassembly queue is allowed to consume
+#ifndef IPV4_FRAG_MAX_MEM_USAGE
+   #define IPV4_FRAG_MAX_MEM_USAGE (IPV4_MAX_FRAG_DATAGRAMS * IPV4_MAX_FRAG_DATAGRAM_SIZE)
+#elif (IPV4_FRAG_MAX_MEM_USAGE < MEM_POOL_BUFFER_SIZE)
+   #error IPV4_FRAG_MAX_MEM_USAGE parameter is invalid
+#endif
+
 //Maximum time an IPv4 fragment can spend waiting to be reassembled
 #ifndef IPV4_FRAG_TIME_TO_LIVE
    #define IPV4_FRAG_TIME_TO_LIVE 15000
@@ -69,45 +90,25 @@
    #error IPV4_FRAG_TIME_TO_LIVE parameter is invalid
 #endif
 
-//Maximum payload size for fragmented packets (shall be a multiple of 8-byte blocks)
-#define IPV4_MAX_FRAG_SIZE (IPV4_MAX_PAYLOAD_SIZE & ~0x0007)
+//Minimum payload size for the first fragment (see RFC 1858)
+#define IPV4_MIN_FIRST_FRAG_SIZE 64
 //Infinity is implemented by a very large integer
 #define IPV4_INFINITY 0xFFFF
 
 
-#if (defined(__GNUC__) || defined(_WIN32))
-   #define __packed
-   #pragma pack(push, 1)
-#endif
-
-
-/**
- * @brief Hole descriptor
- **/
-
-__packed typedef struct
-{
-   uint16_t first;
-   uint16_t last;
-   uint16_t next;
-} Ipv4HoleDesc;
-
-
-#if (defined(__GNUC__) || defined(_WIN32))
-   #undef __packed
-   #pragma pack(pop)
-#endif
-
-
 /**
  * @brief Reassembly buffer
+ *
+ * The first chunk holds the IPv4 header. The subsequent chunks
+ * reference the received fragments, sorted by offset
+ *
  **/
 
 typedef struct
 {
    uint_t chunkCount;
    uint_t maxChunkCount;
-   ChunkDesc chunk[N(IPV4_MAX_FRAG_DATAGRAM_SIZE) + 1];
+   ChunkDesc chunk[IPV4_MAX_FRAG_CHUNKS + 1];
 } Ipv4ReassemblyBuffer;
 
 
@@ -115,19 +116,27 @@ typedef struct
  * @brief Fragmented packet descriptor
  **/
 
-typedef struct
+typedef struct _Ipv4FragDesc
 {
-   time_t timestamp;            ///<Time at which the first fragment was received
-   size_t headerLength;         ///<Length of the header
-   size_t dataLength;           ///<Length of the payload
-   uint16_t firstHole;          ///<Index of the first hole
-   Ipv4ReassemblyBuffer buffer; ///<Buffer containing the reassembled datagram
+   struct _Ipv4FragDesc *next;                ///<Next entry in the same hash bucket
+   time_t timestamp;                          ///<Time at which the first fragment was received
+   Ipv4Addr srcAddr;                          ///<Source address
+   Ipv4Addr destAddr;                         ///<Destination address
+   uint16_t identification;                   ///<Identification field
+   uint8_t protocol;                          ///<Protocol field
+   size_t headerLength;                       ///<Length of the header
+   size_t dataLength;                         ///<Length of the payload (known once the last fragment is received)
+   size_t receivedLength;                     ///<Number of payload bytes received so far
+   size_t memUsage;                           ///<Amount of memory consumed by the fragments
+   uint16_t offset[IPV4_MAX_FRAG_CHUNKS + 1]; ///<Offset of each chunk within the payload
+   uint8_t header[IPV4_MAX_HEADER_LENGTH];    ///<IPv4 header taken from the first fragment
+   Ipv4ReassemblyBuffer buffer;               ///<Chunks that make up the reassembled datagram
 } Ipv4FragDesc;
 
 
 //IPv4 datagram fragmentation and reassembly
 error_t ipv4FragmentDatagram(NetInterface *interface, Ipv4PseudoHeader *pseudoHeader,
-   uint16_t id, const ChunkedBuffer *payload, size_t payloadOffset, uint8_t timeToLive);
+   uint16_t id, const ChunkedBuffer *payload, size_t payloadOffset, size_t pathMtu, uint_t flags);
 
 void ipv4ReassembleDatagram(NetInterface *interface,
    const MacAddr *srcMacAddr, const Ipv4Header *packet, size_t length);
@@ -137,7 +146,12 @@ void ipv4FragTick(NetInterface *interface);
 Ipv4FragDesc *ipv4SearchFragQueue(NetInterface *interface, const Ipv4Header *packet);
 void ipv4FlushFragQueue(NetInterface *interface);
 
-Ipv4HoleDesc *ipv4FindHole(Ipv4FragDesc *frag, uint16_t offset);
-void ipv4DumpHoleList(Ipv4FragDesc *frag);
+uint_t ipv4FragHash(Ipv4Addr srcAddr, Ipv4Addr destAddr,
+   uint16_t identification, uint8_t protocol);
+
+void ipv4RemoveFragDesc(NetInterface *interface, Ipv4FragDesc *frag);
+error_t ipv4FragReserveMem(NetInterface *interface, Ipv4FragDesc *frag, size_t size);
+
+void ipv4DumpFragList(Ipv4FragDesc *frag);
 
 #endif
@@ -65,6 +65,9 @@ void icmpv6ProcessMessage(NetInterface *interface, Ipv6PseudoHeader *pseudoHeade
    size_t length;
    Icmpv6Header *header;
 
+   //Total number of ICMP messages which the entity received
+   MIB2_INC_COUNTER(icmpv6.icmpInMsgs, 1);
+
    //Retrieve the length of the ICMPv6 message
    length = chunkedBufferGetLength(buffer) - offset;
 
@@ -73,6 +76,9 @@ void icmpv6ProcessMessage(NetInterface *interface, Ipv6PseudoHeader *pseudoHeade
    {
       //Debug message
       TRACE_WARNING("ICMPv6 message length is invalid!\r\n");
+      //Number of ICMP messages which the entity received but determined
+      //as having ICMP-specific errors
+      MIB2_INC_COUNTER(icmpv6.icmpInErrors, 1);
       //Exit immediately
       return;
    }
@@ -93,6 +99,9 @@ void icmpv6ProcessMessage(NetInterface *interface, Ipv6PseudoHeader *pseudoHeade
    {
       //Debug message
       TRACE_WARNING("Wrong ICMPv6 header checksum!\r\n");
+      //Number of ICMP messages which the entity received but determined
+      //as having ICMP-specific errors
+      MIB2_INC_COUNTER(icmpv6.icmpInErrors, 1);
       //Exit immediately
       return;
    }
@@ -102,9 +111,30 @@ void icmpv6ProcessMessage(NetInterface *interface, Ipv6PseudoHeader *pseudoHeade
    {
    //Echo Request message?
    case ICMPV6_TYPE_ECHO_REQUEST:
+      //Number of ICMP Echo Request messages received
+      MIB2_INC_COUNTER(icmpv6.icmpInEchos, 1);
       //Process Echo Request message
       icmpv6ProcessEchoRequest(interface, pseudoHeader, buffer, offset);
       break;
+   //Packet Too Big message?
+   case ICMPV6_TYPE_PACKET_TOO_BIG:
+      //Number of ICMP Packet Too Big messages received
+      MIB2_INC_COUNTER(icmpv6.icmpInPktTooBigs, 1);
+      //Process Packet Too Big message
+      icmpv6ProcessPacketTooBig(interface, pseudoHeader, buffer, offset);
+      break;
+   //Destination Unreachable message?
+   case ICMPV6_TYPE_DEST_UNREACHABLE:
+      //Number of ICMP Destination Unreachable messages received
+      MIB2_INC_COUNTER(icmpv6.icmpInDestUnreachs, 1);
+      //Discard incoming ICMPv6 message
+      break;
+   //Echo Reply message?
+   case ICMPV6_TYPE_ECHO_REPLY:
+      //Number of ICMP Echo Reply messages received
+      MIB2_INC_COUNTER(icmpv6.icmpInEchoReps, 1);
+      //Echo Reply messages are handled by raw sockets
+      break;
 #if (MLD_SUPPORT == ENABLED)
    //Multicast Listener Query message?
    case ICMPV6_TYPE_MULTICAST_LISTENER_QUERY:
@@ -177,7 +207,14 @@ void icmpv6ProcessEchoRequest(NetInterface *interface, Ipv6PseudoHeader *request
    //Allocate memory to hold the Echo Reply message
    reply = ipAllocBuffer(sizeof(Icmpv6EchoMessage), &replyOffset);
    //Failed to allocate memory?
-   if(!reply) return;
+   if(!reply)
+   {
+      //Number of ICMP messages which this entity did not send due
+      //to problems discovered within ICMP such as a lack of buffers
+      MIB2_INC_COUNTER(icmpv6.icmpOutErrors, 1);
+      //Exit immediately
+      return;
+   }
 
    //Point to the Echo Reply header
    replyHeader = chunkedBufferAt(reply, replyOffset);
@@ -223,6 +260,11 @@ void icmpv6ProcessEchoRequest(NetInterface *interface, Ipv6PseudoHeader *request
    //Dump message contents for debugging purpose
    icmpv6DumpEchoMessage(replyHeader);
 
+   //Total number of ICMP messages which this entity attempted to send
+   MIB2_INC_COUNTER(icmpv6.icmpOutMsgs, 1);
+   //Number of ICMP Echo Reply messages sent
+   MIB2_INC_COUNTER(icmpv6.icmpOutEchoReps, 1);
+
    //Send Echo Reply message
    ipv6SendDatagram(interface, &replyPseudoHeader, reply, replyOffset, IPV6_DEFAULT_HOP_LIMIT);
 
@@ -231,6 +273,52 @@ void icmpv6ProcessEchoRequest(NetInterface *interface, Ipv6PseudoHeader *request
 }
 
 
+/**
+ * @brief Packet Too Big message processing
+ * @param[in] interface Underlying network interface
+ * @param[in] pseudoHeader IPv6 pseudo header
+ * @param[in] buffer Multi-part buffer containing the incoming Packet Too Big message
+ * @param[in] offset Offset to the first byte of the Packet Too Big message
+ **/
+
+void icmpv6ProcessPacketTooBig(NetInterface *interface, Ipv6PseudoHeader *pseudoHeader,
+   const ChunkedBuffer *buffer, size_t offset)
+{
+   size_t length;
+   size_t pathMtu;
+   Icmpv6PacketTooBigMessage *message;
+   Ipv6Header ipHeader;
+
+   //Retrieve the length of the message
+   length = chunkedBufferGetLength(buffer) - offset;
+
+   //The message must include the header of the invoking packet
+   if(length < (sizeof(Icmpv6PacketTooBigMessage) + sizeof(Ipv6Header)))
+      return;
+
+   //Point to the message header
+   message = chunkedBufferAt(buffer, offset);
+   //Sanity check
+   if(!message) return;
+
+   //Debug message
+   TRACE_INFO("ICMPv6 Packet Too Big message received (%u bytes)...\r\n", length);
+
+   //Copy the header of the invoking packet
+   chunkedBufferRead(&ipHeader, buffer, offset + sizeof(Icmpv6PacketTooBigMessage), sizeof(Ipv6Header));
+
+   //Make sure the invoking packet was originated by this node
+   if(ipv6CheckDestAddr(interface, &ipHeader.srcAddr))
+      return;
+
+   //Retrieve the MTU of the next-hop link
+   pathMtu = ntohl(message->mtu);
+
+   //Update the path MTU cache
+   ipv6UpdatePathMtu(interface, &ipHeader.destAddr, pathMtu);
+}
+
+
 /**
  * @brief Send an ICMPv6 Error message
  * @param[in] interface Underlying network interface
@@ -276,7 +364,14 @@ error_t icmpv6SendErrorMessage(NetInterface *interface, uint8_t type,
    //Allocate a memory buffer to hold the ICMPv6 message
    icmpMessage = ipAllocBuffer(sizeof(Icmpv6ErrorMessage), &offset);
    //Failed to allocate memory?
-   if(!icmpMessage) return ERROR_OUT_OF_MEMORY;
+   if(!icmpMessage)
+   {
+      //Number of ICMP messages which this entity did not send due
+      //to problems discovered within ICMP such as a lack of buffers
+      MIB2_INC_COUNTER(icmpv6.icmpOutErrors, 1);
+      //Report an error
+      return ERROR_OUT_OF_MEMORY;
+   }
 
    //Point to the ICMPv6 header
    icmpHeader = chunkedBufferAt(icmpMessage, offset);
@@ -317,6 +412,13 @@ error_t icmpv6SendErrorMessage(NetInterface *interface, uint8_t type,
    //Dump message contents for debugging purpose
    icmpv6DumpErrorMessage(icmpHeader);
 
+   //Total number of ICMP messages which this entity attempted to send
+   MIB2_INC_COUNTER(icmpv6.icmpOutMsgs, 1);
+
+   //Number of ICMP Destination Unreachable messages sent
+   if(type == ICMPV6_TYPE_DEST_UNREACHABLE)
+      MIB2_INC_COUNTER(icmpv6.icmpOutDestUnreachs, 1);
+
    //Send ICMPv6 Error message
    error = ipv6SendDatagram(interface, &pseudoHeader,
       icmpMessage, offset, IPV6_DEFAULT_HOP_LIMIT);
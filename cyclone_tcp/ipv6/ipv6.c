@@ -38,6 +38,7 @@
 #include <string.h>
 #include <ctype.h>
 #include "tcp_ip_stack.h"
+#include "ip.h"
 #include "ipv6.h"
 #include "icmpv6.h"
 #include "mld.h"
@@ -107,6 +108,28 @@ error_t ipv6Init(NetInterface *interface)
 
    //Clear the reassembly queue
    memset(interface->ipv6FragQueue, 0, sizeof(interface->ipv6FragQueue));
+   memset(interface->ipv6FragTable, 0, sizeof(interface->ipv6FragTable));
+   //The reassembly queue does not hold any memory yet
+   interface->ipv6FragMemUsage = 0;
+#endif
+
+#if (IPV6_PMTU_SUPPORT == ENABLED)
+   //Create a mutex to prevent simultaneous access to the path MTU cache
+   interface->ipv6PmtuCacheMutex = osMutexCreate(FALSE);
+   //Any error to report?
+   if(interface->ipv6PmtuCacheMutex == OS_INVALID_HANDLE)
+   {
+      //Clean up side effects
+      osMutexClose(interface->ipv6FilterMutex);
+#if (IPV6_FRAG_SUPPORT == ENABLED)
+      osMutexClose(interface->ipv6FragQueueMutex);
+#endif
+      //Stop immediately
+      return ERROR_OUT_OF_RESOURCES;
+   }
+
+   //Clear the path MTU cache
+   memset(interface->ipv6PmtuCache, 0, sizeof(interface->ipv6PmtuCache));
 #endif
 
    //Successful initialization
@@ -134,9 +157,17 @@ void ipv6ProcessPacket(NetInterface *interface,
    //Retrieve the length of the IPv6 packet
    length = chunkedBufferGetLength(buffer);
 
+   //Total number of input datagrams received
+   MIB2_INC_COUNTER(ipv6.ipInReceives, 1);
+
    //Ensure the packet length is greater than 40 bytes
    if(length < sizeof(Ipv6Header))
+   {
+      //Number of input datagrams discarded due to errors in their IP headers
+      MIB2_INC_COUNTER(ipv6.ipInHdrErrors, 1);
+      //Discard incoming packet
       return;
+   }
 
    //Point to the IPv6 header
    packet = chunkedBufferAt(buffer, 0);
@@ -148,18 +179,27 @@ void ipv6ProcessPacket(NetInterface *interface,
    //Dump IPv6 header contents for debugging purpose
    ipv6DumpHeader(packet);
 
-   //Check IP version number
-   if(packet->version != IPV6_VERSION)
-      return;
-   //Ensure the payload length is correct before processing the packet
-   if(ntohs(packet->payloadLength) > (length - sizeof(Ipv6Header)))
-      return;
-   //Destination address filtering
-   if(ipv6CheckDestAddr(interface, &packet->destAddr))
+   //Check IP version number and ensure the payload length
+   //is correct before processing the packet
+   if(packet->version != IPV6_VERSION ||
+      ntohs(packet->payloadLength) > (length - sizeof(Ipv6Header)))
+   {
+      //Number of input datagrams discarded due to errors in their IP headers
+      MIB2_INC_COUNTER(ipv6.ipInHdrErrors, 1);
+      //Discard incoming packet
       return;
-   //Source address filtering
-   if(ipv6CheckSourceAddr(interface, &packet->srcAddr))
+   }
+
+   //Destination and source address filtering
+   if(ipv6CheckDestAddr(interface, &packet->destAddr) ||
+      ipv6CheckSourceAddr(interface, &packet->srcAddr))
+   {
+      //Number of input datagrams discarded because the IP address
+      //was not a valid address to be received at this entity
+      MIB2_INC_COUNTER(ipv6.ipInAddrErrors, 1);
+      //Discard incoming packet
       return;
+   }
 
    //Calculate the effective length of the IPv6 packet
    length = sizeof(Ipv6Header) + ntohs(packet->payloadLength);
@@ -214,6 +254,9 @@ void ipv6ProcessPacket(NetInterface *interface,
 
       //Fragment header?
       case IPV6_FRAGMENT_HEADER:
+         //Number of IP fragments received which needed to be reassembled
+         MIB2_INC_COUNTER(ipv6.ipReasmReqds, 1);
+
 #if (IPV6_FRAG_SUPPORT == ENABLED)
          //Acquire exclusive access to the reassembly queue
          osMutexAcquire(interface->ipv6FragQueueMutex);
@@ -241,6 +284,8 @@ void ipv6ProcessPacket(NetInterface *interface,
 
       //ICMPv6 header?
       case IPV6_ICMPV6_HEADER:
+         //Number of input datagrams delivered to IP user-protocols
+         MIB2_INC_COUNTER(ipv6.ipInDelivers, 1);
          //Process incoming ICMPv6 message
          icmpv6ProcessMessage(interface, &pseudoHeader.ipv6Data, buffer, offset, packet->hopLimit);
 #if (RAW_SOCKET_SUPPORT == ENABLED)
@@ -253,8 +298,11 @@ void ipv6ProcessPacket(NetInterface *interface,
 #if (TCP_SUPPORT == ENABLED)
       //TCP header?
       case IPV6_TCP_HEADER:
+         //Number of input datagrams delivered to IP user-protocols
+         MIB2_INC_COUNTER(ipv6.ipInDelivers, 1);
          //Process incoming TCP segment
-         tcpProcessSegment(interface, &pseudoHeader, buffer, offset);
+         tcpProcessSegment(interface, &pseudoHeader, buffer, offset,
+            packet->trafficClassL & IP_ECN_CE);
          //Exit immediately
          return;
 #endif
@@ -262,6 +310,8 @@ void ipv6ProcessPacket(NetInterface *interface,
 #if (UDP_SUPPORT == ENABLED)
       //UDP header?
       case IPV6_UDP_HEADER:
+         //Number of input datagrams delivered to IP user-protocols
+         MIB2_INC_COUNTER(ipv6.ipInDelivers, 1);
          //Process incoming UDP datagram
          udpProcessDatagram(interface, &pseudoHeader, buffer, offset);
          //Exit immediately
@@ -278,6 +328,8 @@ void ipv6ProcessPacket(NetInterface *interface,
       default:
          //Debug message
          TRACE_WARNING("Unrecognized Next Header type\r\n");
+         //Number of datagrams discarded because of an unknown protocol
+         MIB2_INC_COUNTER(ipv6.ipInUnknownProtos, 1);
 
          //Send an ICMP Parameter Problem message
          icmpv6SendErrorMessage(interface, ICMPV6_TYPE_PARAM_PROBLEM,
@@ -488,27 +540,34 @@ error_t ipv6ParseEspHeader(NetInterface *interface,
  * @param[in] pseudoHeader IPv6 pseudo header
  * @param[in] buffer Multi-part buffer containing the payload
  * @param[in] offset Offset to the first byte of the payload
- * @param[in] hopLimit Hop Limit value
+ * @param[in] flags Hop Limit value and ECN codepoint (see #IpFlags)
  * @return Error code
  **/
 
 
 error_t ipv6SendDatagram(NetInterface *interface, Ipv6PseudoHeader *pseudoHeader,
-   ChunkedBuffer *buffer, size_t offset, uint8_t hopLimit)
+   ChunkedBuffer *buffer, size_t offset, uint_t flags)
 {
    error_t error;
    size_t length;
+   size_t pathMtu;
+
+   //Total number of IP datagrams which local IP user-protocols
+   //supplied to IP in requests for transmission
+   MIB2_INC_COUNTER(ipv6.ipOutRequests, 1);
 
    //Retrieve the length of payload
    length = chunkedBufferGetLength(buffer) - offset;
+   //Retrieve the MTU of the path to the destination
+   pathMtu = ipv6GetPathMtu(interface, &pseudoHeader->destAddr);
 
-   //If the payload length is smaller than the network
-   //interface MTU then no fragmentation is needed
-   if(length <= IPV6_MAX_PAYLOAD_SIZE)
+   //If the payload length is smaller than the path MTU
+   //then no fragmentation is needed
+   if((length + sizeof(Ipv6Header)) <= pathMtu)
    {
       //Send data as is
       error = ipv6SendPacket(interface,
-         pseudoHeader, 0, 0, buffer, offset, hopLimit);
+         pseudoHeader, 0, 0, buffer, offset, flags);
    }
    //If the payload length exceeds the network interface MTU
    //then the device must fragment the data
@@ -517,8 +576,10 @@ error_t ipv6SendDatagram(NetInterface *interface, Ipv6PseudoHeader *pseudoHeader
 #if (IPV6_FRAG_SUPPORT == ENABLED)
       //Fragment IP datagram into smaller packets
       error = ipv6FragmentDatagram(interface,
-         pseudoHeader, buffer, offset, hopLimit);
+         pseudoHeader, buffer, offset, pathMtu, flags);
 #else
+      //Number of datagrams that needed to be fragmented but could not be
+      MIB2_INC_COUNTER(ipv6.ipFragFails, 1);
       //Fragmentation is not supported
       error = ERROR_MESSAGE_TOO_LONG;
 #endif
@@ -537,12 +598,12 @@ error_t ipv6SendDatagram(NetInterface *interface, Ipv6PseudoHeader *pseudoHeader
  * @param[in] fragOffset Fragment offset field
  * @param[in] buffer Multi-part buffer containing the payload
  * @param[in] offset Offset to the first byte of the payload
- * @param[in] hopLimit Hop Limit value
+ * @param[in] flags Hop Limit value and ECN codepoint (see #IpFlags)
  * @return Error code
  **/
 
 error_t ipv6SendPacket(NetInterface *interface, Ipv6PseudoHeader *pseudoHeader,
-   uint32_t fragId, uint16_t fragOffset, ChunkedBuffer *buffer, size_t offset, uint8_t hopLimit)
+   uint32_t fragId, uint16_t fragOffset, ChunkedBuffer *buffer, size_t offset, uint_t flags)
 {
    error_t error;
    size_t length;
@@ -602,11 +663,11 @@ error_t ipv6SendPacket(NetInterface *interface, Ipv6PseudoHeader *pseudoHeader,
    //Format IPv6 header
    packet->version = IPV6_VERSION;
    packet->trafficClassH = 0;
-   packet->trafficClassL = 0;
+   packet->trafficClassL = (flags & IP_FLAG_ECN) >> 8;
    packet->flowLabelH = 0;
    packet->flowLabelL = 0;
    packet->payloadLength = htons(length - sizeof(Ipv6Header));
-   packet->hopLimit = hopLimit;
+   packet->hopLimit = flags & IP_FLAG_TTL;
    packet->srcAddr = pseudoHeader->srcAddr;
    packet->destAddr = pseudoHeader->destAddr;
 
@@ -697,6 +758,12 @@ error_t ipv6SendPacket(NetInterface *interface, Ipv6PseudoHeader *pseudoHeader,
    {
       //Debug message
       TRACE_WARNING("Cannot map IPv6 address to Ethernet address!\r\n");
+
+      //No route could be found to transmit the datagram?
+      if(error == ERROR_NO_ROUTE)
+         MIB2_INC_COUNTER(ipv6.ipOutNoRoutes, 1);
+      else
+         MIB2_INC_COUNTER(ipv6.ipOutDiscards, 1);
    }
 
    //Return status code
@@ -1045,6 +1112,140 @@ error_t ipv6MapMulticastAddrToMac(const Ipv6Addr *ipAddr, MacAddr *macAddr)
 }
 
 
+/**
+ * @brief Retrieve the MTU of the path to a given destination
+ * @param[in] interface Underlying network interface
+ * @param[in] destAddr Destination IPv6 address
+ * @return Path MTU
+ **/
+
+size_t ipv6GetPathMtu(NetInterface *interface, const Ipv6Addr *destAddr)
+{
+   size_t pathMtu;
+
+#if (IPV6_PMTU_SUPPORT == ENABLED)
+   uint_t i;
+   time_t time;
+   Ipv6PmtuEntry *entry;
+
+   //Get current time
+   time = osGetTickCount();
+#endif
+
+   //Use the MTU of the first hop unless a smaller value has been learned
+   pathMtu = interface->mtu;
+
+#if (IPV6_PMTU_SUPPORT == ENABLED)
+   //Acquire exclusive access to the path MTU cache
+   osMutexAcquire(interface->ipv6PmtuCacheMutex);
+
+   //Loop through path MTU cache entries
+   for(i = 0; i < IPV6_PMTU_CACHE_SIZE; i++)
+   {
+      //Point to the current entry
+      entry = &interface->ipv6PmtuCache[i];
+
+      //Matching entry?
+      if(entry->pathMtu && ipv6CompAddr(&entry->destAddr, destAddr))
+      {
+         //Stale estimates are discarded so that an increase in the
+         //path MTU can be detected (refer to RFC 8201 section 4)
+         if(timeCompare(time, entry->timestamp + IPV6_PMTU_TIMEOUT) >= 0)
+            entry->pathMtu = 0;
+         else
+            pathMtu = min(entry->pathMtu, interface->mtu);
+
+         //We are done
+         break;
+      }
+   }
+
+   //Release exclusive access to the path MTU cache
+   osMutexRelease(interface->ipv6PmtuCacheMutex);
+#endif
+
+   //Return the MTU of the path
+   return pathMtu;
+}
+
+
+/**
+ * @brief Record a lower path MTU for a given destination
+ * @param[in] interface Underlying network interface
+ * @param[in] destAddr Destination IPv6 address
+ * @param[in] pathMtu New path MTU estimate
+ **/
+
+void ipv6UpdatePathMtu(NetInterface *interface, const Ipv6Addr *destAddr, size_t pathMtu)
+{
+#if (IPV6_PMTU_SUPPORT == ENABLED)
+   uint_t i;
+   time_t time;
+   Ipv6PmtuEntry *entry;
+   Ipv6PmtuEntry *oldestEntry;
+
+   //Get current time
+   time = osGetTickCount();
+
+   //A node must not reduce its estimate of the path MTU below the
+   //IPv6 minimum link MTU (refer to RFC 8201 section 4)
+   pathMtu = max(pathMtu, IPV6_DEFAULT_MTU);
+
+   //The path MTU cannot exceed the MTU of the first hop
+   if(pathMtu >= interface->mtu)
+      return;
+
+   //Acquire exclusive access to the path MTU cache
+   osMutexAcquire(interface->ipv6PmtuCacheMutex);
+
+   //Keep track of the oldest entry
+   oldestEntry = &interface->ipv6PmtuCache[0];
+
+   //Loop through path MTU cache entries
+   for(i = 0; i < IPV6_PMTU_CACHE_SIZE; i++)
+   {
+      //Point to the current entry
+      entry = &interface->ipv6PmtuCache[i];
+
+      //Matching entry?
+      if(entry->pathMtu && ipv6CompAddr(&entry->destAddr, destAddr))
+         break;
+
+      //Keep track of the oldest entry (free entries are used first)
+      if(oldestEntry->pathMtu)
+      {
+         if(!entry->pathMtu || timeCompare(entry->timestamp, oldestEntry->timestamp) < 0)
+            oldestEntry = entry;
+      }
+   }
+
+   //No entry found for the specified destination?
+   if(i >= IPV6_PMTU_CACHE_SIZE)
+   {
+      //Reuse the oldest entry
+      entry = oldestEntry;
+      entry->destAddr = *destAddr;
+      entry->pathMtu = pathMtu;
+      entry->timestamp = time;
+   }
+   //The path MTU can only be decreased, unless the estimate is stale
+   else if(pathMtu < entry->pathMtu ||
+      timeCompare(time, entry->timestamp + IPV6_PMTU_TIMEOUT) >= 0)
+   {
+      entry->pathMtu = pathMtu;
+      entry->timestamp = time;
+   }
+
+   //Debug message
+   TRACE_INFO("Path MTU to %s is now %u bytes\r\n",
+      ipv6AddrToString(destAddr, NULL), entry->pathMtu);
+
+   //Release exclusive access to the path MTU cache
+   osMutexRelease(interface->ipv6PmtuCacheMutex);
+#endif
+}
+
+
 /**
  * @brief Convert a string representation of an IPv6 address to a binary IPv6 address
  * @param[in] str NULL-terminated string representing the IPv6 address
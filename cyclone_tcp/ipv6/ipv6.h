@@ -62,12 +62,31 @@
    #error IPV6_FILTER_MAX_SIZE parameter is invalid
 #endif
 
+//Path MTU discovery support
+#ifndef IPV6_PMTU_SUPPORT
+   #define IPV6_PMTU_SUPPORT ENABLED
+#elif (IPV6_PMTU_SUPPORT != ENABLED && IPV6_PMTU_SUPPORT != DISABLED)
+   #error IPV6_PMTU_SUPPORT parameter is invalid
+#endif
+
+//Size of the path MTU cache
+#ifndef IPV6_PMTU_CACHE_SIZE
+   #define IPV6_PMTU_CACHE_SIZE 8
+#elif (IPV6_PMTU_CACHE_SIZE < 1)
+   #error IPV6_PMTU_CACHE_SIZE parameter is invalid
+#endif
+
+//Lifetime of a path MTU estimate
+#ifndef IPV6_PMTU_TIMEOUT
+   #define IPV6_PMTU_TIMEOUT 600000
+#elif (IPV6_PMTU_TIMEOUT < 300000)
+   #error IPV6_PMTU_TIMEOUT parameter is invalid
+#endif
+
 //Version number for IPv6
 #define IPV6_VERSION 6
 //Minimum MTU that routers and physical links are required to handle
 #define IPV6_DEFAULT_MTU 1280
-//Maximum payload size
-#define IPV6_MAX_PAYLOAD_SIZE (ETH_MTU - sizeof(Ipv6Header))
 
 //Macro used for defining IPv6 addresses
 #define IPV6_ADDR(a, b, c, d, e, f, g, h) {{{ \
@@ -328,6 +347,18 @@ typedef struct
 } Ipv6FilterEntry;
 
 
+/**
+ * @brief Path MTU cache entry
+ **/
+
+typedef struct
+{
+   Ipv6Addr destAddr; ///<Destination IPv6 address
+   size_t pathMtu;    ///<Path MTU estimate
+   time_t timestamp;  ///<Time at which the estimate was last decreased
+} Ipv6PmtuEntry;
+
+
 //IPv6 related constants
 extern const Ipv6Addr IPV6_UNSPECIFIED_ADDR;
 extern const Ipv6Addr IPV6_LOOPBACK_ADDR;
@@ -357,10 +388,10 @@ error_t ipv6ParseEspHeader(NetInterface *interface,
    const ChunkedBuffer *buffer, size_t *offset, size_t *nextHeaderOffset);
 
 error_t ipv6SendDatagram(NetInterface *interface, Ipv6PseudoHeader *pseudoHeader,
-   ChunkedBuffer *buffer, size_t offset, uint8_t hopLimit);
+   ChunkedBuffer *buffer, size_t offset, uint_t flags);
 
 error_t ipv6SendPacket(NetInterface *interface, Ipv6PseudoHeader *pseudoHeader,
-   uint32_t fragId, uint16_t fragOffset, ChunkedBuffer *buffer, size_t offset, uint8_t hopLimit);
+   uint32_t fragId, uint16_t fragOffset, ChunkedBuffer *buffer, size_t offset, uint_t flags);
 
 error_t ipv6CheckSourceAddr(NetInterface *interface, const Ipv6Addr *ipAddr);
 error_t ipv6CheckDestAddr(NetInterface *interface, const Ipv6Addr *ipAddr);
@@ -375,6 +406,9 @@ bool_t ipv6CompPrefix(const Ipv6Addr *ipAddr1, const Ipv6Addr *ipAddr2, size_t l
 error_t ipv6ComputeSolicitedNodeAddr(const Ipv6Addr *ipAddr, Ipv6Addr *solicitedNodeAddr);
 error_t ipv6MapMulticastAddrToMac(const Ipv6Addr *ipAddr, MacAddr *macAddr);
 
+size_t ipv6GetPathMtu(NetInterface *interface, const Ipv6Addr *destAddr);
+void ipv6UpdatePathMtu(NetInterface *interface, const Ipv6Addr *destAddr, size_t pathMtu);
+
 error_t ipv6StringToAddr(const char_t *str, Ipv6Addr *ipAddr);
 char_t *ipv6AddrToString(const Ipv6Addr *ipAddr, char_t *str);
 
@@ -47,17 +47,19 @@
  * @param[in] pseudoHeader IPv6 pseudo header
  * @param[in] payload Multi-part buffer containing the payload
  * @param[in] payloadOffset Offset to the first payload byte
- * @param[in] hopLimit Hop Limit value
+ * @param[in] pathMtu MTU of the path to the destination
+ * @param[in] flags Hop Limit value and ECN codepoint (see #IpFlags)
  * @return Error code
  **/
 
 error_t ipv6FragmentDatagram(NetInterface *interface, Ipv6PseudoHeader *pseudoHeader,
-   const ChunkedBuffer *payload, size_t payloadOffset, uint8_t hopLimit)
+   const ChunkedBuffer *payload, size_t payloadOffset, size_t pathMtu, uint_t flags)
 {
    error_t error;
    uint32_t id;
    size_t offset;
    size_t length;
+   size_t maxFragSize;
    size_t payloadLength;
    size_t fragmentOffset;
    ChunkedBuffer *fragment;
@@ -67,12 +69,19 @@ error_t ipv6FragmentDatagram(NetInterface *interface, Ipv6PseudoHeader *pseudoHe
 
    //Retrieve the length of the payload
    payloadLength = chunkedBufferGetLength(payload) - payloadOffset;
+   //Maximum payload size for fragmented packets (shall be a multiple of 8-byte blocks)
+   maxFragSize = (pathMtu - sizeof(Ipv6Header) - sizeof(Ipv6FragmentHeader)) & ~0x0007;
 
    //Allocate a memory buffer to hold IP fragments
    fragment = ipAllocBuffer(0, &fragmentOffset);
    //Failed to allocate memory?
    if(!fragment)
+   {
+      //Number of datagrams that needed to be fragmented but could not be
+      MIB2_INC_COUNTER(ipv6.ipFragFails, 1);
+      //Report an error
       return ERROR_OUT_OF_MEMORY;
+   }
 
    //Split the payload into multiple IP fragments
    for(offset = 0; offset < payloadLength; offset += length)
@@ -83,7 +92,7 @@ error_t ipv6FragmentDatagram(NetInterface *interface, Ipv6PseudoHeader *pseudoHe
       if(error) break;
 
       //Process the last fragment?
-      if((payloadLength - offset) <= IPV6_MAX_FRAG_SIZE)
+      if((payloadLength - offset) <= maxFragSize)
       {
          //Size of the current fragment
          length = payloadLength - offset;
@@ -92,24 +101,33 @@ error_t ipv6FragmentDatagram(NetInterface *interface, Ipv6PseudoHeader *pseudoHe
 
          //Do not set the MF flag for the last fragment
          error = ipv6SendPacket(interface, pseudoHeader, id,
-            offset, fragment, fragmentOffset, hopLimit);
+            offset, fragment, fragmentOffset, flags);
       }
       else
       {
          //Size of the current fragment (must be a multiple of 8-byte blocks)
-         length = IPV6_MAX_FRAG_SIZE;
+         length = maxFragSize;
          //Copy fragment data
          chunkedBufferConcat(fragment, payload, payloadOffset + offset, length);
 
          //Fragmented packets must have the M flag set
          error = ipv6SendPacket(interface, pseudoHeader, id,
-            offset | IPV6_FLAG_M, fragment, fragmentOffset, hopLimit);
+            offset | IPV6_FLAG_M, fragment, fragmentOffset, flags);
       }
 
       //Failed to send current IP fragment?
       if(error) break;
+
+      //Number of IP datagram fragments that have been generated
+      MIB2_INC_COUNTER(ipv6.ipFragCreates, 1);
    }
 
+   //Update fragmentation statistics
+   if(!error)
+      MIB2_INC_COUNTER(ipv6.ipFragOKs, 1);
+   else
+      MIB2_INC_COUNTER(ipv6.ipFragFails, 1);
+
    //Free previously allocated memory
    chunkedBufferFree(fragment);
    //Return status code
@@ -119,6 +137,12 @@ error_t ipv6FragmentDatagram(NetInterface *interface, Ipv6PseudoHeader *pseudoHe
 
 /**
  * @brief Parse Fragment header and reassemble original datagram
+ *
+ * Each fragment is copied once out of the incoming packet into memory pool
+ * blocks, which are then linked, sorted by offset, into the reassembly
+ * buffer. The reconstructed datagram is passed to the higher layer as a
+ * multi-part buffer that references these blocks directly
+ *
  * @param[in] interface Underlying network interface
  * @param[in] srcMacAddr MAC address of the source
  * @param[in] buffer Multi-part buffer containing the incoming IPv6 packet
@@ -130,13 +154,17 @@ void ipv6ParseFragmentHeader(NetInterface *interface, const MacAddr *srcMacAddr,
    const ChunkedBuffer *buffer, size_t fragHeaderOffset, size_t nextHeaderOffset)
 {
    error_t error;
+   uint_t i;
+   uint_t j;
+   uint_t n;
+   size_t k;
+   size_t pos;
    size_t length;
    uint16_t offset;
-   uint16_t dataFirst;
-   uint16_t dataLast;
+   size_t dataFirst;
+   size_t dataLast;
+   ChunkDesc *chunk;
    Ipv6FragDesc *frag;
-   Ipv6HoleDesc *hole;
-   Ipv6HoleDesc *prevHole;
    Ipv6Header *packet;
    Ipv6FragmentHeader *header;
 
@@ -178,6 +206,10 @@ void ipv6ParseFragmentHeader(NetInterface *interface, const MacAddr *srcMacAddr,
       return;
    }
 
+   //Fragments that do not carry any data are silently discarded
+   if(!length)
+      return;
+
    //Calculate the index of the first byte
    dataFirst = offset & IPV6_OFFSET_MASK;
    //Calculate the index immediately following the last byte
@@ -186,211 +218,260 @@ void ipv6ParseFragmentHeader(NetInterface *interface, const MacAddr *srcMacAddr,
    //Search for a matching IP datagram being reassembled
    frag = ipv6SearchFragQueue(interface, packet, header);
    //No matching entry in the reassembly queue?
-   if(!frag) return;
+   if(!frag)
+   {
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv6.ipReasmFails, 1);
+      //Exit immediately
+      return;
+   }
 
-   //The very first fragment requires special handling
-   if(!(offset & IPV6_OFFSET_MASK))
+   //The size of the reconstructed datagram exceeds the maximum value?
+   if((fragHeaderOffset + dataLast) > IPV6_MAX_FRAG_DATAGRAM_SIZE)
    {
-      uint8_t *p;
+      //Compute the offset of the Fragment Offset field within the packet
+      size_t n = fragHeaderOffset + (uint8_t *) &header->fragmentOffset -
+         (uint8_t *) header;
 
-      //Calculate the length of the unfragmentable part
-      frag->unfragPartLength = fragHeaderOffset;
+      //The fragment must be discarded and an ICMP Parameter Problem
+      //message should be sent to the source of the fragment, pointing
+      //to the Fragment Offset field of the fragment packet
+      icmpv6SendErrorMessage(interface, ICMPV6_TYPE_PARAM_PROBLEM,
+         ICMPV6_CODE_INVALID_HEADER_FIELD, n, buffer);
+
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv6.ipReasmFails, 1);
+      //Drop the partially reconstructed datagram
+      ipv6RemoveFragDesc(interface, frag);
+      //Exit immediately
+      return;
+   }
+
+   //The first fragment must include the whole header chain (refer to
+   //RFC 7112) and the unfragmentable part must fit in a single block
+   if(!dataFirst && (((offset & IPV6_FLAG_M) && length < IPV6_MIN_FIRST_FRAG_SIZE) ||
+      fragHeaderOffset > MEM_POOL_BUFFER_SIZE))
+   {
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv6.ipReasmFails, 1);
+      //Drop the partially reconstructed datagram
+      ipv6RemoveFragDesc(interface, frag);
+      //Exit immediately
+      return;
+   }
 
-      //The size of the reconstructed datagram exceeds the maximum value?
-      if((frag->unfragPartLength + frag->fragPartLength) > IPV6_MAX_FRAG_DATAGRAM_SIZE)
+   //Point to the last chunk of the reassembly buffer
+   i = frag->buffer.chunkCount - 1;
+
+   //The last fragment determines the length of the fragmentable part
+   if(!(offset & IPV6_FLAG_M))
+   {
+      //Inconsistent length or data received beyond the end of the datagram?
+      if((frag->fragPartLength && frag->fragPartLength != dataLast) ||
+         (i > 0 && (frag->offset[i] + frag->buffer.chunk[i].length) > dataLast))
       {
-         //Compute the offset of the Fragment Offset field within the packet
-         size_t n = fragHeaderOffset + (uint8_t *) &header->fragmentOffset -
-            (uint8_t *) header;
-
-         //The fragment must be discarded and an ICMP Parameter Problem
-         //message should be sent to the source of the fragment, pointing
-         //to the Fragment Offset field of the fragment packet
-         icmpv6SendErrorMessage(interface, ICMPV6_TYPE_PARAM_PROBLEM,
-            ICMPV6_CODE_INVALID_HEADER_FIELD, n, buffer);
-
-         //Drop any allocated resources
-         chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer, 0);
+         //Number of failures detected by the IP reassembly algorithm
+         MIB2_INC_COUNTER(ipv6.ipReasmFails, 1);
+         //Drop the partially reconstructed datagram
+         ipv6RemoveFragDesc(interface, frag);
          //Exit immediately
          return;
       }
+   }
+   else if(frag->fragPartLength && dataLast > frag->fragPartLength)
+   {
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv6.ipReasmFails, 1);
+      //Drop the partially reconstructed datagram
+      ipv6RemoveFragDesc(interface, frag);
+      //Exit immediately
+      return;
+   }
+
+   //Chunks are sorted by offset. Find the first chunk that
+   //ends beyond the beginning of the newly arrived fragment
+   for(i = 1; i < frag->buffer.chunkCount; i++)
+   {
+      if((frag->offset[i] + frag->buffer.chunk[i].length) > dataFirst)
+         break;
+   }
 
-      //Make sure the unfragmentable part entirely fits in the first chunk
-      if(frag->unfragPartLength > frag->buffer.chunk[0].size)
+   //Check whether the fragment overlaps data that has already been received
+   if(i < frag->buffer.chunkCount && frag->offset[i] < dataLast)
+   {
+      //Determine the extent of the contiguous data starting at this chunk
+      for(pos = frag->offset[i], j = i; j < frag->buffer.chunkCount; j++)
       {
-         //Drop the reconstructed datagram
-         chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer, 0);
-         //Exit immediately
-         return;
+         if(frag->offset[j] != pos || pos >= dataLast)
+            break;
+
+         pos += frag->buffer.chunk[j].length;
       }
 
-      //Fix the length of the first chunk
-      frag->buffer.chunk[0].length = frag->unfragPartLength;
+      //Duplicate fragments are silently ignored. When any other overlap is
+      //detected, the entire datagram must be silently discarded (RFC 5722)
+      if(frag->offset[i] > dataFirst || pos < dataLast)
+      {
+         //Number of failures detected by the IP reassembly algorithm
+         MIB2_INC_COUNTER(ipv6.ipReasmFails, 1);
+         //Drop the partially reconstructed datagram
+         ipv6RemoveFragDesc(interface, frag);
+      }
 
-      //The unfragmentable part of the reassembled packet consists
-      //of all headers up to, but not including, the Fragment header
-      //of the first fragment packet
-      chunkedBufferCopy((ChunkedBuffer *) &frag->buffer, 0, buffer, 0, frag->unfragPartLength);
+      //Exit immediately
+      return;
+   }
 
-      //Point to the Next Header field of the last header
-      p = chunkedBufferAt((ChunkedBuffer *) &frag->buffer, nextHeaderOffset);
+   //Number of memory blocks required to hold the fragment data
+   n = (length + MEM_POOL_BUFFER_SIZE - 1) / MEM_POOL_BUFFER_SIZE;
 
-      //The Next Header field of the last header of the unfragmentable
-      //part is obtained from the Next Header field of the first
-      //fragment's Fragment header
-      *p = header->nextHeader;
+   //Make sure the reassembly buffer can accommodate the additional chunks
+   if((frag->buffer.chunkCount + n) > frag->buffer.maxChunkCount)
+   {
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv6.ipReasmFails, 1);
+      //Drop the partially reconstructed datagram
+      ipv6RemoveFragDesc(interface, frag);
+      //Exit immediately
+      return;
    }
 
-   //It may be necessary to increase the size of the buffer...
-   if(dataLast > frag->fragPartLength)
-   {
-      //The size of the reconstructed datagram exceeds the maximum value?
-      if((frag->unfragPartLength + dataLast) > IPV6_MAX_FRAG_DATAGRAM_SIZE)
-      {
-         //Compute the offset of the Fragment Offset field within the packet
-         size_t n = fragHeaderOffset + (uint8_t *) &header->fragmentOffset - (uint8_t *) header;
+   //An extra block is needed to hold the unfragmentable part
+   k = (!dataFirst) ? (n + 1) : n;
 
-         //The fragment must be discarded and an ICMP Parameter Problem
-         //message should be sent to the source of the fragment, pointing
-         //to the Fragment Offset field of the fragment packet
-         icmpv6SendErrorMessage(interface, ICMPV6_TYPE_PARAM_PROBLEM,
-            ICMPV6_CODE_INVALID_HEADER_FIELD, n, buffer);
+   //Enforce the memory budget of the reassembly queue
+   error = ipv6FragReserveMem(interface, frag, k * MEM_POOL_BUFFER_SIZE);
+   //Any error to report?
+   if(error)
+   {
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv6.ipReasmFails, 1);
+      //Drop the partially reconstructed datagram
+      ipv6RemoveFragDesc(interface, frag);
+      //Exit immediately
+      return;
+   }
 
-         //Drop any allocated resources
-         chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer, 0);
-         //Exit immediately
-         return;
-      }
+   //The very first fragment requires special handling
+   if(!dataFirst)
+   {
+      uint8_t *p;
 
-      //Adjust the size of the reconstructed datagram
-      error = chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer,
-         frag->unfragPartLength + dataLast + sizeof(Ipv6HoleDesc));
+      //Allocate a memory block to hold the unfragmentable part
+      p = memPoolAlloc(MEM_POOL_BUFFER_SIZE);
 
-      //Any error to report?
-      if(error)
+      //Failed to allocate memory?
+      if(!p)
       {
-         //Drop the reconstructed datagram
-         chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer, 0);
+         //Number of failures detected by the IP reassembly algorithm
+         MIB2_INC_COUNTER(ipv6.ipReasmFails, 1);
+         //Drop the partially reconstructed datagram
+         ipv6RemoveFragDesc(interface, frag);
          //Exit immediately
          return;
       }
 
-      //Actual length of the fragmentable part
-      frag->fragPartLength = dataLast;
-   }
+      //Calculate the length of the unfragmentable part
+      frag->unfragPartLength = fragHeaderOffset;
 
-   //Select the first hole descriptor from the list
-   hole = ipv6FindHole(frag, frag->firstHole);
-   //Keep track of the previous hole in the list
-   prevHole = NULL;
+      //The unfragmentable part of the reassembled packet consists
+      //of all headers up to, but not including, the Fragment header
+      //of the first fragment packet
+      chunkedBufferRead(p, buffer, 0, frag->unfragPartLength);
 
-   //Iterate through the hole descriptors
-   while(hole != NULL)
-   {
-      //Save lower and upper boundaries for later use
-      uint16_t holeFirst = hole->first;
-      uint16_t holeLast = hole->last;
+      //The Next Header field of the last header of the unfragmentable
+      //part is obtained from the Next Header field of the first
+      //fragment's Fragment header
+      p[nextHeaderOffset] = header->nextHeader;
 
-      //Check whether the newly arrived fragment
-      //interacts with this hole in some way
-      if(dataFirst < holeLast && dataLast > holeFirst)
-      {
-         //The current descriptor is no longer valid. We will destroy
-         //it, and in the next two steps, we will determine whether
-         //or not it is necessary to create any new hole descriptors
-         if(prevHole != NULL)
-            prevHole->next = hole->next;
-         else
-            frag->firstHole = hole->next;
-
-         //Is there still a hole at the beginning of the segment?
-         if(dataFirst > holeFirst)
-         {
-            //Create a new entry that describes this hole
-            hole = ipv6FindHole(frag, holeFirst);
-            hole->first = holeFirst;
-            hole->last = dataFirst;
+      //The first chunk holds the unfragmentable part
+      frag->buffer.chunk[0].address = p;
+      frag->buffer.chunk[0].length = frag->unfragPartLength;
+      frag->buffer.chunk[0].size = MEM_POOL_BUFFER_SIZE;
+   }
 
-            //Insert the newly created entry into the hole descriptor list
-            if(prevHole != NULL)
-            {
-               hole->next = prevHole->next;
-               prevHole->next = hole->first;
-            }
-            else
-            {
-               hole->next = frag->firstHole;
-               frag->firstHole = hole->first;
-            }
+   //Make room for the new chunks
+   memmove(&frag->buffer.chunk[i + n], &frag->buffer.chunk[i],
+      (frag->buffer.chunkCount - i) * sizeof(ChunkDesc));
+   memmove(&frag->offset[i + n], &frag->offset[i],
+      (frag->buffer.chunkCount - i) * sizeof(uint16_t));
 
-            //Always keep track of the previous hole
-            prevHole = hole;
-         }
+   //Adjust the number of chunks
+   frag->buffer.chunkCount += n;
 
-         //Is there still a hole at the end of the segment?
-         if(dataLast < holeLast && (offset & IPV6_FLAG_M))
-         {
-            //Create a new entry that describes this hole
-            hole = ipv6FindHole(frag, dataLast);
-            hole->first = dataLast;
-            hole->last = holeLast;
+   //Copy the fragment data
+   for(k = 0, j = i; j < (i + n); j++)
+   {
+      //Point to the current chunk descriptor
+      chunk = &frag->buffer.chunk[j];
 
-            //Insert the newly created entry into the hole descriptor list
-            if(prevHole != NULL)
-            {
-               hole->next = prevHole->next;
-               prevHole->next = hole->first;
-            }
-            else
-            {
-               hole->next = frag->firstHole;
-               frag->firstHole = hole->first;
-            }
+      //Allocate a memory block
+      chunk->address = (error) ? NULL : memPoolAlloc(MEM_POOL_BUFFER_SIZE);
 
-            //Always keep track of the previous hole
-            prevHole = hole;
-         }
+      //Failed to allocate memory?
+      if(!chunk->address)
+      {
+         //Mark the current chunk as free
+         chunk->length = 0;
+         chunk->size = 0;
+         //Report an error
+         error = ERROR_OUT_OF_MEMORY;
       }
       else
       {
-         //The newly arrived fragment does not interact with the current hole
-         prevHole = hole;
+         //Copy the current block of data
+         chunk->length = chunkedBufferRead(chunk->address, buffer, fragHeaderOffset +
+            sizeof(Ipv6FragmentHeader) + k, min(length - k, MEM_POOL_BUFFER_SIZE));
+         chunk->size = MEM_POOL_BUFFER_SIZE;
       }
 
-      //Select the next hole descriptor from the list
-      hole = ipv6FindHole(frag, prevHole ? prevHole->next : frag->firstHole);
+      //Save the offset of the chunk within the fragmentable part
+      frag->offset[j] = dataFirst + k;
+      //Next block
+      k += MEM_POOL_BUFFER_SIZE;
+   }
+
+   //Failed to allocate memory?
+   if(error)
+   {
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv6.ipReasmFails, 1);
+      //Drop the partially reconstructed datagram
+      ipv6RemoveFragDesc(interface, frag);
+      //Exit immediately
+      return;
    }
 
-   //Copy data from the fragment to the reassembly buffer
-   chunkedBufferCopy((ChunkedBuffer *) &frag->buffer, frag->unfragPartLength + dataFirst,
-      buffer, fragHeaderOffset + sizeof(Ipv6FragmentHeader), length);
+   //Number of bytes of the fragmentable part received so far
+   frag->receivedLength += length;
+
+   //The last fragment gives the length of the fragmentable part
+   if(!(offset & IPV6_FLAG_M))
+      frag->fragPartLength = dataLast;
 
-   //Dump hole descriptor list
-   ipv6DumpHoleList(frag);
+   //Dump the list of received fragments
+   ipv6DumpFragList(frag);
 
-   //If the hole descriptor list is empty, the reassembly process is now complete
-   if(!ipv6FindHole(frag, frag->firstHole))
+   //The reassembly process is complete when the first and the last fragments
+   //have been received and there is no remaining hole in the payload
+   if(frag->unfragPartLength && frag->fragPartLength &&
+      frag->receivedLength == frag->fragPartLength)
    {
-      //Discard the extra hole descriptor that follows the reconstructed datagram
-      error = chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer,
-         frag->unfragPartLength + frag->fragPartLength);
+      //Point to the IPv6 header
+      Ipv6Header *datagram = frag->buffer.chunk[0].address;
 
-      //Check status code
-      if(!error)
-      {
-         //Point to the IPv6 header
-         Ipv6Header *datagram = chunkedBufferAt((ChunkedBuffer *) &frag->buffer, 0);
+      //Fix the Payload Length field
+      datagram->payloadLength = htons(frag->unfragPartLength +
+         frag->fragPartLength - sizeof(Ipv6Header));
 
-         //Fix the Payload Length field
-         datagram->payloadLength = htons(frag->unfragPartLength +
-            frag->fragPartLength - sizeof(Ipv6Header));
+      //Pass the original IPv6 datagram to the higher protocol layer
+      ipv6ProcessPacket(interface, srcMacAddr, (ChunkedBuffer *) &frag->buffer);
 
-         //Pass the original IPv6 datagram to the higher protocol layer
-         ipv6ProcessPacket(interface, srcMacAddr, (ChunkedBuffer *) &frag->buffer);
-      }
+      //Number of IP datagrams successfully reassembled
+      MIB2_INC_COUNTER(ipv6.ipReasmOKs, 1);
 
       //Release previously allocated memory
-      chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer, 0);
+      ipv6RemoveFragDesc(interface, frag);
    }
 }
 
@@ -408,8 +489,9 @@ void ipv6FragTick(NetInterface *interface)
 {
    error_t error;
    uint_t i;
+   uint_t j;
+   size_t length;
    time_t time;
-   Ipv6HoleDesc *hole;
 
    //Acquire exclusive access to the reassembly queue
    osMutexAcquire(interface->ipv6FragQueueMutex);
@@ -432,19 +514,27 @@ void ipv6FragTick(NetInterface *interface)
          {
             //Debug message
             TRACE_INFO("IPv6 fragment reassembly timeout...\r\n");
-            //Dump IP header contents for debugging purpose
-            ipv6DumpHeader(frag->buffer.chunk[0].address);
-
-            //Point to the first hole descriptor
-            hole = ipv6FindHole(frag, frag->firstHole);
 
             //Make sure the fragment zero has been received
             //before sending an ICMPv6 message
-            if(hole != NULL && hole->first > 0)
+            if(frag->unfragPartLength > 0)
             {
+               //Dump IP header contents for debugging purpose
+               ipv6DumpHeader(frag->buffer.chunk[0].address);
+
+               //Determine the length of the contiguous data that
+               //immediately follows the unfragmentable part
+               for(length = 0, j = 1; j < frag->buffer.chunkCount; j++)
+               {
+                  if(frag->offset[j] != length)
+                     break;
+
+                  length += frag->buffer.chunk[j].length;
+               }
+
                //Fix the size of the reconstructed datagram
                error = chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer,
-                  frag->unfragPartLength + hole->first);
+                  frag->unfragPartLength + length);
 
                //Check status code
                if(!error)
@@ -455,8 +545,10 @@ void ipv6FragTick(NetInterface *interface)
                }
             }
 
+            //Number of failures detected by the IP reassembly algorithm
+            MIB2_INC_COUNTER(ipv6.ipReasmFails, 1);
             //Drop the partially reconstructed datagram
-            chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer, 0);
+            ipv6RemoveFragDesc(interface, frag);
          }
       }
    }
@@ -477,38 +569,34 @@ void ipv6FragTick(NetInterface *interface)
 Ipv6FragDesc *ipv6SearchFragQueue(NetInterface *interface,
    Ipv6Header *packet, Ipv6FragmentHeader *header)
 {
-   error_t error;
    uint_t i;
-   Ipv6Header *datagram;
+   uint_t h;
    Ipv6FragDesc *frag;
-   Ipv6HoleDesc *hole;
-
-   //Search for a matching IP datagram being reassembled
-   for(i = 0; i < IPV6_MAX_FRAG_DATAGRAMS; i++)
-   {
-      //Point to the current entry in the reassembly queue
-      frag = &interface->ipv6FragQueue[i];
-
-      //Check whether the current entry is used?
-      if(frag->buffer.chunkCount > 0)
-      {
-         //Point to the corresponding datagram
-         datagram = chunkedBufferAt((ChunkedBuffer *) &frag->buffer, 0);
+   Ipv6FragDesc *oldestFrag;
 
-         //Check source and destination addresses
-         if(!ipv6CompAddr(&datagram->srcAddr, &packet->srcAddr))
-            continue;
-         if(!ipv6CompAddr(&datagram->destAddr, &packet->destAddr))
-            continue;
-         //Compare fragment identification fields
-         if(frag->identification != header->identification)
-            continue;
+   //Datagrams being reassembled are indexed by source address,
+   //destination address and fragment identification field
+   h = ipv6FragHash(&packet->srcAddr, &packet->destAddr, header->identification);
 
-         //A matching entry has been found in the reassembly queue
-         return frag;
-      }
+   //Search the corresponding hash bucket for a matching IP datagram
+   for(frag = interface->ipv6FragTable[h]; frag != NULL; frag = frag->next)
+   {
+      //Check source and destination addresses
+      if(!ipv6CompAddr(&frag->srcAddr, &packet->srcAddr))
+         continue;
+      if(!ipv6CompAddr(&frag->destAddr, &packet->destAddr))
+         continue;
+      //Compare fragment identification fields
+      if(frag->identification != header->identification)
+         continue;
+
+      //A matching entry has been found in the reassembly queue
+      return frag;
    }
 
+   //Keep track of the oldest entry
+   oldestFrag = NULL;
+
    //If the current packet does not match an existing entry
    //in the reassembly queue, then create a new entry
    for(i = 0; i < IPV6_MAX_FRAG_DATAGRAMS; i++)
@@ -518,57 +606,55 @@ Ipv6FragDesc *ipv6SearchFragQueue(NetInterface *interface,
 
       //The current entry is free?
       if(!frag->buffer.chunkCount)
-      {
-         //Number of chunks that comprise the reassembly buffer
-         frag->buffer.maxChunkCount = arraysize(frag->buffer.chunk);
-
-         //Allocate sufficient memory to hold the IPv6 header and
-         //the first hole descriptor
-         error = chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer,
-            MEM_POOL_BUFFER_SIZE + sizeof(Ipv6HoleDesc));
+         break;
 
-         //Failed to allocate memory?
-         if(error)
-         {
-            //Clean up side effects
-            chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer, 0);
-            //Exit immediately
-            return NULL;
-         }
+      //Keep track of the oldest entry
+      if(oldestFrag == NULL || timeCompare(frag->timestamp, oldestFrag->timestamp) < 0)
+         oldestFrag = frag;
+   }
 
-         //Initial length of the reconstructed datagram
-         frag->unfragPartLength = sizeof(Ipv6Header);
-         frag->fragPartLength = 0;
-
-         //Fix the length of the first chunk
-         frag->buffer.chunk[0].length = frag->unfragPartLength;
-         //Copy IPv6 header from the incoming fragment
-         chunkedBufferWrite((ChunkedBuffer *) &frag->buffer, 0, packet, frag->unfragPartLength);
-
-         //Save current time
-         frag->timestamp = osGetTickCount();
-         //Record fragment identification field
-         frag->identification = header->identification;
-         //Create a new entry in the hole descriptor list
-         frag->firstHole = 0;
-
-         //Point to first hole descriptor
-         hole = ipv6FindHole(frag, frag->firstHole);
-         //The entry describes the datagram  as  being completely missing
-         hole->first = 0;
-         hole->last = IPV6_INFINITY;
-         hole->next = IPV6_INFINITY;
-
-         //Dump hole descriptor list
-         ipv6DumpHoleList(frag);
-
-         //Return the matching fragment descriptor
-         return frag;
-      }
+   //The reassembly queue is full?
+   if(i >= IPV6_MAX_FRAG_DATAGRAMS)
+   {
+      //Debug message
+      TRACE_INFO("IPv6 reassembly queue full, evicting the oldest datagram...\r\n");
+
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv6.ipReasmFails, 1);
+      //Drop the oldest partially reconstructed datagram
+      ipv6RemoveFragDesc(interface, oldestFrag);
+      //Reuse the corresponding entry
+      frag = oldestFrag;
    }
 
-   //The reassembly queue is full
-   return NULL;
+   //The first chunk will hold the unfragmentable part
+   frag->buffer.chunkCount = 1;
+   frag->buffer.maxChunkCount = arraysize(frag->buffer.chunk);
+   frag->buffer.chunk[0].address = NULL;
+   frag->buffer.chunk[0].length = 0;
+   frag->buffer.chunk[0].size = 0;
+   frag->offset[0] = 0;
+
+   //Save the fields that identify the datagram
+   ipv6CopyAddr(&frag->srcAddr, &packet->srcAddr);
+   ipv6CopyAddr(&frag->destAddr, &packet->destAddr);
+   frag->identification = header->identification;
+
+   //Initial length of the reconstructed datagram
+   frag->unfragPartLength = 0;
+   frag->fragPartLength = 0;
+   frag->receivedLength = 0;
+   frag->memUsage = 0;
+
+   //Save current time
+   frag->timestamp = osGetTickCount();
+
+   //Insert the new entry at the head of the hash bucket
+   frag->next = interface->ipv6FragTable[h];
+   interface->ipv6FragTable[h] = frag;
+
+   //Return the matching fragment descriptor
+   return frag;
 }
 
 
@@ -588,7 +674,8 @@ void ipv6FlushFragQueue(NetInterface *interface)
    for(i = 0; i < IPV6_MAX_FRAG_DATAGRAMS; i++)
    {
       //Drop any partially reconstructed datagram
-      chunkedBufferSetLength((ChunkedBuffer *) &interface->ipv6FragQueue[i].buffer, 0);
+      if(interface->ipv6FragQueue[i].buffer.chunkCount > 0)
+         ipv6RemoveFragDesc(interface, &interface->ipv6FragQueue[i]);
    }
 
    //Release exclusive access to the reassembly queue
@@ -597,43 +684,152 @@ void ipv6FlushFragQueue(NetInterface *interface)
 
 
 /**
- * @brief Retrieve hole descriptor
- * @param[in] frag IPv6 fragment descriptor
- * @param[in] offset Offset of the hole
- * @return A pointer to the hole descriptor is returned if the
- *   specified offset is valid. Otherwise NULL is returned
+ * @brief Compute the hash bucket of a fragmented datagram
+ * @param[in] srcAddr Source address
+ * @param[in] destAddr Destination address
+ * @param[in] identification Fragment identification field
+ * @return Index of the hash bucket
  **/
 
-Ipv6HoleDesc *ipv6FindHole(Ipv6FragDesc *frag, uint16_t offset)
+uint_t ipv6FragHash(const Ipv6Addr *srcAddr,
+   const Ipv6Addr *destAddr, uint32_t identification)
 {
-   //Return a pointer to the hole descriptor
-   return chunkedBufferAt((ChunkedBuffer *) &frag->buffer, frag->unfragPartLength + offset);
+   uint_t i;
+   uint32_t h;
+
+   //The fragment identification field is the most discriminating field
+   h = identification;
+
+   //Combine the source and destination addresses
+   for(i = 0; i < 4; i++)
+      h ^= srcAddr->dw[i] ^ destAddr->dw[i];
+
+   //Fold the resulting value
+   h ^= h >> 16;
+   h ^= h >> 8;
+
+   //Return the index of the hash bucket
+   return h % IPV6_FRAG_HASH_TABLE_SIZE;
+}
+
+
+/**
+ * @brief Remove an entry from the reassembly queue
+ * @param[in] interface Underlying network interface
+ * @param[in] frag IPv6 fragment descriptor to be released
+ **/
+
+void ipv6RemoveFragDesc(NetInterface *interface, Ipv6FragDesc *frag)
+{
+   uint_t h;
+   Ipv6FragDesc **p;
+
+   //Retrieve the hash bucket the entry belongs to
+   h = ipv6FragHash(&frag->srcAddr, &frag->destAddr, frag->identification);
+
+   //Unlink the entry from its hash bucket
+   for(p = &interface->ipv6FragTable[h]; *p != NULL; p = &(*p)->next)
+   {
+      if(*p == frag)
+      {
+         *p = frag->next;
+         break;
+      }
+   }
+
+   //Release the memory blocks that hold the fragments
+   chunkedBufferSetLength((ChunkedBuffer *) &frag->buffer, 0);
+
+   //Update the memory usage of the reassembly queue
+   interface->ipv6FragMemUsage -= frag->memUsage;
+
+   //Mark the entry as free
+   frag->next = NULL;
+   frag->memUsage = 0;
 }
 
 
 /**
- * @brief Dump hole descriptor list
+ * @brief Reserve memory for an incoming fragment
+ *
+ * When the memory budget of the reassembly queue is exhausted, the
+ * oldest datagrams are evicted until enough memory is available
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] frag IPv6 fragment descriptor the memory is reserved for
+ * @param[in] size Number of bytes to reserve
+ * @return Error code
+ **/
+
+error_t ipv6FragReserveMem(NetInterface *interface, Ipv6FragDesc *frag, size_t size)
+{
+   uint_t i;
+   Ipv6FragDesc *oldestFrag;
+
+   //Evict the oldest datagrams until the budget allows the reservation
+   while((interface->ipv6FragMemUsage + size) > IPV6_FRAG_MAX_MEM_USAGE)
+   {
+      //Keep track of the oldest entry
+      oldestFrag = NULL;
+
+      //Loop through the reassembly queue
+      for(i = 0; i < IPV6_MAX_FRAG_DATAGRAMS; i++)
+      {
+         //Skip free entries and the datagram the memory is reserved for
+         if(!interface->ipv6FragQueue[i].buffer.chunkCount)
+            continue;
+         if(&interface->ipv6FragQueue[i] == frag)
+            continue;
+
+         //Check the age of the current entry
+         if(oldestFrag == NULL || timeCompare(interface->ipv6FragQueue[i].timestamp,
+            oldestFrag->timestamp) < 0)
+         {
+            oldestFrag = &interface->ipv6FragQueue[i];
+         }
+      }
+
+      //No datagram can be evicted?
+      if(oldestFrag == NULL)
+         return ERROR_OUT_OF_RESOURCES;
+
+      //Debug message
+      TRACE_INFO("IPv6 reassembly memory exhausted, evicting the oldest datagram...\r\n");
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_INC_COUNTER(ipv6.ipReasmFails, 1);
+      //Drop the oldest partially reconstructed datagram
+      ipv6RemoveFragDesc(interface, oldestFrag);
+   }
+
+   //Update the memory usage of the reassembly queue
+   interface->ipv6FragMemUsage += size;
+   frag->memUsage += size;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Dump the list of received fragments
  * @param[in] frag IPv6 fragment descriptor
  **/
 
-void ipv6DumpHoleList(Ipv6FragDesc *frag)
+void ipv6DumpFragList(Ipv6FragDesc *frag)
 {
 //Check debugging level
 #if (TRACE_LEVEL >= TRACE_LEVEL_DEBUG)
-   Ipv6HoleDesc *hole;
+   uint_t i;
 
    //Debug message
-   TRACE_DEBUG("Hole descriptor list:\r\n");
-   //Select the first hole descriptor from the list
-   hole = ipv6FindHole(frag, frag->firstHole);
+   TRACE_DEBUG("Received fragments:\r\n");
 
-   //Loop through the hole descriptor list
-   while(hole != NULL)
+   //Loop through the chunks that hold the fragmentable part
+   for(i = 1; i < frag->buffer.chunkCount; i++)
    {
-      //Display current hole
-      TRACE_DEBUG("  %u - %u\r\n", hole->first, hole->last);
-      //Select the next hole descriptor from the list
-      hole = ipv6FindHole(frag, hole->next);
+      //Display current chunk
+      TRACE_DEBUG("  %u - %u\r\n", frag->offset[i],
+         frag->offset[i] + frag->buffer.chunk[i].length);
    }
 #endif
 }
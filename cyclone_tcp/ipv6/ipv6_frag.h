@@ -58,10 +58,31 @@
 //Maximum datagram size the host will accept when reassembling fragments
 #ifndef IPV6_MAX_FRAG_DATAGRAM_SIZE
    #define IPV6_MAX_FRAG_DATAGRAM_SIZE 8192
-#elif (IPV6_MAX_FRAG_DATAGRAM_SIZE < 1)
+#elif (IPV6_MAX_FRAG_DATAGRAM_SIZE < 1 || IPV6_MAX_FRAG_DATAGRAM_SIZE > 65575)
    #error IPV6_MAX_FRAG_DATAGRAM_SIZE parameter is invalid
 #endif
 
+//Maximum number of data chunks that make up a reassembled datagram
+#ifndef IPV6_MAX_FRAG_CHUNKS
+   #define IPV6_MAX_FRAG_CHUNKS 16
+#elif (IPV6_MAX_FRAG_CHUNKS < 2)
+   #error IPV6_MAX_FRAG_CHUNKS parameter is invalid
+#endif
+
+//Size of the hash table used to locate datagrams being reassembled
+#ifndef IPV6_FRAG_HASH_TABLE_SIZE
+   #define IPV6_FRAG_HASH_TABLE_SIZE 8
+#elif (IPV6_FRAG_HASH_TABLE_SIZE < 1)
+   #error IPV6_FRAG_HASH_TABLE_SIZE parameter is invalid
+#endif
+
+//Maximum amount of memory the reassembly queue is allowed to consume
+#ifndef IPV6_FRAG_MAX_MEM_USAGE
+   #define IPV6_FRAG_MAX_MEM_USAGE (IPV6_MAX_FRAG_DATAGRAMS * IPV6_MAX_FRAG_DATAGRAM_SIZE)
+#elif (IPV6_FRAG_MAX_MEM_USAGE < (2 * MEM_POOL_BUFFER_SIZE))
+   #error IPV6_FRAG_MAX_MEM_USAGE parameter is invalid
+#endif
+
 //Maximum time an IPv6 fragment can spend waiting to be reassembled
 #ifndef IPV6_FRAG_TIME_TO_LIVE
    #define IPV6_FRAG_TIME_TO_LIVE 15000
@@ -69,45 +90,25 @@
    #error IPV6_FRAG_TIME_TO_LIVE parameter is invalid
 #endif
 
-//Maximum payload size for fragmented packets (shall be a multiple of 8-byte blocks)
-#define IPV6_MAX_FRAG_SIZE ((IPV6_MAX_PAYLOAD_SIZE - sizeof(Ipv6FragmentHeader)) & ~0x0007)
+//Minimum length of the fragmentable part carried by the first fragment
+#define IPV6_MIN_FIRST_FRAG_SIZE 64
 //Infinity is implemented by a very large integer
 #define IPV6_INFINITY 0xFFFF
 
 
-#if (defined(__GNUC__) || defined(_WIN32))
-   #define __packed
-   #pragma pack(push, 1)
-#endif
-
-
-/**
- * @brief Hole descriptor
- **/
-
-__packed typedef struct
-{
-   uint16_t first;
-   uint16_t last;
-   uint16_t next;
-} Ipv6HoleDesc;
-
-
-#if (defined(__GNUC__) || defined(_WIN32))
-   #undef __packed
-   #pragma pack(pop)
-#endif
-
-
 /**
  * @brief Reassembly buffer
+ *
+ * The first chunk holds the unfragmentable part. The subsequent
+ * chunks reference the received fragments, sorted by offset
+ *
  **/
 
 typedef struct
 {
    uint_t chunkCount;
    uint_t maxChunkCount;
-   ChunkDesc chunk[N(IPV6_MAX_FRAG_DATAGRAM_SIZE) + 1];
+   ChunkDesc chunk[IPV6_MAX_FRAG_CHUNKS + 1];
 } Ipv6ReassemblyBuffer;
 
 
@@ -115,20 +116,25 @@ typedef struct
  * @brief Fragmented packet descriptor
  **/
 
-typedef struct
+typedef struct _Ipv6FragDesc
 {
-   time_t timestamp;            ///<Time at which the first fragment was received
-   uint32_t identification;     ///<Fragment identification field
-   size_t unfragPartLength;     ///<Length of the unfragmentable part
-   size_t fragPartLength;       ///<Length of the fragmentable part
-   uint16_t firstHole;          ///<Index of the first hole
-   Ipv6ReassemblyBuffer buffer; ///<Buffer containing the reassembled datagram
+   struct _Ipv6FragDesc *next;                ///<Next entry in the same hash bucket
+   time_t timestamp;                          ///<Time at which the first fragment was received
+   Ipv6Addr srcAddr;                          ///<Source address
+   Ipv6Addr destAddr;                         ///<Destination address
+   uint32_t identification;                   ///<Fragment identification field
+   size_t unfragPartLength;                   ///<Length of the unfragmentable part
+   size_t fragPartLength;                     ///<Length of the fragmentable part (known once the last fragment is received)
+   size_t receivedLength;                     ///<Number of bytes of the fragmentable part received so far
+   size_t memUsage;                           ///<Amount of memory consumed by the fragments
+   uint16_t offset[IPV6_MAX_FRAG_CHUNKS + 1]; ///<Offset of each chunk within the fragmentable part
+   Ipv6ReassemblyBuffer buffer;               ///<Chunks that make up the reassembled datagram
 } Ipv6FragDesc;
 
 
 //IPv6 datagram fragmentation and reassembly
 error_t ipv6FragmentDatagram(NetInterface *interface, Ipv6PseudoHeader *pseudoHeader,
-   const ChunkedBuffer *payload, size_t payloadOffset, uint8_t hopLimit);
+   const ChunkedBuffer *payload, size_t payloadOffset, size_t pathMtu, uint_t flags);
 
 void ipv6ParseFragmentHeader(NetInterface *interface, const MacAddr *srcMacAddr,
    const ChunkedBuffer *buffer, size_t fragHeaderOffset, size_t nextHeaderOffset);
@@ -140,7 +146,12 @@ Ipv6FragDesc *ipv6SearchFragQueue(NetInterface *interface,
 
 void ipv6FlushFragQueue(NetInterface *interface);
 
-Ipv6HoleDesc *ipv6FindHole(Ipv6FragDesc *frag, uint16_t offset);
-void ipv6DumpHoleList(Ipv6FragDesc *frag);
+uint_t ipv6FragHash(const Ipv6Addr *srcAddr,
+   const Ipv6Addr *destAddr, uint32_t identification);
+
+void ipv6RemoveFragDesc(NetInterface *interface, Ipv6FragDesc *frag);
+error_t ipv6FragReserveMem(NetInterface *interface, Ipv6FragDesc *frag, size_t size);
+
+void ipv6DumpFragList(Ipv6FragDesc *frag);
 
 #endif
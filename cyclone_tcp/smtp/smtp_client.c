@@ -877,7 +877,7 @@ error_t smtpWrite(SmtpClientContext *context, const void *data, size_t length, u
    if(context->tlsContext != NULL)
    {
       //Use SSL/TLS to transmit data to the SMTP server
-      return tlsWrite(context->tlsContext, data, length, flags);
+      return tlsWrite(context->tlsContext, data, length, NULL, flags);
    }
    else
 #endif
@@ -335,7 +335,7 @@ int_t main(void)
       TRACE_INFO("HTTP request:\r\n%s", buffer);
 
       //Send the request
-      error = tlsWrite(tlsContext, buffer, strlen(buffer), 0);
+      error = tlsWrite(tlsContext, buffer, strlen(buffer), NULL, 0);
       //Any error to report?
       if(error) break;
 
@@ -528,7 +528,7 @@ error_t processClientRequest(SOCKET clientSocket)
       TRACE_INFO("%s\r\n", buffer);
 
       //Send response to the client
-      error = tlsWrite(tlsContext, response, strlen(response), 0);
+      error = tlsWrite(tlsContext, response, strlen(response), NULL, 0);
       //Any error to report?
       if(error) break;
 